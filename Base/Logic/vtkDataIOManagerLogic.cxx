@@ -127,6 +127,11 @@ void vtkDataIOManagerLogic::ProcessDataIOManagerEvents(
     this->QueueWrite ( node );
     node->InvokeEvent ( vtkDataIOManager::RefreshDisplayEvent );
     }
+  else if ( event == vtkCommand::ModifiedEvent )
+    {
+    //--- requested by LocalWriteCompletedCallback, on the main thread
+    this->GetDataIOManager()->ProcessCompletedLocalWrites();
+    }
 }
 
 
@@ -138,10 +143,32 @@ void vtkDataIOManagerLogic::SetAndObserveDataIOManager ( vtkDataIOManager *ioman
   events->InsertNextValue ( vtkDataIOManager::RemoteWriteEvent );
   events->InsertNextValue ( vtkDataIOManager::LocalReadEvent );
   events->InsertNextValue ( vtkDataIOManager::LocalWriteEvent );
+  events->InsertNextValue ( vtkCommand::ModifiedEvent );
+  if ( this->DataIOManager != nullptr )
+    {
+    this->DataIOManager->SetLocalWriteCompletedCallback ( nullptr, nullptr );
+    }
   vtkSetAndObserveDataIOManagerEventsMacro( this->DataIOManager, iomanager, events.GetPointer() );
+  if ( this->DataIOManager != nullptr )
+    {
+    this->DataIOManager->SetLocalWriteCompletedCallback ( vtkDataIOManagerLogic::LocalWriteCompletedCallback, this );
+    }
 }
 
 
+//----------------------------------------------------------------------------
+void vtkDataIOManagerLogic::LocalWriteCompletedCallback ( void *clientData )
+{
+  vtkDataIOManagerLogic *self = reinterpret_cast<vtkDataIOManagerLogic *>(clientData);
+  vtkSlicerApplicationLogic *appLogic = self->GetApplicationLogic();
+  if ( appLogic != nullptr )
+    {
+    //--- the Modified() is invoked on the main thread, which makes
+    //--- ProcessDataIOManagerEvents finalize the completed writes.
+    appLogic->RequestModified ( self->GetDataIOManager() );
+    }
+}
+
 //----------------------------------------------------------------------------
 void vtkDataIOManagerLogic::AddNewDataTransfer ( vtkDataTransfer *dt, vtkMRMLNode *node )
 {
@@ -49,6 +49,12 @@ class VTK_SLICER_BASE_LOGIC_EXPORT vtkDataIOManagerLogic : public vtkSlicerModul
   /// Communicates progress back to the DataIOManager
   static void ProgressCallback ( void * );
 
+  ///
+  /// Called from the thread that completed a local write of the DataIOManager,
+  /// requests finalizing the completed writes on the main thread.
+  /// \sa vtkDataIOManager::QueueLocalWrite(), vtkDataIOManager::ProcessCompletedLocalWrites()
+  static void LocalWriteCompletedCallback ( void *clientData );
+
   ///
   /// Convenience method that goes through vtkDataIOManager
   /// to create a new DataTransfer object.
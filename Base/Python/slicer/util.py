@@ -2112,14 +2112,14 @@ def arrayFromMarkupsControlPoints(markupsNode, world=False):
 
     To modify markup control points based on a numpy array, use :py:meth:`updateMarkupsControlPointsFromArray`.
     """
-    numberOfControlPoints = markupsNode.GetNumberOfControlPoints()
-    import numpy as np
-    narray = np.zeros([numberOfControlPoints, 3])
-    for controlPointIndex in range(numberOfControlPoints):
-        if world:
-            markupsNode.GetNthControlPointPositionWorld(controlPointIndex, narray[controlPointIndex, :])
-        else:
-            markupsNode.GetNthControlPointPosition(controlPointIndex, narray[controlPointIndex, :])
+    import vtk.util.numpy_support
+    points = vtk.vtkPoints()
+    points.SetDataTypeToDouble()
+    if world:
+        markupsNode.GetControlPointPositionsWorld(points)
+    else:
+        markupsNode.GetControlPointPositions(points)
+    narray = vtk.util.numpy_support.vtk_to_numpy(points.GetData()).reshape(-1, 3).copy()
     return narray
 
 
@@ -2137,29 +2137,15 @@ def updateMarkupsControlPointsFromArray(markupsNode, narray, world=False):
         return
     if len(narrayshape) != 2 or narrayshape[1] != 3:
         raise RuntimeError("Unsupported numpy array shape: " + str(narrayshape) + " expected (N,3)")
-    numberOfControlPoints = narrayshape[0]
-    oldNumberOfControlPoints = markupsNode.GetNumberOfControlPoints()
-    # Update existing control points
-    wasModify = markupsNode.StartModify()
-    try:
-        for controlPointIndex in range(min(numberOfControlPoints, oldNumberOfControlPoints)):
-            if world:
-                markupsNode.SetNthControlPointPositionWorld(controlPointIndex, narray[controlPointIndex, :])
-            else:
-                markupsNode.SetNthControlPointPosition(controlPointIndex, narray[controlPointIndex, :])
-        if numberOfControlPoints >= oldNumberOfControlPoints:
-            # Add new points to the markup node
-            for controlPointIndex in range(oldNumberOfControlPoints, numberOfControlPoints):
-                if world:
-                    markupsNode.AddControlPointWorld(narray[controlPointIndex, :])
-                else:
-                    markupsNode.AddControlPoint(narray[controlPointIndex, :])
-        else:
-            # Remove extra point from the markup node
-            for controlPointIndex in range(oldNumberOfControlPoints, numberOfControlPoints, -1):
-                markupsNode.RemoveNthControlPoint(controlPointIndex - 1)
-    finally:
-        markupsNode.EndModify(wasModify)
+    # Set all positions in one batch, which is much faster than updating control points one by one
+    import numpy as np
+    import vtk.util.numpy_support
+    points = vtk.vtkPoints()
+    points.SetData(vtk.util.numpy_support.numpy_to_vtk(np.ascontiguousarray(narray, dtype=np.float64), deep=True))
+    if world:
+        markupsNode.SetControlPointPositionsWorld(points)
+    else:
+        markupsNode.SetControlPointPositions(points)
 
 
 def arrayFromMarkupsCurvePoints(markupsNode, world=False):
@@ -3101,6 +3087,9 @@ def downloadFile(url, targetFilePath, checksum=None, reDownloadIfChecksumInvalid
         logging.error('Failed to parse checksum: ' + excinfo.message)
         return False
     if not os.path.exists(targetFilePath) or os.stat(targetFilePath).st_size == 0:
+        if copyFileFromContentCache(checksum, targetFilePath):
+            logging.info('Requested file has been found in the content cache: ' + targetFilePath)
+            return True
         logging.info(f'Downloading from\n  {url}\nas file\n  {targetFilePath}\nIt may take a few minutes...')
         try:
             import urllib.request, urllib.parse, urllib.error
@@ -3120,6 +3109,7 @@ def downloadFile(url, targetFilePath, checksum=None, reDownloadIfChecksumInvalid
                 return False
             else:
                 logging.info('Checksum OK')
+                addFileToContentCache(targetFilePath, checksum)
     else:
         if algo is not None:
             current_digest = computeChecksum(algo, targetFilePath)
@@ -3135,17 +3125,70 @@ def downloadFile(url, targetFilePath, checksum=None, reDownloadIfChecksumInvalid
                     return False
             else:
                 logging.info('Requested file has been found and checksum is OK: ' + targetFilePath)
+                addFileToContentCache(targetFilePath, checksum)
         else:
             logging.info('Requested file has been found: ' + targetFilePath)
     return True
 
 
-def extractArchive(archiveFilePath, outputDir, expectedNumberOfExtractedFiles=None):
+def copyFileFromContentCache(checksum, targetFilePath):
+    """Copy the file identified by ``checksum`` from the content-addressed cache to ``targetFilePath``.
+
+    The checksum must be specified as ``<algo>:<digest>``.
+    Returns True if the file was found in the cache and copied.
+
+    See ``slicer.mrmlScene.GetCacheManager().FindFileInContentCache()``.
+    """
+    import os
+    import shutil
+    import slicer
+    if checksum is None or slicer.mrmlScene is None or slicer.mrmlScene.GetCacheManager() is None:
+        return False
+    cachedFilePath = slicer.mrmlScene.GetCacheManager().FindFileInContentCache(checksum)
+    if not cachedFilePath:
+        return False
+    # Copy into a temporary file first so that an interrupted copy does not leave a truncated file behind
+    partialFilePath = targetFilePath + '.partial'
+    try:
+        shutil.copyfile(cachedFilePath, partialFilePath)
+        os.replace(partialFilePath, targetFilePath)
+    except OSError:
+        # the file may have been just evicted from the cache by another application instance
+        if os.path.exists(partialFilePath):
+            os.remove(partialFilePath)
+        return False
+    return True
+
+
+def addFileToContentCache(filePath, checksum):
+    """Add a copy of file ``filePath`` with content verified to match ``checksum`` to the content-addressed cache.
+
+    The checksum must be specified as ``<algo>:<digest>``.
+    Returns True if the file is in the cache.
+
+    See ``slicer.mrmlScene.GetCacheManager().AddFileToContentCache()``.
+    """
+    import slicer
+    if checksum is None or slicer.mrmlScene is None or slicer.mrmlScene.GetCacheManager() is None:
+        return False
+    return slicer.mrmlScene.GetCacheManager().AddFileToContentCache(filePath, checksum) != ''
+
+
+def _archiveExtractionMarkerFilePath(outputDir):
+    import os
+    return os.path.normpath(outputDir) + '.extracted'
+
+
+def extractArchive(archiveFilePath, outputDir, expectedNumberOfExtractedFiles=None, checksum=None):
     """ Extract file ``archiveFilePath`` into folder ``outputDir``.
 
     Number of expected files unzipped may be specified in ``expectedNumberOfExtractedFiles``.
     If folder contains the same number of files as expected (if specified), then it will be
     assumed that unzipping has been successfully done earlier.
+
+    If ``checksum`` of the archive is specified (formatted as ``<algo>:<digest>``) then a successful
+    extraction is recorded next to the output folder and the archive is not extracted again
+    into the same folder.
     """
     import os
     import logging
@@ -3165,12 +3208,24 @@ def extractArchive(archiveFilePath, outputDir, expectedNumberOfExtractedFiles=No
         logging.info(f'File {archiveFilePath} already unzipped into {outputDir}')
         return True
 
+    markerFilePath = _archiveExtractionMarkerFilePath(outputDir)
+    if checksum is not None and numOfFilesInOutputDir > 0 and os.path.exists(markerFilePath):
+        with open(markerFilePath) as markerFile:
+            if markerFile.read().strip() == checksum:
+                logging.info(f'File {archiveFilePath} already unzipped into {outputDir}')
+                return True
+    if os.path.exists(markerFilePath):
+        os.remove(markerFilePath)
+
     extractSuccessful = app.applicationLogic().Unzip(archiveFilePath, outputDir)
     numOfFilesInOutputDirTest = len(getFilesInDirectory(outputDir, False))
     if extractSuccessful is False or (expectedNumberOfExtractedFiles is not None \
                                       and numOfFilesInOutputDirTest != expectedNumberOfExtractedFiles):
         logging.error(f'Unzipping {archiveFilePath} into {outputDir} failed')
         return False
+    if checksum is not None:
+        with open(markerFilePath, 'w') as markerFile:
+            markerFile.write(checksum)
     logging.info(f'Unzipping {archiveFilePath} into {outputDir} successful')
     return True
 
@@ -3244,13 +3299,15 @@ def downloadAndExtractArchive(url, archiveFilePath, outputDir, \
         os.remove(archiveFilePath)
         shutil.rmtree(outputDir)
         os.mkdir(outputDir)
+        if os.path.exists(_archiveExtractionMarkerFilePath(outputDir)):
+            os.remove(_archiveExtractionMarkerFilePath(outputDir))
 
     while numberOfTrials:
         if not downloadFile(url, archiveFilePath, checksum):
             numberOfTrials -= 1
             _cleanup()
             continue
-        if not extractArchive(archiveFilePath, outputDir, expectedNumberOfExtractedFiles):
+        if not extractArchive(archiveFilePath, outputDir, expectedNumberOfExtractedFiles, checksum):
             numberOfTrials -= 1
             _cleanup()
             continue
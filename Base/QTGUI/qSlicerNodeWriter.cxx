@@ -31,6 +31,7 @@
 #include "qSlicerCoreIOManager.h"
 
 // MRML includes
+#include <vtkDataIOManager.h>
 #include <vtkMRMLScene.h>
 #include <vtkMRMLStorableNode.h>
 #include <vtkMRMLStorageNode.h>
@@ -159,7 +160,18 @@ bool qSlicerNodeWriter::write(const qSlicerIO::IOProperties& properties)
       snode->SetCompressionParameter(properties["compressionParameter"].toString().toStdString());
       }
     }
-  bool res = snode->WriteData(node);
+  bool res = false;
+  vtkDataIOManager* dataIOManager = this->mrmlScene()->GetDataIOManager();
+  if (properties.value("writeAsynchronously").toBool()
+    && dataIOManager && dataIOManager->GetEnableAsynchronousLocalWrite()
+    && snode->CanWriteDataAsynchronously(node))
+    {
+    res = (dataIOManager->QueueLocalWrite(node, snode) > 0);
+    }
+  else
+    {
+    res = snode->WriteData(node);
+    }
 
   if (res)
     {
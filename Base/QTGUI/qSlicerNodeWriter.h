@@ -60,6 +60,10 @@ public:
 
   /// Write the node referenced by "nodeID" into the "fileName" file.
   /// Optionally, "useCompression" can be specified.
+  /// If "writeAsynchronously" is true and the storage node supports it then the
+  /// data is captured and the file is written later, in a background thread
+  /// (see vtkDataIOManager::QueueLocalWrite()). The file is complete after
+  /// vtkDataIOManager::FinishLocalWrites() is called.
   /// Return true on success, false otherwise.
   /// Create a storage node if the storable node doesn't have any.
   bool write(const qSlicerIO::IOProperties& properties) override;
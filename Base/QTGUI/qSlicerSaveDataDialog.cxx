@@ -51,6 +51,7 @@
 #include <vtkCacheManager.h>
 #include <vtkCollection.h>
 #include <vtkDataFileFormatHelper.h> // for GetFileExtensionFromFormatString()
+#include <vtkDataIOManager.h>
 //#include <vtkMRMLHierarchyNode.h>
 #include <vtkMRMLMessageCollection.h>
 #include <vtkMRMLScene.h>
@@ -114,6 +115,10 @@ qSlicerSaveDataDialogPrivate::qSlicerSaveDataDialogPrivate(QWidget* parentWidget
   this->ErrorLabel->setVisible(false);
   this->ConfirmOverwriteAnswer = QMessageBox::Ignore;
   this->CancelRequested = false;
+  this->LocalWritesPending = false;
+  this->AcceptWhenSaved = false;
+  this->SaveSceneFileWhenWritten = false;
+  this->SaveSucceeded = true;
 
   this->WarningIcon.addPixmap(qApp->style()->standardPixmap(QStyle::SP_MessageBoxWarning));
   this->ErrorIcon.addPixmap(qApp->style()->standardPixmap(QStyle::SP_MessageBoxCritical));
@@ -173,6 +178,12 @@ qSlicerSaveDataDialogPrivate::~qSlicerSaveDataDialogPrivate() = default;
 //-----------------------------------------------------------------------------
 void qSlicerSaveDataDialogPrivate::setMRMLScene(vtkMRMLScene* scene)
 {
+  vtkDataIOManager* oldDataIOManager = this->MRMLScene ? this->MRMLScene->GetDataIOManager() : nullptr;
+  vtkDataIOManager* newDataIOManager = scene ? scene->GetDataIOManager() : nullptr;
+  this->qvtkReconnect(oldDataIOManager, newDataIOManager, vtkDataIOManager::LocalWriteCompletedEvent,
+    this, SLOT(onLocalWriteCompleted(vtkObject*,void*)));
+  this->qvtkReconnect(oldDataIOManager, newDataIOManager, vtkDataIOManager::LocalWritesFinishedEvent,
+    this, SLOT(onLocalWritesFinished()));
   this->MRMLScene = scene;
 
   qSlicerFileNameItemDelegate * fileNameItemDelegate =
@@ -695,16 +706,22 @@ void qSlicerSaveDataDialogPrivate
 //-----------------------------------------------------------------------------
 void qSlicerSaveDataDialogPrivate::accept()
 {
+  // the dialog is accepted when the files written in background threads are complete
+  this->AcceptWhenSaved = true;
   if (!this->save())
     {
-    return;
+    this->AcceptWhenSaved = false;
     }
-  this->done(QDialog::Accepted);
 }
 
 //-----------------------------------------------------------------------------
 bool qSlicerSaveDataDialogPrivate::save()
 {
+  if (this->LocalWritesPending)
+    {
+    // previous save is not finished yet
+    return false;
+    }
   bool success = true;
 
   this->ErrorLabel->setVisible(false);
@@ -743,8 +760,44 @@ bool qSlicerSaveDataDialogPrivate::save()
     {
     success = false;
     }
+  this->SaveSucceeded = success;
+  this->SaveSceneFileWhenWritten = saveSceneFile;
+
+  vtkDataIOManager* dataIOManager = this->MRMLScene ? this->MRMLScene->GetDataIOManager() : nullptr;
+  if (this->WrittenRows.isEmpty() || !dataIOManager)
+    {
+    return this->finishSave();
+    }
+
+  // Files are written in background threads, the application remains responsive.
+  // The scene is saved when the data IO manager reports that all the files are written.
+  this->LocalWritesPending = true;
+  this->ButtonBox->setEnabled(false);
+  QApplication::setOverrideCursor(QCursor(Qt::BusyCursor));
+  if (dataIOManager->GetNumberOfLocalWritesInProgress() == 0)
+    {
+    // all the files are written already (e.g. the writers could not write asynchronously)
+    dataIOManager->ProcessCompletedLocalWrites();
+    this->onLocalWritesFinished();
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool qSlicerSaveDataDialogPrivate::finishSave()
+{
+  foreach(int row, this->WrittenRows)
+    {
+    if (!this->updateWrittenRowStatus(row))
+      {
+      this->SaveSucceeded = false;
+      }
+    }
+  this->WrittenRows.clear();
+  this->updateSize();
 
-  if (saveSceneFile && !this->CancelRequested)
+  bool success = this->SaveSucceeded;
+  if (this->SaveSceneFileWhenWritten && !this->CancelRequested)
     {
     if (!this->saveScene())
       {
@@ -758,14 +811,60 @@ bool qSlicerSaveDataDialogPrivate::save()
     }
 
   this->ErrorLabel->setVisible(!success);
+  if (success && this->AcceptWhenSaved)
+    {
+    this->done(QDialog::Accepted);
+    }
+  this->AcceptWhenSaved = false;
   return success;
 }
 
+//-----------------------------------------------------------------------------
+void qSlicerSaveDataDialogPrivate::onLocalWriteCompleted(vtkObject* caller, void* callData)
+{
+  Q_UNUSED(caller);
+  vtkMRMLStorageNode* storageNode = reinterpret_cast<vtkMRMLStorageNode*>(callData);
+  if (!this->LocalWritesPending || !storageNode)
+    {
+    return;
+    }
+  // show the result of each file as soon as it is written
+  foreach(int row, this->WrittenRows)
+    {
+    vtkMRMLStorableNode* const storableNode = vtkMRMLStorableNode::SafeDownCast(this->object(row));
+    if (storableNode && storableNode->GetStorageNode() == storageNode)
+      {
+      if (!this->updateWrittenRowStatus(row))
+        {
+        this->SaveSucceeded = false;
+        }
+      this->WrittenRows.removeOne(row);
+      break;
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerSaveDataDialogPrivate::onLocalWritesFinished()
+{
+  if (!this->LocalWritesPending)
+    {
+    // files written by another component
+    return;
+    }
+  this->LocalWritesPending = false;
+  QApplication::restoreOverrideCursor();
+  this->ButtonBox->setEnabled(true);
+  this->finishSave();
+}
+
 //-----------------------------------------------------------------------------
 bool qSlicerSaveDataDialogPrivate::saveNodes()
 {
   bool doneWithSaveDataDialog = true;
   QList<qSlicerIO::IOProperties> files;
+  // rows of the nodes that are written, files may still be written in background threads
+  this->WrittenRows.clear();
   const int sceneRow = this->findSceneRow();
   for (int row = 0; row < this->FileWidget->rowCount(); ++row)
     {
@@ -845,6 +944,8 @@ bool qSlicerSaveDataDialogPrivate::saveNodes()
     savingParameters["nodeID"] = QString(node->GetID());
     savingParameters["fileName"] = file.absoluteFilePath();
     savingParameters["fileFormat"] = format;
+    // nodes are written concurrently, the status is updated when each file is written
+    savingParameters["writeAsynchronously"] = true;
 
     QApplication::setOverrideCursor(QCursor(Qt::BusyCursor));
     bool success = coreIOManager->saveNodes(fileType, savingParameters);
@@ -871,25 +972,41 @@ bool qSlicerSaveDataDialogPrivate::saveNodes()
       doneWithSaveDataDialog = false;
       continue;
       }
+    this->WrittenRows << row;
+    }
+  this->updateSize();
 
-    // Display any warning or error messages from the storage node
-    if (snode)
+  return doneWithSaveDataDialog;
+}
+
+//-----------------------------------------------------------------------------
+bool qSlicerSaveDataDialogPrivate::updateWrittenRowStatus(int row)
+{
+  bool doneWithSaveDataDialog = true;
+  QTableWidgetItem* selectItem = this->FileWidget->item(row, SelectColumn);
+  QTableWidgetItem* nodeStatusItem = this->FileWidget->item(row, NodeStatusColumn);
+  vtkMRMLStorableNode* const storableNode = vtkMRMLStorableNode::SafeDownCast(this->object(row));
+  vtkMRMLStorageNode* snode = storableNode ? storableNode->GetStorageNode() : nullptr;
+  bool success = (snode == nullptr
+    || snode->GetUserMessages()->GetNumberOfMessagesOfType(vtkCommand::ErrorEvent) == 0);
+
+  // Display any warning or error messages from the storage node
+  if (snode)
+    {
+    if (snode->GetUserMessages()->GetNumberOfMessages() > 0)
       {
-      if (snode->GetUserMessages()->GetNumberOfMessages() > 0)
-        {
-        doneWithSaveDataDialog = false;
-        }
-      this->updateStatusIconFromStorageNode(row, success);
+      doneWithSaveDataDialog = false;
       }
-
-    selectItem->setCheckState(
-      storableNode->GetModifiedSinceRead() ? Qt::Checked : Qt::Unchecked);
-
-    selectItem->setCheckState(Qt::Unchecked);
-    nodeStatusItem->setText(qSlicerSaveDataDialog::tr("Not Modified"));
+    this->updateStatusIconFromStorageNode(row, success);
+    }
+  if (!success)
+    {
+    // the file failed to be written in a background thread
+    return false;
     }
-  this->updateSize();
 
+  selectItem->setCheckState(Qt::Unchecked);
+  nodeStatusItem->setText(qSlicerSaveDataDialog::tr("Not Modified"));
   return doneWithSaveDataDialog;
 }
 
@@ -19,6 +19,9 @@
 #include <QMessageBox>
 #include <QStyledItemDelegate>
 
+// CTK includes
+#include <ctkVTKObject.h>
+
 // Slicer includes
 #include "qSlicerIOOptions.h"
 #include "qSlicerSaveDataDialog.h"
@@ -35,6 +38,7 @@ class qSlicerSaveDataDialogPrivate
   , public Ui_qSlicerSaveDataDialog
 {
   Q_OBJECT
+  QVTK_OBJECT
 public:
   typedef qSlicerSaveDataDialogPrivate Self;
   explicit qSlicerSaveDataDialogPrivate(QWidget* _parent=nullptr);
@@ -56,6 +60,9 @@ public slots:
   void setDirectory(const QString& newDirectory);
   void selectModifiedSceneData();
   void selectModifiedData();
+  /// Save the selected nodes and the scene. Files may be written in background
+  /// threads, the scene is saved and the status is updated when they are written.
+  /// Returns false if saving failed.
   bool save();
   /// Reimplemented from QDialog::accept(), only accept the dialog if
   /// save() is successful.
@@ -72,6 +79,8 @@ protected slots:
   void enableNodes(bool);
   void saveSceneAsDataBundle();
   void onItemChanged(QTableWidgetItem*);
+  void onLocalWriteCompleted(vtkObject* caller, void* callData);
+  void onLocalWritesFinished();
 
 protected:
   enum ColumnType
@@ -100,6 +109,12 @@ protected:
   void              updateStatusIconFromStorageNode(int row, bool success);
   void              updateStatusIconFromMessageCollection(int row, vtkMRMLMessageCollection* userMessages, bool success);
   void              setStatusIcon(int row, const QIcon& icon, const QString& message);
+  /// Update the status of a row of a node whose file is written.
+  /// Returns false if the file was written with errors or warnings.
+  bool              updateWrittenRowStatus(int row);
+  /// Update the status of the written nodes and save the scene,
+  /// after all the files of the nodes are written.
+  bool              finishSave();
 
   QString           sceneFileFormat()const;
 
@@ -134,6 +149,14 @@ protected:
 
   QMessageBox::StandardButton ConfirmOverwriteAnswer;
   bool CancelRequested;
+
+  // Rows of the nodes whose files are being written
+  QList<int> WrittenRows;
+  // Files are written in background threads, the save is finished by onLocalWritesFinished()
+  bool LocalWritesPending;
+  bool AcceptWhenSaved;
+  bool SaveSceneFileWhenWritten;
+  bool SaveSucceeded;
   QIcon WarningIcon;
   QIcon ErrorIcon;
 
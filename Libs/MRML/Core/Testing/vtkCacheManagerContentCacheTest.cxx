@@ -0,0 +1,128 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkCacheManager.h"
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkNew.h>
+
+// VTKSYS includes
+#include <vtksys/FStream.hxx>
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <string>
+
+namespace
+{
+
+const std::string ChecksumA = "MD5:0cc175b9c0f1b6a831c399e269772661";
+const std::string ChecksumB = "MD5:92eb5ffee6ae2fec3ad71c777531578f";
+const std::string ChecksumC = "MD5:4a8a08f09d37b73795649038408b5f33";
+
+//---------------------------------------------------------------------------
+std::string WriteTestFile(const std::string& directory, const std::string& fileName, const std::string& content)
+{
+  std::string filePath = directory + "/" + fileName;
+  vtksys::ofstream stream(filePath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  stream << content;
+  return filePath;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkCacheManagerContentCacheTest(int argc, char * argv[])
+{
+  if (argc != 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string tempDir = argv[1];
+  std::string cacheDir = tempDir + "/vtkCacheManagerContentCacheTest";
+  vtksys::SystemTools::RemoveADirectory(cacheDir);
+
+  vtkNew<vtkCacheManager> cacheManager;
+  cacheManager->SetRemoteCacheDirectory(cacheDir.c_str());
+  CHECK_STD_STRING(cacheManager->GetContentCacheDirectory(), cacheDir + "/ContentCache");
+
+  // Checksums are normalized, invalid checksums are rejected
+  CHECK_STD_STRING(cacheManager->GetContentCacheFilePath("md5:0CC175B9C0F1B6A831C399E269772661"),
+    cacheDir + "/ContentCache/MD5/0cc175b9c0f1b6a831c399e269772661");
+  CHECK_STD_STRING(cacheManager->GetContentCacheFilePath("0cc175b9c0f1b6a831c399e269772661"), "");
+  CHECK_STD_STRING(cacheManager->GetContentCacheFilePath("MD5:../../something"), "");
+
+  // Miss
+  CHECK_STD_STRING(cacheManager->FindFileInContentCache(ChecksumA), "");
+  CHECK_INT(cacheManager->GetContentCacheMissCount(), 1);
+  CHECK_INT(cacheManager->GetContentCacheHitCount(), 0);
+
+  // Add by copy
+  std::string fileA = WriteTestFile(tempDir, "vtkCacheManagerContentCacheTest_a.txt", "a");
+  std::string cachedFileA = cacheManager->AddFileToContentCache(fileA, ChecksumA);
+  CHECK_STD_STRING(cachedFileA, cacheManager->GetContentCacheFilePath(ChecksumA));
+  CHECK_BOOL(vtksys::SystemTools::FileExists(fileA, true), true);
+  CHECK_BOOL(vtksys::SystemTools::FileExists(cachedFileA, true), true);
+
+  // Hit
+  CHECK_STD_STRING(cacheManager->FindFileInContentCache(ChecksumA), cachedFileA);
+  CHECK_INT(cacheManager->GetContentCacheHitCount(), 1);
+
+  // Adding the same content again is a no-op
+  CHECK_STD_STRING(cacheManager->AddFileToContentCache(fileA, ChecksumA), cachedFileA);
+
+  // Add by move
+  std::string fileB = WriteTestFile(tempDir, "vtkCacheManagerContentCacheTest_b.txt", "bb");
+  std::string cachedFileB = cacheManager->AddFileToContentCache(fileB, ChecksumB, true);
+  CHECK_BOOL(vtksys::SystemTools::FileExists(fileB), false);
+  CHECK_BOOL(vtksys::SystemTools::FileExists(cachedFileB, true), true);
+  CHECK_INT(static_cast<int>(cacheManager->GetContentCacheSize() * 1000000.0 + 0.5), 3);
+  CHECK_INT(cacheManager->GetContentCacheEvictionCount(), 0);
+
+  // Files that do not fit in the cache are evicted, but the last added file is kept
+  cacheManager->SetContentCacheLimit(0);
+  std::string fileC = WriteTestFile(tempDir, "vtkCacheManagerContentCacheTest_c.txt", "ccc");
+  std::string cachedFileC = cacheManager->AddFileToContentCache(fileC, ChecksumC);
+  CHECK_BOOL(vtksys::SystemTools::FileExists(cachedFileC, true), true);
+  CHECK_BOOL(vtksys::SystemTools::FileExists(cachedFileA), false);
+  CHECK_BOOL(vtksys::SystemTools::FileExists(cachedFileB), false);
+  CHECK_INT(cacheManager->GetContentCacheEvictionCount(), 2);
+  CHECK_STD_STRING(cacheManager->FindFileInContentCache(ChecksumA), "");
+  CHECK_INT(cacheManager->GetContentCacheMissCount(), 2);
+
+  // Explicit pruning removes everything above the limit
+  CHECK_INT(cacheManager->PruneContentCache(), 1);
+  CHECK_BOOL(vtksys::SystemTools::FileExists(cachedFileC), false);
+
+  // Removal
+  cacheManager->SetContentCacheLimit(10);
+  cachedFileC = cacheManager->AddFileToContentCache(fileC, ChecksumC);
+  CHECK_BOOL(cacheManager->RemoveFileFromContentCache(ChecksumC), true);
+  CHECK_BOOL(cacheManager->RemoveFileFromContentCache(ChecksumC), false);
+
+  // Invalid input
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_STD_STRING(cacheManager->AddFileToContentCache(fileC, "invalid"), "");
+  CHECK_STD_STRING(cacheManager->AddFileToContentCache(tempDir + "/vtkCacheManagerContentCacheTest_missing.txt", ChecksumC), "");
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  cacheManager->ResetContentCacheStatistics();
+  CHECK_INT(cacheManager->GetContentCacheHitCount(), 0);
+  CHECK_INT(cacheManager->GetContentCacheMissCount(), 0);
+  CHECK_INT(cacheManager->GetContentCacheEvictionCount(), 0);
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,257 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkDataIOManager.h"
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLCoreTestingUtilities.h"
+#include "vtkMRMLMessageCollection.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLModelStorageNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+#include <vtkSphereSource.h>
+#include <vtkTimerLog.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+const int NumberOfModels = 6;
+
+//---------------------------------------------------------------------------
+vtkMRMLModelNode* AddModel(vtkMRMLScene* scene, const std::string& fileName, int resolution)
+{
+  vtkNew<vtkSphereSource> sphere;
+  sphere->SetThetaResolution(resolution);
+  sphere->SetPhiResolution(resolution);
+  sphere->Update();
+
+  vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(scene->AddNewNodeByClass("vtkMRMLModelNode"));
+  modelNode->SetAndObservePolyData(sphere->GetOutput());
+  modelNode->AddDefaultStorageNode();
+  modelNode->GetStorageNode()->SetFileName(fileName.c_str());
+  vtksys::SystemTools::RemoveFile(fileName);
+  return modelNode;
+}
+
+//---------------------------------------------------------------------------
+std::string GetFileName(const std::string& tempDir, const std::string& prefix, int index, const char* extension)
+{
+  std::stringstream fileName;
+  fileName << tempDir << "/vtkDataIOManagerLocalWriteTest_" << prefix << index << extension;
+  return fileName.str();
+}
+
+//---------------------------------------------------------------------------
+vtkIdType GetNumberOfPointsInFile(const std::string& fileName)
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(scene->AddNewNodeByClass("vtkMRMLModelNode"));
+  vtkNew<vtkMRMLModelStorageNode> storageNode;
+  scene->AddNode(storageNode);
+  storageNode->SetFileName(fileName.c_str());
+  if (!storageNode->ReadData(modelNode) || !modelNode->GetPolyData())
+    {
+    return -1;
+    }
+  return modelNode->GetPolyData()->GetNumberOfPoints();
+}
+
+//---------------------------------------------------------------------------
+int TestAsynchronousWrite(const std::string& tempDir)
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkDataIOManager> dataIOManager;
+  CHECK_BOOL(dataIOManager->GetEnableAsynchronousLocalWrite() != 0, true);
+  vtkNew<vtkMRMLCoreTestingUtilities::vtkMRMLNodeCallback> callback;
+  dataIOManager->AddObserver(vtkDataIOManager::LocalWriteEvent, callback);
+  dataIOManager->AddObserver(vtkDataIOManager::LocalWriteCompletedEvent, callback);
+  dataIOManager->AddObserver(vtkDataIOManager::LocalWritesFinishedEvent, callback);
+
+  std::vector<vtkMRMLModelNode*> modelNodes;
+  std::vector<vtkIdType> numberOfPoints;
+  for (int i = 0; i < NumberOfModels; ++i)
+    {
+    vtkMRMLModelNode* modelNode = AddModel(scene, GetFileName(tempDir, "async", i, (i % 2 ? ".vtp" : ".vtk")), 10 + i);
+    CHECK_BOOL(modelNode->GetStorageNode()->CanWriteDataAsynchronously(modelNode), true);
+    modelNodes.push_back(modelNode);
+    numberOfPoints.push_back(modelNode->GetPolyData()->GetNumberOfPoints());
+    }
+  for (vtkMRMLModelNode* modelNode : modelNodes)
+    {
+    CHECK_INT(dataIOManager->QueueLocalWrite(modelNode), 1);
+    }
+  CHECK_INT(callback->GetNumberOfEvents(vtkDataIOManager::LocalWriteEvent), NumberOfModels);
+
+  // The snapshots share the arrays with the nodes. Replacing the mesh or its arrays
+  // after the write is queued does not change the snapshot, and the nodes are written
+  // again because they were modified after the snapshot was taken.
+  vtkNew<vtkSphereSource> smallSphere;
+  smallSphere->Update();
+  modelNodes[0]->SetAndObservePolyData(smallSphere->GetOutput());
+  modelNodes[1]->GetPolyData()->ShallowCopy(smallSphere->GetOutput());
+  numberOfPoints[0] = smallSphere->GetOutput()->GetNumberOfPoints();
+  numberOfPoints[1] = smallSphere->GetOutput()->GetNumberOfPoints();
+
+  CHECK_INT(dataIOManager->FinishLocalWrites(), NumberOfModels);
+  CHECK_INT(dataIOManager->GetNumberOfLocalWritesInProgress(), 0);
+  CHECK_INT(callback->GetNumberOfEvents(vtkDataIOManager::LocalWriteCompletedEvent), NumberOfModels);
+  CHECK_INT(callback->GetNumberOfEvents(vtkDataIOManager::LocalWritesFinishedEvent), 1);
+  CHECK_BOOL(dataIOManager->GetLocalWriteProgress() == 1.0, true);
+  CHECK_INT(dataIOManager->ProcessCompletedLocalWrites(), 0);
+
+  for (int i = 0; i < NumberOfModels; ++i)
+    {
+    vtkMRMLStorageNode* storageNode = modelNodes[i]->GetStorageNode();
+    CHECK_INT(GetNumberOfPointsInFile(storageNode->GetFileName()), numberOfPoints[i]);
+    CHECK_BOOL(storageNode->GetLastWriteDataTime() >= 0.0, true);
+    CHECK_BOOL(modelNodes[i]->GetModifiedSinceRead(), false);
+    }
+  CHECK_EXIT_SUCCESS(callback->CheckStatus());
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestRequeuedWrite(const std::string& tempDir)
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkDataIOManager> dataIOManager;
+  std::string fileName = GetFileName(tempDir, "requeue", 0, ".vtp");
+  vtkMRMLModelNode* modelNode = AddModel(scene, fileName, 200);
+  CHECK_INT(dataIOManager->QueueLocalWrite(modelNode), 1);
+
+  // Queuing the node again while it is queued or being written does not wait,
+  // the latest data is written.
+  vtkNew<vtkSphereSource> sphere;
+  sphere->SetThetaResolution(20);
+  sphere->SetPhiResolution(20);
+  sphere->Update();
+  modelNode->SetAndObservePolyData(sphere->GetOutput());
+  CHECK_INT(dataIOManager->QueueLocalWrite(modelNode), 1);
+  CHECK_BOOL(dataIOManager->GetNumberOfLocalWritesInProgress() >= 1, true);
+
+  int numberOfWrites = dataIOManager->FinishLocalWrites();
+  CHECK_BOOL(numberOfWrites == 1 || numberOfWrites == 2, true);
+  CHECK_INT(dataIOManager->GetNumberOfLocalWritesInProgress(), 0);
+  CHECK_INT(GetNumberOfPointsInFile(fileName), sphere->GetOutput()->GetNumberOfPoints());
+  CHECK_BOOL(modelNode->GetModifiedSinceRead(), false);
+
+  // Local writes are not queued by QueueWrite, which is only for remote writes
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  dataIOManager->QueueWrite(modelNode);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  CHECK_INT(dataIOManager->GetNumberOfLocalWritesInProgress(), 0);
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestSynchronousWrite(const std::string& tempDir)
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkDataIOManager> dataIOManager;
+  dataIOManager->SetEnableAsynchronousLocalWrite(false);
+  vtkNew<vtkMRMLCoreTestingUtilities::vtkMRMLNodeCallback> callback;
+  dataIOManager->AddObserver(vtkDataIOManager::LocalWriteCompletedEvent, callback);
+  dataIOManager->AddObserver(vtkDataIOManager::LocalWritesFinishedEvent, callback);
+
+  std::string fileName = GetFileName(tempDir, "sync", 0, ".vtk");
+  vtkMRMLModelNode* modelNode = AddModel(scene, fileName, 10);
+  CHECK_INT(dataIOManager->QueueLocalWrite(modelNode), 1);
+  // File is written immediately, completion is reported when completed writes are processed
+  CHECK_BOOL(vtksys::SystemTools::FileExists(fileName, true), true);
+  CHECK_INT(dataIOManager->GetNumberOfLocalWritesInProgress(), 0);
+  CHECK_INT(callback->GetNumberOfEvents(vtkDataIOManager::LocalWriteCompletedEvent), 0);
+  CHECK_INT(dataIOManager->ProcessCompletedLocalWrites(), 1);
+  CHECK_INT(callback->GetNumberOfEvents(vtkDataIOManager::LocalWriteCompletedEvent), 1);
+  CHECK_INT(callback->GetNumberOfEvents(vtkDataIOManager::LocalWritesFinishedEvent), 1);
+  CHECK_BOOL(modelNode->GetModifiedSinceRead(), false);
+  CHECK_EXIT_SUCCESS(callback->CheckStatus());
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestWritePerformance(const std::string& tempDir)
+{
+  vtkNew<vtkMRMLScene> scene;
+  std::vector<vtkMRMLModelNode*> modelNodes;
+  for (int i = 0; i < NumberOfModels; ++i)
+    {
+    vtkMRMLModelNode* modelNode = AddModel(scene, GetFileName(tempDir, "performance", i, ".vtp"), 300);
+    modelNode->GetStorageNode()->SetUseCompression(true);
+    modelNodes.push_back(modelNode);
+    }
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  for (vtkMRMLModelNode* modelNode : modelNodes)
+    {
+    CHECK_BOOL(modelNode->GetStorageNode()->WriteData(modelNode) != 0, true);
+    }
+  timer->StopTimer();
+  double synchronousWriteTime = timer->GetElapsedTime();
+
+  vtkNew<vtkDataIOManager> dataIOManager;
+  timer->StartTimer();
+  for (vtkMRMLModelNode* modelNode : modelNodes)
+    {
+    dataIOManager->QueueLocalWrite(modelNode);
+    }
+  timer->StopTimer();
+  // time while the main thread is blocked
+  double queueTime = timer->GetElapsedTime();
+  timer->StartTimer();
+  CHECK_INT(dataIOManager->FinishLocalWrites(), NumberOfModels);
+  timer->StopTimer();
+  double asynchronousWriteTime = queueTime + timer->GetElapsedTime();
+
+  for (vtkMRMLModelNode* modelNode : modelNodes)
+    {
+    CHECK_BOOL(modelNode->GetModifiedSinceRead(), false);
+    CHECK_INT(modelNode->GetStorageNode()->GetUserMessages()->GetNumberOfMessagesOfType(vtkCommand::ErrorEvent), 0);
+    }
+
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("vtkDataIOManager-SynchronousWriteTime", synchronousWriteTime);
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("vtkDataIOManager-AsynchronousWriteQueueTime", queueTime);
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("vtkDataIOManager-AsynchronousWriteTime", asynchronousWriteTime);
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkDataIOManagerLocalWriteTest(int argc, char * argv[])
+{
+  if (argc != 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string tempDir = argv[1];
+
+  CHECK_EXIT_SUCCESS(TestAsynchronousWrite(tempDir));
+  CHECK_EXIT_SUCCESS(TestSynchronousWrite(tempDir));
+  CHECK_EXIT_SUCCESS(TestRequeuedWrite(tempDir));
+  CHECK_EXIT_SUCCESS(TestWritePerformance(tempDir));
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,256 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkEventBroker.h"
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLCoreTestingUtilities.h"
+#include "vtkMRMLGridTransformNode.h"
+#include "vtkMRMLTransformableNode.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkPrecomputedInverseGridTransform.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkDataArray.h>
+#include <vtkGeneralTransform.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkOrientedGridTransform.h>
+#include <vtkPointData.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void SetDisplacementField(vtkMRMLGridTransformNode* transformNode, double amplitude)
+{
+  vtkNew<vtkImageData> displacementField;
+  displacementField->SetExtent(0, 29, 0, 29, 0, 29);
+  displacementField->SetOrigin(-75.0, -75.0, -75.0);
+  displacementField->SetSpacing(5.0, 5.0, 5.0);
+  displacementField->AllocateScalars(VTK_DOUBLE, 3);
+  double* displacement = static_cast<double*>(displacementField->GetScalarPointer());
+  for (int k = 0; k < 30; k++)
+    {
+    for (int j = 0; j < 30; j++)
+      {
+      for (int i = 0; i < 30; i++)
+        {
+        *(displacement++) = amplitude * sin(0.2 * j);
+        *(displacement++) = amplitude * cos(0.15 * k);
+        *(displacement++) = 0.5 * amplitude * sin(0.25 * i);
+        }
+      }
+    }
+  vtkNew<vtkOrientedGridTransform> gridTransform;
+  gridTransform->SetDisplacementGridData(displacementField);
+  gridTransform->SetInterpolationModeToCubic();
+  transformNode->SetAndObserveTransformFromParent(gridTransform);
+}
+
+//----------------------------------------------------------------------------
+double GetInverseError(vtkMRMLGridTransformNode* transformNode, const double point[3])
+{
+  double pointInParent[3] = { 0.0, 0.0, 0.0 };
+  vtkNew<vtkGeneralTransform> transformToWorld;
+  transformNode->GetTransformToWorld(transformToWorld);
+  transformToWorld->TransformPoint(point, pointInParent);
+  double roundTripPoint[3] = { 0.0, 0.0, 0.0 };
+  transformNode->GetTransformFromParent()->TransformPoint(pointInParent, roundTripPoint);
+  return sqrt(vtkMath::Distance2BetweenPoints(point, roundTripPoint));
+}
+
+//----------------------------------------------------------------------------
+// Simulates the application's modified request queue: the request is stored
+// and Modified() is invoked later on the main thread by the test.
+std::atomic<vtkObject*> RequestedModifiedObject{ nullptr };
+void RequestModifiedCallback(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+  void* vtkNotUsed(clientData), void* callData)
+{
+  RequestedModifiedObject = static_cast<vtkObject*>(callData);
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int TestInverseDisplacementField()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLGridTransformNode* transformNode = vtkMRMLGridTransformNode::SafeDownCast(
+    scene->AddNewNodeByClass("vtkMRMLGridTransformNode"));
+  SetDisplacementField(transformNode, 3.0);
+  const double point[3] = { 12.3, -20.7, 31.1 };
+
+  // Disabled by default
+  CHECK_BOOL(transformNode->GetCacheInverseDisplacementField(), false);
+  CHECK_BOOL(transformNode->UpdateInverseDisplacementField(true), false);
+  CHECK_NULL(transformNode->GetInverseDisplacementField());
+  CHECK_DOUBLE_TOLERANCE(transformNode->GetInverseDisplacementFieldMaximumError(), -1.0, 1e-9);
+
+  // Compute inverse and check residual error
+  transformNode->CacheInverseDisplacementFieldOn();
+  CHECK_BOOL(transformNode->UpdateInverseDisplacementField(true), true);
+  CHECK_NOT_NULL(transformNode->GetInverseDisplacementField());
+  double maximumError = transformNode->GetInverseDisplacementFieldMaximumError();
+  double meanError = transformNode->GetInverseDisplacementFieldMeanError();
+  std::cout << "Inverse displacement field error: maximum = " << maximumError << " mean = " << meanError << std::endl;
+  CHECK_BOOL(maximumError >= 0.0 && maximumError < 0.5, true);
+  CHECK_BOOL(meanError >= 0.0 && meanError <= maximumError, true);
+
+  // Precomputed inverse is used for computing transform to world
+  vtkNew<vtkGeneralTransform> transformToWorld;
+  transformNode->GetTransformToWorld(transformToWorld);
+  CHECK_BOOL(GetInverseError(transformNode, point) < 0.5, true);
+  // Stored transforms are not affected
+  CHECK_BOOL(vtkPrecomputedInverseGridTransform::SafeDownCast(transformNode->GetTransformToParent()) == nullptr, true);
+
+  // Inverse of the precomputed inverse is the exact original transform
+  double pointInParent[3] = { 0.0, 0.0, 0.0 };
+  double pointInParentExpected[3] = { 0.0, 0.0, 0.0 };
+  vtkNew<vtkGeneralTransform> transformFromWorld;
+  transformNode->GetTransformFromWorld(transformFromWorld);
+  transformFromWorld->TransformPoint(point, pointInParent);
+  transformNode->GetTransformFromParent()->TransformPoint(point, pointInParentExpected);
+  CHECK_DOUBLE_TOLERANCE(pointInParent[0], pointInParentExpected[0], 1e-9);
+  CHECK_DOUBLE_TOLERANCE(pointInParent[1], pointInParentExpected[1], 1e-9);
+  CHECK_DOUBLE_TOLERANCE(pointInParent[2], pointInParentExpected[2], 1e-9);
+
+  // Transformable nodes use the precomputed inverse
+  vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(scene->AddNewNodeByClass("vtkMRMLModelNode"));
+  modelNode->SetAndObserveTransformNodeID(transformNode->GetID());
+  double pointWorld[3] = { 0.0, 0.0, 0.0 };
+  double pointWorldExpected[3] = { 0.0, 0.0, 0.0 };
+  modelNode->TransformPointToWorld(point, pointWorld);
+  transformToWorld->TransformPoint(point, pointWorldExpected);
+  CHECK_DOUBLE_TOLERANCE(pointWorld[0], pointWorldExpected[0], 1e-9);
+
+  // Modification of the displacement field invalidates the inverse
+  SetDisplacementField(transformNode, 5.0);
+  CHECK_BOOL(transformNode->IsInverseDisplacementFieldUpToDate(), false);
+  CHECK_NULL(transformNode->GetInverseDisplacementField());
+  vtkImageData* displacementField = vtkOrientedGridTransform::SafeDownCast(
+    transformNode->GetTransformFromParent())->GetDisplacementGrid();
+  CHECK_BOOL(transformNode->UpdateInverseDisplacementField(true), true);
+  displacementField->GetPointData()->GetScalars()->SetComponent(100, 0, 10.0);
+  displacementField->GetPointData()->GetScalars()->Modified();
+  CHECK_BOOL(transformNode->IsInverseDisplacementFieldUpToDate(), false);
+  CHECK_BOOL(transformNode->UpdateInverseDisplacementField(true), true);
+  CHECK_BOOL(GetInverseError(transformNode, point) < 0.5, true);
+
+  // Inverted node: the stored transform is transform to parent
+  transformNode->Inverse();
+  CHECK_BOOL(transformNode->UpdateInverseDisplacementField(true), true);
+  vtkNew<vtkGeneralTransform> invertedTransformToWorld;
+  transformNode->GetTransformToWorld(invertedTransformToWorld);
+  invertedTransformToWorld->TransformPoint(point, pointWorld);
+  transformNode->GetTransformToParent()->TransformPoint(point, pointWorldExpected);
+  CHECK_DOUBLE_TOLERANCE(pointWorld[0], pointWorldExpected[0], 1e-9);
+  CHECK_DOUBLE_TOLERANCE(pointWorld[1], pointWorldExpected[1], 1e-9);
+  CHECK_DOUBLE_TOLERANCE(pointWorld[2], pointWorldExpected[2], 1e-9);
+
+  // Completion of the background computation is reported on the main thread
+  vtkNew<vtkCallbackCommand> requestModifiedCallback;
+  requestModifiedCallback->SetCallback(RequestModifiedCallback);
+  vtkEventBroker::GetInstance()->SetRequestModifiedCallback(requestModifiedCallback);
+  vtkNew<vtkMRMLCoreTestingUtilities::vtkMRMLNodeCallback> transformModifiedCallback;
+  transformNode->AddObserver(vtkMRMLTransformableNode::TransformModifiedEvent, transformModifiedCallback);
+  SetDisplacementField(transformNode, 2.0);
+  transformModifiedCallback->ResetNumberOfEvents();
+  transformNode->GetTransformToWorld(transformToWorld);
+  for (int i = 0; i < 6000 && !RequestedModifiedObject; i++)
+    {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  CHECK_NOT_NULL(RequestedModifiedObject.load());
+  CHECK_BOOL(transformNode->IsInverseDisplacementFieldUpToDate(), false);
+  CHECK_INT(transformModifiedCallback->GetNumberOfEvents(vtkMRMLTransformableNode::TransformModifiedEvent), 0);
+  RequestedModifiedObject.load()->Modified();
+  CHECK_BOOL(transformNode->IsInverseDisplacementFieldUpToDate(), true);
+  CHECK_INT(transformModifiedCallback->GetNumberOfEvents(vtkMRMLTransformableNode::TransformModifiedEvent), 1);
+  vtkEventBroker::GetInstance()->SetRequestModifiedCallback(nullptr);
+  transformNode->RemoveObserver(transformModifiedCallback);
+
+  // Background computation is canceled when caching is disabled
+  SetDisplacementField(transformNode, 4.0);
+  transformNode->UpdateInverseDisplacementField(false);
+  transformNode->CacheInverseDisplacementFieldOff();
+  CHECK_NULL(transformNode->GetInverseDisplacementField());
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestInverseDisplacementFieldPerformance()
+{
+  const int numberOfPoints = 1000000;
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLGridTransformNode* transformNode = vtkMRMLGridTransformNode::SafeDownCast(
+    scene->AddNewNodeByClass("vtkMRMLGridTransformNode"));
+  SetDisplacementField(transformNode, 3.0);
+  vtkNew<vtkTimerLog> timer;
+
+  double point[3] = { 0.0, 0.0, 0.0 };
+  double transformedPoint[3] = { 0.0, 0.0, 0.0 };
+  vtkNew<vtkGeneralTransform> iterativeTransformToWorld;
+  transformNode->GetTransformToWorld(iterativeTransformToWorld);
+  timer->StartTimer();
+  for (int i = 0; i < numberOfPoints; i++)
+    {
+    point[0] = -60.0 + 120.0 * (i % 100) / 100.0;
+    point[1] = -60.0 + 120.0 * ((i / 100) % 100) / 100.0;
+    point[2] = -60.0 + 120.0 * (i / 10000) / 100.0;
+    iterativeTransformToWorld->TransformPoint(point, transformedPoint);
+    }
+  timer->StopTimer();
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("GridTransform-IterativeInverse1MPoints", timer->GetElapsedTime());
+
+  transformNode->CacheInverseDisplacementFieldOn();
+  timer->StartTimer();
+  CHECK_BOOL(transformNode->UpdateInverseDisplacementField(true), true);
+  timer->StopTimer();
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("GridTransform-ComputeInverseDisplacementField30x30x30", timer->GetElapsedTime());
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("GridTransform-InverseDisplacementFieldMaximumError", transformNode->GetInverseDisplacementFieldMaximumError());
+
+  vtkNew<vtkGeneralTransform> precomputedTransformToWorld;
+  transformNode->GetTransformToWorld(precomputedTransformToWorld);
+  timer->StartTimer();
+  for (int i = 0; i < numberOfPoints; i++)
+    {
+    point[0] = -60.0 + 120.0 * (i % 100) / 100.0;
+    point[1] = -60.0 + 120.0 * ((i / 100) % 100) / 100.0;
+    point[2] = -60.0 + 120.0 * (i / 10000) / 100.0;
+    precomputedTransformToWorld->TransformPoint(point, transformedPoint);
+    }
+  timer->StopTimer();
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("GridTransform-PrecomputedInverse1MPoints", timer->GetElapsedTime());
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLGridTransformNodeTest2(int , char * [] )
+{
+  CHECK_EXIT_SUCCESS(TestInverseDisplacementField());
+  CHECK_EXIT_SUCCESS(TestInverseDisplacementFieldPerformance());
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
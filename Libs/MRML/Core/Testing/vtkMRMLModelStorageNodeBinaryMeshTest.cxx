@@ -0,0 +1,240 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLBinaryMeshIO.h"
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLCoreTestingUtilities.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLModelStorageNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSphereSource.h>
+#include <vtkTimerLog.h>
+
+// VTKSYS includes
+#include <vtksys/FStream.hxx>
+
+// STD includes
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <utility>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+bool ArePointsEqual(vtkPolyData* mesh1, vtkPolyData* mesh2)
+{
+  if (mesh1->GetNumberOfPoints() != mesh2->GetNumberOfPoints())
+    {
+    return false;
+    }
+  for (vtkIdType pointIndex = 0; pointIndex < mesh1->GetNumberOfPoints(); ++pointIndex)
+    {
+    double* point1 = mesh1->GetPoint(pointIndex);
+    double* point2 = mesh2->GetPoint(pointIndex);
+    if (point1[0] != point2[0] || point1[1] != point2[1] || point1[2] != point2[2])
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+int TestReadWrite(const std::string& tempDir)
+{
+  vtkNew<vtkSphereSource> sphere;
+  sphere->SetThetaResolution(20);
+  sphere->SetPhiResolution(20);
+  sphere->Update();
+  vtkPolyData* original = sphere->GetOutput();
+  std::string fileName = tempDir + "/vtkMRMLModelStorageNodeBinaryMeshTest.bmesh";
+
+  std::string errorMessage;
+  CHECK_BOOL(vtkMRMLBinaryMeshIO::WritePolyData(fileName, original,
+    vtkMRMLStorageNode::CoordinateSystemRAS, errorMessage), true);
+  CHECK_BOOL(vtkMRMLBinaryMeshIO::CanReadFile(fileName), true);
+
+  int numberOfMappedArraysBefore = vtkMRMLBinaryMeshIO::GetNumberOfMappedArrays();
+  for (bool memoryMap : { true, false })
+    {
+      {
+      vtkNew<vtkPolyData> mesh;
+      int coordinateSystem = -1;
+      CHECK_BOOL(vtkMRMLBinaryMeshIO::ReadPolyData(fileName, mesh, coordinateSystem, errorMessage, memoryMap), true);
+      CHECK_INT(coordinateSystem, vtkMRMLStorageNode::CoordinateSystemRAS);
+      CHECK_INT(mesh->GetNumberOfPolys(), original->GetNumberOfPolys());
+      CHECK_BOOL(ArePointsEqual(mesh, original), true);
+      CHECK_NOT_NULL(mesh->GetPointData()->GetNormals());
+      CHECK_INT(mesh->GetPointData()->GetNormals()->GetNumberOfTuples(), original->GetNumberOfPoints());
+      if (memoryMap && vtkMRMLBinaryMeshIO::IsMemoryMappingSupported())
+        {
+        CHECK_BOOL(vtkMRMLBinaryMeshIO::GetNumberOfMappedArrays() > numberOfMappedArraysBefore, true);
+        }
+
+      // Modifying the mesh does not modify the file (memory is mapped copy-on-write)
+      mesh->GetPoints()->SetPoint(0, 1000.0, 1000.0, 1000.0);
+      }
+    // Mapping is released when the mesh is deleted
+    CHECK_INT(vtkMRMLBinaryMeshIO::GetNumberOfMappedArrays(), numberOfMappedArraysBefore);
+    }
+
+  vtkNew<vtkPolyData> mesh;
+  int coordinateSystem = -1;
+  CHECK_BOOL(vtkMRMLBinaryMeshIO::ReadPolyData(fileName, mesh, coordinateSystem, errorMessage), true);
+  CHECK_BOOL(ArePointsEqual(mesh, original), true);
+
+#ifdef _WIN32
+  // Files cannot be replaced on Windows while they are mapped
+  mesh->Initialize();
+#endif
+
+  // Overwrite the file
+  vtkNew<vtkSphereSource> smallSphere;
+  smallSphere->Update();
+  CHECK_BOOL(vtkMRMLBinaryMeshIO::WritePolyData(fileName, smallSphere->GetOutput(),
+    vtkMRMLStorageNode::CoordinateSystemLPS, errorMessage), true);
+#ifndef _WIN32
+  // Mesh that was read from the previous file content is not affected
+  CHECK_BOOL(ArePointsEqual(mesh, original), true);
+#endif
+  vtkNew<vtkPolyData> smallMesh;
+  CHECK_BOOL(vtkMRMLBinaryMeshIO::ReadPolyData(fileName, smallMesh, coordinateSystem, errorMessage), true);
+  CHECK_INT(coordinateSystem, vtkMRMLStorageNode::CoordinateSystemLPS);
+  CHECK_BOOL(ArePointsEqual(smallMesh, smallSphere->GetOutput()), true);
+
+  // Invalid files are rejected
+  std::string missingFileName = tempDir + "/vtkMRMLModelStorageNodeBinaryMeshTest_missing.bmesh";
+  CHECK_BOOL(vtkMRMLBinaryMeshIO::CanReadFile(missingFileName), false);
+  CHECK_BOOL(vtkMRMLBinaryMeshIO::ReadPolyData(missingFileName, smallMesh, coordinateSystem, errorMessage), false);
+  CHECK_BOOL(errorMessage.empty(), false);
+
+  // Corrupted block table size and block size are rejected before anything is allocated
+  std::string fileContent;
+    {
+    vtksys::ifstream stream(fileName.c_str(), std::ios::in | std::ios::binary);
+    fileContent.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    }
+  const size_t numberOfBlocksPosition = 20;
+  const size_t firstBlockSizePosition = 64 + 32;
+  std::string corruptedFileName = tempDir + "/vtkMRMLModelStorageNodeBinaryMeshTest_corrupted.bmesh";
+  for (size_t position : { numberOfBlocksPosition, firstBlockSizePosition })
+    {
+    std::string corruptedContent = fileContent;
+    const vtkTypeUInt64 hugeValue = 0xFFFFFFFFFFFFFFC0ull;
+    memcpy(&corruptedContent[position], &hugeValue, position == numberOfBlocksPosition ? 4 : 8);
+      {
+      vtksys::ofstream stream(corruptedFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+      stream.write(corruptedContent.data(), static_cast<std::streamsize>(corruptedContent.size()));
+      }
+    errorMessage.clear();
+    CHECK_BOOL(vtkMRMLBinaryMeshIO::ReadPolyData(corruptedFileName, smallMesh, coordinateSystem, errorMessage), false);
+    CHECK_BOOL(errorMessage.empty(), false);
+    }
+
+  // Blocks that overlap each other or the block table are rejected, as their
+  // memory-mapped arrays would share memory
+  const size_t firstBlockOffsetPosition = 64 + 24;
+  const size_t secondBlockOffsetPosition = 64 + 128 + 24;
+  vtkTypeUInt64 firstBlockOffset = 0;
+  memcpy(&firstBlockOffset, &fileContent[firstBlockOffsetPosition], sizeof(firstBlockOffset));
+  const vtkTypeUInt64 blockTableOffset = 64;
+  for (const std::pair<size_t, vtkTypeUInt64>& corruption :
+    { std::make_pair(secondBlockOffsetPosition, firstBlockOffset), std::make_pair(firstBlockOffsetPosition, blockTableOffset) })
+    {
+    std::string corruptedContent = fileContent;
+    memcpy(&corruptedContent[corruption.first], &corruption.second, sizeof(vtkTypeUInt64));
+      {
+      vtksys::ofstream stream(corruptedFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+      stream.write(corruptedContent.data(), static_cast<std::streamsize>(corruptedContent.size()));
+      }
+    int numberOfMappedArraysBefore = vtkMRMLBinaryMeshIO::GetNumberOfMappedArrays();
+    errorMessage.clear();
+    CHECK_BOOL(vtkMRMLBinaryMeshIO::ReadPolyData(corruptedFileName, smallMesh, coordinateSystem, errorMessage), false);
+    CHECK_BOOL(errorMessage.empty(), false);
+    CHECK_INT(vtkMRMLBinaryMeshIO::GetNumberOfMappedArrays(), numberOfMappedArraysBefore);
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestReadPerformance(const std::string& tempDir)
+{
+  vtkNew<vtkSphereSource> sphere;
+  sphere->SetThetaResolution(500);
+  sphere->SetPhiResolution(500);
+  sphere->Update();
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(scene->AddNewNodeByClass("vtkMRMLModelNode"));
+  modelNode->SetAndObservePolyData(sphere->GetOutput());
+  vtkNew<vtkMRMLModelStorageNode> storageNode;
+  scene->AddNode(storageNode);
+  // Default (LPS) coordinate system: binary mesh files are still stored in RAS and read without conversion
+  storageNode->SetUseCompression(true);
+  modelNode->SetAndObserveStorageNodeID(storageNode->GetID());
+
+  vtkNew<vtkTimerLog> timer;
+  for (const char* extension : { ".vtk", ".vtp", ".stl", ".ply", ".bmesh" })
+    {
+    std::string fileName = tempDir + "/vtkMRMLModelStorageNodeBinaryMeshTest_performance" + extension;
+    storageNode->SetFileName(fileName.c_str());
+    CHECK_BOOL(storageNode->WriteData(modelNode) != 0, true);
+
+    modelNode->SetAndObservePolyData(nullptr);
+    timer->StartTimer();
+    CHECK_BOOL(storageNode->ReadData(modelNode) != 0, true);
+    timer->StopTimer();
+    CHECK_NOT_NULL(modelNode->GetPolyData());
+    // STL and PLY writers triangulate and readers may merge points
+    CHECK_BOOL(modelNode->GetPolyData()->GetNumberOfPoints() > 0, true);
+    if (std::string(extension) == ".bmesh" && vtkMRMLBinaryMeshIO::IsMemoryMappingSupported())
+      {
+      // Points are used directly from the mapped file
+      CHECK_INT(storageNode->GetCoordinateSystem(), vtkMRMLStorageNode::CoordinateSystemRAS);
+      CHECK_BOOL(vtkMRMLBinaryMeshIO::GetNumberOfMappedArrays() > 0, true);
+      }
+
+    vtkMRMLCoreTestingUtilities::PrintMeasurement(
+      std::string("vtkMRMLModelStorageNode-ReadPerformance-") + (extension + 1), timer->GetElapsedTime());
+    }
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLModelStorageNodeBinaryMeshTest(int argc, char * argv[])
+{
+  if (argc != 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string tempDir = argv[1];
+
+  CHECK_EXIT_SUCCESS(TestReadWrite(tempDir));
+  CHECK_EXIT_SUCCESS(TestReadPerformance(tempDir));
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -54,6 +54,11 @@ int vtkMRMLModelStorageNodeTest1(int argc, char * argv[])
     CHECK_EXIT_SUCCESS(TestReadWriteData(scene.GetPointer(), ".stl", poly.GetPointer(), coordinateSystem, true));
     CHECK_EXIT_SUCCESS(TestReadWriteData(scene.GetPointer(), ".ply", poly.GetPointer(), coordinateSystem, true));
     CHECK_EXIT_SUCCESS(TestReadWriteData(scene.GetPointer(), ".obj", poly.GetPointer(), coordinateSystem));
+    if (coordinateSystem == vtkMRMLStorageNode::CoordinateSystemRAS)
+      {
+      // binary mesh files are always stored in RAS
+      CHECK_EXIT_SUCCESS(TestReadWriteData(scene.GetPointer(), ".bmesh", poly.GetPointer(), coordinateSystem));
+      }
     CHECK_EXIT_SUCCESS(TestReadWriteData(scene.GetPointer(), ".vtk", ug.GetPointer(), coordinateSystem));
     CHECK_EXIT_SUCCESS(TestReadWriteData(scene.GetPointer(), ".vtu", ug.GetPointer(), coordinateSystem));
     }
@@ -0,0 +1,144 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkDataIOManager.h"
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLModelStorageNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkCollection.h>
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+#include <vtkSphereSource.h>
+
+// STD includes
+#include <sstream>
+#include <string>
+
+namespace
+{
+const int NumberOfModels = 6;
+
+//---------------------------------------------------------------------------
+int CreateScene(const std::string& tempDir, const std::string& sceneFileName)
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetRootDirectory(tempDir.c_str());
+  for (int i = 0; i < NumberOfModels; ++i)
+    {
+    vtkNew<vtkSphereSource> sphere;
+    sphere->SetThetaResolution(10 + i);
+    sphere->SetPhiResolution(10 + i);
+    sphere->Update();
+
+    vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(scene->AddNewNodeByClass("vtkMRMLModelNode"));
+    modelNode->SetAndObservePolyData(sphere->GetOutput());
+    modelNode->AddDefaultStorageNode();
+    vtkMRMLStorageNode* storageNode = modelNode->GetStorageNode();
+    CHECK_NOT_NULL(storageNode);
+    std::stringstream fileName;
+    fileName << tempDir << "/vtkMRMLScenePrefetchDataTest_" << i << (i % 2 ? ".vtp" : ".vtk");
+    storageNode->SetFileName(fileName.str().c_str());
+    CHECK_BOOL(storageNode->WriteData(modelNode), true);
+    }
+  scene->SetURL(sceneFileName.c_str());
+  CHECK_BOOL(scene->Commit() != 0, true);
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestLoadScene(const std::string& sceneFileName, bool parallel)
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkDataIOManager> dataIOManager;
+  dataIOManager->SetEnableParallelLocalRead(parallel);
+  scene->SetDataIOManager(dataIOManager);
+  scene->SetURL(sceneFileName.c_str());
+  CHECK_BOOL(scene->Connect() != 0, true);
+
+  vtkSmartPointer<vtkCollection> modelNodes = vtkSmartPointer<vtkCollection>::Take(
+    scene->GetNodesByClass("vtkMRMLModelNode"));
+  CHECK_INT(modelNodes->GetNumberOfItems(), NumberOfModels);
+  for (int i = 0; i < NumberOfModels; ++i)
+    {
+    vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(modelNodes->GetItemAsObject(i));
+    CHECK_NOT_NULL(modelNode->GetPolyData());
+    // Sphere source generates (resolution - 2) * resolution + 2 points
+    int resolution = 10 + i;
+    CHECK_INT(modelNode->GetPolyData()->GetNumberOfPoints(), (resolution - 2) * resolution + 2);
+    CHECK_BOOL(modelNode->GetStorageNode()->GetLastReadDataTime() >= 0.0, true);
+    }
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestPrefetchStorageNode(const std::string& tempDir)
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSphereSource> sphere;
+  sphere->Update();
+  vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(scene->AddNewNodeByClass("vtkMRMLModelNode"));
+  modelNode->SetAndObservePolyData(sphere->GetOutput());
+  modelNode->AddDefaultStorageNode();
+  vtkMRMLStorageNode* storageNode = modelNode->GetStorageNode();
+  std::string fileName = tempDir + "/vtkMRMLScenePrefetchDataTest.vtk";
+  storageNode->SetFileName(fileName.c_str());
+  CHECK_BOOL(storageNode->WriteData(modelNode), true);
+  int numberOfPoints = sphere->GetOutput()->GetNumberOfPoints();
+
+  // Prefetching does not modify the node
+  modelNode->SetAndObservePolyData(nullptr);
+  CHECK_BOOL(storageNode->CanPrefetchData(modelNode), true);
+  CHECK_BOOL(storageNode->PrefetchData(modelNode), true);
+  CHECK_NULL(modelNode->GetPolyData());
+
+  // Prefetched data is set in the node by ReadData
+  CHECK_BOOL(storageNode->ReadData(modelNode) != 0, true);
+  CHECK_NOT_NULL(modelNode->GetPolyData());
+  CHECK_INT(modelNode->GetPolyData()->GetNumberOfPoints(), numberOfPoints);
+
+  // Prefetched data is only used once, next ReadData reads from file
+  modelNode->SetAndObservePolyData(nullptr);
+  CHECK_BOOL(storageNode->ReadData(modelNode) != 0, true);
+  CHECK_INT(modelNode->GetPolyData()->GetNumberOfPoints(), numberOfPoints);
+
+  // Prefetching a missing file fails without modifying the node
+  storageNode->SetFileName((tempDir + "/vtkMRMLScenePrefetchDataTest_missing.vtk").c_str());
+  CHECK_BOOL(storageNode->PrefetchData(modelNode), false);
+  CHECK_INT(modelNode->GetPolyData()->GetNumberOfPoints(), numberOfPoints);
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLScenePrefetchDataTest(int argc, char * argv[])
+{
+  if (argc != 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string tempDir = argv[1];
+  std::string sceneFileName = tempDir + "/vtkMRMLScenePrefetchDataTest.mrml";
+
+  CHECK_EXIT_SUCCESS(TestPrefetchStorageNode(tempDir));
+  CHECK_EXIT_SUCCESS(CreateScene(tempDir, sceneFileName));
+  CHECK_EXIT_SUCCESS(TestLoadScene(sceneFileName, false));
+  CHECK_EXIT_SUCCESS(TestLoadScene(sceneFileName, true));
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
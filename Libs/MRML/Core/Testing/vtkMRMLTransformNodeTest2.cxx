@@ -0,0 +1,220 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLCoreTestingUtilities.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLTransformNode.h"
+
+// VTK includes
+#include <vtkGeneralTransform.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkThinPlateSplineTransform.h>
+#include <vtkTimerLog.h>
+#include <vtkTransform.h>
+
+// STD includes
+#include <cmath>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+std::vector<vtkMRMLTransformNode*> CreateLinearTransformChain(vtkMRMLScene* scene, int numberOfTransforms)
+{
+  std::vector<vtkMRMLTransformNode*> transformNodes;
+  for (int i = 0; i < numberOfTransforms; i++)
+    {
+    vtkMRMLTransformNode* transformNode = vtkMRMLTransformNode::SafeDownCast(
+      scene->AddNewNodeByClass("vtkMRMLLinearTransformNode"));
+    vtkNew<vtkTransform> transform;
+    transform->Translate(1.0, 0.5 * i, -2.0);
+    transform->RotateZ(3.0 + i);
+    transformNode->SetMatrixTransformToParent(transform->GetMatrix());
+    if (!transformNodes.empty())
+      {
+      transformNodes.back()->SetAndObserveTransformNodeID(transformNode->GetID());
+      }
+    transformNodes.push_back(transformNode);
+    }
+  return transformNodes;
+}
+
+//----------------------------------------------------------------------------
+bool ArePointsEqual(const double point1[3], const double point2[3], double tolerance = 1e-6)
+{
+  for (int i = 0; i < 3; i++)
+    {
+    if (fabs(point1[i] - point2[i]) > tolerance)
+      {
+      std::cerr << "Point mismatch: (" << point1[0] << ", " << point1[1] << ", " << point1[2] << ") != ("
+        << point2[0] << ", " << point2[1] << ", " << point2[2] << ")" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool IsCachedTransformToWorldCorrect(vtkMRMLTransformNode* transformNode)
+{
+  const double pointLocal[3] = { 10.0, -20.0, 30.0 };
+  double pointWorldExpected[3] = { 0.0, 0.0, 0.0 };
+  vtkNew<vtkGeneralTransform> transformToWorld;
+  transformNode->GetTransformToWorld(transformToWorld);
+  transformToWorld->TransformPoint(pointLocal, pointWorldExpected);
+
+  double pointWorld[3] = { 0.0, 0.0, 0.0 };
+  transformNode->GetCachedTransformToWorld()->TransformPoint(pointLocal, pointWorld);
+  if (!ArePointsEqual(pointWorld, pointWorldExpected))
+    {
+    return false;
+    }
+  double pointLocalComputed[3] = { 0.0, 0.0, 0.0 };
+  transformNode->GetCachedTransformFromWorld()->TransformPoint(pointWorld, pointLocalComputed);
+  return ArePointsEqual(pointLocalComputed, pointLocal, 1e-3);
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int TestCachedTransformToWorld()
+{
+  vtkNew<vtkMRMLScene> scene;
+  std::vector<vtkMRMLTransformNode*> transformNodes = CreateLinearTransformChain(scene, 5);
+  vtkMRMLTransformNode* leafNode = transformNodes[0];
+
+  // Linear chain is collapsed into a single matrix
+  CHECK_BOOL(IsCachedTransformToWorldCorrect(leafNode), true);
+  CHECK_BOOL(vtkTransform::SafeDownCast(leafNode->GetCachedTransformToWorld()) != nullptr, true);
+  CHECK_INT(leafNode->IsTransformToWorldLinear(), 1);
+  vtkNew<vtkMatrix4x4> matrixToWorld;
+  CHECK_INT(leafNode->GetMatrixTransformToWorld(matrixToWorld), 1);
+  double pointLocal[4] = { 10.0, -20.0, 30.0, 1.0 };
+  double pointWorld[4] = { 0.0, 0.0, 0.0, 1.0 };
+  double pointWorldExpected[4] = { 0.0, 0.0, 0.0, 1.0 };
+  matrixToWorld->MultiplyPoint(pointLocal, pointWorld);
+  leafNode->GetCachedTransformToWorld()->TransformPoint(pointLocal, pointWorldExpected);
+  CHECK_BOOL(ArePointsEqual(pointWorld, pointWorldExpected), true);
+
+  // Cached transform is updated when a transform in the chain is modified
+  vtkNew<vtkMatrix4x4> matrix;
+  matrix->SetElement(1, 3, 100.0);
+  transformNodes[2]->SetMatrixTransformToParent(matrix);
+  CHECK_BOOL(IsCachedTransformToWorldCorrect(leafNode), true);
+
+  // Cached transform is updated when the chain is modified
+  transformNodes[1]->SetAndObserveTransformNodeID(transformNodes[3]->GetID());
+  CHECK_BOOL(IsCachedTransformToWorldCorrect(leafNode), true);
+  transformNodes[3]->SetAndObserveTransformNodeID(nullptr);
+  CHECK_BOOL(IsCachedTransformToWorldCorrect(leafNode), true);
+
+  // Transformable nodes use the cached transform
+  vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(scene->AddNewNodeByClass("vtkMRMLModelNode"));
+  modelNode->SetAndObserveTransformNodeID(leafNode->GetID());
+  double pointWorldFromModel[3] = { 0.0, 0.0, 0.0 };
+  modelNode->TransformPointToWorld(pointLocal, pointWorldFromModel);
+  leafNode->GetCachedTransformToWorld()->TransformPoint(pointLocal, pointWorldExpected);
+  CHECK_BOOL(ArePointsEqual(pointWorldFromModel, pointWorldExpected), true);
+
+  // Mixed chain: non-linear transform in the middle
+  vtkNew<vtkPoints> sourceLandmarks;
+  vtkNew<vtkPoints> targetLandmarks;
+  for (int i = 0; i < 8; i++)
+    {
+    double point[3] = { (i & 1) ? 50.0 : -50.0, (i & 2) ? 50.0 : -50.0, (i & 4) ? 50.0 : -50.0 };
+    sourceLandmarks->InsertNextPoint(point);
+    point[0] += (i == 3 ? 5.0 : 0.0);
+    targetLandmarks->InsertNextPoint(point);
+    }
+  vtkNew<vtkThinPlateSplineTransform> thinPlateSplineTransform;
+  thinPlateSplineTransform->SetSourceLandmarks(sourceLandmarks);
+  thinPlateSplineTransform->SetTargetLandmarks(targetLandmarks);
+  thinPlateSplineTransform->SetBasisToR();
+  transformNodes[1]->SetAndObserveTransformToParent(thinPlateSplineTransform);
+  CHECK_INT(leafNode->IsTransformToWorldLinear(), 0);
+  CHECK_BOOL(vtkGeneralTransform::SafeDownCast(leafNode->GetCachedTransformToWorld()) != nullptr, true);
+  CHECK_BOOL(IsCachedTransformToWorldCorrect(leafNode), true);
+  CHECK_BOOL(IsCachedTransformToWorldCorrect(transformNodes[2]), true);
+
+  // Non-linear transform is modified
+  targetLandmarks->SetPoint(3, 55.0, 50.0, -40.0);
+  thinPlateSplineTransform->SetTargetLandmarks(targetLandmarks);
+  thinPlateSplineTransform->Modified();
+  CHECK_BOOL(IsCachedTransformToWorldCorrect(leafNode), true);
+
+  // Chain becomes linear again
+  transformNodes[1]->SetAndObserveTransformToParent(nullptr);
+  transformNodes[1]->SetMatrixTransformToParent(matrix);
+  CHECK_INT(leafNode->IsTransformToWorldLinear(), 1);
+  CHECK_BOOL(IsCachedTransformToWorldCorrect(leafNode), true);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestCachedTransformToWorldPerformance()
+{
+  const int numberOfTransforms = 50;
+  const int numberOfPoints = 10000;
+  vtkNew<vtkMRMLScene> scene;
+  std::vector<vtkMRMLTransformNode*> transformNodes = CreateLinearTransformChain(scene, numberOfTransforms);
+  vtkMRMLTransformNode* leafNode = transformNodes[0];
+  vtkNew<vtkTimerLog> timer;
+
+  double pointLocal[3] = { 10.0, -20.0, 30.0 };
+  double pointWorld[3] = { 0.0, 0.0, 0.0 };
+  double pointWorldFromCache[3] = { 0.0, 0.0, 0.0 };
+  timer->StartTimer();
+  for (int i = 0; i < numberOfPoints; i++)
+    {
+    vtkNew<vtkGeneralTransform> transformToWorld;
+    leafNode->GetTransformToWorld(transformToWorld);
+    transformToWorld->TransformPoint(pointLocal, pointWorld);
+    }
+  timer->StopTimer();
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("TransformNode-GetTransformToWorld50Deep10kPoints", timer->GetElapsedTime());
+
+  timer->StartTimer();
+  for (int i = 0; i < numberOfPoints; i++)
+    {
+    leafNode->GetCachedTransformToWorld()->TransformPoint(pointLocal, pointWorldFromCache);
+    }
+  timer->StopTimer();
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("TransformNode-GetCachedTransformToWorld50Deep10kPoints", timer->GetElapsedTime());
+  CHECK_BOOL(ArePointsEqual(pointWorld, pointWorldFromCache), true);
+
+  vtkNew<vtkMatrix4x4> matrixToWorld;
+  timer->StartTimer();
+  for (int i = 0; i < numberOfPoints; i++)
+    {
+    leafNode->GetMatrixTransformToWorld(matrixToWorld);
+    }
+  timer->StopTimer();
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("TransformNode-GetMatrixTransformToWorld50Deep10k", timer->GetElapsedTime());
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLTransformNodeTest2(int , char * [] )
+{
+  CHECK_EXIT_SUCCESS(TestCachedTransformToWorld());
+  CHECK_EXIT_SUCCESS(TestCachedTransformToWorldPerformance());
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,379 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLCoreTestingUtilities.h"
+#include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLSequenceNode.h"
+#include "vtkMRMLVolumeSequenceChunkedIO.h"
+#include "vtkMRMLVolumeSequenceStorageNode.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
+// VTKSYS includes
+#include <vtksys/FStream.hxx>
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <cstring>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+short GetExpectedVoxelValue(int frameIndex, int i, int j, int k)
+{
+  return static_cast<short>(frameIndex * 100 + (i + j + k) % 50);
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLSequenceNode* CreateSequence(vtkMRMLScene* scene, int numberOfFrames, int size)
+{
+  vtkMRMLSequenceNode* sequenceNode = vtkMRMLSequenceNode::SafeDownCast(scene->AddNewNodeByClass("vtkMRMLSequenceNode", "Sequence"));
+  sequenceNode->SetIndexName("time");
+  sequenceNode->SetIndexUnit("s");
+  sequenceNode->SetAttribute("Test attribute", "some value = 5%");
+  for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+    {
+    vtkNew<vtkImageData> imageData;
+    imageData->SetDimensions(size, size, size / 2);
+    imageData->AllocateScalars(VTK_SHORT, 1);
+    for (int k = 0; k < size / 2; ++k)
+      {
+      for (int j = 0; j < size; ++j)
+        {
+        for (int i = 0; i < size; ++i)
+          {
+          *static_cast<short*>(imageData->GetScalarPointer(i, j, k)) = GetExpectedVoxelValue(frameIndex, i, j, k);
+          }
+        }
+      }
+    vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+    volumeNode->SetAndObserveImageData(imageData);
+    volumeNode->SetSpacing(0.5, 0.5, 2.0);
+    volumeNode->SetOrigin(10.0, 20.0, 30.0);
+    std::stringstream indexValue;
+    indexValue << frameIndex * 0.5;
+    sequenceNode->SetDataNodeAtValue(volumeNode, indexValue.str());
+    }
+  return sequenceNode;
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLSequenceNode* ReadSequence(vtkMRMLScene* scene, const std::string& fileName)
+{
+  vtkMRMLSequenceNode* sequenceNode = vtkMRMLSequenceNode::SafeDownCast(scene->AddNewNodeByClass("vtkMRMLSequenceNode", "ReadSequence"));
+  vtkNew<vtkMRMLVolumeSequenceStorageNode> storageNode;
+  scene->AddNode(storageNode);
+  storageNode->SetFileName(fileName.c_str());
+  sequenceNode->SetAndObserveStorageNodeID(storageNode->GetID());
+  if (!storageNode->ReadData(sequenceNode))
+    {
+    return nullptr;
+    }
+  return sequenceNode;
+}
+
+//---------------------------------------------------------------------------
+bool IsFrameContentValid(vtkMRMLSequenceNode* sequenceNode, int frameIndex, short expectedFirstVoxelValue)
+{
+  vtkMRMLScalarVolumeNode* volumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(frameIndex));
+  if (!volumeNode || !volumeNode->GetImageData())
+    {
+    std::cerr << "Frame " << frameIndex << " has no image data" << std::endl;
+    return false;
+    }
+  vtkImageData* imageData = volumeNode->GetImageData();
+  if (*static_cast<short*>(imageData->GetScalarPointer(0, 0, 0)) != expectedFirstVoxelValue
+    || *static_cast<short*>(imageData->GetScalarPointer(3, 2, 1)) != GetExpectedVoxelValue(frameIndex, 3, 2, 1))
+    {
+    std::cerr << "Frame " << frameIndex << " has unexpected content" << std::endl;
+    return false;
+    }
+  double spacing[3] = { 0.0, 0.0, 0.0 };
+  volumeNode->GetSpacing(spacing);
+  if (spacing[0] != 0.5 || spacing[2] != 2.0 || volumeNode->GetOrigin()[1] != 20.0)
+    {
+    std::cerr << "Frame " << frameIndex << " has unexpected geometry" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+/// Copies the file, replacing the 64-bit value at the specified byte offset and
+/// keeping only the first truncatedSize bytes (if nonzero).
+bool WriteCorruptedFile(const std::string& fileName, const std::string& corruptedFileName,
+  std::streamoff valueOffset, vtkTypeUInt64 value, std::size_t truncatedSize = 0)
+{
+  vtksys::ifstream inputStream(fileName.c_str(), std::ios::in | std::ios::binary);
+  std::string content((std::istreambuf_iterator<char>(inputStream)), std::istreambuf_iterator<char>());
+  if (content.size() < static_cast<std::size_t>(valueOffset) + sizeof(value))
+    {
+    std::cerr << "File " << fileName << " is too small" << std::endl;
+    return false;
+    }
+  memcpy(&content[static_cast<std::size_t>(valueOffset)], &value, sizeof(value));
+  if (truncatedSize > 0 && truncatedSize < content.size())
+    {
+    content.resize(truncatedSize);
+    }
+  vtksys::ofstream outputStream(corruptedFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  outputStream.write(content.data(), static_cast<std::streamsize>(content.size()));
+  return outputStream.good();
+}
+
+//---------------------------------------------------------------------------
+vtkTypeUInt64 ReadUInt64(const std::string& fileName, std::streamoff valueOffset)
+{
+  vtkTypeUInt64 value = 0;
+  vtksys::ifstream stream(fileName.c_str(), std::ios::in | std::ios::binary);
+  stream.seekg(valueOffset);
+  stream.read(reinterpret_cast<char*>(&value), sizeof(value));
+  return value;
+}
+
+//---------------------------------------------------------------------------
+int TestReadWrite(const std::string& tempDir)
+{
+  const int numberOfFrames = 20;
+  std::string fileName = tempDir + "/vtkMRMLVolumeSequenceStorageNodeChunkedTest.vseq";
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLSequenceNode* sequenceNode = CreateSequence(scene, numberOfFrames, 16);
+  vtkNew<vtkMRMLVolumeSequenceStorageNode> storageNode;
+  scene->AddNode(storageNode);
+  storageNode->SetFileName(fileName.c_str());
+  storageNode->SetUseCompression(true);
+  CHECK_BOOL(storageNode->CanWriteFromReferenceNode(sequenceNode), true);
+  CHECK_BOOL(storageNode->WriteData(sequenceNode) != 0, true);
+  CHECK_BOOL(vtkMRMLVolumeSequenceChunkedIO::CanReadFile(fileName), true);
+
+  // Frames are compressed independently
+  vtkNew<vtkMRMLVolumeSequenceChunkedIO> chunkedIO;
+  std::string errorMessage;
+  CHECK_BOOL(chunkedIO->ReadHeader(fileName, errorMessage), true);
+  CHECK_INT(chunkedIO->GetNumberOfFrames(), numberOfFrames);
+  CHECK_BOOL(chunkedIO->GetFrameStoredSize(5) < 16 * 16 * 8 * sizeof(short), true);
+
+  // Reading adds the frames as compact items, no data node is created and no frame content is loaded
+  vtkNew<vtkMRMLScene> readScene;
+  vtkMRMLSequenceNode* readSequenceNode = ReadSequence(readScene, fileName);
+  CHECK_NOT_NULL(readSequenceNode);
+  CHECK_INT(readSequenceNode->GetNumberOfDataNodes(), numberOfFrames);
+  CHECK_INT(readSequenceNode->GetNumberOfCompactItems(), numberOfFrames);
+  CHECK_INT(readSequenceNode->GetNumberOfDeferredDataNodes(), 0);
+  CHECK_STD_STRING(readSequenceNode->GetIndexName(), "time");
+  CHECK_STD_STRING(readSequenceNode->GetIndexUnit(), "s");
+  CHECK_STD_STRING(readSequenceNode->GetNthIndexValue(3), "1.5");
+  CHECK_STRING(readSequenceNode->GetAttribute("Test attribute"), "some value = 5%");
+  // Data node class and scene serialization do not create data nodes of compact items
+  CHECK_STD_STRING(readSequenceNode->GetDataNodeClassName(), "vtkMRMLScalarVolumeNode");
+  std::stringstream xml;
+  readSequenceNode->WriteXML(xml, 0);
+  CHECK_NULL(readSequenceNode->GetNthDataNode(7, false));
+  CHECK_INT(readSequenceNode->GetNumberOfCompactItems(), numberOfFrames);
+  // Creating the data node of a frame does not load its content
+  CHECK_NOT_NULL(readSequenceNode->CreateCompactItemDataNode(7));
+  CHECK_NULL(vtkMRMLScalarVolumeNode::SafeDownCast(readSequenceNode->GetNthDataNode(7, false))->GetImageData());
+  CHECK_STRING(readSequenceNode->GetNthDataNode(7, false)->GetName(), "ReadSequence_0007");
+  CHECK_INT(readSequenceNode->GetNumberOfCompactItems(), numberOfFrames - 1);
+  CHECK_INT(readSequenceNode->GetNumberOfDeferredDataNodes(), 1);
+  CHECK_BOOL(readSequenceNode->GetModifiedSinceRead(), false);
+
+  // Checking if the sequence can be written does not create data nodes or load the frames
+  vtkNew<vtkMRMLVolumeSequenceStorageNode> nrrdStorageNode;
+  CHECK_BOOL(nrrdStorageNode->CanWriteFromReferenceNode(readSequenceNode), true);
+  CHECK_INT(readSequenceNode->GetNumberOfCompactItems(), numberOfFrames - 1);
+  CHECK_INT(readSequenceNode->GetNumberOfLoadedDeferredDataNodes(), 0);
+
+  // Random access, only the most recently used frames stay loaded
+  readSequenceNode->SetMaximumNumberOfLoadedDeferredDataNodes(4);
+  CHECK_BOOL(IsFrameContentValid(readSequenceNode, 7, GetExpectedVoxelValue(7, 0, 0, 0)), true);
+  CHECK_INT(readSequenceNode->GetNumberOfLoadedDeferredDataNodes(), 1);
+  CHECK_NOT_NULL(readSequenceNode->GetDataNodeAtValue("6.5"));
+  CHECK_BOOL(readSequenceNode->IsDataNodeLoaded(readSequenceNode->GetNthDataNode(13, false)), true);
+  for (int frameIndex = 0; frameIndex < numberOfFrames; frameIndex += 2)
+    {
+    CHECK_BOOL(IsFrameContentValid(readSequenceNode, frameIndex, GetExpectedVoxelValue(frameIndex, 0, 0, 0)), true);
+    }
+  CHECK_INT(readSequenceNode->GetNumberOfLoadedDeferredDataNodes(), 4);
+  CHECK_BOOL(readSequenceNode->IsDataNodeLoaded(readSequenceNode->GetNthDataNode(7, false)), false);
+  CHECK_NULL(vtkMRMLScalarVolumeNode::SafeDownCast(readSequenceNode->GetNthDataNode(7, false))->GetImageData());
+
+  // Modified frames are kept in memory
+  vtkMRMLScalarVolumeNode* modifiedVolumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(readSequenceNode->GetNthDataNode(3));
+  *static_cast<short*>(modifiedVolumeNode->GetImageData()->GetScalarPointer(0, 0, 0)) = -1;
+  modifiedVolumeNode->GetImageData()->Modified();
+  for (int frameIndex = 10; frameIndex < 16; ++frameIndex)
+    {
+    readSequenceNode->GetNthDataNode(frameIndex);
+    }
+  CHECK_NOT_NULL(readSequenceNode->GetDataNodeLoader(readSequenceNode->GetNthDataNode(0, false)));
+  CHECK_NULL(readSequenceNode->GetDataNodeLoader(modifiedVolumeNode));
+  // Frames 1, 5, 9, 17, 19 have not been accessed, frame 3 is modified
+  const int numberOfNotAccessedFrames = 5;
+  CHECK_INT(readSequenceNode->GetNumberOfCompactItems(), numberOfNotAccessedFrames);
+  CHECK_INT(readSequenceNode->GetNumberOfDeferredDataNodes(), numberOfFrames - numberOfNotAccessedFrames - 1);
+  CHECK_BOOL(IsFrameContentValid(readSequenceNode, 3, -1), true);
+
+  // Copy shares the loader
+  vtkNew<vtkMRMLSequenceNode> copiedSequenceNode;
+  copiedSequenceNode->Copy(readSequenceNode);
+  CHECK_INT(copiedSequenceNode->GetNumberOfCompactItems(), numberOfNotAccessedFrames);
+  CHECK_INT(copiedSequenceNode->GetNumberOfDeferredDataNodes(), numberOfFrames - numberOfNotAccessedFrames - 1);
+  CHECK_BOOL(IsFrameContentValid(copiedSequenceNode, 18, GetExpectedVoxelValue(18, 0, 0, 0)), true);
+  CHECK_BOOL(IsFrameContentValid(copiedSequenceNode, 3, -1), true);
+
+  // Overwrite the file that the frames are loaded from, compact items are not converted to data nodes
+  vtkMRMLStorageNode* readStorageNode = readSequenceNode->GetStorageNode();
+  readStorageNode->SetUseCompression(false);
+  CHECK_BOOL(readStorageNode->WriteData(readSequenceNode) != 0, true);
+  CHECK_INT(readSequenceNode->GetNumberOfCompactItems(), numberOfNotAccessedFrames);
+  // Frames keep being loaded on demand, from the new file content
+  CHECK_INT(readSequenceNode->GetNumberOfDeferredDataNodes(), numberOfFrames - numberOfNotAccessedFrames - 1);
+  CHECK_BOOL(IsFrameContentValid(readSequenceNode, 17, GetExpectedVoxelValue(17, 0, 0, 0)), true);
+  CHECK_BOOL(IsFrameContentValid(readSequenceNode, 12, GetExpectedVoxelValue(12, 0, 0, 0)), true);
+  CHECK_INT(readSequenceNode->GetNumberOfLoadedDeferredDataNodes(), 4);
+
+  vtkNew<vtkMRMLScene> rereadScene;
+  vtkMRMLSequenceNode* rereadSequenceNode = ReadSequence(rereadScene, fileName);
+  CHECK_NOT_NULL(rereadSequenceNode);
+  CHECK_BOOL(IsFrameContentValid(rereadSequenceNode, 3, -1), true);
+  CHECK_BOOL(IsFrameContentValid(rereadSequenceNode, 19, GetExpectedVoxelValue(19, 0, 0, 0)), true);
+
+  // Writing in NRRD format reads the voxels of compact items without creating their data nodes
+  std::string nrrdFileName = tempDir + "/vtkMRMLVolumeSequenceStorageNodeChunkedTest.seq.nrrd";
+  rereadScene->AddNode(nrrdStorageNode);
+  nrrdStorageNode->SetFileName(nrrdFileName.c_str());
+  CHECK_BOOL(nrrdStorageNode->WriteData(rereadSequenceNode) != 0, true);
+  CHECK_INT(rereadSequenceNode->GetNumberOfCompactItems(), numberOfFrames - 2);
+  vtkNew<vtkMRMLScene> nrrdScene;
+  vtkMRMLSequenceNode* nrrdSequenceNode = ReadSequence(nrrdScene, nrrdFileName);
+  CHECK_NOT_NULL(nrrdSequenceNode);
+  CHECK_BOOL(IsFrameContentValid(nrrdSequenceNode, 3, -1), true);
+  CHECK_BOOL(IsFrameContentValid(nrrdSequenceNode, 11, GetExpectedVoxelValue(11, 0, 0, 0)), true);
+
+  // All frames can be loaded permanently
+  CHECK_BOOL(rereadSequenceNode->LoadAllDeferredDataNodes(), true);
+  CHECK_INT(rereadSequenceNode->GetNumberOfDeferredDataNodes(), 0);
+  CHECK_NOT_NULL(vtkMRMLScalarVolumeNode::SafeDownCast(rereadSequenceNode->GetNthDataNode(11, false))->GetImageData());
+
+  // Invalid file
+  std::string invalidFileName = tempDir + "/vtkMRMLVolumeSequenceStorageNodeChunkedTest_invalid.vseq";
+    {
+    vtksys::ofstream stream(invalidFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    stream << "invalid";
+    }
+  CHECK_BOOL(vtkMRMLVolumeSequenceChunkedIO::CanReadFile(invalidFileName), false);
+  vtkNew<vtkMRMLScene> invalidScene;
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_NULL(ReadSequence(invalidScene, invalidFileName));
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  // Corrupted sizes in the header or frame table are detected before allocating memory
+  // (header field offsets: NumberOfFrames 40, MetadataSize 56, FrameTableOffset 64)
+  const vtkTypeUInt64 hugeValue = 0x7FFFFFFFFFFFFFFFull;
+  std::string corruptedFileName = tempDir + "/vtkMRMLVolumeSequenceStorageNodeChunkedTest_corrupted.vseq";
+  CHECK_BOOL(chunkedIO->ReadHeader(fileName, errorMessage), true);
+  CHECK_BOOL(WriteCorruptedFile(fileName, corruptedFileName, 40, hugeValue), true);
+  CHECK_BOOL(chunkedIO->ReadHeader(corruptedFileName, errorMessage), false);
+  CHECK_INT(chunkedIO->GetNumberOfFrames(), 0);
+  CHECK_BOOL(WriteCorruptedFile(fileName, corruptedFileName, 56, hugeValue), true);
+  CHECK_BOOL(chunkedIO->ReadHeader(corruptedFileName, errorMessage), false);
+  vtkTypeUInt64 frameTableOffset = ReadUInt64(fileName, 64);
+  CHECK_BOOL(WriteCorruptedFile(fileName, corruptedFileName, static_cast<std::streamoff>(frameTableOffset), hugeValue), true);
+  CHECK_BOOL(chunkedIO->ReadHeader(corruptedFileName, errorMessage), false);
+  CHECK_BOOL(WriteCorruptedFile(fileName, corruptedFileName, static_cast<std::streamoff>(frameTableOffset) + 8, hugeValue), true);
+  CHECK_BOOL(chunkedIO->ReadHeader(corruptedFileName, errorMessage), false);
+
+  // Frames are validated against the file size when they are read (the file may be truncated after the header was read)
+  CHECK_BOOL(WriteCorruptedFile(fileName, corruptedFileName, 0, ReadUInt64(fileName, 0)), true);
+  CHECK_BOOL(chunkedIO->ReadHeader(corruptedFileName, errorMessage), true);
+  CHECK_BOOL(WriteCorruptedFile(fileName, corruptedFileName, 0, ReadUInt64(fileName, 0), 512), true);
+  vtkNew<vtkImageData> frameImageData;
+  CHECK_BOOL(chunkedIO->ReadFrame(numberOfFrames - 1, frameImageData, errorMessage), false);
+  CHECK_INT(frameImageData->GetNumberOfPoints(), 0);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestReadPerformance(const std::string& tempDir)
+{
+  const int numberOfFrames = 60;
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLSequenceNode* sequenceNode = CreateSequence(scene, numberOfFrames, 64);
+  vtkNew<vtkMRMLVolumeSequenceStorageNode> storageNode;
+  scene->AddNode(storageNode);
+  storageNode->SetUseCompression(true);
+
+  vtkNew<vtkTimerLog> timer;
+  for (const char* extension : { ".seq.nrrd", ".vseq" })
+    {
+    std::string fileName = tempDir + "/vtkMRMLVolumeSequenceStorageNodeChunkedTest_performance" + extension;
+    storageNode->SetFileName(fileName.c_str());
+    timer->StartTimer();
+    CHECK_BOOL(storageNode->WriteData(sequenceNode) != 0, true);
+    timer->StopTimer();
+    double writeTime = timer->GetElapsedTime();
+
+    vtkNew<vtkMRMLScene> readScene;
+    timer->StartTimer();
+    vtkMRMLSequenceNode* readSequenceNode = ReadSequence(readScene, fileName);
+    timer->StopTimer();
+    double readTime = timer->GetElapsedTime();
+    CHECK_NOT_NULL(readSequenceNode);
+    CHECK_INT(readSequenceNode->GetNumberOfDataNodes(), numberOfFrames);
+
+    // Access frames in random order
+    timer->StartTimer();
+    for (int frameIndex : { 41, 3, 59, 17, 30, 8 })
+      {
+      CHECK_BOOL(IsFrameContentValid(readSequenceNode, frameIndex, GetExpectedVoxelValue(frameIndex, 0, 0, 0)), true);
+      }
+    timer->StopTimer();
+    double accessTime = timer->GetElapsedTime();
+
+    vtkMRMLCoreTestingUtilities::PrintMeasurement(std::string("vtkMRMLVolumeSequenceStorageNode-WriteTime-") + (extension + 1), writeTime);
+    vtkMRMLCoreTestingUtilities::PrintMeasurement(std::string("vtkMRMLVolumeSequenceStorageNode-ReadTime-") + (extension + 1), readTime);
+    vtkMRMLCoreTestingUtilities::PrintMeasurement(std::string("vtkMRMLVolumeSequenceStorageNode-RandomAccessTime-") + (extension + 1), accessTime);
+    }
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLVolumeSequenceStorageNodeChunkedTest(int argc, char * argv[])
+{
+  if (argc != 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string tempDir = argv[1];
+
+  CHECK_EXIT_SUCCESS(TestReadWrite(tempDir));
+  CHECK_EXIT_SUCCESS(TestReadPerformance(tempDir));
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
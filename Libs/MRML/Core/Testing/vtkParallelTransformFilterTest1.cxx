@@ -0,0 +1,193 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLCoreTestingUtilities.h"
+#include "vtkMRMLTransformNode.h"
+#include "vtkParallelTransformFilter.h"
+
+// VTK includes
+#include <vtkAbstractTransform.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkGridTransform.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkTimerLog.h>
+#include <vtkTransformFilter.h>
+
+// STD includes
+#include <cmath>
+#include <string>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void CreateGridTransform(vtkGridTransform* gridTransform)
+{
+  vtkNew<vtkImageData> displacementField;
+  displacementField->SetExtent(0, 19, 0, 19, 0, 19);
+  displacementField->SetOrigin(-100.0, -100.0, -100.0);
+  displacementField->SetSpacing(10.0, 10.0, 10.0);
+  displacementField->AllocateScalars(VTK_DOUBLE, 3);
+  double* displacement = static_cast<double*>(displacementField->GetScalarPointer());
+  for (int k = 0; k < 20; k++)
+    {
+    for (int j = 0; j < 20; j++)
+      {
+      for (int i = 0; i < 20; i++)
+        {
+        *(displacement++) = 5.0 * sin(0.3 * j);
+        *(displacement++) = 3.0 * cos(0.2 * k);
+        *(displacement++) = 2.0 * sin(0.4 * i);
+        }
+      }
+    }
+  gridTransform->SetDisplacementGridData(displacementField);
+  gridTransform->SetInterpolationModeToCubic();
+}
+
+//----------------------------------------------------------------------------
+void CreatePointCloud(vtkPolyData* polyData, vtkIdType numberOfPoints)
+{
+  vtkNew<vtkPoints> points;
+  points->SetNumberOfPoints(numberOfPoints);
+  vtkNew<vtkFloatArray> normals;
+  normals->SetName("Normals");
+  normals->SetNumberOfComponents(3);
+  normals->SetNumberOfTuples(numberOfPoints);
+  vtkNew<vtkDoubleArray> vectors;
+  vectors->SetName("Vectors");
+  vectors->SetNumberOfComponents(3);
+  vectors->SetNumberOfTuples(numberOfPoints);
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; pointId++)
+    {
+    double t = static_cast<double>(pointId) / numberOfPoints;
+    points->SetPoint(pointId, 80.0 * sin(97.0 * t), 80.0 * cos(61.0 * t), 160.0 * t - 80.0);
+    normals->SetTuple3(pointId, 0.0, 0.0, 1.0);
+    vectors->SetTuple3(pointId, 1.0, 0.0, 0.0);
+    }
+  polyData->SetPoints(points);
+  polyData->GetPointData()->SetNormals(normals);
+  polyData->GetPointData()->SetVectors(vectors);
+}
+
+//----------------------------------------------------------------------------
+bool AreArraysEqual(vtkDataArray* array1, vtkDataArray* array2, double tolerance)
+{
+  if (!array1 || !array2 || array1->GetNumberOfTuples() != array2->GetNumberOfTuples())
+    {
+    std::cerr << "Array size mismatch" << std::endl;
+    return false;
+    }
+  for (vtkIdType tupleIndex = 0; tupleIndex < array1->GetNumberOfTuples(); tupleIndex++)
+    {
+    for (int component = 0; component < 3; component++)
+      {
+      if (fabs(array1->GetComponent(tupleIndex, component) - array2->GetComponent(tupleIndex, component)) > tolerance)
+        {
+        std::cerr << "Mismatch at tuple " << tupleIndex << " component " << component << ": "
+          << array1->GetComponent(tupleIndex, component) << " != " << array2->GetComponent(tupleIndex, component) << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+double TransformWithFilter(vtkTransformFilter* filter, vtkAbstractTransform* transform, vtkPolyData* input)
+{
+  vtkNew<vtkTimerLog> timer;
+  filter->SetInputData(input);
+  filter->SetTransform(transform);
+  timer->StartTimer();
+  filter->Update();
+  timer->StopTimer();
+  return timer->GetElapsedTime();
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int TestParallelTransformFilter(vtkAbstractTransform* transform)
+{
+  vtkNew<vtkPolyData> polyData;
+  CreatePointCloud(polyData, 2000);
+
+  vtkNew<vtkTransformFilter> filter;
+  TransformWithFilter(filter, transform, polyData);
+  vtkNew<vtkParallelTransformFilter> parallelFilter;
+  TransformWithFilter(parallelFilter, transform, polyData);
+
+  vtkPointSet* expected = filter->GetOutput();
+  vtkPointSet* actual = parallelFilter->GetOutput();
+  CHECK_BOOL(vtkPolyData::SafeDownCast(actual) != nullptr, true);
+  CHECK_INT(actual->GetPoints()->GetDataType(), expected->GetPoints()->GetDataType());
+  CHECK_BOOL(AreArraysEqual(actual->GetPoints()->GetData(), expected->GetPoints()->GetData(), 1e-4), true);
+  CHECK_BOOL(AreArraysEqual(actual->GetPointData()->GetNormals(), expected->GetPointData()->GetNormals(), 1e-4), true);
+  CHECK_BOOL(AreArraysEqual(actual->GetPointData()->GetVectors(), expected->GetPointData()->GetVectors(), 1e-4), true);
+  CHECK_STRING(actual->GetPointData()->GetNormals()->GetName(), "Normals");
+
+  // Points only
+  vtkNew<vtkPoints> transformedPoints;
+  vtkMRMLTransformNode::TransformPoints(transform, polyData->GetPoints(), transformedPoints);
+  CHECK_BOOL(AreArraysEqual(transformedPoints->GetData(), expected->GetPoints()->GetData(), 1e-4), true);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestParallelTransformFilterPerformance(vtkAbstractTransform* transform, vtkIdType numberOfPoints, const std::string& name)
+{
+  vtkNew<vtkPolyData> polyData;
+  CreatePointCloud(polyData, numberOfPoints);
+
+  vtkNew<vtkTransformFilter> filter;
+  double serialTime = TransformWithFilter(filter, transform, polyData);
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("TransformFilter-" + name, serialTime);
+
+  vtkNew<vtkParallelTransformFilter> parallelFilter;
+  double parallelTime = TransformWithFilter(parallelFilter, transform, polyData);
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("ParallelTransformFilter-" + name, parallelTime);
+
+  CHECK_INT(parallelFilter->GetOutput()->GetNumberOfPoints(), numberOfPoints);
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int vtkParallelTransformFilterTest1(int argc, char * argv[] )
+{
+  // Performance is only measured on large data if requested (--performance)
+  bool measurePerformance = (argc > 1 && std::string(argv[1]) == "--performance");
+
+  vtkNew<vtkGridTransform> gridTransform;
+  CreateGridTransform(gridTransform);
+
+  CHECK_EXIT_SUCCESS(TestParallelTransformFilter(gridTransform));
+  // Inverse grid transform is computed iteratively
+  CHECK_EXIT_SUCCESS(TestParallelTransformFilter(gridTransform->GetInverse()));
+
+  if (measurePerformance)
+    {
+    CHECK_EXIT_SUCCESS(TestParallelTransformFilterPerformance(gridTransform, 5000000, "Grid5MPoints"));
+    CHECK_EXIT_SUCCESS(TestParallelTransformFilterPerformance(gridTransform->GetInverse(), 5000000, "InverseGrid5MPoints"));
+    }
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
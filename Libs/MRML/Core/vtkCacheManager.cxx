@@ -10,10 +10,176 @@
 #include <vtkCallbackCommand.h>
 #include <vtkObjectFactory.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <ctime>
+#include <sstream>
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <unistd.h>
+#endif
+
 vtkStandardNewMacro ( vtkCacheManager );
 
 #define MB 1000000.0
 
+namespace
+{
+
+/// Temporary files of additions that have not completed in this time (in seconds)
+/// are considered to be left behind by an application instance that has crashed.
+const long ContentCacheStalePartialFileAge = 24 * 60 * 60;
+const char* ContentCachePartialFileExtension = ".partial";
+
+struct ContentCacheEntry
+{
+  std::string FilePath;
+  unsigned long Size;
+  long AccessTime;
+};
+
+//----------------------------------------------------------------------------
+bool ParseContentCacheChecksum(const std::string& checksum, std::string& algo, std::string& digest)
+{
+  size_t separatorPosition = checksum.find(':');
+  if (separatorPosition == std::string::npos || separatorPosition == 0
+    || separatorPosition + 1 >= checksum.size())
+    {
+    return false;
+    }
+  algo = checksum.substr(0, separatorPosition);
+  digest = checksum.substr(separatorPosition + 1);
+  // only allow characters that are safe to use in file names
+  for (char& c : algo)
+    {
+    if (!isalnum(static_cast<unsigned char>(c)))
+      {
+      return false;
+      }
+    c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+    }
+  for (char& c : digest)
+    {
+    if (!isxdigit(static_cast<unsigned char>(c)))
+      {
+      return false;
+      }
+    c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool EndsWith(const std::string& str, const std::string& suffix)
+{
+  return str.size() >= suffix.size()
+    && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+//----------------------------------------------------------------------------
+void GetContentCacheEntries(const std::string& contentCacheDirectory, std::vector<ContentCacheEntry>& entries)
+{
+  vtksys::Directory algoDirectories;
+  if (contentCacheDirectory.empty() || !algoDirectories.Load(contentCacheDirectory))
+    {
+    return;
+    }
+  long now = static_cast<long>(time(nullptr));
+  for (unsigned long algoIndex = 0; algoIndex < algoDirectories.GetNumberOfFiles(); ++algoIndex)
+    {
+    std::string algoName = algoDirectories.GetFile(algoIndex);
+    std::string algoDirectory = contentCacheDirectory + "/" + algoName;
+    if (algoName == "." || algoName == ".." || !vtksys::SystemTools::FileIsDirectory(algoDirectory))
+      {
+      continue;
+      }
+    vtksys::Directory files;
+    files.Load(algoDirectory);
+    for (unsigned long fileIndex = 0; fileIndex < files.GetNumberOfFiles(); ++fileIndex)
+      {
+      ContentCacheEntry entry;
+      entry.FilePath = algoDirectory + "/" + files.GetFile(fileIndex);
+      if (vtksys::SystemTools::FileIsDirectory(entry.FilePath))
+        {
+        continue;
+        }
+      entry.AccessTime = vtksys::SystemTools::ModifiedTime(entry.FilePath);
+      if (EndsWith(entry.FilePath, ContentCachePartialFileExtension))
+        {
+        // another instance may be writing this file right now, only remove it if it is very old
+        if (now - entry.AccessTime > ContentCacheStalePartialFileAge)
+          {
+          vtksys::SystemTools::RemoveFile(entry.FilePath);
+          }
+        continue;
+        }
+      entry.Size = vtksys::SystemTools::FileLength(entry.FilePath);
+      entries.push_back(entry);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+int PruneContentCacheDirectory(const std::string& contentCacheDirectory, double cacheLimit,
+  const std::string& keepFilePath)
+{
+  std::vector<ContentCacheEntry> entries;
+  GetContentCacheEntries(contentCacheDirectory, entries);
+  double cacheSize = 0.0;
+  for (const ContentCacheEntry& entry : entries)
+    {
+    cacheSize += entry.Size;
+    }
+  if (cacheSize <= cacheLimit)
+    {
+    return 0;
+    }
+
+  // Remove least recently used files first
+  std::sort(entries.begin(), entries.end(),
+    [](const ContentCacheEntry& a, const ContentCacheEntry& b) { return a.AccessTime < b.AccessTime; });
+  int numberOfRemovedFiles = 0;
+  for (const ContentCacheEntry& entry : entries)
+    {
+    if (cacheSize <= cacheLimit)
+      {
+      break;
+      }
+    if (entry.FilePath == keepFilePath)
+      {
+      continue;
+      }
+    // Removal fails if the file is in use (on Windows) or if another instance has already removed it
+    if (vtksys::SystemTools::RemoveFile(entry.FilePath)
+      || !vtksys::SystemTools::FileExists(entry.FilePath))
+      {
+      cacheSize -= entry.Size;
+      numberOfRemovedFiles++;
+      }
+    }
+  return numberOfRemovedFiles;
+}
+
+//----------------------------------------------------------------------------
+std::string GetUniqueContentCachePartialFileName(const std::string& cachedFilePath)
+{
+  static std::atomic<unsigned int> counter(0);
+  std::stringstream ss;
+  ss << cachedFilePath << ".";
+#ifdef _WIN32
+  ss << GetCurrentProcessId();
+#else
+  ss << getpid();
+#endif
+  ss << "." << counter++ << ContentCachePartialFileExtension;
+  return ss.str();
+}
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 vtkCacheManager::vtkCacheManager()
 {
@@ -27,6 +193,10 @@ vtkCacheManager::vtkCacheManager()
   this->EnableForceRedownload = 0;
   this->InsufficientFreeBufferNotificationFlag = 0;
   // this->EnableRemoteCacheOverwriting = 1;
+  this->ContentCacheLimit = 2000;
+  this->ContentCacheHitCount = 0;
+  this->ContentCacheMissCount = 0;
+  this->ContentCacheEvictionCount = 0;
   this->uriMap.clear();
 }
 
@@ -254,6 +424,10 @@ void vtkCacheManager::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "RemoteCacheFreeBufferSize: " << this->GetRemoteCacheFreeBufferSize() << "\n";
   //os << indent << "EnableRemoteCacheOverwriting: " << this->GetEnableRemoteCacheOverwriting() << "\n";
   os << indent << "EnableForceRedownload: " << this->GetEnableForceRedownload() << "\n";
+  os << indent << "ContentCacheLimit: " << this->GetContentCacheLimit() << "\n";
+  os << indent << "ContentCacheHitCount: " << this->GetContentCacheHitCount() << "\n";
+  os << indent << "ContentCacheMissCount: " << this->GetContentCacheMissCount() << "\n";
+  os << indent << "ContentCacheEvictionCount: " << this->GetContentCacheEvictionCount() << "\n";
 }
 
 
@@ -1001,3 +1175,145 @@ const char* vtkCacheManager::FindCachedFile ( const char * target, const char *d
     }
 
 }
+
+//----------------------------------------------------------------------------
+std::string vtkCacheManager::GetContentCacheDirectory()
+{
+  if (this->RemoteCacheDirectory.empty())
+    {
+    return std::string();
+    }
+  return this->RemoteCacheDirectory + "/ContentCache";
+}
+
+//----------------------------------------------------------------------------
+std::string vtkCacheManager::GetContentCacheFilePath(const std::string& checksum)
+{
+  std::string algo;
+  std::string digest;
+  std::string contentCacheDirectory = this->GetContentCacheDirectory();
+  if (contentCacheDirectory.empty() || !ParseContentCacheChecksum(checksum, algo, digest))
+    {
+    return std::string();
+    }
+  return contentCacheDirectory + "/" + algo + "/" + digest;
+}
+
+//----------------------------------------------------------------------------
+std::string vtkCacheManager::FindFileInContentCache(const std::string& checksum)
+{
+  std::string cachedFilePath = this->GetContentCacheFilePath(checksum);
+  if (cachedFilePath.empty()
+    || !vtksys::SystemTools::FileExists(cachedFilePath, true))
+    {
+    this->ContentCacheMissCount++;
+    return std::string();
+    }
+  // Modification time is used as access time for least recently used eviction
+  vtksys::SystemTools::Touch(cachedFilePath, false);
+  this->ContentCacheHitCount++;
+  return cachedFilePath;
+}
+
+//----------------------------------------------------------------------------
+std::string vtkCacheManager::AddFileToContentCache(const std::string& filePath, const std::string& checksum,
+  bool moveFile/*=false*/)
+{
+  if (!vtksys::SystemTools::FileExists(filePath, true))
+    {
+    vtkErrorMacro("AddFileToContentCache: file not found: " << filePath);
+    return std::string();
+    }
+  std::string cachedFilePath = this->GetContentCacheFilePath(checksum);
+  if (cachedFilePath.empty())
+    {
+    vtkErrorMacro("AddFileToContentCache: invalid checksum '" << checksum
+      << "' or cache directory '" << this->RemoteCacheDirectory << "'");
+    return std::string();
+    }
+
+  if (!vtksys::SystemTools::FileExists(cachedFilePath, true))
+    {
+    vtksys::SystemTools::MakeDirectory(vtksys::SystemTools::GetFilenamePath(cachedFilePath));
+    // Write to a unique temporary file and rename it, so that other application instances
+    // never see a partially written file.
+    std::string partialFilePath = GetUniqueContentCachePartialFileName(cachedFilePath);
+    bool partialFileCreated = false;
+    if (moveFile)
+      {
+      partialFileCreated = static_cast<bool>(vtksys::SystemTools::RenameFile(filePath, partialFilePath));
+      }
+    if (!partialFileCreated)
+      {
+      // copy if requested or if the file could not be moved (e.g., it is on a different volume)
+      partialFileCreated = static_cast<bool>(vtksys::SystemTools::CopyFileAlways(filePath, partialFilePath));
+      }
+    if (!partialFileCreated)
+      {
+      vtkErrorMacro("AddFileToContentCache: failed to copy " << filePath << " to " << partialFilePath);
+      vtksys::SystemTools::RemoveFile(partialFilePath);
+      return std::string();
+      }
+    if (!vtksys::SystemTools::RenameFile(partialFilePath, cachedFilePath))
+      {
+      vtksys::SystemTools::RemoveFile(partialFilePath);
+      // the rename may fail if another instance has just added the same file
+      if (!vtksys::SystemTools::FileExists(cachedFilePath, true))
+        {
+        vtkErrorMacro("AddFileToContentCache: failed to create " << cachedFilePath);
+        return std::string();
+        }
+      }
+    }
+  if (moveFile && vtksys::SystemTools::FileExists(filePath))
+    {
+    vtksys::SystemTools::RemoveFile(filePath);
+    }
+
+  vtksys::SystemTools::Touch(cachedFilePath, false);
+  // the file that has just been added is kept even if it exceeds the limit in itself
+  this->ContentCacheEvictionCount += PruneContentCacheDirectory(this->GetContentCacheDirectory(),
+    static_cast<double>(this->ContentCacheLimit) * MB, cachedFilePath);
+  return cachedFilePath;
+}
+
+//----------------------------------------------------------------------------
+bool vtkCacheManager::RemoveFileFromContentCache(const std::string& checksum)
+{
+  std::string cachedFilePath = this->GetContentCacheFilePath(checksum);
+  if (cachedFilePath.empty() || !vtksys::SystemTools::FileExists(cachedFilePath, true))
+    {
+    return false;
+    }
+  return static_cast<bool>(vtksys::SystemTools::RemoveFile(cachedFilePath));
+}
+
+//----------------------------------------------------------------------------
+int vtkCacheManager::PruneContentCache()
+{
+  int numberOfRemovedFiles = PruneContentCacheDirectory(this->GetContentCacheDirectory(),
+    static_cast<double>(this->ContentCacheLimit) * MB, std::string());
+  this->ContentCacheEvictionCount += numberOfRemovedFiles;
+  return numberOfRemovedFiles;
+}
+
+//----------------------------------------------------------------------------
+float vtkCacheManager::GetContentCacheSize()
+{
+  std::vector<ContentCacheEntry> entries;
+  GetContentCacheEntries(this->GetContentCacheDirectory(), entries);
+  double cacheSize = 0.0;
+  for (const ContentCacheEntry& entry : entries)
+    {
+    cacheSize += entry.Size;
+    }
+  return static_cast<float>(cacheSize / MB);
+}
+
+//----------------------------------------------------------------------------
+void vtkCacheManager::ResetContentCacheStatistics()
+{
+  this->ContentCacheHitCount = 0;
+  this->ContentCacheMissCount = 0;
+  this->ContentCacheEvictionCount = 0;
+}
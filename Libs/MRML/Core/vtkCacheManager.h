@@ -116,6 +116,62 @@ class VTK_MRML_EXPORT vtkCacheManager : public vtkObject
 
   std::vector< std::string > GetCachedFiles()const;
 
+  ///
+  /// Content-addressed cache.
+  /// Files are identified by their checksum, formatted as ``<algo>:<digest>``
+  /// (for example ``SHA256:cc211f0dfd9a05ca3841ce1141b292898b2dd2d3f08286affadf823a7e58df93``)
+  /// and stored as ContentCache/<algo>/<digest> in the remote cache directory.
+  /// The checksum is not computed here, the caller is responsible for verifying
+  /// the file content before adding it to the cache.
+  /// Files are added by atomic rename and least recently used files are removed
+  /// when the cache size exceeds ContentCacheLimit, so the same cache directory
+  /// can be used by several application instances at the same time.
+  std::string GetContentCacheDirectory();
+
+  ///
+  /// Returns the path where the file with the given checksum is stored in
+  /// the content cache (the file may not exist).
+  /// Returns an empty string if the checksum is invalid.
+  std::string GetContentCacheFilePath(const std::string& checksum);
+
+  ///
+  /// Returns the path of the cached file with the given checksum.
+  /// Returns an empty string if the file is not in the cache.
+  /// Updates the hit/miss counters and marks the file as recently used.
+  std::string FindFileInContentCache(const std::string& checksum);
+
+  ///
+  /// Copies a file into the content cache and removes least recently used files
+  /// if the cache size exceeds ContentCacheLimit.
+  /// If moveFile is true then the file is moved instead of copied.
+  /// Returns the path of the cached file or an empty string on failure.
+  std::string AddFileToContentCache(const std::string& filePath, const std::string& checksum, bool moveFile=false);
+
+  ///
+  /// Removes the file with the given checksum from the content cache.
+  bool RemoveFileFromContentCache(const std::string& checksum);
+
+  ///
+  /// Removes least recently used files until the content cache size
+  /// is below ContentCacheLimit. Returns the number of removed files.
+  int PruneContentCache();
+
+  ///
+  /// Total size of files in the content cache, in MB.
+  float GetContentCacheSize();
+
+  ///
+  /// Maximum size of the content cache, in MB. Default is 2000.
+  vtkGetMacro ( ContentCacheLimit, int );
+  vtkSetMacro ( ContentCacheLimit, int );
+
+  ///
+  /// Content cache usage statistics of this application instance.
+  vtkGetMacro ( ContentCacheHitCount, int );
+  vtkGetMacro ( ContentCacheMissCount, int );
+  vtkGetMacro ( ContentCacheEvictionCount, int );
+  void ResetContentCacheStatistics();
+
   ///
   vtkGetMacro ( RemoteCacheLimit, int );
   vtkSetMacro ( RemoteCacheLimit, int );
@@ -161,6 +217,10 @@ class VTK_MRML_EXPORT vtkCacheManager : public vtkObject
   int RemoteCacheFreeBufferSize;
   int EnableForceRedownload;
   //int EnableRemoteCacheOverwriting;
+  int ContentCacheLimit;
+  int ContentCacheHitCount;
+  int ContentCacheMissCount;
+  int ContentCacheEvictionCount;
   vtkMRMLScene *MRMLScene;
 
   std::string RemoteCacheDirectory;
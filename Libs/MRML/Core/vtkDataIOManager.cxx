@@ -3,6 +3,7 @@
 #include "vtkCacheManager.h"
 #include "vtkDataFileFormatHelper.h"
 #include "vtkDataTransfer.h"
+#include "vtkMRMLScene.h"
 #include "vtkMRMLStorageNode.h"
 #include "vtkMRMLStorableNode.h"
 
@@ -10,9 +11,185 @@
 #include <vtkCallbackCommand.h>
 #include <vtkCollection.h>
 #include <vtkObjectFactory.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
 
 // STD includes
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+// A node that keeps being modified while it is written is reported after this many rewrites
+const int MAXIMUM_NUMBER_OF_LOCAL_REWRITES = 3;
+}
 
+//----------------------------------------------------------------------------
+class vtkDataIOManager::vtkInternal
+{
+public:
+  struct LocalWrite
+    {
+    vtkSmartPointer<vtkMRMLStorableNode> StorableNode;
+    vtkSmartPointer<vtkMRMLStorageNode> StorageNode;
+    // true if the file is written from a snapshot in a background thread
+    bool Asynchronous{ false };
+    int Success{ 0 };
+    // number of times the file was written again because the node was
+    // modified while its snapshot was being written
+    int NumberOfRewrites{ 0 };
+    };
+
+  /// Write snapshots until the queue is empty. Runs in a background thread.
+  void WriteLoop();
+
+  /// Returns true if the snapshot of the storage node is being written or its write
+  /// is not finalized yet, so that the snapshot cannot be taken again. Mutex must be locked.
+  bool IsSnapshotInUse(vtkMRMLStorageNode* storageNode);
+
+  /// Remove a write of the storage node that has not been started yet and release
+  /// its snapshot. Returns true if a write was removed. Mutex must be locked.
+  bool RemovePendingWrite(vtkMRMLStorageNode* storageNode);
+
+  /// Call the completion callback. Mutex must be locked by the lock, it is
+  /// released while the callback runs.
+  void InvokeCompletedCallback(std::unique_lock<std::mutex>& lock);
+
+  /// Join the threads that have exited their write loop. Mutex must not be locked.
+  void JoinFinishedThreads();
+
+  // All members below are guarded by Mutex
+  std::mutex Mutex;
+  std::condition_variable Condition;
+  std::deque<LocalWrite> PendingWrites;
+  std::deque<LocalWrite> CompletedWrites;
+  // Writes requested while the snapshot of the storage node was in use,
+  // queued again when the previous write is finalized
+  std::vector<LocalWrite> DeferredWrites;
+  std::vector<std::thread> Threads;
+  // Threads that exited their write loop and can be joined
+  std::vector<std::thread::id> FinishedThreadIds;
+  int NumberOfActiveThreads{ 0 };
+  std::vector<vtkMRMLStorageNode*> RunningWrites;
+  unsigned long NumberOfFinishedWrites{ 0 };
+  vtkDataIOManager::LocalWriteCompletedCallbackType CompletedCallback{ nullptr };
+  void* CompletedCallbackClientData{ nullptr };
+  int NumberOfRunningCallbacks{ 0 };
+
+  // Progress of the current batch of writes, only accessed from the main thread
+  int NumberOfQueuedWritesInBatch{ 0 };
+  int NumberOfProcessedWritesInBatch{ 0 };
+  int NumberOfFailedWritesInBatch{ 0 };
+};
+
+//----------------------------------------------------------------------------
+void vtkDataIOManager::vtkInternal::WriteLoop()
+{
+  std::unique_lock<std::mutex> lock(this->Mutex);
+  while (!this->PendingWrites.empty())
+    {
+    LocalWrite write = std::move(this->PendingWrites.front());
+    this->PendingWrites.pop_front();
+    this->RunningWrites.push_back(write.StorageNode.GetPointer());
+    lock.unlock();
+
+    write.Success = write.StorageNode->WriteSnapshotData();
+
+    lock.lock();
+    this->RunningWrites.erase(std::find(this->RunningWrites.begin(), this->RunningWrites.end(), write.StorageNode.GetPointer()));
+    this->NumberOfFinishedWrites++;
+    this->CompletedWrites.push_back(std::move(write));
+    this->Condition.notify_all();
+    this->InvokeCompletedCallback(lock);
+    }
+  this->NumberOfActiveThreads--;
+  this->FinishedThreadIds.push_back(std::this_thread::get_id());
+}
+
+//----------------------------------------------------------------------------
+void vtkDataIOManager::vtkInternal::InvokeCompletedCallback(std::unique_lock<std::mutex>& lock)
+{
+  vtkDataIOManager::LocalWriteCompletedCallbackType callback = this->CompletedCallback;
+  void* clientData = this->CompletedCallbackClientData;
+  if (!callback)
+    {
+    return;
+    }
+  // The callback may take other locks, it must not be called with the mutex held.
+  // SetLocalWriteCompletedCallback waits for running callbacks, so the client data
+  // remains valid until the callback returns.
+  this->NumberOfRunningCallbacks++;
+  lock.unlock();
+  callback(clientData);
+  lock.lock();
+  this->NumberOfRunningCallbacks--;
+  this->Condition.notify_all();
+}
+
+//----------------------------------------------------------------------------
+void vtkDataIOManager::vtkInternal::JoinFinishedThreads()
+{
+  std::vector<std::thread> finishedThreads;
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    for (const std::thread::id& threadId : this->FinishedThreadIds)
+      {
+      std::vector<std::thread>::iterator it = std::find_if(this->Threads.begin(), this->Threads.end(),
+        [&threadId](const std::thread& thread) { return thread.get_id() == threadId; });
+      if (it != this->Threads.end())
+        {
+        finishedThreads.push_back(std::move(*it));
+        this->Threads.erase(it);
+        }
+      }
+    this->FinishedThreadIds.clear();
+  }
+  // the threads have left the write loop, joining returns immediately
+  for (std::thread& thread : finishedThreads)
+    {
+    thread.join();
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkDataIOManager::vtkInternal::IsSnapshotInUse(vtkMRMLStorageNode* storageNode)
+{
+  if (std::find(this->RunningWrites.begin(), this->RunningWrites.end(), storageNode) != this->RunningWrites.end())
+    {
+    return true;
+    }
+  for (const LocalWrite& write : this->CompletedWrites)
+    {
+    if (write.Asynchronous && write.StorageNode == storageNode)
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+bool vtkDataIOManager::vtkInternal::RemovePendingWrite(vtkMRMLStorageNode* storageNode)
+{
+  for (std::deque<LocalWrite>::iterator it = this->PendingWrites.begin(); it != this->PendingWrites.end(); ++it)
+    {
+    if (it->StorageNode == storageNode)
+      {
+      this->PendingWrites.erase(it);
+      storageNode->ClearSnapshotData();
+      return true;
+      }
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
 vtkStandardNewMacro ( vtkDataIOManager );
 vtkCxxSetObjectMacro(vtkDataIOManager, CacheManager, vtkCacheManager);
 vtkCxxSetObjectMacro(vtkDataIOManager, DataTransferCollection, vtkCollection);
@@ -25,6 +202,10 @@ vtkDataIOManager::vtkDataIOManager()
   this->DataTransferCollection = vtkCollection::New();
   this->CacheManager = nullptr;
   this->EnableAsynchronousIO = 0;
+  this->EnableParallelLocalRead = 1;
+  this->EnableAsynchronousLocalWrite = 1;
+  this->MaximumNumberOfLocalWriteThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  this->Internal = new vtkInternal;
 
   //--- set up callback
   this->TransferUpdateCommand = vtkCallbackCommand::New();
@@ -38,6 +219,17 @@ vtkDataIOManager::vtkDataIOManager()
 //----------------------------------------------------------------------------
 vtkDataIOManager::~vtkDataIOManager()
 {
+  this->SetLocalWriteCompletedCallback ( nullptr, nullptr );
+  //--- queued files must not be lost, wait for the writes to complete
+  while ( this->WaitForNextLocalWrite() )
+    {
+    }
+  for ( std::thread& thread : this->Internal->Threads )
+    {
+    thread.join();
+    }
+  delete this->Internal;
+  this->Internal = nullptr;
 
   if ( this->TransferUpdateCommand )
     {
@@ -100,6 +292,9 @@ void vtkDataIOManager::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "DataTransferCollection: " << this->GetDataTransferCollection() << "\n";
   os << indent << "CacheManager: " << this->GetCacheManager() << "\n";
   os << indent << "EnableAsynchronousIO: " << this->GetEnableAsynchronousIO() << "\n";
+  os << indent << "EnableParallelLocalRead: " << this->GetEnableParallelLocalRead() << "\n";
+  os << indent << "EnableAsynchronousLocalWrite: " << this->GetEnableAsynchronousLocalWrite() << "\n";
+  os << indent << "MaximumNumberOfLocalWriteThreads: " << this->GetMaximumNumberOfLocalWriteThreads() << "\n";
 
 }
 
@@ -496,6 +691,345 @@ void vtkDataIOManager::QueueWrite ( vtkMRMLNode *node )
 }
 
 
+//----------------------------------------------------------------------------
+int vtkDataIOManager::QueueLocalWrite ( vtkMRMLStorableNode *node, vtkMRMLStorageNode *storageNode/*=nullptr*/ )
+{
+  return this->QueueLocalWriteInternal ( node, storageNode, 0 );
+}
+
+//----------------------------------------------------------------------------
+int vtkDataIOManager::QueueLocalWriteInternal ( vtkMRMLStorableNode *node, vtkMRMLStorageNode *storageNode, int numberOfRewrites )
+{
+  if ( node == nullptr )
+    {
+    vtkErrorMacro("QueueLocalWrite: null input node!");
+    return 0;
+    }
+  std::vector<vtkMRMLStorageNode*> storageNodes;
+  if ( storageNode != nullptr )
+    {
+    storageNodes.push_back ( storageNode );
+    }
+  else
+    {
+    for ( int i = 0; i < node->GetNumberOfStorageNodes(); i++ )
+      {
+      vtkMRMLStorageNode *nthStorageNode = node->GetNthStorageNode(i);
+      if ( nthStorageNode != nullptr && nthStorageNode->GetURI() == nullptr )
+        {
+        storageNodes.push_back ( nthStorageNode );
+        }
+      }
+    }
+  if ( storageNodes.empty() )
+    {
+    vtkErrorMacro("QueueLocalWrite: no local storage node found for node " << (node->GetID() ? node->GetID() : "(none)"));
+    return 0;
+    }
+
+  for ( vtkMRMLStorageNode *writtenStorageNode : storageNodes )
+    {
+    vtkInternal::LocalWrite write;
+    write.StorableNode = node;
+    write.StorageNode = writtenStorageNode;
+    write.NumberOfRewrites = numberOfRewrites;
+    {
+      std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+      if ( this->Internal->IsSnapshotInUse ( writtenStorageNode ) )
+        {
+        //--- a storage node holds only one snapshot, write the current data
+        //--- after the previous write of the same storage node is finalized
+        bool alreadyDeferred = false;
+        for ( const vtkInternal::LocalWrite& deferredWrite : this->Internal->DeferredWrites )
+          {
+          alreadyDeferred = alreadyDeferred || ( deferredWrite.StorageNode == writtenStorageNode );
+          }
+        if ( !alreadyDeferred )
+          {
+          this->Internal->DeferredWrites.push_back ( std::move(write) );
+          this->Internal->NumberOfQueuedWritesInBatch++;
+          }
+        continue;
+        }
+      //--- a write that has not started yet is replaced by a write of the current data
+      if ( !this->Internal->RemovePendingWrite ( writtenStorageNode ) )
+        {
+        this->Internal->NumberOfQueuedWritesInBatch++;
+        }
+    }
+    if ( this->EnableAsynchronousLocalWrite && writtenStorageNode->CanWriteDataAsynchronously ( node ) )
+      {
+      //--- the data is captured here, on the main thread, the file is written later
+      write.Asynchronous = writtenStorageNode->SnapshotData ( node );
+      }
+    else
+      {
+      write.Success = writtenStorageNode->WriteData ( node );
+      }
+
+    std::unique_lock<std::mutex> lock(this->Internal->Mutex);
+    if ( !write.Asynchronous )
+      {
+      //--- already written (or failed), only needs to be reported
+      this->Internal->NumberOfFinishedWrites++;
+      this->Internal->CompletedWrites.push_back ( std::move(write) );
+      this->Internal->Condition.notify_all();
+      this->Internal->InvokeCompletedCallback ( lock );
+      }
+    else
+      {
+      this->Internal->PendingWrites.push_back ( std::move(write) );
+      if ( this->Internal->NumberOfActiveThreads < this->MaximumNumberOfLocalWriteThreads
+           && this->Internal->NumberOfActiveThreads < static_cast<int>(this->Internal->PendingWrites.size()) )
+        {
+        this->Internal->NumberOfActiveThreads++;
+        this->Internal->Threads.emplace_back ( &vtkInternal::WriteLoop, this->Internal );
+        }
+      }
+    }
+  vtkDebugMacro("QueueLocalWrite: queued " << storageNodes.size() << " local writes, invoking a local write event on the data io manager");
+  this->InvokeEvent ( vtkDataIOManager::LocalWriteEvent, node );
+  return static_cast<int>(storageNodes.size());
+}
+
+//----------------------------------------------------------------------------
+void vtkDataIOManager::SetLocalWriteCompletedCallback ( LocalWriteCompletedCallbackType callback, void *clientData )
+{
+  std::unique_lock<std::mutex> lock(this->Internal->Mutex);
+  //--- the previous client data must stay valid until its callbacks return
+  this->Internal->Condition.wait ( lock, [this] { return this->Internal->NumberOfRunningCallbacks == 0; } );
+  this->Internal->CompletedCallback = callback;
+  this->Internal->CompletedCallbackClientData = clientData;
+}
+
+//----------------------------------------------------------------------------
+int vtkDataIOManager::ProcessCompletedLocalWrites ( )
+{
+  this->Internal->JoinFinishedThreads();
+  std::deque<vtkInternal::LocalWrite> completedWrites;
+  {
+    std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+    completedWrites.swap ( this->Internal->CompletedWrites );
+  }
+  if ( completedWrites.empty() )
+    {
+    return 0;
+    }
+
+  int numberOfReportedWrites = 0;
+  std::vector<vtkInternal::LocalWrite> rewrites;
+  for ( vtkInternal::LocalWrite& write : completedWrites )
+    {
+    if ( write.Asynchronous )
+      {
+      write.Success = write.StorageNode->CompleteWriteSnapshotData ( write.StorableNode, write.Success );
+      //--- the snapshot shares the bulk data with the node, if the node was changed
+      //--- after the snapshot was taken then the file may not match the node
+      if ( write.Success && write.StorableNode->GetModifiedSinceRead()
+        && write.NumberOfRewrites < MAXIMUM_NUMBER_OF_LOCAL_REWRITES )
+        {
+        write.NumberOfRewrites++;
+        rewrites.push_back ( std::move(write) );
+        continue;
+        }
+      }
+    if ( !write.Success )
+      {
+      this->Internal->NumberOfFailedWritesInBatch++;
+      }
+    this->Internal->NumberOfProcessedWritesInBatch++;
+    vtkDebugMacro("ProcessCompletedLocalWrites: " << (write.StorageNode->GetFileName() ? write.StorageNode->GetFileName() : "(none)")
+      << " written in " << write.StorageNode->GetLastWriteDataTime() << " s");
+    this->InvokeEvent ( vtkDataIOManager::LocalWriteCompletedEvent, write.StorageNode.GetPointer() );
+    numberOfReportedWrites++;
+    }
+
+  //--- write the current data of the nodes that were modified while being written
+  for ( vtkInternal::LocalWrite& write : rewrites )
+    {
+    vtkDebugMacro("ProcessCompletedLocalWrites: " << (write.StorableNode->GetID() ? write.StorableNode->GetID() : "(none)")
+      << " was modified while it was written, writing it again");
+    //--- already counted in the batch when it was first queued
+    this->Internal->NumberOfQueuedWritesInBatch--;
+    this->QueueLocalWriteInternal ( write.StorableNode, write.StorageNode, write.NumberOfRewrites );
+    }
+
+  //--- storage nodes that were queued again while being written can take a new snapshot now
+  std::vector<vtkInternal::LocalWrite> deferredWrites;
+  {
+    std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+    std::vector<vtkInternal::LocalWrite>::iterator it = this->Internal->DeferredWrites.begin();
+    while ( it != this->Internal->DeferredWrites.end() )
+      {
+      if ( this->Internal->IsSnapshotInUse ( it->StorageNode ) )
+        {
+        ++it;
+        continue;
+        }
+      deferredWrites.push_back ( std::move(*it) );
+      it = this->Internal->DeferredWrites.erase ( it );
+      //--- already counted in the batch when it was deferred
+      this->Internal->NumberOfQueuedWritesInBatch--;
+      }
+  }
+  for ( vtkInternal::LocalWrite& write : deferredWrites )
+    {
+    this->QueueLocalWriteInternal ( write.StorableNode, write.StorageNode, write.NumberOfRewrites );
+    }
+
+  bool finished = false;
+  {
+    std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+    finished = ( this->Internal->PendingWrites.empty()
+      && this->Internal->RunningWrites.empty()
+      && this->Internal->CompletedWrites.empty()
+      && this->Internal->DeferredWrites.empty() );
+  }
+  if ( finished )
+    {
+    int numberOfFailedWrites = this->Internal->NumberOfFailedWritesInBatch;
+    this->Internal->NumberOfQueuedWritesInBatch = 0;
+    this->Internal->NumberOfProcessedWritesInBatch = 0;
+    this->Internal->NumberOfFailedWritesInBatch = 0;
+    this->InvokeEvent ( vtkDataIOManager::LocalWritesFinishedEvent, &numberOfFailedWrites );
+    }
+  return numberOfReportedWrites;
+}
+
+//----------------------------------------------------------------------------
+int vtkDataIOManager::FinishLocalWrites ( )
+{
+  int numberOfProcessedWrites = 0;
+  do
+    {
+    while ( this->WaitForNextLocalWrite() )
+      {
+      }
+    //--- may queue deferred writes again
+    numberOfProcessedWrites += this->ProcessCompletedLocalWrites();
+    }
+  while ( this->GetNumberOfLocalWritesInProgress() > 0 );
+  return numberOfProcessedWrites;
+}
+
+//----------------------------------------------------------------------------
+bool vtkDataIOManager::WaitForNextLocalWrite ( )
+{
+  std::unique_lock<std::mutex> lock(this->Internal->Mutex);
+  if ( this->Internal->PendingWrites.empty() && this->Internal->RunningWrites.empty() )
+    {
+    return false;
+    }
+  unsigned long numberOfFinishedWrites = this->Internal->NumberOfFinishedWrites;
+  this->Internal->Condition.wait ( lock, [this, numberOfFinishedWrites]
+    { return this->Internal->NumberOfFinishedWrites != numberOfFinishedWrites; } );
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int vtkDataIOManager::GetNumberOfLocalWritesInProgress ( )
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return static_cast<int>(this->Internal->PendingWrites.size() + this->Internal->RunningWrites.size()
+    + this->Internal->DeferredWrites.size());
+}
+
+//----------------------------------------------------------------------------
+double vtkDataIOManager::GetLocalWriteProgress ( )
+{
+  if ( this->Internal->NumberOfQueuedWritesInBatch == 0 )
+    {
+    return 1.0;
+    }
+  return static_cast<double>(this->Internal->NumberOfProcessedWritesInBatch)
+    / this->Internal->NumberOfQueuedWritesInBatch;
+}
+
+//----------------------------------------------------------------------------
+int vtkDataIOManager::PrefetchData ( vtkCollection *nodes )
+{
+  if ( nodes == nullptr || !this->EnableParallelLocalRead )
+    {
+    return 0;
+    }
+
+  //--- collect the reads on the main thread, storage nodes are only
+  //--- allowed to read their file into memory in the worker threads.
+  std::vector< std::pair<vtkMRMLStorageNode*, vtkMRMLStorableNode*> > reads;
+  vtkCollectionSimpleIterator it;
+  vtkObject *object;
+  for ( nodes->InitTraversal(it); (object = nodes->GetNextItemAsObject(it)); )
+    {
+    vtkMRMLStorableNode *storableNode = vtkMRMLStorableNode::SafeDownCast ( object );
+    if ( storableNode == nullptr || !storableNode->GetAddToScene() )
+      {
+      continue;
+      }
+    vtkMRMLScene *scene = storableNode->GetScene();
+    if ( scene != nullptr && scene->GetReadDataOnLoad() == 0 )
+      {
+      continue;
+      }
+    for ( int i = 0; i < storableNode->GetNumberOfStorageNodes(); i++ )
+      {
+      vtkMRMLStorageNode *storageNode = storableNode->GetNthStorageNode(i);
+      if ( storageNode != nullptr
+           && storageNode->GetURI() == nullptr
+           && storageNode->CanPrefetchData ( storableNode ) )
+        {
+        reads.emplace_back ( storageNode, storableNode );
+        }
+      }
+    }
+  if ( reads.empty() )
+    {
+    return 0;
+    }
+
+  vtkDebugMacro("PrefetchData: reading " << reads.size() << " files in parallel");
+  std::atomic<int> numberOfPrefetchedNodes(0);
+  // grain size of 1: each file read is a separate task
+  vtkSMPTools::For ( 0, static_cast<vtkIdType>(reads.size()), 1,
+    [&reads, &numberOfPrefetchedNodes](vtkIdType begin, vtkIdType end)
+    {
+    for ( vtkIdType i = begin; i < end; ++i )
+      {
+      if ( reads[i].first->PrefetchData ( reads[i].second ) )
+        {
+        numberOfPrefetchedNodes++;
+        }
+      }
+    });
+  return numberOfPrefetchedNodes;
+}
+
+//----------------------------------------------------------------------------
+void vtkDataIOManager::ClearPrefetchedData ( vtkCollection *nodes )
+{
+  if ( nodes == nullptr )
+    {
+    return;
+    }
+  vtkCollectionSimpleIterator it;
+  vtkObject *object;
+  for ( nodes->InitTraversal(it); (object = nodes->GetNextItemAsObject(it)); )
+    {
+    vtkMRMLStorableNode *storableNode = vtkMRMLStorableNode::SafeDownCast ( object );
+    if ( storableNode == nullptr )
+      {
+      continue;
+      }
+    for ( int i = 0; i < storableNode->GetNumberOfStorageNodes(); i++ )
+      {
+      vtkMRMLStorageNode *storageNode = storableNode->GetNthStorageNode(i);
+      if ( storageNode != nullptr )
+        {
+        storageNode->ClearPrefetchedData();
+        }
+      }
+    }
+}
+
 //----------------------------------------------------------------------------
 int vtkDataIOManager::GetUniqueTransferID ( )
 {
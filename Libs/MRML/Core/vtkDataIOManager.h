@@ -7,6 +7,8 @@ class vtkCacheManager;
 class vtkDataFileFormatHelper;
 class vtkDataTransfer;
 class vtkMRMLNode;
+class vtkMRMLStorableNode;
+class vtkMRMLStorageNode;
 
 // VTK includes
 #include <vtkObject.h>
@@ -40,6 +42,29 @@ class VTK_MRML_EXPORT vtkDataIOManager : public vtkObject
 
   void SetEnableAsynchronousIO ( int );
 
+  ///
+  /// Enable reading of local files of independent storable nodes in parallel
+  /// on a worker thread pool when a scene is imported. Enabled by default.
+  /// \sa PrefetchData(), vtkMRMLStorageNode::PrefetchData()
+  vtkSetMacro ( EnableParallelLocalRead, int );
+  vtkGetMacro ( EnableParallelLocalRead, int );
+  vtkBooleanMacro ( EnableParallelLocalRead, int );
+
+  ///
+  /// Write local files of storable nodes in background threads when they are
+  /// queued by QueueLocalWrite(). Enabled by default. If disabled then QueueLocalWrite()
+  /// writes local files immediately, on the calling thread.
+  /// \sa QueueLocalWrite(), vtkMRMLStorageNode::SnapshotData()
+  vtkSetMacro ( EnableAsynchronousLocalWrite, int );
+  vtkGetMacro ( EnableAsynchronousLocalWrite, int );
+  vtkBooleanMacro ( EnableAsynchronousLocalWrite, int );
+
+  ///
+  /// Maximum number of background threads that write local files concurrently.
+  /// Default is the number of logical processors.
+  vtkSetClampMacro ( MaximumNumberOfLocalWriteThreads, int, 1, VTK_INT_MAX );
+  vtkGetMacro ( MaximumNumberOfLocalWriteThreads, int );
+
   ///
   /// Creates and adds a new data transfer object to the collection
   vtkDataTransfer *AddNewDataTransfer ( );
@@ -76,6 +101,82 @@ class VTK_MRML_EXPORT vtkDataIOManager : public vtkObject
   /// so that logic can take care of scheduling and applying it
   void QueueWrite ( vtkMRMLNode *node );
 
+  ///
+  /// Write the local file of a storage node of the node. If storageNode is nullptr then
+  /// the files of all storage nodes of the node that do not refer to a remote URI are written.
+  /// The data is captured on the calling (main) thread by vtkMRMLStorageNode::SnapshotData()
+  /// and files are written in background threads, concurrently. Storage nodes that
+  /// cannot write asynchronously are written immediately.
+  /// The snapshot shares the bulk data with the node, so the node must be modified by
+  /// replacing its data (for example by SetAndObserveMesh or DeepCopy into its data object),
+  /// not by editing arrays in place, while it is written. If the node is modified before
+  /// the write is finalized then it is written again, with the current data.
+  /// The calling thread never waits for a background write: if a write of the same
+  /// storage node is queued but not started yet then its snapshot is replaced by the
+  /// current data, if it is being written then the storage node is queued again when
+  /// that write is completed.
+  /// A LocalWriteEvent is invoked with the node as call data.
+  /// Completed local writes are reported by ProcessCompletedLocalWrites().
+  /// Returns the number of queued writes.
+  int QueueLocalWrite ( vtkMRMLStorableNode *node, vtkMRMLStorageNode *storageNode = nullptr );
+
+  ///
+  /// Function that is called each time a local write is completed, from the thread
+  /// that completed the write, so that the application can request calling
+  /// ProcessCompletedLocalWrites() on the main thread (for example by
+  /// vtkSlicerApplicationLogic::RequestModified()). It must be thread-safe and
+  /// must not call any method of this class.
+  typedef void (*LocalWriteCompletedCallbackType)(void *clientData);
+  void SetLocalWriteCompletedCallback ( LocalWriteCompletedCallbackType callback, void *clientData );
+
+  ///
+  /// Finalize local writes that have been completed since the last call, on the
+  /// main thread. LocalWriteCompletedEvent is invoked for each written file, with
+  /// the storage node as call data (see vtkMRMLStorageNode::GetLastWriteDataTime()
+  /// and vtkMRMLStorageNode::GetUserMessages()). When all queued writes are completed,
+  /// LocalWritesFinishedEvent is invoked with the number of failed writes (int*) as call data.
+  /// Writes of nodes that were modified while being written are queued again and
+  /// are not reported until the file is written with the current data.
+  /// Returns the number of writes that have been finalized.
+  int ProcessCompletedLocalWrites ( );
+
+  ///
+  /// Block until all queued local writes are completed, then finalize them
+  /// by calling ProcessCompletedLocalWrites(). Writes that are queued again while
+  /// they are being written are waited for as well. Must be called from the main thread.
+  /// Returns the number of writes that have been finalized.
+  int FinishLocalWrites ( );
+
+  ///
+  /// Block until a local write that is in progress completes.
+  /// Returns immediately with false if no local writes are in progress.
+  /// This method is thread-safe.
+  bool WaitForNextLocalWrite ( );
+
+  ///
+  /// Number of local writes that are queued, being written, or waiting to be
+  /// queued again. Thread-safe.
+  int GetNumberOfLocalWritesInProgress ( );
+
+  ///
+  /// Fraction of local writes finalized by ProcessCompletedLocalWrites() since
+  /// the last time all local writes were finished (0.0 - 1.0).
+  double GetLocalWriteProgress ( );
+
+  ///
+  /// Read the local files of all storable nodes in the collection concurrently,
+  /// using the VTK SMP thread pool. Data is kept in the storage nodes and set
+  /// in the storable nodes by the next ReadData call, on the main thread.
+  /// Storage nodes that do not support prefetching (see vtkMRMLStorageNode::CanPrefetchData)
+  /// or refer to remote URIs are skipped.
+  /// Returns the number of storage nodes that successfully prefetched their data.
+  int PrefetchData ( vtkCollection *nodes );
+
+  ///
+  /// Release prefetched data of all storable nodes in the collection that
+  /// was not used by a ReadData call.
+  void ClearPrefetchedData ( vtkCollection *nodes );
+
   ///
   /// Set the status of a data transfer (Idle, Scheduled, Cancelled Running,
   /// Completed).  The "modify" parameter indicates whether the object
@@ -97,7 +198,9 @@ class VTK_MRML_EXPORT vtkDataIOManager : public vtkObject
       TransferUpdateEvent,
       SettingsUpdateEvent,
       DisplayManagerWindowEvent,
-      RefreshDisplayEvent
+      RefreshDisplayEvent,
+      LocalWriteCompletedEvent,
+      LocalWritesFinishedEvent
     };
 
   /// function that gets called when a data transfer has been updated.
@@ -112,12 +215,22 @@ class VTK_MRML_EXPORT vtkDataIOManager : public vtkObject
   vtkCollection *DataTransferCollection;
   vtkCacheManager *CacheManager;
   int EnableAsynchronousIO;
+  int EnableParallelLocalRead;
+  int EnableAsynchronousLocalWrite;
+  int MaximumNumberOfLocalWriteThreads;
+
+  class vtkInternal;
+  vtkInternal* Internal;
 
   vtkDataFileFormatHelper* FileFormatHelper;
 
  protected:
   vtkDataIOManager();
   ~vtkDataIOManager() override;
+
+  /// Queue local writes, numberOfRewrites is the number of times the files were
+  /// already written again because the node was modified while being written.
+  int QueueLocalWriteInternal ( vtkMRMLStorableNode *node, vtkMRMLStorageNode *storageNode, int numberOfRewrites );
   vtkDataIOManager(const vtkDataIOManager&);
   void operator=(const vtkDataIOManager&);
 
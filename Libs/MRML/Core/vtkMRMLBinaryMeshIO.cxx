@@ -0,0 +1,732 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLBinaryMeshIO.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkDataArray.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTypeInt64Array.h>
+
+// VTKSYS includes
+#include <vtksys/FStream.hxx>
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#ifdef _WIN32
+# include <vtksys/Encoding.hxx>
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkMRMLBinaryMeshIO);
+
+namespace
+{
+
+const char BinaryMeshSignature[8] = { 'S', 'L', 'C', 'R', 'M', 'E', 'S', 'H' };
+const vtkTypeUInt32 BinaryMeshVersion = 1;
+const vtkTypeUInt32 BinaryMeshByteOrderMark = 0x01020304;
+const vtkTypeUInt64 BinaryMeshBlockAlignment = 64;
+
+enum BlockKind
+{
+  PointsBlock = 0,
+  VertsOffsetsBlock,
+  VertsConnectivityBlock,
+  LinesOffsetsBlock,
+  LinesConnectivityBlock,
+  PolysOffsetsBlock,
+  PolysConnectivityBlock,
+  StripsOffsetsBlock,
+  StripsConnectivityBlock,
+  PointDataBlock,
+  CellDataBlock,
+  BlockKind_Last
+};
+
+struct FileHeader
+{
+  char Signature[8];
+  vtkTypeUInt32 Version;
+  vtkTypeUInt32 ByteOrderMark;
+  vtkTypeUInt32 CoordinateSystem;
+  vtkTypeUInt32 NumberOfBlocks;
+  vtkTypeUInt64 BlockTableOffset;
+  char Reserved[32];
+};
+static_assert(sizeof(FileHeader) == 64, "Unexpected binary mesh file header size");
+
+struct BlockHeader
+{
+  vtkTypeUInt32 Kind;
+  vtkTypeInt32 DataType;
+  vtkTypeInt32 NumberOfComponents;
+  vtkTypeInt32 AttributeType;
+  vtkTypeInt64 NumberOfTuples;
+  vtkTypeUInt64 Offset;
+  vtkTypeUInt64 Size;
+  char Name[80];
+  char Reserved[8];
+};
+static_assert(sizeof(BlockHeader) == 128, "Unexpected binary mesh block header size");
+
+//----------------------------------------------------------------------------
+bool IsSupportedDataType(int dataType)
+{
+  switch (dataType)
+    {
+    case VTK_CHAR:
+    case VTK_SIGNED_CHAR:
+    case VTK_UNSIGNED_CHAR:
+    case VTK_SHORT:
+    case VTK_UNSIGNED_SHORT:
+    case VTK_INT:
+    case VTK_UNSIGNED_INT:
+    case VTK_LONG:
+    case VTK_UNSIGNED_LONG:
+    case VTK_LONG_LONG:
+    case VTK_UNSIGNED_LONG_LONG:
+    case VTK_ID_TYPE:
+    case VTK_FLOAT:
+    case VTK_DOUBLE:
+      return true;
+    default:
+      return false;
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkTypeUInt64 AlignOffset(vtkTypeUInt64 offset)
+{
+  return ((offset + BinaryMeshBlockAlignment - 1) / BinaryMeshBlockAlignment) * BinaryMeshBlockAlignment;
+}
+
+//----------------------------------------------------------------------------
+/// Read-only, copy-on-write mapping of a complete file.
+class MappedFile
+{
+public:
+  MappedFile() = default;
+  ~MappedFile()
+  {
+    this->Close();
+  }
+
+  bool Open(const std::string& fileName)
+  {
+    this->Close();
+#ifdef _WIN32
+    std::wstring wideFileName = vtksys::Encoding::ToWindowsExtendedPath(fileName);
+    HANDLE file = CreateFileW(wideFileName.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+      nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+      {
+      return false;
+      }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+      {
+      CloseHandle(file);
+      return false;
+      }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr)
+      {
+      return false;
+      }
+    void* data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    // the view keeps a reference to the mapping object
+    CloseHandle(mapping);
+    if (data == nullptr)
+      {
+      return false;
+      }
+    this->Data = static_cast<char*>(data);
+    this->Size = static_cast<vtkTypeUInt64>(fileSize.QuadPart);
+#else
+    int fileDescriptor = open(fileName.c_str(), O_RDONLY);
+    if (fileDescriptor < 0)
+      {
+      return false;
+      }
+    struct stat fileStatus;
+    if (fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size <= 0)
+      {
+      close(fileDescriptor);
+      return false;
+      }
+    // Private mapping: pages that are written to are copied, the file is never modified
+    void* data = mmap(nullptr, static_cast<size_t>(fileStatus.st_size), PROT_READ | PROT_WRITE,
+      MAP_PRIVATE, fileDescriptor, 0);
+    // the mapping keeps a reference to the file
+    close(fileDescriptor);
+    if (data == MAP_FAILED)
+      {
+      return false;
+      }
+    this->Data = static_cast<char*>(data);
+    this->Size = static_cast<vtkTypeUInt64>(fileStatus.st_size);
+#endif
+    return true;
+  }
+
+  void Close()
+  {
+    if (!this->Data)
+      {
+      return;
+      }
+#ifdef _WIN32
+    UnmapViewOfFile(this->Data);
+#else
+    munmap(this->Data, static_cast<size_t>(this->Size));
+#endif
+    this->Data = nullptr;
+    this->Size = 0;
+  }
+
+  char* GetData() const { return this->Data; }
+  vtkTypeUInt64 GetSize() const { return this->Size; }
+
+private:
+  MappedFile(const MappedFile&) = delete;
+  void operator=(const MappedFile&) = delete;
+
+  char* Data{nullptr};
+  vtkTypeUInt64 Size{0};
+};
+
+//----------------------------------------------------------------------------
+/// Keeps file mappings alive while data arrays refer to them.
+/// It is intentionally never deleted, as arrays may be released during static destruction.
+struct MappedArrayRegistry
+{
+  /// Arrays that use the same block share an entry, the mapping is kept until all of them are released
+  struct MappedBlock
+    {
+    std::shared_ptr<MappedFile> File;
+    int NumberOfArrays{ 0 };
+    };
+  std::mutex Mutex;
+  std::map<void*, MappedBlock> MappedBlocks;
+};
+
+MappedArrayRegistry& GetMappedArrayRegistry()
+{
+  static MappedArrayRegistry* registry = new MappedArrayRegistry;
+  return *registry;
+}
+
+//----------------------------------------------------------------------------
+/// Free function of mapped data arrays
+void ReleaseMappedArray(void* pointer)
+{
+  // unmap the file (if this was the last array that referred to it) outside of the lock
+  std::shared_ptr<MappedFile> mappedFile;
+  MappedArrayRegistry& registry = GetMappedArrayRegistry();
+  std::lock_guard<std::mutex> lock(registry.Mutex);
+  std::map<void*, MappedArrayRegistry::MappedBlock>::iterator it = registry.MappedBlocks.find(pointer);
+  if (it != registry.MappedBlocks.end() && --it->second.NumberOfArrays <= 0)
+    {
+    mappedFile = it->second.File;
+    registry.MappedBlocks.erase(it);
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Provides access to the file content either through a memory mapping or by reading
+/// the file into newly allocated arrays.
+class BinaryMeshSource
+{
+public:
+  bool Open(const std::string& fileName, bool memoryMap)
+  {
+    if (memoryMap)
+      {
+      this->Mapping = std::make_shared<MappedFile>();
+      if (this->Mapping->Open(fileName))
+        {
+        this->FileSize = this->Mapping->GetSize();
+        return true;
+        }
+      // fall back to reading the file
+      this->Mapping.reset();
+      }
+    this->Stream.open(fileName.c_str(), std::ios::in | std::ios::binary);
+    if (!this->Stream.is_open())
+      {
+      return false;
+      }
+    this->Stream.seekg(0, std::ios::end);
+    this->FileSize = static_cast<vtkTypeUInt64>(this->Stream.tellg());
+    return true;
+  }
+
+  vtkTypeUInt64 GetFileSize() const { return this->FileSize; }
+
+  bool Read(vtkTypeUInt64 offset, vtkTypeUInt64 size, void* buffer)
+  {
+    if (offset > this->FileSize || size > this->FileSize - offset)
+      {
+      return false;
+      }
+    if (this->Mapping)
+      {
+      memcpy(buffer, this->Mapping->GetData() + offset, static_cast<size_t>(size));
+      return true;
+      }
+    this->Stream.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+    this->Stream.read(static_cast<char*>(buffer), static_cast<std::streamsize>(size));
+    return !this->Stream.fail();
+  }
+
+  /// Make the array use the block content. Memory-mapped blocks are not copied.
+  bool LoadArray(const BlockHeader& block, vtkDataArray* array)
+  {
+    array->SetNumberOfComponents(block.NumberOfComponents);
+    vtkIdType numberOfValues = static_cast<vtkIdType>(block.NumberOfTuples) * block.NumberOfComponents;
+    if (numberOfValues == 0)
+      {
+      return true;
+      }
+    if (this->Mapping)
+      {
+      void* pointer = this->Mapping->GetData() + block.Offset;
+      MappedArrayRegistry& registry = GetMappedArrayRegistry();
+        {
+        std::lock_guard<std::mutex> lock(registry.Mutex);
+        MappedArrayRegistry::MappedBlock& mappedBlock = registry.MappedBlocks[pointer];
+        mappedBlock.File = this->Mapping;
+        mappedBlock.NumberOfArrays++;
+        }
+      array->SetVoidArray(pointer, numberOfValues, 0, vtkAbstractArray::VTK_DATA_ARRAY_USER_DEFINED);
+      array->SetArrayFreeFunction(ReleaseMappedArray);
+      return true;
+      }
+    array->SetNumberOfTuples(static_cast<vtkIdType>(block.NumberOfTuples));
+    return this->Read(block.Offset, block.Size, array->GetVoidPointer(0));
+  }
+
+private:
+  std::shared_ptr<MappedFile> Mapping;
+  vtksys::ifstream Stream;
+  vtkTypeUInt64 FileSize{0};
+};
+
+//----------------------------------------------------------------------------
+struct BlockToWrite
+{
+  BlockHeader Header;
+  vtkSmartPointer<vtkDataArray> Array;
+};
+
+//----------------------------------------------------------------------------
+void AddBlockToWrite(std::vector<BlockToWrite>& blocks, vtkTypeUInt32 kind, vtkDataArray* array,
+  int attributeType = -1)
+{
+  BlockToWrite block;
+  memset(&block.Header, 0, sizeof(BlockHeader));
+  block.Header.Kind = kind;
+  block.Header.DataType = array->GetDataType();
+  block.Header.NumberOfComponents = array->GetNumberOfComponents();
+  block.Header.AttributeType = attributeType;
+  block.Header.NumberOfTuples = array->GetNumberOfTuples();
+  block.Header.Size = static_cast<vtkTypeUInt64>(array->GetNumberOfTuples())
+    * array->GetNumberOfComponents() * array->GetDataTypeSize();
+  if (array->GetName())
+    {
+    strncpy(block.Header.Name, array->GetName(), sizeof(block.Header.Name) - 1);
+    }
+  block.Array = array;
+  blocks.push_back(block);
+}
+
+//----------------------------------------------------------------------------
+void AddCellBlocksToWrite(std::vector<BlockToWrite>& blocks, vtkCellArray* cells,
+  vtkTypeUInt32 offsetsKind, vtkTypeUInt32 connectivityKind)
+{
+  if (!cells || cells->GetNumberOfCells() == 0)
+    {
+    return;
+    }
+  vtkSmartPointer<vtkDataArray> offsets;
+  vtkSmartPointer<vtkDataArray> connectivity;
+  if (cells->IsStorage64Bit())
+    {
+    offsets = cells->GetOffsetsArray64();
+    connectivity = cells->GetConnectivityArray64();
+    }
+  else
+    {
+    offsets = vtkSmartPointer<vtkTypeInt64Array>::New();
+    offsets->DeepCopy(cells->GetOffsetsArray());
+    connectivity = vtkSmartPointer<vtkTypeInt64Array>::New();
+    connectivity->DeepCopy(cells->GetConnectivityArray());
+    }
+  AddBlockToWrite(blocks, offsetsKind, offsets);
+  AddBlockToWrite(blocks, connectivityKind, connectivity);
+}
+
+//----------------------------------------------------------------------------
+void AddAttributeBlocksToWrite(std::vector<BlockToWrite>& blocks, vtkDataSetAttributes* attributes,
+  vtkTypeUInt32 kind)
+{
+  if (!attributes)
+    {
+    return;
+    }
+  for (int arrayIndex = 0; arrayIndex < attributes->GetNumberOfArrays(); ++arrayIndex)
+    {
+    vtkDataArray* array = attributes->GetArray(arrayIndex);
+    if (!array || !IsSupportedDataType(array->GetDataType()))
+      {
+      // string, bit, and other non-numeric arrays are not stored
+      continue;
+      }
+    AddBlockToWrite(blocks, kind, array, attributes->IsArrayAnAttribute(arrayIndex));
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkMRMLBinaryMeshIO::vtkMRMLBinaryMeshIO() = default;
+
+//----------------------------------------------------------------------------
+vtkMRMLBinaryMeshIO::~vtkMRMLBinaryMeshIO() = default;
+
+//----------------------------------------------------------------------------
+void vtkMRMLBinaryMeshIO::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfMappedArrays: " << vtkMRMLBinaryMeshIO::GetNumberOfMappedArrays() << "\n";
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLBinaryMeshIO::IsMemoryMappingSupported()
+{
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLBinaryMeshIO::GetNumberOfMappedArrays()
+{
+  MappedArrayRegistry& registry = GetMappedArrayRegistry();
+  std::lock_guard<std::mutex> lock(registry.Mutex);
+  int numberOfMappedArrays = 0;
+  for (const std::pair<void* const, MappedArrayRegistry::MappedBlock>& mappedBlock : registry.MappedBlocks)
+    {
+    numberOfMappedArrays += mappedBlock.second.NumberOfArrays;
+    }
+  return numberOfMappedArrays;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLBinaryMeshIO::CanReadFile(const std::string& fileName)
+{
+  vtksys::ifstream stream(fileName.c_str(), std::ios::in | std::ios::binary);
+  if (!stream.is_open())
+    {
+    return false;
+    }
+  char signature[sizeof(BinaryMeshSignature)] = { 0 };
+  stream.read(signature, sizeof(signature));
+  return !stream.fail() && memcmp(signature, BinaryMeshSignature, sizeof(signature)) == 0;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLBinaryMeshIO::ReadPolyData(const std::string& fileName, vtkPolyData* polyData,
+  int& coordinateSystem, std::string& errorMessage, bool memoryMap/*=true*/)
+{
+  if (!polyData)
+    {
+    errorMessage = "Invalid output polydata";
+    return false;
+    }
+  BinaryMeshSource source;
+  if (!source.Open(fileName, memoryMap))
+    {
+    errorMessage = "Failed to open file " + fileName;
+    return false;
+    }
+
+  FileHeader header;
+  if (!source.Read(0, sizeof(FileHeader), &header)
+    || memcmp(header.Signature, BinaryMeshSignature, sizeof(BinaryMeshSignature)) != 0)
+    {
+    errorMessage = "File " + fileName + " is not a binary mesh file";
+    return false;
+    }
+  if (header.Version != BinaryMeshVersion)
+    {
+    std::stringstream ss;
+    ss << "Unsupported binary mesh file version " << header.Version << " in file " << fileName;
+    errorMessage = ss.str();
+    return false;
+    }
+  if (header.ByteOrderMark != BinaryMeshByteOrderMark)
+    {
+    errorMessage = "Binary mesh file " + fileName + " was written on a platform with different byte order";
+    return false;
+    }
+
+  // Header fields are not trusted: the block table must fit in the file before it is allocated
+  const vtkTypeUInt64 fileSize = source.GetFileSize();
+  if (header.BlockTableOffset > fileSize
+    || header.NumberOfBlocks > (fileSize - header.BlockTableOffset) / sizeof(BlockHeader))
+    {
+    errorMessage = "Invalid block table in binary mesh file " + fileName;
+    return false;
+    }
+  std::vector<BlockHeader> blocks(header.NumberOfBlocks);
+  if (header.NumberOfBlocks > 0
+    && !source.Read(header.BlockTableOffset, header.NumberOfBlocks * sizeof(BlockHeader), blocks.data()))
+    {
+    errorMessage = "Failed to read block table from binary mesh file " + fileName;
+    return false;
+    }
+
+  // Blocks must not overlap each other or the headers, as memory-mapped arrays would share memory
+  std::vector< std::pair<vtkTypeUInt64, vtkTypeUInt64> > blockRanges;
+  blockRanges.emplace_back(0, sizeof(FileHeader));
+  if (header.NumberOfBlocks > 0)
+    {
+    blockRanges.emplace_back(header.BlockTableOffset, header.NumberOfBlocks * sizeof(BlockHeader));
+    }
+  for (const BlockHeader& block : blocks)
+    {
+    std::string name(block.Name, strnlen(block.Name, sizeof(block.Name)));
+    // Size is compared by division to avoid overflow for corrupted tuple counts
+    const vtkTypeUInt64 tupleSize = IsSupportedDataType(block.DataType) && block.NumberOfComponents > 0
+      ? static_cast<vtkTypeUInt64>(block.NumberOfComponents) * vtkDataArray::GetDataTypeSize(block.DataType) : 0;
+    if (block.Kind >= BlockKind_Last
+      || tupleSize == 0
+      || block.NumberOfTuples < 0
+      || block.Offset % BinaryMeshBlockAlignment != 0
+      || block.Offset > fileSize
+      || block.Size > fileSize - block.Offset
+      || block.Size % tupleSize != 0
+      || block.Size / tupleSize != static_cast<vtkTypeUInt64>(block.NumberOfTuples))
+      {
+      errorMessage = "Invalid block '" + name + "' in binary mesh file " + fileName;
+      return false;
+      }
+    if (block.Size > 0)
+      {
+      blockRanges.emplace_back(block.Offset, block.Size);
+      }
+    }
+  std::sort(blockRanges.begin(), blockRanges.end());
+  for (std::size_t rangeIndex = 1; rangeIndex < blockRanges.size(); ++rangeIndex)
+    {
+    if (blockRanges[rangeIndex].first < blockRanges[rangeIndex - 1].first + blockRanges[rangeIndex - 1].second)
+      {
+      errorMessage = "Overlapping blocks in binary mesh file " + fileName;
+      return false;
+      }
+    }
+
+  vtkNew<vtkPolyData> mesh;
+  vtkSmartPointer<vtkTypeInt64Array> cellOffsets[4];
+  vtkSmartPointer<vtkTypeInt64Array> cellConnectivity[4];
+  for (const BlockHeader& block : blocks)
+    {
+    std::string name(block.Name, strnlen(block.Name, sizeof(block.Name)));
+
+    vtkSmartPointer<vtkDataArray> array;
+    if (block.Kind >= VertsOffsetsBlock && block.Kind <= StripsConnectivityBlock)
+      {
+      if (block.DataType != VTK_TYPE_INT64 || block.NumberOfComponents != 1)
+        {
+        errorMessage = "Invalid cell block in binary mesh file " + fileName;
+        return false;
+        }
+      // vtkCellArray can only use the array without copying if it is a vtkTypeInt64Array
+      vtkSmartPointer<vtkTypeInt64Array> cellArray = vtkSmartPointer<vtkTypeInt64Array>::New();
+      int cellType = (block.Kind - VertsOffsetsBlock) / 2;
+      if ((block.Kind - VertsOffsetsBlock) % 2 == 0)
+        {
+        cellOffsets[cellType] = cellArray;
+        }
+      else
+        {
+        cellConnectivity[cellType] = cellArray;
+        }
+      array = cellArray;
+      }
+    else
+      {
+      array = vtkSmartPointer<vtkDataArray>::Take(vtkDataArray::CreateDataArray(block.DataType));
+      }
+    if (!array || !source.LoadArray(block, array))
+      {
+      errorMessage = "Failed to read block '" + name + "' from binary mesh file " + fileName;
+      return false;
+      }
+    if (!name.empty())
+      {
+      array->SetName(name.c_str());
+      }
+
+    if (block.Kind == PointsBlock)
+      {
+      if ((block.DataType != VTK_FLOAT && block.DataType != VTK_DOUBLE) || block.NumberOfComponents != 3)
+        {
+        errorMessage = "Invalid points in binary mesh file " + fileName;
+        return false;
+        }
+      vtkNew<vtkPoints> points;
+      points->SetData(array);
+      mesh->SetPoints(points);
+      }
+    else if (block.Kind == PointDataBlock || block.Kind == CellDataBlock)
+      {
+      vtkDataSetAttributes* attributes = (block.Kind == PointDataBlock)
+        ? static_cast<vtkDataSetAttributes*>(mesh->GetPointData())
+        : static_cast<vtkDataSetAttributes*>(mesh->GetCellData());
+      int arrayIndex = attributes->AddArray(array);
+      if (block.AttributeType >= 0 && block.AttributeType < vtkDataSetAttributes::NUM_ATTRIBUTES)
+        {
+        attributes->SetActiveAttribute(arrayIndex, block.AttributeType);
+        }
+      }
+    }
+
+  for (int cellType = 0; cellType < 4; ++cellType)
+    {
+    if (!cellOffsets[cellType] && !cellConnectivity[cellType])
+      {
+      continue;
+      }
+    if (!cellOffsets[cellType] || !cellConnectivity[cellType])
+      {
+      errorMessage = "Incomplete cell definition in binary mesh file " + fileName;
+      return false;
+      }
+    vtkNew<vtkCellArray> cells;
+    cells->SetData(cellOffsets[cellType], cellConnectivity[cellType]);
+    switch (cellType)
+      {
+      case 0: mesh->SetVerts(cells); break;
+      case 1: mesh->SetLines(cells); break;
+      case 2: mesh->SetPolys(cells); break;
+      case 3: mesh->SetStrips(cells); break;
+      default: break;
+      }
+    }
+
+  polyData->ShallowCopy(mesh);
+  coordinateSystem = static_cast<int>(header.CoordinateSystem);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLBinaryMeshIO::WritePolyData(const std::string& fileName, vtkPolyData* polyData,
+  int coordinateSystem, std::string& errorMessage)
+{
+  if (!polyData)
+    {
+    errorMessage = "Invalid input polydata";
+    return false;
+    }
+
+  std::vector<BlockToWrite> blocks;
+  if (polyData->GetPoints() && polyData->GetPoints()->GetData())
+    {
+    AddBlockToWrite(blocks, PointsBlock, polyData->GetPoints()->GetData());
+    }
+  AddCellBlocksToWrite(blocks, polyData->GetVerts(), VertsOffsetsBlock, VertsConnectivityBlock);
+  AddCellBlocksToWrite(blocks, polyData->GetLines(), LinesOffsetsBlock, LinesConnectivityBlock);
+  AddCellBlocksToWrite(blocks, polyData->GetPolys(), PolysOffsetsBlock, PolysConnectivityBlock);
+  AddCellBlocksToWrite(blocks, polyData->GetStrips(), StripsOffsetsBlock, StripsConnectivityBlock);
+  AddAttributeBlocksToWrite(blocks, polyData->GetPointData(), PointDataBlock);
+  AddAttributeBlocksToWrite(blocks, polyData->GetCellData(), CellDataBlock);
+
+  FileHeader header;
+  memset(&header, 0, sizeof(FileHeader));
+  memcpy(header.Signature, BinaryMeshSignature, sizeof(BinaryMeshSignature));
+  header.Version = BinaryMeshVersion;
+  header.ByteOrderMark = BinaryMeshByteOrderMark;
+  header.CoordinateSystem = static_cast<vtkTypeUInt32>(coordinateSystem);
+  header.NumberOfBlocks = static_cast<vtkTypeUInt32>(blocks.size());
+  header.BlockTableOffset = sizeof(FileHeader);
+
+  // Compute layout
+  vtkTypeUInt64 offset = AlignOffset(header.BlockTableOffset + blocks.size() * sizeof(BlockHeader));
+  for (BlockToWrite& block : blocks)
+    {
+    block.Header.Offset = offset;
+    offset = AlignOffset(offset + block.Header.Size);
+    }
+
+  // Write into a temporary file first, then replace the destination file. Existing mappings
+  // of the destination file keep referring to the original content.
+  std::string temporaryFileName = fileName + ".partial";
+    {
+    vtksys::ofstream stream(temporaryFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!stream.is_open())
+      {
+      errorMessage = "Failed to open file " + temporaryFileName + " for writing";
+      return false;
+      }
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+    for (const BlockToWrite& block : blocks)
+      {
+      stream.write(reinterpret_cast<const char*>(&block.Header), sizeof(BlockHeader));
+      }
+    const char padding[BinaryMeshBlockAlignment] = { 0 };
+    for (const BlockToWrite& block : blocks)
+      {
+      vtkTypeUInt64 position = static_cast<vtkTypeUInt64>(stream.tellp());
+      stream.write(padding, static_cast<std::streamsize>(block.Header.Offset - position));
+      if (block.Header.Size > 0)
+        {
+        stream.write(static_cast<const char*>(block.Array->GetVoidPointer(0)),
+          static_cast<std::streamsize>(block.Header.Size));
+        }
+      }
+    stream.close();
+    if (stream.fail())
+      {
+      errorMessage = "Failed to write file " + temporaryFileName;
+      vtksys::SystemTools::RemoveFile(temporaryFileName);
+      return false;
+      }
+    }
+  if (!vtksys::SystemTools::RenameFile(temporaryFileName, fileName))
+    {
+    errorMessage = "Failed to replace file " + fileName + " (it may be in use)";
+    vtksys::SystemTools::RemoveFile(temporaryFileName);
+    return false;
+    }
+  return true;
+}
@@ -0,0 +1,76 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#ifndef __vtkMRMLBinaryMeshIO_h
+#define __vtkMRMLBinaryMeshIO_h
+
+// MRML includes
+#include "vtkMRML.h"
+
+// VTK includes
+#include <vtkObject.h>
+class vtkPolyData;
+
+// STD includes
+#include <string>
+
+/// \brief Read and write polydata in a native binary format that can be memory-mapped.
+///
+/// The file (.bmesh) consists of a fixed size header, a block table, and the raw
+/// content of points, cell offsets, cell connectivity, point data and cell data arrays.
+/// Each block is stored in native byte order and is aligned to 64 bytes, so that
+/// the reader can memory-map the file and wrap the mapped memory in VTK data arrays
+/// without copying or parsing.
+///
+/// Memory is mapped copy-on-write: the mesh can be modified without changing the file.
+/// The mapping is released when the last data array that refers to it is deleted.
+///
+/// Only numeric point and cell data arrays are stored. Cells are stored with 64-bit
+/// offsets and connectivity.
+class VTK_MRML_EXPORT vtkMRMLBinaryMeshIO : public vtkObject
+{
+public:
+  static vtkMRMLBinaryMeshIO *New();
+  vtkTypeMacro(vtkMRMLBinaryMeshIO, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Read polydata from file.
+  /// If memoryMap is true then arrays refer directly to the memory-mapped file content,
+  /// otherwise the file content is copied into newly allocated arrays.
+  /// Coordinate system that the points are stored in (see vtkMRMLStorageNode::CoordinateSystemType)
+  /// is returned in coordinateSystem.
+  /// Returns false and sets errorMessage on failure.
+  static bool ReadPolyData(const std::string& fileName, vtkPolyData* polyData,
+    int& coordinateSystem, std::string& errorMessage, bool memoryMap = true);
+
+  /// Write polydata to file.
+  /// The file is first written to a temporary file, which then replaces the
+  /// destination file, so that meshes that are currently mapped from the destination
+  /// file are not affected. On Windows, a file cannot be replaced while it is mapped.
+  /// Returns false and sets errorMessage on failure.
+  static bool WritePolyData(const std::string& fileName, vtkPolyData* polyData,
+    int coordinateSystem, std::string& errorMessage);
+
+  /// Returns true if the file starts with the binary mesh file signature.
+  static bool CanReadFile(const std::string& fileName);
+
+  /// Returns true if the platform supports memory-mapping of files.
+  static bool IsMemoryMappingSupported();
+
+  /// Number of currently mapped data arrays. Used for testing.
+  static int GetNumberOfMappedArrays();
+
+protected:
+  vtkMRMLBinaryMeshIO();
+  ~vtkMRMLBinaryMeshIO() override;
+  vtkMRMLBinaryMeshIO(const vtkMRMLBinaryMeshIO&);
+  void operator=(const vtkMRMLBinaryMeshIO&);
+};
+
+#endif
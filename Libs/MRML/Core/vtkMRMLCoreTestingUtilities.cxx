@@ -119,6 +119,13 @@ bool CheckNodeIdAndName(int line, vtkMRMLNode* node,
   return true;
 }
 
+//----------------------------------------------------------------------------
+void PrintMeasurement(const std::string& name, double value)
+{
+  std::cout << "<DartMeasurement name=\"" << name << "\" type=\"numeric/double\">"
+    << value << "</DartMeasurement>" << std::endl;
+}
+
 // ----------------------------------------------------------------------------
 int GetExpectedNodeAddedClassNames(const char * sceneFilePath, std::vector<std::string>& expectedNodeAddedClassNames)
 {
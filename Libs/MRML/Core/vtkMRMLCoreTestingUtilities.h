@@ -60,6 +60,10 @@ bool CheckNodeIdAndName(int line, vtkMRMLNode* node,
 template<typename Type>
 std::string ToString(Type value);
 
+/// Print a numeric value as a CTest/CDash measurement (for example, an elapsed time)
+VTK_MRML_EXPORT
+void PrintMeasurement(const std::string& name, double value);
+
 /// Return list of node that should be added to the scene
 VTK_MRML_EXPORT
 int GetExpectedNodeAddedClassNames(
@@ -13,16 +13,147 @@ Version:   $Revision: 1.14 $
 =========================================================================auto=*/
 
 // MRML includes
+#include "vtkEventBroker.h"
 #include "vtkMRMLGridTransformNode.h"
+#include "vtkPrecomputedInverseGridTransform.h"
 
 // VTK includes
+#include <vtkCallbackCommand.h>
 #include <vtkOrientedGridTransform.h>
 #include <vtkImageData.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
 
 // STD includes
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <sstream>
+#include <thread>
+
+//----------------------------------------------------------------------------
+class vtkMRMLGridTransformNode::vtkInternal
+{
+public:
+  /// Inverse displacement field computation running in a background thread.
+  /// The background thread only accesses this object.
+  struct Computation
+  {
+    /// Copy of the grid transform, so that the displacement field can be modified during the computation
+    vtkSmartPointer<vtkGridTransform> OriginalTransform;
+    vtkSmartPointer<vtkPrecomputedInverseGridTransform> InverseTransform;
+    double MaximumError{ -1.0 };
+    double MeanError{ -1.0 };
+    std::atomic<bool> Canceled{ false };
+    std::atomic<bool> Completed{ false };
+    /// Object that is modified on the main thread when the computation is completed
+    vtkSmartPointer<vtkObject> CompletionNotifier;
+  };
+
+  vtkInternal(vtkMRMLGridTransformNode* node)
+  {
+    this->CompletionCallback->SetCallback(vtkMRMLGridTransformNode::vtkInternal::OnComputationCompleted);
+    this->CompletionCallback->SetClientData(node);
+    this->CompletionNotifier->AddObserver(vtkCommand::ModifiedEvent, this->CompletionCallback);
+  }
+
+  ~vtkInternal()
+  {
+    this->CompletionNotifier->RemoveObserver(this->CompletionCallback);
+    this->CancelComputation();
+  }
+
+  static void Compute(Computation& computation);
+  static void OnComputationCompleted(vtkObject* caller, unsigned long eid, void* clientData, void* callData);
+  void CancelComputation();
+  void JoinComputation();
+
+  std::shared_ptr<Computation> RunningComputation;
+  std::thread ComputationThread;
+  /// Grid transform and its modification time that the running computation was started for
+  vtkGridTransform* RunningComputationSource{ nullptr };
+  vtkMTimeType RunningComputationSourceMTime{ 0 };
+
+  /// Completed computation
+  vtkSmartPointer<vtkPrecomputedInverseGridTransform> InverseTransform;
+  vtkGridTransform* InverseTransformSource{ nullptr };
+  vtkMTimeType InverseTransformSourceMTime{ 0 };
+  double MaximumError{ -1.0 };
+  double MeanError{ -1.0 };
+
+  /// The background thread requests a modified event of this object when the computation
+  /// is completed. The event is invoked on the main thread, where the result is taken into use.
+  vtkNew<vtkObject> CompletionNotifier;
+  vtkNew<vtkCallbackCommand> CompletionCallback;
+};
+
+//----------------------------------------------------------------------------
+void vtkMRMLGridTransformNode::vtkInternal::Compute(Computation& computation)
+{
+  vtkNew<vtkImageData> inverseDisplacementField;
+  if (vtkPrecomputedInverseGridTransform::ComputeInverseDisplacementField(
+    computation.OriginalTransform, inverseDisplacementField, &computation.Canceled))
+    {
+    vtkSmartPointer<vtkPrecomputedInverseGridTransform> inverseTransform = vtkSmartPointer<vtkPrecomputedInverseGridTransform>::New();
+    inverseTransform->SetDisplacementGridData(inverseDisplacementField);
+    vtkOrientedGridTransform* orientedGridTransform = vtkOrientedGridTransform::SafeDownCast(computation.OriginalTransform);
+    if (orientedGridTransform)
+      {
+      inverseTransform->SetGridDirectionMatrix(orientedGridTransform->GetGridDirectionMatrix());
+      }
+    inverseTransform->SetOriginalTransform(computation.OriginalTransform);
+    if (inverseTransform->ComputeResidualError(computation.MaximumError, computation.MeanError, &computation.Canceled))
+      {
+      computation.InverseTransform = inverseTransform;
+      }
+    }
+  computation.Completed = true;
+  if (!computation.Canceled && computation.CompletionNotifier)
+    {
+    // The result is only taken into use on the main thread, when the requested modified event
+    // is processed by the application event loop. Evaluating the transform does not use the result.
+    // If there is no application event loop (e.g., in headless scripts) then the result is taken
+    // into use when UpdateInverseDisplacementField is called.
+    vtkEventBroker::GetInstance()->RequestModified(computation.CompletionNotifier);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLGridTransformNode::vtkInternal::OnComputationCompleted(vtkObject* vtkNotUsed(caller),
+  unsigned long vtkNotUsed(eid), void* clientData, void* vtkNotUsed(callData))
+{
+  // Called on the main thread
+  vtkMRMLGridTransformNode* self = static_cast<vtkMRMLGridTransformNode*>(clientData);
+  if (!self || !self->Internal->RunningComputation || !self->Internal->RunningComputation->Completed)
+    {
+    // The computation has been already processed or canceled
+    return;
+    }
+  self->UpdateInverseDisplacementField(false);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLGridTransformNode::vtkInternal::CancelComputation()
+{
+  if (this->RunningComputation)
+    {
+    this->RunningComputation->Canceled = true;
+    }
+  this->JoinComputation();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLGridTransformNode::vtkInternal::JoinComputation()
+{
+  if (this->ComputationThread.joinable())
+    {
+    this->ComputationThread.join();
+    }
+  this->RunningComputation.reset();
+  this->RunningComputationSource = nullptr;
+  this->RunningComputationSourceMTime = 0;
+}
 
 //----------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLGridTransformNode);
@@ -30,6 +161,8 @@ vtkMRMLNodeNewMacro(vtkMRMLGridTransformNode);
 //----------------------------------------------------------------------------
 vtkMRMLGridTransformNode::vtkMRMLGridTransformNode()
 {
+  this->Internal = new vtkInternal(this);
+
   // Set up the node with a dummy displacement field (that contains one single
   // null-vector) to make sure the node is valid and can be saved
   vtkNew<vtkImageData> emptyDisplacementField;
@@ -48,23 +181,232 @@ vtkMRMLGridTransformNode::vtkMRMLGridTransformNode()
 //----------------------------------------------------------------------------
 vtkMRMLGridTransformNode::~vtkMRMLGridTransformNode()
 {
+  // Removing the transform may invoke events, whose observers may evaluate the transform,
+  // which uses the internal state. Therefore the internal state is deleted last.
   this->SetAndObserveTransformFromParent(nullptr);
+  delete this->Internal;
+  this->Internal = nullptr;
 }
 
 //----------------------------------------------------------------------------
 void vtkMRMLGridTransformNode::WriteXML(ostream& of, int nIndent)
 {
   Superclass::WriteXML(of, nIndent);
+
+  vtkMRMLWriteXMLBeginMacro(of);
+  vtkMRMLWriteXMLBooleanMacro(cacheInverseDisplacementField, CacheInverseDisplacementField);
+  vtkMRMLWriteXMLEndMacro();
 }
 
 //----------------------------------------------------------------------------
 void vtkMRMLGridTransformNode::ReadXMLAttributes(const char** atts)
 {
+  MRMLNodeModifyBlocker blocker(this);
   Superclass::ReadXMLAttributes(atts);
+
+  vtkMRMLReadXMLBeginMacro(atts);
+  vtkMRMLReadXMLBooleanMacro(cacheInverseDisplacementField, CacheInverseDisplacementField);
+  vtkMRMLReadXMLEndMacro();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLGridTransformNode::CopyContent(vtkMRMLNode* anode, bool deepCopy/*=true*/)
+{
+  MRMLNodeModifyBlocker blocker(this);
+  Superclass::CopyContent(anode, deepCopy);
+
+  vtkMRMLGridTransformNode* node = vtkMRMLGridTransformNode::SafeDownCast(anode);
+  if (!node)
+    {
+    return;
+    }
+
+  vtkMRMLCopyBeginMacro(anode);
+  vtkMRMLCopyBooleanMacro(CacheInverseDisplacementField);
+  vtkMRMLCopyEndMacro();
 }
 
 //----------------------------------------------------------------------------
 void vtkMRMLGridTransformNode::PrintSelf(ostream& os, vtkIndent indent)
 {
   Superclass::PrintSelf(os,indent);
+
+  vtkMRMLPrintBeginMacro(os, indent);
+  vtkMRMLPrintBooleanMacro(CacheInverseDisplacementField);
+  vtkMRMLPrintEndMacro();
+  os << indent << "InverseDisplacementFieldUpToDate: " << (this->IsInverseDisplacementFieldUpToDate() ? "true" : "false") << "\n";
+  os << indent << "InverseDisplacementFieldMaximumError: " << this->GetInverseDisplacementFieldMaximumError() << "\n";
+  os << indent << "InverseDisplacementFieldMeanError: " << this->GetInverseDisplacementFieldMeanError() << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLGridTransformNode::SetCacheInverseDisplacementField(bool enable)
+{
+  if (this->CacheInverseDisplacementField == enable)
+    {
+    return;
+    }
+  this->CacheInverseDisplacementField = enable;
+  if (!enable)
+    {
+    this->Internal->CancelComputation();
+    this->Internal->InverseTransform = nullptr;
+    this->Internal->InverseTransformSource = nullptr;
+    }
+  this->Modified();
+  // Transforms between nodes are computed differently
+  this->TransformModified();
+  if (enable)
+    {
+    this->ProcessInverseDisplacementFieldComputation(false, false);
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkGridTransform* vtkMRMLGridTransformNode::GetInverseDisplacementFieldSource(vtkMTimeType& sourceMTime)
+{
+  sourceMTime = 0;
+  // The inverse is only computed if one of the transforms is stored and the other is computed from it
+  vtkAbstractTransform* storedTransform = nullptr;
+  if (this->TransformFromParent && !this->TransformToParent)
+    {
+    storedTransform = this->TransformFromParent;
+    }
+  else if (this->TransformToParent && !this->TransformFromParent)
+    {
+    storedTransform = this->TransformToParent;
+    }
+  vtkGridTransform* gridTransform = vtkGridTransform::SafeDownCast(storedTransform);
+  if (!gridTransform || !gridTransform->GetDisplacementGrid())
+    {
+    return nullptr;
+    }
+  sourceMTime = std::max(gridTransform->GetMTime(), gridTransform->GetDisplacementGrid()->GetMTime());
+  return gridTransform;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLGridTransformNode::IsInverseDisplacementFieldUpToDate()
+{
+  vtkMTimeType sourceMTime = 0;
+  vtkGridTransform* source = this->GetInverseDisplacementFieldSource(sourceMTime);
+  return source && this->Internal->InverseTransform
+    && this->Internal->InverseTransformSource == source
+    && this->Internal->InverseTransformSourceMTime == sourceMTime;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLGridTransformNode::ProcessInverseDisplacementFieldComputation(bool wait, bool useCompletedResult/*=true*/)
+{
+  vtkMTimeType sourceMTime = 0;
+  vtkGridTransform* source = this->GetInverseDisplacementFieldSource(sourceMTime);
+  if (!this->CacheInverseDisplacementField || !source)
+    {
+    this->Internal->CancelComputation();
+    this->Internal->InverseTransform = nullptr;
+    this->Internal->InverseTransformSource = nullptr;
+    return false;
+    }
+  if (this->IsInverseDisplacementFieldUpToDate())
+    {
+    return false;
+    }
+
+  // Cancel computation that was started for a previous state of the displacement field
+  if (this->Internal->RunningComputation
+    && (this->Internal->RunningComputationSource != source || this->Internal->RunningComputationSourceMTime != sourceMTime))
+    {
+    this->Internal->CancelComputation();
+    }
+
+  if (!this->Internal->RunningComputation)
+    {
+    std::shared_ptr<vtkInternal::Computation> computation = std::make_shared<vtkInternal::Computation>();
+    vtkSmartPointer<vtkAbstractTransform> originalTransform = vtkSmartPointer<vtkAbstractTransform>::Take(source->MakeTransform());
+    vtkMRMLTransformNode::DeepCopyTransform(originalTransform, source);
+    computation->OriginalTransform = vtkGridTransform::SafeDownCast(originalTransform);
+    computation->CompletionNotifier = this->Internal->CompletionNotifier.GetPointer();
+    this->Internal->RunningComputation = computation;
+    this->Internal->RunningComputationSource = source;
+    this->Internal->RunningComputationSourceMTime = sourceMTime;
+    this->Internal->ComputationThread = std::thread([computation]()
+      {
+      vtkInternal::Compute(*computation);
+      });
+    }
+
+  if (!useCompletedResult || (!wait && !this->Internal->RunningComputation->Completed))
+    {
+    return false;
+    }
+
+  std::shared_ptr<vtkInternal::Computation> computation = this->Internal->RunningComputation;
+  this->Internal->JoinComputation();
+  if (!computation->InverseTransform)
+    {
+    vtkErrorMacro("ProcessInverseDisplacementFieldComputation: failed to compute inverse displacement field");
+    return false;
+    }
+  this->Internal->InverseTransform = computation->InverseTransform;
+  this->Internal->InverseTransformSource = source;
+  this->Internal->InverseTransformSourceMTime = sourceMTime;
+  this->Internal->MaximumError = computation->MaximumError;
+  this->Internal->MeanError = computation->MeanError;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLGridTransformNode::UpdateInverseDisplacementField(bool wait/*=false*/)
+{
+  if (this->ProcessInverseDisplacementFieldComputation(wait))
+    {
+    this->TransformModified();
+    }
+  return this->IsInverseDisplacementFieldUpToDate();
+}
+
+//----------------------------------------------------------------------------
+vtkImageData* vtkMRMLGridTransformNode::GetInverseDisplacementField()
+{
+  if (!this->IsInverseDisplacementFieldUpToDate())
+    {
+    return nullptr;
+    }
+  return this->Internal->InverseTransform->GetDisplacementGrid();
+}
+
+//----------------------------------------------------------------------------
+double vtkMRMLGridTransformNode::GetInverseDisplacementFieldMaximumError()
+{
+  return this->IsInverseDisplacementFieldUpToDate() ? this->Internal->MaximumError : -1.0;
+}
+
+//----------------------------------------------------------------------------
+double vtkMRMLGridTransformNode::GetInverseDisplacementFieldMeanError()
+{
+  return this->IsInverseDisplacementFieldUpToDate() ? this->Internal->MeanError : -1.0;
+}
+
+//----------------------------------------------------------------------------
+vtkAbstractTransform* vtkMRMLGridTransformNode::GetTransformToParentForEvaluation()
+{
+  if (!this->CacheInverseDisplacementField)
+    {
+    return this->GetTransformToParent();
+    }
+  // Only start the computation here. Events cannot be invoked while transforms are being computed,
+  // therefore the result is taken into use (and TransformModifiedEvent is invoked) by
+  // UpdateInverseDisplacementField, which is called on the main thread when the computation is completed.
+  this->ProcessInverseDisplacementFieldComputation(false, false);
+  if (!this->IsInverseDisplacementFieldUpToDate())
+    {
+    return this->GetTransformToParent();
+    }
+  if (this->TransformFromParent)
+    {
+    // Transform to parent is the inverse of the stored transform
+    return this->Internal->InverseTransform;
+    }
+  // Transform to parent is the stored transform, its inverse is precomputed
+  return this->Internal->InverseTransform->GetInverse();
 }
@@ -17,6 +17,9 @@
 
 #include "vtkMRMLTransformNode.h"
 
+class vtkGridTransform;
+class vtkImageData;
+
 /// \brief MRML node for representing a nonlinear transformation to the parent node using a grid transform.
 ///
 /// MRML node for representing a nonlinear transformation to the parent
@@ -40,17 +43,74 @@ public:
 
   /// Copy node content (excludes basic data, such as name and node references).
   /// \sa vtkMRMLNode::CopyContent
-  vtkMRMLCopyContentDefaultMacro(vtkMRMLGridTransformNode);
+  vtkMRMLCopyContentMacro(vtkMRMLGridTransformNode);
 
   ///
   /// Get node XML tag name (like Volume, Model)
   const char* GetNodeTagName() override {return "GridTransform";}
 
+  ///
+  /// Use a precomputed inverse displacement field for computing the inverse of the grid transform.
+  /// Computing the inverse of a grid transform requires iterative inversion at each point, which is slow.
+  /// If enabled, the inverse displacement field is computed in a background thread when the inverse is needed
+  /// and after that the inverse is evaluated by trilinear interpolation of the inverse displacement field.
+  /// Until the computation is completed the inverse is computed iteratively.
+  /// When the computation is completed, UpdateInverseDisplacementField is called on the main thread
+  /// (using vtkEventBroker::RequestModified), which invokes vtkMRMLTransformableNode::TransformModifiedEvent.
+  /// This requires an application event loop that processes modified requests. Evaluating the transform only
+  /// starts the computation and never takes the result into use, therefore callers without an application
+  /// event loop (headless scripts, tests) must call UpdateInverseDisplacementField to use the precomputed inverse.
+  /// The inverse displacement field is recomputed when the displacement field is modified.
+  /// Only transforms computed between nodes (GetTransformToWorld, GetTransformBetweenNodes, ...) use the
+  /// precomputed inverse, GetTransformToParent and GetTransformFromParent always return the exact transforms.
+  /// Disabled by default.
+  void SetCacheInverseDisplacementField(bool enable);
+  vtkGetMacro(CacheInverseDisplacementField, bool);
+  vtkBooleanMacro(CacheInverseDisplacementField, bool);
+
+  ///
+  /// Start computation of the inverse displacement field if it is not up-to-date and use the result
+  /// if the computation is completed. If wait is true then the method waits for the computation to complete.
+  /// This is the only way to use the precomputed inverse if there is no application event loop.
+  /// Invokes vtkMRMLTransformableNode::TransformModifiedEvent when a new inverse displacement field is used.
+  /// Returns true if the inverse displacement field is up-to-date.
+  /// It has no effect if CacheInverseDisplacementField is disabled.
+  bool UpdateInverseDisplacementField(bool wait = false);
+
+  ///
+  /// Returns true if the computed inverse displacement field corresponds to the current displacement field.
+  bool IsInverseDisplacementFieldUpToDate();
+
+  ///
+  /// Get the precomputed inverse displacement field. Returns nullptr if it is not computed or not up-to-date.
+  vtkImageData* GetInverseDisplacementField();
+
+  ///
+  /// Get maximum and mean residual error (in mm) of the precomputed inverse, measured at the center
+  /// of the displacement field cells. Returns -1 if the inverse displacement field is not available.
+  double GetInverseDisplacementFieldMaximumError();
+  double GetInverseDisplacementFieldMeanError();
+
 protected:
   vtkMRMLGridTransformNode();
   ~vtkMRMLGridTransformNode() override;
   vtkMRMLGridTransformNode(const vtkMRMLGridTransformNode&);
   void operator=(const vtkMRMLGridTransformNode&);
+
+  vtkAbstractTransform* GetTransformToParentForEvaluation() override;
+
+  /// Get the stored grid transform that the inverse is computed for and its modification time.
+  /// Returns nullptr if the inverse displacement field cannot be precomputed.
+  vtkGridTransform* GetInverseDisplacementFieldSource(vtkMTimeType& sourceMTime);
+
+  /// Start a new computation if needed and use the completed computation if useCompletedResult is true.
+  /// Returns true if a new inverse displacement field was taken into use.
+  bool ProcessInverseDisplacementFieldComputation(bool wait, bool useCompletedResult = true);
+
+  bool CacheInverseDisplacementField{ false };
+
+  class vtkInternal;
+  vtkInternal* Internal;
 };
 
 #endif
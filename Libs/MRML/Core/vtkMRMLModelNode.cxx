@@ -20,6 +20,7 @@ Version:   $Revision: 1.3 $
 #include <vtkMRMLProceduralColorNode.h>
 #include "vtkMRMLTransformNode.h"
 #include "vtkMRMLScene.h"
+#include "vtkParallelTransformFilter.h"
 
 // VTK includes
 #include <vtkAlgorithmOutput.h>
@@ -36,7 +37,6 @@ Version:   $Revision: 1.3 $
 #include <vtkPointData.h>
 #include <vtkPolyData.h>
 #include <vtkSmartPointer.h>
-#include <vtkTransformFilter.h>
 #include <vtkTrivialProducer.h>
 #include <vtkUnstructuredGrid.h>
 #include <vtkVersion.h>
@@ -698,7 +698,7 @@ void vtkMRMLModelNode::ApplyTransform(vtkAbstractTransform* transform)
     return;
     }
 
-  vtkTransformFilter* transformFilter = vtkTransformFilter::New();
+  vtkParallelTransformFilter* transformFilter = vtkParallelTransformFilter::New();
   transformFilter->SetInputConnection(this->MeshConnection);
   transformFilter->SetTransform(transform);
 
@@ -14,6 +14,7 @@
 
 #include "vtkMRMLModelStorageNode.h"
 
+#include "vtkMRMLBinaryMeshIO.h"
 #include "vtkMRMLDisplayNode.h"
 #include "vtkMRMLMessageCollection.h"
 #include "vtkMRMLModelNode.h"
@@ -31,6 +32,7 @@
 #include <vtkOBJReader.h>
 #include <vtkOBJExporter.h>
 #include <vtkPointData.h>
+#include <vtkPolyData.h>
 #include <vtkPolyDataMapper.h>
 #include <vtkPLYReader.h>
 #include <vtkPLYWriter.h>
@@ -98,6 +100,9 @@ vtkMRMLModelStorageNode::vtkMRMLModelStorageNode()
 {
   this->DefaultWriteFileExtension = "vtk";
   this->CoordinateSystem = vtkMRMLStorageNode::CoordinateSystemLPS;
+  this->PrefetchedCoordinateSystemInFileHeader = -1;
+  this->SnapshotCoordinateSystem = vtkMRMLStorageNode::CoordinateSystemLPS;
+  this->SnapshotUseCompression = true;
 }
 
 //----------------------------------------------------------------------------
@@ -198,6 +203,59 @@ int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
   vtkDebugMacro("ReadDataInternal (" << (this->ID ? this->ID : "(unknown)") << "): extension = " << extension.c_str());
 
   int coordinateSystemInFileHeader = -1;
+  vtkSmartPointer<vtkPointSet> meshToSetInNode;
+  if (this->PrefetchedMesh && this->PrefetchedFileName == fullName)
+    {
+    // the file has been already read by PrefetchData
+    meshToSetInNode = this->PrefetchedMesh;
+    coordinateSystemInFileHeader = this->PrefetchedCoordinateSystemInFileHeader;
+    }
+  else if (!this->ReadMeshFromFile(fullName, meshToSetInNode, coordinateSystemInFileHeader))
+    {
+    return 0;
+    }
+
+  if (coordinateSystemInFileHeader >= 0)
+    {
+    // coordinate system specified in the file, use it (regardless oassumingf what was the preferred coordinate system in the node)
+    this->CoordinateSystem = coordinateSystemInFileHeader;
+    }
+  else
+    {
+    // no coordinate system in the file, use the currently set coordinate system
+    vtkInfoMacro("ReadDataInternal (" << (this->ID ? this->ID : "(unknown)") << "): File "
+      << fullName.c_str() << " does not contain coordinate system information. Assuming "
+      << vtkMRMLStorageNode::GetCoordinateSystemTypeAsString(this->CoordinateSystem) << ".");
+    }
+
+  modelNode->SetAndObserveMesh(meshToSetInNode);
+
+  if (modelNode->GetMesh() != nullptr)
+    {
+    for (int i=0; i<modelNode->GetNumberOfDisplayNodes(); ++i)
+      {
+      vtkMRMLDisplayNode* displayNode = modelNode->GetNthDisplayNode(i);
+      // is there an active scalar array?
+      if (displayNode && displayNode->GetScalarRangeFlag() == vtkMRMLDisplayNode::UseDataScalarRange)
+        {
+        double *scalarRange = modelNode->GetMesh()->GetScalarRange();
+        if (scalarRange)
+          {
+          vtkDebugMacro("ReadDataInternal (" << (this->ID ? this->ID : "(unknown)") << "): setting scalar range " << scalarRange[0] << ", " << scalarRange[1]);
+          displayNode->SetScalarRange(scalarRange);
+          }
+        }
+      } // For all display nodes
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLModelStorageNode::ReadMeshFromFile(const std::string& fullName,
+  vtkSmartPointer<vtkPointSet>& meshInRAS, int& coordinateSystemInFileHeader)
+{
+  std::string extension = vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(fullName);
+  coordinateSystemInFileHeader = -1;
   vtkSmartPointer<vtkPointSet> meshFromFile;
   try
     {
@@ -263,6 +321,20 @@ int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
       this->GetUserMessages()->SetObservedObject(nullptr);
       coordinateSystemInFileHeader = vtkMRMLModelStorageNode::GetCoordinateSystemFromFieldData(meshFromFile);
       }
+    else if (extension == std::string(".bmesh"))
+      {
+      vtkNew<vtkPolyData> polyData;
+      std::string errorMessage;
+      if (vtkMRMLBinaryMeshIO::ReadPolyData(fullName, polyData, coordinateSystemInFileHeader, errorMessage))
+        {
+        meshFromFile = polyData.GetPointer();
+        }
+      else
+        {
+        vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLModelStorageNode::ReadDataInternal",
+          "Failed to load model from file " << fullName << ": " << errorMessage);
+        }
+      }
     else if (extension == std::string(".ucd"))
       {
       vtkNew<vtkAVSucdReader> reader;
@@ -401,60 +473,128 @@ int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     return 0;
     }
 
-  if (coordinateSystemInFileHeader >= 0)
-    {
-    // coordinate system specified in the file, use it (regardless oassumingf what was the preferred coordinate system in the node)
-    this->CoordinateSystem = coordinateSystemInFileHeader;
-    }
-  else
-    {
-    // no coordinate system in the file, use the currently set coordinate system
-    vtkInfoMacro("ReadDataInternal (" << (this->ID ? this->ID : "(unknown)") << "): File "
-      << fullName.c_str() << " does not contain coordinate system information. Assuming "
-      << vtkMRMLStorageNode::GetCoordinateSystemTypeAsString(this->CoordinateSystem) << ".");
-    }
-
-  vtkSmartPointer<vtkPointSet> meshToSetInNode;
-  if (this->CoordinateSystem == vtkMRMLStorageNode::CoordinateSystemRAS)
+  int coordinateSystem = (coordinateSystemInFileHeader >= 0 ? coordinateSystemInFileHeader : this->CoordinateSystem);
+  if (coordinateSystem == vtkMRMLStorageNode::CoordinateSystemRAS)
     {
     // no flip of first two axes
-    meshToSetInNode = meshFromFile;
+    meshInRAS = meshFromFile;
     }
   else
     {
     // transform from RAS to LPS
     if (meshFromFile->IsA("vtkPolyData"))
       {
-      meshToSetInNode = vtkSmartPointer<vtkPolyData>::New();
+      meshInRAS = vtkSmartPointer<vtkPolyData>::New();
       }
     else
       {
-      meshToSetInNode = vtkSmartPointer<vtkUnstructuredGrid>::New();
+      meshInRAS = vtkSmartPointer<vtkUnstructuredGrid>::New();
       }
-    vtkMRMLModelStorageNode::ConvertBetweenRASAndLPS(meshFromFile, meshToSetInNode);
+    vtkMRMLModelStorageNode::ConvertBetweenRASAndLPS(meshFromFile, meshInRAS);
     }
-  modelNode->SetAndObserveMesh(meshToSetInNode);
+  return 1;
+}
 
-  if (modelNode->GetMesh() != nullptr)
+//----------------------------------------------------------------------------
+bool vtkMRMLModelStorageNode::CanPrefetchData(vtkMRMLNode* refNode)
+{
+  if (!refNode || !this->CanReadInReferenceNode(refNode)
+    || this->GetWriteState() == SkippedNoData
+    || this->GetURI() != nullptr || this->GetFileName() == nullptr)
     {
-    for (int i=0; i<modelNode->GetNumberOfDisplayNodes(); ++i)
-      {
-      vtkMRMLDisplayNode* displayNode = modelNode->GetNthDisplayNode(i);
-      // is there an active scalar array?
-      if (displayNode && displayNode->GetScalarRangeFlag() == vtkMRMLDisplayNode::UseDataScalarRange)
-        {
-        double *scalarRange = modelNode->GetMesh()->GetScalarRange();
-        if (scalarRange)
-          {
-          vtkDebugMacro("ReadDataInternal (" << (this->ID ? this->ID : "(unknown)") << "): setting scalar range " << scalarRange[0] << ", " << scalarRange[1]);
-          displayNode->SetScalarRange(scalarRange);
-          }
-        }
-      } // For all display nodes
+    return false;
+    }
+  // ITK mesh reader is not used from worker threads
+  std::string extension = vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(this->GetFileName());
+  return !extension.empty() && extension != std::string(".meta");
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLModelStorageNode::PrefetchDataInternal(vtkMRMLNode* vtkNotUsed(refNode))
+{
+  this->PrefetchedMesh = nullptr;
+  this->PrefetchedFileName = this->GetFullNameFromFileName();
+  if (this->PrefetchedFileName.empty()
+    || !vtksys::SystemTools::FileExists(this->PrefetchedFileName.c_str()))
+    {
+    return 0;
+    }
+  return this->ReadMeshFromFile(this->PrefetchedFileName, this->PrefetchedMesh,
+    this->PrefetchedCoordinateSystemInFileHeader);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLModelStorageNode::ClearPrefetchedData()
+{
+  this->Superclass::ClearPrefetchedData();
+  this->PrefetchedMesh = nullptr;
+  this->PrefetchedFileName.clear();
+  this->PrefetchedCoordinateSystemInFileHeader = -1;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLModelStorageNode::CanWriteDataAsynchronously(vtkMRMLNode* refNode)
+{
+  if (!refNode || !this->CanWriteFromReferenceNode(refNode)
+    || this->GetURI() != nullptr || this->GetFileName() == nullptr)
+    {
+    return false;
+    }
+  std::string extension = vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(this->GetFileName());
+  return !extension.empty() && extension != std::string(".obj");
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLModelStorageNode::SnapshotDataInternal(vtkMRMLNode* refNode)
+{
+  vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(refNode);
+  if (!modelNode)
+    {
+    return 0;
     }
+  this->SnapshotFileName = this->GetFullNameFromFileName();
+  if (this->SnapshotFileName.empty())
+    {
+    vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLModelStorageNode::SnapshotDataInternal",
+      "Failed to write model: File name not specified.");
+    return 0;
+    }
+  if (modelNode->GetMeshConnection() == nullptr || modelNode->GetMesh()->GetNumberOfPoints() == 0)
+    {
+    // nothing to write, WriteSnapshotDataInternal will not write anything
+    this->SetWriteStateSkippedNoData();
+    return 1;
+    }
+  // Shallow copy: the arrays are shared with the node, not copied on the main thread.
+  // The node replaces its mesh or arrays when it is modified, which leaves the snapshot
+  // unchanged, and the data IO manager writes the node again if it was modified.
+  this->SnapshotMesh = vtkSmartPointer<vtkPointSet>::Take(modelNode->GetMesh()->NewInstance());
+  this->SnapshotMesh->ShallowCopy(modelNode->GetMesh());
+  this->SnapshotCoordinateSystem = this->CoordinateSystem;
+  this->SnapshotUseCompression = (this->GetUseCompression() != 0);
   return 1;
 }
 
+//----------------------------------------------------------------------------
+int vtkMRMLModelStorageNode::WriteSnapshotDataInternal()
+{
+  if (!this->SnapshotMesh)
+    {
+    // no data to write
+    return 1;
+    }
+  return this->WriteMeshToFile(this->SnapshotFileName, this->SnapshotMesh,
+    this->SnapshotCoordinateSystem, this->SnapshotUseCompression, nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLModelStorageNode::ClearSnapshotData()
+{
+  this->Superclass::ClearSnapshotData();
+  this->SnapshotMesh = nullptr;
+  this->SnapshotFileName.clear();
+}
+
 //----------------------------------------------------------------------------
 int vtkMRMLModelStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
 {
@@ -474,26 +614,42 @@ int vtkMRMLModelStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     return 1; // success
     }
 
+  return this->WriteMeshToFile(fullName, modelNode->GetMesh(), this->CoordinateSystem,
+    this->GetUseCompression(), modelNode->GetDisplayNode());
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLModelStorageNode::WriteMeshToFile(const std::string& fullName, vtkPointSet* meshInRAS,
+  int coordinateSystem, bool useCompression, vtkMRMLDisplayNode* displayNode)
+{
   std::string extension = vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(fullName);
+  if (extension == ".bmesh")
+    {
+    // Binary mesh files are always stored in RAS, so that they can be memory-mapped
+    // and used without converting the points when they are read.
+    coordinateSystem = vtkMRMLStorageNode::CoordinateSystemRAS;
+    }
 
   // We explicitly write the coordinate system into the file header.
   const std::string coordinateSystemTag = "SPACE"; // following NRRD naming convention
-  const std::string coordinateSystemStr = vtkMRMLStorageNode::GetCoordinateSystemTypeAsString(this->CoordinateSystem);
+  const std::string coordinateSystemStr = vtkMRMLStorageNode::GetCoordinateSystemTypeAsString(coordinateSystem);
   // SPACE=RAS format follows Mimics software's convention, saving extra information into the
   // STL file header: COLOR=rgba,MATERIAL=rgbargbargba
   // (see details at https://en.wikipedia.org/wiki/STL_(file_format)#Color_in_binary_STL)
   const std::string coordinateSytemSpecification = coordinateSystemTag + "=" + coordinateSystemStr;
 
   vtkSmartPointer<vtkPointSet> meshToWrite;
-  if (this->CoordinateSystem == vtkMRMLStorageNode::CoordinateSystemRAS)
+  bool isPolyData = (vtkPolyData::SafeDownCast(meshInRAS) != nullptr);
+  bool isUnstructuredGrid = (vtkUnstructuredGrid::SafeDownCast(meshInRAS) != nullptr);
+  if (coordinateSystem == vtkMRMLStorageNode::CoordinateSystemRAS)
     {
     // no flip of first two axes
-    meshToWrite = modelNode->GetMesh();
+    meshToWrite = meshInRAS;
     }
   else
     {
     // transform from RAS to LPS
-    if (modelNode->GetMeshType() == vtkMRMLModelNode::PolyDataMeshType)
+    if (isPolyData)
       {
       meshToWrite = vtkSmartPointer<vtkPolyData>::New();
       }
@@ -501,18 +657,16 @@ int vtkMRMLModelStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
       {
       meshToWrite = vtkSmartPointer<vtkUnstructuredGrid>::New();
       }
-    vtkMRMLModelStorageNode::ConvertBetweenRASAndLPS(modelNode->GetMesh(), meshToWrite);
+    vtkMRMLModelStorageNode::ConvertBetweenRASAndLPS(meshInRAS, meshToWrite);
     }
 
   bool success = true;
 
-  if (extension == ".vtk" &&
-    (modelNode->GetMeshType() == vtkMRMLModelNode::PolyDataMeshType
-    || modelNode->GetMeshType() == vtkMRMLModelNode::UnstructuredGridMeshType))
+  if (extension == ".vtk" && (isPolyData || isUnstructuredGrid))
     {
     vtkSmartPointer<vtkDataWriter> writer;
     this->GetUserMessages()->SetObservedObject(writer);
-    if (modelNode->GetMeshType() == vtkMRMLModelNode::PolyDataMeshType)
+    if (isPolyData)
       {
       writer = vtkSmartPointer<vtkPolyDataWriter>::New();
       // version 5.1 is not compatible with earlier Slicer versions (VTK < 9) and most other software
@@ -528,7 +682,7 @@ int vtkMRMLModelStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
       }
 
     writer->SetFileName(fullName.c_str());
-    writer->SetFileType(this->GetUseCompression() ? VTK_BINARY : VTK_ASCII );
+    writer->SetFileType(useCompression ? VTK_BINARY : VTK_ASCII );
 
     std::string header = std::string("3D Slicer output. ") + coordinateSytemSpecification;
     writer->SetHeader(header.c_str());
@@ -564,9 +718,9 @@ int vtkMRMLModelStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     writer->SetInputData(inputData);
     writer->SetFileName(fullName.c_str());
     writer->SetCompressorType(
-      this->GetUseCompression() ? vtkXMLWriter::ZLIB : vtkXMLWriter::NONE);
+      useCompression ? vtkXMLWriter::ZLIB : vtkXMLWriter::NONE);
     writer->SetDataMode(
-      this->GetUseCompression() ? vtkXMLWriter::Appended : vtkXMLWriter::Ascii);
+      useCompression ? vtkXMLWriter::Appended : vtkXMLWriter::Ascii);
 
     // Write coordinate system space (RAS) to field data
     // In the future (when Slicer switches to VTK8) array metadata may be used instead of separate field data.
@@ -586,7 +740,7 @@ int vtkMRMLModelStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
       }
     else
       {
-      vtkWarningToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLModelStorageNode::WriteDataInternal",
+      vtkWarningToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLModelStorageNode::WriteMeshToFile",
         "Failed to write model " << (this->ID ? this->ID : "(unknown)")
         << ": 'space' field already exists, cannot write coordinate system name into file");
       }
@@ -607,7 +761,7 @@ int vtkMRMLModelStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     vtkNew<vtkSTLWriter> writer;
     this->GetUserMessages()->SetObservedObject(writer);
     writer->SetFileName(fullName.c_str());
-    writer->SetFileType(this->GetUseCompression() ? VTK_BINARY : VTK_ASCII );
+    writer->SetFileType(useCompression ? VTK_BINARY : VTK_ASCII );
     triangulator->SetInputData(meshToWrite);
     writer->SetInputConnection(triangulator->GetOutputPort());
     std::string header = std::string("3D Slicer output. ") + coordinateSytemSpecification;
@@ -628,7 +782,7 @@ int vtkMRMLModelStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     vtkNew<vtkPLYWriter> writer;
     this->GetUserMessages()->SetObservedObject(writer);
     writer->SetFileName(fullName.c_str());
-    writer->SetFileType(this->GetUseCompression() ? VTK_BINARY : VTK_ASCII );
+    writer->SetFileType(useCompression ? VTK_BINARY : VTK_ASCII );
     // VTK's PLY writer can save RGB or RGBA unsigned char color array.
     // If we find such an array then we configure the writer to include that array.
     if (meshToWrite->GetPointData())
@@ -671,13 +825,30 @@ int vtkMRMLModelStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
       }
     this->GetUserMessages()->SetObservedObject(nullptr);
     }
+  else if (extension == ".bmesh")
+    {
+    vtkPolyData* polyDataToWrite = vtkPolyData::SafeDownCast(meshToWrite);
+    std::string errorMessage;
+    if (!polyDataToWrite)
+      {
+      vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLModelStorageNode::WriteMeshToFile",
+        "Failed to write model " << (this->ID ? this->ID : "(unknown)")
+        << ": binary mesh file format can only store polydata");
+      success = false;
+      }
+    else if (!vtkMRMLBinaryMeshIO::WritePolyData(fullName, polyDataToWrite, coordinateSystem, errorMessage))
+      {
+      vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLModelStorageNode::WriteMeshToFile",
+        "Failed to write model " << (this->ID ? this->ID : "(unknown)") << ": " << errorMessage);
+      success = false;
+      }
+    }
   else if (extension == ".obj")
     {
     vtkNew<vtkPolyDataMapper> mapper;
     mapper->SetInputData(vtkPolyData::SafeDownCast(meshToWrite));
     vtkNew<vtkActor> actor;
     actor->SetMapper(mapper.GetPointer());
-    vtkMRMLDisplayNode* displayNode = modelNode->GetDisplayNode();
     if (displayNode)
       {
       double color[3] = { 0.5, 0.5, 0.5 };
@@ -720,7 +891,7 @@ int vtkMRMLModelStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     }
   else
     {
-    vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLModelStorageNode::WriteDataInternal",
+    vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLModelStorageNode::WriteMeshToFile",
       "Failed to write model " << (this->ID ? this->ID : "(unknown)")
       << ": No file extension recognized : " << fullName.c_str());
     }
@@ -730,7 +901,7 @@ int vtkMRMLModelStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
   if (success && this->GetUserMessages()->GetNumberOfMessagesOfType(vtkCommand::ErrorEvent)==0
     && !vtksys::SystemTools::FileExists(fullName))
     {
-    vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLModelStorageNode::WriteDataInternal",
+    vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLModelStorageNode::WriteMeshToFile",
       "Failed to write model " << (this->ID ? this->ID : "(unknown)")
       << ": Output file " << fullName.c_str() << " has not been created.");
     success = false;
@@ -753,6 +924,7 @@ void vtkMRMLModelStorageNode::InitializeSupportedReadFileTypes()
   this->SupportedReadFileTypes->InsertNextValue("PLY (.ply)");
   this->SupportedReadFileTypes->InsertNextValue("UCD (.ucd)");
   this->SupportedReadFileTypes->InsertNextValue("Wavefront OBJ (.obj)");
+  this->SupportedReadFileTypes->InsertNextValue("Binary mesh (.bmesh)");
 }
 
 //----------------------------------------------------------------------------
@@ -770,6 +942,7 @@ void vtkMRMLModelStorageNode::InitializeSupportedWriteFileTypes()
     this->SupportedWriteFileTypes->InsertNextValue("STL (.stl)");
     this->SupportedWriteFileTypes->InsertNextValue("PLY (.ply)");
     this->SupportedWriteFileTypes->InsertNextValue("Wavefront OBJ (.obj)");
+    this->SupportedWriteFileTypes->InsertNextValue("Binary mesh (.bmesh)");
     }
   if (!modelNode || modelNode->GetMeshType() == vtkMRMLModelNode::UnstructuredGridMeshType)
     {
@@ -17,9 +17,13 @@
 
 #include "vtkMRMLStorageNode.h"
 
+class vtkMRMLDisplayNode;
 class vtkMRMLModelNode;
 class vtkPointSet;
 
+// VTK includes
+#include <vtkSmartPointer.h>
+
 /// \brief MRML node for model storage on disk.
 ///
 /// Storage nodes has methods to read/write vtkPolyData to/from disk.
@@ -55,6 +59,19 @@ public:
   /// between RAS and LPS coordinate system.
   static void ConvertBetweenRASAndLPS(vtkPointSet* inputMesh, vtkPointSet* outputMesh);
 
+  /// Return true if the model file can be read in a worker thread by PrefetchData().
+  bool CanPrefetchData(vtkMRMLNode* refNode) override;
+
+  /// Release the mesh that was read by PrefetchData() but not used by ReadData().
+  void ClearPrefetchedData() override;
+
+  /// Return true if the model can be written in a worker thread by WriteSnapshotData().
+  /// All formats are supported, except OBJ, which is written using a render window.
+  bool CanWriteDataAsynchronously(vtkMRMLNode* refNode) override;
+
+  /// Release the mesh that was captured by SnapshotData() but not written.
+  void ClearSnapshotData() override;
+
 protected:
   vtkMRMLModelStorageNode();
   ~vtkMRMLModelStorageNode() override;
@@ -73,14 +90,45 @@ protected:
   /// Read data and set it in the referenced node
   int ReadDataInternal(vtkMRMLNode *refNode) override;
 
+  /// Read the mesh from file without setting it in the referenced node
+  int PrefetchDataInternal(vtkMRMLNode *refNode) override;
+
   /// Write data from a  referenced node
   int WriteDataInternal(vtkMRMLNode *refNode) override;
 
+  /// Shallow copy the mesh of the referenced node
+  int SnapshotDataInternal(vtkMRMLNode *refNode) override;
+
+  /// Write the mesh that was captured by SnapshotDataInternal()
+  int WriteSnapshotDataInternal() override;
+
+  /// Write mesh (in RAS coordinate system) to file, in the specified coordinate system.
+  /// Display node is only used for writing OBJ files. Writing OBJ files updates the
+  /// file name list, therefore only the other formats may be written from a worker thread.
+  int WriteMeshToFile(const std::string& fullName, vtkPointSet* meshInRAS,
+    int coordinateSystem, bool useCompression, vtkMRMLDisplayNode* displayNode);
+
+  /// Read mesh from file and convert it to RAS coordinate system.
+  /// Coordinate system specified in the file header is returned in coordinateSystemInFileHeader
+  /// (-1 if not specified). It does not modify the model node, therefore it is safe to
+  /// call it from a worker thread.
+  int ReadMeshFromFile(const std::string& fullName, vtkSmartPointer<vtkPointSet>& meshInRAS,
+    int& coordinateSystemInFileHeader);
+
   static int GetCoordinateSystemFromFileHeader(const char* header);
 
   static int GetCoordinateSystemFromFieldData(vtkPointSet* mesh);
 
   int CoordinateSystem;
+
+  vtkSmartPointer<vtkPointSet> PrefetchedMesh;
+  std::string PrefetchedFileName;
+  int PrefetchedCoordinateSystemInFileHeader;
+
+  vtkSmartPointer<vtkPointSet> SnapshotMesh;
+  std::string SnapshotFileName;
+  int SnapshotCoordinateSystem;
+  bool SnapshotUseCompression;
 };
 
 #endif
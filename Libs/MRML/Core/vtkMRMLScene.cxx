@@ -867,6 +867,14 @@ int vtkMRMLScene::Import(vtkMRMLMessageCollection* userMessagesInput/*=nullptr*/
 
     this->InvokeEvent(vtkMRMLScene::NewSceneEvent, nullptr);
 
+    // Read local data files of independent nodes concurrently. The data is
+    // only set in the nodes below, by UpdateScene, in the order of the nodes
+    // in the scene.
+    if (this->GetDataIOManager())
+      {
+      this->GetDataIOManager()->PrefetchData(addedNodes);
+      }
+
     // Notify the imported nodes about that all nodes are created
     // (so the observers can be attached to referenced nodes, etc.)
     // by calling UpdateScene on each node
@@ -893,6 +901,12 @@ int vtkMRMLScene::Import(vtkMRMLMessageCollection* userMessagesInput/*=nullptr*/
         }
       }
 
+    // Release data that was prefetched but not read (e.g., reading failed before the file was used)
+    if (this->GetDataIOManager())
+      {
+      this->GetDataIOManager()->ClearPrefetchedData(addedNodes);
+      }
+
     this->Modified();
     this->RemoveUnusedNodeReferences();
 #ifdef MRMLSCENE_VERBOSE
@@ -4234,6 +4248,8 @@ bool vtkMRMLScene::SaveSceneToSlicerDataBundleDirectory(const char* sdbDir,
 
   bool success = true;
   std::map<std::string, vtkMRMLNode *> storableNodes;
+  // nodes that are written in background threads
+  std::vector<vtkMRMLStorableNode*> queuedNodes;
   int numNodes = this->GetNumberOfNodes();
   for (int i = 0; i < numNodes; ++i)
     {
@@ -4249,7 +4265,7 @@ bool vtkMRMLScene::SaveSceneToSlicerDataBundleDirectory(const char* sdbDir,
       // get all storable nodes in the main scene
       // and store them in the map by ID to avoid duplicates for the scene views
       vtkMRMLStorableNode* storableNode = vtkMRMLStorableNode::SafeDownCast(mrmlNode);
-      if (!this->SaveStorableNodeToSlicerDataBundleDirectory(storableNode, dataDir, originalStorageNodeFileNames, userMessages))
+      if (!this->SaveStorableNodeToSlicerDataBundleDirectory(storableNode, dataDir, originalStorageNodeFileNames, userMessages, &queuedNodes))
         {
         success = false;
         }
@@ -4316,6 +4332,12 @@ bool vtkMRMLScene::SaveSceneToSlicerDataBundleDirectory(const char* sdbDir,
       }
     }
 
+  // all data files must be written before the scene is written
+  if (!this->FinishStorableNodeWrites(queuedNodes, userMessages))
+    {
+    success = false;
+    }
+
   // write the scene to disk, changes paths to relative
   vtkDebugMacro("calling commit on the scene, to url " << this->GetURL());
   this->Commit(nullptr, userMessages);
@@ -4501,7 +4523,8 @@ std::string vtkMRMLScene::CreateUniqueFileName(const std::string& filename, cons
 
 //----------------------------------------------------------------------------
 bool vtkMRMLScene::SaveStorableNodeToSlicerDataBundleDirectory(vtkMRMLStorableNode* storableNode, std::string &dataDir,
-  std::map<vtkMRMLStorageNode*, std::vector<std::string> > &originalStorageNodeFileNames, vtkMRMLMessageCollection* userMessages)
+  std::map<vtkMRMLStorageNode*, std::vector<std::string> > &originalStorageNodeFileNames, vtkMRMLMessageCollection* userMessages,
+  std::vector<vtkMRMLStorableNode*>* queuedNodes/*=nullptr*/)
 {
   if (!storableNode || !storableNode->GetSaveWithScene())
     {
@@ -4575,6 +4598,17 @@ bool vtkMRMLScene::SaveStorableNodeToSlicerDataBundleDirectory(vtkMRMLStorableNo
     }
 
   storageNode->GetUserMessages()->ClearMessages();
+  if (queuedNodes && this->DataIOManager
+    && this->DataIOManager->GetEnableAsynchronousLocalWrite()
+    && storageNode->CanWriteDataAsynchronously(storableNode))
+    {
+    // the file name is captured now, the file is written in a background thread
+    if (this->DataIOManager->QueueLocalWrite(storableNode, storageNode) > 0)
+      {
+      queuedNodes->push_back(storableNode);
+      return true;
+      }
+    }
   int success = storageNode->WriteData(storableNode);
   if (userMessages)
     {
@@ -4585,6 +4619,37 @@ bool vtkMRMLScene::SaveStorableNodeToSlicerDataBundleDirectory(vtkMRMLStorableNo
   return success;
  }
 
+//----------------------------------------------------------------------------
+bool vtkMRMLScene::FinishStorableNodeWrites(std::vector<vtkMRMLStorableNode*>& queuedNodes, vtkMRMLMessageCollection* userMessages)
+{
+  if (queuedNodes.empty() || !this->DataIOManager)
+    {
+    return true;
+    }
+  this->DataIOManager->FinishLocalWrites();
+  bool success = true;
+  for (vtkMRMLStorableNode* storableNode : queuedNodes)
+    {
+    vtkMRMLStorageNode* storageNode = storableNode->GetStorageNode();
+    if (!storageNode)
+      {
+      continue;
+      }
+    if (storageNode->GetUserMessages()->GetNumberOfMessagesOfType(vtkCommand::ErrorEvent) > 0)
+      {
+      success = false;
+      }
+    if (userMessages)
+      {
+      std::string messagePrefix = std::string(storableNode->GetName() ? storableNode->GetName() : "unknown") + " ("
+        + (storableNode->GetID() ? storableNode->GetID() : "none") + "): ";
+      userMessages->AddMessages(storageNode->GetUserMessages(), messagePrefix);
+      }
+    }
+  queuedNodes.clear();
+  return success;
+}
+
 //----------------------------------------------------------------------------
 std::string vtkMRMLScene::PercentEncode(std::string s)
 {
@@ -911,8 +911,22 @@ protected:
   /// Returns true on success (written successfully or no need to write the node).
   /// If userMessages is not nullptr then the method may add messages to it about issues
   /// encountered during the operation.
+  /// If queuedNodes is not nullptr then the node may be written in a background thread
+  /// (see vtkDataIOManager::QueueLocalWrite()) and it is added to queuedNodes. The caller
+  /// must then call FinishStorableNodeWrites() before the files are used.
   bool SaveStorableNodeToSlicerDataBundleDirectory(vtkMRMLStorableNode* storableNode, std::string& dataDir,
-    std::map<vtkMRMLStorageNode*, std::vector<std::string> > &originalStorageNodeFileNames, vtkMRMLMessageCollection* userMessages);
+    std::map<vtkMRMLStorageNode*, std::vector<std::string> > &originalStorageNodeFileNames, vtkMRMLMessageCollection* userMessages,
+    std::vector<vtkMRMLStorableNode*>* queuedNodes = nullptr);
+
+  /// Wait until the nodes that were queued by SaveStorableNodeToSlicerDataBundleDirectory()
+  /// are written. Returns true if all nodes were written successfully.
+  /// This blocks the calling thread: saving a data bundle is synchronous, because the
+  /// scene file is written, the file names are restored and the MRB archive is created
+  /// from the files right after. Only the files of the nodes are written concurrently.
+  /// Callers that must not block (such as the Save Data dialog) write the nodes by
+  /// vtkDataIOManager::QueueLocalWrite() and observe vtkDataIOManager::LocalWritesFinishedEvent.
+  /// Messages of the storage nodes are added to userMessages (if not nullptr).
+  bool FinishStorableNodeWrites(std::vector<vtkMRMLStorableNode*>& queuedNodes, vtkMRMLMessageCollection* userMessages);
 
   vtkCollection*  Nodes;
 
@@ -0,0 +1,55 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkMRMLSequenceItemLoader.h"
+
+//----------------------------------------------------------------------------
+vtkMRMLSequenceItemLoader::vtkMRMLSequenceItemLoader() = default;
+
+//----------------------------------------------------------------------------
+vtkMRMLSequenceItemLoader::~vtkMRMLSequenceItemLoader() = default;
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSequenceItemLoader::ReadItemData(int vtkNotUsed(itemId), vtkDataObject* vtkNotUsed(data))
+{
+  return false;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLNode* vtkMRMLSequenceItemLoader::CreateItemDataNode(int vtkNotUsed(itemId))
+{
+  return nullptr;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLNode* vtkMRMLSequenceItemLoader::GetItemDataNodeTemplate()
+{
+  return nullptr;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSequenceItemLoader::GetItemImageInformation(int vtkNotUsed(itemId), vtkMatrix4x4* vtkNotUsed(ijkToRAS),
+  int vtkNotUsed(dimensions)[3], int& vtkNotUsed(scalarType), int& vtkNotUsed(numberOfComponents))
+{
+  return false;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSequenceItemLoader::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+}
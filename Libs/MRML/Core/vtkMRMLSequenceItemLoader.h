@@ -0,0 +1,87 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkMRMLSequenceItemLoader_h
+#define __vtkMRMLSequenceItemLoader_h
+
+// MRML includes
+#include "vtkMRML.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+class vtkDataObject;
+class vtkMatrix4x4;
+class vtkMRMLNode;
+
+/// \brief Abstract interface for loading content of sequence data nodes on demand.
+///
+/// A sequence node can store data nodes that only contain the lightweight properties
+/// (name, geometry, etc.) of an item. The bulk content of these deferred data nodes
+/// (for example, voxels of a volume) is loaded by the loader when the data node is accessed
+/// and released when it has not been accessed recently.
+/// See vtkMRMLSequenceNode::SetDataNodeDeferred.
+class VTK_MRML_EXPORT vtkMRMLSequenceItemLoader : public vtkObject
+{
+public:
+  vtkTypeMacro(vtkMRMLSequenceItemLoader, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Load content of the item identified by itemId into the data node.
+  /// Returns true on success.
+  virtual bool LoadItem(vtkMRMLNode* dataNode, int itemId) = 0;
+
+  /// Release the content of the data node that was loaded by LoadItem.
+  virtual void UnloadItem(vtkMRMLNode* dataNode) = 0;
+
+  /// Return a value that changes whenever the loaded content of the data node is modified.
+  /// It is used for detecting if a loaded content has been modified and so it must not be released.
+  virtual vtkMTimeType GetItemContentMTime(vtkMRMLNode* dataNode) = 0;
+
+  /// Read content of the item identified by itemId into a data object, without
+  /// modifying any node. It is used for preparing items in background threads,
+  /// therefore implementations must be thread-safe.
+  /// Returns false if reading failed or if it is not supported by the loader (default).
+  virtual bool ReadItemData(int itemId, vtkDataObject* data);
+
+  /// Create a new data node for the item identified by itemId. Only the lightweight
+  /// properties are set, the content is loaded by LoadItem. It is used for creating
+  /// data nodes of compact sequence items (see vtkMRMLSequenceNode::SetCompactItemAtValue).
+  /// The caller is responsible for deleting the returned node.
+  /// Returns nullptr if it is not supported by the loader (default).
+  virtual vtkMRMLNode* CreateItemDataNode(int itemId);
+
+  /// Return the node that the data nodes created by CreateItemDataNode are copied from.
+  /// It allows getting the class and tag name of compact sequence items without creating
+  /// their data nodes. The returned node must not be modified.
+  /// Returns nullptr if it is not supported by the loader (default).
+  virtual vtkMRMLNode* GetItemDataNodeTemplate();
+
+  /// Get geometry and voxel type of a volume item without creating its data node or reading its voxels.
+  /// It is used for writing volume sequences that contain compact items.
+  /// Returns false if the item is not a volume or it is not supported by the loader (default).
+  virtual bool GetItemImageInformation(int itemId, vtkMatrix4x4* ijkToRAS, int dimensions[3],
+    int& scalarType, int& numberOfComponents);
+
+protected:
+  vtkMRMLSequenceItemLoader();
+  ~vtkMRMLSequenceItemLoader() override;
+  vtkMRMLSequenceItemLoader(const vtkMRMLSequenceItemLoader&);
+  void operator=(const vtkMRMLSequenceItemLoader&);
+};
+
+#endif
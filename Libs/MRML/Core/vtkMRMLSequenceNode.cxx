@@ -33,6 +33,7 @@
 #include <vtkTimerLog.h>
 
 // STD includes
+#include <algorithm>
 #include <sstream>
 
 #define SAFE_CHAR_POINTER(unsafeString) ( unsafeString==nullptr?"":unsafeString )
@@ -55,6 +56,23 @@ vtkCxxSetVariableInDataAndStorageNodeMacro(IndexUnit, const std::string&);
 vtkCxxSetVariableInDataAndStorageNodeMacro(IndexType, int);
 vtkCxxSetVariableInDataAndStorageNodeMacro(NumericIndexValueTolerance, double);
 
+namespace
+{
+//----------------------------------------------------------------------------
+std::string GetDataNodeBaseName(vtkMRMLNode* node)
+{
+  if (node->GetAttribute("Sequences.BaseName") != 0)
+    {
+    return node->GetAttribute("Sequences.BaseName");
+    }
+  else if (node->GetName() != 0)
+    {
+    return node->GetName();
+    }
+  return "Data";
+}
+}
+
 //----------------------------------------------------------------------------
 vtkMRMLSequenceNode::vtkMRMLSequenceNode()
 {
@@ -80,6 +98,9 @@ vtkMRMLSequenceNode::~vtkMRMLSequenceNode()
 void vtkMRMLSequenceNode::RemoveAllDataNodes()
 {
   this->IndexEntries.clear();
+  this->DeferredDataNodes.clear();
+  this->LoadedDeferredDataNodes.clear();
+  this->NumberOfCompactItems = 0;
   if (!this->SequenceScene)
     {
     return;
@@ -114,7 +135,13 @@ void vtkMRMLSequenceNode::WriteXML(ostream& of, int nIndent)
       // not the first index, add a separator before adding values
       of << ";";
       }
-    if (indexIt->DataNode==nullptr)
+    if (indexIt->CompactItemLoader)
+      {
+      // Compact items have no data node ID. Data nodes are restored from the sequence file by the
+      // storage node, therefore only a placeholder ID is written (it does not refer to any node).
+      of << "CompactItem" << indexIt->CompactItemId << ":" << indexIt->IndexValue;
+      }
+    else if (indexIt->DataNode==nullptr)
       {
       // If we have a data node ID then store that, it is the most we know about the node that should be there
       if (!indexIt->DataNodeID.empty())
@@ -189,6 +216,7 @@ void vtkMRMLSequenceNode::ReadIndexValues(const std::string& indexText)
   if (!this->IndexEntries.empty())
     {
     this->IndexEntries.clear();
+    this->NumberOfCompactItems = 0;
     modified = true;
     }
 
@@ -204,6 +232,7 @@ void vtkMRMLSequenceNode::ReadIndexValues(const std::string& indexText)
 
       IndexEntryType indexEntry;
       indexEntry.IndexValue=indexValue;
+      indexEntry.NumericIndexValue=atof(indexValue.c_str());
       // The nodes are not read yet, so we can only store the node ID and get the pointer to the node later (in UpdateScene())
       indexEntry.DataNodeID=nodeId;
       indexEntry.DataNode=nullptr;
@@ -244,6 +273,8 @@ void vtkMRMLSequenceNode::Copy(vtkMRMLNode *anode)
     this->SequenceScene->Delete();
     }
   this->SequenceScene=vtkMRMLScene::New();
+  this->DeferredDataNodes.clear();
+  this->LoadedDeferredDataNodes.clear();
 
   // Get data node ID in the target scene from the data node ID in the source scene
   std::map< std::string, std::string > sourceToTargetDataNodeID;
@@ -269,11 +300,22 @@ void vtkMRMLSequenceNode::Copy(vtkMRMLNode *anode)
   bool mapDataNodeIds = !sourceToTargetDataNodeID.empty();
 
   this->IndexEntries.clear();
+  this->NumberOfCompactItems = 0;
   for(std::deque< IndexEntryType >::iterator sourceIndexIt=snode->IndexEntries.begin(); sourceIndexIt!=snode->IndexEntries.end(); ++sourceIndexIt)
     {
     IndexEntryType seqItem;
     seqItem.IndexValue=sourceIndexIt->IndexValue;
+    seqItem.NumericIndexValue=sourceIndexIt->NumericIndexValue;
     seqItem.DataNode = nullptr;
+    if (sourceIndexIt->CompactItemLoader)
+      {
+      // Content of compact items is not modified after it is added, so it can be shared
+      seqItem.CompactItemLoader = sourceIndexIt->CompactItemLoader;
+      seqItem.CompactItemId = sourceIndexIt->CompactItemId;
+      this->IndexEntries.push_back(seqItem);
+      this->NumberOfCompactItems++;
+      continue;
+      }
     if (sourceIndexIt->DataNode!=nullptr)
       {
       std::string targetDataNodeID = sourceToTargetDataNodeID[sourceIndexIt->DataNode->GetID()];
@@ -292,6 +334,33 @@ void vtkMRMLSequenceNode::Copy(vtkMRMLNode *anode)
       }
     this->IndexEntries.push_back(seqItem);
     }
+
+  // Deferred data nodes are copied as they are (unloaded content is not loaded),
+  // the loaders are shared between the source and target sequence.
+  for (std::list< vtkMRMLNode* >::reverse_iterator sourceNodeIt = snode->LoadedDeferredDataNodes.rbegin();
+    sourceNodeIt != snode->LoadedDeferredDataNodes.rend(); ++sourceNodeIt)
+    {
+    const DeferredDataNodeType& sourceDeferred = snode->DeferredDataNodes[*sourceNodeIt];
+    vtkMRMLNode* targetDataNode = this->SequenceScene->GetNodeByID(sourceToTargetDataNodeID[(*sourceNodeIt)->GetID()]);
+    if (targetDataNode)
+      {
+      this->SetDataNodeDeferred(targetDataNode, sourceDeferred.Loader, sourceDeferred.ItemId, true);
+      }
+    }
+  for (std::map< vtkMRMLNode*, DeferredDataNodeType >::iterator sourceDeferredIt = snode->DeferredDataNodes.begin();
+    sourceDeferredIt != snode->DeferredDataNodes.end(); ++sourceDeferredIt)
+    {
+    if (sourceDeferredIt->second.Loaded)
+      {
+      continue;
+      }
+    vtkMRMLNode* targetDataNode = this->SequenceScene->GetNodeByID(sourceToTargetDataNodeID[sourceDeferredIt->first->GetID()]);
+    if (targetDataNode)
+      {
+      this->SetDataNodeDeferred(targetDataNode, sourceDeferredIt->second.Loader, sourceDeferredIt->second.ItemId, false);
+      }
+    }
+
   this->Modified();
   this->StorableModifiedTime.Modified();
 
@@ -310,10 +379,18 @@ void vtkMRMLSequenceNode::CopySequenceIndex(vtkMRMLNode *anode)
   if (this->IndexEntries.size() > 0 || snode->IndexEntries.size() > 0)
     {
     this->IndexEntries.clear();
+    this->NumberOfCompactItems = 0;
     for (std::deque< IndexEntryType >::iterator sourceIndexIt = snode->IndexEntries.begin(); sourceIndexIt != snode->IndexEntries.end(); ++sourceIndexIt)
       {
       IndexEntryType seqItem;
       seqItem.IndexValue = sourceIndexIt->IndexValue;
+      seqItem.NumericIndexValue = sourceIndexIt->NumericIndexValue;
+      if (sourceIndexIt->CompactItemLoader)
+        {
+        seqItem.CompactItemLoader = sourceIndexIt->CompactItemLoader;
+        seqItem.CompactItemId = sourceIndexIt->CompactItemId;
+        this->NumberOfCompactItems++;
+        }
       if (sourceIndexIt->DataNode != nullptr)
         {
         seqItem.DataNodeID = sourceIndexIt->DataNode->GetID();
@@ -341,6 +418,10 @@ void vtkMRMLSequenceNode::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "indexType: " << indexTypeString << "\n";
 
   os << indent << "numericIndexValueTolerance: " << this->NumericIndexValueTolerance << "\n";
+  os << indent << "numberOfDeferredDataNodes: " << this->DeferredDataNodes.size() << "\n";
+  os << indent << "numberOfLoadedDeferredDataNodes: " << this->LoadedDeferredDataNodes.size() << "\n";
+  os << indent << "maximumNumberOfLoadedDeferredDataNodes: " << this->MaximumNumberOfLoadedDeferredDataNodes << "\n";
+  os << indent << "numberOfCompactItems: " << this->NumberOfCompactItems << "\n";
 
   os << indent << "indexValues: ";
   if (this->IndexEntries.empty())
@@ -382,22 +463,51 @@ bool vtkMRMLSequenceNode::UpdateDataNodeAtValue(vtkMRMLNode* node, const std::st
 //----------------------------------------------------------------------------
 int vtkMRMLSequenceNode::GetInsertPosition(const std::string& indexValue)
 {
-  int insertPosition = this->IndexEntries.size();
-  if (this->IndexType == vtkMRMLSequenceNode::NumericIndex && !this->IndexEntries.empty())
+  if (this->IndexType != vtkMRMLSequenceNode::NumericIndex || this->IndexEntries.empty())
     {
-    int itemNumber = this->GetItemNumberFromIndexValue(indexValue, false);
-    double numericIndexValue = atof(indexValue.c_str());
-    double foundNumericIndexValue = atof(this->IndexEntries[itemNumber].IndexValue.c_str());
-    if (numericIndexValue < foundNumericIndexValue) // Deals with case of index value being smaller than any in the sequence and numeric tolerances
-      {
-      insertPosition = itemNumber;
-      }
-    else
+    return this->IndexEntries.size();
+    }
+  double numericIndexValue = atof(indexValue.c_str());
+  if (numericIndexValue >= this->IndexEntries.back().NumericIndexValue)
+    {
+    // Most common case (e.g., recording): appending to the end
+    return this->IndexEntries.size();
+    }
+  // Insert after all items that have index value less than or equal to the new value
+  std::deque< IndexEntryType >::iterator insertIt = std::upper_bound(this->IndexEntries.begin(), this->IndexEntries.end(),
+    numericIndexValue, [](double value, const IndexEntryType& entry) { return value < entry.NumericIndexValue; });
+  return insertIt - this->IndexEntries.begin();
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLSequenceNode::GetOrCreateItemNumber(const std::string& indexValue)
+{
+  double numericIndexValue = atof(indexValue.c_str());
+  int seqItemIndex = -1;
+  if (this->IndexType == vtkMRMLSequenceNode::NumericIndex
+    && (this->IndexEntries.empty()
+      || numericIndexValue > this->IndexEntries.back().NumericIndexValue + this->NumericIndexValueTolerance))
+    {
+    // Fast path for recording: the new item is after all existing items, so it can be appended without searching.
+    seqItemIndex = this->IndexEntries.size();
+    }
+  else
+    {
+    seqItemIndex = this->GetItemNumberFromIndexValue(indexValue);
+    if (seqItemIndex >= 0)
       {
-      insertPosition = itemNumber + 1;
+      // The sequence item exists already
+      return seqItemIndex;
       }
+    seqItemIndex = this->GetInsertPosition(indexValue);
     }
-  return insertPosition;
+  // Create new item
+  IndexEntryType seqItem;
+  seqItem.IndexValue = indexValue;
+  seqItem.NumericIndexValue = numericIndexValue;
+  seqItem.DataNode = nullptr;
+  this->IndexEntries.insert(this->IndexEntries.begin() + seqItemIndex, seqItem);
+  return seqItemIndex;
 }
 
 //----------------------------------------------------------------------------
@@ -413,15 +523,12 @@ vtkMRMLNode* vtkMRMLSequenceNode::SetDataNodeAtValue(vtkMRMLNode* node, const st
   this->GetSequenceScene();
   // Add a copy of the node to the sequence's scene
   vtkMRMLNode* newNode = this->DeepCopyNodeToScene(node, this->SequenceScene);
-  int seqItemIndex = this->GetItemNumberFromIndexValue(indexValue);
-  if (seqItemIndex<0)
+  int seqItemIndex = this->GetOrCreateItemNumber(indexValue);
+  if (this->IndexEntries[seqItemIndex].CompactItemLoader)
     {
-    // The sequence item doesn't exist yet
-    seqItemIndex = GetInsertPosition(indexValue);
-    // Create new item
-    IndexEntryType seqItem;
-    seqItem.IndexValue = indexValue;
-    this->IndexEntries.insert(this->IndexEntries.begin() + seqItemIndex, seqItem);
+    this->IndexEntries[seqItemIndex].CompactItemLoader = nullptr;
+    this->IndexEntries[seqItemIndex].CompactItemId = -1;
+    this->NumberOfCompactItems--;
     }
   this->IndexEntries[seqItemIndex].DataNode = newNode;
   this->IndexEntries[seqItemIndex].DataNodeID.clear();
@@ -445,12 +552,22 @@ void vtkMRMLSequenceNode::RemoveDataNodeAtValue(const std::string& indexValue)
     vtkWarningMacro("vtkMRMLSequenceNode::RemoveDataNodeAtValue: node was not found at index value "<<indexValue);
     return;
     }
+  if (this->IndexEntries[seqItemIndex].CompactItemLoader)
+    {
+    // there is no data node to remove
+    this->IndexEntries.erase(this->IndexEntries.begin()+seqItemIndex);
+    this->NumberOfCompactItems--;
+    this->Modified();
+    this->StorableModifiedTime.Modified();
+    return;
+    }
   if (!this->SequenceScene)
     {
     vtkWarningMacro("vtkMRMLSequenceNode::RemoveDataNodeAtValue: internal scene is already empty");
     return;
     }
   // TODO: remove associated nodes as well (such as storage node)?
+  this->RemoveDeferredDataNode(this->IndexEntries[seqItemIndex].DataNode);
   this->SequenceScene->RemoveNode(this->IndexEntries[seqItemIndex].DataNode);
   this->IndexEntries.erase(this->IndexEntries.begin()+seqItemIndex);
   this->Modified();
@@ -466,61 +583,28 @@ int vtkMRMLSequenceNode::GetItemNumberFromIndexValue(const std::string& indexVal
     return -1;
     }
 
-  // Binary search will be faster for numeric index
+  // Binary search for numeric index
   if (this->IndexType == NumericIndex)
     {
-    int lowerBound = 0;
-    int upperBound = numberOfSeqItems-1;
-
-    // Deal with index values not within the range of index values in the Sequence
     double numericIndexValue = atof(indexValue.c_str());
-    double lowerNumericIndexValue = atof(this->IndexEntries[lowerBound].IndexValue.c_str());
-    double upperNumericIndexValue = atof(this->IndexEntries[upperBound].IndexValue.c_str());
-    if (numericIndexValue <= lowerNumericIndexValue + this->NumericIndexValueTolerance)
-      {
-      if (numericIndexValue < lowerNumericIndexValue - this->NumericIndexValueTolerance && exactMatchRequired)
-        {
-        return -1;
-        }
-      else
-        {
-        return lowerBound;
-        }
-      }
-    if (numericIndexValue >= upperNumericIndexValue - this->NumericIndexValueTolerance)
-      {
-      if (numericIndexValue > upperNumericIndexValue + this->NumericIndexValueTolerance && exactMatchRequired)
-        {
-        return -1;
-        }
-      else
-        {
-        return upperBound;
-        }
-      }
-
-    while (upperBound - lowerBound > 1)
+    // Find the first item that is not smaller than the index value (considering the tolerance)
+    double toleranceLowerBound = numericIndexValue - this->NumericIndexValueTolerance;
+    std::deque< IndexEntryType >::iterator foundIt = std::lower_bound(this->IndexEntries.begin(), this->IndexEntries.end(),
+      toleranceLowerBound, [](const IndexEntryType& entry, double value) { return entry.NumericIndexValue < value; });
+    int foundItemNumber = foundIt - this->IndexEntries.begin();
+    if (foundIt != this->IndexEntries.end()
+      && foundIt->NumericIndexValue <= numericIndexValue + this->NumericIndexValueTolerance)
       {
-      // Note that if middle is equal to either lowerBound or upperBound then upperBound - lowerBound <= 1
-      int middle = int((lowerBound + upperBound)/2);
-      double middleNumericIndexValue = atof(this->IndexEntries[middle].IndexValue.c_str());
-      if (fabs(numericIndexValue - middleNumericIndexValue) <= this->NumericIndexValueTolerance)
-        {
-        return middle;
-        }
-      if (numericIndexValue > middleNumericIndexValue)
-        {
-        lowerBound = middle;
-        }
-      if (numericIndexValue < middleNumericIndexValue)
-        {
-        upperBound = middle;
-        }
+      // exact match (within tolerance)
+      return foundItemNumber;
       }
-    if (!exactMatchRequired)
+    if (exactMatchRequired)
       {
-      return lowerBound;
+      return -1;
       }
+    // Use the item just before the index value. If the index value is smaller than all
+    // index values in the sequence then use the first item.
+    return (foundItemNumber > 0 ? foundItemNumber - 1 : 0);
     }
 
   // Need linear search for non-numeric index
@@ -538,7 +622,7 @@ int vtkMRMLSequenceNode::GetItemNumberFromIndexValue(const std::string& indexVal
 //---------------------------------------------------------------------------
 vtkMRMLNode* vtkMRMLSequenceNode::GetDataNodeAtValue(const std::string& indexValue, bool exactMatchRequired /* =true */)
 {
-  if (!this->SequenceScene)
+  if (!this->SequenceScene && this->NumberOfCompactItems == 0)
     {
     // no data nodes are stored
     return nullptr;
@@ -549,7 +633,7 @@ vtkMRMLNode* vtkMRMLSequenceNode::GetDataNodeAtValue(const std::string& indexVal
     // not found
     return nullptr;
     }
-  return this->IndexEntries[seqItemIndex].DataNode;
+  return this->GetNthDataNode(seqItemIndex);
 }
 
 //---------------------------------------------------------------------------
@@ -590,6 +674,7 @@ bool vtkMRMLSequenceNode::UpdateIndexValue(const std::string& oldIndexValue, con
     }
   // Update the index value
   this->IndexEntries[oldSeqItemIndex].IndexValue = newIndexValue;
+  this->IndexEntries[oldSeqItemIndex].NumericIndexValue = atof(newIndexValue.c_str());
   if (this->IndexType == vtkMRMLSequenceNode::NumericIndex)
     {
     IndexEntryType movingEntry = this->IndexEntries[oldSeqItemIndex];
@@ -612,7 +697,7 @@ std::string vtkMRMLSequenceNode::GetDataNodeClassName()
     return "";
     }
   // All the nodes should be of the same class, so just get the class from the first one
-  vtkMRMLNode* node=this->IndexEntries[0].DataNode;
+  vtkMRMLNode* node=this->GetNthDataNodeOrTemplate(0);
   if (node==nullptr)
     {
     vtkErrorMacro("vtkMRMLSequenceNode::GetDataNodeClassName node is invalid");
@@ -631,7 +716,7 @@ std::string vtkMRMLSequenceNode::GetDataNodeTagName()
     return undefinedReturn;
     }
   // All the nodes should be of the same class, so just get the class from the first one
-  vtkMRMLNode* node=this->IndexEntries[0].DataNode;
+  vtkMRMLNode* node=this->GetNthDataNodeOrTemplate(0);
   if (node==nullptr)
     {
     vtkErrorMacro("vtkMRMLSequenceNode::GetDataNodeClassName node is invalid");
@@ -646,14 +731,40 @@ std::string vtkMRMLSequenceNode::GetDataNodeTagName()
 }
 
 //-----------------------------------------------------------------------------
-vtkMRMLNode* vtkMRMLSequenceNode::GetNthDataNode(int itemNumber)
+vtkMRMLNode* vtkMRMLSequenceNode::GetNthDataNode(int itemNumber, bool loadDeferred /* =true */)
 {
   if (static_cast<int>(this->IndexEntries.size())<=itemNumber)
     {
     vtkErrorMacro("vtkMRMLSequenceNode::GetNthDataNode failed: itemNumber "<<itemNumber<<" is out of range");
     return nullptr;
     }
-  return this->IndexEntries[itemNumber].DataNode;
+  if (!loadDeferred)
+    {
+    // Data nodes of compact items are not created
+    return this->IndexEntries[itemNumber].DataNode;
+    }
+  if (this->IndexEntries[itemNumber].CompactItemLoader)
+    {
+    this->CreateCompactItemDataNode(itemNumber);
+    }
+  vtkMRMLNode* dataNode = this->IndexEntries[itemNumber].DataNode;
+  this->LoadDeferredDataNode(dataNode);
+  return dataNode;
+}
+
+//-----------------------------------------------------------------------------
+vtkMRMLNode* vtkMRMLSequenceNode::GetNthDataNodeOrTemplate(int itemNumber)
+{
+  if (itemNumber < 0 || itemNumber >= static_cast<int>(this->IndexEntries.size()))
+    {
+    return nullptr;
+    }
+  const IndexEntryType& seqItem = this->IndexEntries[itemNumber];
+  if (seqItem.CompactItemLoader)
+    {
+    return seqItem.CompactItemLoader->GetItemDataNodeTemplate();
+    }
+  return seqItem.DataNode;
 }
 
 //-----------------------------------------------------------------------------
@@ -684,13 +795,15 @@ vtkMRMLStorageNode* vtkMRMLSequenceNode::CreateDefaultStorageNode()
 std::string vtkMRMLSequenceNode::GetDefaultStorageNodeClassName(const char* filename /* =nullptr */)
 {
   // No need to create storage node if there are no nodes to store
-  if (this->GetSequenceScene() == nullptr || this->GetSequenceScene()->GetNumberOfNodes() == 0)
+  if (this->NumberOfCompactItems == 0
+    && (this->GetSequenceScene() == nullptr || this->GetSequenceScene()->GetNumberOfNodes() == 0))
     {
     return "";
     }
 
-  // Use specific sequence storage node, if possible
-  vtkMRMLStorableNode* storableNode = vtkMRMLStorableNode::SafeDownCast(this->GetNthDataNode(0));
+  // Use specific sequence storage node, if possible.
+  // Only the class of the data nodes is needed, therefore content is not loaded.
+  vtkMRMLStorableNode* storableNode = vtkMRMLStorableNode::SafeDownCast(this->GetNthDataNodeOrTemplate(0));
   if (storableNode && this->GetScene())
     {
     std::string sequenceStorageNodeClassName = storableNode->GetDefaultSequenceStorageNodeClassName();
@@ -732,7 +845,7 @@ void vtkMRMLSequenceNode::UpdateSequenceIndex()
     }
   for (std::deque< IndexEntryType >::iterator indexIt = this->IndexEntries.begin(); indexIt != this->IndexEntries.end(); ++indexIt)
     {
-    if (indexIt->DataNode == nullptr)
+    if (indexIt->DataNode == nullptr && !indexIt->CompactItemLoader)
       {
       indexIt->DataNode = this->SequenceScene->GetNodeByID(indexIt->DataNodeID);
       if (indexIt->DataNode != nullptr)
@@ -790,15 +903,7 @@ vtkMRMLNode* vtkMRMLSequenceNode::DeepCopyNodeToScene(vtkMRMLNode* source, vtkMR
     vtkGenericWarningMacro("vtkMRMLSequenceNode::DeepCopyNodeToScene failed, invalid node");
     return nullptr;
     }
-  std::string baseName = "Data";
-  if (source->GetAttribute("Sequences.BaseName") != 0)
-    {
-    baseName = source->GetAttribute("Sequences.BaseName");
-    }
-  else if (source->GetName() != 0)
-    {
-    baseName = source->GetName();
-    }
+  std::string baseName = GetDataNodeBaseName(source);
   std::string newNodeName = baseName;
 
   vtkSmartPointer<vtkMRMLNode> target = vtkSmartPointer<vtkMRMLNode>::Take(source->CreateNodeInstance());
@@ -812,3 +917,304 @@ vtkMRMLNode* vtkMRMLSequenceNode::DeepCopyNodeToScene(vtkMRMLNode* source, vtkMR
   vtkMRMLNode* addedTargetNode = scene->AddNode(target);
   return addedTargetNode;
 }
+
+//-----------------------------------------------------------
+void vtkMRMLSequenceNode::SetDataNodeDeferred(vtkMRMLNode* dataNode, vtkMRMLSequenceItemLoader* loader,
+  int itemId, bool loaded /* =false */)
+{
+  if (!dataNode || !loader)
+    {
+    vtkErrorMacro("vtkMRMLSequenceNode::SetDataNodeDeferred failed: invalid data node or loader");
+    return;
+    }
+  this->RemoveDeferredDataNode(dataNode);
+  DeferredDataNodeType& deferred = this->DeferredDataNodes[dataNode];
+  deferred.Loader = loader;
+  deferred.ItemId = itemId;
+  deferred.Loaded = loaded;
+  if (loaded)
+    {
+    deferred.ContentMTime = loader->GetItemContentMTime(dataNode);
+    this->LoadedDeferredDataNodes.push_front(dataNode);
+    this->UnloadDeferredDataNodes(this->MaximumNumberOfLoadedDeferredDataNodes);
+    }
+}
+
+//-----------------------------------------------------------
+vtkMRMLSequenceItemLoader* vtkMRMLSequenceNode::GetDataNodeLoader(vtkMRMLNode* dataNode)
+{
+  std::map< vtkMRMLNode*, DeferredDataNodeType >::iterator deferredIt = this->DeferredDataNodes.find(dataNode);
+  if (deferredIt == this->DeferredDataNodes.end())
+    {
+    return nullptr;
+    }
+  return deferredIt->second.Loader;
+}
+
+//-----------------------------------------------------------
+int vtkMRMLSequenceNode::GetDataNodeItemId(vtkMRMLNode* dataNode)
+{
+  std::map< vtkMRMLNode*, DeferredDataNodeType >::iterator deferredIt = this->DeferredDataNodes.find(dataNode);
+  if (deferredIt == this->DeferredDataNodes.end())
+    {
+    return -1;
+    }
+  return deferredIt->second.ItemId;
+}
+
+//-----------------------------------------------------------
+bool vtkMRMLSequenceNode::IsDataNodeLoaded(vtkMRMLNode* dataNode)
+{
+  std::map< vtkMRMLNode*, DeferredDataNodeType >::iterator deferredIt = this->DeferredDataNodes.find(dataNode);
+  if (deferredIt == this->DeferredDataNodes.end())
+    {
+    return true;
+    }
+  return deferredIt->second.Loaded;
+}
+
+//-----------------------------------------------------------
+bool vtkMRMLSequenceNode::LoadAllDeferredDataNodes()
+{
+  bool success = this->CreateAllCompactItemDataNodes();
+  for (std::map< vtkMRMLNode*, DeferredDataNodeType >::iterator deferredIt = this->DeferredDataNodes.begin();
+    deferredIt != this->DeferredDataNodes.end(); ++deferredIt)
+    {
+    if (deferredIt->second.Loaded)
+      {
+      continue;
+      }
+    if (!deferredIt->second.Loader->LoadItem(deferredIt->first, deferredIt->second.ItemId))
+      {
+      vtkErrorMacro("vtkMRMLSequenceNode::LoadAllDeferredDataNodes: failed to load content of data node "
+        << (deferredIt->first->GetID() ? deferredIt->first->GetID() : "(unknown)"));
+      success = false;
+      }
+    }
+  this->DeferredDataNodes.clear();
+  this->LoadedDeferredDataNodes.clear();
+  return success;
+}
+
+//-----------------------------------------------------------
+int vtkMRMLSequenceNode::GetNumberOfDeferredDataNodes()
+{
+  return static_cast<int>(this->DeferredDataNodes.size());
+}
+
+//-----------------------------------------------------------
+int vtkMRMLSequenceNode::GetNumberOfLoadedDeferredDataNodes()
+{
+  return static_cast<int>(this->LoadedDeferredDataNodes.size());
+}
+
+//-----------------------------------------------------------
+void vtkMRMLSequenceNode::SetMaximumNumberOfLoadedDeferredDataNodes(int maximumNumberOfLoadedDataNodes)
+{
+  maximumNumberOfLoadedDataNodes = std::max(1, maximumNumberOfLoadedDataNodes);
+  if (this->MaximumNumberOfLoadedDeferredDataNodes == maximumNumberOfLoadedDataNodes)
+    {
+    return;
+    }
+  this->MaximumNumberOfLoadedDeferredDataNodes = maximumNumberOfLoadedDataNodes;
+  this->UnloadDeferredDataNodes(this->MaximumNumberOfLoadedDeferredDataNodes);
+  this->Modified();
+}
+
+//-----------------------------------------------------------
+bool vtkMRMLSequenceNode::LoadDeferredDataNode(vtkMRMLNode* dataNode)
+{
+  std::map< vtkMRMLNode*, DeferredDataNodeType >::iterator deferredIt = this->DeferredDataNodes.find(dataNode);
+  if (deferredIt == this->DeferredDataNodes.end())
+    {
+    // not deferred, content is always available
+    return true;
+    }
+  DeferredDataNodeType& deferred = deferredIt->second;
+  if (deferred.Loaded)
+    {
+    // move to the front of the most recently used list
+    std::list< vtkMRMLNode* >::iterator loadedIt = std::find(
+      this->LoadedDeferredDataNodes.begin(), this->LoadedDeferredDataNodes.end(), dataNode);
+    if (loadedIt != this->LoadedDeferredDataNodes.end())
+      {
+      this->LoadedDeferredDataNodes.splice(this->LoadedDeferredDataNodes.begin(), this->LoadedDeferredDataNodes, loadedIt);
+      }
+    return true;
+    }
+  if (!deferred.Loader->LoadItem(dataNode, deferred.ItemId))
+    {
+    vtkErrorMacro("vtkMRMLSequenceNode::LoadDeferredDataNode: failed to load content of item " << deferred.ItemId);
+    return false;
+    }
+  deferred.Loaded = true;
+  deferred.ContentMTime = deferred.Loader->GetItemContentMTime(dataNode);
+  this->LoadedDeferredDataNodes.push_front(dataNode);
+  this->UnloadDeferredDataNodes(this->MaximumNumberOfLoadedDeferredDataNodes);
+  return true;
+}
+
+//-----------------------------------------------------------
+void vtkMRMLSequenceNode::UnloadDeferredDataNodes(int maximumNumberOfLoadedDataNodes)
+{
+  while (static_cast<int>(this->LoadedDeferredDataNodes.size()) > maximumNumberOfLoadedDataNodes)
+    {
+    vtkMRMLNode* dataNode = this->LoadedDeferredDataNodes.back();
+    this->LoadedDeferredDataNodes.pop_back();
+    std::map< vtkMRMLNode*, DeferredDataNodeType >::iterator deferredIt = this->DeferredDataNodes.find(dataNode);
+    if (deferredIt == this->DeferredDataNodes.end())
+      {
+      continue;
+      }
+    if (deferredIt->second.Loader->GetItemContentMTime(dataNode) != deferredIt->second.ContentMTime)
+      {
+      // Content has been modified since loading, keep it in memory
+      this->DeferredDataNodes.erase(deferredIt);
+      continue;
+      }
+    deferredIt->second.Loader->UnloadItem(dataNode);
+    deferredIt->second.Loaded = false;
+    deferredIt->second.ContentMTime = 0;
+    }
+}
+
+//-----------------------------------------------------------
+void vtkMRMLSequenceNode::RemoveDeferredDataNode(vtkMRMLNode* dataNode)
+{
+  std::map< vtkMRMLNode*, DeferredDataNodeType >::iterator deferredIt = this->DeferredDataNodes.find(dataNode);
+  if (deferredIt == this->DeferredDataNodes.end())
+    {
+    return;
+    }
+  if (deferredIt->second.Loaded)
+    {
+    this->LoadedDeferredDataNodes.remove(dataNode);
+    }
+  this->DeferredDataNodes.erase(deferredIt);
+}
+
+//-----------------------------------------------------------
+bool vtkMRMLSequenceNode::SetCompactItemAtValue(const std::string& indexValue, vtkMRMLSequenceItemLoader* loader, int itemId)
+{
+  if (!loader)
+    {
+    vtkErrorMacro("vtkMRMLSequenceNode::SetCompactItemAtValue failed, invalid loader");
+    return false;
+    }
+  MRMLNodeModifyBlocker blocker(this);
+  int seqItemIndex = this->GetOrCreateItemNumber(indexValue);
+  IndexEntryType& seqItem = this->IndexEntries[seqItemIndex];
+  if (seqItem.CompactItemLoader)
+    {
+    this->NumberOfCompactItems--;
+    }
+  else if (seqItem.DataNode)
+    {
+    // Replace existing data node
+    vtkMRMLNode* dataNode = seqItem.DataNode;
+    seqItem.DataNode = nullptr;
+    this->RemoveDeferredDataNode(dataNode);
+    if (this->SequenceScene)
+      {
+      this->SequenceScene->RemoveNode(dataNode);
+      }
+    }
+  seqItem.DataNodeID.clear();
+  seqItem.CompactItemLoader = loader;
+  seqItem.CompactItemId = itemId;
+  this->NumberOfCompactItems++;
+  if (this->GetNumberOfDataNodes() <= 1)
+    {
+    this->SetAttribute("DataNodeClassName", this->GetDataNodeClassName().c_str());
+    }
+  this->Modified();
+  this->StorableModifiedTime.Modified();
+  return true;
+}
+
+//-----------------------------------------------------------
+bool vtkMRMLSequenceNode::IsCompactItem(int itemNumber)
+{
+  if (itemNumber < 0 || itemNumber >= static_cast<int>(this->IndexEntries.size()))
+    {
+    return false;
+    }
+  return this->IndexEntries[itemNumber].CompactItemLoader != nullptr;
+}
+
+//-----------------------------------------------------------
+bool vtkMRMLSequenceNode::CreateAllCompactItemDataNodes()
+{
+  if (this->NumberOfCompactItems == 0)
+    {
+    return true;
+    }
+  bool success = true;
+  int numberOfItems = static_cast<int>(this->IndexEntries.size());
+  for (int itemNumber = 0; itemNumber < numberOfItems; ++itemNumber)
+    {
+    if (this->IndexEntries[itemNumber].CompactItemLoader && !this->CreateCompactItemDataNode(itemNumber))
+      {
+      success = false;
+      }
+    }
+  return success;
+}
+
+//-----------------------------------------------------------
+vtkMRMLSequenceItemLoader* vtkMRMLSequenceNode::GetCompactItemLoader(int itemNumber)
+{
+  if (itemNumber < 0 || itemNumber >= static_cast<int>(this->IndexEntries.size()))
+    {
+    return nullptr;
+    }
+  return this->IndexEntries[itemNumber].CompactItemLoader;
+}
+
+//-----------------------------------------------------------
+int vtkMRMLSequenceNode::GetCompactItemId(int itemNumber)
+{
+  if (itemNumber < 0 || itemNumber >= static_cast<int>(this->IndexEntries.size()))
+    {
+    return -1;
+    }
+  return this->IndexEntries[itemNumber].CompactItemId;
+}
+
+//-----------------------------------------------------------
+vtkMRMLNode* vtkMRMLSequenceNode::CreateCompactItemDataNode(int itemNumber)
+{
+  if (itemNumber < 0 || itemNumber >= static_cast<int>(this->IndexEntries.size()))
+    {
+    vtkErrorMacro("vtkMRMLSequenceNode::CreateCompactItemDataNode failed: itemNumber " << itemNumber << " is out of range");
+    return nullptr;
+    }
+  vtkSmartPointer<vtkMRMLSequenceItemLoader> loader = this->IndexEntries[itemNumber].CompactItemLoader;
+  int itemId = this->IndexEntries[itemNumber].CompactItemId;
+  if (!loader)
+    {
+    return this->IndexEntries[itemNumber].DataNode;
+    }
+  vtkSmartPointer<vtkMRMLNode> dataNode = vtkSmartPointer<vtkMRMLNode>::Take(loader->CreateItemDataNode(itemId));
+  if (!dataNode)
+    {
+    vtkErrorMacro("vtkMRMLSequenceNode::CreateCompactItemDataNode: failed to create data node of item " << itemId);
+    return nullptr;
+    }
+  // Use the same naming as for data nodes added by SetDataNodeAtValue
+  std::string baseName = GetDataNodeBaseName(dataNode);
+  dataNode->SetName(baseName.c_str());
+  dataNode->SetAttribute("Sequences.BaseName", baseName.c_str());
+  vtkMRMLNode* addedDataNode = this->GetSequenceScene()->AddNode(dataNode);
+
+  IndexEntryType& seqItem = this->IndexEntries[itemNumber];
+  seqItem.DataNode = addedDataNode;
+  seqItem.DataNodeID.clear();
+  seqItem.CompactItemLoader = nullptr;
+  seqItem.CompactItemId = -1;
+  this->NumberOfCompactItems--;
+
+  // Content is loaded when the data node is accessed
+  this->SetDataNodeDeferred(addedDataNode, loader, itemId);
+  return addedDataNode;
+}
@@ -21,9 +21,15 @@
 // MRML includes
 #include <vtkMRML.h>
 #include <vtkMRMLStorableNode.h>
+#include "vtkMRMLSequenceItemLoader.h"
+
+// VTK includes
+#include <vtkSmartPointer.h>
 
 // std includes
 #include <deque>
+#include <list>
+#include <map>
 #include <set>
 
 
@@ -43,6 +49,9 @@
 /// Class name of data nodes stored in the sequence is set into the `DataNodeClassName`
 /// node attribute, which may be used for attribute-based filters (for example,
 /// to show only certain type of sequence node in a node selector).
+///
+/// Content of data nodes can be loaded on demand (see SetDataNodeDeferred), which allows
+/// browsing of sequences that would not fit into memory.
 
 class VTK_MRML_EXPORT vtkMRMLSequenceNode : public vtkMRMLStorableNode
 {
@@ -121,8 +130,10 @@ public:
   /// If exact match is not required and index is numeric then the best matching data node is returned.
   vtkMRMLNode* GetDataNodeAtValue(const std::string& indexValue, bool exactMatchRequired = true);
 
-  /// Get the data node corresponding to the n-th index value
-  vtkMRMLNode* GetNthDataNode(int itemNumber);
+  /// Get the data node corresponding to the n-th index value.
+  /// If loadDeferred is false then content of deferred data nodes is not loaded
+  /// and data nodes of compact items are not created (nullptr is returned for compact items).
+  vtkMRMLNode* GetNthDataNode(int itemNumber, bool loadDeferred = true);
 
   /// Index value of n-th data node.
   std::string GetNthIndexValue(int itemNumber);
@@ -160,6 +171,66 @@ public:
   /// Update node IDs in case of node ID conflicts on scene import
   void UpdateScene(vtkMRMLScene *scene) override;
 
+  /// \name Deferred data nodes
+  /// Content of a deferred data node is loaded by its loader when the data node is
+  /// accessed by GetNthDataNode or GetDataNodeAtValue. Only the most recently accessed
+  /// MaximumNumberOfLoadedDeferredDataNodes deferred data nodes are kept loaded, content of
+  /// the others is released. A deferred data node whose content is modified after loading
+  /// is kept in memory and it is no longer deferred.
+  ///@{
+
+  /// Make the content of a data node loaded on demand by the loader.
+  /// itemId identifies the content for the loader. Set loaded to true if the data node
+  /// content is already loaded and it is the same as the content provided by the loader.
+  void SetDataNodeDeferred(vtkMRMLNode* dataNode, vtkMRMLSequenceItemLoader* loader, int itemId, bool loaded = false);
+  /// Return the loader of a deferred data node, nullptr if the data node is not deferred.
+  vtkMRMLSequenceItemLoader* GetDataNodeLoader(vtkMRMLNode* dataNode);
+  /// Return the item ID of a deferred data node, -1 if the data node is not deferred.
+  int GetDataNodeItemId(vtkMRMLNode* dataNode);
+  /// Return false if the data node is deferred and its content is currently not loaded.
+  bool IsDataNodeLoaded(vtkMRMLNode* dataNode);
+  /// Load content of all deferred data nodes and keep them in memory (they are no longer deferred).
+  /// Returns false if content of any of the data nodes could not be loaded.
+  bool LoadAllDeferredDataNodes();
+  /// Return the number of data nodes whose content is loaded on demand.
+  int GetNumberOfDeferredDataNodes();
+  /// Return the number of deferred data nodes whose content is currently loaded.
+  int GetNumberOfLoadedDeferredDataNodes();
+  /// Maximum number of deferred data nodes that are kept loaded. Default is 16.
+  void SetMaximumNumberOfLoadedDeferredDataNodes(int maximumNumberOfLoadedDataNodes);
+  vtkGetMacro(MaximumNumberOfLoadedDeferredDataNodes, int);
+  ///@}
+
+  /// \name Compact items
+  /// A compact item has no data node until it is accessed. When the data node of a compact item
+  /// is needed (for example, by GetNthDataNode or when the sequence is saved in a bundle), it is created
+  /// by the loader and then it becomes a deferred data node. Compact items allow adding many items
+  /// quickly (for example, recording at high rate) without creating a data node for each item.
+  /// Data node class and tag name, scene writing, and volume sequence writing do not create data nodes.
+  ///@{
+
+  /// Add an item that has no data node yet. The data node will be created by
+  /// vtkMRMLSequenceItemLoader::CreateItemDataNode and its content loaded by
+  /// vtkMRMLSequenceItemLoader::LoadItem. If an item already exists at the index value
+  /// then it is replaced. Returns false if the loader is invalid.
+  bool SetCompactItemAtValue(const std::string& indexValue, vtkMRMLSequenceItemLoader* loader, int itemId);
+  /// Return true if the data node of the item has not been created yet.
+  bool IsCompactItem(int itemNumber);
+  /// Return the number of items whose data node has not been created yet.
+  vtkGetMacro(NumberOfCompactItems, int);
+  /// Return the loader of a compact item, nullptr if the item is not compact.
+  vtkMRMLSequenceItemLoader* GetCompactItemLoader(int itemNumber);
+  /// Return the loader item ID of a compact item, -1 if the item is not compact.
+  int GetCompactItemId(int itemNumber);
+  /// Create the data node of a compact item and add it to the sequence scene. Content of the
+  /// data node is not loaded. If the item is not compact then its existing data node is returned.
+  /// Returns nullptr if the data node could not be created.
+  vtkMRMLNode* CreateCompactItemDataNode(int itemNumber);
+  /// Create data nodes of all compact items. Content of the data nodes is not loaded.
+  /// Returns false if any of the data nodes could not be created.
+  bool CreateAllCompactItemDataNodes();
+  ///@}
+
   /// Type of the index. Controls the behavior of sorting, finding, etc.
   /// Additional types may be added in the future, such as tag cloud, two-dimensional index, ...
   enum IndexTypes
@@ -183,11 +254,41 @@ protected:
 
   vtkMRMLNode* DeepCopyNodeToScene(vtkMRMLNode* source, vtkMRMLScene* scene);
 
+  /// Load content of the data node if it is deferred and not loaded yet.
+  /// Returns false if the content could not be loaded.
+  bool LoadDeferredDataNode(vtkMRMLNode* dataNode);
+
+  /// Release content of least recently used deferred data nodes
+  /// so that at most maximumNumberOfLoadedDataNodes remain loaded.
+  void UnloadDeferredDataNodes(int maximumNumberOfLoadedDataNodes);
+
+  /// Stop tracking the data node as deferred (the content is not changed).
+  void RemoveDeferredDataNode(vtkMRMLNode* dataNode);
+
+  /// Get the number of the item at the index value. If no item exists at the index value then
+  /// a new item (without data node) is inserted.
+  int GetOrCreateItemNumber(const std::string& indexValue);
+
+  /// Get the data node of an item, or for compact items the node that their data node would be created from.
+  /// Only the class of the returned node may be used. It does not create data nodes or load content.
+  vtkMRMLNode* GetNthDataNodeOrTemplate(int itemNumber);
+
   struct IndexEntryType
     {
     std::string IndexValue;
+    double NumericIndexValue{0.0}; // IndexValue converted to number, to avoid parsing the string at each comparison
     vtkMRMLNode* DataNode;
     std::string DataNodeID; // only used temporarily, during scene load
+    vtkSmartPointer<vtkMRMLSequenceItemLoader> CompactItemLoader; // only set for compact items
+    int CompactItemId{-1};
+    };
+
+  struct DeferredDataNodeType
+    {
+    vtkSmartPointer<vtkMRMLSequenceItemLoader> Loader;
+    int ItemId{-1};
+    bool Loaded{false};
+    vtkMTimeType ContentMTime{0}; // content modified time right after loading
     };
 
 protected:
@@ -202,8 +303,18 @@ protected:
   /// we need MRML storage nodes, which only work if they refer to a data node in the same scene
   vtkMRMLScene* SequenceScene{0};
 
-  /// List of data items (the scene may contain some more nodes, such as storage nodes)
+  /// List of data items (the scene may contain some more nodes, such as storage nodes).
+  /// If the index is numeric then items are sorted by NumericIndexValue.
   std::deque< IndexEntryType > IndexEntries;
+
+  /// Data nodes whose content is loaded on demand
+  std::map< vtkMRMLNode*, DeferredDataNodeType > DeferredDataNodes;
+  /// Deferred data nodes whose content is loaded, most recently used first
+  std::list< vtkMRMLNode* > LoadedDeferredDataNodes;
+  int MaximumNumberOfLoadedDeferredDataNodes{16};
+
+  /// Number of items that have no data node yet
+  int NumberOfCompactItems{0};
 };
 
 #endif
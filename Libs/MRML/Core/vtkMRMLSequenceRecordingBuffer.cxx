@@ -0,0 +1,300 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLSequenceRecordingBuffer.h"
+#include "vtkMRMLTransformNode.h"
+#include "vtkMRMLVolumeNode.h"
+
+// VTK includes
+#include <vtkAbstractTransform.h>
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkMRMLSequenceRecordingBuffer);
+
+namespace
+{
+/// Voxels are stored in memory blocks of approximately this size
+const vtkTypeUInt64 FrameBlockSize = 16 * 1024 * 1024;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLSequenceRecordingBuffer::vtkMRMLSequenceRecordingBuffer() = default;
+
+//----------------------------------------------------------------------------
+vtkMRMLSequenceRecordingBuffer::~vtkMRMLSequenceRecordingBuffer() = default;
+
+//----------------------------------------------------------------------------
+void vtkMRMLSequenceRecordingBuffer::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfSamples: " << this->GetNumberOfSamples() << "\n";
+  os << indent << "NodeClassName: " << (this->TemplateNode ? this->TemplateNode->GetClassName() : "(none)") << "\n";
+  if (this->RecordingVolume)
+    {
+    os << indent << "ScalarType: " << this->ScalarType << "\n";
+    os << indent << "NumberOfComponents: " << this->NumberOfComponents << "\n";
+    os << indent << "Dimensions: " << this->Dimensions[0] << " " << this->Dimensions[1] << " " << this->Dimensions[2] << "\n";
+    os << indent << "AllocatedFrameMemorySize: " << this->GetAllocatedFrameMemorySize() << "\n";
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSequenceRecordingBuffer::CanRecordNode(vtkMRMLNode* node)
+{
+  vtkMRMLTransformNode* transformNode = vtkMRMLTransformNode::SafeDownCast(node);
+  if (transformNode)
+    {
+    return transformNode->IsLinear();
+    }
+  vtkMRMLVolumeNode* volumeNode = vtkMRMLVolumeNode::SafeDownCast(node);
+  if (volumeNode)
+    {
+    return volumeNode->GetImageData() && volumeNode->GetImageData()->GetPointData()->GetScalars();
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLSequenceRecordingBuffer::AppendSample(vtkMRMLNode* node)
+{
+  if (!vtkMRMLSequenceRecordingBuffer::CanRecordNode(node))
+    {
+    return -1;
+    }
+  if (this->TemplateNode && strcmp(node->GetClassName(), this->TemplateNode->GetClassName()) != 0)
+    {
+    return -1;
+    }
+
+  vtkMRMLVolumeNode* volumeNode = vtkMRMLVolumeNode::SafeDownCast(node);
+  vtkImageData* imageData = (volumeNode ? volumeNode->GetImageData() : nullptr);
+  if (!this->TemplateNode)
+    {
+    // The first sample determines what is stored in the buffer
+    this->TemplateNode = vtkSmartPointer<vtkMRMLNode>::Take(node->CreateNodeInstance());
+    if (volumeNode)
+      {
+      // Voxels are not needed in the template
+      this->TemplateNode->CopyContent(node, false);
+      vtkMRMLVolumeNode::SafeDownCast(this->TemplateNode)->SetAndObserveImageData(nullptr);
+      this->RecordingVolume = true;
+      imageData->GetDimensions(this->Dimensions);
+      this->ScalarType = imageData->GetScalarType();
+      this->NumberOfComponents = imageData->GetNumberOfScalarComponents();
+      this->FrameSize = static_cast<vtkTypeUInt64>(this->Dimensions[0]) * this->Dimensions[1] * this->Dimensions[2]
+        * this->NumberOfComponents * imageData->GetScalarSize();
+      this->FramesPerBlock = static_cast<int>(std::max<vtkTypeUInt64>(1, FrameBlockSize / std::max<vtkTypeUInt64>(1, this->FrameSize)));
+      }
+    else
+      {
+      this->TemplateNode->CopyContent(node);
+      }
+    this->TemplateNode->SetName(node->GetName());
+    }
+
+  vtkNew<vtkMatrix4x4> matrix;
+  if (this->RecordingVolume)
+    {
+    int dimensions[3] = { 0, 0, 0 };
+    imageData->GetDimensions(dimensions);
+    if (dimensions[0] != this->Dimensions[0] || dimensions[1] != this->Dimensions[1] || dimensions[2] != this->Dimensions[2]
+      || imageData->GetScalarType() != this->ScalarType
+      || imageData->GetNumberOfScalarComponents() != this->NumberOfComponents)
+      {
+      return -1;
+      }
+    volumeNode->GetIJKToRASMatrix(matrix);
+
+    std::lock_guard<std::mutex> lock(this->FramesMutex);
+    if (this->NumberOfFrames == static_cast<int>(this->FrameBlocks.size()) * this->FramesPerBlock)
+      {
+      this->FrameBlocks.emplace_back(new unsigned char[this->FramesPerBlock * this->FrameSize]);
+      }
+    memcpy(this->GetFramePointer(this->NumberOfFrames), imageData->GetScalarPointer(), this->FrameSize);
+    this->NumberOfFrames++;
+    }
+  else
+    {
+    vtkMRMLTransformNode::SafeDownCast(node)->GetMatrixTransformToParent(matrix);
+    }
+
+  int itemId = this->GetNumberOfSamples();
+  this->Matrices.insert(this->Matrices.end(), &matrix->Element[0][0], &matrix->Element[0][0] + 16);
+  return itemId;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLSequenceRecordingBuffer::GetNumberOfSamples()
+{
+  return static_cast<int>(this->Matrices.size() / 16);
+}
+
+//----------------------------------------------------------------------------
+vtkTypeUInt64 vtkMRMLSequenceRecordingBuffer::GetAllocatedFrameMemorySize()
+{
+  std::lock_guard<std::mutex> lock(this->FramesMutex);
+  return this->FrameBlocks.size() * this->FramesPerBlock * this->FrameSize;
+}
+
+//----------------------------------------------------------------------------
+unsigned char* vtkMRMLSequenceRecordingBuffer::GetFramePointer(int itemId)
+{
+  return this->FrameBlocks[itemId / this->FramesPerBlock].get()
+    + static_cast<vtkTypeUInt64>(itemId % this->FramesPerBlock) * this->FrameSize;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLNode* vtkMRMLSequenceRecordingBuffer::CreateItemDataNode(int itemId)
+{
+  if (!this->TemplateNode || itemId < 0 || itemId >= this->GetNumberOfSamples())
+    {
+    vtkErrorMacro("CreateItemDataNode failed: invalid item " << itemId);
+    return nullptr;
+    }
+  vtkMRMLNode* dataNode = this->TemplateNode->CreateNodeInstance();
+  dataNode->CopyContent(this->TemplateNode);
+  dataNode->SetName(this->TemplateNode->GetName());
+  // Geometry is set now, as it is needed even if voxels are not loaded
+  vtkNew<vtkMatrix4x4> matrix;
+  matrix->DeepCopy(&this->Matrices[16 * itemId]);
+  if (this->RecordingVolume)
+    {
+    vtkMRMLVolumeNode::SafeDownCast(dataNode)->SetIJKToRASMatrix(matrix);
+    }
+  else
+    {
+    vtkMRMLTransformNode::SafeDownCast(dataNode)->SetMatrixTransformToParent(matrix);
+    }
+  return dataNode;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLNode* vtkMRMLSequenceRecordingBuffer::GetItemDataNodeTemplate()
+{
+  return this->TemplateNode;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSequenceRecordingBuffer::GetItemImageInformation(int itemId, vtkMatrix4x4* ijkToRAS, int dimensions[3],
+  int& scalarType, int& numberOfComponents)
+{
+  if (!this->RecordingVolume || itemId < 0 || itemId >= this->GetNumberOfSamples())
+    {
+    return false;
+    }
+  if (ijkToRAS)
+    {
+    ijkToRAS->DeepCopy(&this->Matrices[16 * itemId]);
+    }
+  for (int i = 0; i < 3; i++)
+    {
+    dimensions[i] = this->Dimensions[i];
+    }
+  scalarType = this->ScalarType;
+  numberOfComponents = this->NumberOfComponents;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSequenceRecordingBuffer::LoadItem(vtkMRMLNode* dataNode, int itemId)
+{
+  if (itemId < 0 || itemId >= this->GetNumberOfSamples())
+    {
+    vtkErrorMacro("LoadItem failed: invalid item " << itemId);
+    return false;
+    }
+  vtkNew<vtkMatrix4x4> matrix;
+  matrix->DeepCopy(&this->Matrices[16 * itemId]);
+  if (!this->RecordingVolume)
+    {
+    vtkMRMLTransformNode* transformNode = vtkMRMLTransformNode::SafeDownCast(dataNode);
+    if (!transformNode)
+      {
+      vtkErrorMacro("LoadItem failed: data node is not a transform node");
+      return false;
+      }
+    transformNode->SetMatrixTransformToParent(matrix);
+    return true;
+    }
+
+  vtkMRMLVolumeNode* volumeNode = vtkMRMLVolumeNode::SafeDownCast(dataNode);
+  if (!volumeNode)
+    {
+    vtkErrorMacro("LoadItem failed: data node is not a volume node");
+    return false;
+    }
+  vtkNew<vtkImageData> imageData;
+  if (!this->ReadItemData(itemId, imageData))
+    {
+    vtkErrorMacro("LoadItem failed: voxels of item " << itemId << " are not available");
+    return false;
+    }
+  volumeNode->SetIJKToRASMatrix(matrix);
+  volumeNode->SetAndObserveImageData(imageData);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSequenceRecordingBuffer::ReadItemData(int itemId, vtkDataObject* data)
+{
+  vtkImageData* imageData = vtkImageData::SafeDownCast(data);
+  if (!imageData || !this->RecordingVolume)
+    {
+    return false;
+    }
+  imageData->SetDimensions(this->Dimensions);
+  imageData->AllocateScalars(this->ScalarType, this->NumberOfComponents);
+  std::lock_guard<std::mutex> lock(this->FramesMutex);
+  if (itemId < 0 || itemId >= this->NumberOfFrames)
+    {
+    // Not reported here: this method may be called from a background thread.
+    return false;
+    }
+  memcpy(imageData->GetScalarPointer(), this->GetFramePointer(itemId), this->FrameSize);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSequenceRecordingBuffer::UnloadItem(vtkMRMLNode* dataNode)
+{
+  vtkMRMLVolumeNode* volumeNode = vtkMRMLVolumeNode::SafeDownCast(dataNode);
+  if (!volumeNode)
+    {
+    return;
+    }
+  volumeNode->SetAndObserveImageData(nullptr);
+}
+
+//----------------------------------------------------------------------------
+vtkMTimeType vtkMRMLSequenceRecordingBuffer::GetItemContentMTime(vtkMRMLNode* dataNode)
+{
+  vtkMRMLVolumeNode* volumeNode = vtkMRMLVolumeNode::SafeDownCast(dataNode);
+  if (volumeNode)
+    {
+    // Modification time is unique, so replacing the image data also changes the returned value
+    return volumeNode->GetImageData() ? volumeNode->GetImageData()->GetMTime() : 0;
+    }
+  vtkMRMLTransformNode* transformNode = vtkMRMLTransformNode::SafeDownCast(dataNode);
+  if (transformNode && transformNode->GetTransformToParent())
+    {
+    return transformNode->GetTransformToParent()->GetMTime();
+    }
+  return 0;
+}
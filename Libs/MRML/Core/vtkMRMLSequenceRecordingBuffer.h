@@ -0,0 +1,112 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#ifndef __vtkMRMLSequenceRecordingBuffer_h
+#define __vtkMRMLSequenceRecordingBuffer_h
+
+// MRML includes
+#include "vtkMRML.h"
+#include "vtkMRMLSequenceItemLoader.h"
+
+// VTK includes
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/// \brief Compact storage of node states recorded into a sequence.
+///
+/// Each sample stores the state of a node without creating a data node:
+/// matrices are appended to a contiguous array of doubles (transform to parent
+/// for linear transforms, IJK to RAS for volumes) and voxels of volumes are copied
+/// into fixed size frame slots of a pooled memory arena, which is allocated in large blocks.
+/// Data nodes are only created when the corresponding sequence item is accessed
+/// (see vtkMRMLSequenceNode::SetCompactItemAtValue).
+///
+/// All samples of a buffer must be from the same kind of node: the first sample
+/// determines the node class and, for volumes, the image extent, scalar type, and
+/// number of components. All other properties of the created data nodes (name,
+/// attributes, etc.) are taken from the first sample.
+class VTK_MRML_EXPORT vtkMRMLSequenceRecordingBuffer : public vtkMRMLSequenceItemLoader
+{
+public:
+  static vtkMRMLSequenceRecordingBuffer *New();
+  vtkTypeMacro(vtkMRMLSequenceRecordingBuffer, vtkMRMLSequenceItemLoader);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Returns true if state of the node can be stored in a recording buffer.
+  /// Linear transform nodes and volume nodes that have image data are supported.
+  static bool CanRecordNode(vtkMRMLNode* node);
+
+  /// Store the current state of the node as a new sample.
+  /// Returns the item ID of the new sample, or -1 if the node cannot be stored in this buffer
+  /// (for example, the node class or image extent is different from the first sample).
+  int AppendSample(vtkMRMLNode* node);
+
+  /// Number of stored samples.
+  int GetNumberOfSamples();
+
+  /// \name Properties of the recorded image frames (only available if volumes are recorded)
+  ///@{
+  vtkGetMacro(ScalarType, int);
+  vtkGetMacro(NumberOfComponents, int);
+  vtkGetVector3Macro(Dimensions, int);
+  /// Size of the memory allocated for storing voxels, in bytes.
+  vtkTypeUInt64 GetAllocatedFrameMemorySize();
+  ///@}
+
+  /// \name Sequence item loader interface
+  /// Item ID is the sample index.
+  ///@{
+  vtkMRMLNode* CreateItemDataNode(int itemId) override;
+  /// The template node has the properties of the first sample, without image data.
+  vtkMRMLNode* GetItemDataNodeTemplate() override;
+  /// Only available if volumes are recorded.
+  bool GetItemImageInformation(int itemId, vtkMatrix4x4* ijkToRAS, int dimensions[3],
+    int& scalarType, int& numberOfComponents) override;
+  bool LoadItem(vtkMRMLNode* dataNode, int itemId) override;
+  /// Voxels of volumes are released. Transform matrices are small, therefore they are kept.
+  void UnloadItem(vtkMRMLNode* dataNode) override;
+  vtkMTimeType GetItemContentMTime(vtkMRMLNode* dataNode) override;
+  /// Data object must be a vtkImageData.
+  bool ReadItemData(int itemId, vtkDataObject* data) override;
+  ///@}
+
+protected:
+  vtkMRMLSequenceRecordingBuffer();
+  ~vtkMRMLSequenceRecordingBuffer() override;
+  vtkMRMLSequenceRecordingBuffer(const vtkMRMLSequenceRecordingBuffer&);
+  void operator=(const vtkMRMLSequenceRecordingBuffer&);
+
+  /// Return address of the voxels of a frame. Must be called with FramesMutex locked.
+  unsigned char* GetFramePointer(int itemId);
+
+  /// Node that all created data nodes are copied from. It does not contain image data.
+  vtkSmartPointer<vtkMRMLNode> TemplateNode;
+  bool RecordingVolume{false};
+
+  /// Matrix of each sample (16 values per sample)
+  std::vector<double> Matrices;
+
+  int ScalarType{VTK_VOID};
+  int NumberOfComponents{0};
+  int Dimensions[3]{0, 0, 0};
+  vtkTypeUInt64 FrameSize{0};
+  int FramesPerBlock{1};
+
+  /// Memory blocks that store voxels of FramesPerBlock frames each.
+  /// Guarded by FramesMutex, because frames may be read from background threads.
+  std::vector< std::unique_ptr<unsigned char[]> > FrameBlocks;
+  int NumberOfFrames{0};
+  std::mutex FramesMutex;
+};
+
+#endif
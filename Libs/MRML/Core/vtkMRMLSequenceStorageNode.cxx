@@ -175,6 +175,8 @@ int vtkMRMLSequenceStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
   bool success = false;
   if (extension == ".mrb")
     {
+    // Content of all data nodes is needed for writing them into the bundle
+    sequenceNode->LoadAllDeferredDataNodes();
     this->ForceUniqueDataNodeFileNames(sequenceNode); // Prevents storable nodes' files from being overwritten due to the same node name
     vtkMRMLScene *sequenceScene=sequenceNode->GetSequenceScene();
 
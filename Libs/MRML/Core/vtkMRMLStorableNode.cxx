@@ -333,7 +333,8 @@ void vtkMRMLStorableNode::UpdateScene(vtkMRMLScene *scene)
         }
       else
         {
-        vtkDebugMacro("UpdateScene: read data called and succeeded reading " << fname.c_str());
+        vtkDebugMacro("UpdateScene: read data called and succeeded reading " << fname.c_str()
+          << " in " << pnode->GetLastReadDataTime() << "s");
         }
       }
     else
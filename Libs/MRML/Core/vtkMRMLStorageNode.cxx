@@ -27,6 +27,7 @@ Version:   $Revision: 1.1.1.1 $
 #include <vtkCommand.h>
 #include <vtkNew.h>
 #include <vtkStringArray.h>
+#include <vtkTimerLog.h>
 #include <vtkURIHandler.h>
 
 // VTKSYS includes
@@ -51,6 +52,9 @@ vtkMRMLStorageNode::vtkMRMLStorageNode()
   this->ReadState = this->Idle;
   this->WriteState = this->Idle;
   this->URIHandler = nullptr;
+  this->PrefetchDataTime = 0.0;
+  this->LastReadDataTime = 0.0;
+  this->LastWriteDataTime = 0.0;
   this->FileNameList.clear();
   this->URIList.clear();
 
@@ -404,6 +408,8 @@ void vtkMRMLStorageNode::PrintSelf(ostream& os, vtkIndent indent)
 
   os << indent << "ReadState:  " << this->GetReadStateAsString() << "\n";
   os << indent << "WriteState: " << this->GetWriteStateAsString() << "\n";
+  os << indent << "LastReadDataTime: " << this->LastReadDataTime << "\n";
+  os << indent << "LastWriteDataTime: " << this->LastWriteDataTime << "\n";
   os << indent << "SupportedWriteFileTypes: \n";
   for(int i=0; i<this->SupportedWriteFileTypes->GetNumberOfTuples(); i++)
     {
@@ -1216,6 +1222,7 @@ int vtkMRMLStorageNode::ReadData(vtkMRMLNode* refNode, bool temporary)
     {
     vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLStorageNode::ReadData",
       "Cannot read data into a null node.");
+    this->ClearPrefetchedData();
     return 0;
     }
 
@@ -1223,17 +1230,20 @@ int vtkMRMLStorageNode::ReadData(vtkMRMLNode* refNode, bool temporary)
     {
     vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLStorageNode::ReadData",
       "Cannot read data into reference node of class " << refNode->GetClassName() << ".");
+    this->ClearPrefetchedData();
     return 0;
     }
 
   // do not read if if we are not in the scene (for example inside snapshot)
   if (!refNode->GetAddToScene())
     {
+    this->ClearPrefetchedData();
     return 0;
     }
 
   if (this->GetScene() && this->GetScene()->GetReadDataOnLoad() == 0)
     {
+    this->ClearPrefetchedData();
     return 0;
     }
 
@@ -1241,6 +1251,7 @@ int vtkMRMLStorageNode::ReadData(vtkMRMLNode* refNode, bool temporary)
     {
     vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLStorageNode::ReadData",
       "Both filename and uri are null.");
+    this->ClearPrefetchedData();
     return 0;
     }
 
@@ -1250,13 +1261,18 @@ int vtkMRMLStorageNode::ReadData(vtkMRMLNode* refNode, bool temporary)
     // remote file download hasn't finished
     vtkWarningToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLStorageNode::ReadData",
       "ReadData: read state is pending, remote download hasn't finished yet");
+    this->ClearPrefetchedData();
     return 0;
     }
   vtkDebugMacro("ReadData: read state is ready, "
     <<  "URI = " << (this->GetURI() == nullptr ? "null" : this->GetURI()) << ", "
     << "filename = " << (this->GetFileName() == nullptr ? "null" : this->GetFileName()));
   vtkMRMLStorableNode* storableNode = vtkMRMLStorableNode::SafeDownCast(refNode);
+  double startTime = vtkTimerLog::GetUniversalTime();
   int success = this->ReadDataInternal(refNode);
+  this->LastReadDataTime = this->PrefetchDataTime + (vtkTimerLog::GetUniversalTime() - startTime);
+  // Prefetched data is only valid for one read
+  this->ClearPrefetchedData();
   if (!success)
     {
     // failed
@@ -1325,7 +1341,9 @@ int vtkMRMLStorageNode::WriteData(vtkMRMLNode* refNode)
     return 0;
     }
 
+  double startTime = vtkTimerLog::GetUniversalTime();
   int success = this->WriteDataInternal(refNode);
+  this->LastWriteDataTime = vtkTimerLog::GetUniversalTime() - startTime;
 
   // If there were error messages, then do not return that we were successful
   if (success
@@ -1350,12 +1368,128 @@ int vtkMRMLStorageNode::ReadDataInternal(vtkMRMLNode* vtkNotUsed(refNode))
   return 0;
 }
 
+//------------------------------------------------------------------------------
+bool vtkMRMLStorageNode::CanPrefetchData(vtkMRMLNode* vtkNotUsed(refNode))
+{
+  return false;
+}
+
+//------------------------------------------------------------------------------
+bool vtkMRMLStorageNode::PrefetchData(vtkMRMLNode* refNode)
+{
+  this->PrefetchDataTime = 0.0;
+  if (refNode == nullptr)
+    {
+    return false;
+    }
+  double startTime = vtkTimerLog::GetUniversalTime();
+  int success = this->PrefetchDataInternal(refNode);
+  this->PrefetchDataTime = vtkTimerLog::GetUniversalTime() - startTime;
+  if (!success)
+    {
+    // ReadData will try again from the file and report the error
+    this->ClearPrefetchedData();
+    }
+  return (success != 0);
+}
+
+//------------------------------------------------------------------------------
+int vtkMRMLStorageNode::PrefetchDataInternal(vtkMRMLNode* vtkNotUsed(refNode))
+{
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLStorageNode::ClearPrefetchedData()
+{
+  this->PrefetchDataTime = 0.0;
+}
+
 //------------------------------------------------------------------------------
 int vtkMRMLStorageNode::WriteDataInternal(vtkMRMLNode* vtkNotUsed(refNode))
 {
   return 0;
 }
 
+//------------------------------------------------------------------------------
+bool vtkMRMLStorageNode::CanWriteDataAsynchronously(vtkMRMLNode* vtkNotUsed(refNode))
+{
+  return false;
+}
+
+//------------------------------------------------------------------------------
+bool vtkMRMLStorageNode::SnapshotData(vtkMRMLNode* refNode)
+{
+  this->ClearSnapshotData();
+  this->WriteState = this->Idle;
+  if (refNode == nullptr)
+    {
+    vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLStorageNode::SnapshotData",
+      "Cannot write " << (this->GetID() ? this->GetID() : "(null)") << ": input node is null");
+    return false;
+    }
+  if (!this->CanWriteFromReferenceNode(refNode))
+    {
+    return false;
+    }
+  if (!this->SnapshotDataInternal(refNode))
+    {
+    this->ClearSnapshotData();
+    return false;
+    }
+  // Any modification of the reference node after this point makes it modified since read
+  this->SnapshotTime.Modified();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+int vtkMRMLStorageNode::WriteSnapshotData()
+{
+  double startTime = vtkTimerLog::GetUniversalTime();
+  int success = this->WriteSnapshotDataInternal();
+  this->LastWriteDataTime = vtkTimerLog::GetUniversalTime() - startTime;
+  this->ClearSnapshotData();
+  return success;
+}
+
+//------------------------------------------------------------------------------
+int vtkMRMLStorageNode::CompleteWriteSnapshotData(vtkMRMLNode* refNode, int success)
+{
+  // If there were error messages, then do not return that we were successful
+  if (success
+      && this->GetUserMessages()
+      && this->GetUserMessages()->GetNumberOfMessagesOfType(vtkCommand::ErrorEvent)>0)
+    {
+    success = 0;
+    }
+
+  if (success && refNode)
+    {
+    this->StageWriteData(refNode);
+    // The file contains the data as it was at the time of the snapshot
+    *this->StoredTime = this->SnapshotTime;
+    }
+
+  return success;
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLStorageNode::ClearSnapshotData()
+{
+}
+
+//------------------------------------------------------------------------------
+int vtkMRMLStorageNode::SnapshotDataInternal(vtkMRMLNode* vtkNotUsed(refNode))
+{
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+int vtkMRMLStorageNode::WriteSnapshotDataInternal()
+{
+  return 0;
+}
+
 //------------------------------------------------------------------------------
 std::string vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(const std::string& filename)
 {
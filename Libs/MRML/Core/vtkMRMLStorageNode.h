@@ -59,6 +59,32 @@ public:
   /// \sa SetFileName(), ReadDataInternal(), GetStoredTime()
   virtual int ReadData(vtkMRMLNode *refNode, bool temporaryFile = false);
 
+  ///
+  /// Return true if the file content can be read by PrefetchData() without
+  /// modifying the reference node. Must be called from the main thread.
+  /// Returns false by default. Subclasses that implement PrefetchDataInternal()
+  /// should reimplement this method.
+  /// \sa PrefetchData()
+  virtual bool CanPrefetchData(vtkMRMLNode* refNode);
+
+  ///
+  /// Read data from  FileName into memory without modifying the reference
+  /// node or the scene. The prefetched data is set in the reference node by the
+  /// next ReadData() call. Unlike ReadData(), this method may be called from a
+  /// worker thread, concurrently for different storage nodes.
+  /// Return true on success.
+  /// \sa CanPrefetchData(), ClearPrefetchedData(), vtkDataIOManager::PrefetchData()
+  bool PrefetchData(vtkMRMLNode* refNode);
+
+  ///
+  /// Release data that was read by PrefetchData() but not used by ReadData().
+  virtual void ClearPrefetchedData();
+
+  ///
+  /// Wall-clock time (in seconds) spent in the last ReadData() call, including
+  /// the time spent in PrefetchData() if the data was prefetched.
+  vtkGetMacro(LastReadDataTime, double);
+
   ///
   /// Write data from a  referenced node
   /// Return 1 on success, 0 on failure.
@@ -66,6 +92,53 @@ public:
   /// \sa WriteDataInternal()
   virtual int WriteData(vtkMRMLNode *refNode);
 
+  ///
+  /// Return true if the data of the reference node can be written to file
+  /// in a worker thread, using SnapshotData() and WriteSnapshotData().
+  /// Must be called from the main thread.
+  /// Returns false by default. Subclasses that implement SnapshotDataInternal()
+  /// and WriteSnapshotDataInternal() should reimplement this method.
+  /// \sa SnapshotData(), vtkDataIOManager::QueueWrite()
+  virtual bool CanWriteDataAsynchronously(vtkMRMLNode* refNode);
+
+  ///
+  /// Capture the data of the reference node and all storage node properties
+  /// needed for writing, so that the data can be written by WriteSnapshotData()
+  /// while the reference node is modified or deleted.
+  /// Bulk data is shallow copied, it is not copied on the main thread: the reference
+  /// node may replace its data objects or arrays while the file is being written, but
+  /// it must not resize or overwrite the shared arrays in place. Modifications after
+  /// the snapshot are detected by CompleteWriteSnapshotData(), which leaves the node
+  /// marked as modified since read, so that it is written again.
+  /// Must be called from the main thread. Return true on success.
+  /// \sa CanWriteDataAsynchronously(), WriteSnapshotData()
+  bool SnapshotData(vtkMRMLNode* refNode);
+
+  ///
+  /// Write the data captured by SnapshotData() to file.
+  /// Unlike WriteData(), this method may be called from a worker thread,
+  /// concurrently for different storage nodes. It does not invoke any events.
+  /// The snapshot is released after writing.
+  /// Return 1 on success, 0 on failure.
+  /// \sa CompleteWriteSnapshotData()
+  int WriteSnapshotData();
+
+  ///
+  /// Finalize an asynchronous write on the main thread: update the stored time
+  /// and write state the same way as WriteData() does.
+  /// success is the value returned by WriteSnapshotData().
+  /// Return 1 on success, 0 on failure.
+  int CompleteWriteSnapshotData(vtkMRMLNode* refNode, int success);
+
+  ///
+  /// Release data that was captured by SnapshotData() but not written.
+  virtual void ClearSnapshotData();
+
+  ///
+  /// Wall-clock time (in seconds) spent in the last WriteData() or
+  /// WriteSnapshotData() call.
+  vtkGetMacro(LastWriteDataTime, double);
+
   ///
   /// Write this node's information to a MRML file in XML format.
   void WriteXML(ostream& of, int indent) override;
@@ -386,11 +459,27 @@ protected:
   /// To be reimplemented in subclass.
   virtual int ReadDataInternal(vtkMRMLNode* refNode);
 
+  /// Reads the file content into member variables of the storage node.
+  /// Must not modify the reference node or the scene.
+  /// Returns 0 by default (prefetch not supported).
+  /// To be reimplemented in subclass, along with CanPrefetchData().
+  virtual int PrefetchDataInternal(vtkMRMLNode* refNode);
+
   /// Does the actual writing. Returns 1 on success, 0 otherwise.
   /// Returns 0 by default (write not supported).
   /// To be reimplemented in subclass.
   virtual int WriteDataInternal(vtkMRMLNode* refNode);
 
+  /// Captures the data of the reference node into member variables of the storage node.
+  /// Returns 0 by default (asynchronous write not supported).
+  /// To be reimplemented in subclass, along with CanWriteDataAsynchronously().
+  virtual int SnapshotDataInternal(vtkMRMLNode* refNode);
+
+  /// Writes the data captured by SnapshotDataInternal() to file.
+  /// Must not access the reference node or the scene.
+  /// Returns 0 by default (asynchronous write not supported).
+  virtual int WriteSnapshotDataInternal();
+
   ///
   /// If the URI is not null, fetch it and save it to the node's FileName location or
   /// load directly into the reference node.
@@ -410,6 +499,11 @@ protected:
   int WriteState;
   std::string CompressionParameter;
   std::vector<CompressionPreset> CompressionPresets;
+  double PrefetchDataTime;
+  double LastReadDataTime;
+  double LastWriteDataTime;
+  /// Time when the data was captured by SnapshotData().
+  vtkTimeStamp SnapshotTime;
 
   ///
   /// An array of file names, should contain the FileName but may not
@@ -30,18 +30,22 @@ Version:   $Revision: 1.14 $
 #include <vtkCommand.h>
 #include <vtkCollection.h>
 #include <vtkCollectionIterator.h>
+#include <vtkDataArray.h>
 #include <vtkGeneralTransform.h>
 #include <vtkImageData.h>
 #include <vtkLinearTransform.h>
+#include <vtkMath.h>
 #include <vtkHomogeneousTransform.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPoints.h>
+#include <vtkSMPTools.h>
 #include <vtkThinPlateSplineTransform.h>
 #include <vtkTransform.h>
 #include <vtksys/SystemTools.hxx>
 
 // STD includes
+#include <set>
 #include <sstream>
 #include <stack>
 
@@ -57,6 +61,11 @@ vtkMRMLTransformNode::vtkMRMLTransformNode()
 
   this->CachedMatrixTransformToParent=vtkMatrix4x4::New();
   this->CachedMatrixTransformFromParent=vtkMatrix4x4::New();
+  this->CachedLinearTransformToWorld=vtkTransform::New();
+  this->CachedGeneralTransformToWorld=vtkGeneralTransform::New();
+  this->CachedTransformToWorldLinear=true;
+  this->CachedTransformToWorldMTime=0;
+  this->CachedTransformToWorldValid=false;
 
   this->ContentModifiedEvents->InsertNextValue(vtkMRMLTransformableNode::TransformModifiedEvent);
 
@@ -73,6 +82,10 @@ vtkMRMLTransformNode::~vtkMRMLTransformNode()
   this->CachedMatrixTransformToParent=nullptr;
   this->CachedMatrixTransformFromParent->Delete();
   this->CachedMatrixTransformFromParent=nullptr;
+  this->CachedLinearTransformToWorld->Delete();
+  this->CachedLinearTransformToWorld=nullptr;
+  this->CachedGeneralTransformToWorld->Delete();
+  this->CachedGeneralTransformToWorld=nullptr;
 }
 
 //----------------------------------------------------------------------------
@@ -291,6 +304,102 @@ int vtkMRMLTransformNode::DeepCopyTransform(vtkAbstractTransform* dst, vtkAbstra
   return 1;
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLTransformNode::TransformPoints(vtkAbstractTransform* transform, vtkPoints* inPoints, vtkPoints* outPoints)
+{
+  vtkMRMLTransformNode::TransformPointsNormalsVectors(transform, inPoints, outPoints, nullptr, nullptr, nullptr, nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLTransformNode::TransformPointsNormalsVectors(vtkAbstractTransform* transform,
+  vtkPoints* inPoints, vtkPoints* outPoints,
+  vtkDataArray* inNormals, vtkDataArray* outNormals,
+  vtkDataArray* inVectors, vtkDataArray* outVectors)
+{
+  if (!transform || !inPoints || !outPoints)
+    {
+    vtkGenericWarningMacro("vtkMRMLTransformNode::TransformPointsNormalsVectors failed: invalid transform or points");
+    return;
+    }
+  if (inPoints == outPoints)
+    {
+    vtkGenericWarningMacro("vtkMRMLTransformNode::TransformPointsNormalsVectors failed: in-place transformation is not supported");
+    return;
+    }
+  if (!inNormals || !outNormals)
+    {
+    inNormals = nullptr;
+    outNormals = nullptr;
+    }
+  if (!inVectors || !outVectors)
+    {
+    inVectors = nullptr;
+    outVectors = nullptr;
+    }
+
+  vtkIdType numberOfPoints = inPoints->GetNumberOfPoints();
+  outPoints->SetNumberOfPoints(numberOfPoints);
+  if (outNormals)
+    {
+    outNormals->SetNumberOfComponents(3);
+    outNormals->SetNumberOfTuples(numberOfPoints);
+    }
+  if (outVectors)
+    {
+    outVectors->SetNumberOfComponents(3);
+    outVectors->SetNumberOfTuples(numberOfPoints);
+    }
+
+  // Update the transform (and all concatenated transforms) on this thread,
+  // so that only the thread-safe Internal... methods are called from the worker threads.
+  transform->Update();
+
+  vtkSMPTools::For(0, numberOfPoints, [&](vtkIdType begin, vtkIdType end)
+    {
+    double point[3] = { 0.0, 0.0, 0.0 };
+    double transformedPoint[3] = { 0.0, 0.0, 0.0 };
+    double derivative[3][3];
+    double tuple[3] = { 0.0, 0.0, 0.0 };
+    for (vtkIdType pointId = begin; pointId < end; ++pointId)
+      {
+      inPoints->GetPoint(pointId, point);
+      if (!outNormals && !outVectors)
+        {
+        transform->InternalTransformPoint(point, transformedPoint);
+        outPoints->SetPoint(pointId, transformedPoint);
+        continue;
+        }
+      transform->InternalTransformDerivative(point, transformedPoint, derivative);
+      outPoints->SetPoint(pointId, transformedPoint);
+      if (outVectors)
+        {
+        inVectors->GetTuple(pointId, tuple);
+        vtkMath::Multiply3x3(derivative, tuple, tuple);
+        outVectors->SetTuple(pointId, tuple);
+        }
+      if (outNormals)
+        {
+        // Normals are transformed by the inverse transpose of the derivative
+        inNormals->GetTuple(pointId, tuple);
+        vtkMath::Transpose3x3(derivative, derivative);
+        vtkMath::LinearSolve3x3(derivative, tuple, tuple);
+        vtkMath::Normalize(tuple);
+        outNormals->SetTuple(pointId, tuple);
+        }
+      }
+    });
+
+  outPoints->Modified();
+  if (outNormals)
+    {
+    outNormals->Modified();
+    }
+  if (outVectors)
+    {
+    outVectors->Modified();
+    }
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLTransformNode::CopyContent(vtkMRMLNode* anode, bool deepCopy/*=true*/)
 {
@@ -396,6 +505,12 @@ vtkAbstractTransform* vtkMRMLTransformNode::GetTransformToParent()
     }
 }
 
+//----------------------------------------------------------------------------
+vtkAbstractTransform* vtkMRMLTransformNode::GetTransformToParentForEvaluation()
+{
+  return this->GetTransformToParent();
+}
+
 //----------------------------------------------------------------------------
 vtkAbstractTransform* vtkMRMLTransformNode::GetTransformFromParent()
 {
@@ -416,15 +531,109 @@ vtkAbstractTransform* vtkMRMLTransformNode::GetTransformFromParent()
 //----------------------------------------------------------------------------
 int  vtkMRMLTransformNode::IsTransformToWorldLinear()
 {
+  this->UpdateCachedTransformToWorld();
+  return this->CachedTransformToWorldLinear ? 1 : 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLTransformNode::UpdateCachedTransformToWorld()
+{
+  // Walking through the chain is much faster than composing the transforms,
+  // so the chain is only composed again if it is different from the cached one.
+  std::vector<std::pair<vtkMRMLTransformNode*, vtkAbstractTransform*> > chain;
+  vtkMTimeType latestMTime = 0;
+  bool loopDetected = false;
+  // If the number of transforms exceeds the max depth threshold, then begin to search
+  // for duplicate transform nodes to ensure that the transform nodes don't contain a loop.
+  // See issue https://github.com/Slicer/Slicer/issues/6355.
+  const size_t maxDepth = 100;
+  std::set<vtkMRMLTransformNode*> visitedTransformNodes;
   for (vtkMRMLTransformNode* current = this; current != nullptr; current = current->GetParentTransformNode())
     {
-    if (!current->IsLinear())
+    vtkAbstractTransform* transformToParent = current->GetTransformToParentForEvaluation();
+    if (transformToParent && transformToParent->GetMTime() > latestMTime)
       {
-      return 0;
+      latestMTime = transformToParent->GetMTime();
+      }
+    chain.emplace_back(current, transformToParent);
+    if (chain.size() > maxDepth && !visitedTransformNodes.insert(current).second)
+      {
+      vtkWarningMacro("vtkMRMLTransformNode::UpdateCachedTransformToWorld: Loop detected between transform nodes");
+      loopDetected = true;
+      break;
       }
     }
-  // not found non-linear transform component, therefore it's a linear transform
-  return 1;
+
+  if (this->CachedTransformToWorldValid && !loopDetected
+    && latestMTime == this->CachedTransformToWorldMTime
+    && chain == this->CachedTransformToWorldChain)
+    {
+    // no change
+    return;
+    }
+
+  // Collapse consecutive linear transforms into a single matrix.
+  // Transforms are concatenated from bottom to top, from this node to world.
+  this->CachedGeneralTransformToWorld->Identity();
+  this->CachedGeneralTransformToWorld->PostMultiply();
+  vtkNew<vtkMatrix4x4> linearSegmentMatrix;
+  bool linearSegmentIdentity = true;
+  bool allLinear = true;
+  vtkNew<vtkTransform> linearTransform;
+  for (const auto& nodeAndTransform : chain)
+    {
+    if (loopDetected || !nodeAndTransform.second)
+      {
+      // loop is treated as identity transform, as in GetTransformBetweenNodes
+      continue;
+      }
+    if (nodeAndTransform.first->IsLinear()
+      && vtkMRMLTransformNode::IsGeneralTransformLinear(nodeAndTransform.second, linearTransform))
+      {
+      vtkMatrix4x4::Multiply4x4(linearTransform->GetMatrix(), linearSegmentMatrix, linearSegmentMatrix);
+      linearSegmentIdentity = false;
+      continue;
+      }
+    if (!linearSegmentIdentity)
+      {
+      this->CachedGeneralTransformToWorld->Concatenate(linearSegmentMatrix);
+      linearSegmentMatrix->Identity();
+      linearSegmentIdentity = true;
+      }
+    this->CachedGeneralTransformToWorld->Concatenate(nodeAndTransform.second);
+    allLinear = false;
+    }
+  if (allLinear)
+    {
+    this->CachedLinearTransformToWorld->SetMatrix(linearSegmentMatrix);
+    }
+  else if (!linearSegmentIdentity)
+    {
+    this->CachedGeneralTransformToWorld->Concatenate(linearSegmentMatrix);
+    }
+
+  this->CachedTransformToWorldLinear = allLinear;
+  this->CachedTransformToWorldMTime = latestMTime;
+  this->CachedTransformToWorldChain = chain;
+  // If a loop was detected then check again the next time
+  this->CachedTransformToWorldValid = !loopDetected;
+}
+
+//----------------------------------------------------------------------------
+vtkAbstractTransform* vtkMRMLTransformNode::GetCachedTransformToWorld()
+{
+  this->UpdateCachedTransformToWorld();
+  if (this->CachedTransformToWorldLinear)
+    {
+    return this->CachedLinearTransformToWorld;
+    }
+  return this->CachedGeneralTransformToWorld;
+}
+
+//----------------------------------------------------------------------------
+vtkAbstractTransform* vtkMRMLTransformNode::GetCachedTransformFromWorld()
+{
+  return this->GetCachedTransformToWorld()->GetInverse();
 }
 
 //----------------------------------------------------------------------------
@@ -539,7 +748,7 @@ void vtkMRMLTransformNode::GetTransformBetweenNodes(vtkMRMLTransformNode* source
     // traverse the transform tree from bottom to top, from sourceNode to targetNode
     for (vtkMRMLTransformNode* current = sourceNode; current != targetNode; current = current->GetParentTransformNode())
       {
-      vtkAbstractTransform* transformToParent=current->GetTransformToParent();
+      vtkAbstractTransform* transformToParent=current->GetTransformToParentForEvaluation();
       if (transformToParent)
         {
         transformSourceToTarget->Concatenate(transformToParent);
@@ -561,7 +770,7 @@ void vtkMRMLTransformNode::GetTransformBetweenNodes(vtkMRMLTransformNode* source
     // traverse the transform tree from bottom to top, from targetNode to sourceNode
     for (vtkMRMLTransformNode* current = targetNode; current != sourceNode; current = current->GetParentTransformNode())
       {
-      vtkAbstractTransform* transformToParent=current->GetTransformToParent();
+      vtkAbstractTransform* transformToParent=current->GetTransformToParentForEvaluation();
       if (transformToParent)
         {
         transformSourceToTarget->Concatenate(transformToParent);
@@ -944,6 +1153,18 @@ int  vtkMRMLTransformNode::GetMatrixTransformBetweenNodes(vtkMRMLTransformNode*
     return 1;
     }
 
+  // Fast path: use the cached matrix if one of the nodes is the world
+  if (targetNode == nullptr && sourceNode->IsTransformToWorldLinear())
+    {
+    transformSourceToTarget->DeepCopy(sourceNode->CachedLinearTransformToWorld->GetMatrix());
+    return 1;
+    }
+  if (sourceNode == nullptr && targetNode->IsTransformToWorldLinear())
+    {
+    vtkMatrix4x4::Invert(targetNode->CachedLinearTransformToWorld->GetMatrix(), transformSourceToTarget);
+    return 1;
+    }
+
   if (sourceNode && sourceNode->IsTransformNodeMyParent(targetNode))
     {
     transformSourceToTarget->Identity();
@@ -17,10 +17,16 @@
 
 #include "vtkMRMLDisplayableNode.h"
 
+// STD includes
+#include <utility>
+#include <vector>
+
 class vtkCollection;
 class vtkAbstractTransform;
+class vtkDataArray;
 class vtkGeneralTransform;
 class vtkMatrix4x4;
+class vtkPoints;
 class vtkTransform;
 
 /// \brief MRML node for representing a transformation
@@ -130,6 +136,23 @@ public:
   /// \sa GetTransformBetweenNodes
   void GetTransformFromWorld(vtkGeneralTransform* transformFromWorld);
 
+  ///
+  /// Get the composed transform from this node to world.
+  /// Unlike GetTransformToWorld, the transform is not rebuilt at each call: it is
+  /// cached and only recomputed when any transform in the chain to world or the
+  /// chain itself changes. Consecutive linear transforms in the chain are collapsed
+  /// into a single matrix, so the returned transform is also faster to evaluate.
+  /// If the whole chain is linear then a vtkTransform is returned, otherwise a vtkGeneralTransform.
+  /// The returned object is owned by this node and its content is only updated
+  /// when this method is called again, therefore it should not be stored.
+  /// \sa GetCachedTransformFromWorld, IsTransformToWorldLinear
+  vtkAbstractTransform* GetCachedTransformToWorld();
+
+  ///
+  /// Get the composed transform from world to this node.
+  /// Same as GetCachedTransformToWorld but returns the inverse transform.
+  vtkAbstractTransform* GetCachedTransformFromWorld();
+
   ///
   /// Get concatenated transforms to the specified node.
   /// The method may change the PreMultiply/PostMultiply flag of the transform.
@@ -346,6 +369,25 @@ public:
   /// Returns nonzero on success.
   static int DeepCopyTransform(vtkAbstractTransform* dst, vtkAbstractTransform* src);
 
+  ///
+  /// Transform points using multiple threads.
+  /// Non-linear transforms (grid, B-spline, thin-plate spline, and especially their inverse,
+  /// which is computed iteratively) are evaluated point by point, therefore transforming
+  /// large meshes is much faster if all available cores are used.
+  /// outPoints is resized to have the same number of points as inPoints.
+  static void TransformPoints(vtkAbstractTransform* transform, vtkPoints* inPoints, vtkPoints* outPoints);
+
+  ///
+  /// Transform points, normals, and vectors using multiple threads.
+  /// Normals and vectors are transformed using the derivative of the transform at each point,
+  /// the same way as in vtkAbstractTransform::TransformPointsNormalsVectors.
+  /// Normals and vectors are only computed if both the input and output arrays are specified.
+  /// Output arrays are resized to have the same number of tuples as the number of input points.
+  static void TransformPointsNormalsVectors(vtkAbstractTransform* transform,
+    vtkPoints* inPoints, vtkPoints* outPoints,
+    vtkDataArray* inNormals, vtkDataArray* outNormals,
+    vtkDataArray* inVectors, vtkDataArray* outVectors);
+
   ///
   /// Invert the transform.
   /// Internally it does not perform any actual computation just switches ToParent and FromParent.
@@ -386,6 +428,18 @@ protected:
   /// Sets and observes a transform and deletes the inverse (so that the inverse will be computed automatically)
   virtual void SetAndObserveTransform(vtkAbstractTransform** originalTransformPtr, vtkAbstractTransform** inverseTransformPtr, vtkAbstractTransform *transform);
 
+  ///
+  /// Recompute the cached transform to world if the transform chain has changed.
+  void UpdateCachedTransformToWorld();
+
+  ///
+  /// Get transform to parent that is used for computing transforms between nodes
+  /// (GetTransformToWorld, GetTransformBetweenNodes, GetCachedTransformToWorld, ...).
+  /// By default it is the same as GetTransformToParent(). Derived classes may return
+  /// a different transform object that computes the same transformation faster.
+  /// The returned transform must not be modified.
+  virtual vtkAbstractTransform* GetTransformToParentForEvaluation();
+
   ///
   /// These transforms store the transforms that were set externally.
   /// We use the capability of generic transforms for concatenating and inverting the same
@@ -405,6 +459,17 @@ protected:
   /// GetMatrixTransformToParent and GetMatrixFromParent methods
   vtkMatrix4x4* CachedMatrixTransformToParent;
   vtkMatrix4x4* CachedMatrixTransformFromParent;
+
+  /// Composed transform to world, see GetCachedTransformToWorld.
+  /// CachedLinearTransformToWorld is used if all transforms are linear.
+  vtkTransform* CachedLinearTransformToWorld;
+  vtkGeneralTransform* CachedGeneralTransformToWorld;
+  bool CachedTransformToWorldLinear;
+  /// Latest modification time of the transforms in the chain when the cache was computed
+  vtkMTimeType CachedTransformToWorldMTime;
+  /// Transform nodes and their transforms to parent in the chain when the cache was computed
+  std::vector<std::pair<vtkMRMLTransformNode*, vtkAbstractTransform*> > CachedTransformToWorldChain;
+  bool CachedTransformToWorldValid;
 };
 
 #endif
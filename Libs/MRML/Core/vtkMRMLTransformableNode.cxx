@@ -209,12 +209,8 @@ void vtkMRMLTransformableNode::TransformPointToWorld(const double inLocal[3], do
     return;
     }
 
-  // Get transform
-  vtkNew<vtkGeneralTransform> transformToWorld;
-  tnode->GetTransformToWorld(transformToWorld.GetPointer());
-
-  // Convert coordinates
-  transformToWorld->TransformPoint(inLocal, outWorld);
+  // Convert coordinates (cached transform avoids rebuilding the transform chain for each point)
+  tnode->GetCachedTransformToWorld()->TransformPoint(inLocal, outWorld);
 }
 
 //-----------------------------------------------------------
@@ -230,12 +226,8 @@ void vtkMRMLTransformableNode::TransformPointFromWorld(const double inWorld[3],
     return;
     }
 
-  // Get transform
-  vtkNew<vtkGeneralTransform> transformFromWorld;
-  tnode->GetTransformFromWorld(transformFromWorld.GetPointer());
-
-  // Convert coordinates
-  transformFromWorld->TransformPoint(inWorld, outLocal);
+  // Convert coordinates (cached transform avoids rebuilding the transform chain for each point)
+  tnode->GetCachedTransformFromWorld()->TransformPoint(inWorld, outLocal);
 }
 
 //---------------------------------------------------------------------------
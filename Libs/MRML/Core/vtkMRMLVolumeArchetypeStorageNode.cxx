@@ -39,7 +39,9 @@ Version:   $Revision: 1.6 $
 #include <vtkDataArray.h>
 #include <vtkErrorCode.h>
 #include <vtkImageChangeInformation.h>
+#include <vtkImageData.h>
 #include <vtkMatrix3x3.h>
+#include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkPointData.h>
 #include <vtkSmartPointer.h>
@@ -86,6 +88,8 @@ vtkMRMLVolumeArchetypeStorageNode::vtkMRMLVolumeArchetypeStorageNode()
   this->SingleFile  = 0;
   this->UseOrientationFromFile = 1;
   this->DefaultWriteFileExtension = "nrrd";
+  this->SnapshotVoxelVectorType = vtkMRMLVolumeNode::VoxelVectorTypeUndefined;
+  this->SnapshotUseCompression = true;
 }
 
 //----------------------------------------------------------------------------
@@ -327,96 +331,24 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     return 0;
     }
 
-  vtkSmartPointer<vtkITKArchetypeImageSeriesReader> reader;
-
-  if (refNode->IsA("vtkMRMLVectorVolumeNode"))
-    {
-    reader.TakeReference(this->InstantiateVectorVolumeReader(fullName));
-    }
-  else if (refNode->IsA("vtkMRMLDiffusionTensorVolumeNode"))
-    {
-    reader = vtkSmartPointer<vtkITKArchetypeDiffusionTensorImageReaderFile>::New();
-    reader->SetSingleFile( this->GetSingleFile() );
-    reader->SetUseOrientationFromFile( this->GetUseOrientationFromFile() );
-    }
-  else
-    {
-    reader = vtkSmartPointer<vtkITKArchetypeImageSeriesScalarReader>::New();
-    reader->SetSingleFile( this->GetSingleFile() );
-    reader->SetUseOrientationFromFile( this->GetUseOrientationFromFile() );
-    }
-
-  if (reader.GetPointer() == nullptr)
-    {
-    vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal",
-      "Failed to instantiate a file reader");
-    return 0;
-    }
-
-  reader->AddObserver( vtkCommand::ProgressEvent,  this->MRMLCallbackCommand);
-
   if (volNode->GetImageData())
     {
     volNode->SetAndObserveImageData(nullptr);
     }
 
-  // Set the list of file names on the reader
-  reader->ResetFileNames();
-  reader->SetArchetype(fullName.c_str());
-
-  // Workaround
-  ApplyImageSeriesReaderWorkaround(this, reader, fullName);
-
-  // Center image
-  reader->SetOutputScalarTypeToNative();
-  reader->SetDesiredCoordinateOrientationToNative();
-  if (this->CenterImage)
+  vtkSmartPointer<vtkITKArchetypeImageSeriesReader> reader;
+  if (this->PrefetchedReader && this->PrefetchedFileName == fullName)
     {
-    reader->SetUseNativeOriginOff();
+    // the file has been already read by PrefetchData
+    reader = this->PrefetchedReader;
     }
   else
     {
-    reader->SetUseNativeOriginOn();
-    }
-
-  bool readingWorked = true;
-  std::string errorMessage = "";
-  try
-    {
-    vtkDebugMacro("ReadDataInternal: right before reader update, reader num files = " << reader->GetNumberOfFileNames());
-    reader->Update();
-    if (reader->GetErrorCode() != vtkErrorCode::NoError)
-      {
-      readingWorked = false;
-      errorMessage = std::string(vtkErrorCode::GetStringFromErrorCode(reader->GetErrorCode()));
-      }
-    }
-  catch (itk::ExceptionObject& e)
-    {
-    readingWorked = false;
-    errorMessage = std::string("ITK exception info: error in ") + e.GetLocation() + "\n"
-                                                + e.GetDescription() + "\n";
-    }
-  if (!readingWorked)
-    {
-    std::string reader0thFileName;
-    if (reader->GetFileName(0) != nullptr)
-      {
-      reader0thFileName = std::string("reader 0th file name = ") + std::string(reader->GetFileName(0));
-      }
-    vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal",
-      "Cannot read file as a volume of type " << (refNode ? refNode->GetNodeTagName() : "null")
-      << " [" << "fullName = " << fullName << "]: " << errorMessage << "."
-      << " Number of files listed in the node = " << this->GetNumberOfFileNames() << "."
-      << " File reader says it was able to read " << reader->GetNumberOfFileNames() << " files."
-      << " File reader used the archetype file name of " << reader->GetArchetype() << " [" << reader0thFileName.c_str() << "].");
-    return 0;
+    reader = this->ReadImageFromFile(refNode, fullName, true);
     }
-
-  if (reader->GetOutput() == nullptr || reader->GetOutput()->GetPointData() == nullptr)
+  if (reader.GetPointer() == nullptr)
     {
-    vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal",
-      "Unable to read data from file: " << fullName);
+    // error is already logged
     return 0;
     }
 
@@ -529,6 +461,274 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
   return 1;
 }
 
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkITKArchetypeImageSeriesReader> vtkMRMLVolumeArchetypeStorageNode::ReadImageFromFile(
+  vtkMRMLNode* refNode, const std::string& fullName, bool observeProgress)
+{
+  vtkSmartPointer<vtkITKArchetypeImageSeriesReader> reader;
+
+  if (refNode->IsA("vtkMRMLVectorVolumeNode"))
+    {
+    reader.TakeReference(this->InstantiateVectorVolumeReader(fullName));
+    }
+  else if (refNode->IsA("vtkMRMLDiffusionTensorVolumeNode"))
+    {
+    reader = vtkSmartPointer<vtkITKArchetypeDiffusionTensorImageReaderFile>::New();
+    reader->SetSingleFile( this->GetSingleFile() );
+    reader->SetUseOrientationFromFile( this->GetUseOrientationFromFile() );
+    }
+  else
+    {
+    reader = vtkSmartPointer<vtkITKArchetypeImageSeriesScalarReader>::New();
+    reader->SetSingleFile( this->GetSingleFile() );
+    reader->SetUseOrientationFromFile( this->GetUseOrientationFromFile() );
+    }
+
+  if (reader.GetPointer() == nullptr)
+    {
+    vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLVolumeArchetypeStorageNode::ReadImageFromFile",
+      "Failed to instantiate a file reader");
+    return nullptr;
+    }
+
+  if (observeProgress)
+    {
+    reader->AddObserver( vtkCommand::ProgressEvent,  this->MRMLCallbackCommand);
+    }
+
+  // Set the list of file names on the reader
+  reader->ResetFileNames();
+  reader->SetArchetype(fullName.c_str());
+
+  // Workaround
+  ApplyImageSeriesReaderWorkaround(this, reader, fullName);
+
+  // Center image
+  reader->SetOutputScalarTypeToNative();
+  reader->SetDesiredCoordinateOrientationToNative();
+  if (this->CenterImage)
+    {
+    reader->SetUseNativeOriginOff();
+    }
+  else
+    {
+    reader->SetUseNativeOriginOn();
+    }
+
+  bool readingWorked = true;
+  std::string errorMessage = "";
+  try
+    {
+    vtkDebugMacro("ReadImageFromFile: right before reader update, reader num files = " << reader->GetNumberOfFileNames());
+    reader->Update();
+    if (reader->GetErrorCode() != vtkErrorCode::NoError)
+      {
+      readingWorked = false;
+      errorMessage = std::string(vtkErrorCode::GetStringFromErrorCode(reader->GetErrorCode()));
+      }
+    }
+  catch (itk::ExceptionObject& e)
+    {
+    readingWorked = false;
+    errorMessage = std::string("ITK exception info: error in ") + e.GetLocation() + "\n"
+                                                + e.GetDescription() + "\n";
+    }
+  if (!readingWorked)
+    {
+    std::string reader0thFileName;
+    if (reader->GetFileName(0) != nullptr)
+      {
+      reader0thFileName = std::string("reader 0th file name = ") + std::string(reader->GetFileName(0));
+      }
+    vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLVolumeArchetypeStorageNode::ReadImageFromFile",
+      "Cannot read file as a volume of type " << (refNode ? refNode->GetNodeTagName() : "null")
+      << " [" << "fullName = " << fullName << "]: " << errorMessage << "."
+      << " Number of files listed in the node = " << this->GetNumberOfFileNames() << "."
+      << " File reader says it was able to read " << reader->GetNumberOfFileNames() << " files."
+      << " File reader used the archetype file name of " << reader->GetArchetype() << " [" << reader0thFileName.c_str() << "].");
+    return nullptr;
+    }
+
+  if (reader->GetOutput() == nullptr || reader->GetOutput()->GetPointData() == nullptr)
+    {
+    vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLVolumeArchetypeStorageNode::ReadImageFromFile",
+      "Unable to read data from file: " << fullName);
+    return nullptr;
+    }
+
+  return reader;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVolumeArchetypeStorageNode::CanPrefetchData(vtkMRMLNode* refNode)
+{
+  // Only scalar volumes are prefetched, vector volume readers are instantiated
+  // by probing the file.
+  return refNode
+    && refNode->IsA("vtkMRMLScalarVolumeNode")
+    && !refNode->IsA("vtkMRMLVectorVolumeNode")
+    && !refNode->IsA("vtkMRMLDiffusionTensorVolumeNode")
+    && this->GetWriteState() != SkippedNoData
+    && this->GetURI() == nullptr
+    && this->GetFileName() != nullptr;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeArchetypeStorageNode::PrefetchDataInternal(vtkMRMLNode* refNode)
+{
+  this->PrefetchedReader = nullptr;
+  this->PrefetchedFileName = this->GetFullNameFromFileName();
+  if (this->PrefetchedFileName.empty())
+    {
+    return 0;
+    }
+  // Progress events must not be invoked from a worker thread
+  this->PrefetchedReader = this->ReadImageFromFile(refNode, this->PrefetchedFileName, false);
+  return (this->PrefetchedReader.GetPointer() != nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVolumeArchetypeStorageNode::ClearPrefetchedData()
+{
+  this->Superclass::ClearPrefetchedData();
+  this->PrefetchedReader = nullptr;
+  this->PrefetchedFileName.clear();
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVolumeArchetypeStorageNode::CanWriteDataAsynchronously(vtkMRMLNode* refNode)
+{
+  if (!refNode || !refNode->IsA("vtkMRMLScalarVolumeNode")
+    || this->GetURI() != nullptr || this->GetFileName() == nullptr)
+    {
+    return false;
+    }
+  std::string extension = vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(this->GetFileName());
+  return extension == ".nrrd" || extension == ".nii" || extension == ".nii.gz" || extension == ".mha";
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeArchetypeStorageNode::SnapshotDataInternal(vtkMRMLNode* refNode)
+{
+  vtkMRMLVolumeNode* volNode = vtkMRMLVolumeNode::SafeDownCast(refNode);
+  if (!volNode)
+    {
+    return 0;
+    }
+  if (volNode->GetImageData() == nullptr)
+    {
+    // nothing to write, WriteSnapshotDataInternal will not write anything
+    this->SetWriteStateSkippedNoData();
+    return 1;
+    }
+  this->SnapshotFileName = this->GetFullNameFromFileName();
+  if (this->SnapshotFileName.empty())
+    {
+    vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLVolumeArchetypeStorageNode::SnapshotDataInternal",
+      "File name not specified");
+    return 0;
+    }
+
+  this->SnapshotVoxelVectorType = volNode->GetVoxelVectorType();
+  if (this->SnapshotVoxelVectorType == vtkMRMLVolumeNode::VoxelVectorTypeSpatial)
+    {
+    if (volNode->GetImageData()->GetNumberOfScalarComponents() != 3)
+      {
+      vtkWarningToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLVolumeArchetypeStorageNode::SnapshotDataInternal",
+        "Voxel vector type is spatial but number of scalar components is not 3. Saved vector type will be non-spatial.");
+      }
+    else
+      {
+      std::string extension = vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(this->SnapshotFileName);
+      if (extension != ".nrrd")
+        {
+        vtkWarningToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLVolumeArchetypeStorageNode::SnapshotDataInternal",
+          "Spatial vectors will be written to non-nrrd file format (" << extension << "). In this format, voxels are saved"
+          << " as regular vectors. If the file is imported again then vector axis directions may be flipped."
+          << "\nIt is recommended to save volumes that contain spatial vectors into NRRD file format.");
+        }
+      }
+    }
+
+  // Shallow copy: the voxels are shared with the node, not copied on the main thread.
+  // The snapshot is not modified by the writer, the data IO manager writes the node
+  // again if it was modified after the snapshot was taken.
+  this->SnapshotImageData = vtkSmartPointer<vtkImageData>::New();
+  this->SnapshotImageData->ShallowCopy(volNode->GetImageData());
+  this->SnapshotRASToIJKMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  volNode->GetRASToIJKMatrix(this->SnapshotRASToIJKMatrix);
+  this->SnapshotUseCompression = (this->GetUseCompression() != 0);
+  this->SnapshotImageIOClassName.clear();
+  if (this->WriteFileFormat
+    && this->GetScene()
+    && this->GetScene()->GetDataIOManager()
+    && this->GetScene()->GetDataIOManager()->GetFileFormatHelper())
+    {
+    // the format helper is not thread-safe, resolve the writer class here
+    const char* className = this->GetScene()->GetDataIOManager()->GetFileFormatHelper()->
+      GetClassNameFromFormatString(this->WriteFileFormat);
+    this->SnapshotImageIOClassName = (className ? className : "");
+    }
+
+  // single-file formats, the archetype is the only file
+  this->ResetFileNameList();
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeArchetypeStorageNode::WriteSnapshotDataInternal()
+{
+  if (!this->SnapshotImageData)
+    {
+    // no data to write
+    return 1;
+    }
+  vtkNew<vtkITKImageWriter> writer;
+  vtkSmartPointer<vtkImageData> imageData = this->SnapshotImageData;
+  if (this->SnapshotVoxelVectorType == vtkMRMLVolumeNode::VoxelVectorTypeSpatial
+    && this->SnapshotImageData->GetNumberOfScalarComponents() == 3)
+    {
+    // voxels are shared with the volume node, convert a copy (in this thread)
+    imageData = vtkSmartPointer<vtkImageData>::New();
+    imageData->DeepCopy(this->SnapshotImageData);
+    this->ConvertSpatialVectorVoxelsBetweenRasLps(imageData);
+    }
+  writer->SetFileName(this->SnapshotFileName.c_str());
+  writer->SetInputData(imageData);
+  writer->SetUseCompression(this->SnapshotUseCompression);
+  if (!this->SnapshotImageIOClassName.empty())
+    {
+    writer->SetImageIOClassName(this->SnapshotImageIOClassName.c_str());
+    }
+  writer->SetRasToIJKMatrix(this->SnapshotRASToIJKMatrix);
+  writer->SetVoxelVectorType(ConvertVoxelVectorTypeMRMLToVTKITK(this->SnapshotVoxelVectorType));
+  int result = 1;
+  try
+    {
+    writer->Write();
+    }
+  catch (...)
+    {
+    result = 0;
+    }
+  if (!result)
+    {
+    vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLVolumeArchetypeStorageNode::WriteSnapshotDataInternal",
+      "Failed to write '" << this->SnapshotFileName << "'.");
+    }
+  return result;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVolumeArchetypeStorageNode::ClearSnapshotData()
+{
+  this->Superclass::ClearSnapshotData();
+  this->SnapshotImageData = nullptr;
+  this->SnapshotRASToIJKMatrix = nullptr;
+  this->SnapshotFileName.clear();
+  this->SnapshotImageIOClassName.clear();
+}
+
 //----------------------------------------------------------------------------
 int vtkMRMLVolumeArchetypeStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
 {
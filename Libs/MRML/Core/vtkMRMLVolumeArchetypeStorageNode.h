@@ -19,8 +19,12 @@
 
 class vtkImageData;
 class vtkITKArchetypeImageSeriesReader;
+class vtkMatrix4x4;
 class vtkMRMLVolumeNode;
 
+// VTK includes
+#include <vtkSmartPointer.h>
+
 /// \brief MRML node for representing a volume storage.
 ///
 /// vtkMRMLVolumeArchetypeStorageNode nodes describe the archetybe based volume storage
@@ -92,6 +96,20 @@ public:
   /// using only wrapped types.
   static void SetMetaDataDictionaryFromReader(vtkMRMLVolumeNode*, vtkITKArchetypeImageSeriesReader*);
 
+  /// Return true if the volume file can be read in a worker thread by PrefetchData().
+  bool CanPrefetchData(vtkMRMLNode* refNode) override;
+
+  /// Release the reader output that was read by PrefetchData() but not used by ReadData().
+  void ClearPrefetchedData() override;
+
+  /// Return true if the volume can be written in a worker thread by WriteSnapshotData().
+  /// Only scalar volumes written to single-file formats (NRRD, NIFTI, MetaImage) are supported,
+  /// other formats may need the temporary directory that updates the file list.
+  bool CanWriteDataAsynchronously(vtkMRMLNode* refNode) override;
+
+  /// Release the image that was captured by SnapshotData() but not written.
+  void ClearSnapshotData() override;
+
 protected:
   vtkMRMLVolumeArchetypeStorageNode();
   ~vtkMRMLVolumeArchetypeStorageNode() override;
@@ -108,13 +126,38 @@ protected:
   /// Read data and set it in the referenced node
   int ReadDataInternal(vtkMRMLNode *refNode) override;
 
+  /// Read the image from file without setting it in the referenced node
+  int PrefetchDataInternal(vtkMRMLNode *refNode) override;
+
   /// Write data from a referenced node
   int WriteDataInternal(vtkMRMLNode *refNode) override;
 
+  /// Shallow copy the image and copy the image geometry of the referenced node
+  int SnapshotDataInternal(vtkMRMLNode *refNode) override;
+
+  /// Write the image that was captured by SnapshotDataInternal()
+  int WriteSnapshotDataInternal() override;
+
+  /// Instantiate a reader that is suitable for the referenced node and read the file.
+  /// It does not modify the referenced node, therefore it is safe to call it from a worker thread
+  /// if observeProgress is false.
+  /// Returns nullptr if reading failed.
+  vtkSmartPointer<vtkITKArchetypeImageSeriesReader> ReadImageFromFile(vtkMRMLNode* refNode,
+    const std::string& fullName, bool observeProgress);
+
   int CenterImage;
   int SingleFile;
   int UseOrientationFromFile;
 
+  vtkSmartPointer<vtkITKArchetypeImageSeriesReader> PrefetchedReader;
+  std::string PrefetchedFileName;
+
+  vtkSmartPointer<vtkImageData> SnapshotImageData;
+  vtkSmartPointer<vtkMatrix4x4> SnapshotRASToIJKMatrix;
+  std::string SnapshotFileName;
+  std::string SnapshotImageIOClassName;
+  int SnapshotVoxelVectorType;
+  bool SnapshotUseCompression;
 };
 
 #endif
@@ -0,0 +1,937 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLSequenceNode.h"
+#include "vtkMRMLVolumeNode.h"
+#include "vtkMRMLVolumeSequenceChunkedIO.h"
+
+// vtkAddon includes
+#include <vtkAddonMathUtilities.h>
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+#include <vtkZLibDataCompressor.h>
+
+// VTKSYS includes
+#include <vtksys/FStream.hxx>
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkMRMLVolumeSequenceChunkedIO);
+
+namespace
+{
+
+const char ChunkedSequenceSignature[8] = { 'S', 'L', 'C', 'R', 'V', 'S', 'E', 'Q' };
+const vtkTypeUInt32 ChunkedSequenceVersion = 1;
+const vtkTypeUInt32 ChunkedSequenceByteOrderMark = 0x01020304;
+
+struct FileHeader
+{
+  char Signature[8];
+  vtkTypeUInt32 Version;
+  vtkTypeUInt32 ByteOrderMark;
+  vtkTypeInt32 ScalarType;
+  vtkTypeInt32 NumberOfComponents;
+  vtkTypeInt32 Dimensions[3];
+  vtkTypeUInt32 Reserved1;
+  vtkTypeUInt64 NumberOfFrames;
+  vtkTypeUInt64 MetadataOffset;
+  vtkTypeUInt64 MetadataSize;
+  vtkTypeUInt64 FrameTableOffset;
+  double IJKToRAS[16];
+  char Reserved2[56];
+};
+static_assert(sizeof(FileHeader) == 256, "Unexpected chunked volume sequence file header size");
+
+struct FrameTableEntry
+{
+  vtkTypeUInt64 Offset;
+  vtkTypeUInt64 StoredSize;
+  vtkTypeUInt32 Compressed;
+  vtkTypeUInt32 Reserved;
+};
+static_assert(sizeof(FrameTableEntry) == 24, "Unexpected chunked volume sequence frame table entry size");
+
+/// Deflate cannot compress data by more than about 1:1032, larger ratios indicate a corrupted frame table
+const vtkTypeUInt64 MaximumCompressionRatio = 1032;
+
+//----------------------------------------------------------------------------
+/// Returns the size of the file opened in the stream, or 0 if it cannot be determined.
+/// The read position is moved to the beginning of the file.
+vtkTypeUInt64 GetStreamSize(std::istream& stream)
+{
+  stream.seekg(0, std::ios::end);
+  std::streamoff size = stream.tellg();
+  stream.seekg(0, std::ios::beg);
+  return size > 0 ? static_cast<vtkTypeUInt64>(size) : 0;
+}
+
+//----------------------------------------------------------------------------
+/// Returns true if the block of size bytes starting at offset is within the file (without integer overflow)
+bool IsBlockInFile(vtkTypeUInt64 offset, vtkTypeUInt64 size, vtkTypeUInt64 fileSize)
+{
+  return offset <= fileSize && size <= fileSize - offset;
+}
+
+//----------------------------------------------------------------------------
+/// Compute size of a frame in bytes. Returns false if the size does not fit in an image.
+bool GetFrameSize(const int dimensions[3], int numberOfComponents, int scalarType, vtkTypeUInt64& frameSize)
+{
+  const vtkTypeUInt64 maximumNumberOfValues = static_cast<vtkTypeUInt64>(VTK_ID_MAX);
+  vtkTypeUInt64 numberOfValues = static_cast<vtkTypeUInt64>(numberOfComponents);
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    if (dimensions[axis] > 0 && numberOfValues > maximumNumberOfValues / static_cast<vtkTypeUInt64>(dimensions[axis]))
+      {
+      return false;
+      }
+    numberOfValues *= static_cast<vtkTypeUInt64>(dimensions[axis]);
+    }
+  frameSize = numberOfValues * static_cast<vtkTypeUInt64>(vtkAbstractArray::GetDataTypeSize(scalarType));
+  return true;
+}
+
+//----------------------------------------------------------------------------
+/// Returns true if the frame is within the file and its stored size is consistent with the frame size
+bool IsFrameValid(vtkTypeUInt64 offset, vtkTypeUInt64 storedSize, bool compressed, vtkTypeUInt64 frameSize, vtkTypeUInt64 fileSize)
+{
+  if (!IsBlockInFile(offset, storedSize, fileSize))
+    {
+    return false;
+    }
+  if (!compressed)
+    {
+    return storedSize == frameSize;
+    }
+  return storedSize > 0 && frameSize / MaximumCompressionRatio <= storedSize;
+}
+
+//----------------------------------------------------------------------------
+/// Voxels of a frame, ready to be written to file
+struct FrameToWrite
+{
+  vtkSmartPointer<vtkImageData> ImageData;
+  std::vector<unsigned char> CompressedVoxels;
+  bool Compressed{false};
+};
+
+//----------------------------------------------------------------------------
+void CompressFrame(FrameToWrite& frame, size_t frameSize)
+{
+  const unsigned char* voxels = static_cast<const unsigned char*>(frame.ImageData->GetScalarPointer());
+  vtkNew<vtkZLibDataCompressor> compressor;
+  frame.CompressedVoxels.resize(compressor->GetMaximumCompressionSpace(frameSize));
+  size_t compressedSize = compressor->Compress(voxels, frameSize,
+    frame.CompressedVoxels.data(), frame.CompressedVoxels.size());
+  if (compressedSize == 0 || compressedSize >= frameSize)
+    {
+    // Not compressible, store voxels as is
+    frame.CompressedVoxels.clear();
+    frame.Compressed = false;
+    return;
+    }
+  frame.CompressedVoxels.resize(compressedSize);
+  frame.Compressed = true;
+}
+
+//----------------------------------------------------------------------------
+/// Percent-encode all characters that could interfere with the metadata syntax
+std::string EncodeMetadataValue(const std::string& value)
+{
+  static const char hexDigits[] = "0123456789ABCDEF";
+  std::string encoded;
+  for (unsigned char c : value)
+    {
+    if (c == '%' || c == '=' || c == ' ' || c < 0x20 || c == 0x7F)
+      {
+      encoded += '%';
+      encoded += hexDigits[c >> 4];
+      encoded += hexDigits[c & 0x0F];
+      }
+    else
+      {
+      encoded += static_cast<char>(c);
+      }
+    }
+  return encoded;
+}
+
+//----------------------------------------------------------------------------
+std::string DecodeMetadataValue(const std::string& encoded)
+{
+  std::string value;
+  for (size_t i = 0; i < encoded.size(); ++i)
+    {
+    if (encoded[i] == '%' && i + 2 < encoded.size() && isxdigit(static_cast<unsigned char>(encoded[i + 1]))
+      && isxdigit(static_cast<unsigned char>(encoded[i + 2])))
+      {
+      value += static_cast<char>(std::stoi(encoded.substr(i + 1, 2), nullptr, 16));
+      i += 2;
+      }
+    else
+      {
+      value += encoded[i];
+      }
+    }
+  return value;
+}
+
+//----------------------------------------------------------------------------
+std::string GetMetadataLine(const std::string& key, const std::string& value)
+{
+  return key + "=" + EncodeMetadataValue(value) + "\n";
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkMRMLVolumeSequenceChunkedIO::vtkMRMLVolumeSequenceChunkedIO()
+{
+  vtkMatrix4x4::Identity(this->IJKToRAS);
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLVolumeSequenceChunkedIO::~vtkMRMLVolumeSequenceChunkedIO() = default;
+
+//----------------------------------------------------------------------------
+void vtkMRMLVolumeSequenceChunkedIO::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "FileName: " << this->FileName << "\n";
+  os << indent << "NumberOfFrames: " << this->Frames.size() << "\n";
+  os << indent << "VolumeNodeClassName: " << this->VolumeNodeClassName << "\n";
+  os << indent << "ScalarType: " << this->ScalarType << "\n";
+  os << indent << "NumberOfComponents: " << this->NumberOfComponents << "\n";
+  os << indent << "Dimensions: " << this->Dimensions[0] << " " << this->Dimensions[1] << " " << this->Dimensions[2] << "\n";
+  os << indent << "ItemDataNodeTemplate: " << this->ItemDataNodeTemplate.GetPointer() << "\n";
+  os << indent << "ItemNamePrefix: " << this->ItemNamePrefix << "\n";
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVolumeSequenceChunkedIO::CanReadFile(const std::string& fileName)
+{
+  vtksys::ifstream stream(fileName.c_str(), std::ios::in | std::ios::binary);
+  if (!stream.is_open())
+    {
+    return false;
+    }
+  char signature[sizeof(ChunkedSequenceSignature)] = { 0 };
+  stream.read(signature, sizeof(signature));
+  return stream.good() && memcmp(signature, ChunkedSequenceSignature, sizeof(signature)) == 0;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVolumeSequenceChunkedIO::ReadHeader(const std::string& fileName, std::string& errorMessage)
+{
+  this->FileName.clear();
+  this->IndexValues.clear();
+  this->Attributes.clear();
+  this->Frames.clear();
+
+  vtksys::ifstream stream(fileName.c_str(), std::ios::in | std::ios::binary);
+  if (!stream.is_open())
+    {
+    errorMessage = "Failed to open file " + fileName;
+    return false;
+    }
+
+  vtkTypeUInt64 fileSize = GetStreamSize(stream);
+  FileHeader header;
+  stream.read(reinterpret_cast<char*>(&header), sizeof(FileHeader));
+  if (!stream.good()
+    || memcmp(header.Signature, ChunkedSequenceSignature, sizeof(ChunkedSequenceSignature)) != 0)
+    {
+    errorMessage = "File " + fileName + " is not a chunked volume sequence file";
+    return false;
+    }
+  if (header.Version != ChunkedSequenceVersion)
+    {
+    errorMessage = "Unsupported chunked volume sequence file version in " + fileName;
+    return false;
+    }
+  if (header.ByteOrderMark != ChunkedSequenceByteOrderMark)
+    {
+    errorMessage = "File " + fileName + " was written on a platform with different byte order";
+    return false;
+    }
+  vtkTypeUInt64 frameSize = 0;
+  if (header.NumberOfComponents < 1 || header.Dimensions[0] < 0 || header.Dimensions[1] < 0 || header.Dimensions[2] < 0
+    || vtkAbstractArray::GetDataTypeSize(header.ScalarType) == 0
+    || !GetFrameSize(header.Dimensions, header.NumberOfComponents, header.ScalarType, frameSize))
+    {
+    errorMessage = "Invalid voxel type or dimensions in " + fileName;
+    return false;
+    }
+  // Sizes are checked before allocating memory, so that a corrupted header cannot cause huge allocations
+  if (!IsBlockInFile(header.MetadataOffset, header.MetadataSize, fileSize))
+    {
+    errorMessage = "Invalid metadata size in " + fileName;
+    return false;
+    }
+  if (header.FrameTableOffset > fileSize
+    || header.NumberOfFrames > (fileSize - header.FrameTableOffset) / sizeof(FrameTableEntry))
+    {
+    errorMessage = "Invalid number of frames in " + fileName;
+    return false;
+    }
+
+  // Metadata
+  std::string metadata(header.MetadataSize, '\0');
+  stream.seekg(header.MetadataOffset);
+  stream.read(&metadata[0], static_cast<std::streamsize>(header.MetadataSize));
+  if (!stream.good())
+    {
+    errorMessage = "Failed to read metadata from " + fileName;
+    return false;
+    }
+  std::istringstream metadataStream(metadata);
+  std::string line;
+  while (std::getline(metadataStream, line))
+    {
+    std::size_t separatorPos = line.find('=');
+    if (separatorPos == std::string::npos)
+      {
+      continue;
+      }
+    std::string key = line.substr(0, separatorPos);
+    std::string value = DecodeMetadataValue(line.substr(separatorPos + 1));
+    if (key == "indexValue")
+      {
+      this->IndexValues.push_back(value);
+      }
+    else if (key == "indexName")
+      {
+      this->IndexName = value;
+      }
+    else if (key == "indexUnit")
+      {
+      this->IndexUnit = value;
+      }
+    else if (key == "indexType")
+      {
+      this->IndexType = value;
+      }
+    else if (key == "volumeNodeClassName")
+      {
+      this->VolumeNodeClassName = value;
+      }
+    else if (key == "attribute")
+      {
+      // name and value are separated by the first space (spaces are encoded in both)
+      std::size_t attributeSeparatorPos = value.find(' ');
+      if (attributeSeparatorPos != std::string::npos)
+        {
+        this->Attributes.emplace_back(DecodeMetadataValue(value.substr(0, attributeSeparatorPos)),
+          DecodeMetadataValue(value.substr(attributeSeparatorPos + 1)));
+        }
+      }
+    }
+
+  // Frame table
+  std::vector<FrameTableEntry> frameTable(header.NumberOfFrames);
+  stream.seekg(header.FrameTableOffset);
+  if (header.NumberOfFrames > 0)
+    {
+    stream.read(reinterpret_cast<char*>(frameTable.data()),
+      static_cast<std::streamsize>(header.NumberOfFrames * sizeof(FrameTableEntry)));
+    }
+  if (!stream.good())
+    {
+    errorMessage = "Failed to read frame table from " + fileName;
+    return false;
+    }
+  this->Frames.resize(frameTable.size());
+  for (size_t frameIndex = 0; frameIndex < frameTable.size(); ++frameIndex)
+    {
+    if (!IsFrameValid(frameTable[frameIndex].Offset, frameTable[frameIndex].StoredSize,
+      frameTable[frameIndex].Compressed != 0, frameSize, fileSize))
+      {
+      errorMessage = "Invalid frame table entry in " + fileName;
+      this->Frames.clear();
+      this->IndexValues.clear();
+      return false;
+      }
+    this->Frames[frameIndex].Offset = frameTable[frameIndex].Offset;
+    this->Frames[frameIndex].StoredSize = frameTable[frameIndex].StoredSize;
+    this->Frames[frameIndex].Compressed = (frameTable[frameIndex].Compressed != 0);
+    }
+  if (this->IndexValues.size() != this->Frames.size())
+    {
+    errorMessage = "Number of index values does not match the number of frames in " + fileName;
+    this->Frames.clear();
+    this->IndexValues.clear();
+    return false;
+    }
+
+  this->ScalarType = header.ScalarType;
+  this->NumberOfComponents = header.NumberOfComponents;
+  std::copy(header.Dimensions, header.Dimensions + 3, this->Dimensions);
+  std::copy(header.IJKToRAS, header.IJKToRAS + 16, this->IJKToRAS);
+  this->FileName = fileName;
+  this->Modified();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVolumeSequenceChunkedIO::ReadFrame(int frameIndex, vtkImageData* imageData, std::string& errorMessage)
+{
+  if (!imageData)
+    {
+    errorMessage = "Invalid output image";
+    return false;
+    }
+  if (frameIndex < 0 || frameIndex >= static_cast<int>(this->Frames.size()))
+    {
+    errorMessage = "Frame index is out of range";
+    return false;
+    }
+  const FrameEntry& frame = this->Frames[frameIndex];
+
+  vtksys::ifstream stream(this->FileName.c_str(), std::ios::in | std::ios::binary);
+  if (!stream.is_open())
+    {
+    errorMessage = "Failed to open file " + this->FileName;
+    return false;
+    }
+  // The file may have been replaced since the header was read
+  vtkTypeUInt64 expectedFrameSize = 0;
+  if (!GetFrameSize(this->Dimensions, this->NumberOfComponents, this->ScalarType, expectedFrameSize)
+    || !IsFrameValid(frame.Offset, frame.StoredSize, frame.Compressed, expectedFrameSize, GetStreamSize(stream)))
+    {
+    errorMessage = "Invalid frame offset or size in " + this->FileName;
+    return false;
+    }
+
+  imageData->SetDimensions(this->Dimensions);
+  imageData->SetOrigin(0.0, 0.0, 0.0);
+  imageData->SetSpacing(1.0, 1.0, 1.0);
+  imageData->AllocateScalars(this->ScalarType, this->NumberOfComponents);
+  vtkDataArray* scalars = imageData->GetPointData()->GetScalars();
+  size_t frameSize = static_cast<size_t>(scalars->GetNumberOfValues()) * scalars->GetDataTypeSize();
+  unsigned char* voxels = static_cast<unsigned char*>(scalars->GetVoidPointer(0));
+
+  stream.seekg(frame.Offset);
+  if (!frame.Compressed)
+    {
+    stream.read(reinterpret_cast<char*>(voxels), static_cast<std::streamsize>(frameSize));
+    if (!stream.good())
+      {
+      errorMessage = "Failed to read frame from " + this->FileName;
+      return false;
+      }
+    return true;
+    }
+
+  std::vector<unsigned char> compressedVoxels(frame.StoredSize);
+  stream.read(reinterpret_cast<char*>(compressedVoxels.data()), static_cast<std::streamsize>(frame.StoredSize));
+  if (!stream.good())
+    {
+    errorMessage = "Failed to read frame from " + this->FileName;
+    return false;
+    }
+  vtkNew<vtkZLibDataCompressor> compressor;
+  if (compressor->Uncompress(compressedVoxels.data(), compressedVoxels.size(), voxels, frameSize) != frameSize)
+    {
+    errorMessage = "Failed to decompress frame from " + this->FileName;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVolumeSequenceChunkedIO::WriteSequence(const std::string& fileName, vtkMRMLSequenceNode* sequenceNode,
+  bool useCompression, std::string& errorMessage)
+{
+  if (!sequenceNode)
+    {
+    errorMessage = "Invalid sequence node";
+    return false;
+    }
+  int numberOfFrames = sequenceNode->GetNumberOfDataNodes();
+
+  FileHeader header;
+  memset(&header, 0, sizeof(FileHeader));
+  memcpy(header.Signature, ChunkedSequenceSignature, sizeof(ChunkedSequenceSignature));
+  header.Version = ChunkedSequenceVersion;
+  header.ByteOrderMark = ChunkedSequenceByteOrderMark;
+  header.ScalarType = VTK_UNSIGNED_CHAR;
+  header.NumberOfComponents = 1;
+  header.NumberOfFrames = static_cast<vtkTypeUInt64>(numberOfFrames);
+  vtkMatrix4x4::Identity(header.IJKToRAS);
+
+  // Geometry and voxel type of the first frame (content of the frame is not needed)
+  std::string volumeNodeClassName = "vtkMRMLScalarVolumeNode";
+  vtkNew<vtkMatrix4x4> firstFrameIjkToRas;
+  if (numberOfFrames > 0)
+    {
+    int dimensions[3] = { 0, 0, 0 };
+    int scalarType = VTK_VOID;
+    int numberOfComponents = 0;
+    if (!vtkMRMLVolumeSequenceChunkedIO::GetSequenceItemImageInformation(sequenceNode, 0,
+        firstFrameIjkToRas, dimensions, scalarType, numberOfComponents)
+      || scalarType == VTK_VOID)
+      {
+      errorMessage = "Only volume sequences with image data can be written in this format";
+      return false;
+      }
+    volumeNodeClassName = sequenceNode->GetDataNodeClassName();
+    vtkMatrix4x4::DeepCopy(header.IJKToRAS, firstFrameIjkToRas);
+    for (int i = 0; i < 3; i++)
+      {
+      header.Dimensions[i] = dimensions[i];
+      }
+    header.ScalarType = scalarType;
+    header.NumberOfComponents = numberOfComponents;
+    }
+  size_t frameSize = static_cast<size_t>(header.Dimensions[0]) * header.Dimensions[1] * header.Dimensions[2]
+    * header.NumberOfComponents * vtkAbstractArray::GetDataTypeSize(header.ScalarType);
+
+  // Metadata
+  std::string metadata;
+  metadata += GetMetadataLine("volumeNodeClassName", volumeNodeClassName);
+  metadata += GetMetadataLine("indexName", sequenceNode->GetIndexName());
+  metadata += GetMetadataLine("indexUnit", sequenceNode->GetIndexUnit());
+  metadata += GetMetadataLine("indexType", sequenceNode->GetIndexTypeAsString());
+  for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+    {
+    metadata += GetMetadataLine("indexValue", sequenceNode->GetNthIndexValue(frameIndex));
+    }
+  std::vector<std::string> attributeNames = sequenceNode->GetAttributeNames();
+  for (const std::string& attributeName : attributeNames)
+    {
+    const char* attributeValue = sequenceNode->GetAttribute(attributeName.c_str());
+    metadata += GetMetadataLine("attribute", EncodeMetadataValue(attributeName) + " "
+      + EncodeMetadataValue(attributeValue ? attributeValue : ""));
+    }
+  header.MetadataOffset = sizeof(FileHeader);
+  header.MetadataSize = metadata.size();
+  header.FrameTableOffset = header.MetadataOffset + header.MetadataSize;
+  std::vector<FrameTableEntry> frameTable(numberOfFrames);
+  memset(frameTable.data(), 0, frameTable.size() * sizeof(FrameTableEntry));
+
+  // Write into a temporary file first, then replace the destination file. Frames that are
+  // loaded on demand from the destination file can be still read while the new file is written.
+  std::string temporaryFileName = fileName + ".partial";
+    {
+    vtksys::ofstream stream(temporaryFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!stream.is_open())
+      {
+      errorMessage = "Failed to open file " + temporaryFileName + " for writing";
+      return false;
+      }
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+    stream.write(metadata.data(), static_cast<std::streamsize>(metadata.size()));
+    // Placeholder for the frame table, it is filled after all the frames are written
+    if (!frameTable.empty())
+      {
+      stream.write(reinterpret_cast<const char*>(frameTable.data()),
+        static_cast<std::streamsize>(frameTable.size() * sizeof(FrameTableEntry)));
+      }
+
+    // Frames are processed in batches: voxels are retrieved on this thread (without creating
+    // data nodes of compact items or loading deferred data nodes), then the batch is compressed in parallel.
+    int batchSize = std::max(1, vtkSMPTools::GetEstimatedNumberOfThreads());
+    std::vector<FrameToWrite> batch;
+    for (int batchStart = 0; batchStart < numberOfFrames; batchStart += batchSize)
+      {
+      int batchEnd = std::min(numberOfFrames, batchStart + batchSize);
+      batch.clear();
+      batch.resize(batchEnd - batchStart);
+      for (int frameIndex = batchStart; frameIndex < batchEnd; ++frameIndex)
+        {
+        vtkNew<vtkMatrix4x4> frameIjkToRas;
+        int frameInformationDimensions[3] = { 0, 0, 0 };
+        int frameInformationScalarType = VTK_VOID;
+        int frameInformationNumberOfComponents = 0;
+        vtkSmartPointer<vtkImageData> frameImageData;
+        if (vtkMRMLVolumeSequenceChunkedIO::GetSequenceItemImageInformation(sequenceNode, frameIndex, frameIjkToRas,
+          frameInformationDimensions, frameInformationScalarType, frameInformationNumberOfComponents))
+          {
+          frameImageData = vtkMRMLVolumeSequenceChunkedIO::GetSequenceItemImageData(sequenceNode, frameIndex);
+          }
+        std::stringstream frameErrorMessage;
+        if (!frameImageData || !frameImageData->GetPointData()->GetScalars())
+          {
+          frameErrorMessage << "Frame " << frameIndex << " is not a volume or it does not have image data";
+          }
+        else
+          {
+          int frameDimensions[3] = { 0, 0, 0 };
+          frameImageData->GetDimensions(frameDimensions);
+          if (!vtkAddonMathUtilities::MatrixAreEqual(frameIjkToRas, firstFrameIjkToRas))
+            {
+            frameErrorMessage << "Geometry of frame " << frameIndex << " is different from the first frame";
+            }
+          else if (frameDimensions[0] != header.Dimensions[0] || frameDimensions[1] != header.Dimensions[1]
+            || frameDimensions[2] != header.Dimensions[2]
+            || frameImageData->GetScalarType() != header.ScalarType
+            || frameImageData->GetNumberOfScalarComponents() != header.NumberOfComponents)
+            {
+            frameErrorMessage << "Size or voxel type of frame " << frameIndex << " is different from the first frame";
+            }
+          }
+        if (!frameErrorMessage.str().empty())
+          {
+          errorMessage = frameErrorMessage.str();
+          stream.close();
+          vtksys::SystemTools::RemoveFile(temporaryFileName);
+          return false;
+          }
+        batch[frameIndex - batchStart].ImageData = frameImageData;
+        }
+
+      if (useCompression)
+        {
+        vtkSMPTools::For(0, static_cast<vtkIdType>(batch.size()), [&](vtkIdType begin, vtkIdType end)
+          {
+          for (vtkIdType batchIndex = begin; batchIndex < end; ++batchIndex)
+            {
+            CompressFrame(batch[batchIndex], frameSize);
+            }
+          });
+        }
+
+      for (int frameIndex = batchStart; frameIndex < batchEnd; ++frameIndex)
+        {
+        const FrameToWrite& frame = batch[frameIndex - batchStart];
+        FrameTableEntry& entry = frameTable[frameIndex];
+        entry.Offset = static_cast<vtkTypeUInt64>(stream.tellp());
+        if (frame.Compressed)
+          {
+          entry.StoredSize = frame.CompressedVoxels.size();
+          entry.Compressed = 1;
+          stream.write(reinterpret_cast<const char*>(frame.CompressedVoxels.data()),
+            static_cast<std::streamsize>(frame.CompressedVoxels.size()));
+          }
+        else
+          {
+          entry.StoredSize = frameSize;
+          entry.Compressed = 0;
+          stream.write(static_cast<const char*>(frame.ImageData->GetScalarPointer()),
+            static_cast<std::streamsize>(frameSize));
+          }
+        }
+      }
+
+    if (!frameTable.empty())
+      {
+      stream.seekp(header.FrameTableOffset);
+      stream.write(reinterpret_cast<const char*>(frameTable.data()),
+        static_cast<std::streamsize>(frameTable.size() * sizeof(FrameTableEntry)));
+      }
+    stream.close();
+    if (stream.fail())
+      {
+      errorMessage = "Failed to write file " + temporaryFileName;
+      vtksys::SystemTools::RemoveFile(temporaryFileName);
+      return false;
+      }
+    }
+  if (!vtksys::SystemTools::RenameFile(temporaryFileName, fileName))
+    {
+    errorMessage = "Failed to replace file " + fileName + " (it may be in use)";
+    vtksys::SystemTools::RemoveFile(temporaryFileName);
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVolumeSequenceChunkedIO::GetSequenceItemImageInformation(vtkMRMLSequenceNode* sequenceNode, int itemNumber,
+  vtkMatrix4x4* ijkToRAS, int dimensions[3], int& scalarType, int& numberOfComponents)
+{
+  for (int i = 0; i < 3; i++)
+    {
+    dimensions[i] = 0;
+    }
+  scalarType = VTK_VOID;
+  numberOfComponents = 0;
+  if (!sequenceNode)
+    {
+    return false;
+    }
+  vtkMRMLSequenceItemLoader* compactItemLoader = sequenceNode->GetCompactItemLoader(itemNumber);
+  if (compactItemLoader)
+    {
+    // All information is provided by the loader
+    return vtkMRMLVolumeNode::SafeDownCast(compactItemLoader->GetItemDataNodeTemplate()) != nullptr
+      && compactItemLoader->GetItemImageInformation(sequenceNode->GetCompactItemId(itemNumber),
+        ijkToRAS, dimensions, scalarType, numberOfComponents);
+    }
+  vtkMRMLVolumeNode* volumeNode = vtkMRMLVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(itemNumber, false));
+  if (!volumeNode)
+    {
+    return false;
+    }
+  if (ijkToRAS)
+    {
+    volumeNode->GetIJKToRASMatrix(ijkToRAS);
+    }
+  if (volumeNode->GetImageData())
+    {
+    volumeNode->GetImageData()->GetDimensions(dimensions);
+    scalarType = volumeNode->GetImageData()->GetScalarType();
+    numberOfComponents = volumeNode->GetImageData()->GetNumberOfScalarComponents();
+    }
+  else if (!sequenceNode->IsDataNodeLoaded(volumeNode))
+    {
+    // Geometry is stored in the data node, voxel information is provided by the loader
+    vtkMRMLSequenceItemLoader* loader = sequenceNode->GetDataNodeLoader(volumeNode);
+    vtkNew<vtkMatrix4x4> loaderIJKToRAS;
+    if (loader && !loader->GetItemImageInformation(sequenceNode->GetDataNodeItemId(volumeNode),
+      loaderIJKToRAS, dimensions, scalarType, numberOfComponents))
+      {
+      for (int i = 0; i < 3; i++)
+        {
+        dimensions[i] = 0;
+        }
+      scalarType = VTK_VOID;
+      numberOfComponents = 0;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> vtkMRMLVolumeSequenceChunkedIO::GetSequenceItemImageData(
+  vtkMRMLSequenceNode* sequenceNode, int itemNumber)
+{
+  if (!sequenceNode)
+    {
+    return nullptr;
+    }
+  vtkMRMLSequenceItemLoader* loader = sequenceNode->GetCompactItemLoader(itemNumber);
+  int itemId = sequenceNode->GetCompactItemId(itemNumber);
+  vtkMRMLVolumeNode* volumeNode = nullptr;
+  if (loader)
+    {
+    if (!vtkMRMLVolumeNode::SafeDownCast(loader->GetItemDataNodeTemplate()))
+      {
+      return nullptr;
+      }
+    }
+  else
+    {
+    volumeNode = vtkMRMLVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(itemNumber, false));
+    if (!volumeNode)
+      {
+      return nullptr;
+      }
+    if (sequenceNode->IsDataNodeLoaded(volumeNode))
+      {
+      return volumeNode->GetImageData();
+      }
+    loader = sequenceNode->GetDataNodeLoader(volumeNode);
+    itemId = sequenceNode->GetDataNodeItemId(volumeNode);
+    }
+  vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+  if (loader && loader->ReadItemData(itemId, imageData))
+    {
+    return imageData;
+    }
+  if (volumeNode)
+    {
+    // The loader cannot read voxels without a data node, load the content of the data node instead
+    volumeNode = vtkMRMLVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(itemNumber));
+    return volumeNode ? volumeNode->GetImageData() : nullptr;
+    }
+  return nullptr;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeSequenceChunkedIO::GetNumberOfFrames()
+{
+  return static_cast<int>(this->Frames.size());
+}
+
+//----------------------------------------------------------------------------
+std::string vtkMRMLVolumeSequenceChunkedIO::GetNthIndexValue(int frameIndex)
+{
+  if (frameIndex < 0 || frameIndex >= static_cast<int>(this->IndexValues.size()))
+    {
+    vtkErrorMacro("GetNthIndexValue failed: frame index " << frameIndex << " is out of range");
+    return "";
+    }
+  return this->IndexValues[frameIndex];
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVolumeSequenceChunkedIO::GetIJKToRASMatrix(vtkMatrix4x4* ijkToRas)
+{
+  if (!ijkToRas)
+    {
+    return;
+    }
+  ijkToRas->DeepCopy(this->IJKToRAS);
+}
+
+//----------------------------------------------------------------------------
+std::vector<std::string> vtkMRMLVolumeSequenceChunkedIO::GetAttributeNames()
+{
+  std::vector<std::string> attributeNames;
+  for (const std::pair<std::string, std::string>& attribute : this->Attributes)
+    {
+    attributeNames.push_back(attribute.first);
+    }
+  return attributeNames;
+}
+
+//----------------------------------------------------------------------------
+std::string vtkMRMLVolumeSequenceChunkedIO::GetAttribute(const std::string& name)
+{
+  for (const std::pair<std::string, std::string>& attribute : this->Attributes)
+    {
+    if (attribute.first == name)
+      {
+      return attribute.second;
+      }
+    }
+  return "";
+}
+
+//----------------------------------------------------------------------------
+vtkTypeUInt64 vtkMRMLVolumeSequenceChunkedIO::GetFrameStoredSize(int frameIndex)
+{
+  if (frameIndex < 0 || frameIndex >= static_cast<int>(this->Frames.size()))
+    {
+    vtkErrorMacro("GetFrameStoredSize failed: frame index " << frameIndex << " is out of range");
+    return 0;
+    }
+  return this->Frames[frameIndex].StoredSize;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVolumeSequenceChunkedIO::LoadItem(vtkMRMLNode* dataNode, int itemId)
+{
+  vtkMRMLVolumeNode* volumeNode = vtkMRMLVolumeNode::SafeDownCast(dataNode);
+  if (!volumeNode)
+    {
+    vtkErrorMacro("LoadItem failed: data node is not a volume node");
+    return false;
+    }
+  vtkNew<vtkImageData> imageData;
+  std::string errorMessage;
+  if (!this->ReadFrame(itemId, imageData, errorMessage))
+    {
+    vtkErrorMacro("LoadItem failed: " << errorMessage);
+    return false;
+    }
+  volumeNode->SetAndObserveImageData(imageData);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVolumeSequenceChunkedIO::ReadItemData(int itemId, vtkDataObject* data)
+{
+  vtkImageData* imageData = vtkImageData::SafeDownCast(data);
+  if (!imageData)
+    {
+    return false;
+    }
+  std::string errorMessage;
+  if (!this->ReadFrame(itemId, imageData, errorMessage))
+    {
+    // Not reported here: this method may be called from a background thread.
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVolumeSequenceChunkedIO::SetItemDataNodeTemplate(vtkMRMLVolumeNode* templateNode)
+{
+  if (this->ItemDataNodeTemplate == templateNode)
+    {
+    return;
+    }
+  this->ItemDataNodeTemplate = templateNode;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLNode* vtkMRMLVolumeSequenceChunkedIO::GetItemDataNodeTemplate()
+{
+  return this->ItemDataNodeTemplate;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLVolumeSequenceChunkedIO::GetItemImageInformation(int itemId, vtkMatrix4x4* ijkToRAS, int dimensions[3],
+  int& scalarType, int& numberOfComponents)
+{
+  if (itemId < 0 || itemId >= static_cast<int>(this->Frames.size()))
+    {
+    return false;
+    }
+  this->GetIJKToRASMatrix(ijkToRAS);
+  for (int i = 0; i < 3; i++)
+    {
+    dimensions[i] = this->Dimensions[i];
+    }
+  scalarType = this->ScalarType;
+  numberOfComponents = this->NumberOfComponents;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLNode* vtkMRMLVolumeSequenceChunkedIO::CreateItemDataNode(int itemId)
+{
+  if (!this->ItemDataNodeTemplate || itemId < 0 || itemId >= static_cast<int>(this->Frames.size()))
+    {
+    vtkErrorMacro("CreateItemDataNode failed: invalid item " << itemId << " or item data node template is not set");
+    return nullptr;
+    }
+  vtkMRMLVolumeNode* dataNode = vtkMRMLVolumeNode::SafeDownCast(this->ItemDataNodeTemplate->CreateNodeInstance());
+  dataNode->CopyContent(this->ItemDataNodeTemplate);
+  vtkNew<vtkMatrix4x4> ijkToRas;
+  this->GetIJKToRASMatrix(ijkToRas);
+  dataNode->SetIJKToRASMatrix(ijkToRas);
+  std::ostringstream nameStr;
+  nameStr << this->ItemNamePrefix << "_" << std::setw(4) << std::setfill('0') << itemId;
+  dataNode->SetName(nameStr.str().c_str());
+  return dataNode;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVolumeSequenceChunkedIO::UnloadItem(vtkMRMLNode* dataNode)
+{
+  vtkMRMLVolumeNode* volumeNode = vtkMRMLVolumeNode::SafeDownCast(dataNode);
+  if (!volumeNode)
+    {
+    return;
+    }
+  volumeNode->SetAndObserveImageData(nullptr);
+}
+
+//----------------------------------------------------------------------------
+vtkMTimeType vtkMRMLVolumeSequenceChunkedIO::GetItemContentMTime(vtkMRMLNode* dataNode)
+{
+  vtkMRMLVolumeNode* volumeNode = vtkMRMLVolumeNode::SafeDownCast(dataNode);
+  if (!volumeNode || !volumeNode->GetImageData())
+    {
+    return 0;
+    }
+  // Modification time is unique, so replacing the image data also changes the returned value
+  return volumeNode->GetImageData()->GetMTime();
+}
@@ -0,0 +1,159 @@
+/*=auto=========================================================================
+
+Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+See COPYRIGHT.txt
+or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#ifndef __vtkMRMLVolumeSequenceChunkedIO_h
+#define __vtkMRMLVolumeSequenceChunkedIO_h
+
+// MRML includes
+#include "vtkMRML.h"
+#include "vtkMRMLSequenceItemLoader.h"
+class vtkMRMLSequenceNode;
+class vtkMRMLVolumeNode;
+
+// VTK includes
+#include <vtkSmartPointer.h>
+class vtkImageData;
+class vtkMatrix4x4;
+
+// STD includes
+#include <string>
+#include <vector>
+
+/// \brief Read and write volume sequences in a chunked container format with random frame access.
+///
+/// The file (.vseq) consists of a fixed size header, a metadata block (index name, unit, type,
+/// index values, and node attributes), a frame table, and the voxels of each frame.
+/// Each frame is compressed independently, and the frame table stores the position and size
+/// of each frame in the file, therefore any frame can be read without reading the others.
+///
+/// When used as a sequence item loader, the voxels of a frame are only read
+/// when the corresponding data node of the sequence is accessed. Frames can be added to
+/// a sequence as compact items, in which case even the data node of a frame is only created
+/// (from the item data node template) when it is accessed.
+/// Reading of frames is thread-safe.
+class VTK_MRML_EXPORT vtkMRMLVolumeSequenceChunkedIO : public vtkMRMLSequenceItemLoader
+{
+public:
+  static vtkMRMLVolumeSequenceChunkedIO *New();
+  vtkTypeMacro(vtkMRMLVolumeSequenceChunkedIO, vtkMRMLSequenceItemLoader);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Read the header, metadata, and frame table of the file. Voxels are not read.
+  /// Returns false and sets errorMessage on failure.
+  bool ReadHeader(const std::string& fileName, std::string& errorMessage);
+
+  /// Read voxels of a frame into imageData. Origin and spacing of the image are set to
+  /// (0,0,0) and (1,1,1), geometry is specified by the IJK to RAS matrix.
+  /// This method is thread-safe.
+  /// Returns false and sets errorMessage on failure.
+  bool ReadFrame(int frameIndex, vtkImageData* imageData, std::string& errorMessage);
+
+  /// Write all items of a volume sequence. All frames must have the same geometry,
+  /// extent, scalar type, and number of components.
+  /// Frames are compressed in parallel. The file is first written to a temporary file,
+  /// which then replaces the destination file.
+  /// Returns false and sets errorMessage on failure.
+  static bool WriteSequence(const std::string& fileName, vtkMRMLSequenceNode* sequenceNode,
+    bool useCompression, std::string& errorMessage);
+
+  /// Returns true if the file starts with the chunked volume sequence file signature.
+  static bool CanReadFile(const std::string& fileName);
+
+  /// Get geometry and voxel type of an item of a volume sequence. Data nodes of compact items
+  /// are not created and content of deferred data nodes is not loaded.
+  /// Dimensions, scalar type, and number of components are set to 0, VTK_VOID, and 0
+  /// if they are not available (for example, the volume has no image data).
+  /// Returns false if the item is not a volume.
+  static bool GetSequenceItemImageInformation(vtkMRMLSequenceNode* sequenceNode, int itemNumber,
+    vtkMatrix4x4* ijkToRAS, int dimensions[3], int& scalarType, int& numberOfComponents);
+
+  /// Get voxels of an item of a volume sequence. Data nodes of compact items are not created,
+  /// voxels of compact items and deferred data nodes that are not loaded are read by their loader
+  /// into a new image, without loading them into the data node.
+  /// Returns nullptr if the item is not a volume or its voxels are not available.
+  static vtkSmartPointer<vtkImageData> GetSequenceItemImageData(vtkMRMLSequenceNode* sequenceNode, int itemNumber);
+
+  /// Name of the file that the header was read from.
+  vtkGetMacro(FileName, std::string);
+
+  /// \name Header information
+  ///@{
+  int GetNumberOfFrames();
+  std::string GetNthIndexValue(int frameIndex);
+  vtkGetMacro(IndexName, std::string);
+  vtkGetMacro(IndexUnit, std::string);
+  vtkGetMacro(IndexType, std::string);
+  vtkGetMacro(VolumeNodeClassName, std::string);
+  vtkGetMacro(ScalarType, int);
+  vtkGetMacro(NumberOfComponents, int);
+  vtkGetVector3Macro(Dimensions, int);
+  void GetIJKToRASMatrix(vtkMatrix4x4* ijkToRas);
+  /// Sequence node attributes stored in the file
+  std::vector<std::string> GetAttributeNames();
+  std::string GetAttribute(const std::string& name);
+  /// Size of a frame in the file (after compression), in bytes.
+  vtkTypeUInt64 GetFrameStoredSize(int frameIndex);
+  ///@}
+
+  /// \name Sequence item loader interface
+  /// Item ID is the frame index. Data nodes must be volume nodes.
+  ///@{
+  bool LoadItem(vtkMRMLNode* dataNode, int itemId) override;
+  void UnloadItem(vtkMRMLNode* dataNode) override;
+  vtkMTimeType GetItemContentMTime(vtkMRMLNode* dataNode) override;
+  /// Data object must be a vtkImageData.
+  bool ReadItemData(int itemId, vtkDataObject* data) override;
+  /// Create a copy of the item data node template, named <ItemNamePrefix>_<frame index>.
+  /// Geometry is set from the header, voxels are loaded by LoadItem.
+  vtkMRMLNode* CreateItemDataNode(int itemId) override;
+  /// Geometry and voxel type are the same for all items, they are read from the header.
+  bool GetItemImageInformation(int itemId, vtkMatrix4x4* ijkToRAS, int dimensions[3],
+    int& scalarType, int& numberOfComponents) override;
+  ///@}
+
+  /// Volume node that data nodes of compact items are created from (see CreateItemDataNode).
+  /// Only its class and properties are used, it does not need image data.
+  void SetItemDataNodeTemplate(vtkMRMLVolumeNode* templateNode);
+  vtkMRMLNode* GetItemDataNodeTemplate() override;
+
+  /// Name prefix of the data nodes created by CreateItemDataNode.
+  vtkSetMacro(ItemNamePrefix, std::string);
+  vtkGetMacro(ItemNamePrefix, std::string);
+
+protected:
+  vtkMRMLVolumeSequenceChunkedIO();
+  ~vtkMRMLVolumeSequenceChunkedIO() override;
+  vtkMRMLVolumeSequenceChunkedIO(const vtkMRMLVolumeSequenceChunkedIO&);
+  void operator=(const vtkMRMLVolumeSequenceChunkedIO&);
+
+  struct FrameEntry
+    {
+    vtkTypeUInt64 Offset{0};
+    vtkTypeUInt64 StoredSize{0};
+    bool Compressed{false};
+    };
+
+  std::string FileName;
+  std::string IndexName;
+  std::string IndexUnit;
+  std::string IndexType;
+  std::string VolumeNodeClassName;
+  int ScalarType{VTK_VOID};
+  int NumberOfComponents{0};
+  int Dimensions[3]{0, 0, 0};
+  double IJKToRAS[16];
+  std::vector<std::string> IndexValues;
+  std::vector<std::pair<std::string, std::string> > Attributes;
+  std::vector<FrameEntry> Frames;
+
+  vtkSmartPointer<vtkMRMLVolumeNode> ItemDataNodeTemplate;
+  std::string ItemNamePrefix{"Volume"};
+};
+
+#endif
@@ -15,8 +15,10 @@ or http://www.slicer.org/copyright/copyright.txt for details.
 #include "vtkMRMLVolumeSequenceStorageNode.h"
 
 #include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLScene.h"
 #include "vtkMRMLSequenceNode.h"
 #include "vtkMRMLVectorVolumeNode.h"
+#include "vtkMRMLVolumeSequenceChunkedIO.h"
 
 #include "vtkSlicerVersionConfigure.h"
 #include "vtkTeemNRRDReader.h"
@@ -28,9 +30,16 @@ or http://www.slicer.org/copyright/copyright.txt for details.
 #endif
 #include "vtkImageExtractComponents.h"
 #include "vtkNew.h"
+#include "vtkSmartPointer.h"
 #include "vtkStringArray.h"
 #include "vtksys/SystemTools.hxx"
 
+namespace
+{
+const char ChunkedSequenceFileExtension[] = ".vseq";
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLVolumeSequenceStorageNode);
 
@@ -68,6 +77,11 @@ int vtkMRMLVolumeSequenceStorageNode::ReadDataInternal(vtkMRMLNode* refNode)
     return 0;
     }
 
+  if (vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(fullName) == ChunkedSequenceFileExtension)
+    {
+    return this->ReadChunkedSequence(volSequenceNode, fullName);
+    }
+
   vtkNew<vtkTeemNRRDReader> reader;
   reader->SetFileName(fullName.c_str());
 
@@ -253,43 +267,42 @@ bool vtkMRMLVolumeSequenceStorageNode::CanWriteFromReferenceNode(vtkMRMLNode *re
     this->GetUserMessages()->AddMessage(vtkCommand::ErrorEvent, std::string("Data node must be a sequence node."));
     return false;
     }
-  vtkMRMLVolumeNode* firstFrameVolume = vtkMRMLVolumeNode::SafeDownCast(volSequenceNode->GetNthDataNode(0));
-  if (firstFrameVolume == nullptr)
+  // Data nodes of compact items are not created and content of deferred frames is not loaded,
+  // image information is available without that
+  vtkNew<vtkMatrix4x4> firstVolumeIjkToRas;
+  int firstFrameVolumeDimensions[3] = { 0, 0, 0 };
+  int firstFrameVolumeScalarType = VTK_VOID;
+  int firstFrameVolumeNumberOfComponents = 0;
+  if (!vtkMRMLVolumeSequenceChunkedIO::GetSequenceItemImageInformation(volSequenceNode, 0, firstVolumeIjkToRas,
+    firstFrameVolumeDimensions, firstFrameVolumeScalarType, firstFrameVolumeNumberOfComponents))
     {
     this->GetUserMessages()->AddMessage(vtkCommand::ErrorEvent, std::string("Only volume nodes can be written."));
     return false;
     }
-
-  int firstFrameVolumeExtent[6] = { 0, -1, 0, -1, 0, -1 };
-  int firstFrameVolumeScalarType = VTK_VOID;
-  int firstFrameVolumeNumberOfComponents = 0;
-  if (firstFrameVolume->GetImageData())
+  // VTK NRRD writer only supports 4D volumes (writing a 3D color volume sequence would require 5D),
+  // the chunked sequence format can store any number of components.
+  bool chunkedFormat = (this->GetFileName() != nullptr
+    && vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(this->GetFileName()) == ChunkedSequenceFileExtension);
+  if (firstFrameVolumeNumberOfComponents > 1 && !chunkedFormat)
     {
-    firstFrameVolume->GetImageData()->GetExtent(firstFrameVolumeExtent);
-    firstFrameVolumeScalarType = firstFrameVolume->GetImageData()->GetScalarType();
-    firstFrameVolumeNumberOfComponents = firstFrameVolume->GetImageData()->GetNumberOfScalarComponents();
-    // VTK NRRD writer only supports 4D volumes (writing a 3D color volume sequence would require 5D)
-    if (firstFrameVolumeNumberOfComponents != 1)
-      {
-      this->GetUserMessages()->AddMessage(vtkCommand::ErrorEvent, std::string("Only single scalar component volumes can be written in this format."));
-      return false;
-      }
+    this->GetUserMessages()->AddMessage(vtkCommand::ErrorEvent, std::string("Only single scalar component volumes can be written in this format."));
+    return false;
     }
-  vtkNew<vtkMatrix4x4> firstVolumeIjkToRas;
-  firstFrameVolume->GetIJKToRASMatrix(firstVolumeIjkToRas.GetPointer());
 
   int numberOfFrameVolumes = volSequenceNode->GetNumberOfDataNodes();
   for (int frameIndex = 1; frameIndex<numberOfFrameVolumes; frameIndex++)
     {
-    vtkMRMLVolumeNode* currentFrameVolume = vtkMRMLVolumeNode::SafeDownCast(volSequenceNode->GetNthDataNode(frameIndex));
-    if (currentFrameVolume == nullptr)
+    vtkNew<vtkMatrix4x4> currentVolumeIjkToRas;
+    int currentFrameVolumeDimensions[3] = { 0, 0, 0 };
+    int currentFrameVolumeScalarType = VTK_VOID;
+    int currentFrameVolumeNumberOfComponents = 0;
+    if (!vtkMRMLVolumeSequenceChunkedIO::GetSequenceItemImageInformation(volSequenceNode, frameIndex, currentVolumeIjkToRas,
+      currentFrameVolumeDimensions, currentFrameVolumeScalarType, currentFrameVolumeNumberOfComponents))
       {
       vtkDebugMacro("vtkMRMLVolumeSequenceStorageNode::CanWriteFromReferenceNode: only volume nodes can be written (frame "<<frameIndex<<")");
       this->GetUserMessages()->AddMessage(vtkCommand::ErrorEvent, std::string("Only volumes can be written in this format."));
       return false;
       }
-    vtkNew<vtkMatrix4x4> currentVolumeIjkToRas;
-    currentFrameVolume->GetIJKToRASMatrix(currentVolumeIjkToRas.GetPointer());
     if (!vtkAddonMathUtilities::MatrixAreEqual(currentVolumeIjkToRas, firstVolumeIjkToRas))
       {
       vtkDebugMacro("vtkMRMLVolumeSequenceStorageNode::CanWriteFromReferenceNode: IJK to RAS matrix is not the same in all frames"
@@ -298,18 +311,9 @@ bool vtkMRMLVolumeSequenceStorageNode::CanWriteFromReferenceNode(vtkMRMLNode *re
       this->GetUserMessages()->AddMessage(vtkCommand::ErrorEvent, std::string("Geometry of all volumes in the sequence must be the same."));
       return false;
       }
-    int currentFrameVolumeExtent[6] = { 0, -1, 0, -1, 0, -1 };
-    int currentFrameVolumeScalarType = VTK_VOID;
-    int currentFrameVolumeNumberOfComponents = 0;
-    if (currentFrameVolume->GetImageData())
-      {
-      currentFrameVolume->GetImageData()->GetExtent(currentFrameVolumeExtent);
-      currentFrameVolumeScalarType = currentFrameVolume->GetImageData()->GetScalarType();
-      currentFrameVolumeNumberOfComponents = currentFrameVolume->GetImageData()->GetNumberOfScalarComponents();
-      }
-    for (int i = 0; i < 6; i++)
+    for (int i = 0; i < 3; i++)
       {
-      if (firstFrameVolumeExtent[i] != currentFrameVolumeExtent[i])
+      if (firstFrameVolumeDimensions[i] != currentFrameVolumeDimensions[i])
         {
         vtkDebugMacro("vtkMRMLVolumeSequenceStorageNode::CanWriteFromReferenceNode: extent mismatch (frame " << frameIndex << ")");
         this->GetUserMessages()->AddMessage(vtkCommand::ErrorEvent, std::string("Extent of all volumes in the sequence must be the same."));
@@ -344,39 +348,41 @@ int vtkMRMLVolumeSequenceStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     return 0;
     }
 
+  if (vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(this->GetFullNameFromFileName()) == ChunkedSequenceFileExtension)
+    {
+    return this->WriteChunkedSequence(volSequenceNode, this->GetFullNameFromFileName());
+    }
+
   vtkNew<vtkMatrix4x4> firstVolumeIjkToRas;
   int frameVolumeDimensions[3] = {0};
   int frameVolumeScalarType = VTK_VOID;
   int numberOfFrameVolumes = volSequenceNode->GetNumberOfDataNodes();
   if (numberOfFrameVolumes > 0)
     {
-    vtkMRMLVolumeNode* frameVolume = vtkMRMLVolumeNode::SafeDownCast(volSequenceNode->GetNthDataNode(0));
-    if (frameVolume==nullptr)
+    int frameVolumeNumberOfComponents = 0;
+    if (!vtkMRMLVolumeSequenceChunkedIO::GetSequenceItemImageInformation(volSequenceNode, 0, firstVolumeIjkToRas,
+      frameVolumeDimensions, frameVolumeScalarType, frameVolumeNumberOfComponents))
       {
       this->GetUserMessages()->AddMessage(vtkCommand::ErrorEvent, std::string("Only volume sequence can be written in this format."));
       return 0;
       }
-    frameVolume->GetIJKToRASMatrix(firstVolumeIjkToRas.GetPointer());
-    if (frameVolume->GetImageData())
-      {
-      frameVolume->GetImageData()->GetDimensions(frameVolumeDimensions);
-      frameVolumeScalarType = frameVolume->GetImageData()->GetScalarType();
-      }
     }
 
 #ifndef NRRD_CHUNK_IO_AVAILABLE
   vtkNew<vtkImageAppendComponents> appender;
   for (int frameIndex=0; frameIndex<numberOfFrameVolumes; frameIndex++)
     {
-    vtkMRMLVolumeNode* frameVolume = vtkMRMLVolumeNode::SafeDownCast(volSequenceNode->GetNthDataNode(frameIndex));
-    if (frameVolume==nullptr)
+    vtkNew<vtkMatrix4x4> currentVolumeIjkToRas;
+    int currentFrameVolumeDimensions[3] = {0};
+    int currentFrameVolumeScalarType = VTK_VOID;
+    int currentFrameVolumeNumberOfComponents = 0;
+    if (!vtkMRMLVolumeSequenceChunkedIO::GetSequenceItemImageInformation(volSequenceNode, frameIndex, currentVolumeIjkToRas,
+      currentFrameVolumeDimensions, currentFrameVolumeScalarType, currentFrameVolumeNumberOfComponents))
       {
       vtkDebugMacro(<< "vtkMRMLVolumeSequenceStorageNode::WriteDataInternal: Data node "<<frameIndex<<" is not a volume");
       this->GetUserMessages()->AddMessage(vtkCommand::ErrorEvent, std::string("Only volume sequence can be written in this format."));
       return 0;
       }
-    vtkNew<vtkMatrix4x4> currentVolumeIjkToRas;
-    frameVolume->GetIJKToRASMatrix(currentVolumeIjkToRas.GetPointer());
     if (!vtkAddonMathUtilities::MatrixAreEqual(currentVolumeIjkToRas, firstVolumeIjkToRas))
       {
       vtkDebugMacro("vtkMRMLVolumeSequenceStorageNode::CanWriteFromReferenceNode: IJK to RAS matrix is not the same in all frames"
@@ -385,13 +391,6 @@ int vtkMRMLVolumeSequenceStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
       this->GetUserMessages()->AddMessage(vtkCommand::ErrorEvent, std::string("Geometry of all volumes in the sequence must be the same."));
       return 0;
       }
-    int currentFrameVolumeDimensions[3] = {0};
-    int currentFrameVolumeScalarType = VTK_VOID;
-    if (frameVolume->GetImageData())
-      {
-      frameVolume->GetImageData()->GetDimensions(currentFrameVolumeDimensions);
-      currentFrameVolumeScalarType = frameVolume->GetImageData()->GetScalarType();
-      }
     if (currentFrameVolumeDimensions[0] != frameVolumeDimensions[0]
     || currentFrameVolumeDimensions[1] != frameVolumeDimensions[1]
     || currentFrameVolumeDimensions[2] != frameVolumeDimensions[2]
@@ -409,9 +408,11 @@ int vtkMRMLVolumeSequenceStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
       this->GetUserMessages()->AddMessage(vtkCommand::ErrorEvent, std::string("Size and scalar type of all volumes in the sequence must be the same."));
       return 0;
      }
-    if (frameVolume->GetImageData())
+    // Voxels of compact items and deferred data nodes are read without creating or loading data nodes
+    vtkSmartPointer<vtkImageData> frameImageData = vtkMRMLVolumeSequenceChunkedIO::GetSequenceItemImageData(volSequenceNode, frameIndex);
+    if (frameImageData)
       {
-      appender->AddInputData(frameVolume->GetImageData());
+      appender->AddInputData(frameImageData);
       }
   }
 #endif
@@ -501,15 +502,17 @@ int vtkMRMLVolumeSequenceStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
   for (int frameIndex = 0; frameIndex < numberOfFrameVolumes; ++frameIndex)
     {
     vtkDebugMacro(<< " writing frame : "<<frameIndex);
-    vtkMRMLVolumeNode* frameVolume = vtkMRMLVolumeNode::SafeDownCast(volSequenceNode->GetNthDataNode(frameIndex));
-    if (frameVolume == nullptr)
+    vtkNew<vtkMatrix4x4> currentVolumeIjkToRas;
+    int currentFrameVolumeDimensions[3] = {0};
+    int currentFrameVolumeScalarType = VTK_VOID;
+    int currentFrameVolumeNumberOfComponents = 0;
+    if (!vtkMRMLVolumeSequenceChunkedIO::GetSequenceItemImageInformation(volSequenceNode, frameIndex, currentVolumeIjkToRas,
+      currentFrameVolumeDimensions, currentFrameVolumeScalarType, currentFrameVolumeNumberOfComponents))
       {
       vtkDebugMacro(<< "vtkMRMLVolumeSequenceStorageNode::WriteDataInternal: Data node "<<frameIndex<<" is not a volume");
       this->GetUserMessages()->AddMessage(vtkCommand::ErrorEvent, std::string("Only volume nodes can be saved in this format."));
       return 0;
       }
-    vtkNew<vtkMatrix4x4> currentVolumeIjkToRas;
-    frameVolume->GetIJKToRASMatrix(currentVolumeIjkToRas.GetPointer());
     if (!vtkAddonMathUtilities::MatrixAreEqual(currentVolumeIjkToRas, firstVolumeIjkToRas))
       {
       vtkDebugMacro("vtkMRMLVolumeSequenceStorageNode::vtkMRMLVolumeSequenceStorageNode: IJK to RAS matrix is not the same in all frames"
@@ -518,13 +521,6 @@ int vtkMRMLVolumeSequenceStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
       this->GetUserMessages()->AddMessage(vtkCommand::ErrorEvent, std::string("Geometry of all volumes in the sequence must be the same."));
       return 0;
       }
-    int currentFrameVolumeDimensions[3] = {0};
-    int currentFrameVolumeScalarType = VTK_VOID;
-    if (frameVolume->GetImageData())
-      {
-      frameVolume->GetImageData()->GetDimensions(currentFrameVolumeDimensions);
-      currentFrameVolumeScalarType = frameVolume->GetImageData()->GetScalarType();
-      }
     if (currentFrameVolumeDimensions[0] != frameVolumeDimensions[0]
     || currentFrameVolumeDimensions[0] != frameVolumeDimensions[0]
     || currentFrameVolumeDimensions[0] != frameVolumeDimensions[0]
@@ -542,7 +538,9 @@ int vtkMRMLVolumeSequenceStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
       this->GetUserMessages()->AddMessage(vtkCommand::ErrorEvent, std::string("All volumes must be of the same type and geometry."));
       return 0;
       }
-    if (frameVolume->GetImageData() == nullptr)
+    // Voxels of compact items and deferred data nodes are read without creating or loading data nodes
+    vtkSmartPointer<vtkImageData> frameImageData = vtkMRMLVolumeSequenceChunkedIO::GetSequenceItemImageData(volSequenceNode, frameIndex);
+    if (frameImageData == nullptr)
       {
       vtkDebugMacro(<< "vtkMRMLVolumeSequenceStorageNode::WriteDataInternal: "
                        "image data of Data node "<<frameIndex<<" not found.");
@@ -550,7 +548,7 @@ int vtkMRMLVolumeSequenceStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
       return 0;
       }
 
-    writer->SetInputDataObject(frameVolume->GetImageData());
+    writer->SetInputDataObject(frameImageData);
     writer->SetCurrentImageIndex(frameIndex);
 
     writer->Write();
@@ -589,6 +587,100 @@ int vtkMRMLVolumeSequenceStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
   return writeFlag;
 }
 
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeSequenceStorageNode::ReadChunkedSequence(vtkMRMLSequenceNode* volSequenceNode, const std::string& fullName)
+{
+  vtkNew<vtkMRMLVolumeSequenceChunkedIO> chunkedIO;
+  std::string errorMessage;
+  if (!chunkedIO->ReadHeader(fullName, errorMessage))
+    {
+    vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLVolumeSequenceStorageNode::ReadChunkedSequence",
+      "Failed to read volume sequence: " << errorMessage);
+    return 0;
+    }
+
+  if (!chunkedIO->GetIndexType().empty())
+    {
+    volSequenceNode->SetIndexTypeFromString(chunkedIO->GetIndexType().c_str());
+    }
+  volSequenceNode->SetIndexName(chunkedIO->GetIndexName().empty() ? "frame" : chunkedIO->GetIndexName());
+  volSequenceNode->SetIndexUnit(chunkedIO->GetIndexUnit());
+  std::vector<std::string> attributeNames = chunkedIO->GetAttributeNames();
+  for (const std::string& attributeName : attributeNames)
+    {
+    volSequenceNode->SetAttribute(attributeName.c_str(), chunkedIO->GetAttribute(attributeName).c_str());
+    }
+
+  // Frames are added as compact items: data nodes are only created when a frame is accessed
+  // and voxels of each frame are read from the file when the data node content is needed.
+  vtkSmartPointer<vtkMRMLNode> node = vtkSmartPointer<vtkMRMLNode>::Take(
+    volSequenceNode->GetSequenceScene()->CreateNodeByClass(chunkedIO->GetVolumeNodeClassName().c_str()));
+  vtkSmartPointer<vtkMRMLVolumeNode> templateVolume = vtkMRMLVolumeNode::SafeDownCast(node);
+  if (!templateVolume)
+    {
+    templateVolume = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
+    }
+  chunkedIO->SetItemDataNodeTemplate(templateVolume);
+  chunkedIO->SetItemNamePrefix(volSequenceNode->GetName() ? volSequenceNode->GetName() : "Volume");
+  int numberOfFrames = chunkedIO->GetNumberOfFrames();
+  for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+    {
+    volSequenceNode->SetCompactItemAtValue(chunkedIO->GetNthIndexValue(frameIndex), chunkedIO, frameIndex);
+    }
+
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeSequenceStorageNode::WriteChunkedSequence(vtkMRMLSequenceNode* volSequenceNode, const std::string& fullName)
+{
+  std::string errorMessage;
+  if (!vtkMRMLVolumeSequenceChunkedIO::WriteSequence(fullName, volSequenceNode, this->GetUseCompression(), errorMessage))
+    {
+    vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLVolumeSequenceStorageNode::WriteChunkedSequence",
+      "Failed to write volume sequence: " << errorMessage);
+    return 0;
+    }
+
+  // Frames (compact items or deferred data nodes) that were loaded on demand from the file
+  // that has just been replaced must be loaded from the new file content (frame positions may have changed).
+  std::string collapsedFullName = vtksys::SystemTools::CollapseFullPath(fullName);
+  vtkNew<vtkMRMLVolumeSequenceChunkedIO> writtenChunkedIO;
+  int numberOfFrames = volSequenceNode->GetNumberOfDataNodes();
+  for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+    {
+    vtkMRMLNode* dataNode = volSequenceNode->GetNthDataNode(frameIndex, false);
+    vtkMRMLVolumeSequenceChunkedIO* chunkedIO = vtkMRMLVolumeSequenceChunkedIO::SafeDownCast(dataNode
+      ? volSequenceNode->GetDataNodeLoader(dataNode) : volSequenceNode->GetCompactItemLoader(frameIndex));
+    if (!chunkedIO || vtksys::SystemTools::CollapseFullPath(chunkedIO->GetFileName()) != collapsedFullName)
+      {
+      continue;
+      }
+    if (writtenChunkedIO->GetFileName().empty())
+      {
+      if (!writtenChunkedIO->ReadHeader(fullName, errorMessage))
+        {
+        vtkErrorToMessageCollectionMacro(this->GetUserMessages(), "vtkMRMLVolumeSequenceStorageNode::WriteChunkedSequence",
+          "Failed to read written volume sequence: " << errorMessage);
+        return 0;
+        }
+      writtenChunkedIO->SetItemDataNodeTemplate(vtkMRMLVolumeNode::SafeDownCast(chunkedIO->GetItemDataNodeTemplate()));
+      writtenChunkedIO->SetItemNamePrefix(chunkedIO->GetItemNamePrefix());
+      }
+    if (dataNode)
+      {
+      volSequenceNode->SetDataNodeDeferred(dataNode, writtenChunkedIO, frameIndex, volSequenceNode->IsDataNodeLoaded(dataNode));
+      }
+    else
+      {
+      volSequenceNode->SetCompactItemAtValue(volSequenceNode->GetNthIndexValue(frameIndex), writtenChunkedIO, frameIndex);
+      }
+    }
+
+  this->StageWriteData(volSequenceNode);
+  return 1;
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLVolumeSequenceStorageNode::InitializeSupportedReadFileTypes()
 {
@@ -596,6 +688,7 @@ void vtkMRMLVolumeSequenceStorageNode::InitializeSupportedReadFileTypes()
   this->SupportedReadFileTypes->InsertNextValue("Volume sequence (.seq.nhdr)");
   this->SupportedReadFileTypes->InsertNextValue("Volume sequence (.nrrd)");
   this->SupportedReadFileTypes->InsertNextValue("Volume sequence (.nhdr)");
+  this->SupportedReadFileTypes->InsertNextValue("Chunked volume sequence (.vseq)");
 }
 
 //----------------------------------------------------------------------------
@@ -605,6 +698,7 @@ void vtkMRMLVolumeSequenceStorageNode::InitializeSupportedWriteFileTypes()
   this->SupportedWriteFileTypes->InsertNextValue("Volume sequence (.seq.nhdr)");
   this->SupportedWriteFileTypes->InsertNextValue("Volume sequence (.nrrd)");
   this->SupportedWriteFileTypes->InsertNextValue("Volume sequence (.nhdr)");
+  this->SupportedWriteFileTypes->InsertNextValue("Chunked volume sequence (.vseq)");
 }
 
 //----------------------------------------------------------------------------
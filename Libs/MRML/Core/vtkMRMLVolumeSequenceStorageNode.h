@@ -9,6 +9,10 @@
 ///  vtkMRMLVolumeSequenceStorageNode - MRML node that can read/write
 ///  a Sequence node containing volumes in a single NRRD file
 ///
+///  Volume sequences can be also stored in a chunked sequence file (.vseq, see
+///  vtkMRMLVolumeSequenceChunkedIO). When such a file is read, voxels of each frame are
+///  only read from the file when the frame is accessed.
+///
 
 #ifndef __vtkMRMLVolumeSequenceStorageNode_h
 #define __vtkMRMLVolumeSequenceStorageNode_h
@@ -18,6 +22,8 @@
 #include "vtkMRMLNRRDStorageNode.h"
 #include <string>
 
+class vtkMRMLSequenceNode;
+
 /// \ingroup Slicer_QtModules_Sequences
 class VTK_MRML_EXPORT vtkMRMLVolumeSequenceStorageNode : public vtkMRMLNRRDStorageNode
 {
@@ -75,6 +81,12 @@ protected:
 
   int ReadDataInternal(vtkMRMLNode* refNode) override;
 
+  /// Read header of a chunked sequence file and set up on-demand loading of frames.
+  int ReadChunkedSequence(vtkMRMLSequenceNode* volSequenceNode, const std::string& fullName);
+
+  /// Write sequence into a chunked sequence file.
+  int WriteChunkedSequence(vtkMRMLSequenceNode* volSequenceNode, const std::string& fullName);
+
   /// Initialize all the supported write file types
   void InitializeSupportedReadFileTypes() override;
 
@@ -0,0 +1,109 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#include "vtkParallelTransformFilter.h"
+
+// MRML includes
+#include "vtkMRMLTransformNode.h"
+
+// VTK includes
+#include <vtkAbstractTransform.h>
+#include <vtkCellData.h>
+#include <vtkDataArray.h>
+#include <vtkInformationVector.h>
+#include <vtkLinearTransform.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPointSet.h>
+#include <vtkSmartPointer.h>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkParallelTransformFilter);
+
+//----------------------------------------------------------------------------
+vtkParallelTransformFilter::vtkParallelTransformFilter() = default;
+
+//----------------------------------------------------------------------------
+vtkParallelTransformFilter::~vtkParallelTransformFilter() = default;
+
+//----------------------------------------------------------------------------
+int vtkParallelTransformFilter::RequestData(vtkInformation* request,
+  vtkInformationVector** inputVector, vtkInformationVector* outputVector)
+{
+  vtkPointSet* input = vtkPointSet::GetData(inputVector[0]);
+  vtkPointSet* output = vtkPointSet::GetData(outputVector);
+  vtkAbstractTransform* transform = this->GetTransform();
+  if (!input || !output || !transform || !input->GetPoints()
+    || vtkLinearTransform::SafeDownCast(transform) || this->GetTransformAllInputVectors())
+    {
+    // Linear transforms are already multi-threaded in vtkTransformFilter
+    return this->Superclass::RequestData(request, inputVector, outputVector);
+    }
+
+  output->CopyStructure(input);
+
+  vtkPoints* inPoints = input->GetPoints();
+  vtkNew<vtkPoints> newPoints;
+  if (this->OutputPointsPrecision == vtkAlgorithm::SINGLE_PRECISION)
+    {
+    newPoints->SetDataType(VTK_FLOAT);
+    }
+  else if (this->OutputPointsPrecision == vtkAlgorithm::DOUBLE_PRECISION)
+    {
+    newPoints->SetDataType(VTK_DOUBLE);
+    }
+  else
+    {
+    newPoints->SetDataType(inPoints->GetDataType());
+    }
+
+  vtkPointData* inPointData = input->GetPointData();
+  vtkPointData* outPointData = output->GetPointData();
+  vtkDataArray* inNormals = inPointData->GetNormals();
+  vtkDataArray* inVectors = inPointData->GetVectors();
+  vtkSmartPointer<vtkDataArray> newNormals;
+  if (inNormals)
+    {
+    newNormals.TakeReference(inNormals->NewInstance());
+    newNormals->SetName(inNormals->GetName());
+    }
+  vtkSmartPointer<vtkDataArray> newVectors;
+  if (inVectors)
+    {
+    newVectors.TakeReference(inVectors->NewInstance());
+    newVectors->SetName(inVectors->GetName());
+    }
+
+  this->UpdateProgress(0.2);
+  vtkMRMLTransformNode::TransformPointsNormalsVectors(transform, inPoints, newPoints,
+    inNormals, newNormals, inVectors, newVectors);
+  this->UpdateProgress(0.8);
+
+  output->SetPoints(newPoints);
+  if (newNormals)
+    {
+    outPointData->SetNormals(newNormals);
+    outPointData->CopyNormalsOff();
+    }
+  if (newVectors)
+    {
+    outPointData->SetVectors(newVectors);
+    outPointData->CopyVectorsOff();
+    }
+  outPointData->PassData(inPointData);
+  // Cell normals and vectors cannot be transformed by non-linear transforms,
+  // they are passed unchanged (same as in vtkTransformFilter)
+  output->GetCellData()->PassData(input->GetCellData());
+
+  return 1;
+}
@@ -0,0 +1,47 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#ifndef __vtkParallelTransformFilter_h
+#define __vtkParallelTransformFilter_h
+
+// MRML includes
+#include "vtkMRML.h"
+
+// VTK includes
+#include <vtkTransformFilter.h>
+
+/// \brief Transform point sets using multiple threads.
+///
+/// Drop-in replacement for vtkTransformFilter. vtkTransformFilter transforms points
+/// on a single thread, which is very slow for large meshes if the transform is non-linear
+/// (e.g., displacement field or its inverse). This filter transforms points, point normals
+/// and point vectors using vtkMRMLTransformNode::TransformPointsNormalsVectors.
+/// Linear transforms, non point set inputs, and transformation of all input vectors
+/// are handled by vtkTransformFilter.
+class VTK_MRML_EXPORT vtkParallelTransformFilter : public vtkTransformFilter
+{
+public:
+  static vtkParallelTransformFilter* New();
+  vtkTypeMacro(vtkParallelTransformFilter, vtkTransformFilter);
+
+protected:
+  vtkParallelTransformFilter();
+  ~vtkParallelTransformFilter() override;
+
+  int RequestData(vtkInformation* request, vtkInformationVector** inputVector,
+    vtkInformationVector* outputVector) override;
+
+private:
+  vtkParallelTransformFilter(const vtkParallelTransformFilter&) = delete;
+  void operator=(const vtkParallelTransformFilter&) = delete;
+};
+
+#endif
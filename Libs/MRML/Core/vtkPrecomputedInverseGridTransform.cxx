@@ -0,0 +1,313 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#include "vtkPrecomputedInverseGridTransform.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Get matrix that maps displacement field voxel indices to physical positions
+void GetGridIndexToPhysicalMatrix(vtkGridTransform* gridTransform, vtkImageData* grid, double gridIndexToPhysical[16])
+{
+  vtkNew<vtkMatrix4x4> directionMatrix;
+  vtkOrientedGridTransform* orientedGridTransform = vtkOrientedGridTransform::SafeDownCast(gridTransform);
+  if (orientedGridTransform && orientedGridTransform->GetGridDirectionMatrix())
+    {
+    directionMatrix->DeepCopy(orientedGridTransform->GetGridDirectionMatrix());
+    }
+  double* origin = grid->GetOrigin();
+  double* spacing = grid->GetSpacing();
+  vtkNew<vtkMatrix4x4> matrix;
+  for (int row = 0; row < 3; row++)
+    {
+    for (int column = 0; column < 3; column++)
+      {
+      matrix->SetElement(row, column, directionMatrix->GetElement(row, column) * spacing[column]);
+      }
+    matrix->SetElement(row, 3, origin[row]);
+    }
+  vtkMatrix4x4::DeepCopy(gridIndexToPhysical, matrix);
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkPrecomputedInverseGridTransform);
+
+//----------------------------------------------------------------------------
+vtkPrecomputedInverseGridTransform::vtkPrecomputedInverseGridTransform()
+{
+  this->SetInterpolationModeToLinear();
+}
+
+//----------------------------------------------------------------------------
+vtkPrecomputedInverseGridTransform::~vtkPrecomputedInverseGridTransform()
+{
+  this->SetOriginalTransform(nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkPrecomputedInverseGridTransform::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "OriginalTransform: " << this->OriginalTransform << "\n";
+}
+
+//----------------------------------------------------------------------------
+vtkAbstractTransform* vtkPrecomputedInverseGridTransform::MakeTransform()
+{
+  return vtkPrecomputedInverseGridTransform::New();
+}
+
+//----------------------------------------------------------------------------
+void vtkPrecomputedInverseGridTransform::SetOriginalTransform(vtkGridTransform* originalTransform)
+{
+  if (this->OriginalTransform == originalTransform)
+    {
+    return;
+    }
+  if (this->OriginalTransform)
+    {
+    this->OriginalTransform->UnRegister(this);
+    }
+  this->OriginalTransform = originalTransform;
+  if (this->OriginalTransform)
+    {
+    this->OriginalTransform->Register(this);
+    }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkMTimeType vtkPrecomputedInverseGridTransform::GetMTime()
+{
+  vtkMTimeType mtime = this->Superclass::GetMTime();
+  if (this->OriginalTransform)
+    {
+    mtime = std::max(mtime, this->OriginalTransform->GetMTime());
+    }
+  return mtime;
+}
+
+//----------------------------------------------------------------------------
+void vtkPrecomputedInverseGridTransform::InternalUpdate()
+{
+  this->Superclass::InternalUpdate();
+  if (this->OriginalTransform)
+    {
+    this->OriginalTransform->Update();
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkPrecomputedInverseGridTransform::InternalDeepCopy(vtkAbstractTransform* transform)
+{
+  this->Superclass::InternalDeepCopy(transform);
+  vtkPrecomputedInverseGridTransform* inverseGridTransform = vtkPrecomputedInverseGridTransform::SafeDownCast(transform);
+  // The original transform is not modified, therefore it can be shared
+  this->SetOriginalTransform(inverseGridTransform ? inverseGridTransform->GetOriginalTransform() : nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkPrecomputedInverseGridTransform::InverseTransformPoint(const float in[3], float out[3])
+{
+  if (!this->OriginalTransform)
+    {
+    this->Superclass::InverseTransformPoint(in, out);
+    return;
+    }
+  this->OriginalTransform->InternalTransformPoint(in, out);
+}
+
+//----------------------------------------------------------------------------
+void vtkPrecomputedInverseGridTransform::InverseTransformPoint(const double in[3], double out[3])
+{
+  if (!this->OriginalTransform)
+    {
+    this->Superclass::InverseTransformPoint(in, out);
+    return;
+    }
+  this->OriginalTransform->InternalTransformPoint(in, out);
+}
+
+//----------------------------------------------------------------------------
+void vtkPrecomputedInverseGridTransform::InverseTransformDerivative(const float in[3], float out[3], float derivative[3][3])
+{
+  if (!this->OriginalTransform)
+    {
+    this->Superclass::InverseTransformDerivative(in, out, derivative);
+    return;
+    }
+  this->OriginalTransform->InternalTransformDerivative(in, out, derivative);
+}
+
+//----------------------------------------------------------------------------
+void vtkPrecomputedInverseGridTransform::InverseTransformDerivative(const double in[3], double out[3], double derivative[3][3])
+{
+  if (!this->OriginalTransform)
+    {
+    this->Superclass::InverseTransformDerivative(in, out, derivative);
+    return;
+    }
+  this->OriginalTransform->InternalTransformDerivative(in, out, derivative);
+}
+
+//----------------------------------------------------------------------------
+bool vtkPrecomputedInverseGridTransform::ComputeInverseDisplacementField(vtkGridTransform* originalTransform,
+  vtkImageData* inverseDisplacementField, const std::atomic<bool>* canceled/*=nullptr*/)
+{
+  if (!originalTransform || !inverseDisplacementField)
+    {
+    vtkGenericWarningMacro("vtkPrecomputedInverseGridTransform::ComputeInverseDisplacementField failed: invalid inputs");
+    return false;
+    }
+  originalTransform->Update();
+  vtkImageData* grid = originalTransform->GetDisplacementGrid();
+  if (!grid)
+    {
+    vtkGenericWarningMacro("vtkPrecomputedInverseGridTransform::ComputeInverseDisplacementField failed: invalid displacement field");
+    return false;
+    }
+  inverseDisplacementField->Initialize();
+  inverseDisplacementField->CopyStructure(grid);
+  inverseDisplacementField->AllocateScalars(VTK_DOUBLE, 3);
+  double* inverseDisplacements = static_cast<double*>(inverseDisplacementField->GetScalarPointer());
+  int* extent = inverseDisplacementField->GetExtent();
+  vtkIdType dimensions[3] = { extent[1] - extent[0] + 1, extent[3] - extent[2] + 1, extent[5] - extent[4] + 1 };
+
+  double gridIndexToPhysical[16];
+  GetGridIndexToPhysicalMatrix(originalTransform, grid, gridIndexToPhysical);
+
+  // The inverse of the original transform is computed by iterative inversion at each grid point
+  vtkAbstractTransform* inverseTransform = originalTransform->GetInverse();
+  inverseTransform->Update();
+
+  vtkSMPTools::For(0, dimensions[1] * dimensions[2], [&](vtkIdType beginRow, vtkIdType endRow)
+    {
+    double point_Index[4] = { 0.0, 0.0, 0.0, 1.0 };
+    double point[4] = { 0.0, 0.0, 0.0, 1.0 };
+    double inversePoint[3] = { 0.0, 0.0, 0.0 };
+    for (vtkIdType row = beginRow; row < endRow; ++row)
+      {
+      // Check in each row, as with the sequential backend the whole range is processed in one chunk
+      if (canceled && *canceled)
+        {
+        return;
+        }
+      point_Index[1] = extent[2] + row % dimensions[1];
+      point_Index[2] = extent[4] + row / dimensions[1];
+      double* displacement = inverseDisplacements + row * dimensions[0] * 3;
+      for (vtkIdType i = 0; i < dimensions[0]; ++i)
+        {
+        point_Index[0] = extent[0] + i;
+        vtkMatrix4x4::MultiplyPoint(gridIndexToPhysical, point_Index, point);
+        inverseTransform->InternalTransformPoint(point, inversePoint);
+        *(displacement++) = inversePoint[0] - point[0];
+        *(displacement++) = inversePoint[1] - point[1];
+        *(displacement++) = inversePoint[2] - point[2];
+        }
+      }
+    });
+
+  return !(canceled && *canceled);
+}
+
+//----------------------------------------------------------------------------
+bool vtkPrecomputedInverseGridTransform::ComputeResidualError(double& maximumError, double& meanError,
+  const std::atomic<bool>* canceled/*=nullptr*/)
+{
+  maximumError = 0.0;
+  meanError = 0.0;
+  this->Update();
+  vtkImageData* grid = this->GetDisplacementGrid();
+  if (!this->OriginalTransform || !grid)
+    {
+    vtkErrorMacro("ComputeResidualError failed: original transform or displacement field is not set");
+    return false;
+    }
+  int* extent = grid->GetExtent();
+  // Number of cells along each axis (grids that are flat along an axis have a single cell layer)
+  vtkIdType numberOfCells[3] = { 1, 1, 1 };
+  double cellCenterOffset[3] = { 0.0, 0.0, 0.0 };
+  for (int axis = 0; axis < 3; axis++)
+    {
+    vtkIdType numberOfPoints = extent[axis * 2 + 1] - extent[axis * 2] + 1;
+    if (numberOfPoints > 1)
+      {
+      numberOfCells[axis] = numberOfPoints - 1;
+      cellCenterOffset[axis] = 0.5;
+      }
+    }
+
+  double gridIndexToPhysical[16];
+  GetGridIndexToPhysicalMatrix(this, grid, gridIndexToPhysical);
+
+  vtkSMPThreadLocal<double> localMaximumError(0.0);
+  vtkSMPThreadLocal<double> localSumError(0.0);
+  vtkSMPTools::For(0, numberOfCells[1] * numberOfCells[2], [&](vtkIdType beginRow, vtkIdType endRow)
+    {
+    double& threadMaximumError = localMaximumError.Local();
+    double& threadSumError = localSumError.Local();
+    double point_Index[4] = { 0.0, 0.0, 0.0, 1.0 };
+    double point[4] = { 0.0, 0.0, 0.0, 1.0 };
+    double inversePoint[3] = { 0.0, 0.0, 0.0 };
+    double roundTripPoint[3] = { 0.0, 0.0, 0.0 };
+    for (vtkIdType row = beginRow; row < endRow; ++row)
+      {
+      if (canceled && *canceled)
+        {
+        return;
+        }
+      point_Index[1] = extent[2] + row % numberOfCells[1] + cellCenterOffset[1];
+      point_Index[2] = extent[4] + row / numberOfCells[1] + cellCenterOffset[2];
+      for (vtkIdType i = 0; i < numberOfCells[0]; ++i)
+        {
+        point_Index[0] = extent[0] + i + cellCenterOffset[0];
+        vtkMatrix4x4::MultiplyPoint(gridIndexToPhysical, point_Index, point);
+        this->ForwardTransformPoint(point, inversePoint);
+        this->OriginalTransform->InternalTransformPoint(inversePoint, roundTripPoint);
+        double error = sqrt(vtkMath::Distance2BetweenPoints(point, roundTripPoint));
+        threadMaximumError = std::max(threadMaximumError, error);
+        threadSumError += error;
+        }
+      }
+    });
+  if (canceled && *canceled)
+    {
+    return false;
+    }
+
+  double sumError = 0.0;
+  for (double error : localMaximumError)
+    {
+    maximumError = std::max(maximumError, error);
+    }
+  for (double error : localSumError)
+    {
+    sumError += error;
+    }
+  meanError = sumError / (numberOfCells[0] * numberOfCells[1] * numberOfCells[2]);
+  return true;
+}
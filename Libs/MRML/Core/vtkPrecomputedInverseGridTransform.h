@@ -0,0 +1,87 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#ifndef __vtkPrecomputedInverseGridTransform_h
+#define __vtkPrecomputedInverseGridTransform_h
+
+// MRML includes
+#include "vtkMRML.h"
+
+// VTK includes
+#include <vtkOrientedGridTransform.h>
+
+// STD includes
+#include <atomic>
+
+/// \brief Inverse of a grid transform, evaluated using a precomputed displacement field.
+///
+/// Computing the inverse of a grid transform requires iterative inversion at each point,
+/// which is slow. This transform stores a precomputed inverse displacement field (which is
+/// evaluated using trilinear interpolation) and the original grid transform, which is used
+/// for computing the inverse of this transform. Therefore, inverting this transform gives
+/// the exact original grid transform.
+///
+/// The displacement field can be computed by ComputeInverseDisplacementField.
+class VTK_MRML_EXPORT vtkPrecomputedInverseGridTransform : public vtkOrientedGridTransform
+{
+public:
+  static vtkPrecomputedInverseGridTransform* New();
+  vtkTypeMacro(vtkPrecomputedInverseGridTransform, vtkOrientedGridTransform);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Make another transform of the same type.
+  vtkAbstractTransform* MakeTransform() override;
+
+  /// Grid transform that this transform is the inverse of.
+  /// It is used for computing the inverse of this transform.
+  /// The transform must not be modified after it is set.
+  void SetOriginalTransform(vtkGridTransform* originalTransform);
+  vtkGetObjectMacro(OriginalTransform, vtkGridTransform);
+
+  /// Compute inverse displacement field of a grid transform, with the same geometry as
+  /// the displacement field of the original transform.
+  /// The original transform must not be modified during the computation.
+  /// Points are processed using multiple threads.
+  /// If canceled is specified and it is set to true (from another thread) during the computation
+  /// then the computation stops and the method returns false.
+  static bool ComputeInverseDisplacementField(vtkGridTransform* originalTransform,
+    vtkImageData* inverseDisplacementField, const std::atomic<bool>* canceled = nullptr);
+
+  /// Compute error of the inverse transform at the center of each displacement field cell
+  /// (where the interpolation error is expected to be the largest).
+  /// The error is the distance between the input point and the point after transforming
+  /// it with this transform and then with the original transform.
+  /// Returns false if the error cannot be computed.
+  bool ComputeResidualError(double& maximumError, double& meanError, const std::atomic<bool>* canceled = nullptr);
+
+  vtkMTimeType GetMTime() override;
+
+protected:
+  vtkPrecomputedInverseGridTransform();
+  ~vtkPrecomputedInverseGridTransform() override;
+
+  void InternalUpdate() override;
+  void InternalDeepCopy(vtkAbstractTransform* transform) override;
+
+  /// Inverse of this transform is computed using the original transform
+  void InverseTransformPoint(const float in[3], float out[3]) override;
+  void InverseTransformPoint(const double in[3], double out[3]) override;
+  void InverseTransformDerivative(const float in[3], float out[3], float derivative[3][3]) override;
+  void InverseTransformDerivative(const double in[3], double out[3], double derivative[3][3]) override;
+
+  vtkGridTransform* OriginalTransform{ nullptr };
+
+private:
+  vtkPrecomputedInverseGridTransform(const vtkPrecomputedInverseGridTransform&) = delete;
+  void operator=(const vtkPrecomputedInverseGridTransform&) = delete;
+};
+
+#endif
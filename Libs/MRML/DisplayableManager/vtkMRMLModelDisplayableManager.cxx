@@ -31,6 +31,7 @@
 #include <vtkMRMLTransformNode.h>
 #include <vtkMRMLViewNode.h>
 #include <vtkMRMLVolumeNode.h>
+#include <vtkParallelTransformFilter.h>
 
 // VTK includes
 #include <vtkAlgorithm.h>
@@ -1060,7 +1061,7 @@ void vtkMRMLModelDisplayableManager::UpdateModelMesh(vtkMRMLDisplayableNode *dis
       tit = this->Internal->DisplayNodeTransformFilters.find(displayNode->GetID());
       if (tit == this->Internal->DisplayNodeTransformFilters.end() )
         {
-        transformFilter = vtkTransformFilter::New();
+        transformFilter = vtkParallelTransformFilter::New();
         this->Internal->DisplayNodeTransformFilters[displayNode->GetID()] = transformFilter;
         }
       else
@@ -33,6 +33,7 @@
 #include <vtkMRMLSliceLogic.h>
 #include <vtkMRMLSliceNode.h>
 #include <vtkMRMLTransformNode.h>
+#include <vtkParallelTransformFilter.h>
 
 // VTK includes
 #include <vtkActor2D.h>
@@ -316,7 +317,7 @@ void vtkMRMLModelSliceDisplayableManager::vtkInternal
   pipeline->TransformToSlice = vtkSmartPointer<vtkTransform>::New();
   pipeline->NodeToWorld = vtkSmartPointer<vtkGeneralTransform>::New();
   pipeline->Transformer = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-  pipeline->ModelWarper = vtkSmartPointer<vtkTransformFilter>::New();
+  pipeline->ModelWarper = vtkSmartPointer<vtkParallelTransformFilter>::New();
   pipeline->SurfaceExtractor = vtkSmartPointer<vtkDataSetSurfaceFilter>::New();
   pipeline->Plane = vtkSmartPointer<vtkPlane>::New();
 
@@ -36,6 +36,17 @@
 #include <vtkPolyData.h>
 #include <vtkTriangleFilter.h>
 
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+/// Number of incremental updates after which the sums in the measurement cache are recomputed
+/// from all values, to prevent accumulation of rounding errors.
+const int MAXIMUM_NUMBER_OF_INCREMENTAL_SUM_UPDATES = 100;
+}
+
 //------------------------------------------------------------------------------
 vtkStandardNewMacro(vtkCurveMeasurementsCalculator);
 
@@ -153,6 +164,8 @@ int vtkCurveMeasurementsCalculator::RequestData(
   else
     {
     outputPolyData->GetPointData()->RemoveArray(this->GetCurvatureArrayName());
+    this->CurvatureCache = CurvePointMeasurementCache();
+    this->NumberOfUpdatedCurvatureValues = 0;
     }
 
   if (this->CalculateTorsion)
@@ -166,6 +179,8 @@ int vtkCurveMeasurementsCalculator::RequestData(
   else
     {
     outputPolyData->GetPointData()->RemoveArray(this->GetTorsionArrayName());
+    this->TorsionCache = CurvePointMeasurementCache();
+    this->NumberOfUpdatedTorsionValues = 0;
     }
 
   // Go through measurements, and interpolate those that contain control point data and are enabled
@@ -217,75 +232,57 @@ bool vtkCurveMeasurementsCalculator::CalculatePolyDataCurvature(vtkPolyData* pol
   curvatureValues->Reset();
   curvatureValues->FillComponent(0,0.0);
 
-  // Initialize curvature variables
-  double minKappa = 0.0;
-  double maxKappa = 0.0;
-  double meanKappa = 0.0; // Mean is weighted by the length of each segment
-
-  // Get values for first point
-  double prevPoint[3] = {points->GetPoint(linePoints->GetId(0))[0], points->GetPoint(linePoints->GetId(0))[1], points->GetPoint(linePoints->GetId(0))[2]}; // pp
-  double* currPoint = points->GetPoint(linePoints->GetId(1)); // p
-  double diffVector[3] = {currPoint[0]-prevPoint[0], currPoint[1]-prevPoint[1], currPoint[2]-prevPoint[2]};
-  double diffNorm = sqrt(diffVector[0]*diffVector[0] + diffVector[1]*diffVector[1] + diffVector[2]*diffVector[2]); // ds
-  double normDiffVector[3] = {0.0, 0.0, 0.0}; // T
-  double prevNormDiffVector[3] = {diffVector[0]/diffNorm, diffVector[1]/diffNorm, diffVector[2]/diffNorm}; // pT
-  double meanPoint[3] = {0.0, 0.0, 0.0}; // m
-  double prevMeanPoint[3] = {currPoint[0], currPoint[1], currPoint[2]}; // pm (Skip first point)
-  double kappa = 0.0;
-  double currentLength = 0.0;
-  double length = 0.0;
-
-  // The curvature for the first cell is 0.0 for open curves
-  curvatureValues->InsertValue(linePoints->GetId(0), 0.0);
+  // Collect curve point positions in the order of the line
+  std::vector<double> curvePointPositions(3 * numberOfPoints);
+  for (vtkIdType idx=0; idx<numberOfPoints; ++idx)
+    {
+    points->GetPoint(linePoints->GetId(idx), &curvePointPositions[3*idx]);
+    }
 
-  prevPoint[0] = currPoint[0]; prevPoint[1] = currPoint[1]; prevPoint[2] = currPoint[2];
-  for (vtkIdType idx=1; idx<numberOfPoints-1; ++idx)
+  // Local curvature depends on the previous and next curve point positions.
+  // Mean is weighted by the length of each segment.
+  this->NumberOfUpdatedCurvatureValues = vtkCurveMeasurementsCalculator::UpdateCurvePointMeasurementCache(
+    this->CurvatureCache, curvePointPositions, 3, 1, 1,
+    [](const double* positions, vtkIdType idx, double& kappa, double& currentLength)
     {
-    currPoint = points->GetPoint(linePoints->GetId(idx+1));
+    const double* prevPoint = positions + 3*(idx-1); // pp
+    const double* currPoint = positions + 3*idx; // p
+    const double* nextPoint = positions + 3*(idx+1);
 
-    diffVector[0] = currPoint[0]-prevPoint[0];
-    diffVector[1] = currPoint[1]-prevPoint[1];
-    diffVector[2] = currPoint[2]-prevPoint[2];
-    diffNorm = sqrt(diffVector[0]*diffVector[0] + diffVector[1]*diffVector[1] + diffVector[2]*diffVector[2]);
+    double prevDiffVector[3] = {currPoint[0]-prevPoint[0], currPoint[1]-prevPoint[1], currPoint[2]-prevPoint[2]};
+    double prevDiffNorm = sqrt(prevDiffVector[0]*prevDiffVector[0] + prevDiffVector[1]*prevDiffVector[1] + prevDiffVector[2]*prevDiffVector[2]);
+    double prevNormDiffVector[3] = {prevDiffVector[0]/prevDiffNorm, prevDiffVector[1]/prevDiffNorm, prevDiffVector[2]/prevDiffNorm}; // pT
 
-    normDiffVector[0] = diffVector[0] / diffNorm;
-    normDiffVector[1] = diffVector[1] / diffNorm;
-    normDiffVector[2] = diffVector[2] / diffNorm;
+    double diffVector[3] = {nextPoint[0]-currPoint[0], nextPoint[1]-currPoint[1], nextPoint[2]-currPoint[2]};
+    double diffNorm = sqrt(diffVector[0]*diffVector[0] + diffVector[1]*diffVector[1] + diffVector[2]*diffVector[2]); // ds
+    double normDiffVector[3] = {diffVector[0]/diffNorm, diffVector[1]/diffNorm, diffVector[2]/diffNorm}; // T
 
     // Local curvature
     kappa = sqrt( (normDiffVector[0]-prevNormDiffVector[0])*(normDiffVector[0]-prevNormDiffVector[0])
                 + (normDiffVector[1]-prevNormDiffVector[1])*(normDiffVector[1]-prevNormDiffVector[1])
                 + (normDiffVector[2]-prevNormDiffVector[2])*(normDiffVector[2]-prevNormDiffVector[2]) )
             / diffNorm;
-    curvatureValues->InsertValue(linePoints->GetId(idx), kappa);
-
-    // Statistics
-    meanPoint[0] = (currPoint[0]+prevPoint[0]) / 2.0;
-    meanPoint[1] = (currPoint[1]+prevPoint[1]) / 2.0;
-    meanPoint[2] = (currPoint[2]+prevPoint[2]) / 2.0;
 
+    // Length between the segment midpoints (skip first point)
+    double meanPoint[3] = {(nextPoint[0]+currPoint[0]) / 2.0, (nextPoint[1]+currPoint[1]) / 2.0, (nextPoint[2]+currPoint[2]) / 2.0}; // m
+    double prevMeanPoint[3] = {currPoint[0], currPoint[1], currPoint[2]}; // pm
+    if (idx > 1)
+      {
+      prevMeanPoint[0] = (currPoint[0]+prevPoint[0]) / 2.0;
+      prevMeanPoint[1] = (currPoint[1]+prevPoint[1]) / 2.0;
+      prevMeanPoint[2] = (currPoint[2]+prevPoint[2]) / 2.0;
+      }
     currentLength = sqrt( (meanPoint[0]-prevMeanPoint[0])*(meanPoint[0]-prevMeanPoint[0])
                         + (meanPoint[1]-prevMeanPoint[1])*(meanPoint[1]-prevMeanPoint[1])
                         + (meanPoint[2]-prevMeanPoint[2])*(meanPoint[2]-prevMeanPoint[2]) );
-    if (kappa < minKappa)
-      {
-      minKappa = kappa;
-      }
-    else if (kappa > maxKappa)
-      {
-      maxKappa = kappa;
-      }
-    meanKappa += kappa * currentLength; // weighted mean
-    length += currentLength;
+    });
 
-    // Propagate current values to previous
-    for (int i=0; i<3; ++i)
-      {
-      prevPoint[i] = currPoint[i];
-      prevMeanPoint[i] = meanPoint[i];
-      prevNormDiffVector[i] = normDiffVector[i];
-      }
-    } // For each line point
+  // The curvature for the first cell is 0.0 for open curves
+  curvatureValues->InsertValue(linePoints->GetId(0), 0.0);
+  for (vtkIdType idx=1; idx<numberOfPoints-1; ++idx)
+    {
+    curvatureValues->InsertValue(linePoints->GetId(idx), this->CurvatureCache.Values[idx]);
+    }
 
   if (!this->CurveIsClosed)
     {
@@ -301,18 +298,16 @@ bool vtkCurveMeasurementsCalculator::CalculatePolyDataCurvature(vtkPolyData* pol
       curvatureValues->GetValue(linePoints->GetId(numberOfPoints-2)));
     }
 
-  currentLength = sqrt( (prevPoint[0]-prevMeanPoint[0])*(prevPoint[0]-prevMeanPoint[0])
-                      + (prevPoint[1]-prevMeanPoint[1])*(prevPoint[1]-prevMeanPoint[1])
-                      + (prevPoint[2]-prevMeanPoint[2])*(prevPoint[2]-prevMeanPoint[2]) );
-  length += currentLength;
-  if (length > 0.0)
-    {
-    meanKappa = meanKappa / length;
-    }
-  else
-    {
-    meanKappa = 0.0;
-    }
+  // Add length of the half segment at the last point
+  const double* lastPoint = &this->CurvatureCache.Inputs[3*(numberOfPoints-1)];
+  const double* secondLastPoint = &this->CurvatureCache.Inputs[3*(numberOfPoints-2)];
+  double lastMeanPoint[3] = {(lastPoint[0]+secondLastPoint[0]) / 2.0, (lastPoint[1]+secondLastPoint[1]) / 2.0, (lastPoint[2]+secondLastPoint[2]) / 2.0};
+  double currentLength = sqrt( (lastPoint[0]-lastMeanPoint[0])*(lastPoint[0]-lastMeanPoint[0])
+                             + (lastPoint[1]-lastMeanPoint[1])*(lastPoint[1]-lastMeanPoint[1])
+                             + (lastPoint[2]-lastMeanPoint[2])*(lastPoint[2]-lastMeanPoint[2]) );
+  double length = this->CurvatureCache.TotalWeight + currentLength;
+  double meanKappa = (length > 0.0 ? this->CurvatureCache.WeightedSum / length : 0.0);
+  double maxKappa = this->CurvatureCache.MaximumValue;
 
   // Set mean and max curvature to measurements
   // Calculate and set interpolated control point measurements in poly data
@@ -415,60 +410,44 @@ bool vtkCurveMeasurementsCalculator::CalculatePolyDataTorsion(vtkPolyData* polyD
   torsionArray->Reset();
   torsionArray->FillComponent(0,0.0);
 
-  // Initialize curvature variables
-  double minTorsion= 0.0;
-  double maxTorsion = 0.0;
-  double meanTorsion = 0.0;
-
-  // Get values for first point
-  double* binormal = binormals->GetTuple3(linePoints->GetId(1));
-  double binormalNorm = sqrt(binormal[0]*binormal[0] + binormal[1]*binormal[1] + binormal[2]*binormal[2]);
-  double normBinormal[3] = {0.0, 0.0, 0.0};
-  double prevNormBinormal[3] = {binormal[0]/binormalNorm, binormal[1]/binormalNorm, binormal[2]/binormalNorm};
-  double torsion = 0.0;
-  double *tangent = nullptr;
-  double currentLength = 0.0;
-  double length = 0.0;
-
-  // The torsion for the first cell is 0.0 for open curves
-  torsionArray->InsertValue(linePoints->GetId(0), 0.0);
+  // Collect binormal and tangent of each curve point in the order of the line
+  std::vector<double> curvePointFrames(6 * numberOfPoints);
+  for (vtkIdType idx=0; idx<numberOfPoints; ++idx)
+    {
+    binormals->GetTypedTuple(linePoints->GetId(idx), &curvePointFrames[6*idx]);
+    tangents->GetTypedTuple(linePoints->GetId(idx), &curvePointFrames[6*idx+3]);
+    }
 
-  for (vtkIdType idx=1; idx<numberOfPoints-1; ++idx)
+  // Local torsion depends on the binormal of the current and next curve point.
+  // Mean is weighted by the tangent length.
+  this->NumberOfUpdatedTorsionValues = vtkCurveMeasurementsCalculator::UpdateCurvePointMeasurementCache(
+    this->TorsionCache, curvePointFrames, 6, 0, 1,
+    [](const double* frames, vtkIdType idx, double& torsion, double& currentLength)
     {
-    binormal = binormals->GetTuple3(linePoints->GetId(idx+1));
-    binormalNorm = sqrt(binormal[0]*binormal[0] + binormal[1]*binormal[1] + binormal[2]*binormal[2]);
+    const double* prevBinormal = frames + 6*idx;
+    const double* binormal = frames + 6*(idx+1);
+    const double* tangent = frames + 6*idx + 3;
 
-    normBinormal[0] = binormal[0] / binormalNorm;
-    normBinormal[1] = binormal[1] / binormalNorm;
-    normBinormal[2] = binormal[2] / binormalNorm;
+    double prevBinormalNorm = sqrt(prevBinormal[0]*prevBinormal[0] + prevBinormal[1]*prevBinormal[1] + prevBinormal[2]*prevBinormal[2]);
+    double prevNormBinormal[3] = {prevBinormal[0]/prevBinormalNorm, prevBinormal[1]/prevBinormalNorm, prevBinormal[2]/prevBinormalNorm};
+    double binormalNorm = sqrt(binormal[0]*binormal[0] + binormal[1]*binormal[1] + binormal[2]*binormal[2]);
+    double normBinormal[3] = {binormal[0]/binormalNorm, binormal[1]/binormalNorm, binormal[2]/binormalNorm};
 
     // Local torsion
     torsion = sqrt( (normBinormal[0]-prevNormBinormal[0])*(normBinormal[0]-prevNormBinormal[0])
                   + (normBinormal[1]-prevNormBinormal[1])*(normBinormal[1]-prevNormBinormal[1])
                   + (normBinormal[2]-prevNormBinormal[2])*(normBinormal[2]-prevNormBinormal[2]) )
               / binormalNorm;
-    torsionArray->InsertValue(linePoints->GetId(idx), torsion);
 
-    // Statistics
-    tangent = tangents->GetTuple3(linePoints->GetId(idx));
     currentLength = sqrt( tangent[0]*tangent[0] + tangent[1]*tangent[1] + tangent[2]*tangent[2] );
-    if (torsion < minTorsion)
-      {
-      minTorsion = torsion;
-      }
-    else if (torsion > maxTorsion)
-      {
-      maxTorsion = torsion;
-      }
-    meanTorsion += torsion * currentLength; // weighted mean
-    length += currentLength;
+    });
 
-    // Propagate current values to previous
-    for (int i=0; i<3; ++i)
-      {
-      prevNormBinormal[i] = normBinormal[i];
-      }
-    } // For each line point
+  // The torsion for the first cell is 0.0 for open curves
+  torsionArray->InsertValue(linePoints->GetId(0), 0.0);
+  for (vtkIdType idx=1; idx<numberOfPoints-1; ++idx)
+    {
+    torsionArray->InsertValue(linePoints->GetId(idx), this->TorsionCache.Values[idx]);
+    }
 
   // Use the adjacent values for instead of the singular values
   if (!this->CurveIsClosed)
@@ -484,17 +463,11 @@ bool vtkCurveMeasurementsCalculator::CalculatePolyDataTorsion(vtkPolyData* polyD
       torsionArray->GetValue(linePoints->GetId(numberOfPoints-2)));
     }
 
-  tangent = tangents->GetTuple3(linePoints->GetId(numberOfPoints-1));
-  currentLength = sqrt( tangent[0]*tangent[0] + tangent[1]*tangent[1] + tangent[2]*tangent[2] );
-  length += currentLength;
-  if (length > 0.0)
-    {
-    meanTorsion = meanTorsion / length;
-    }
-  else
-    {
-    meanTorsion = 0.0;
-    }
+  const double* tangent = &this->TorsionCache.Inputs[6*(numberOfPoints-1)+3];
+  double currentLength = sqrt( tangent[0]*tangent[0] + tangent[1]*tangent[1] + tangent[2]*tangent[2] );
+  double length = this->TorsionCache.TotalWeight + currentLength;
+  double meanTorsion = (length > 0.0 ? this->TorsionCache.WeightedSum / length : 0.0);
+  double maxTorsion = this->TorsionCache.MaximumValue;
 
   // Set mean and max torsion to measurements
   // Calculate and set interpolated control point measurements in poly data
@@ -523,6 +496,113 @@ bool vtkCurveMeasurementsCalculator::CalculatePolyDataTorsion(vtkPolyData* polyD
   return true;
 }
 
+//------------------------------------------------------------------------------
+vtkIdType vtkCurveMeasurementsCalculator::UpdateCurvePointMeasurementCache(CurvePointMeasurementCache& cache,
+  std::vector<double>& inputs, int numberOfInputComponents, vtkIdType dependencyBefore, vtkIdType dependencyAfter,
+  const std::function<void(const double* inputs, vtkIdType pointIndex, double& value, double& weight)>& computeValue)
+{
+  vtkIdType numberOfPoints = static_cast<vtkIdType>(inputs.size()) / numberOfInputComponents;
+  vtkIdType firstUpdatedPointIndex = 1;
+  vtkIdType lastUpdatedPointIndex = numberOfPoints - 2;
+  bool incrementalUpdate = (cache.Inputs.size() == inputs.size());
+  if (incrementalUpdate)
+    {
+    // Find the range of curve points that have changed since the last update
+    vtkIdType firstChangedPointIndex = -1;
+    vtkIdType lastChangedPointIndex = -1;
+    for (vtkIdType pointIndex = 0; pointIndex < numberOfPoints; ++pointIndex)
+      {
+      std::vector<double>::const_iterator pointInputsBegin = inputs.begin() + pointIndex * numberOfInputComponents;
+      if (!std::equal(pointInputsBegin, pointInputsBegin + numberOfInputComponents,
+        cache.Inputs.begin() + pointIndex * numberOfInputComponents))
+        {
+        if (firstChangedPointIndex < 0)
+          {
+          firstChangedPointIndex = pointIndex;
+          }
+        lastChangedPointIndex = pointIndex;
+        }
+      }
+    if (firstChangedPointIndex < 0)
+      {
+      // Nothing has changed
+      return 0;
+      }
+    firstUpdatedPointIndex = std::max<vtkIdType>(firstUpdatedPointIndex, firstChangedPointIndex - dependencyAfter);
+    lastUpdatedPointIndex = std::min<vtkIdType>(lastUpdatedPointIndex, lastChangedPointIndex + dependencyBefore);
+    }
+  else
+    {
+    cache.Values.assign(numberOfPoints, 0.0);
+    cache.Weights.assign(numberOfPoints, 0.0);
+    cache.WeightedSum = 0.0;
+    cache.TotalWeight = 0.0;
+    cache.MaximumValue = 0.0;
+    cache.NumberOfIncrementalSumUpdates = 0;
+    }
+
+  bool maximumValueRemoved = false;
+  for (vtkIdType pointIndex = firstUpdatedPointIndex; pointIndex <= lastUpdatedPointIndex; ++pointIndex)
+    {
+    double& value = cache.Values[pointIndex];
+    double& weight = cache.Weights[pointIndex];
+    if (incrementalUpdate)
+      {
+      // Remove contribution of the previous value
+      cache.WeightedSum -= value * weight;
+      cache.TotalWeight -= weight;
+      if (value >= cache.MaximumValue)
+        {
+        maximumValueRemoved = true;
+        }
+      }
+    computeValue(inputs.data(), pointIndex, value, weight);
+    cache.WeightedSum += value * weight;
+    cache.TotalWeight += weight;
+    if (value > cache.MaximumValue)
+      {
+      cache.MaximumValue = value;
+      }
+    }
+
+  if (maximumValueRemoved)
+    {
+    // The previous maximum may have been replaced by a smaller value
+    cache.MaximumValue = 0.0;
+    for (vtkIdType pointIndex = 1; pointIndex < numberOfPoints - 1; ++pointIndex)
+      {
+      if (cache.Values[pointIndex] > cache.MaximumValue)
+        {
+        cache.MaximumValue = cache.Values[pointIndex];
+        }
+      }
+    }
+  vtkIdType numberOfUpdatedPoints = lastUpdatedPointIndex - firstUpdatedPointIndex + 1;
+  if (incrementalUpdate)
+    {
+    cache.NumberOfIncrementalSumUpdates++;
+    }
+  // Invalid values (e.g., at coincident curve points) cannot be removed from the sum.
+  // Rounding errors of repeated subtraction and addition accumulate in the sums.
+  // If most of the values are updated then recomputing the sums is not more expensive.
+  if (incrementalUpdate && (!std::isfinite(cache.WeightedSum) || !std::isfinite(cache.TotalWeight)
+    || cache.NumberOfIncrementalSumUpdates >= MAXIMUM_NUMBER_OF_INCREMENTAL_SUM_UPDATES
+    || 2 * numberOfUpdatedPoints > numberOfPoints))
+    {
+    cache.NumberOfIncrementalSumUpdates = 0;
+    cache.WeightedSum = 0.0;
+    cache.TotalWeight = 0.0;
+    for (vtkIdType pointIndex = 1; pointIndex < numberOfPoints - 1; ++pointIndex)
+      {
+      cache.WeightedSum += cache.Values[pointIndex] * cache.Weights[pointIndex];
+      cache.TotalWeight += cache.Weights[pointIndex];
+      }
+    }
+
+  cache.Inputs.swap(inputs);
+  return numberOfUpdatedPoints;
+}
+
 //------------------------------------------------------------------------------
 bool vtkCurveMeasurementsCalculator::InterpolateControlPointMeasurementToPolyData(vtkPolyData* outputPolyData)
 {
@@ -25,6 +25,10 @@
 #include <vtkSetGet.h>
 #include <vtkWeakPointer.h>
 
+// STD includes
+#include <functional>
+#include <vector>
+
 // Markups MRML includes
 #include <vtkMRMLMarkupsNode.h>
 
@@ -37,6 +41,11 @@ class vtkCallbackCommand;
 /// - Interpolate control point measurements into curve point data
 /// - Calculate per-curve-point curvature (disabled by default)
 /// - Calculate per-curve-point torsion (disabled by default)
+///
+/// Curvature and torsion values are cached between executions. If only some curve points
+/// are changed (for example, because a control point is moved) then only the values
+/// in the neighborhood of the changed points are recomputed and the mean and maximum
+/// measurements are updated incrementally.
 class VTK_SLICER_MARKUPS_MODULE_MRML_EXPORT vtkCurveMeasurementsCalculator : public vtkPolyDataAlgorithm
 {
 public:
@@ -94,6 +103,13 @@ public:
   vtkGetMacro(TorsionUnits, std::string);
   vtkSetMacro(TorsionUnits, std::string);
 
+  //@{
+  /// Get number of curve points that curvature or torsion was recomputed at
+  /// during the last execution. Values at other curve points were reused from the previous execution.
+  vtkGetMacro(NumberOfUpdatedCurvatureValues, vtkIdType);
+  vtkGetMacro(NumberOfUpdatedTorsionValues, vtkIdType);
+  //@}
+
   vtkMTimeType GetMTime() override;
 
   /// Store interpolated values of inputValues in interpolatedValues,
@@ -108,6 +124,31 @@ protected:
   bool CalculatePolyDataTorsion(vtkPolyData* polyData);
   bool InterpolateControlPointMeasurementToPolyData(vtkPolyData* outputPolyData);
 
+  /// Measurement values at each curve point, stored to allow incremental update.
+  struct CurvePointMeasurementCache
+    {
+    /// Values that the measurement was computed from (same number of values for each curve point)
+    std::vector<double> Inputs;
+    /// Measurement value at each curve point
+    std::vector<double> Values;
+    /// Weight of each value in the mean (length of the curve that belongs to the curve point)
+    std::vector<double> Weights;
+    double WeightedSum{0.0};
+    double TotalWeight{0.0};
+    double MaximumValue{0.0};
+    /// Number of incremental updates of WeightedSum and TotalWeight since they were last computed from all values
+    int NumberOfIncrementalSumUpdates{0};
+    };
+
+  /// Compute measurement values at curve points 1..N-2 from the inputs (numberOfInputComponents values per curve point).
+  /// Only values that depend on inputs that are different from the cached inputs are recomputed:
+  /// value at curve point i is assumed to depend on inputs of curve points i-dependencyBefore..i+dependencyAfter.
+  /// The computeValue function computes value and weight at a curve point, from all inputs.
+  /// Returns the number of recomputed values.
+  static vtkIdType UpdateCurvePointMeasurementCache(CurvePointMeasurementCache& cache,
+    std::vector<double>& inputs, int numberOfInputComponents, vtkIdType dependencyBefore, vtkIdType dependencyAfter,
+    const std::function<void(const double* inputs, vtkIdType pointIndex, double& value, double& weight)>& computeValue);
+
   /// Callback function observing data array modified events.
   /// If a data array to interpolate is modified, then the interpolation needs to be re-run.
   static void OnControlPointArrayModified(vtkObject* caller, unsigned long eid, void* clientData, void* callData);
@@ -133,6 +174,11 @@ protected:
   std::string CurvatureUnits{"mm-1"};
   std::string TorsionUnits{"mm-1"};
 
+  CurvePointMeasurementCache CurvatureCache;
+  CurvePointMeasurementCache TorsionCache;
+  vtkIdType NumberOfUpdatedCurvatureValues{0};
+  vtkIdType NumberOfUpdatedTorsionValues{0};
+
 protected:
   int FillInputPortInformation(int port, vtkInformation* info) override;
   int RequestData(vtkInformation* request, vtkInformationVector** inputVector, vtkInformationVector* outputVector) override;
@@ -46,6 +46,7 @@
 #include <vtkObjectFactory.h>
 #include <vtkPlane.h>
 #include <vtkPointData.h>
+#include <vtkPoints.h>
 #include <vtkPolyData.h>
 #include <vtkStringArray.h>
 #include <vtkTransform.h>
@@ -58,6 +59,18 @@
 #include <sstream>
 #include <algorithm>
 
+namespace
+{
+//----------------------------------------------------------------------------
+std::string FormatControlPointLabel(const std::string& formatString, int controlPointNumber)
+{
+  char buf[128];
+  buf[sizeof(buf) - 1] = 0; // make sure the string is zero-terminated
+  snprintf(buf, sizeof(buf) - 1, formatString.c_str(), controlPointNumber);
+  return std::string(buf);
+}
+}
+
 //----------------------------------------------------------------------------
 vtkMRMLMarkupsNode::vtkMRMLMarkupsNode()
 {
@@ -1101,8 +1114,7 @@ void vtkMRMLMarkupsNode::TransformOrientationMatrixFromNodeToWorld(
   if (this->GetParentTransformNode())
     {
     // Transform orientation matrix from world
-    vtkNew<vtkGeneralTransform> nodeToWorldTransform;
-    this->GetParentTransformNode()->GetTransformToWorld(nodeToWorldTransform);
+    vtkAbstractTransform* nodeToWorldTransform = this->GetParentTransformNode()->GetCachedTransformToWorld();
 
     double xAxis_Node[3] = { orientationMatrix_Node[0], orientationMatrix_Node[3], orientationMatrix_Node[6] };
     double yAxis_Node[3] = { orientationMatrix_Node[1], orientationMatrix_Node[4], orientationMatrix_Node[7] };
@@ -1131,8 +1143,7 @@ void vtkMRMLMarkupsNode::TransformOrientationMatrixFromWorldToNode(
   if (this->GetParentTransformNode())
     {
     // Transform orientation matrix from world
-    vtkNew<vtkGeneralTransform> worldToNodeTransform;
-    this->GetParentTransformNode()->GetTransformFromWorld(worldToNodeTransform);
+    vtkAbstractTransform* worldToNodeTransform = this->GetParentTransformNode()->GetCachedTransformFromWorld();
 
     double xAxis_World[3] = { orientationMatrix_Node[0], orientationMatrix_Node[3], orientationMatrix_Node[6] };
     double yAxis_World[3] = { orientationMatrix_Node[1], orientationMatrix_Node[4], orientationMatrix_Node[7] };
@@ -1784,15 +1795,22 @@ void vtkMRMLMarkupsNode::ApplyTransform(vtkAbstractTransform* transform)
     this->InteractionHandleToWorldMatrix->DeepCopy(handleToWorldTransform->GetMatrix());
     }
 
+  // Transform all points at once (position status of the points is not changed)
   int numControlPoints = this->GetNumberOfControlPoints();
-  double xyzIn[3];
-  double xyzOut[3];
+  vtkNew<vtkPoints> pointsIn;
+  pointsIn->SetDataTypeToDouble();
+  this->GetControlPointPositions(pointsIn);
+  vtkNew<vtkPoints> pointsOut;
+  pointsOut->SetDataTypeToDouble();
+  transform->TransformPoints(pointsIn, pointsOut);
   for (int controlPointIndex = 0; controlPointIndex < numControlPoints; controlPointIndex++)
     {
-    this->GetNthControlPointPosition(controlPointIndex, xyzIn);
-    transform->TransformPoint(xyzIn,xyzOut);
-    int status = this->GetNthControlPointPositionStatus(controlPointIndex);
-    this->SetNthControlPointPosition(controlPointIndex, xyzOut, status);
+    pointsOut->GetPoint(controlPointIndex, this->ControlPoints[controlPointIndex]->Position);
+    this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointModifiedEvent, static_cast<void*>(&controlPointIndex));
+    }
+  if (numControlPoints > 0 && this->GetDisplayNode())
+    {
+    this->GetDisplayNode()->UpdateScalarRange();
     }
   this->StorableModifiedTime.Modified();
   this->Modified();
@@ -1880,11 +1898,7 @@ std::string vtkMRMLMarkupsNode::GenerateUniqueControlPointID()
 //---------------------------------------------------------------------------
 std::string vtkMRMLMarkupsNode::GenerateControlPointLabel(int controlPointIndex)
 {
-  std::string formatString = this->ReplaceListNameInControlPointLabelFormat();
-  char buf[128];
-  buf[sizeof(buf) - 1] = 0; // make sure the string is zero-terminated
-  snprintf(buf, sizeof(buf) - 1, formatString.c_str(), controlPointIndex);
-  return std::string(buf);
+  return FormatControlPointLabel(this->ReplaceListNameInControlPointLabelFormat(), controlPointIndex);
 }
 
 //---------------------------------------------------------------------------
@@ -2426,6 +2440,46 @@ void vtkMRMLMarkupsNode::GetControlPointLabels(vtkStringArray* labels)
 
 //---------------------------------------------------------------------------
 void vtkMRMLMarkupsNode::SetControlPointPositionsWorld(vtkPoints* points)
+{
+  vtkMRMLTransformNode* transformNode = this->GetParentTransformNode();
+  if (!points || !transformNode)
+    {
+    this->SetControlPointPositions(points);
+    return;
+    }
+  // Get the transform only once for all points
+  vtkNew<vtkGeneralTransform> transformFromWorld;
+  transformNode->GetTransformFromWorld(transformFromWorld);
+  vtkNew<vtkPoints> pointsLocal;
+  pointsLocal->SetDataTypeToDouble();
+  transformFromWorld->TransformPoints(points, pointsLocal);
+  this->SetControlPointPositions(pointsLocal);
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsNode::GetControlPointPositionsWorld(vtkPoints* points)
+{
+  if (!points)
+    {
+    return;
+    }
+  vtkMRMLTransformNode* transformNode = this->GetParentTransformNode();
+  if (!transformNode)
+    {
+    this->GetControlPointPositions(points);
+    return;
+    }
+  vtkNew<vtkPoints> pointsLocal;
+  pointsLocal->SetDataTypeToDouble();
+  this->GetControlPointPositions(pointsLocal);
+  vtkNew<vtkGeneralTransform> transformToWorld;
+  transformNode->GetTransformToWorld(transformToWorld);
+  points->Reset();
+  transformToWorld->TransformPoints(pointsLocal, points);
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsNode::SetControlPointPositions(vtkPoints* points)
 {
   if (!points)
     {
@@ -2436,21 +2490,39 @@ void vtkMRMLMarkupsNode::SetControlPointPositionsWorld(vtkPoints* points)
   int wasModified = this->StartModify();
   this->IsUpdatingPoints = true;
 
+  // Update existing points. Positions are set directly (instead of using SetNthControlPointPosition)
+  // so that the scalar range is only updated once, after all the points are set.
   vtkIdType numberOfPoints = points->GetNumberOfPoints();
-  for (vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
-    {
-    double* posWorld = points->GetPoint(pointIndex);
-    if (pointIndex < this->GetNumberOfControlPoints())
+  int numberOfUpdatedPoints = static_cast<int>(std::min<vtkIdType>(numberOfPoints, this->GetNumberOfControlPoints()));
+  for (int pointIndex = 0; pointIndex < numberOfUpdatedPoints; pointIndex++)
+    {
+    ControlPoint* controlPoint = this->ControlPoints[pointIndex];
+    points->GetPoint(pointIndex, controlPoint->Position);
+    int oldPositionStatus = controlPoint->PositionStatus;
+    controlPoint->PositionStatus = PositionDefined;
+    this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointModifiedEvent, static_cast<void*>(&pointIndex));
+    if (oldPositionStatus != PositionDefined)
       {
-      // point already exists, just update it
-      this->SetNthControlPointPositionWorld(pointIndex, posWorld);
+      this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointPositionDefinedEvent, static_cast<void*>(&pointIndex));
       }
-    else
+    if (oldPositionStatus == PositionMissing)
       {
-      // need to add a new point
-      vtkMRMLMarkupsNode::AddControlPointWorld(vtkVector3d(posWorld));
+      this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointPositionNonMissingEvent, static_cast<void*>(&pointIndex));
       }
     }
+  if (numberOfUpdatedPoints > 0)
+    {
+    this->StorableModifiedTime.Modified();
+    }
+
+  if (numberOfPoints > numberOfUpdatedPoints)
+    {
+    // Add new points
+    vtkNew<vtkPoints> newPoints;
+    newPoints->SetDataTypeToDouble();
+    newPoints->InsertPoints(0, numberOfPoints - numberOfUpdatedPoints, numberOfUpdatedPoints, points);
+    this->AddControlPoints(newPoints);
+    }
   while (this->GetNumberOfControlPoints() > numberOfPoints)
     {
     this->RemoveNthControlPoint(this->GetNumberOfControlPoints() - 1);
@@ -2460,10 +2532,15 @@ void vtkMRMLMarkupsNode::SetControlPointPositionsWorld(vtkPoints* points)
   // No need to call UpdateAllMeasurements(), because it is automatically
   // called in EndModify().
   this->EndModify(wasModified);
+
+  if (numberOfUpdatedPoints > 0 && this->GetDisplayNode())
+    {
+    this->GetDisplayNode()->UpdateScalarRange();
+    }
 }
 
 //---------------------------------------------------------------------------
-void vtkMRMLMarkupsNode::GetControlPointPositionsWorld(vtkPoints* points)
+void vtkMRMLMarkupsNode::GetControlPointPositions(vtkPoints* points)
 {
   if (!points)
     {
@@ -2471,12 +2548,65 @@ void vtkMRMLMarkupsNode::GetControlPointPositionsWorld(vtkPoints* points)
     }
   int numberOfControlPoints = this->GetNumberOfControlPoints();
   points->SetNumberOfPoints(numberOfControlPoints);
-  double posWorld[3] = { 0.0, 0.0, 0.0 };
   for (int controlPointIndex = 0; controlPointIndex < numberOfControlPoints; controlPointIndex++)
     {
-    this->GetNthControlPointPositionWorld(controlPointIndex, posWorld);
-    points->SetPoint(controlPointIndex, posWorld);
+    points->SetPoint(controlPointIndex, this->ControlPoints[controlPointIndex]->Position);
+    }
+}
+
+//---------------------------------------------------------------------------
+int vtkMRMLMarkupsNode::AddControlPoints(vtkPoints* points, std::string label /*=std::string()*/)
+{
+  if (!points)
+    {
+    vtkErrorMacro("AddControlPoints: invalid points");
+    return -1;
+    }
+  vtkIdType numberOfPoints = points->GetNumberOfPoints();
+  if (this->MaximumNumberOfControlPoints >= 0 && this->GetNumberOfControlPoints() + numberOfPoints > this->MaximumNumberOfControlPoints)
+    {
+    vtkErrorMacro("AddControlPoints: number of existing points (" << this->GetNumberOfControlPoints()
+      << ") plus requested number of new points (" << numberOfPoints << ") are more than maximum number of control points allowed ("
+      << this->MaximumNumberOfControlPoints << ")");
+    return -1;
+    }
+  if (this->GetFixedNumberOfControlPoints())
+    {
+    vtkErrorMacro("AddControlPoints: Markup node control point number is locked.");
+    return -1;
+    }
+
+  MRMLNodeModifyBlocker blocker(this);
+  // Label format is the same for all the new points
+  std::string labelFormat = (label.empty() ? this->ReplaceListNameInControlPointLabelFormat() : std::string());
+  this->ControlPoints.reserve(this->ControlPoints.size() + numberOfPoints);
+  int controlPointIndex = -1;
+  for (vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
+    {
+    ControlPoint* controlPoint = new ControlPoint;
+    points->GetPoint(pointIndex, controlPoint->Position);
+    controlPoint->PositionStatus = PositionDefined;
+    controlPoint->ID = this->GenerateUniqueControlPointID();
+    controlPoint->Label = (label.empty() ? FormatControlPointLabel(labelFormat, this->LastUsedControlPointNumber) : label);
+    controlPointIndex = this->AddControlPoint(controlPoint, false);
+    }
+  return controlPointIndex;
+}
+
+//---------------------------------------------------------------------------
+int vtkMRMLMarkupsNode::AddControlPointsWorld(vtkPoints* pointsWorld, std::string label /*=std::string()*/)
+{
+  vtkMRMLTransformNode* transformNode = this->GetParentTransformNode();
+  if (!pointsWorld || !transformNode)
+    {
+    return this->AddControlPoints(pointsWorld, label);
     }
+  vtkNew<vtkGeneralTransform> transformFromWorld;
+  transformNode->GetTransformFromWorld(transformFromWorld);
+  vtkNew<vtkPoints> points;
+  points->SetDataTypeToDouble();
+  transformFromWorld->TransformPoints(pointsWorld, points);
+  return this->AddControlPoints(points, label);
 }
 
 //---------------------------------------------------------------------------
@@ -83,6 +83,12 @@ class  VTK_SLICER_MARKUPS_MODULE_MRML_EXPORT vtkMRMLMarkupsNode : public vtkMRML
 
 public:
 
+  /// Control points are stored as separately allocated ControlPoint structs, which are exposed
+  /// by GetNthControlPoint() and GetControlPoints(). Each point keeps its own strings and
+  /// orientation, therefore memory usage grows by a few hundred bytes per point. For lists of
+  /// many points the bulk methods (AddControlPoints(), SetControlPointPositions(),
+  /// GetControlPointPositions() and their world coordinate variants) avoid the per-point
+  /// transform lookups and modified events, but not the per-point memory usage.
   struct ControlPoint
     {
     ControlPoint()
@@ -317,6 +323,25 @@ public:
   /// Get a copy of all control point positions in world coordinate system
   void GetControlPointPositionsWorld(vtkPoints* points);
 
+  /// Set all control point positions from a point list, in the node coordinate system.
+  /// Works the same way as SetControlPointPositionsWorld.
+  void SetControlPointPositions(vtkPoints* points);
+
+  /// Get a copy of all control point positions in the node coordinate system
+  void GetControlPointPositions(vtkPoints* points);
+
+  ///@{
+  /// Add a new control point at each position of a point list (in the node or world coordinate system).
+  /// Points are added in a single batch, which is much faster than adding control points one by one
+  /// (for example, when creating point lists of many thousands of points from a numpy array).
+  /// If label is empty then labels are generated automatically.
+  /// If requested number of points would result more points than the maximum allowed number of points
+  /// then no points are added at all.
+  /// Return index of the last added control point, -1 on failure.
+  int AddControlPoints(vtkPoints* points, std::string label = std::string());
+  int AddControlPointsWorld(vtkPoints* pointsWorld, std::string label = std::string());
+  ///@}
+
   ///@{
   /// Add a new control point, returning the point index, -1 on failure.
   int AddControlPoint(vtkVector3d point, std::string label = std::string());
@@ -33,6 +33,8 @@
 #include <vtkPointLocator.h>
 #include <vtkTransformPolyDataFilter.h>
 
+#include <algorithm>
+
 //------------------------------------------------------------------------------
 vtkStandardNewMacro(vtkProjectMarkupsCurvePointsFilter);
 
@@ -70,6 +72,12 @@ double vtkProjectMarkupsCurvePointsFilter::GetMaximumSearchRadiusTolerance() con
   return this->MaximumSearchRadiusTolerance;
 }
 
+//------------------------------------------------------------------------------
+vtkIdType vtkProjectMarkupsCurvePointsFilter::GetNumberOfProjectedPoints() const
+{
+  return this->NumberOfProjectedPoints;
+}
+
 //---------------------------------------------------------------------------
 int vtkProjectMarkupsCurvePointsFilter::FillInputPortInformation(int port, vtkInformation* info)
 {
@@ -153,12 +161,33 @@ bool vtkProjectMarkupsCurvePointsFilter::ConstrainPointsToSurfaceImpl(vtkOBBTree
     return false;
     }
 
-  double tolerance = surfaceObbTree->GetTolerance();
+  double rayLength = vtkProjectMarkupsCurvePointsFilter::GetRayLength(surfacePolydata, maximumSearchRadiusTolerance);
 
   double originalPoint[3] = { 0.0, 0.0, 0.0 };
   double rayDirection[3] = { 0.0, 0.0, 0.0 };
   double exteriorPoint[3] = { 0.0, 0.0, 0.0 };
+  size_t noIntersectionCount = 0;
+  for (vtkIdType controlPointIndex = 0; controlPointIndex < originalPoints->GetNumberOfPoints(); controlPointIndex++)
+    {
+    originalPoints->GetPoint(controlPointIndex, originalPoint);
+    normalVectors->GetTuple(controlPointIndex, rayDirection);
+    if (!vtkProjectMarkupsCurvePointsFilter::ConstrainPointToSurface(surfaceObbTree, pointLocator, surfacePolydata,
+      originalPoint, rayDirection, rayLength, exteriorPoint))
+      {
+      ++noIntersectionCount;
+      }
+    surfacePoints->InsertNextPoint(exteriorPoint);
+    }
+  if (noIntersectionCount > 0)
+    {
+    vtkGenericWarningMacro("No intersections found for " << noIntersectionCount << " points for curve ");
+    }
+  return true;
+}
 
+//---------------------------------------------------------------------------
+double vtkProjectMarkupsCurvePointsFilter::GetRayLength(vtkPolyData* surfacePolydata, double maximumSearchRadiusTolerance)
+{
   // Curves are expected to be close to surface. The maximumSearchRadiusTolerance
   // sets the allowable projection distance as a percentage of the model's
   // bounding box diagonal in world coordinate system.
@@ -167,45 +196,42 @@ bool vtkProjectMarkupsCurvePointsFilter::ConstrainPointsToSurfaceImpl(vtkOBBTree
   vtkBoundingBox modelBoundingBox;
   modelBoundingBox.AddBounds(polydataBounds);
   double polydataDiagonalLength = modelBoundingBox.GetDiagonalLength();
-  double rayLength = maximumSearchRadiusTolerance*sqrt(polydataDiagonalLength);
+  return maximumSearchRadiusTolerance*sqrt(polydataDiagonalLength);
+}
 
-  size_t noIntersectionCount = 0;
-  for (vtkIdType controlPointIndex = 0; controlPointIndex < originalPoints->GetNumberOfPoints(); controlPointIndex++)
+//---------------------------------------------------------------------------
+bool vtkProjectMarkupsCurvePointsFilter::ConstrainPointToSurface(vtkOBBTree* surfaceObbTree, vtkPointLocator* pointLocator,
+  vtkPolyData* surfacePolydata, const double originalPoint[3], const double rayDirection[3], double rayLength, double surfacePoint[3])
+{
+  double tolerance = surfaceObbTree->GetTolerance();
+
+  // Cast ray and find model intersection point
+  double rayStartPoint[3] = { originalPoint[0], originalPoint[1], originalPoint[2] };
+  double rayEndPoint[3] = { 0.0, 0.0, 0.0 };
+  rayEndPoint[0] = originalPoint[0] + rayDirection[0] * rayLength;
+  rayEndPoint[1] = originalPoint[1] + rayDirection[1] * rayLength;
+  rayEndPoint[2] = originalPoint[2] + rayDirection[2] * rayLength;
+
+  double t = 0.0;
+  double pcoords[3] = { 0.0, 0.0, 0.0 };
+  int subId = 0;
+  vtkIdType cellId = 0;
+  vtkNew <vtkGenericCell> cell;
+  int foundIntersection = surfaceObbTree->IntersectWithLine(rayEndPoint, rayStartPoint, tolerance, t, surfacePoint, pcoords, subId, cellId, cell);
+  if (foundIntersection == 0)
     {
-    originalPoints->GetPoint(controlPointIndex, originalPoint);
-    normalVectors->GetTuple(controlPointIndex, rayDirection);
-    // Cast ray and find model intersection point
-    double rayEndPoint[3] = { 0.0, 0.0, 0.0 };
-    rayEndPoint[0] = originalPoint[0] + rayDirection[0] * rayLength;
-    rayEndPoint[1] = originalPoint[1] + rayDirection[1] * rayLength;
-    rayEndPoint[2] = originalPoint[2] + rayDirection[2] * rayLength;
-
-    double t = 0.0;
-    double pcoords[3] = { 0.0, 0.0, 0.0 };
-    int subId = 0;
-    vtkIdType cellId = 0;
-    vtkNew <vtkGenericCell> cell;
-    int foundIntersection = surfaceObbTree->IntersectWithLine(rayEndPoint, originalPoint, tolerance, t, exteriorPoint, pcoords, subId, cellId, cell);
-    if(foundIntersection == 0)
+    // If no intersection, reverse direction of normal vector ray
+    rayEndPoint[0] = originalPoint[0] + rayDirection[0] * -rayLength;
+    rayEndPoint[1] = originalPoint[1] + rayDirection[1] * -rayLength;
+    rayEndPoint[2] = originalPoint[2] + rayDirection[2] * -rayLength;
+    foundIntersection = surfaceObbTree->IntersectWithLine(rayStartPoint, rayEndPoint, tolerance, t, surfacePoint, pcoords, subId, cellId, cell);
+    if (foundIntersection == 0)
       {
-      // If no intersection, reverse direction of normal vector ray
-      rayEndPoint[0] = originalPoint[0] + rayDirection[0] * -rayLength;
-      rayEndPoint[1] = originalPoint[1] + rayDirection[1] * -rayLength;
-      rayEndPoint[2] = originalPoint[2] + rayDirection[2] * -rayLength;
-      int foundIntersection = surfaceObbTree->IntersectWithLine(originalPoint, rayEndPoint, tolerance, t, exteriorPoint, pcoords, subId, cellId, cell);
-      if(foundIntersection == 0)
-        {
-        // If no intersection in either direction, use closest mesh point
-        vtkIdType closestPointId = pointLocator->FindClosestPoint(originalPoint);
-        surfacePolydata->GetPoint(closestPointId, exteriorPoint);
-        ++noIntersectionCount;
-        }
+      // If no intersection in either direction, use closest mesh point
+      vtkIdType closestPointId = pointLocator->FindClosestPoint(originalPoint);
+      surfacePolydata->GetPoint(closestPointId, surfacePoint);
+      return false;
       }
-    surfacePoints->InsertNextPoint(exteriorPoint);
-    }
-  if (noIntersectionCount > 0)
-    {
-    vtkGenericWarningMacro("No intersections found for " << noIntersectionCount << " points for curve ");
     }
   return true;
 }
@@ -244,16 +270,69 @@ bool vtkProjectMarkupsCurvePointsFilter::ProjectPointsToSurface(
 
   vtkNew<vtkPoints> controlPoints;
   this->InputCurveNode->GetControlPointPositionsWorld(controlPoints);
+  if (controlPoints->GetNumberOfPoints() < 2)
+    {
+    // Projection direction cannot be determined
+    outputPoints->DeepCopy(pointsToProject);
+    return true;
+    }
 
-  auto pointNormalArray = this->PointProjection.GetPointNormals(pointsToProject, controlPoints);
-  if (!pointNormalArray)
+  // Projected points of the previous execution can only be reused if the surface is unchanged
+  if (this->CachedSurfaceUpdateTime != this->PointProjection.GetSurfaceUpdateTime()
+    || this->CachedMaximumSearchRadiusTolerance != maximumSearchRadiusTolerance)
     {
-    return false;
+    this->CachedProjectionInputs.clear();
+    this->CachedProjectedPoints.clear();
     }
+  vtkIdType numberOfCachedPoints = static_cast<vtkIdType>(this->CachedProjectedPoints.size() / 3);
+
+  vtkOBBTree* surfaceObbTree = this->PointProjection.GetObbTree();
+  vtkPointLocator* pointLocator = this->PointProjection.GetPointLocator();
+  double rayLength = vtkProjectMarkupsCurvePointsFilter::GetRayLength(surfacePolydata, maximumSearchRadiusTolerance);
 
-  return vtkProjectMarkupsCurvePointsFilter::ConstrainPointsToSurfaceImpl(this->PointProjection.GetObbTree(), this->PointProjection.GetPointLocator(),
-    pointsToProject, pointNormalArray, surfacePolydata,
-    outputPoints, maximumSearchRadiusTolerance);
+  const vtkIdType numberOfPoints = pointsToProject->GetNumberOfPoints();
+  std::vector<double> projectionInputs(9 * numberOfPoints);
+  std::vector<double> projectedPoints(3 * numberOfPoints);
+  this->NumberOfProjectedPoints = 0;
+  size_t noIntersectionCount = 0;
+  for (vtkIdType pointIndex = 0; pointIndex < numberOfPoints; ++pointIndex)
+    {
+    // Projection of a point is determined by its position and the closest control points
+    double* pointInputs = &projectionInputs[9 * pointIndex];
+    double* projectedPoint = &projectedPoints[3 * pointIndex];
+    pointsToProject->GetPoint(pointIndex, pointInputs);
+    PointProjectionHelper::GetSegmentEndPoints(pointInputs, controlPoints, pointInputs + 3, pointInputs + 6);
+    if (pointIndex < numberOfCachedPoints
+      && std::equal(pointInputs, pointInputs + 9, this->CachedProjectionInputs.begin() + 9 * pointIndex))
+      {
+      std::copy_n(this->CachedProjectedPoints.begin() + 3 * pointIndex, 3, projectedPoint);
+      continue;
+      }
+    double rayDirection[3] = { 0.0, 0.0, 0.0 };
+    this->PointProjection.GetPointNormal(pointInputs, pointInputs + 3, pointInputs + 6, rayDirection);
+    if (!vtkProjectMarkupsCurvePointsFilter::ConstrainPointToSurface(surfaceObbTree, pointLocator, surfacePolydata,
+      pointInputs, rayDirection, rayLength, projectedPoint))
+      {
+      ++noIntersectionCount;
+      }
+    ++this->NumberOfProjectedPoints;
+    }
+  if (noIntersectionCount > 0)
+    {
+    vtkWarningMacro("No intersections found for " << noIntersectionCount << " points for curve ");
+    }
+
+  outputPoints->SetNumberOfPoints(numberOfPoints);
+  for (vtkIdType pointIndex = 0; pointIndex < numberOfPoints; ++pointIndex)
+    {
+    outputPoints->SetPoint(pointIndex, &projectedPoints[3 * pointIndex]);
+    }
+
+  this->CachedProjectionInputs.swap(projectionInputs);
+  this->CachedProjectedPoints.swap(projectedPoints);
+  this->CachedSurfaceUpdateTime = this->PointProjection.GetSurfaceUpdateTime();
+  this->CachedMaximumSearchRadiusTolerance = maximumSearchRadiusTolerance;
+  return true;
 }
 
 //---------------------------------------------------------------------------
@@ -294,6 +373,13 @@ vtkOBBTree* vtkProjectMarkupsCurvePointsFilter::PointProjectionHelper::GetObbTre
   return this->ModelObbTree;
 }
 
+//---------------------------------------------------------------------------
+vtkMTimeType vtkProjectMarkupsCurvePointsFilter::PointProjectionHelper::GetSurfaceUpdateTime()
+{
+  this->UpdateAll();
+  return this->SurfaceUpdateTime.GetMTime();
+}
+
 //---------------------------------------------------------------------------
 bool vtkProjectMarkupsCurvePointsFilter::PointProjectionHelper::UpdateAll()
 {
@@ -327,6 +413,8 @@ bool vtkProjectMarkupsCurvePointsFilter::PointProjectionHelper::UpdateAll()
       this->SurfacePolyData = transformPolydataFilter->GetOutput();
       }
 
+    this->SurfaceUpdateTime.Modified();
+
     this->ModelPointLocator = vtkSmartPointer<vtkPointLocator>::New();
     this->ModelPointLocator->SetDataSet(this->SurfacePolyData);
     this->ModelPointLocator->BuildLocator();
@@ -392,61 +480,72 @@ vtkSmartPointer<vtkDoubleArray> vtkProjectMarkupsCurvePointsFilter::PointProject
   for (vtkIdType i = 0; i < numberOfPoints; ++i)
     {
     const double* point = points->GetPoint(i);
-    const auto segmentStartIndex = GetClosestControlPointIndex(point, controlPoints);
     double segmentStartPoint[3] = { 0.0, 0.0, 0.0 };
-    controlPoints->GetPoint(segmentStartIndex, segmentStartPoint);
-    const auto segmentEndIndex = [&]() -> vtkIdType {
-      if (segmentStartIndex == 0)
-        {
-        return 1;
-        }
-      else if (segmentStartIndex == controlPoints->GetNumberOfPoints() - 1)
+    double segmentEndPoint[3] = { 0.0, 0.0, 0.0 };
+    PointProjectionHelper::GetSegmentEndPoints(point, controlPoints, segmentStartPoint, segmentEndPoint);
+    double rayDirection[3] = { 0.0, 0.0, 0.0 };
+    this->GetPointNormal(point, segmentStartPoint, segmentEndPoint, rayDirection);
+    normals->InsertNextTuple(rayDirection);
+    }
+
+    return normals;
+}
+
+//---------------------------------------------------------------------------
+void vtkProjectMarkupsCurvePointsFilter::PointProjectionHelper::GetSegmentEndPoints(const double point[3], vtkPoints* controlPoints,
+  double segmentStartPoint[3], double segmentEndPoint[3])
+{
+  const auto segmentStartIndex = GetClosestControlPointIndex(point, controlPoints);
+  controlPoints->GetPoint(segmentStartIndex, segmentStartPoint);
+  const auto segmentEndIndex = [&]() -> vtkIdType {
+    if (segmentStartIndex == 0)
+      {
+      return 1;
+      }
+    else if (segmentStartIndex == controlPoints->GetNumberOfPoints() - 1)
+      {
+      return segmentStartIndex - 1;
+      }
+    else
+      {
+      double segmentEndPoint1[3] = { 0.0, 0.0, 0.0 };
+      controlPoints->GetPoint(segmentStartIndex - 1, segmentEndPoint1);
+      double dist1 = vtkMath::Distance2BetweenPoints(segmentEndPoint1, point);
+      double segmentEndPoint2[3];
+      controlPoints->GetPoint(segmentStartIndex + 1, segmentEndPoint2);
+      double dist2 = vtkMath::Distance2BetweenPoints(segmentEndPoint2, point);
+
+      if ((dist1 < dist2) && dist1 < vtkMath::Distance2BetweenPoints(segmentEndPoint1, segmentStartPoint))
         {
         return segmentStartIndex - 1;
         }
       else
         {
-        double segmentEndPoint1[3] = { 0.0, 0.0, 0.0 };
-        controlPoints->GetPoint(segmentStartIndex - 1, segmentEndPoint1);
-        double dist1 = vtkMath::Distance2BetweenPoints(segmentEndPoint1, point);
-        double segmentEndPoint2[3];
-        controlPoints->GetPoint(segmentStartIndex + 1, segmentEndPoint2);
-        double dist2 = vtkMath::Distance2BetweenPoints(segmentEndPoint2, point);
-
-        if ((dist1 < dist2) && dist1 < vtkMath::Distance2BetweenPoints(segmentEndPoint1, segmentStartPoint))
-          {
-          return segmentStartIndex - 1;
-          }
-        else
-          {
-          return segmentStartIndex + 1;
-          }
+        return segmentStartIndex + 1;
         }
-      }();
-    double segmentEndPoint[3] = { 0.0, 0.0, 0.0 };
-    controlPoints->GetPoint(segmentEndIndex, segmentEndPoint);
-
-    const auto distance2ToStart = vtkMath::Distance2BetweenPoints(point, segmentStartPoint);
-    const auto distance2ToEnd = vtkMath::Distance2BetweenPoints(point, segmentEndPoint);
-
-    vtkIdType pointIdStart = this->ModelPointLocator->FindClosestPoint(segmentStartPoint);
-    double startNormal[3] = { 0.0, 0.0, 0.0 };
-    this->ModelNormalVectorArray->GetTuple(pointIdStart, startNormal);
-    vtkIdType pointIdEnd = this->ModelPointLocator->FindClosestPoint(segmentEndPoint);
-    double endNormal[3] = { 0.0, 0.0, 0.0 };
-    this->ModelNormalVectorArray->GetTuple(pointIdEnd, endNormal);
-
-    const double startWeight = distance2ToEnd / (distance2ToStart + distance2ToEnd);
-    const double endWeight = distance2ToStart / (distance2ToStart + distance2ToEnd);
-    double rayDirection[3] =
-      {
-      (startWeight * startNormal[0]) + (endWeight * endNormal[0]),
-      (startWeight * startNormal[1]) + (endWeight * endNormal[1]),
-      (startWeight * startNormal[2]) + (endWeight * endNormal[2])
-      };
-    vtkMath::Normalize(rayDirection);
-    normals->InsertNextTuple(rayDirection);
-    }
+      }
+    }();
+  controlPoints->GetPoint(segmentEndIndex, segmentEndPoint);
+}
 
-    return normals;
+//---------------------------------------------------------------------------
+void vtkProjectMarkupsCurvePointsFilter::PointProjectionHelper::GetPointNormal(const double point[3],
+  const double segmentStartPoint[3], const double segmentEndPoint[3], double normal[3])
+{
+  const auto distance2ToStart = vtkMath::Distance2BetweenPoints(point, segmentStartPoint);
+  const auto distance2ToEnd = vtkMath::Distance2BetweenPoints(point, segmentEndPoint);
+
+  vtkIdType pointIdStart = this->ModelPointLocator->FindClosestPoint(segmentStartPoint);
+  double startNormal[3] = { 0.0, 0.0, 0.0 };
+  this->ModelNormalVectorArray->GetTuple(pointIdStart, startNormal);
+  vtkIdType pointIdEnd = this->ModelPointLocator->FindClosestPoint(segmentEndPoint);
+  double endNormal[3] = { 0.0, 0.0, 0.0 };
+  this->ModelNormalVectorArray->GetTuple(pointIdEnd, endNormal);
+
+  const double startWeight = distance2ToEnd / (distance2ToStart + distance2ToEnd);
+  const double endWeight = distance2ToStart / (distance2ToStart + distance2ToEnd);
+  normal[0] = (startWeight * startNormal[0]) + (endWeight * endNormal[0]);
+  normal[1] = (startWeight * startNormal[1]) + (endWeight * endNormal[1]);
+  normal[2] = (startWeight * startNormal[2]) + (endWeight * endNormal[2]);
+  vtkMath::Normalize(normal);
 }
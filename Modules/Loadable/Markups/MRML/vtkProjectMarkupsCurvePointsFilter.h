@@ -22,8 +22,11 @@
 
 #include <vtkInformation.h>
 #include <vtkPolyDataAlgorithm.h>
+#include <vtkTimeStamp.h>
 #include <vtkWeakPointer.h>
 
+#include <vector>
+
 class vtkDoubleArray;
 class vtkOBBTree;
 class vtkPointLocator;
@@ -42,6 +45,9 @@ class vtkMRMLModelNode;
 /// to a surface. It is expected that the points given to SetInputData/SetInputConnection are
 /// actually along the curve defined by the curve node's control point positions world.
 ///
+/// Projected points are cached. A point is only projected again if its position, the control points
+/// that determine its projection direction, or the surface have changed since the previous execution.
+///
 /// This class is not meant to be a general purpose point projection filter.
 class VTK_SLICER_MARKUPS_MODULE_MRML_EXPORT vtkProjectMarkupsCurvePointsFilter : public vtkPolyDataAlgorithm
 {
@@ -100,6 +106,10 @@ public:
   double GetMaximumSearchRadiusTolerance() const;
   ///@}
 
+  /// Get number of points that were projected during the last execution.
+  /// Projection of other points was reused from the previous execution.
+  vtkIdType GetNumberOfProjectedPoints() const;
+
 protected:
   int FillInputPortInformation(int port, vtkInformation* info) override;
   int RequestData(vtkInformation* request, vtkInformationVector** inputVector, vtkInformationVector* outputVector) override;
@@ -113,6 +123,12 @@ private:
   static bool ConstrainPointsToSurfaceImpl(vtkOBBTree* surfaceObbTree, vtkPointLocator* pointLocator,
       vtkPoints* originalPoints, vtkDoubleArray* normalVectors, vtkPolyData* surfacePolydata,
       vtkPoints* surfacePoints, double maximumSearchRadius=.25);
+  /// Returns the length of the rays that are cast from the points to find the surface.
+  static double GetRayLength(vtkPolyData* surfacePolydata, double maximumSearchRadiusTolerance);
+  /// Find the point on the surface along the ray direction (or closest surface point if there is no intersection).
+  /// Returns false if there is no intersection.
+  static bool ConstrainPointToSurface(vtkOBBTree* surfaceObbTree, vtkPointLocator* pointLocator, vtkPolyData* surfacePolydata,
+      const double originalPoint[3], const double rayDirection[3], double rayLength, double surfacePoint[3]);
 
   class PointProjectionHelper
   {
@@ -122,6 +138,15 @@ private:
     /// Gets the point normals on the model at the points with the given controlPoints.
     /// Both points and control points must have no outstanding transformations.
     vtkSmartPointer<vtkDoubleArray> GetPointNormals(vtkPoints* points, vtkPoints* controlPoints);
+    /// Gets the control points that determine the normal at a point.
+    static void GetSegmentEndPoints(const double point[3], vtkPoints* controlPoints,
+      double segmentStartPoint[3], double segmentEndPoint[3]);
+    /// Gets the point normal from the model normals at the segment end points.
+    /// The surface is not updated, therefore GetSurfacePolyData() must be called before this method.
+    void GetPointNormal(const double point[3], const double segmentStartPoint[3], const double segmentEndPoint[3],
+      double normal[3]);
+    /// Time when the surface locators and normals were last rebuilt.
+    vtkMTimeType GetSurfaceUpdateTime();
     vtkPointLocator* GetPointLocator();
     vtkOBBTree* GetObbTree();
     vtkPolyData* GetSurfacePolyData();
@@ -134,12 +159,22 @@ private:
     vtkSmartPointer<vtkPointLocator> ModelPointLocator;
     vtkSmartPointer<vtkOBBTree> ModelObbTree;
     vtkSmartPointer<vtkPolyData> SurfacePolyData;
+    vtkTimeStamp SurfaceUpdateTime;
 
     bool UpdateAll();
     static vtkIdType GetClosestControlPointIndex(const double point[3], vtkPoints* controlPoints);
   };
 
   PointProjectionHelper PointProjection;
+
+  /// Projection results of the previous execution.
+  /// For each point: point position, segment start point, and segment end point (9 values).
+  std::vector<double> CachedProjectionInputs;
+  /// For each point: projected point position (3 values).
+  std::vector<double> CachedProjectedPoints;
+  vtkMTimeType CachedSurfaceUpdateTime{0};
+  double CachedMaximumSearchRadiusTolerance{0.0};
+  vtkIdType NumberOfProjectedPoints{0};
 };
 
 #endif
@@ -0,0 +1,329 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Markups MRML includes
+#include "vtkCurveMeasurementsCalculator.h"
+#include "vtkMRMLMarkupsCurveNode.h"
+#include "vtkProjectMarkupsCurvePointsFilter.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLMeasurement.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkNew.h>
+#include <vtkParallelTransportFrame.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void CreateHelix(vtkPoints* points, int numberOfPoints)
+{
+  points->SetDataTypeToDouble();
+  points->SetNumberOfPoints(numberOfPoints);
+  for (int i = 0; i < numberOfPoints; i++)
+    {
+    double angle = i * 0.5;
+    points->SetPoint(i, 20.0 * cos(angle), 20.0 * sin(angle), 3.0 * i);
+    }
+}
+
+//----------------------------------------------------------------------------
+void MoveControlPoint(vtkMRMLMarkupsCurveNode* curveNode, int pointIndex, double offset)
+{
+  double position[3] = { 0.0, 0.0, 0.0 };
+  curveNode->GetNthControlPointPositionWorld(pointIndex, position);
+  position[0] += offset;
+  curveNode->SetNthControlPointPositionWorld(pointIndex, position);
+}
+
+//----------------------------------------------------------------------------
+int CheckArraysEqual(vtkDataArray* array1, vtkDataArray* array2)
+{
+  CHECK_NOT_NULL(array1);
+  CHECK_NOT_NULL(array2);
+  CHECK_INT(array1->GetNumberOfTuples(), array2->GetNumberOfTuples());
+  for (vtkIdType i = 0; i < array1->GetNumberOfTuples(); ++i)
+    {
+    CHECK_DOUBLE_TOLERANCE(array1->GetComponent(i, 0), array2->GetComponent(i, 0), 1e-9);
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+double GetMeasurementValue(vtkMRMLMarkupsCurveNode* curveNode, const char* name)
+{
+  return curveNode->GetMeasurement(name)->GetValue();
+}
+
+//----------------------------------------------------------------------------
+int CheckSameAsFullComputation(vtkCurveMeasurementsCalculator* calculator, vtkMRMLMarkupsCurveNode* curveNode)
+{
+  calculator->Update();
+  vtkPointData* pointData = calculator->GetOutput()->GetPointData();
+  double meanCurvature = GetMeasurementValue(curveNode, vtkCurveMeasurementsCalculator::GetMeanCurvatureName());
+  double maxCurvature = GetMeasurementValue(curveNode, vtkCurveMeasurementsCalculator::GetMaxCurvatureName());
+  double meanTorsion = GetMeasurementValue(curveNode, vtkCurveMeasurementsCalculator::GetMeanTorsionName());
+  double maxTorsion = GetMeasurementValue(curveNode, vtkCurveMeasurementsCalculator::GetMaxTorsionName());
+
+  vtkNew<vtkCurveMeasurementsCalculator> fullCalculator;
+  fullCalculator->SetInputMarkupsMRMLNode(curveNode);
+  fullCalculator->SetInputConnection(calculator->GetInputConnection(0, 0));
+  fullCalculator->SetCurveIsClosed(calculator->GetCurveIsClosed());
+  fullCalculator->CalculateCurvatureOn();
+  fullCalculator->CalculateTorsionOn();
+  fullCalculator->Update();
+  vtkPointData* fullPointData = fullCalculator->GetOutput()->GetPointData();
+
+  CHECK_EXIT_SUCCESS(CheckArraysEqual(pointData->GetArray(vtkCurveMeasurementsCalculator::GetCurvatureArrayName()),
+    fullPointData->GetArray(vtkCurveMeasurementsCalculator::GetCurvatureArrayName())));
+  CHECK_EXIT_SUCCESS(CheckArraysEqual(pointData->GetArray(vtkCurveMeasurementsCalculator::GetTorsionArrayName()),
+    fullPointData->GetArray(vtkCurveMeasurementsCalculator::GetTorsionArrayName())));
+  CHECK_DOUBLE_TOLERANCE(meanCurvature, GetMeasurementValue(curveNode, vtkCurveMeasurementsCalculator::GetMeanCurvatureName()), 1e-9);
+  CHECK_DOUBLE_TOLERANCE(maxCurvature, GetMeasurementValue(curveNode, vtkCurveMeasurementsCalculator::GetMaxCurvatureName()), 1e-9);
+  CHECK_DOUBLE_TOLERANCE(meanTorsion, GetMeasurementValue(curveNode, vtkCurveMeasurementsCalculator::GetMeanTorsionName()), 1e-9);
+  CHECK_DOUBLE_TOLERANCE(maxTorsion, GetMeasurementValue(curveNode, vtkCurveMeasurementsCalculator::GetMaxTorsionName()), 1e-9);
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void CreatePlane(vtkPolyData* polyData, int size)
+{
+  vtkNew<vtkPoints> points;
+  vtkNew<vtkCellArray> polys;
+  for (int y = 0; y <= size; y++)
+    {
+    for (int x = 0; x <= size; x++)
+      {
+      points->InsertNextPoint(x - size / 2.0, y - size / 2.0, 0.0);
+      }
+    }
+  for (int y = 0; y < size; y++)
+    {
+    for (int x = 0; x < size; x++)
+      {
+      vtkIdType p0 = y * (size + 1) + x;
+      vtkIdType triangle1[3] = { p0, p0 + 1, p0 + size + 2 };
+      vtkIdType triangle2[3] = { p0, p0 + size + 2, p0 + size + 1 };
+      polys->InsertNextCell(3, triangle1);
+      polys->InsertNextCell(3, triangle2);
+      }
+    }
+  polyData->SetPoints(points);
+  polyData->SetPolys(polys);
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int TestIncrementalCurveMeasurements(const char* className)
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLMarkupsCurveNode* curveNode = vtkMRMLMarkupsCurveNode::SafeDownCast(scene->AddNewNodeByClass(className));
+  vtkNew<vtkPoints> controlPoints;
+  CreateHelix(controlPoints, 20);
+  curveNode->SetControlPointPositionsWorld(controlPoints);
+  curveNode->GetMeasurement(vtkCurveMeasurementsCalculator::GetMeanCurvatureName())->SetEnabled(true);
+  curveNode->GetMeasurement(vtkCurveMeasurementsCalculator::GetMaxCurvatureName())->SetEnabled(true);
+  curveNode->GetMeasurement(vtkCurveMeasurementsCalculator::GetMeanTorsionName())->SetEnabled(true);
+  curveNode->GetMeasurement(vtkCurveMeasurementsCalculator::GetMaxTorsionName())->SetEnabled(true);
+
+  vtkNew<vtkCurveMeasurementsCalculator> calculator;
+  calculator->SetInputMarkupsMRMLNode(curveNode);
+  calculator->SetInputConnection(curveNode->GetCurveCoordinateSystemGeneratorWorld()->GetOutputPort());
+  calculator->SetCurveIsClosed(curveNode->GetCurveClosed());
+  calculator->CalculateCurvatureOn();
+  calculator->CalculateTorsionOn();
+  calculator->Update();
+  vtkIdType numberOfCurvePoints = calculator->GetOutput()->GetNumberOfPoints();
+  CHECK_BOOL(numberOfCurvePoints > 100, true);
+
+  // First execution computes all values (except at the curve end points)
+  vtkIdType numberOfComputedValues = calculator->GetNumberOfUpdatedCurvatureValues();
+  CHECK_BOOL(numberOfComputedValues >= numberOfCurvePoints - 3, true);
+  CHECK_INT(calculator->GetNumberOfUpdatedTorsionValues(), numberOfComputedValues);
+  CHECK_EXIT_SUCCESS(CheckSameAsFullComputation(calculator, curveNode));
+
+  // Moving a control point only updates curvature in its neighborhood
+  MoveControlPoint(curveNode, 10, 5.0);
+  calculator->Update();
+  CHECK_BOOL(calculator->GetNumberOfUpdatedCurvatureValues() > 0, true);
+  CHECK_BOOL(calculator->GetNumberOfUpdatedCurvatureValues() < numberOfCurvePoints / 2, true);
+  if (!curveNode->GetCurveClosed())
+    {
+    // Frames are only changed after the moved point
+    CHECK_BOOL(calculator->GetNumberOfUpdatedTorsionValues() < numberOfComputedValues, true);
+    }
+  CHECK_EXIT_SUCCESS(CheckSameAsFullComputation(calculator, curveNode));
+
+  // Moving the end points
+  MoveControlPoint(curveNode, 0, -5.0);
+  CHECK_EXIT_SUCCESS(CheckSameAsFullComputation(calculator, curveNode));
+  MoveControlPoint(curveNode, 19, 5.0);
+  CHECK_EXIT_SUCCESS(CheckSameAsFullComputation(calculator, curveNode));
+
+  // Moving back a point may decrease the maximum
+  MoveControlPoint(curveNode, 10, -5.0);
+  CHECK_EXIT_SUCCESS(CheckSameAsFullComputation(calculator, curveNode));
+
+  // Adding a control point changes the number of curve points
+  curveNode->AddControlPoint(vtkVector3d(0.0, 0.0, 100.0));
+  calculator->Update();
+  CHECK_BOOL(calculator->GetNumberOfUpdatedCurvatureValues() > numberOfComputedValues, true);
+  CHECK_EXIT_SUCCESS(CheckSameAsFullComputation(calculator, curveNode));
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestIncrementalProjection()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(scene->AddNewNodeByClass("vtkMRMLModelNode"));
+  vtkNew<vtkPolyData> plane;
+  CreatePlane(plane, 40);
+  modelNode->SetAndObservePolyData(plane);
+
+  vtkMRMLMarkupsCurveNode* curveNode = vtkMRMLMarkupsCurveNode::SafeDownCast(
+    scene->AddNewNodeByClass("vtkMRMLMarkupsCurveNode"));
+  vtkNew<vtkPoints> controlPoints;
+  controlPoints->SetDataTypeToDouble();
+  for (int i = 0; i < 5; i++)
+    {
+    controlPoints->InsertNextPoint(-15.0 + 7.5 * i, 0.0, 0.5);
+    }
+  curveNode->SetControlPointPositionsWorld(controlPoints);
+  curveNode->SetAndObserveSurfaceConstraintNode(modelNode);
+
+  // Points to project
+  const int numberOfPoints = 61;
+  vtkNew<vtkPoints> points;
+  points->SetDataTypeToDouble();
+  for (int i = 0; i < numberOfPoints; i++)
+    {
+    points->InsertNextPoint(-15.0 + 0.5 * i, 0.0, 0.5);
+    }
+  vtkNew<vtkPolyData> curvePoly;
+  curvePoly->SetPoints(points);
+
+  vtkNew<vtkProjectMarkupsCurvePointsFilter> projectFilter;
+  projectFilter->SetInputCurveNode(curveNode);
+  projectFilter->SetInputData(curvePoly);
+  projectFilter->Update();
+  CHECK_INT(projectFilter->GetNumberOfProjectedPoints(), numberOfPoints);
+  CHECK_DOUBLE_TOLERANCE(projectFilter->GetOutput()->GetPoint(30)[2], 0.0, 1e-6);
+
+  // Only the modified point is projected again
+  points->SetPoint(30, 0.25, 1.0, 0.75);
+  points->Modified();
+  projectFilter->Update();
+  CHECK_INT(projectFilter->GetNumberOfProjectedPoints(), 1);
+  CHECK_DOUBLE_TOLERANCE(projectFilter->GetOutput()->GetPoint(30)[1], 1.0, 1e-6);
+  CHECK_DOUBLE_TOLERANCE(projectFilter->GetOutput()->GetPoint(30)[2], 0.0, 1e-6);
+
+  // Moving a control point changes the projection direction of points in its neighborhood
+  double controlPoint[3] = { 0.0, 0.0, 0.0 };
+  curveNode->GetNthControlPointPositionWorld(2, controlPoint);
+  controlPoint[1] = 0.5;
+  curveNode->SetNthControlPointPositionWorld(2, controlPoint);
+  projectFilter->Modified();
+  projectFilter->Update();
+  CHECK_BOOL(projectFilter->GetNumberOfProjectedPoints() > 0, true);
+  CHECK_BOOL(projectFilter->GetNumberOfProjectedPoints() < numberOfPoints, true);
+
+  vtkNew<vtkProjectMarkupsCurvePointsFilter> fullProjectFilter;
+  fullProjectFilter->SetInputCurveNode(curveNode);
+  fullProjectFilter->SetInputData(curvePoly);
+  fullProjectFilter->Update();
+  for (int i = 0; i < numberOfPoints; i++)
+    {
+    for (int c = 0; c < 3; c++)
+      {
+      CHECK_DOUBLE_TOLERANCE(projectFilter->GetOutput()->GetPoint(i)[c], fullProjectFilter->GetOutput()->GetPoint(i)[c], 1e-9);
+      }
+    }
+
+  // Modifying the surface invalidates all projected points
+  plane->GetPoints()->Modified();
+  plane->Modified();
+  modelNode->Modified();
+  projectFilter->Modified();
+  projectFilter->Update();
+  CHECK_INT(projectFilter->GetNumberOfProjectedPoints(), numberOfPoints);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestRepeatedIncrementalCurveMeasurements()
+{
+  const int numberOfControlPoints = 100;
+  // More moves than the number of incremental updates after which the sums are recomputed
+  const int numberOfMoves = 250;
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLMarkupsCurveNode* curveNode = vtkMRMLMarkupsCurveNode::SafeDownCast(
+    scene->AddNewNodeByClass("vtkMRMLMarkupsCurveNode"));
+  vtkNew<vtkPoints> controlPoints;
+  CreateHelix(controlPoints, numberOfControlPoints);
+  curveNode->SetControlPointPositionsWorld(controlPoints);
+  curveNode->GetMeasurement(vtkCurveMeasurementsCalculator::GetMeanCurvatureName())->SetEnabled(true);
+  curveNode->GetMeasurement(vtkCurveMeasurementsCalculator::GetMaxCurvatureName())->SetEnabled(true);
+  curveNode->GetMeasurement(vtkCurveMeasurementsCalculator::GetMeanTorsionName())->SetEnabled(true);
+  curveNode->GetMeasurement(vtkCurveMeasurementsCalculator::GetMaxTorsionName())->SetEnabled(true);
+
+  vtkNew<vtkCurveMeasurementsCalculator> calculator;
+  calculator->SetInputMarkupsMRMLNode(curveNode);
+  calculator->SetInputConnection(curveNode->GetCurveCoordinateSystemGeneratorWorld()->GetOutputPort());
+  calculator->CalculateCurvatureOn();
+  calculator->CalculateTorsionOn();
+  calculator->Update();
+  vtkIdType numberOfCurvePoints = calculator->GetOutput()->GetNumberOfPoints();
+
+  // Dragging a control point only updates values in its neighborhood and
+  // the mean values do not drift from the values computed from all points.
+  vtkIdType numberOfUpdatedValues = 0;
+  for (int move = 0; move < numberOfMoves; ++move)
+    {
+    MoveControlPoint(curveNode, numberOfControlPoints / 2, (move % 2) ? -0.1 : 0.1);
+    calculator->Update();
+    numberOfUpdatedValues += calculator->GetNumberOfUpdatedCurvatureValues();
+    }
+  CHECK_BOOL(numberOfUpdatedValues < numberOfMoves * numberOfCurvePoints / 10, true);
+  CHECK_EXIT_SUCCESS(CheckSameAsFullComputation(calculator, curveNode));
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLMarkupsCurveNodeTest1(int , char * [] )
+{
+  CHECK_EXIT_SUCCESS(TestIncrementalCurveMeasurements("vtkMRMLMarkupsCurveNode"));
+  CHECK_EXIT_SUCCESS(TestIncrementalCurveMeasurements("vtkMRMLMarkupsClosedCurveNode"));
+  CHECK_EXIT_SUCCESS(TestIncrementalProjection());
+  CHECK_EXIT_SUCCESS(TestRepeatedIncrementalCurveMeasurements());
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
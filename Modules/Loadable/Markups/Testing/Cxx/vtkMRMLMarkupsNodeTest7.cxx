@@ -0,0 +1,194 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLCoreTestingUtilities.h"
+#include "vtkMRMLLinearTransformNode.h"
+#include "vtkMRMLMarkupsFiducialNode.h"
+#include "vtkMRMLMarkupsLineNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkTimerLog.h>
+#include <vtkTransform.h>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void CreatePoints(vtkPoints* points, int numberOfPoints, double offset)
+{
+  points->SetDataTypeToDouble();
+  points->SetNumberOfPoints(numberOfPoints);
+  for (int i = 0; i < numberOfPoints; i++)
+    {
+    points->SetPoint(i, i + offset, 2.0 * i, -i);
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int TestBulkControlPoints()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLMarkupsFiducialNode* markupsNode = vtkMRMLMarkupsFiducialNode::SafeDownCast(
+    scene->AddNewNodeByClass("vtkMRMLMarkupsFiducialNode", "F"));
+
+  vtkNew<vtkPoints> points;
+  CreatePoints(points, 5, 0.0);
+  CHECK_INT(markupsNode->AddControlPoints(points), 4);
+  CHECK_INT(markupsNode->GetNumberOfControlPoints(), 5);
+  CHECK_STD_STRING(markupsNode->GetNthControlPointLabel(0), "F-1");
+  CHECK_STD_STRING(markupsNode->GetNthControlPointLabel(4), "F-5");
+  CHECK_STD_STRING(markupsNode->GetNthControlPointID(4), "5");
+  CHECK_INT(markupsNode->GetNthControlPointPositionStatus(3), vtkMRMLMarkupsNode::PositionDefined);
+  CHECK_DOUBLE_TOLERANCE(markupsNode->GetNthControlPointPositionVector(3)[1], 6.0, 1e-9);
+  // Curve input points are updated
+  CHECK_INT(markupsNode->GetCurvePoints()->GetNumberOfPoints(), 5);
+
+  // Labels are not generated if a label is specified
+  CHECK_INT(markupsNode->AddControlPoints(points, "P"), 9);
+  CHECK_STD_STRING(markupsNode->GetNthControlPointLabel(7), "P");
+  markupsNode->AddControlPoint(vtkVector3d(1.0, 2.0, 3.0));
+  CHECK_STD_STRING(markupsNode->GetNthControlPointLabel(10), "F-11");
+
+  // Maximum number of points is respected
+  vtkNew<vtkMRMLMarkupsLineNode> lineNode;
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_INT(lineNode->AddControlPoints(points), -1);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  CHECK_INT(lineNode->GetNumberOfControlPoints(), 0);
+
+  // Set positions: existing points are updated, extra points are removed
+  vtkNew<vtkPoints> newPoints;
+  CreatePoints(newPoints, 3, 100.0);
+  markupsNode->UnsetNthControlPointPosition(1);
+  markupsNode->SetControlPointPositions(newPoints);
+  CHECK_INT(markupsNode->GetNumberOfControlPoints(), 3);
+  CHECK_INT(markupsNode->GetNthControlPointPositionStatus(1), vtkMRMLMarkupsNode::PositionDefined);
+  CHECK_DOUBLE_TOLERANCE(markupsNode->GetNthControlPointPositionVector(2)[0], 102.0, 1e-9);
+  CHECK_STD_STRING(markupsNode->GetNthControlPointLabel(0), "F-1");
+
+  // Set positions: points are added
+  markupsNode->SetControlPointPositions(points);
+  CHECK_INT(markupsNode->GetNumberOfControlPoints(), 5);
+  CHECK_DOUBLE_TOLERANCE(markupsNode->GetNthControlPointPositionVector(4)[0], 4.0, 1e-9);
+
+  // World coordinates
+  vtkNew<vtkMatrix4x4> matrix;
+  matrix->SetElement(0, 3, 10.0);
+  vtkMRMLLinearTransformNode* transformNode = vtkMRMLLinearTransformNode::SafeDownCast(
+    scene->AddNewNodeByClass("vtkMRMLLinearTransformNode"));
+  transformNode->SetMatrixTransformToParent(matrix);
+  markupsNode->SetAndObserveTransformNodeID(transformNode->GetID());
+
+  vtkNew<vtkPoints> pointsWorld;
+  markupsNode->GetControlPointPositionsWorld(pointsWorld);
+  CHECK_INT(pointsWorld->GetNumberOfPoints(), 5);
+  CHECK_DOUBLE_TOLERANCE(pointsWorld->GetPoint(4)[0], 14.0, 1e-9);
+  CHECK_INT(markupsNode->AddControlPointsWorld(pointsWorld), 9);
+  CHECK_DOUBLE_TOLERANCE(markupsNode->GetNthControlPointPositionVector(9)[0], 4.0, 1e-9);
+  markupsNode->SetControlPointPositionsWorld(pointsWorld);
+  CHECK_INT(markupsNode->GetNumberOfControlPoints(), 5);
+  CHECK_DOUBLE_TOLERANCE(markupsNode->GetNthControlPointPositionVector(2)[0], 2.0, 1e-9);
+
+  // Transform is applied to all points
+  vtkNew<vtkTransform> transform;
+  transform->Translate(0.0, 0.0, 5.0);
+  markupsNode->ApplyTransform(transform);
+  CHECK_DOUBLE_TOLERANCE(markupsNode->GetNthControlPointPositionVector(3)[2], 2.0, 1e-9);
+
+  // Fixed number of points
+  markupsNode->SetFixedNumberOfControlPoints(true);
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_INT(markupsNode->AddControlPoints(points), -1);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestLargePointListPerformance()
+{
+  const int numberOfPoints = 100000;
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkPoints> points;
+  CreatePoints(points, numberOfPoints, 0.0);
+  vtkNew<vtkTimerLog> timer;
+
+  vtkMRMLMarkupsFiducialNode* markupsNode = vtkMRMLMarkupsFiducialNode::SafeDownCast(
+    scene->AddNewNodeByClass("vtkMRMLMarkupsFiducialNode", "F"));
+  timer->StartTimer();
+  int wasModified = markupsNode->StartModify();
+  for (int i = 0; i < numberOfPoints; i++)
+    {
+    markupsNode->AddControlPoint(points->GetPoint(i));
+    }
+  markupsNode->EndModify(wasModified);
+  timer->StopTimer();
+  CHECK_INT(markupsNode->GetNumberOfControlPoints(), numberOfPoints);
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("Markups-AddControlPoint100kPoints", timer->GetElapsedTime());
+
+  vtkMRMLMarkupsFiducialNode* bulkMarkupsNode = vtkMRMLMarkupsFiducialNode::SafeDownCast(
+    scene->AddNewNodeByClass("vtkMRMLMarkupsFiducialNode", "F"));
+  timer->StartTimer();
+  bulkMarkupsNode->AddControlPoints(points);
+  timer->StopTimer();
+  CHECK_INT(bulkMarkupsNode->GetNumberOfControlPoints(), numberOfPoints);
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("Markups-AddControlPoints100kPoints", timer->GetElapsedTime());
+
+  vtkNew<vtkPoints> movedPoints;
+  CreatePoints(movedPoints, numberOfPoints, 1.0);
+  timer->StartTimer();
+  bulkMarkupsNode->SetControlPointPositions(movedPoints);
+  timer->StopTimer();
+  CHECK_DOUBLE_TOLERANCE(bulkMarkupsNode->GetNthControlPointPositionVector(numberOfPoints - 1)[0], numberOfPoints, 1e-9);
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("Markups-SetControlPointPositions100kPoints", timer->GetElapsedTime());
+
+  vtkNew<vtkTransform> transform;
+  transform->Translate(1.0, 2.0, 3.0);
+  timer->StartTimer();
+  bulkMarkupsNode->ApplyTransform(transform);
+  timer->StopTimer();
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("Markups-ApplyTransform100kPoints", timer->GetElapsedTime());
+
+  vtkMRMLLinearTransformNode* transformNode = vtkMRMLLinearTransformNode::SafeDownCast(
+    scene->AddNewNodeByClass("vtkMRMLLinearTransformNode"));
+  bulkMarkupsNode->SetAndObserveTransformNodeID(transformNode->GetID());
+  vtkNew<vtkPoints> pointsWorld;
+  timer->StartTimer();
+  bulkMarkupsNode->GetControlPointPositionsWorld(pointsWorld);
+  timer->StopTimer();
+  CHECK_INT(pointsWorld->GetNumberOfPoints(), numberOfPoints);
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("Markups-GetControlPointPositionsWorld100kPoints", timer->GetElapsedTime());
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLMarkupsNodeTest7(int , char * [] )
+{
+  CHECK_EXIT_SUCCESS(TestBulkControlPoints());
+  CHECK_EXIT_SUCCESS(TestLargePointListPerformance());
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,226 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Markups includes
+#include "vtkMarkupsDisplayPointLocator.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkIdList.h>
+#include <vtkMinimalStandardRandomSequence.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Display positions of the points, as they were set in the locator.
+/// A point is expected to be found if it is set and its position is finite and not very large.
+struct ReferencePoints
+{
+  double CellSize{ 0.0 };
+  std::vector<double> Positions;
+  std::vector<bool> Indexed;
+
+  void SetPoint(vtkMarkupsDisplayPointLocator* locator, vtkIdType pointId, double x, double y)
+    {
+    double position[2] = { x, y };
+    locator->SetPoint(pointId, position);
+    this->Positions[2 * pointId] = x;
+    this->Positions[2 * pointId + 1] = y;
+    // same limit as in the locator, false for NaN
+    this->Indexed[pointId] = (std::abs(std::floor(x / this->CellSize)) < 1.0e9
+      && std::abs(std::floor(y / this->CellSize)) < 1.0e9);
+    }
+
+  void RemovePoint(vtkMarkupsDisplayPointLocator* locator, vtkIdType pointId)
+    {
+    locator->RemovePoint(pointId);
+    this->Indexed[pointId] = false;
+    }
+
+  /// Brute-force search
+  std::vector<vtkIdType> FindPointsWithinRadius(double radius, const double position[2])
+    {
+    std::vector<vtkIdType> pointIds;
+    if (!(radius >= 0.0))
+      {
+      return pointIds;
+      }
+    for (vtkIdType pointId = 0; pointId < static_cast<vtkIdType>(this->Indexed.size()); ++pointId)
+      {
+      if (!this->Indexed[pointId])
+        {
+        continue;
+        }
+      double dx = this->Positions[2 * pointId] - position[0];
+      double dy = this->Positions[2 * pointId + 1] - position[1];
+      if (dx * dx + dy * dy <= radius * radius)
+        {
+        pointIds.push_back(pointId);
+        }
+      }
+    return pointIds;
+    }
+};
+
+//----------------------------------------------------------------------------
+double GetNextRangeValue(vtkMinimalStandardRandomSequence* random, double rangeMin, double rangeMax)
+{
+  random->Next();
+  return random->GetRangeValue(rangeMin, rangeMax);
+}
+
+//----------------------------------------------------------------------------
+int CheckQuery(vtkMarkupsDisplayPointLocator* locator, ReferencePoints& reference,
+  double radius, double x, double y)
+{
+  double position[2] = { x, y };
+  vtkNew<vtkIdList> result;
+  locator->FindPointsWithinRadius(radius, position, result);
+  std::vector<vtkIdType> foundPointIds(result->begin(), result->end());
+  std::sort(foundPointIds.begin(), foundPointIds.end());
+  std::vector<vtkIdType> expectedPointIds = reference.FindPointsWithinRadius(radius, position);
+  if (foundPointIds != expectedPointIds)
+    {
+    std::cerr << "Query at (" << x << ", " << y << ") with radius " << radius << " found "
+      << foundPointIds.size() << " points, expected " << expectedPointIds.size() << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int CheckRandomQueries(vtkMarkupsDisplayPointLocator* locator, ReferencePoints& reference,
+  vtkMinimalStandardRandomSequence* random)
+{
+  for (int queryIndex = 0; queryIndex < 200; ++queryIndex)
+    {
+    double x = GetNextRangeValue(random, -50.0, 1050.0);
+    double y = GetNextRangeValue(random, -50.0, 1050.0);
+    double radius = GetNextRangeValue(random, 0.0, 60.0);
+    CHECK_EXIT_SUCCESS(CheckQuery(locator, reference, radius, x, y));
+    }
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkMarkupsDisplayPointLocatorTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkMarkupsDisplayPointLocator> locator;
+  locator->SetCellSize(20.0);
+  CHECK_DOUBLE(locator->GetCellSize(), 20.0);
+
+  const vtkIdType numberOfPoints = 2000;
+  locator->Initialize(numberOfPoints);
+  CHECK_INT(locator->GetNumberOfPoints(), numberOfPoints);
+  ReferencePoints reference;
+  reference.CellSize = locator->GetCellSize();
+  reference.Positions.assign(2 * numberOfPoints, 0.0);
+  reference.Indexed.assign(numberOfPoints, false);
+
+  // Points are not found before their position is set
+  CHECK_EXIT_SUCCESS(CheckQuery(locator, reference, 1.0e9, 0.0, 0.0));
+
+  vtkNew<vtkMinimalStandardRandomSequence> random;
+  random->SetSeed(1234);
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+    {
+    double x = GetNextRangeValue(random, 0.0, 1000.0);
+    double y = GetNextRangeValue(random, 0.0, 1000.0);
+    reference.SetPoint(locator, pointId, x, y);
+    }
+  CHECK_EXIT_SUCCESS(CheckRandomQueries(locator, reference, random));
+
+  // Points on cell boundaries and queries with zero radius
+  reference.SetPoint(locator, 0, 40.0, 60.0);
+  reference.SetPoint(locator, 1, -20.0, -0.0);
+  CHECK_EXIT_SUCCESS(CheckQuery(locator, reference, 0.0, 40.0, 60.0));
+  CHECK_EXIT_SUCCESS(CheckQuery(locator, reference, 0.0, -20.0, 0.0));
+  CHECK_EXIT_SUCCESS(CheckQuery(locator, reference, 20.0, 20.0, 60.0));
+
+  // Points moved across cells, some of them only slightly, within the same cell
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; pointId += 3)
+    {
+    double x = reference.Positions[2 * pointId] + GetNextRangeValue(random, -100.0, 100.0);
+    double y = reference.Positions[2 * pointId + 1] + GetNextRangeValue(random, -1.0, 1.0);
+    reference.SetPoint(locator, pointId, x, y);
+    }
+  CHECK_EXIT_SUCCESS(CheckRandomQueries(locator, reference, random));
+
+  // Removed points are not found, removing twice or removing an invalid id is ignored
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; pointId += 5)
+    {
+    reference.RemovePoint(locator, pointId);
+    }
+  reference.RemovePoint(locator, 5);
+  locator->RemovePoint(-1);
+  locator->RemovePoint(numberOfPoints);
+  CHECK_EXIT_SUCCESS(CheckRandomQueries(locator, reference, random));
+
+  // Removed points are found again when their position is set
+  reference.SetPoint(locator, 10, 500.0, 500.0);
+  CHECK_EXIT_SUCCESS(CheckQuery(locator, reference, 5.0, 500.0, 500.0));
+
+  // Points with non-finite or very large coordinates are not indexed,
+  // and are removed from the index if they were indexed before
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const double inf = std::numeric_limits<double>::infinity();
+  reference.SetPoint(locator, 11, nan, 100.0);
+  reference.SetPoint(locator, 12, 100.0, inf);
+  reference.SetPoint(locator, 13, -inf, -inf);
+  reference.SetPoint(locator, 14, 1.0e300, 100.0);
+  reference.SetPoint(locator, 16, 100.0, -1.0e15);
+  CHECK_BOOL(reference.Indexed[11] || reference.Indexed[12] || reference.Indexed[13]
+    || reference.Indexed[14] || reference.Indexed[16], false);
+  CHECK_EXIT_SUCCESS(CheckRandomQueries(locator, reference, random));
+  CHECK_EXIT_SUCCESS(CheckQuery(locator, reference, 1.0e3, 1.0e300, 100.0));
+  // Queries at invalid positions or with invalid radius find nothing
+  CHECK_EXIT_SUCCESS(CheckQuery(locator, reference, 10.0, nan, 100.0));
+  CHECK_EXIT_SUCCESS(CheckQuery(locator, reference, nan, 500.0, 500.0));
+  CHECK_EXIT_SUCCESS(CheckQuery(locator, reference, -1.0, 500.0, 500.0));
+
+  // Radius larger than the occupied area returns all indexed points
+  CHECK_EXIT_SUCCESS(CheckQuery(locator, reference, 1.0e5, 500.0, 500.0));
+  CHECK_EXIT_SUCCESS(CheckQuery(locator, reference, 1.0e12, -3.0e6, 7.0e5));
+  CHECK_EXIT_SUCCESS(CheckQuery(locator, reference, inf, 500.0, 500.0));
+
+  // Changing the cell size removes all points
+  locator->SetCellSize(7.0);
+  CHECK_INT(locator->GetNumberOfPoints(), numberOfPoints);
+  reference.CellSize = locator->GetCellSize();
+  std::fill(reference.Indexed.begin(), reference.Indexed.end(), false);
+  CHECK_EXIT_SUCCESS(CheckQuery(locator, reference, 1.0e9, 500.0, 500.0));
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+    {
+    reference.SetPoint(locator, pointId, GetNextRangeValue(random, 0.0, 1000.0), GetNextRangeValue(random, 0.0, 1000.0));
+    }
+  CHECK_EXIT_SUCCESS(CheckRandomQueries(locator, reference, random));
+
+  std::cout << "Success." << std::endl;
+  return EXIT_SUCCESS;
+}
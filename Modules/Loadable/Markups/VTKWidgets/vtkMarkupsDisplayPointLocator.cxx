@@ -0,0 +1,225 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkMarkupsDisplayPointLocator.h"
+
+// VTK includes
+#include <vtkIdList.h>
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+/// Points farther than this (in number of cells) from the origin are not indexed.
+/// They are far outside the view and this keeps cell indices in 32-bit range.
+const double MaximumCellIndex = 1.0e9;
+}
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkMarkupsDisplayPointLocator);
+
+//----------------------------------------------------------------------------
+vtkMarkupsDisplayPointLocator::vtkMarkupsDisplayPointLocator() = default;
+
+//----------------------------------------------------------------------------
+vtkMarkupsDisplayPointLocator::~vtkMarkupsDisplayPointLocator() = default;
+
+//----------------------------------------------------------------------------
+void vtkMarkupsDisplayPointLocator::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "CellSize: " << this->CellSize << "\n";
+  os << indent << "NumberOfPoints: " << this->GetNumberOfPoints() << "\n";
+  os << indent << "NumberOfCells: " << this->Cells.size() << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkMarkupsDisplayPointLocator::SetCellSize(double cellSize)
+{
+  if (cellSize <= 0.0)
+    {
+    vtkErrorMacro("SetCellSize failed: cell size must be positive");
+    return;
+    }
+  if (cellSize == this->CellSize)
+    {
+    return;
+    }
+  this->CellSize = cellSize;
+  this->Initialize(this->GetNumberOfPoints());
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkMarkupsDisplayPointLocator::Initialize(vtkIdType numberOfPoints)
+{
+  this->Cells.clear();
+  this->PointPositions.assign(2 * numberOfPoints, 0.0);
+  this->PointCellKeys.assign(numberOfPoints, 0);
+  this->PointIndexed.assign(numberOfPoints, false);
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkMarkupsDisplayPointLocator::GetNumberOfPoints()
+{
+  return static_cast<vtkIdType>(this->PointIndexed.size());
+}
+
+//----------------------------------------------------------------------------
+long long vtkMarkupsDisplayPointLocator::GetCellKey(long long i, long long j)
+{
+  unsigned long long key = (static_cast<unsigned long long>(i) << 32)
+    ^ (static_cast<unsigned long long>(j) & 0xffffffffULL);
+  return static_cast<long long>(key);
+}
+
+//----------------------------------------------------------------------------
+bool vtkMarkupsDisplayPointLocator::GetCellKey(double x, double y, long long& key)
+{
+  double i = std::floor(x / this->CellSize);
+  double j = std::floor(y / this->CellSize);
+  // comparison is false for NaN
+  if (!(std::abs(i) < MaximumCellIndex && std::abs(j) < MaximumCellIndex))
+    {
+    return false;
+    }
+  key = vtkMarkupsDisplayPointLocator::GetCellKey(static_cast<long long>(i), static_cast<long long>(j));
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkMarkupsDisplayPointLocator::SetPoint(vtkIdType pointId, const double position[2])
+{
+  if (pointId < 0 || pointId >= this->GetNumberOfPoints())
+    {
+    vtkErrorMacro("SetPoint failed: invalid point id " << pointId);
+    return;
+    }
+  this->PointPositions[2 * pointId] = position[0];
+  this->PointPositions[2 * pointId + 1] = position[1];
+  long long key = 0;
+  if (!this->GetCellKey(position[0], position[1], key))
+    {
+    this->RemovePoint(pointId);
+    return;
+    }
+  if (this->PointIndexed[pointId])
+    {
+    if (this->PointCellKeys[pointId] == key)
+      {
+      // Point remained in the same cell
+      return;
+      }
+    this->RemovePoint(pointId);
+    }
+  this->Cells[key].push_back(pointId);
+  this->PointCellKeys[pointId] = key;
+  this->PointIndexed[pointId] = true;
+}
+
+//----------------------------------------------------------------------------
+void vtkMarkupsDisplayPointLocator::RemovePoint(vtkIdType pointId)
+{
+  if (pointId < 0 || pointId >= this->GetNumberOfPoints() || !this->PointIndexed[pointId])
+    {
+    return;
+    }
+  this->PointIndexed[pointId] = false;
+  auto cellIt = this->Cells.find(this->PointCellKeys[pointId]);
+  if (cellIt == this->Cells.end())
+    {
+    return;
+    }
+  std::vector<vtkIdType>& cellPointIds = cellIt->second;
+  auto pointIt = std::find(cellPointIds.begin(), cellPointIds.end(), pointId);
+  if (pointIt != cellPointIds.end())
+    {
+    // Order of points in a cell does not matter
+    *pointIt = cellPointIds.back();
+    cellPointIds.pop_back();
+    }
+  if (cellPointIds.empty())
+    {
+    this->Cells.erase(cellIt);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMarkupsDisplayPointLocator::FindPointsWithinRadius(double radius, const double position[2], vtkIdList* result)
+{
+  if (!result)
+    {
+    vtkErrorMacro("FindPointsWithinRadius failed: invalid result list");
+    return;
+    }
+  result->Reset();
+  if (this->Cells.empty() || !(radius >= 0.0))
+    {
+    return;
+    }
+  double radius2 = radius * radius;
+  auto appendPointsInCell = [&](const std::vector<vtkIdType>& cellPointIds)
+    {
+    for (vtkIdType pointId : cellPointIds)
+      {
+      double dx = this->PointPositions[2 * pointId] - position[0];
+      double dy = this->PointPositions[2 * pointId + 1] - position[1];
+      if (dx * dx + dy * dy <= radius2)
+        {
+        result->InsertNextId(pointId);
+        }
+      }
+    };
+
+  double minI = std::floor((position[0] - radius) / this->CellSize);
+  double maxI = std::floor((position[0] + radius) / this->CellSize);
+  double minJ = std::floor((position[1] - radius) / this->CellSize);
+  double maxJ = std::floor((position[1] + radius) / this->CellSize);
+  // Points outside the indexed range are not stored
+  minI = std::max(minI, -MaximumCellIndex);
+  maxI = std::min(maxI, MaximumCellIndex);
+  minJ = std::max(minJ, -MaximumCellIndex);
+  maxJ = std::min(maxJ, MaximumCellIndex);
+  if (!(minI <= maxI && minJ <= maxJ))
+    {
+    return;
+    }
+  double numberOfSearchedCells = (maxI - minI + 1.0) * (maxJ - minJ + 1.0);
+  if (!(numberOfSearchedCells <= static_cast<double>(this->Cells.size())))
+    {
+    // Search region is larger than the occupied region, it is faster to visit all non-empty cells
+    for (const auto& cell : this->Cells)
+      {
+      appendPointsInCell(cell.second);
+      }
+    return;
+    }
+  for (long long i = static_cast<long long>(minI); i <= static_cast<long long>(maxI); ++i)
+    {
+    for (long long j = static_cast<long long>(minJ); j <= static_cast<long long>(maxJ); ++j)
+      {
+      auto cellIt = this->Cells.find(vtkMarkupsDisplayPointLocator::GetCellKey(i, j));
+      if (cellIt != this->Cells.end())
+        {
+        appendPointsInCell(cellIt->second);
+        }
+      }
+    }
+}
@@ -0,0 +1,95 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+/**
+ * @class   vtkMarkupsDisplayPointLocator
+ * @brief   Uniform grid for finding control points near a display position
+ *
+ * Points are stored by their 2D display position in square buckets of CellSize pixels.
+ * Unlike vtkPointLocator, positions can be updated one by one without rebuilding
+ * the whole structure, which allows keeping the locator up-to-date while a single
+ * control point is dragged.
+ *
+ * Points that are not indexed (not set, removed, or having non-finite or very large
+ * coordinates) are never returned by queries.
+ */
+
+#ifndef vtkMarkupsDisplayPointLocator_h
+#define vtkMarkupsDisplayPointLocator_h
+
+#include "vtkSlicerMarkupsModuleVTKWidgetsExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <unordered_map>
+#include <vector>
+
+class vtkIdList;
+
+class VTK_SLICER_MARKUPS_MODULE_VTKWIDGETS_EXPORT vtkMarkupsDisplayPointLocator : public vtkObject
+{
+public:
+  static vtkMarkupsDisplayPointLocator* New();
+  vtkTypeMacro(vtkMarkupsDisplayPointLocator, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Size of a grid cell in pixels. Changing the cell size removes all points.
+  /// Optimal value is about the typical query radius.
+  void SetCellSize(double cellSize);
+  vtkGetMacro(CellSize, double);
+
+  /// Remove all points and set the number of point ids that can be stored.
+  /// Points are not indexed until their position is set.
+  void Initialize(vtkIdType numberOfPoints);
+
+  /// Get number of point ids (including points that are not indexed).
+  vtkIdType GetNumberOfPoints();
+
+  /// Set or update display position of a point.
+  void SetPoint(vtkIdType pointId, const double position[2]);
+
+  /// Remove a point from the index. Its id remains valid.
+  void RemovePoint(vtkIdType pointId);
+
+  /// Get ids of all indexed points that are within radius of the position.
+  void FindPointsWithinRadius(double radius, const double position[2], vtkIdList* result);
+
+protected:
+  vtkMarkupsDisplayPointLocator();
+  ~vtkMarkupsDisplayPointLocator() override;
+
+  bool GetCellKey(double x, double y, long long& key);
+  static long long GetCellKey(long long i, long long j);
+
+  double CellSize{ 10.0 };
+
+  /// Point ids in each non-empty cell
+  std::unordered_map<long long, std::vector<vtkIdType> > Cells;
+  /// Display positions (x, y) of all points
+  std::vector<double> PointPositions;
+  /// Cell of each point, only valid if the point is indexed
+  std::vector<long long> PointCellKeys;
+  std::vector<bool> PointIndexed;
+
+private:
+  vtkMarkupsDisplayPointLocator(const vtkMarkupsDisplayPointLocator&) = delete;
+  void operator=(const vtkMarkupsDisplayPointLocator&) = delete;
+};
+
+#endif
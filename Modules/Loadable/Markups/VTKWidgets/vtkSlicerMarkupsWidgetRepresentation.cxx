@@ -155,6 +155,9 @@ vtkSlicerMarkupsWidgetRepresentation::vtkSlicerMarkupsWidgetRepresentation()
   this->AlwaysOnTop = false;
 
   this->InteractionPipeline = nullptr;
+
+  this->ControlPointLocator = vtkSmartPointer<vtkMarkupsDisplayPointLocator>::New();
+  this->ControlPointLocatorOutdated = true;
 }
 
 //----------------------------------------------------------------------
@@ -426,6 +429,10 @@ vtkMRMLMarkupsNode *vtkSlicerMarkupsWidgetRepresentation::GetMarkupsNode()
 //----------------------------------------------------------------------
 void vtkSlicerMarkupsWidgetRepresentation::SetMarkupsNode(vtkMRMLMarkupsNode *markupsNode)
 {
+  if (this->MarkupsNode != markupsNode)
+    {
+    this->ControlPointLocatorOutdated = true;
+    }
   this->MarkupsNode = markupsNode;
 }
 
@@ -446,6 +453,48 @@ void vtkSlicerMarkupsWidgetRepresentation::CanInteract(
   foundComponentType = vtkMRMLMarkupsDisplayNode::ComponentNone;
 }
 
+//----------------------------------------------------------------------
+void vtkSlicerMarkupsWidgetRepresentation::UpdateControlPointLocator(bool rebuild,
+  vtkMRMLInteractionEventData* interactionEventData)
+{
+  int numberOfPoints = this->MarkupsNode ? this->MarkupsNode->GetNumberOfControlPoints() : 0;
+  if (rebuild || this->ControlPointLocatorOutdated
+    || this->ControlPointLocator->GetNumberOfPoints() != numberOfPoints
+    || static_cast<int>(this->ControlPointLocatorModifiedPoints.size()) > numberOfPoints / 2)
+    {
+    this->InitializeControlPointLocator(numberOfPoints);
+    for (int i = 0; i < numberOfPoints; i++)
+      {
+      this->UpdateControlPointLocatorPoint(i, interactionEventData);
+      }
+    this->ControlPointLocatorOutdated = false;
+    }
+  else
+    {
+    for (int i : this->ControlPointLocatorModifiedPoints)
+      {
+      if (i >= 0 && i < numberOfPoints)
+        {
+        this->UpdateControlPointLocatorPoint(i, interactionEventData);
+        }
+      }
+    }
+  this->ControlPointLocatorModifiedPoints.clear();
+}
+
+//----------------------------------------------------------------------
+void vtkSlicerMarkupsWidgetRepresentation::InitializeControlPointLocator(int numberOfPoints)
+{
+  this->ControlPointLocator->Initialize(numberOfPoints);
+}
+
+//----------------------------------------------------------------------
+void vtkSlicerMarkupsWidgetRepresentation::UpdateControlPointLocatorPoint(int controlPointIndex,
+  vtkMRMLInteractionEventData* vtkNotUsed(interactionEventData))
+{
+  this->ControlPointLocator->RemovePoint(controlPointIndex);
+}
+
 //----------------------------------------------------------------------
 bool vtkSlicerMarkupsWidgetRepresentation::GetTransformationReferencePoint(double referencePointWorld[3])
 {
@@ -524,13 +573,24 @@ void vtkSlicerMarkupsWidgetRepresentation::BuildLine(vtkPolyData* linePolyData,
 
 //----------------------------------------------------------------------
 void vtkSlicerMarkupsWidgetRepresentation::UpdateFromMRML(
-    vtkMRMLNode* vtkNotUsed(caller), unsigned long event, void *vtkNotUsed(callData))
+    vtkMRMLNode* caller, unsigned long event, void *callData)
 {
   if (!this->InteractionPipeline)
     {
     this->SetupInteractionPipeline();
     }
 
+  if (event == vtkMRMLMarkupsNode::PointModifiedEvent && callData)
+    {
+    // Only a single point is moved, the locator can be updated incrementally
+    this->ControlPointLocatorModifiedPoints.insert(*reinterpret_cast<int*>(callData));
+    }
+  else if (!event || (caller && caller == this->MarkupsNode && event != vtkMRMLDisplayableNode::DisplayModifiedEvent))
+    {
+    // Points may have been added, removed, or moved (e.g., by a transform)
+    this->ControlPointLocatorOutdated = true;
+    }
+
   if (!event || event == vtkMRMLTransformableNode::TransformModifiedEvent)
     {
     this->MarkupsTransformModifiedTime.Modified();
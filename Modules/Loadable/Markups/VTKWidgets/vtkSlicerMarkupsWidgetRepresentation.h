@@ -53,6 +53,7 @@
 #include "vtkArrowSource.h"
 #include "vtkGlyph3D.h"
 #include "vtkLookupTable.h"
+#include "vtkMarkupsDisplayPointLocator.h"
 #include "vtkMarkupsGlyphSource2D.h"
 #include "vtkPointPlacer.h"
 #include "vtkPointSetToLabelHierarchy.h"
@@ -67,6 +68,9 @@
 #include "vtkTransformPolyDataFilter.h"
 #include "vtkTubeFilter.h"
 
+// STD includes
+#include <set>
+
 class vtkMRMLInteractionEventData;
 
 class VTK_SLICER_MARKUPS_MODULE_VTKWIDGETS_EXPORT vtkSlicerMarkupsWidgetRepresentation : public vtkMRMLAbstractWidgetRepresentation
@@ -345,6 +349,24 @@ protected:
   /// Update the interaction pipeline
   virtual void UpdateInteractionPipeline();
 
+  /// Update display positions stored in ControlPointLocator.
+  /// All points are added again if rebuild is requested (e.g., because the view projection changed),
+  /// control points were added or removed, or the markups node was modified in a way that may
+  /// have moved many points. Otherwise only the points that were reported as modified are updated.
+  void UpdateControlPointLocator(bool rebuild, vtkMRMLInteractionEventData* interactionEventData);
+  /// Remove all points from the locator and prepare it for storing numberOfPoints points.
+  virtual void InitializeControlPointLocator(int numberOfPoints);
+  /// Compute display position of a control point and store it in the locator.
+  /// Default implementation removes the point from the locator.
+  virtual void UpdateControlPointLocatorPoint(int controlPointIndex, vtkMRMLInteractionEventData* interactionEventData);
+
+  /// Spatial index of control point display positions, for fast picking of control points.
+  vtkSmartPointer<vtkMarkupsDisplayPointLocator> ControlPointLocator;
+  /// Control points positions may have changed, all points must be added again to the locator
+  bool ControlPointLocatorOutdated;
+  /// Control points that have been moved since the last locator update
+  std::set<int> ControlPointLocatorModifiedPoints;
+
 private:
   vtkSlicerMarkupsWidgetRepresentation(const vtkSlicerMarkupsWidgetRepresentation&) = delete;
   void operator=(const vtkSlicerMarkupsWidgetRepresentation&) = delete;
@@ -21,6 +21,7 @@
 #include "vtkCellLocator.h"
 #include "vtkDiscretizableColorTransferFunction.h"
 #include "vtkGlyph2D.h"
+#include "vtkIdList.h"
 #include "vtkLabelPlacementMapper.h"
 #include "vtkLine.h"
 #include "vtkMarkupsGlyphSource2D.h"
@@ -126,6 +127,9 @@ vtkSlicerMarkupsWidgetRepresentation2D::vtkSlicerMarkupsWidgetRepresentation2D()
 
   this->SlicePlane = vtkSmartPointer<vtkPlane>::New();
   this->WorldToSliceTransform = vtkSmartPointer<vtkTransform>::New();
+
+  this->ControlPointLocatorXYToRAS = vtkSmartPointer<vtkMatrix4x4>::New();
+  this->ControlPointLocatorRASToXY = vtkSmartPointer<vtkMatrix4x4>::New();
 }
 
 //----------------------------------------------------------------------
@@ -552,21 +556,43 @@ void vtkSlicerMarkupsWidgetRepresentation2D::CanInteract(
       }
     }
 
-  vtkIdType numberOfPoints = markupsNode->GetNumberOfControlPoints();
+  // Only control points that are near the mouse position in XY are checked
+  bool sliceGeometryChanged = false;
+  vtkMatrix4x4* xyToRAS = sliceNode->GetXYToRAS();
+  for (int row = 0; row < 4 && !sliceGeometryChanged; row++)
+    {
+    for (int column = 0; column < 4; column++)
+      {
+      if (xyToRAS->GetElement(row, column) != this->ControlPointLocatorXYToRAS->GetElement(row, column))
+        {
+        sliceGeometryChanged = true;
+        break;
+        }
+      }
+    }
+  if (sliceGeometryChanged)
+    {
+    this->ControlPointLocatorXYToRAS->DeepCopy(xyToRAS);
+    vtkMatrix4x4::Invert(xyToRAS, this->ControlPointLocatorRASToXY);
+    }
+  this->UpdateControlPointLocator(sliceGeometryChanged, interactionEventData);
+  vtkNew<vtkIdList> candidatePointIds;
+  this->ControlPointLocator->FindPointsWithinRadius(sqrt(maxPickingDistanceFromControlPoint2), displayPosition3, candidatePointIds);
+  // Sort to pick the lowest index among points at equal distance, as when checking all points
+  candidatePointIds->Sort();
 
   double pointDisplayPos[4] = { 0.0, 0.0, 0.0, 1.0 };
   double pointWorldPos[4] = { 0.0, 0.0, 0.0, 1.0 };
 
-  vtkNew<vtkMatrix4x4> rasToxyMatrix;
-  sliceNode->GetXYToRAS()->Invert(sliceNode->GetXYToRAS(), rasToxyMatrix.GetPointer());
-  for (int i = 0; i < numberOfPoints; i++)
+  for (vtkIdType candidateIndex = 0; candidateIndex < candidatePointIds->GetNumberOfIds(); candidateIndex++)
     {
+    int i = static_cast<int>(candidatePointIds->GetId(candidateIndex));
     if (!this->GetNthControlPointViewVisibility(i))
       {
       continue;
       }
     markupsNode->GetNthControlPointPositionWorld(i, pointWorldPos);
-    rasToxyMatrix->MultiplyPoint(pointWorldPos, pointDisplayPos);
+    this->ControlPointLocatorRASToXY->MultiplyPoint(pointWorldPos, pointDisplayPos);
     if (this->MarkupsDisplayNode->GetSliceProjection())
       {
       pointDisplayPos[2] = displayPosition3[2];
@@ -581,6 +607,17 @@ void vtkSlicerMarkupsWidgetRepresentation2D::CanInteract(
     }
 }
 
+//----------------------------------------------------------------------
+void vtkSlicerMarkupsWidgetRepresentation2D::UpdateControlPointLocatorPoint(int controlPointIndex,
+  vtkMRMLInteractionEventData* vtkNotUsed(interactionEventData))
+{
+  double pointWorldPos[4] = { 0.0, 0.0, 0.0, 1.0 };
+  double pointDisplayPos[4] = { 0.0, 0.0, 0.0, 1.0 };
+  this->MarkupsNode->GetNthControlPointPositionWorld(controlPointIndex, pointWorldPos);
+  this->ControlPointLocatorRASToXY->MultiplyPoint(pointWorldPos, pointDisplayPos);
+  this->ControlPointLocator->SetPoint(controlPointIndex, pointDisplayPos);
+}
+
 //----------------------------------------------------------------------
 void vtkSlicerMarkupsWidgetRepresentation2D::CanInteractWithHandles(
   vtkMRMLInteractionEventData* interactionEventData,
@@ -40,6 +40,7 @@ class vtkDiscretizableColorTransferFunction;
 class vtkGlyph2D;
 class vtkLabelPlacementMapper;
 class vtkMarkupsGlyphSource2D;
+class vtkMatrix4x4;
 class vtkPlane;
 class vtkPolyDataMapper2D;
 class vtkProperty2D;
@@ -173,6 +174,13 @@ protected:
 
   virtual void UpdateAllPointsAndLabelsFromMRML(double labelsOffset);
 
+  /// Store control point XY position in the locator
+  void UpdateControlPointLocatorPoint(int controlPointIndex, vtkMRMLInteractionEventData* interactionEventData) override;
+
+  /// Slice geometry that was used for computing the control point positions stored in the locator
+  vtkSmartPointer<vtkMatrix4x4> ControlPointLocatorXYToRAS;
+  vtkSmartPointer<vtkMatrix4x4> ControlPointLocatorRASToXY;
+
   double GetWidgetOpacity(int controlPointType);
 
   class MarkupsInteractionPipeline2D : public MarkupsInteractionPipeline
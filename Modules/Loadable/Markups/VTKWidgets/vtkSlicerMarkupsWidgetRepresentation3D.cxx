@@ -24,6 +24,7 @@
 #include "vtkLine.h"
 #include "vtkFloatArray.h"
 #include "vtkGlyph3DMapper.h"
+#include "vtkIdList.h"
 #include "vtkMarkupsGlyphSource2D.h"
 #include "vtkMath.h"
 #include "vtkMatrix4x4.h"
@@ -414,9 +415,51 @@ void vtkSlicerMarkupsWidgetRepresentation3D::CanInteract(
       }
     }
 
-  vtkIdType numberOfPoints = markupsNode->GetNumberOfControlPoints();
-  for (int i = 0; i < numberOfPoints; i++)
+  vtkNew<vtkIdList> candidatePointIds;
+  if (interactionEventData->IsDisplayPositionValid() && this->Renderer && this->Renderer->GetActiveCamera())
+    {
+    // Only control points that are near the mouse position in display coordinates are checked
+    vtkMTimeType cameraMTime = this->Renderer->GetActiveCamera()->GetMTime();
+    int* rendererOrigin = this->Renderer->GetOrigin();
+    int* rendererSize = this->Renderer->GetSize();
+    bool projectionChanged = (cameraMTime != this->ControlPointLocatorCameraMTime
+      || rendererOrigin[0] != this->ControlPointLocatorRendererOrigin[0]
+      || rendererOrigin[1] != this->ControlPointLocatorRendererOrigin[1]
+      || rendererSize[0] != this->ControlPointLocatorRendererSize[0]
+      || rendererSize[1] != this->ControlPointLocatorRendererSize[1]);
+    if (projectionChanged)
+      {
+      this->ControlPointLocatorCameraMTime = cameraMTime;
+      for (int i = 0; i < 2; i++)
+        {
+        this->ControlPointLocatorRendererOrigin[i] = rendererOrigin[i];
+        this->ControlPointLocatorRendererSize[i] = rendererSize[i];
+        }
+      }
+    this->UpdateControlPointLocator(projectionChanged, interactionEventData);
+    double searchRadius = this->ControlPointSize / 2.0 * this->ControlPointLocatorMaximumPixelsPerMm
+      + this->PickingTolerance * this->ScreenScaleFactor;
+    this->ControlPointLocator->FindPointsWithinRadius(searchRadius, displayPosition3, candidatePointIds);
+    // Sort to pick the lowest index among points at equal distance, as when checking all points
+    candidatePointIds->Sort();
+    }
+  else
+    {
+    // The display point locator is not used in 3D only contexts (such as virtual reality):
+    // there is no display position to search around, and the picking tolerance is defined in world
+    // coordinates, which would require a separate world coordinate index. These contexts pick
+    // with a controller at a low event rate, therefore all control points are checked.
+    vtkIdType numberOfPoints = markupsNode->GetNumberOfControlPoints();
+    candidatePointIds->SetNumberOfIds(numberOfPoints);
+    for (vtkIdType i = 0; i < numberOfPoints; i++)
+      {
+      candidatePointIds->SetId(i, i);
+      }
+    }
+
+  for (vtkIdType candidateIndex = 0; candidateIndex < candidatePointIds->GetNumberOfIds(); candidateIndex++)
     {
+    int i = static_cast<int>(candidatePointIds->GetId(candidateIndex));
     if (!(markupsNode->GetNthControlPointPositionVisibility(i)
       && markupsNode->GetNthControlPointVisibility(i)))
       {
@@ -494,22 +537,30 @@ void vtkSlicerMarkupsWidgetRepresentation3D::CanInteract(
         }
       }
     }
+}
 
-  /* This would probably faster for many points:
-
-  this->BuildLocator();
-
-  double closestDistance2 = VTK_DOUBLE_MAX;
-  int closestNode = static_cast<int> (this->Locator->FindClosestPointWithinRadius(
-    this->PixelTolerance, displayPos, closestDistance2));
+//----------------------------------------------------------------------
+void vtkSlicerMarkupsWidgetRepresentation3D::InitializeControlPointLocator(int numberOfPoints)
+{
+  this->Superclass::InitializeControlPointLocator(numberOfPoints);
+  this->ControlPointLocatorMaximumPixelsPerMm = 0.0;
+}
 
-  if (closestNode != this->GetActiveNode())
+//----------------------------------------------------------------------
+void vtkSlicerMarkupsWidgetRepresentation3D::UpdateControlPointLocatorPoint(int controlPointIndex,
+  vtkMRMLInteractionEventData* interactionEventData)
+{
+  double pointWorldPos[3] = { 0.0, 0.0, 0.0 };
+  double pointDisplayPos[3] = { 0.0, 0.0, 0.0 };
+  this->MarkupsNode->GetNthControlPointPositionWorld(controlPointIndex, pointWorldPos);
+  interactionEventData->WorldToDisplay(pointWorldPos, pointDisplayPos);
+  this->ControlPointLocator->SetPoint(controlPointIndex, pointDisplayPos);
+  double pixelsPerMm = 1.0 / this->GetViewScaleFactorAtPosition(pointWorldPos, interactionEventData);
+  // The search radius is only allowed to grow until the next full rebuild, which is conservative
+  if (pixelsPerMm > this->ControlPointLocatorMaximumPixelsPerMm)
     {
-    this->SetActiveNode(closestNode);
-    this->NeedToRender = 1;
+    this->ControlPointLocatorMaximumPixelsPerMm = pixelsPerMm;
     }
-  return (this->GetActiveNode() >= 0);
-  */
 }
 
 //----------------------------------------------------------------------
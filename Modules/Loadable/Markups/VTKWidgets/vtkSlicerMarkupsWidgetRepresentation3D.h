@@ -157,6 +157,19 @@ protected:
   void UpdateRelativeCoincidentTopologyOffsets(vtkMapper* mapper, vtkMapper* occludedMapper);
   using vtkMRMLAbstractWidgetRepresentation::UpdateRelativeCoincidentTopologyOffsets;
 
+  /// Store control point display position in the locator
+  void InitializeControlPointLocator(int numberOfPoints) override;
+  void UpdateControlPointLocatorPoint(int controlPointIndex, vtkMRMLInteractionEventData* interactionEventData) override;
+
+  /// Camera and renderer state that was used for computing the control point positions stored in the locator
+  vtkMTimeType ControlPointLocatorCameraMTime{ 0 };
+  int ControlPointLocatorRendererOrigin[2] = { 0, 0 };
+  int ControlPointLocatorRendererSize[2] = { 0, 0 };
+  /// Largest display size (in pixels) of 1mm at any of the control points in the locator.
+  /// Used for determining the search radius, as control points closer to the camera
+  /// can be picked from farther away.
+  double ControlPointLocatorMaximumPixelsPerMm{ 0.0 };
+
   vtkSmartPointer<vtkCellPicker> AccuratePicker;
 
   double TextActorPositionWorld[3];
@@ -1,3 +1,5 @@
+import logging
+
 import qt
 
 import slicer
@@ -91,3 +93,64 @@ class AbstractScriptedSegmentEditorEffect:
         spinbox.singleStep = stepSize
         # number of decimals is set to be able to show the step size (e.g., stepSize = 0.01 => decimals = 2)
         spinbox.decimals = max(int(-math.floor(math.log10(stepSize))), 0)
+
+    @staticmethod
+    def isExtentContained(extent, containerExtent):
+        """Returns True if extent is within containerExtent. Empty extent is contained in any extent."""
+        if extent[0] > extent[1] or extent[2] > extent[3] or extent[4] > extent[5]:
+            return True
+        for axis in range(3):
+            if extent[axis * 2] < containerExtent[axis * 2] or extent[axis * 2 + 1] > containerExtent[axis * 2 + 1]:
+                return False
+        return True
+
+    def applyLabelOperationToSegments(self, labelOperation, segmentIDs, operationName=None):
+        """Replace each segment by the result of a label operation (vtkImageLabelOperation subclass).
+        Segments that are stored in a shared labelmap that has the same geometry as the modifier labelmap
+        and covers its extent are processed directly from the shared labelmap, therefore bounding extents of all labels of the
+        shared labelmap are computed only once. Other segments are processed from the selected segment labelmap.
+        Results of all segments are computed before any of the segments is modified.
+        """
+        import vtkSegmentationCorePython as vtkSegmentationCore
+        parameterSetNode = self.scriptedEffect.parameterSetNode()
+        segmentationNode = parameterSetNode.GetSegmentationNode()
+        segmentation = segmentationNode.GetSegmentation()
+        binaryLabelmapRepresentationName = vtkSegmentationCore.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName()
+        modifierLabelmap = self.scriptedEffect.defaultModifierLabelmap()
+
+        # store which segment was selected before operation
+        selectedStartSegmentID = parameterSetNode.GetSelectedSegmentID()
+        results = []
+        for segmentID in segmentIDs:
+            segment = segmentation.GetSegment(segmentID)
+            if not segment:
+                continue
+            if operationName:
+                slicer.util.showStatusMessage(f'{operationName} {segment.GetName()}...', 500)
+                slicer.app.processEvents()
+            layerLabelmap = segment.GetRepresentation(binaryLabelmapRepresentationName)
+            # The operation result is clipped to the extent of the processed labelmap, therefore the shared
+            # labelmap can only be used if it covers the whole modifier labelmap extent (otherwise margin growth
+            # or closing would be clipped to the current extent of the shared labelmap).
+            if (layerLabelmap and modifierLabelmap
+                    and slicer.vtkOrientedImageDataResample.DoGeometriesMatch(layerLabelmap, modifierLabelmap)
+                    and self.isExtentContained(modifierLabelmap.GetExtent(), layerLabelmap.GetExtent())):
+                labelOperation.SetLabelmap(layerLabelmap)
+                labelValue = segment.GetLabelValue()
+            else:
+                parameterSetNode.SetSelectedSegmentID(segmentID)
+                labelOperation.SetLabelmap(self.scriptedEffect.selectedSegmentLabelmap())
+                # Selected segment labelmap contains 1 in the segment and 0 elsewhere
+                labelValue = 1
+            result = slicer.vtkOrientedImageData()
+            if not labelOperation.Execute(labelValue, result):
+                logging.error(f"Failed to process segment {segmentID}")
+                continue
+            results.append((segmentID, result))
+        labelOperation.SetLabelmap(None)
+        # restore segment selection
+        parameterSetNode.SetSelectedSegmentID(selectedStartSegmentID)
+
+        for segmentID, result in results:
+            self.scriptedEffect.modifySegmentByLabelmap(segmentationNode, segmentID, result,
+                                                        slicer.qSlicerSegmentEditorAbstractEffect.ModificationModeSet)
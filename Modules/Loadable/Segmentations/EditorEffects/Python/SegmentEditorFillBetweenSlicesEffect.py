@@ -15,6 +15,7 @@ class SegmentEditorFillBetweenSlicesEffect(AbstractScriptedSegmentEditorAutoComp
     def __init__(self, scriptedEffect):
         AbstractScriptedSegmentEditorAutoCompleteEffect.__init__(self, scriptedEffect)
         scriptedEffect.name = 'Fill between slices'
+        self.fillBetweenSlices = None
 
     def clone(self):
         import qSlicerSegmentationsEditorEffectsPythonQt as effects
@@ -22,6 +23,10 @@ class SegmentEditorFillBetweenSlicesEffect(AbstractScriptedSegmentEditorAutoComp
         clonedEffect.setPythonSource(__file__.replace('\\', '/'))
         return clonedEffect
 
+    def reset(self):
+        self.fillBetweenSlices = None
+        AbstractScriptedSegmentEditorAutoCompleteEffect.reset(self)
+
     def icon(self):
         iconPath = os.path.join(os.path.dirname(__file__), 'Resources/Icons/FillBetweenSlices.png')
         if os.path.exists(iconPath):
@@ -38,15 +43,15 @@ do not use sphere brush with Paint effect and always leave at least one empty sl
 <li>The complete segmentation will be created by interpolating segmentations in empty slices.</li>
 </ul><p>
 Masking settings are ignored. If segments overlap, segment higher in the segments table will have priority.
-The effect uses  <a href="https://insight-journal.org/browse/publication/977">morphological contour interpolation method</a>.
+The effect uses shape-based interpolation: signed distance maps of the nearest segmented slices are interpolated.
+Interpolation results are reused while the preview is updated, only the gaps next to modified slices are recomputed.
 <p></html>"""
 
     def computePreviewLabelmap(self, mergedImage, outputLabelmap):
-        import vtkITK
-        interpolator = vtkITK.vtkITKMorphologicalContourInterpolator()
-        interpolator.SetInputData(mergedImage)
-        interpolator.Update()
-        outputLabelmap.DeepCopy(interpolator.GetOutput())
-        imageToWorld = vtk.vtkMatrix4x4()
-        mergedImage.GetImageToWorldMatrix(imageToWorld)
-        outputLabelmap.SetImageToWorldMatrix(imageToWorld)
+        import vtkSlicerSegmentationsModuleLogicPython as vtkSlicerSegmentationsModuleLogic
+        if not self.fillBetweenSlices:
+            # Keep the filter between preview updates so that gaps that are not affected by an edit are reused
+            self.fillBetweenSlices = vtkSlicerSegmentationsModuleLogic.vtkImageFillBetweenSlices()
+        self.fillBetweenSlices.SetLabelmap(mergedImage)
+        self.fillBetweenSlices.Execute(outputLabelmap)
+        self.fillBetweenSlices.SetLabelmap(None)
@@ -16,6 +16,7 @@ class SegmentEditorHollowEffect(AbstractScriptedSegmentEditorEffect):
     def __init__(self, scriptedEffect):
         scriptedEffect.name = 'Hollow'
         AbstractScriptedSegmentEditorEffect.__init__(self, scriptedEffect)
+        self.labelMargin = None
 
     def clone(self):
         import qSlicerSegmentationsEditorEffectsPythonQt as effects
@@ -32,6 +33,10 @@ class SegmentEditorHollowEffect(AbstractScriptedSegmentEditorEffect):
     def helpText(self):
         return """Make the selected segment hollow by replacing the segment with a uniform-thickness shell defined by the segment boundary."""
 
+    def deactivate(self):
+        # Release cached distance maps
+        self.labelMargin = None
+
     def setupOptionsFrame(self):
 
         operationLayout = qt.QVBoxLayout()
@@ -175,43 +180,41 @@ class SegmentEditorHollowEffect(AbstractScriptedSegmentEditorEffect):
         slicer.util.showStatusMessage(msg, timeoutMsec)
         slicer.app.processEvents()
 
-    def processHollowing(self):
-        # Get modifier labelmap and parameters
-        modifierLabelmap = self.scriptedEffect.defaultModifierLabelmap()
-        selectedSegmentLabelmap = self.scriptedEffect.selectedSegmentLabelmap()
-        # We need to know exactly the value of the segment voxels, apply threshold to make force the selected label value
-        labelValue = 1
-        backgroundValue = 0
-        thresh = vtk.vtkImageThreshold()
-        thresh.SetInputData(selectedSegmentLabelmap)
-        thresh.ThresholdByLower(0)
-        thresh.SetInValue(backgroundValue)
-        thresh.SetOutValue(labelValue)
-        thresh.SetOutputScalarType(selectedSegmentLabelmap.GetScalarType())
-
+    def getLabelMargin(self):
+        """Get label margin operation that creates the shell according to the current effect parameters.
+        The operation is kept while the effect is active so that distance maps of unchanged segments
+        are reused when the operation is repeated with a different thickness (e.g., after undo).
+        """
+        if not self.labelMargin:
+            import vtkSlicerSegmentationsModuleLogicPython as vtkSlicerSegmentationsModuleLogic
+            self.labelMargin = vtkSlicerSegmentationsModuleLogic.vtkImageLabelMargin()
         shellMode = self.scriptedEffect.parameter("ShellMode")
         shellThicknessMM = abs(self.scriptedEffect.doubleParameter("ShellThicknessMm"))
-        import vtkITK
-        margin = vtkITK.vtkITKImageMargin()
-        margin.SetInputConnection(thresh.GetOutputPort())
-        margin.CalculateMarginInMMOn()
-
-        spacing = selectedSegmentLabelmap.GetSpacing()
-        voxelDiameter = min(selectedSegmentLabelmap.GetSpacing())
+        # Shell is the region between the inner and outer margin (signed distance from the segment boundary)
         if shellMode == MEDIAL_SURFACE:
-            margin.SetOuterMarginMM(0.5 * shellThicknessMM)
-            margin.SetInnerMarginMM(-0.5 * shellThicknessMM + 0.5 * voxelDiameter)
+            self.labelMargin.SetInnerMarginSize(-0.5 * shellThicknessMM)
+            self.labelMargin.SetMarginSize(0.5 * shellThicknessMM)
         elif shellMode == INSIDE_SURFACE:
-            margin.SetOuterMarginMM(shellThicknessMM + 0.1 * voxelDiameter)
-            margin.SetInnerMarginMM(0.0 + 0.1 * voxelDiameter)  # Don't include the original border (0.0)
+            self.labelMargin.SetInnerMarginSize(0.0)
+            self.labelMargin.SetMarginSize(shellThicknessMM)
         elif shellMode == OUTSIDE_SURFACE:
-            margin.SetOuterMarginMM(0.0)
-            margin.SetInnerMarginMM(-shellThicknessMM + voxelDiameter)
+            self.labelMargin.SetInnerMarginSize(-shellThicknessMM)
+            self.labelMargin.SetMarginSize(0.0)
+        return self.labelMargin
 
-        modifierLabelmap.DeepCopy(margin.GetOutput())
+    def processHollowing(self):
+        # Get modifier labelmap and parameters
+        modifierLabelmap = self.scriptedEffect.defaultModifierLabelmap()
+        selectedSegmentLabelmap = self.scriptedEffect.selectedSegmentLabelmap()
 
-        margin.Update()
-        modifierLabelmap.ShallowCopy(margin.GetOutput())
+        labelMargin = self.getLabelMargin()
+        labelMargin.SetLabelmap(selectedSegmentLabelmap)
+        # Selected segment labelmap contains 1 in the segment and 0 elsewhere
+        success = labelMargin.Execute(1, modifierLabelmap)
+        labelMargin.SetLabelmap(None)
+        if not success:
+            logging.error('Failed to create hollow shell')
+            return
 
         # Apply changes
         self.scriptedEffect.modifySelectedSegmentByLabelmap(modifierLabelmap, slicer.qSlicerSegmentEditorAbstractEffect.ModificationModeSet)
@@ -234,19 +237,11 @@ class SegmentEditorHollowEffect(AbstractScriptedSegmentEditorEffect):
                 inputSegmentIDs = vtk.vtkStringArray()
                 segmentationNode = self.scriptedEffect.parameterSetNode().GetSegmentationNode()
                 segmentationNode.GetDisplayNode().GetVisibleSegmentIDs(inputSegmentIDs)
-                # store which segment was selected before operation
-                selectedStartSegmentID = self.scriptedEffect.parameterSetNode().GetSelectedSegmentID()
                 if inputSegmentIDs.GetNumberOfValues() == 0:
                     logging.info("Hollow operation skipped: there are no visible segments.")
                     return
-                # select input segments one by one, process
-                for index in range(inputSegmentIDs.GetNumberOfValues()):
-                    segmentID = inputSegmentIDs.GetValue(index)
-                    self.showStatusMessage(f'Processing {segmentationNode.GetSegmentation().GetSegment(segmentID).GetName()}...')
-                    self.scriptedEffect.parameterSetNode().SetSelectedSegmentID(segmentID)
-                    self.processHollowing()
-                # restore segment selection
-                self.scriptedEffect.parameterSetNode().SetSelectedSegmentID(selectedStartSegmentID)
+                segmentIDs = [inputSegmentIDs.GetValue(index) for index in range(inputSegmentIDs.GetNumberOfValues())]
+                self.applyLabelOperationToSegments(self.getLabelMargin(), segmentIDs, 'Processing')
             else:
                 self.processHollowing()
 
@@ -3,7 +3,6 @@ import os
 
 import qt
 import vtk
-import vtkITK
 
 import slicer
 
@@ -141,26 +140,21 @@ about each operation, hover the mouse over the option and wait for the tooltip t
         # Get modifier labelmap
         selectedSegmentLabelmap = self.scriptedEffect.selectedSegmentLabelmap()
 
-        castIn = vtk.vtkImageCast()
-        castIn.SetInputData(selectedSegmentLabelmap)
-        castIn.SetOutputScalarTypeToUnsignedInt()
-
-        # Identify the islands in the inverted volume and
-        # find the pixel that corresponds to the background
-        islandMath = vtkITK.vtkITKIslandMath()
-        islandMath.SetInputConnection(castIn.GetOutputPort())
-        islandMath.SetFullyConnected(False)
-        islandMath.SetMinimumSize(minimumSize)
-        islandMath.Update()
-
+        # Identify the islands within the bounding box of the segment.
+        # Selected segment labelmap contains 1 in the segment and 0 elsewhere.
+        import vtkSlicerSegmentationsModuleLogicPython as vtkSlicerSegmentationsModuleLogic
+        labelIslands = vtkSlicerSegmentationsModuleLogic.vtkImageLabelIslands()
+        labelIslands.SetLabelmap(selectedSegmentLabelmap)
+        labelIslands.SetFullyConnected(False)
+        labelIslands.SetMinimumSize(minimumSize)
         islandImage = slicer.vtkOrientedImageData()
-        islandImage.ShallowCopy(islandMath.GetOutput())
-        selectedSegmentLabelmapImageToWorldMatrix = vtk.vtkMatrix4x4()
-        selectedSegmentLabelmap.GetImageToWorldMatrix(selectedSegmentLabelmapImageToWorldMatrix)
-        islandImage.SetImageToWorldMatrix(selectedSegmentLabelmapImageToWorldMatrix)
+        if not labelIslands.Execute(1, islandImage):
+            logging.error("Failed to identify islands")
+            qt.QApplication.restoreOverrideCursor()
+            return
 
-        islandCount = islandMath.GetNumberOfIslands()
-        islandOrigCount = islandMath.GetOriginalNumberOfIslands()
+        islandCount = labelIslands.GetNumberOfIslands()
+        islandOrigCount = labelIslands.GetOriginalNumberOfIslands()
         ignoredIslands = islandOrigCount - islandCount
         logging.info("%d islands created (%d ignored)" % (islandCount, ignoredIslands))
 
@@ -174,30 +168,31 @@ about each operation, hover the mouse over the option and wait for the tooltip t
             if selectedSegmentName is not None and selectedSegmentName != "":
                 baseSegmentName = selectedSegmentName
 
-            labelValues = vtk.vtkIntArray()
-            slicer.vtkSlicerSegmentationsModuleLogic.GetAllLabelValues(labelValues, islandImage)
-
-            # Erase segment from in original labelmap.
-            # Individual islands will be added back later.
-            threshold = vtk.vtkImageThreshold()
-            threshold.SetInputData(selectedSegmentLabelmap)
-            threshold.ThresholdBetween(0, 0)
-            threshold.SetInValue(0)
-            threshold.SetOutValue(0)
-            threshold.Update()
-            emptyLabelmap = slicer.vtkOrientedImageData()
-            emptyLabelmap.ShallowCopy(threshold.GetOutput())
-            emptyLabelmap.CopyDirections(selectedSegmentLabelmap)
-            self.scriptedEffect.modifySegmentByLabelmap(segmentationNode, selectedSegmentID, emptyLabelmap,
-                                                        slicer.qSlicerSegmentEditorAbstractEffect.ModificationModeSet)
-
-            for i in range(labelValues.GetNumberOfTuples()):
+            if islandCount == 0:
+                # Erase segment from the original labelmap.
+                # If there are islands then the first one replaces the segment.
+                threshold = vtk.vtkImageThreshold()
+                threshold.SetInputData(selectedSegmentLabelmap)
+                threshold.ThresholdBetween(0, 0)
+                threshold.SetInValue(0)
+                threshold.SetOutValue(0)
+                threshold.Update()
+                emptyLabelmap = slicer.vtkOrientedImageData()
+                emptyLabelmap.ShallowCopy(threshold.GetOutput())
+                emptyLabelmap.CopyDirections(selectedSegmentLabelmap)
+                self.scriptedEffect.modifySegmentByLabelmap(segmentationNode, selectedSegmentID, emptyLabelmap,
+                                                            slicer.qSlicerSegmentEditorAbstractEffect.ModificationModeSet)
+
+            # Islands are labeled in descending order of size, starting from 1
+            islandImageToWorldMatrix = vtk.vtkMatrix4x4()
+            islandImage.GetImageToWorldMatrix(islandImageToWorldMatrix)
+            for i in range(islandCount):
                 if (maxNumberOfSegments > 0 and i >= maxNumberOfSegments):
                     # We only care about the segments up to maxNumberOfSegments.
                     # If we do not want to split segments, we only care about the first.
                     break
 
-                labelValue = int(labelValues.GetTuple1(i))
+                labelValue = i + 1
                 segment = selectedSegment
                 segmentID = selectedSegmentID
                 if i != 0 and split:
@@ -211,7 +206,7 @@ about each operation, hover the mouse over the option and wait for the tooltip t
                     segment.SetLabelValue(segmentation.GetUniqueLabelValueForSharedLabelmap(selectedSegmentID))
 
                 threshold = vtk.vtkImageThreshold()
-                threshold.SetInputData(islandMath.GetOutput())
+                threshold.SetInputData(islandImage)
                 if not split and maxNumberOfSegments <= 0:
                     # no need to split segments and no limit on number of segments, so we can lump all islands into one segment
                     threshold.ThresholdByLower(0)
@@ -231,9 +226,7 @@ about each operation, hover the mouse over the option and wait for the tooltip t
                 # Create oriented image data from output
                 modifierImage = slicer.vtkOrientedImageData()
                 modifierImage.DeepCopy(threshold.GetOutput())
-                selectedSegmentLabelmapImageToWorldMatrix = vtk.vtkMatrix4x4()
-                selectedSegmentLabelmap.GetImageToWorldMatrix(selectedSegmentLabelmapImageToWorldMatrix)
-                modifierImage.SetGeometryFromImageToWorldMatrix(selectedSegmentLabelmapImageToWorldMatrix)
+                modifierImage.SetGeometryFromImageToWorldMatrix(islandImageToWorldMatrix)
                 # We could use a single slicer.vtkSlicerSegmentationsModuleLogic.ImportLabelmapToSegmentationNode
                 # method call to import all the resulting segments at once but that would put all the imported segments
                 # in a new layer. By using modifySegmentByLabelmap, the number of layers will not increase.
@@ -179,6 +179,110 @@ class SegmentEditorLogicalEffect(AbstractScriptedSegmentEditorEffect):
         invertedModifierLabelmap.SetGeometryFromImageToWorldMatrix(imageToWorldMatrix)
         return invertedModifierLabelmap
 
+    def applyInPlace(self, operation, bypassMasking):
+        """Apply union, intersect, subtract, or invert operation directly on the label values
+        of the binary labelmap layers, without extracting, resampling, and merging segment labelmaps.
+        It is only done if the result is the same as with modifySelectedSegmentByLabelmap: masking is not active,
+        layer geometries match, and no other segment would have to be moved to a separate layer.
+        Returns True if the operation is applied.
+        """
+        if operation not in [LOGICAL_UNION, LOGICAL_INTERSECT, LOGICAL_SUBTRACT, LOGICAL_INVERT]:
+            return False
+
+        import vtkSegmentationCorePython as vtkSegmentationCore
+        import vtkSlicerSegmentationsModuleLogicPython as vtkSlicerSegmentationsModuleLogic
+
+        parameterSetNode = self.scriptedEffect.parameterSetNode()
+        segmentation = parameterSetNode.GetSegmentationNode().GetSegmentation()
+        binaryLabelmapReprName = vtkSegmentationCore.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName()
+        if segmentation.GetMasterRepresentationName() != binaryLabelmapReprName:
+            return False
+
+        # Intensity mask is applied even if masking is bypassed
+        if parameterSetNode.GetSourceVolumeIntensityMask():
+            return False
+        if not bypassMasking and parameterSetNode.GetMaskMode() != slicer.vtkMRMLSegmentationNode.EditAllowedEverywhere:
+            return False
+
+        # Subtract never sets the segment, therefore other segments are not affected by the overwrite mode.
+        # Other segments can only be overwritten in place if they are all in the same layer.
+        overwriteOtherLabels = False
+        if operation != LOGICAL_SUBTRACT and not bypassMasking:
+            overwriteMode = parameterSetNode.GetOverwriteMode()
+            if overwriteMode == slicer.vtkMRMLSegmentEditorNode.OverwriteAllSegments and segmentation.GetNumberOfLayers() == 1:
+                overwriteOtherLabels = True
+            elif overwriteMode != slicer.vtkMRMLSegmentEditorNode.OverwriteNone:
+                return False
+
+        selectedSegment = segmentation.GetSegment(parameterSetNode.GetSelectedSegmentID())
+        if not selectedSegment:
+            return False
+        labelmap = selectedSegment.GetRepresentation(binaryLabelmapReprName)
+        if not labelmap:
+            return False
+
+        logicalOperation = vtkSlicerSegmentationsModuleLogic.vtkImageLabelLogicalOperation()
+        logicalOperation.SetLabelmap(labelmap)
+        logicalOperation.SetLabelValue(selectedSegment.GetLabelValue())
+        logicalOperation.SetOverwriteOtherLabels(overwriteOtherLabels)
+
+        if operation == LOGICAL_INVERT:
+            # Segment is inverted within the reference geometry
+            referenceGeometryImage = self.scriptedEffect.referenceGeometryImage()
+            if labelmap.IsEmpty() or not vtkSegmentationCore.vtkOrientedImageDataResample.DoGeometriesMatch(labelmap, referenceGeometryImage):
+                return False
+            logicalOperation.SetOperationToInvert()
+            logicalOperation.SetExtent(referenceGeometryImage.GetExtent())
+        else:
+            modifierSegment = segmentation.GetSegment(self.modifierSegmentID())
+            if not modifierSegment:
+                return False
+            modifierLabelmap = modifierSegment.GetRepresentation(binaryLabelmapReprName)
+            if not modifierLabelmap:
+                return False
+            if (not labelmap.IsEmpty() and not modifierLabelmap.IsEmpty()
+                    and not vtkSegmentationCore.vtkOrientedImageDataResample.DoGeometriesMatch(labelmap, modifierLabelmap)):
+                return False
+            logicalOperation.SetModifierLabelmap(modifierLabelmap)
+            logicalOperation.AddModifierLabelValue(modifierSegment.GetLabelValue())
+            if operation == LOGICAL_UNION:
+                logicalOperation.SetOperationToUnion()
+            elif operation == LOGICAL_INTERSECT:
+                logicalOperation.SetOperationToIntersect()
+            else:
+                logicalOperation.SetOperationToSubtract()
+
+        # Labelmap is left unchanged if the operation cannot be applied in place.
+        # Master representation modified event is disabled, because it would remove the other representations
+        # of all segments in the layer. Only the modified segments are reconverted below.
+        wasMasterRepresentationModifiedEnabled = segmentation.SetMasterRepresentationModifiedEnabled(False)
+        try:
+            success = logicalOperation.Execute()
+        finally:
+            segmentation.SetMasterRepresentationModifiedEnabled(wasMasterRepresentationModifiedEnabled)
+        if not success:
+            return False
+
+        if logicalOperation.GetNumberOfModifiedVoxels() > 0:
+            # The selected segment and the segments in the same layer whose voxels were overwritten are modified
+            selectedSegmentID = parameterSetNode.GetSelectedSegmentID()
+            modifiedSegmentIDs = vtk.vtkStringArray()
+            modifiedSegmentIDs.InsertNextValue(selectedSegmentID)
+            overwrittenLabelValues = [logicalOperation.GetNthOverwrittenLabelValue(i)
+                                      for i in range(logicalOperation.GetNumberOfOverwrittenLabelValues())]
+            if overwrittenLabelValues:
+                for segmentIndex in range(segmentation.GetNumberOfSegments()):
+                    segmentID = segmentation.GetNthSegmentID(segmentIndex)
+                    segment = segmentation.GetSegment(segmentID)
+                    if (segmentID != selectedSegmentID and segment.GetRepresentation(binaryLabelmapReprName) is labelmap
+                            and segment.GetLabelValue() in overwrittenLabelValues):
+                        modifiedSegmentIDs.InsertNextValue(segmentID)
+            segmentationsLogic = slicer.modules.segmentations.logic()
+            segmentationsLogic.UpdateSegmentsModifiedInPlace(parameterSetNode.GetSegmentationNode(), modifiedSegmentIDs)
+            if segmentationsLogic.GetSegmentStatus(selectedSegment) == segmentationsLogic.NotStarted:
+                segmentationsLogic.SetSegmentStatus(selectedSegment, segmentationsLogic.InProgress)
+        return True
+
     def onApply(self):
         # Make sure the user wants to do the operation, even if the segment is not visible
         if not self.scriptedEffect.confirmCurrentSegmentVisible():
@@ -198,6 +302,10 @@ class SegmentEditorLogicalEffect(AbstractScriptedSegmentEditorEffect):
         segmentationNode = self.scriptedEffect.parameterSetNode().GetSegmentationNode()
         segmentation = segmentationNode.GetSegmentation()
 
+        # Segments in matching layers are combined directly by their label values
+        if self.applyInPlace(operation, bypassMasking):
+            return
+
         if operation in self.operationsRequireModifierSegment:
 
             # Get modifier segment
@@ -17,6 +17,7 @@ class SegmentEditorMarginEffect(AbstractScriptedSegmentEditorEffect):
     def __init__(self, scriptedEffect):
         scriptedEffect.name = 'Margin'
         AbstractScriptedSegmentEditorEffect.__init__(self, scriptedEffect)
+        self.labelMargin = None
 
     def clone(self):
         import qSlicerSegmentationsEditorEffectsPythonQt as effects
@@ -33,6 +34,10 @@ class SegmentEditorMarginEffect(AbstractScriptedSegmentEditorEffect):
     def helpText(self):
         return "Grow or shrink selected segment by specified margin size."
 
+    def deactivate(self):
+        # Release cached distance maps
+        self.labelMargin = None
+
     def setupOptionsFrame(self):
 
         operationLayout = qt.QVBoxLayout()
@@ -162,48 +167,30 @@ class SegmentEditorMarginEffect(AbstractScriptedSegmentEditorEffect):
         slicer.util.showStatusMessage(msg, timeoutMsec)
         slicer.app.processEvents()
 
+    def getLabelMargin(self):
+        """Get label margin operation that is set up according to the current effect parameters.
+        The operation is kept while the effect is active so that distance maps of unchanged segments
+        are reused when the operation is repeated with a different margin size (e.g., after undo).
+        """
+        if not self.labelMargin:
+            import vtkSlicerSegmentationsModuleLogicPython as vtkSlicerSegmentationsModuleLogic
+            self.labelMargin = vtkSlicerSegmentationsModuleLogic.vtkImageLabelMargin()
+        self.labelMargin.SetMarginSize(self.scriptedEffect.doubleParameter("MarginSizeMm"))
+        return self.labelMargin
+
     def processMargin(self):
         # Get modifier labelmap and parameters
         modifierLabelmap = self.scriptedEffect.defaultModifierLabelmap()
         selectedSegmentLabelmap = self.scriptedEffect.selectedSegmentLabelmap()
 
-        marginSizeMM = self.scriptedEffect.doubleParameter("MarginSizeMm")
-
-        # We need to know exactly the value of the segment voxels, apply threshold to make force the selected label value
-        labelValue = 1
-        backgroundValue = 0
-        thresh = vtk.vtkImageThreshold()
-        thresh.SetInputData(selectedSegmentLabelmap)
-        thresh.ThresholdByLower(0)
-        thresh.SetInValue(backgroundValue)
-        thresh.SetOutValue(labelValue)
-        thresh.SetOutputScalarType(selectedSegmentLabelmap.GetScalarType())
-        if (marginSizeMM < 0):
-            # The distance filter used in the margin filter starts at zero at the border voxels,
-            # so if we need to shrink the margin, it is more accurate to invert the labelmap and
-            # use positive distance when calculating the margin
-            thresh.SetInValue(labelValue)
-            thresh.SetOutValue(backgroundValue)
-
-        import vtkITK
-        margin = vtkITK.vtkITKImageMargin()
-        margin.SetInputConnection(thresh.GetOutputPort())
-        margin.CalculateMarginInMMOn()
-        margin.SetOuterMarginMM(abs(marginSizeMM))
-        margin.Update()
-
-        if marginSizeMM >= 0:
-            modifierLabelmap.ShallowCopy(margin.GetOutput())
-        else:
-            # If we are shrinking then the result needs to be inverted.
-            thresh = vtk.vtkImageThreshold()
-            thresh.SetInputData(margin.GetOutput())
-            thresh.ThresholdByLower(0)
-            thresh.SetInValue(labelValue)
-            thresh.SetOutValue(backgroundValue)
-            thresh.SetOutputScalarType(selectedSegmentLabelmap.GetScalarType())
-            thresh.Update()
-            modifierLabelmap.ShallowCopy(thresh.GetOutput())
+        labelMargin = self.getLabelMargin()
+        labelMargin.SetLabelmap(selectedSegmentLabelmap)
+        # Selected segment labelmap contains 1 in the segment and 0 elsewhere
+        success = labelMargin.Execute(1, modifierLabelmap)
+        labelMargin.SetLabelmap(None)
+        if not success:
+            logging.error('Failed to apply margin')
+            return
 
         # Apply changes
         self.scriptedEffect.modifySelectedSegmentByLabelmap(modifierLabelmap, slicer.qSlicerSegmentEditorAbstractEffect.ModificationModeSet)
@@ -222,23 +209,15 @@ class SegmentEditorMarginEffect(AbstractScriptedSegmentEditorEffect):
                 if self.scriptedEffect.parameter("ApplyToAllVisibleSegments") else False
 
             if applyToAllVisibleSegments:
-                # Smooth all visible segments
+                # Process all visible segments
                 inputSegmentIDs = vtk.vtkStringArray()
                 segmentationNode = self.scriptedEffect.parameterSetNode().GetSegmentationNode()
                 segmentationNode.GetDisplayNode().GetVisibleSegmentIDs(inputSegmentIDs)
-                # store which segment was selected before operation
-                selectedStartSegmentID = self.scriptedEffect.parameterSetNode().GetSelectedSegmentID()
                 if inputSegmentIDs.GetNumberOfValues() == 0:
                     logging.info("Margin operation skipped: there are no visible segments.")
                     return
-                # select input segments one by one, process
-                for index in range(inputSegmentIDs.GetNumberOfValues()):
-                    segmentID = inputSegmentIDs.GetValue(index)
-                    self.showStatusMessage(f'Processing {segmentationNode.GetSegmentation().GetSegment(segmentID).GetName()}...')
-                    self.scriptedEffect.parameterSetNode().SetSelectedSegmentID(segmentID)
-                    self.processMargin()
-                # restore segment selection
-                self.scriptedEffect.parameterSetNode().SetSelectedSegmentID(selectedStartSegmentID)
+                segmentIDs = [inputSegmentIDs.GetValue(index) for index in range(inputSegmentIDs.GetNumberOfValues())]
+                self.applyLabelOperationToSegments(self.getLabelMargin(), segmentIDs, 'Processing')
             else:
                 self.processMargin()
 
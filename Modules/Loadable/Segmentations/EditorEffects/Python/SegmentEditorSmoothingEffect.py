@@ -217,18 +217,21 @@ If segments overlap, segment higher in the segments table will have priority. <b
                 inputSegmentIDs = vtk.vtkStringArray()
                 segmentationNode = self.scriptedEffect.parameterSetNode().GetSegmentationNode()
                 segmentationNode.GetDisplayNode().GetVisibleSegmentIDs(inputSegmentIDs)
-                # store which segment was selected before operation
-                selectedStartSegmentID = self.scriptedEffect.parameterSetNode().GetSelectedSegmentID()
                 if inputSegmentIDs.GetNumberOfValues() == 0:
                     logging.info("Smoothing operation skipped: there are no visible segments.")
                     return
-                for index in range(inputSegmentIDs.GetNumberOfValues()):
-                    segmentID = inputSegmentIDs.GetValue(index)
-                    self.showStatusMessage(f'Smoothing {segmentationNode.GetSegmentation().GetSegment(segmentID).GetName()}...')
-                    self.scriptedEffect.parameterSetNode().SetSelectedSegmentID(segmentID)
-                    self.smoothSelectedSegment(maskImage, maskExtent)
-                # restore segment selection
-                self.scriptedEffect.parameterSetNode().SetSelectedSegmentID(selectedStartSegmentID)
+                segmentIDs = [inputSegmentIDs.GetValue(index) for index in range(inputSegmentIDs.GetNumberOfValues())]
+                if maskImage:
+                    # store which segment was selected before operation
+                    selectedStartSegmentID = self.scriptedEffect.parameterSetNode().GetSelectedSegmentID()
+                    for segmentID in segmentIDs:
+                        self.showStatusMessage(f'Smoothing {segmentationNode.GetSegmentation().GetSegment(segmentID).GetName()}...')
+                        self.scriptedEffect.parameterSetNode().SetSelectedSegmentID(segmentID)
+                        self.smoothSelectedSegment(maskImage, maskExtent)
+                    # restore segment selection
+                    self.scriptedEffect.parameterSetNode().SetSelectedSegmentID(selectedStartSegmentID)
+                else:
+                    self.smoothSegments(segmentIDs)
             else:
                 self.smoothSelectedSegment(maskImage, maskExtent)
         finally:
@@ -275,93 +278,66 @@ If segments overlap, segment higher in the segments table will have priority. <b
             modifierLabelmap.DeepCopy(smoothedImage)
             self.scriptedEffect.modifySelectedSegmentByLabelmap(modifierLabelmap, slicer.qSlicerSegmentEditorAbstractEffect.ModificationModeSet)
 
+    def createLabelSmoothing(self):
+        """Create label smoothing operation that is set up according to the current effect parameters"""
+        import vtkSlicerSegmentationsModuleLogicPython as vtkSlicerSegmentationsModuleLogic
+        labelSmoothing = vtkSlicerSegmentationsModuleLogic.vtkImageLabelSmoothing()
+        smoothingMethod = self.scriptedEffect.parameter("SmoothingMethod")
+        if smoothingMethod == GAUSSIAN:
+            standardDeviationMM = self.scriptedEffect.doubleParameter("GaussianStandardDeviationMm")
+            spacing = self.scriptedEffect.defaultModifierLabelmap().GetSpacing()
+            labelSmoothing.SetMethodToGaussian()
+            labelSmoothing.SetGaussianStandardDeviation(*[standardDeviationMM / spacing[idx] for idx in range(3)])
+            labelSmoothing.SetGaussianRadiusFactor(4.0)
+        else:
+            if smoothingMethod == MEDIAN:
+                labelSmoothing.SetMethodToMedian()
+            elif smoothingMethod == MORPHOLOGICAL_OPENING:
+                labelSmoothing.SetMethodToMorphologicalOpening()
+            else:  # must be smoothingMethod == MORPHOLOGICAL_CLOSING:
+                labelSmoothing.SetMethodToMorphologicalClosing()
+            # size rounded to nearest odd number. If kernel size is even then image gets shifted.
+            labelSmoothing.SetKernelSize(*self.getKernelSizePixel())
+        return labelSmoothing
+
+    def getClipMarginPixel(self, labelSmoothing):
+        if labelSmoothing.GetMethod() == labelSmoothing.Gaussian:
+            radiusFactor = labelSmoothing.GetGaussianRadiusFactor()
+            return [int(standardDeviation * radiusFactor) + 1 for standardDeviation in labelSmoothing.GetGaussianStandardDeviation()]
+        return list(labelSmoothing.GetKernelSize())
+
     def smoothSelectedSegment(self, maskImage=None, maskExtent=None):
         try:
             # Get modifier labelmap
             modifierLabelmap = self.scriptedEffect.defaultModifierLabelmap()
             selectedSegmentLabelmap = self.scriptedEffect.selectedSegmentLabelmap()
 
-            smoothingMethod = self.scriptedEffect.parameter("SmoothingMethod")
-
-            if smoothingMethod == GAUSSIAN:
-                maxValue = 255
-                radiusFactor = 4.0
-                standardDeviationMM = self.scriptedEffect.doubleParameter("GaussianStandardDeviationMm")
-                spacing = modifierLabelmap.GetSpacing()
-                standardDeviationPixel = [1.0, 1.0, 1.0]
-                radiusPixel = [3, 3, 3]
-                for idx in range(3):
-                    standardDeviationPixel[idx] = standardDeviationMM / spacing[idx]
-                    radiusPixel[idx] = int(standardDeviationPixel[idx] * radiusFactor) + 1
-                if maskExtent:
-                    clippedSelectedSegmentLabelmap = self.clipImage(selectedSegmentLabelmap, maskExtent, radiusPixel)
-                else:
-                    clippedSelectedSegmentLabelmap = selectedSegmentLabelmap
-
-                thresh = vtk.vtkImageThreshold()
-                thresh.SetInputData(clippedSelectedSegmentLabelmap)
-                thresh.ThresholdByLower(0)
-                thresh.SetInValue(0)
-                thresh.SetOutValue(maxValue)
-                thresh.SetOutputScalarType(vtk.VTK_UNSIGNED_CHAR)
-
-                gaussianFilter = vtk.vtkImageGaussianSmooth()
-                gaussianFilter.SetInputConnection(thresh.GetOutputPort())
-                gaussianFilter.SetStandardDeviation(*standardDeviationPixel)
-                gaussianFilter.SetRadiusFactor(radiusFactor)
-
-                thresh2 = vtk.vtkImageThreshold()
-                thresh2.SetInputConnection(gaussianFilter.GetOutputPort())
-                thresh2.ThresholdByUpper(int(maxValue / 2))
-                thresh2.SetInValue(1)
-                thresh2.SetOutValue(0)
-                thresh2.SetOutputScalarType(selectedSegmentLabelmap.GetScalarType())
-                thresh2.Update()
-
-                self.modifySelectedSegmentByLabelmap(thresh2.GetOutput(), selectedSegmentLabelmap, modifierLabelmap, maskImage, maskExtent)
-
+            labelSmoothing = self.createLabelSmoothing()
+            if maskExtent:
+                # Only the painted region is smoothed, the output must cover the entire clipped region
+                # so that the segment is not modified outside the painted region.
+                labelSmoothing.SetLabelmap(self.clipImage(selectedSegmentLabelmap, maskExtent, self.getClipMarginPixel(labelSmoothing)))
+                labelSmoothing.CropOutputOff()
             else:
-                # size rounded to nearest odd number. If kernel size is even then image gets shifted.
-                kernelSizePixel = self.getKernelSizePixel()
+                labelSmoothing.SetLabelmap(selectedSegmentLabelmap)
 
-                if maskExtent:
-                    clippedSelectedSegmentLabelmap = self.clipImage(selectedSegmentLabelmap, maskExtent, kernelSizePixel)
-                else:
-                    clippedSelectedSegmentLabelmap = selectedSegmentLabelmap
-
-                if smoothingMethod == MEDIAN:
-                    # Median filter does not require a particular label value
-                    smoothingFilter = vtk.vtkImageMedian3D()
-                    smoothingFilter.SetInputData(clippedSelectedSegmentLabelmap)
+            # Selected segment labelmap contains 1 in the segment and 0 elsewhere
+            smoothedImage = slicer.vtkOrientedImageData()
+            if not labelSmoothing.Execute(1, smoothedImage):
+                logging.error('apply: Failed to apply smoothing')
+                return
 
-                else:
-                    # We need to know exactly the value of the segment voxels, apply threshold to make force the selected label value
-                    labelValue = 1
-                    backgroundValue = 0
-                    thresh = vtk.vtkImageThreshold()
-                    thresh.SetInputData(clippedSelectedSegmentLabelmap)
-                    thresh.ThresholdByLower(0)
-                    thresh.SetInValue(backgroundValue)
-                    thresh.SetOutValue(labelValue)
-                    thresh.SetOutputScalarType(clippedSelectedSegmentLabelmap.GetScalarType())
-
-                    smoothingFilter = vtk.vtkImageOpenClose3D()
-                    smoothingFilter.SetInputConnection(thresh.GetOutputPort())
-                    if smoothingMethod == MORPHOLOGICAL_OPENING:
-                        smoothingFilter.SetOpenValue(labelValue)
-                        smoothingFilter.SetCloseValue(backgroundValue)
-                    else:  # must be smoothingMethod == MORPHOLOGICAL_CLOSING:
-                        smoothingFilter.SetOpenValue(backgroundValue)
-                        smoothingFilter.SetCloseValue(labelValue)
-
-                smoothingFilter.SetKernelSize(kernelSizePixel[0], kernelSizePixel[1], kernelSizePixel[2])
-                smoothingFilter.Update()
-
-                self.modifySelectedSegmentByLabelmap(smoothingFilter.GetOutput(), selectedSegmentLabelmap, modifierLabelmap, maskImage, maskExtent)
+            self.modifySelectedSegmentByLabelmap(smoothedImage, selectedSegmentLabelmap, modifierLabelmap, maskImage, maskExtent)
 
         except IndexError:
             logging.error('apply: Failed to apply smoothing')
 
+    def smoothSegments(self, segmentIDs):
+        """Smooth segments one by one, using the same smoothing parameters.
+        Segments that are stored in the same shared labelmap are smoothed directly from the shared labelmap.
+        """
+        self.applyLabelOperationToSegments(self.createLabelSmoothing(), segmentIDs, 'Smoothing')
+
     def smoothMultipleSegments(self, maskImage=None, maskExtent=None):
         import vtkSegmentationCorePython as vtkSegmentationCore
 
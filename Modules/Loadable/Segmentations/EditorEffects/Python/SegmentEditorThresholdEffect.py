@@ -29,6 +29,9 @@ class SegmentEditorThresholdEffect(AbstractScriptedSegmentEditorEffect):
         # Effect-specific members
         import vtkITK
         self.autoThresholdCalculator = vtkITK.vtkITKImageThresholdCalculator()
+        # Thresholding of the full source volume keeps its brick table and mask between applies,
+        # therefore re-applying with adjusted thresholds only updates the changed regions.
+        self.brickThreshold = None
 
         self.timer = qt.QTimer()
         self.previewState = 0
@@ -397,6 +400,9 @@ class SegmentEditorThresholdEffect(AbstractScriptedSegmentEditorEffect):
     def sourceVolumeNodeChanged(self):
         # Set scalar range of source volume image data to threshold slider
         masterImageData = self.scriptedEffect.sourceVolumeImageData()
+        if self.brickThreshold:
+            # Release cache of the previous source volume
+            self.brickThreshold.ClearCache()
         if masterImageData:
             lo, hi = masterImageData.GetScalarRange()
             self.thresholdSlider.setRange(lo, hi)
@@ -511,6 +517,8 @@ class SegmentEditorThresholdEffect(AbstractScriptedSegmentEditorEffect):
     #
     def onThresholdValuesChanged(self, min, max):
         self.scriptedEffect.updateMRMLFromGUI()
+        # Show the new threshold range immediately, not just at the next preview timer event
+        self.updatePreviewThresholds()
 
     def onUseForPaint(self):
         parameterSetNode = self.scriptedEffect.parameterSetNode()
@@ -606,14 +614,17 @@ class SegmentEditorThresholdEffect(AbstractScriptedSegmentEditorEffect):
             self.scriptedEffect.saveStateForUndo()
 
             # Perform thresholding
-            thresh = vtk.vtkImageThreshold()
-            thresh.SetInputData(masterImageData)
-            thresh.ThresholdBetween(min, max)
-            thresh.SetInValue(1)
-            thresh.SetOutValue(0)
-            thresh.SetOutputScalarType(modifierLabelmap.GetScalarType())
-            thresh.Update()
-            modifierLabelmap.DeepCopy(thresh.GetOutput())
+            if not self.brickThreshold:
+                import vtkSlicerSegmentationsModuleLogicPython as vtkSlicerSegmentationsModuleLogic
+                self.brickThreshold = vtkSlicerSegmentationsModuleLogic.vtkImageBrickThreshold()
+                # The modifier labelmap must cover the whole source volume: with masking, the segment
+                # is only restored within the modifier labelmap extent, so a cropped output would erase it.
+                self.brickThreshold.CropOutputOff()
+            self.brickThreshold.SetInputImage(masterImageData)
+            success = self.brickThreshold.Execute(min, max, modifierLabelmap)
+            self.brickThreshold.SetInputImage(None)
+            if not success:
+                logging.error('apply: Failed to threshold source volume!')
         except IndexError:
             logging.error('apply: Failed to threshold source volume!')
             pass
@@ -687,11 +698,8 @@ class SegmentEditorThresholdEffect(AbstractScriptedSegmentEditorEffect):
         for sliceWidget in self.previewPipelines:
             pipeline = self.previewPipelines[sliceWidget]
             pipeline.lookupTable.SetTableValue(1, r, g, b, opacity)
-            layerLogic = self.getSourceVolumeLayerLogic(sliceWidget)
-            pipeline.thresholdFilter.SetInputConnection(layerLogic.GetReslice().GetOutputPort())
-            pipeline.thresholdFilter.ThresholdBetween(min, max)
             pipeline.actor.VisibilityOn()
-            sliceWidget.sliceView().scheduleRender()
+        self.updatePreviewThresholds()
 
         self.previewState += self.previewStep
         if self.previewState >= self.previewSteps:
@@ -699,6 +707,21 @@ class SegmentEditorThresholdEffect(AbstractScriptedSegmentEditorEffect):
         if self.previewState <= 0:
             self.previewStep = 1
 
+    def updatePreviewThresholds(self, sliceWidgets=None):
+        """Threshold the resliced source volume in the preview pipelines.
+        Only those bricks of the slices are updated that may change since the last update.
+        """
+        min = self.scriptedEffect.doubleParameter("MinimumThreshold")
+        max = self.scriptedEffect.doubleParameter("MaximumThreshold")
+        for sliceWidget, pipeline in self.previewPipelines.items():
+            if sliceWidgets is not None and sliceWidget not in sliceWidgets:
+                continue
+            layerLogic = self.getSourceVolumeLayerLogic(sliceWidget)
+            reslice = layerLogic.GetReslice()
+            reslice.Update()
+            pipeline.updateThresholdedImage(reslice.GetOutput(), min, max)
+            sliceWidget.sliceView().scheduleRender()
+
     def processInteractionEvents(self, callerInteractor, eventId, viewWidget):
         abortEvent = False
 
@@ -751,6 +774,8 @@ class SegmentEditorThresholdEffect(AbstractScriptedSegmentEditorEffect):
     def processViewNodeEvents(self, callerViewNode, eventId, viewWidget):
         if self.histogramPipeline is not None:
             self.histogramPipeline.updateBrushModel()
+        if viewWidget in self.previewPipelines:
+            self.updatePreviewThresholds([viewWidget])
 
     def onHistogramMouseClick(self, pos, button):
         self.selectionStartPosition = pos
@@ -947,10 +972,17 @@ class PreviewPipeline:
         self.colorMapper = vtk.vtkImageMapToRGBA()
         self.colorMapper.SetOutputFormatToRGBA()
         self.colorMapper.SetLookupTable(self.lookupTable)
-        self.thresholdFilter = vtk.vtkImageThreshold()
-        self.thresholdFilter.SetInValue(1)
-        self.thresholdFilter.SetOutValue(0)
-        self.thresholdFilter.SetOutputScalarTypeToUnsignedChar()
+        # Thresholding keeps the brick table and the mask of the resliced image, therefore
+        # when the threshold slider is moved only the bricks that may change are updated.
+        import vtkSlicerSegmentationsModuleLogicPython as vtkSlicerSegmentationsModuleLogic
+        self.brickThreshold = vtkSlicerSegmentationsModuleLogic.vtkImageBrickThreshold()
+        self.brickThreshold.CropOutputOff()
+        self.thresholdedImage = slicer.vtkOrientedImageData()
+        self.thresholdedImage.SetExtent(0, -1, 0, -1, 0, -1)
+        self.thresholdedImage.AllocateScalars(vtk.VTK_UNSIGNED_CHAR, 1)
+        # Threshold range and resliced image time that thresholdedImage was computed for
+        self.thresholdedRange = None
+        self.thresholdedImageTime = 0
 
         # Feedback actor
         self.mapper = vtk.vtkImageMapper()
@@ -964,9 +996,24 @@ class PreviewPipeline:
         self.mapper.SetColorLevel(128)
 
         # Setup pipeline
-        self.colorMapper.SetInputConnection(self.thresholdFilter.GetOutputPort())
+        self.colorMapper.SetInputData(self.thresholdedImage)
         self.mapper.SetInputConnection(self.colorMapper.GetOutputPort())
 
+    def updateThresholdedImage(self, reslicedImage, lowerThreshold, upperThreshold):
+        """Threshold the resliced source volume if the image or the threshold range has changed"""
+        scalars = reslicedImage.GetPointData().GetScalars()
+        if scalars is None:
+            return
+        imageTime = max(reslicedImage.GetMTime(), scalars.GetMTime())
+        if self.thresholdedRange == (lowerThreshold, upperThreshold) and self.thresholdedImageTime == imageTime:
+            # up-to-date
+            return
+        self.brickThreshold.SetInputImage(reslicedImage)
+        if not self.brickThreshold.Execute(lowerThreshold, upperThreshold, self.thresholdedImage):
+            logging.error('preview: Failed to threshold source volume!')
+        self.thresholdedRange = (lowerThreshold, upperThreshold)
+        self.thresholdedImageTime = imageTime
+
 
 ###
 #
@@ -21,6 +21,7 @@
 // Segmentations includes
 #include "qSlicerSegmentEditorPaintEffect.h"
 #include "qSlicerSegmentEditorPaintEffect_p.h"
+#include "vtkImageBrushStrokeRasterizer.h"
 #include "vtkMRMLSegmentationNode.h"
 #include "vtkMRMLSegmentationDisplayNode.h"
 #include "vtkMRMLSegmentationsDisplayableManager2D.h"
@@ -48,10 +49,6 @@
 #include <vtkGlyph2D.h>
 #include <vtkGlyph3D.h>
 #include <vtkIdList.h>
-#include <vtkImageChangeInformation.h>
-#include <vtkImageStencil.h>
-#include <vtkImageStencilData.h>
-#include <vtkImageStencilToImage.h>
 #include <vtkMath.h>
 #include <vtkMatrix4x4.h>
 #include <vtkNew.h>
@@ -62,7 +59,6 @@
 #include <vtkPolyDataMapper.h>
 #include <vtkPolyDataMapper2D.h>
 #include <vtkPolyDataNormals.h>
-#include <vtkPolyDataToImageStencil.h>
 #include <vtkProperty2D.h>
 #include <vtkProperty.h>
 #include <vtkPropPicker.h>
@@ -94,7 +90,6 @@
 #include "qSlicerApplication.h"
 #include "vtkMRMLSliceLogic.h"
 #include "vtkMRMLSliceLayerLogic.h"
-#include "vtkOrientedImageDataResample.h"
 
 //-----------------------------------------------------------------------------
 /// Visualization objects and pipeline for each slice view for the paint brush
@@ -263,13 +258,7 @@ qSlicerSegmentEditorPaintEffectPrivate::qSlicerSegmentEditorPaintEffectPrivate(q
   this->WorldOriginToWorldTransformer->SetTransform(this->WorldOriginToWorldTransform);
   this->WorldOriginToWorldTransformer->SetInputConnection(this->BrushPolyDataNormals->GetOutputPort());
 
-  this->WorldOriginToModifierLabelmapIjkTransformer = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-  this->WorldOriginToModifierLabelmapIjkTransform = vtkSmartPointer<vtkTransform>::New();
-  this->WorldOriginToModifierLabelmapIjkTransformer->SetTransform(this->WorldOriginToModifierLabelmapIjkTransform);
-  this->WorldOriginToModifierLabelmapIjkTransformer->SetInputConnection(this->BrushPolyDataNormals->GetOutputPort());
-  this->BrushPolyDataToStencil = vtkSmartPointer<vtkPolyDataToImageStencil>::New();
-  this->BrushPolyDataToStencil->SetOutputSpacing(1.0,1.0,1.0);
-  this->BrushPolyDataToStencil->SetInputConnection(this->WorldOriginToModifierLabelmapIjkTransformer->GetOutputPort());
+  this->BrushStrokeRasterizer = vtkSmartPointer<vtkImageBrushStrokeRasterizer>::New();
 
   this->FeedbackGlyphFilter = vtkSmartPointer<vtkGlyph3D>::New();
   this->FeedbackGlyphFilter->SetInputData(this->FeedbackPointsPolyData);
@@ -367,58 +356,6 @@ void qSlicerSegmentEditorPaintEffectPrivate::paintAddPoint(qMRMLWidget* viewWidg
     }
 }
 
-//-----------------------------------------------------------------------------
-void qSlicerSegmentEditorPaintEffectPrivate::updateBrushStencil(qMRMLWidget* viewWidget)
-{
-  Q_Q(qSlicerSegmentEditorPaintEffect);
-  Q_UNUSED(viewWidget);
-
-  if (!q->parameterSetNode())
-    {
-    qCritical() << Q_FUNC_INFO << ": Invalid segment editor parameter set node!";
-    return;
-    }
-  vtkMRMLSegmentationNode* segmentationNode = q->parameterSetNode()->GetSegmentationNode();
-  if (!segmentationNode)
-    {
-    qCritical() << Q_FUNC_INFO << ": Invalid segmentationNode";
-    return;
-    }
-  vtkOrientedImageData* modifierLabelmap = q->modifierLabelmap();
-  if (!modifierLabelmap)
-    {
-    qCritical() << Q_FUNC_INFO << ": Invalid modifierLabelmap";
-    return;
-    }
-
-  // Brush stencil transform
-
-  this->WorldOriginToModifierLabelmapIjkTransform->Identity();
-
-  vtkNew<vtkMatrix4x4> segmentationToSegmentationIjkTransformMatrix;
-  modifierLabelmap->GetImageToWorldMatrix(segmentationToSegmentationIjkTransformMatrix.GetPointer());
-  segmentationToSegmentationIjkTransformMatrix->Invert();
-  segmentationToSegmentationIjkTransformMatrix->SetElement(0,3, 0);
-  segmentationToSegmentationIjkTransformMatrix->SetElement(1,3, 0);
-  segmentationToSegmentationIjkTransformMatrix->SetElement(2,3, 0);
-  this->WorldOriginToModifierLabelmapIjkTransform->Concatenate(segmentationToSegmentationIjkTransformMatrix.GetPointer());
-
-  vtkNew<vtkMatrix4x4> worldToSegmentationTransformMatrix;
-  // We don't support painting in non-linearly transformed node (it could be implemented, but would probably slow down things too much)
-  // TODO: show a meaningful error message to the user if attempted
-  vtkMRMLTransformNode::GetMatrixTransformBetweenNodes(nullptr, segmentationNode->GetParentTransformNode(), worldToSegmentationTransformMatrix.GetPointer());
-  worldToSegmentationTransformMatrix->SetElement(0,3, 0);
-  worldToSegmentationTransformMatrix->SetElement(1,3, 0);
-  worldToSegmentationTransformMatrix->SetElement(2,3, 0);
-  this->WorldOriginToModifierLabelmapIjkTransform->Concatenate(worldToSegmentationTransformMatrix.GetPointer());
-
-  this->WorldOriginToModifierLabelmapIjkTransformer->Update();
-  vtkPolyData* brushModel_ModifierLabelmapIjk = this->WorldOriginToModifierLabelmapIjkTransformer->GetOutput();
-  double* boundsIjk = brushModel_ModifierLabelmapIjk->GetBounds();
-  this->BrushPolyDataToStencil->SetOutputWholeExtent(floor(boundsIjk[0])-1, ceil(boundsIjk[1])+1,
-    floor(boundsIjk[2])-1, ceil(boundsIjk[3])+1, floor(boundsIjk[4])-1, ceil(boundsIjk[5])+1);
-}
-
 //-----------------------------------------------------------------------------
 void qSlicerSegmentEditorPaintEffectPrivate::transformPointsFromWorldToIJK(vtkOrientedImageData* image,
   vtkMRMLSegmentationNode* segmentationNode, vtkPoints* rasPoints, vtkPoints* ijkPoints)
@@ -522,10 +459,14 @@ void qSlicerSegmentEditorPaintEffectPrivate::paintBrushes(
   vtkPoints* pixelPositions_World,
   int updateExtent[6])
 {
-  Q_UNUSED(pixelPositions_World);
+  Q_UNUSED(viewWidget);
   Q_Q(qSlicerSegmentEditorPaintEffect);
 
-  this->updateBrushStencil(viewWidget);
+  if (!pixelPositions_World)
+    {
+    qCritical() << Q_FUNC_INFO << ": Invalid pixelPositions";
+    return;
+    }
 
   if (!modifierLabelmap)
     {
@@ -539,57 +480,21 @@ void qSlicerSegmentEditorPaintEffectPrivate::paintBrushes(
     return;
     }
 
-  this->BrushPolyDataToStencil->Update();
-  vtkImageStencilData* stencilData = this->BrushPolyDataToStencil->GetOutput();
-  int stencilExtent[6]={0,-1,0,-1,0,-1};
-  stencilData->GetExtent(stencilExtent);
-
-  vtkNew<vtkPoints> paintCoordinates_Ijk;
-  this->transformPointsFromWorldToIJK(modifierLabelmap, segmentationNode, this->PaintCoordinates_World, paintCoordinates_Ijk);
-
-  vtkNew<vtkImageStencilToImage> stencilToImage;
-  stencilToImage->SetInputConnection(this->BrushPolyDataToStencil->GetOutputPort());
-  stencilToImage->SetInsideValue(q->m_FillValue);
-  stencilToImage->SetOutsideValue(q->m_EraseValue);
-  stencilToImage->SetOutputScalarType(modifierLabelmap->GetScalarType());
-
-  vtkNew<vtkImageChangeInformation> brushPositioner;
-  brushPositioner->SetInputConnection(stencilToImage->GetOutputPort());
-  brushPositioner->SetOutputSpacing(modifierLabelmap->GetSpacing());
-  brushPositioner->SetOutputOrigin(modifierLabelmap->GetOrigin());
-
-  vtkIdType numberOfPoints = this->PaintCoordinates_World->GetNumberOfPoints();
-  for (int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
-    {
-    double* shiftDouble = paintCoordinates_Ijk->GetPoint(pointIndex);
-    int shift[3] = {vtkMath::Round(shiftDouble[0]), vtkMath::Round(shiftDouble[1]), vtkMath::Round(shiftDouble[2])};
-    brushPositioner->SetExtentTranslation(shift);
-    brushPositioner->Update();
-    vtkNew<vtkOrientedImageData> orientedBrushPositionerOutput;
-    orientedBrushPositionerOutput->ShallowCopy(brushPositioner->GetOutput());
-    orientedBrushPositionerOutput->CopyDirections(modifierLabelmap);
-    if (pointIndex == 0)
-      {
-      orientedBrushPositionerOutput->GetExtent(updateExtent);
-      }
-    else
-      {
-      int* brushExtent = orientedBrushPositionerOutput->GetExtent();
-      for (int i = 0; i < 3; i++)
-        {
-        if (brushExtent[i * 2] < updateExtent[i * 2])
-          {
-          updateExtent[i * 2] = brushExtent[i * 2];
-          }
-        if (brushExtent[i * 2 + 1] > updateExtent[i * 2 + 1])
-          {
-          updateExtent[i * 2 + 1] = brushExtent[i * 2 + 1];
-          }
-        }
-      }
-    vtkOrientedImageDataResample::ModifyImage(modifierLabelmap, orientedBrushPositionerOutput.GetPointer(), vtkOrientedImageDataResample::OPERATION_MAXIMUM);
-    }
-  modifierLabelmap->Modified();
+  // Brush shape is set in updateBrushModel, here only the transform to the labelmap is updated
+  vtkNew<vtkMatrix4x4> worldToSegmentationTransformMatrix;
+  // We don't support painting in non-linearly transformed node (it could be implemented, but would probably slow down things too much)
+  // TODO: show a meaningful error message to the user if attempted
+  vtkMRMLTransformNode::GetMatrixTransformBetweenNodes(nullptr, segmentationNode->GetParentTransformNode(), worldToSegmentationTransformMatrix.GetPointer());
+  vtkNew<vtkMatrix4x4> segmentationToModifierLabelmapIjkTransformMatrix;
+  modifierLabelmap->GetWorldToImageMatrix(segmentationToModifierLabelmapIjkTransformMatrix.GetPointer());
+  vtkNew<vtkMatrix4x4> worldToModifierLabelmapIjkTransformMatrix;
+  vtkMatrix4x4::Multiply4x4(segmentationToModifierLabelmapIjkTransformMatrix.GetPointer(),
+    worldToSegmentationTransformMatrix.GetPointer(), worldToModifierLabelmapIjkTransformMatrix.GetPointer());
+  this->BrushStrokeRasterizer->SetWorldToImageMatrix(worldToModifierLabelmapIjkTransformMatrix.GetPointer());
+  this->BrushStrokeRasterizer->SetFillValue(q->m_FillValue);
+
+  // The brush is swept along the stroke and voxels are written directly into the labelmap
+  this->BrushStrokeRasterizer->PaintStroke(modifierLabelmap, pixelPositions_World, updateExtent);
 }
 
 //-----------------------------------------------------------------------------
@@ -752,6 +657,7 @@ void qSlicerSegmentEditorPaintEffectPrivate::updateBrushModel(qMRMLWidget* viewW
     this->BrushSphereSource->SetPhiResolution(32);
     this->BrushSphereSource->SetThetaResolution(32);
     this->BrushToWorldOriginTransformer->SetInputConnection(this->BrushSphereSource->GetOutputPort());
+    this->BrushStrokeRasterizer->SetBrushShapeToSphere();
     }
   else
     {
@@ -760,7 +666,13 @@ void qSlicerSegmentEditorPaintEffectPrivate::updateBrushModel(qMRMLWidget* viewW
     double sliceSpacingMm = qSlicerSegmentEditorAbstractEffect::sliceSpacing(sliceWidget);
     this->BrushCylinderSource->SetHeight(sliceSpacingMm);
     this->BrushToWorldOriginTransformer->SetInputConnection(this->BrushCylinderSource->GetOutputPort());
+    this->BrushStrokeRasterizer->SetBrushShapeToCylinder();
+    this->BrushStrokeRasterizer->SetHeight(sliceSpacingMm);
+    // cylinder axis is the slice normal
+    vtkMatrix4x4* sliceToRAS = sliceWidget->sliceLogic()->GetSliceNode()->GetSliceToRAS();
+    this->BrushStrokeRasterizer->SetCylinderAxis(sliceToRAS->GetElement(0, 2), sliceToRAS->GetElement(1, 2), sliceToRAS->GetElement(2, 2));
     }
+  this->BrushStrokeRasterizer->SetRadius(diameterMm/2.0);
 
   vtkNew<vtkMatrix4x4> brushToWorldOriginTransformMatrix;
   if (sliceWidget)
@@ -62,9 +62,9 @@ class qMRMLSliceWidget;
 class qMRMLSpinBox;
 class vtkActor2D;
 class vtkGlyph3D;
+class vtkImageBrushStrokeRasterizer;
 class vtkPoints;
 class vtkPolyDataNormals;
-class vtkPolyDataToImageStencil;
 
 /// \ingroup SlicerRt_QtModules_Segmentations
 /// \brief Private implementation of the segment editor paint effect
@@ -91,13 +91,9 @@ public:
   /// Update brushes
   void updateBrushes();
 
-  /// Update brush model (shape and position)
+  /// Update brush model (shape and position) and the shape of the brush stroke rasterizer
   void updateBrushModel(qMRMLWidget* viewWidget, double brushPosition_World[3]);
 
-  /// Updates the brush stencil that can be used to quickly paint the brush shape into
-  /// modifierLabelmap at many different positions.
-  void updateBrushStencil(qMRMLWidget* viewWidget);
-
 protected:
   /// Get brush object for widget. Create if does not exist
   BrushPipeline* brushForWidget(qMRMLWidget* viewWidget);
@@ -143,9 +139,9 @@ public:
   vtkSmartPointer<vtkTransformPolyDataFilter> WorldOriginToWorldTransformer;
   vtkSmartPointer<vtkTransform> WorldOriginToWorldTransform;
   vtkSmartPointer<vtkPolyDataNormals> BrushPolyDataNormals;
-  vtkSmartPointer<vtkTransformPolyDataFilter> WorldOriginToModifierLabelmapIjkTransformer;
-  vtkSmartPointer<vtkTransform> WorldOriginToModifierLabelmapIjkTransform; // transforms from polydata source to modifierLabelmap's IJK coordinate system (brush origin in IJK origin)
-  vtkSmartPointer<vtkPolyDataToImageStencil> BrushPolyDataToStencil;
+
+  /// Paints the brush swept along the stroke directly into the modifier labelmap
+  vtkSmartPointer<vtkImageBrushStrokeRasterizer> BrushStrokeRasterizer;
 
   vtkSmartPointer<vtkGlyph3D> FeedbackGlyphFilter;
 
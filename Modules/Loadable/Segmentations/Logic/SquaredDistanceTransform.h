@@ -0,0 +1,143 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// exclude from VTK wrapping
+#ifndef __VTK_WRAP__
+
+#ifndef SquaredDistanceTransform_h
+#define SquaredDistanceTransform_h
+
+// VTK includes
+#include <vtkSMPTools.h>
+#include <vtkType.h>
+
+// STD includes
+#include <cmath>
+#include <limits>
+#include <vector>
+
+/// Squared distance of voxels that have no seed voxel on their line (yet)
+const float SQUARED_DISTANCE_INFINITE = std::numeric_limits<float>::max();
+
+//----------------------------------------------------------------------------
+/// One-dimensional squared distance transform of sampled function f:
+/// d(q) = min_p ( spacing^2 * (q-p)^2 + f(p) )
+/// Computed as the lower envelope of parabolas, as described in
+/// Felzenszwalb and Huttenlocher, "Distance Transforms of Sampled Functions", 2012.
+class SquaredDistanceTransform1D
+{
+public:
+  void Resize(int length)
+  {
+    if (static_cast<int>(this->F.size()) < length)
+      {
+      this->F.resize(length);
+      this->V.resize(length);
+      this->Z.resize(length + 1);
+      }
+  }
+
+  /// Transform values of a line in place
+  void Transform(float* values, vtkIdType stride, int length, double spacing)
+  {
+    this->Resize(length);
+    const double spacingSquared = spacing * spacing;
+    int numberOfParabolas = 0;
+    for (int q = 0; q < length; ++q)
+      {
+      this->F[q] = values[q * stride];
+      if (this->F[q] >= SQUARED_DISTANCE_INFINITE)
+        {
+        continue;
+        }
+      const double fq = this->F[q] + spacingSquared * q * q;
+      double intersection = -std::numeric_limits<double>::infinity();
+      while (numberOfParabolas > 0)
+        {
+        const int v = this->V[numberOfParabolas - 1];
+        intersection = (fq - (this->F[v] + spacingSquared * v * v)) / (2.0 * spacingSquared * (q - v));
+        if (intersection > this->Z[numberOfParabolas - 1])
+          {
+          break;
+          }
+        --numberOfParabolas;
+        intersection = -std::numeric_limits<double>::infinity();
+        }
+      this->V[numberOfParabolas] = q;
+      this->Z[numberOfParabolas] = intersection;
+      ++numberOfParabolas;
+      }
+    if (numberOfParabolas == 0)
+      {
+      // no finite values in this line
+      return;
+      }
+    this->Z[numberOfParabolas] = std::numeric_limits<double>::infinity();
+    int parabolaIndex = 0;
+    for (int q = 0; q < length; ++q)
+      {
+      while (this->Z[parabolaIndex + 1] < q)
+        {
+        ++parabolaIndex;
+        }
+      const int v = this->V[parabolaIndex];
+      values[q * stride] = static_cast<float>(spacingSquared * (q - v) * (q - v) + this->F[v]);
+      }
+  }
+
+protected:
+  std::vector<double> F;
+  std::vector<int> V;
+  std::vector<double> Z;
+};
+
+//----------------------------------------------------------------------------
+/// Compute exact squared Euclidean distance map in place.
+/// Values must be 0 at seed voxels and SQUARED_DISTANCE_INFINITE elsewhere.
+/// Values are stored in x-fastest order. Distance is only propagated along axes
+/// that have an entry of true in transformAxes (e.g., within slices).
+inline void ComputeSquaredDistances(float* squaredDistances, const int dimensions[3], const double spacing[3],
+  const bool transformAxes[3])
+{
+  const vtkIdType strides[3] = { 1, dimensions[0], static_cast<vtkIdType>(dimensions[0]) * dimensions[1] };
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    if (!transformAxes[axis] || dimensions[axis] < 2)
+      {
+      continue;
+      }
+    const int otherAxis0 = (axis == 0 ? 1 : 0);
+    const int otherAxis1 = (axis == 2 ? 1 : 2);
+    const vtkIdType numberOfLines = static_cast<vtkIdType>(dimensions[otherAxis0]) * dimensions[otherAxis1];
+    const double axisSpacing = fabs(spacing[axis]);
+    vtkSMPTools::For(0, numberOfLines, [&](vtkIdType firstLine, vtkIdType lastLine)
+      {
+      SquaredDistanceTransform1D transform;
+      for (vtkIdType line = firstLine; line < lastLine; ++line)
+        {
+        const vtkIdType index0 = line % dimensions[otherAxis0];
+        const vtkIdType index1 = line / dimensions[otherAxis0];
+        transform.Transform(squaredDistances + index0 * strides[otherAxis0] + index1 * strides[otherAxis1],
+          strides[axis], dimensions[axis], axisSpacing);
+        }
+      });
+    }
+}
+
+#endif
+
+#endif //__VTK_WRAP__
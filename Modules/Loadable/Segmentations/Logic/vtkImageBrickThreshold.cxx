@@ -0,0 +1,406 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkImageBrickThreshold.h"
+
+// vtkSegmentationCore includes
+#include "vtkOrientedImageData.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Voxel extent of a brick (in voxel indices relative to the first voxel of the image)
+void GetBrickVoxelExtent(vtkIdType brickIndex, const int brickDimensions[3], int brickSize,
+  const int dimensions[3], int voxelExtent[6])
+{
+  const int brick[3] =
+    {
+    static_cast<int>(brickIndex % brickDimensions[0]),
+    static_cast<int>((brickIndex / brickDimensions[0]) % brickDimensions[1]),
+    static_cast<int>(brickIndex / (static_cast<vtkIdType>(brickDimensions[0]) * brickDimensions[1]))
+    };
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    voxelExtent[axis * 2] = brick[axis] * brickSize;
+    voxelExtent[axis * 2 + 1] = std::min(voxelExtent[axis * 2] + brickSize, dimensions[axis]) - 1;
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void vtkImageBrickThresholdComputeBricks(vtkImageData* image, const int brickDimensions[3], int brickSize,
+  double* brickMinimums, double* brickMaximums, unsigned char* brickContainsNaN)
+{
+  int dimensions[3] = { 0, 0, 0 };
+  image->GetDimensions(dimensions);
+  vtkIdType increments[3] = { 0, 0, 0 };
+  image->GetIncrements(increments);
+  const T* basePtr = static_cast<const T*>(image->GetScalarPointer());
+  const vtkIdType numberOfBricks = static_cast<vtkIdType>(brickDimensions[0]) * brickDimensions[1] * brickDimensions[2];
+  vtkSMPTools::For(0, numberOfBricks, [&](vtkIdType firstBrick, vtkIdType lastBrick)
+    {
+    for (vtkIdType brickIndex = firstBrick; brickIndex < lastBrick; ++brickIndex)
+      {
+      int voxelExtent[6] = { 0, -1, 0, -1, 0, -1 };
+      GetBrickVoxelExtent(brickIndex, brickDimensions, brickSize, dimensions, voxelExtent);
+      T minimum = std::numeric_limits<T>::max();
+      T maximum = std::numeric_limits<T>::lowest();
+      bool containsNaN = false;
+      for (int k = voxelExtent[4]; k <= voxelExtent[5]; ++k)
+        {
+        for (int j = voxelExtent[2]; j <= voxelExtent[3]; ++j)
+          {
+          const T* voxelPtr = basePtr + k * increments[2] + j * increments[1] + voxelExtent[0] * increments[0];
+          for (int i = voxelExtent[0]; i <= voxelExtent[1]; ++i, voxelPtr += increments[0])
+            {
+            const T value = *voxelPtr;
+            if (value != value)
+              {
+              containsNaN = true;
+              continue;
+              }
+            minimum = std::min(minimum, value);
+            maximum = std::max(maximum, value);
+            }
+          }
+        }
+      brickMinimums[brickIndex] = static_cast<double>(minimum);
+      brickMaximums[brickIndex] = static_cast<double>(maximum);
+      brickContainsNaN[brickIndex] = (containsNaN ? 1 : 0);
+      }
+    });
+}
+
+//----------------------------------------------------------------------------
+/// Clamp threshold to the range of the scalar type and convert it to the scalar type (same as vtkImageThreshold)
+template <class T>
+double vtkImageBrickThresholdConvertThreshold(double threshold)
+{
+  if (threshold < static_cast<double>(std::numeric_limits<T>::lowest()))
+    {
+    return static_cast<double>(std::numeric_limits<T>::lowest());
+    }
+  if (threshold > static_cast<double>(std::numeric_limits<T>::max()))
+    {
+    return static_cast<double>(std::numeric_limits<T>::max());
+    }
+  return static_cast<double>(static_cast<T>(threshold));
+}
+
+//----------------------------------------------------------------------------
+/// Threshold voxels of the listed bricks into the mask
+template <class T>
+void vtkImageBrickThresholdUpdateMask(vtkImageData* image, const int brickDimensions[3], int brickSize,
+  const std::vector<vtkIdType>& bricks, const std::vector<unsigned char>& brickFillValues,
+  double lowerThreshold, double upperThreshold, unsigned char* mask)
+{
+  int dimensions[3] = { 0, 0, 0 };
+  image->GetDimensions(dimensions);
+  vtkIdType increments[3] = { 0, 0, 0 };
+  image->GetIncrements(increments);
+  const T* basePtr = static_cast<const T*>(image->GetScalarPointer());
+  const T lower = static_cast<T>(lowerThreshold);
+  const T upper = static_cast<T>(upperThreshold);
+  vtkSMPTools::For(0, static_cast<vtkIdType>(bricks.size()), [&](vtkIdType first, vtkIdType last)
+    {
+    for (vtkIdType listIndex = first; listIndex < last; ++listIndex)
+      {
+      int voxelExtent[6] = { 0, -1, 0, -1, 0, -1 };
+      GetBrickVoxelExtent(bricks[listIndex], brickDimensions, brickSize, dimensions, voxelExtent);
+      const int rowLength = voxelExtent[1] - voxelExtent[0] + 1;
+      const unsigned char fillValue = brickFillValues[listIndex];
+      for (int k = voxelExtent[4]; k <= voxelExtent[5]; ++k)
+        {
+        for (int j = voxelExtent[2]; j <= voxelExtent[3]; ++j)
+          {
+          unsigned char* maskRow = mask + (k * static_cast<vtkIdType>(dimensions[1]) + j) * dimensions[0] + voxelExtent[0];
+          if (fillValue <= 1)
+            {
+            // Brick is completely inside or outside the threshold range
+            memset(maskRow, fillValue, rowLength);
+            continue;
+            }
+          const T* voxelPtr = basePtr + k * increments[2] + j * increments[1] + voxelExtent[0] * increments[0];
+          for (int i = 0; i < rowLength; ++i, voxelPtr += increments[0])
+            {
+            maskRow[i] = (lower <= *voxelPtr && *voxelPtr <= upper ? 1 : 0);
+            }
+          }
+        }
+      }
+    });
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkImageBrickThreshold);
+
+//----------------------------------------------------------------------------
+vtkImageBrickThreshold::vtkImageBrickThreshold() = default;
+
+//----------------------------------------------------------------------------
+vtkImageBrickThreshold::~vtkImageBrickThreshold()
+{
+  this->SetInputImage(nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageBrickThreshold::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "InputImage: " << this->InputImage << "\n";
+  os << indent << "BrickSize: " << this->BrickSize << "\n";
+  os << indent << "CropOutput: " << (this->CropOutput ? "true" : "false") << "\n";
+  os << indent << "NumberOfUpdatedBricks: " << this->NumberOfUpdatedBricks << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkImageBrickThreshold::ClearCache()
+{
+  this->BrickMinimums.clear();
+  this->BrickMaximums.clear();
+  this->BrickContainsNaN.clear();
+  this->BricksImage = nullptr;
+  this->BricksTime = 0;
+  this->Mask.clear();
+  this->Mask.shrink_to_fit();
+  this->MaskValid = false;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkImageBrickThreshold::GetNumberOfBricks()
+{
+  return static_cast<vtkIdType>(this->BrickMinimums.size());
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageBrickThreshold::UpdateBricks()
+{
+  if (!this->InputImage || !this->InputImage->GetPointData() || !this->InputImage->GetPointData()->GetScalars())
+    {
+    vtkErrorMacro("UpdateBricks: invalid input image");
+    return false;
+    }
+  vtkMTimeType imageTime = std::max(this->InputImage->GetMTime(), this->InputImage->GetPointData()->GetScalars()->GetMTime());
+  if (this->InputImage == this->BricksImage && imageTime == this->BricksTime && this->BrickSize == this->BricksBrickSize)
+    {
+    // up-to-date
+    return true;
+    }
+
+  int dimensions[3] = { 0, 0, 0 };
+  this->InputImage->GetDimensions(dimensions);
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    this->BrickDimensions[axis] = (dimensions[axis] + this->BrickSize - 1) / this->BrickSize;
+    }
+  const vtkIdType numberOfBricks = static_cast<vtkIdType>(this->BrickDimensions[0])
+    * this->BrickDimensions[1] * this->BrickDimensions[2];
+  this->BrickMinimums.resize(numberOfBricks);
+  this->BrickMaximums.resize(numberOfBricks);
+  this->BrickContainsNaN.resize(numberOfBricks);
+  if (numberOfBricks > 0)
+    {
+    switch (this->InputImage->GetScalarType())
+      {
+      vtkTemplateMacro(vtkImageBrickThresholdComputeBricks<VTK_TT>(this->InputImage, this->BrickDimensions, this->BrickSize,
+        this->BrickMinimums.data(), this->BrickMaximums.data(), this->BrickContainsNaN.data()));
+      default:
+        vtkErrorMacro("UpdateBricks: unsupported input image scalar type");
+        return false;
+      }
+    }
+  this->BricksImage = this->InputImage;
+  this->BricksTime = imageTime;
+  this->BricksBrickSize = this->BrickSize;
+  // Mask has to be fully recomputed
+  this->MaskValid = false;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageBrickThreshold::Execute(double lowerThreshold, double upperThreshold, vtkOrientedImageData* output)
+{
+  this->NumberOfUpdatedBricks = 0;
+  if (!output)
+    {
+    vtkErrorMacro("Execute: invalid output");
+    return false;
+    }
+  if (!this->UpdateBricks())
+    {
+    return false;
+    }
+
+  // Convert thresholds to the input scalar type
+  double thresholds[2] = { lowerThreshold, upperThreshold };
+  for (int index = 0; index < 2; ++index)
+    {
+    switch (this->InputImage->GetScalarType())
+      {
+      vtkTemplateMacro(thresholds[index] = vtkImageBrickThresholdConvertThreshold<VTK_TT>(thresholds[index]));
+      }
+    }
+
+  // Collect bricks whose mask may change. If the mask is valid, then a voxel may only change
+  // if its value is between the previous and current lower or upper threshold.
+  int dimensions[3] = { 0, 0, 0 };
+  this->InputImage->GetDimensions(dimensions);
+  const vtkIdType numberOfVoxels = static_cast<vtkIdType>(dimensions[0]) * dimensions[1] * dimensions[2];
+  if (static_cast<vtkIdType>(this->Mask.size()) != numberOfVoxels)
+    {
+    this->Mask.resize(numberOfVoxels);
+    this->MaskValid = false;
+    }
+  const bool changedRangeValid[2] =
+    {
+    !this->MaskValid || this->MaskThresholds[0] != thresholds[0],
+    !this->MaskValid || this->MaskThresholds[1] != thresholds[1]
+    };
+  const double changedRanges[2][2] =
+    {
+    { std::min(this->MaskThresholds[0], thresholds[0]), std::max(this->MaskThresholds[0], thresholds[0]) },
+    { std::min(this->MaskThresholds[1], thresholds[1]), std::max(this->MaskThresholds[1], thresholds[1]) }
+    };
+  std::vector<vtkIdType> updatedBricks;
+  // Fill value of each updated brick: 0 or 1 if the brick is completely outside or inside the threshold range,
+  // 2 if voxels have to be thresholded one by one
+  std::vector<unsigned char> updatedBrickFillValues;
+  const vtkIdType numberOfBricks = this->GetNumberOfBricks();
+  for (vtkIdType brickIndex = 0; brickIndex < numberOfBricks; ++brickIndex)
+    {
+    const double brickMinimum = this->BrickMinimums[brickIndex];
+    const double brickMaximum = this->BrickMaximums[brickIndex];
+    if (this->MaskValid)
+      {
+      bool changed = false;
+      for (int index = 0; index < 2; ++index)
+        {
+        changed = changed || (changedRangeValid[index]
+          && brickMinimum <= changedRanges[index][1] && brickMaximum >= changedRanges[index][0]);
+        }
+      if (!changed)
+        {
+        continue;
+        }
+      }
+    unsigned char fillValue = 2;
+    if (brickMaximum < thresholds[0] || brickMinimum > thresholds[1])
+      {
+      fillValue = 0;
+      }
+    else if (brickMinimum >= thresholds[0] && brickMaximum <= thresholds[1] && !this->BrickContainsNaN[brickIndex])
+      {
+      fillValue = 1;
+      }
+    updatedBricks.push_back(brickIndex);
+    updatedBrickFillValues.push_back(fillValue);
+    }
+
+  if (!updatedBricks.empty())
+    {
+    switch (this->InputImage->GetScalarType())
+      {
+      vtkTemplateMacro(vtkImageBrickThresholdUpdateMask<VTK_TT>(this->InputImage, this->BrickDimensions, this->BrickSize,
+        updatedBricks, updatedBrickFillValues, thresholds[0], thresholds[1], this->Mask.data()));
+      }
+    }
+  this->NumberOfUpdatedBricks = static_cast<vtkIdType>(updatedBricks.size());
+  this->MaskThresholds[0] = thresholds[0];
+  this->MaskThresholds[1] = thresholds[1];
+  this->MaskValid = true;
+
+  // Output extent (relative to the first voxel of the input image)
+  int outputVoxelExtent[6] = { 0, dimensions[0] - 1, 0, dimensions[1] - 1, 0, dimensions[2] - 1 };
+  if (this->CropOutput)
+    {
+    int croppedVoxelExtent[6] = { VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN };
+    for (vtkIdType brickIndex = 0; brickIndex < numberOfBricks; ++brickIndex)
+      {
+      if (this->BrickMaximums[brickIndex] < thresholds[0] || this->BrickMinimums[brickIndex] > thresholds[1])
+        {
+        // no voxels in the threshold range
+        continue;
+        }
+      int brickVoxelExtent[6] = { 0, -1, 0, -1, 0, -1 };
+      GetBrickVoxelExtent(brickIndex, this->BrickDimensions, this->BrickSize, dimensions, brickVoxelExtent);
+      for (int axis = 0; axis < 3; ++axis)
+        {
+        croppedVoxelExtent[axis * 2] = std::min(croppedVoxelExtent[axis * 2], brickVoxelExtent[axis * 2]);
+        croppedVoxelExtent[axis * 2 + 1] = std::max(croppedVoxelExtent[axis * 2 + 1], brickVoxelExtent[axis * 2 + 1]);
+        }
+      }
+    std::copy(croppedVoxelExtent, croppedVoxelExtent + 6, outputVoxelExtent);
+    }
+
+  output->Initialize();
+  output->SetOrigin(this->InputImage->GetOrigin());
+  output->SetSpacing(this->InputImage->GetSpacing());
+  if (vtkOrientedImageData::SafeDownCast(this->InputImage))
+    {
+    output->CopyDirections(this->InputImage);
+    }
+  else
+    {
+    output->SetDirections(1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0);
+    }
+  int* inputExtent = this->InputImage->GetExtent();
+  if (outputVoxelExtent[0] > outputVoxelExtent[1])
+    {
+    // No voxels in the threshold range
+    output->SetExtent(0, -1, 0, -1, 0, -1);
+    output->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    return true;
+    }
+  output->SetExtent(
+    inputExtent[0] + outputVoxelExtent[0], inputExtent[0] + outputVoxelExtent[1],
+    inputExtent[2] + outputVoxelExtent[2], inputExtent[2] + outputVoxelExtent[3],
+    inputExtent[4] + outputVoxelExtent[4], inputExtent[4] + outputVoxelExtent[5]);
+  output->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+
+  // Copy the mask to the output
+  const int rowLength = outputVoxelExtent[1] - outputVoxelExtent[0] + 1;
+  const int numberOfRows = outputVoxelExtent[3] - outputVoxelExtent[2] + 1;
+  unsigned char* outputPtr = static_cast<unsigned char*>(output->GetScalarPointer());
+  const unsigned char* mask = this->Mask.data();
+  vtkSMPTools::For(outputVoxelExtent[4], outputVoxelExtent[5] + 1, [&](vtkIdType firstSlice, vtkIdType lastSlice)
+    {
+    for (vtkIdType k = firstSlice; k < lastSlice; ++k)
+      {
+      for (int j = outputVoxelExtent[2]; j <= outputVoxelExtent[3]; ++j)
+        {
+        memcpy(outputPtr + ((k - outputVoxelExtent[4]) * numberOfRows + (j - outputVoxelExtent[2])) * static_cast<vtkIdType>(rowLength),
+          mask + (k * dimensions[1] + j) * static_cast<vtkIdType>(dimensions[0]) + outputVoxelExtent[0], rowLength);
+        }
+      }
+    });
+  return true;
+}
@@ -0,0 +1,117 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef vtkImageBrickThreshold_h
+#define vtkImageBrickThreshold_h
+
+#include "vtkSlicerSegmentationsModuleLogicExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <vector>
+
+class vtkImageData;
+class vtkOrientedImageData;
+
+/// \brief Threshold an image repeatedly with different threshold ranges.
+///
+/// The input image is divided into bricks (small blocks of voxels) and the minimum and maximum
+/// voxel value of each brick is computed. Bricks that are completely inside or outside the
+/// threshold range are filled without visiting their voxels. The brick table is kept until the
+/// input image is modified.
+///
+/// The thresholded mask is kept between executions. When the threshold range is changed,
+/// only those bricks are updated that contain values between the previous and current thresholds,
+/// because classification of all other voxels remains the same.
+///
+/// The result is the same as computed by vtkImageThreshold (in value: 1, out value: 0) on the
+/// first scalar component: thresholds are clamped to the range of the input scalar type and
+/// converted to the input scalar type before comparison.
+class VTK_SLICER_SEGMENTATIONS_LOGIC_EXPORT vtkImageBrickThreshold : public vtkObject
+{
+public:
+  static vtkImageBrickThreshold* New();
+  vtkTypeMacro(vtkImageBrickThreshold, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Image to threshold
+  vtkSetObjectMacro(InputImage, vtkImageData);
+  vtkGetObjectMacro(InputImage, vtkImageData);
+
+  /// Number of voxels along each axis of a brick. Default is 8.
+  vtkSetClampMacro(BrickSize, int, 2, 64);
+  vtkGetMacro(BrickSize, int);
+
+  /// If enabled (default) then the output extent is restricted to the bricks that
+  /// may contain voxels within the threshold range. If disabled then the output has
+  /// the same extent as the input image.
+  vtkSetMacro(CropOutput, bool);
+  vtkGetMacro(CropOutput, bool);
+  vtkBooleanMacro(CropOutput, bool);
+
+  /// Compute binary labelmap (unsigned char, 1: lowerThreshold <= value <= upperThreshold, 0: other voxels).
+  /// Geometry of the output is the same as the input image.
+  /// \return False if the inputs are invalid.
+  bool Execute(double lowerThreshold, double upperThreshold, vtkOrientedImageData* output);
+
+  /// Remove the cached brick table and mask
+  void ClearCache();
+
+  /// Number of bricks in the input image
+  vtkIdType GetNumberOfBricks();
+
+  /// Number of bricks whose mask was updated in the last execution
+  vtkGetMacro(NumberOfUpdatedBricks, vtkIdType);
+
+protected:
+  vtkImageBrickThreshold();
+  ~vtkImageBrickThreshold() override;
+
+  /// Update minimum and maximum value of each brick if the input image has changed since the last update.
+  bool UpdateBricks();
+
+  vtkImageData* InputImage{ nullptr };
+  int BrickSize{ 8 };
+  bool CropOutput{ true };
+  vtkIdType NumberOfUpdatedBricks{ 0 };
+
+  /// Number of bricks along each axis
+  int BrickDimensions[3]{ 0, 0, 0 };
+  /// Minimum and maximum value in each brick (NaN values are ignored)
+  std::vector<double> BrickMinimums;
+  std::vector<double> BrickMaximums;
+  /// Non-zero for bricks that contain NaN. These bricks are never completely inside the threshold range.
+  std::vector<unsigned char> BrickContainsNaN;
+  /// Input image and time that the brick table was computed for
+  vtkImageData* BricksImage{ nullptr };
+  vtkMTimeType BricksTime{ 0 };
+  int BricksBrickSize{ 0 };
+
+  /// Thresholded input image, stored in x-fastest order, in the extent of the input image
+  std::vector<unsigned char> Mask;
+  bool MaskValid{ false };
+  /// Thresholds that Mask was computed with (converted to the input scalar type)
+  double MaskThresholds[2]{ 0.0, 0.0 };
+
+private:
+  vtkImageBrickThreshold(const vtkImageBrickThreshold&) = delete;
+  void operator=(const vtkImageBrickThreshold&) = delete;
+};
+
+#endif
@@ -0,0 +1,470 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkImageBrushStrokeRasterizer.h"
+
+// vtkSegmentationCore includes
+#include "vtkOrientedImageData.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkLine.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Brush swept along a line segment from Start to Start+Direction.
+/// All positions and vectors are in world coordinates.
+struct BrushSegment
+{
+  double Start[3]{ 0.0, 0.0, 0.0 };
+  /// Component of the segment direction that is orthogonal to the brush axis
+  double RadialDirection[3]{ 0.0, 0.0, 0.0 };
+  double RadialDirectionSquaredNorm{ 0.0 };
+  /// Component of the segment direction along the brush axis
+  double AxialDirection{ 0.0 };
+  /// Voxels that may be inside the swept brush
+  int Extent[6]{ 0, -1, 0, -1, 0, -1 };
+};
+
+//----------------------------------------------------------------------------
+/// Settings shared by all segments of a stroke.
+struct BrushStroke
+{
+  /// Unit vector for cylinder, zero vector for sphere
+  double Axis[3]{ 0.0, 0.0, 0.0 };
+  double HalfHeight{ VTK_DOUBLE_MAX };
+  double SquaredRadius{ 0.0 };
+  std::vector<BrushSegment> Segments;
+
+  /// Returns true if the position is inside the brush swept along the segment.
+  /// The swept brush contains a point if for some t in [0, 1] the point is inside
+  /// the brush that is centered at Start + t * Direction. The axial distance constrains t to
+  /// an interval and the radial distance is a convex quadratic function of t,
+  /// therefore it is enough to check the radial distance at the clamped minimum.
+  bool IsInside(const BrushSegment& segment, const double position[3]) const
+    {
+    double offset[3] =
+      {
+      position[0] - segment.Start[0],
+      position[1] - segment.Start[1],
+      position[2] - segment.Start[2]
+      };
+    double axialOffset = vtkMath::Dot(offset, this->Axis);
+    double tMin = 0.0;
+    double tMax = 1.0;
+    if (std::abs(segment.AxialDirection) > 1e-12)
+      {
+      double t1 = (axialOffset - this->HalfHeight) / segment.AxialDirection;
+      double t2 = (axialOffset + this->HalfHeight) / segment.AxialDirection;
+      tMin = std::max(tMin, std::min(t1, t2));
+      tMax = std::min(tMax, std::max(t1, t2));
+      if (tMin > tMax)
+        {
+        return false;
+        }
+      }
+    else if (std::abs(axialOffset) > this->HalfHeight)
+      {
+      return false;
+      }
+    double radialOffset[3] =
+      {
+      offset[0] - axialOffset * this->Axis[0],
+      offset[1] - axialOffset * this->Axis[1],
+      offset[2] - axialOffset * this->Axis[2]
+      };
+    double t = tMin;
+    if (segment.RadialDirectionSquaredNorm > 0.0)
+      {
+      t = vtkMath::Dot(radialOffset, segment.RadialDirection) / segment.RadialDirectionSquaredNorm;
+      t = std::min(std::max(t, tMin), tMax);
+      }
+    double distance[3] =
+      {
+      radialOffset[0] - t * segment.RadialDirection[0],
+      radialOffset[1] - t * segment.RadialDirection[1],
+      radialOffset[2] - t * segment.RadialDirection[2]
+      };
+    return vtkMath::Dot(distance, distance) <= this->SquaredRadius;
+    }
+};
+
+//----------------------------------------------------------------------------
+/// Painted voxel range of an image row
+struct RowRange
+{
+  int Min{ VTK_INT_MAX };
+  int Max{ VTK_INT_MIN };
+};
+
+//----------------------------------------------------------------------------
+template <class T>
+class PaintRowsFunctor
+{
+public:
+  PaintRowsFunctor(vtkImageData* image, const BrushStroke& stroke, vtkMatrix4x4* imageToWorld,
+    const int extent[6], T fillValue, std::vector<RowRange>& rowRanges)
+    : Image(image)
+    , Stroke(stroke)
+    , ImageToWorld(imageToWorld)
+    , FillValue(fillValue)
+    , RowRanges(rowRanges)
+    {
+    std::copy(extent, extent + 6, this->Extent);
+    this->NumberOfComponents = image->GetNumberOfScalarComponents();
+    }
+
+  void operator()(vtkIdType beginRow, vtkIdType endRow) const
+    {
+    int rowsPerSlice = this->Extent[3] - this->Extent[2] + 1;
+    double step[3] =
+      {
+      this->ImageToWorld->GetElement(0, 0),
+      this->ImageToWorld->GetElement(1, 0),
+      this->ImageToWorld->GetElement(2, 0)
+      };
+    for (vtkIdType row = beginRow; row < endRow; ++row)
+      {
+      int j = this->Extent[2] + static_cast<int>(row % rowsPerSlice);
+      int k = this->Extent[4] + static_cast<int>(row / rowsPerSlice);
+      RowRange& rowRange = this->RowRanges[row];
+      for (const BrushSegment& segment : this->Stroke.Segments)
+        {
+        if (j < segment.Extent[2] || j > segment.Extent[3] || k < segment.Extent[4] || k > segment.Extent[5])
+          {
+          continue;
+          }
+        double ijk[4] = { static_cast<double>(segment.Extent[0]), static_cast<double>(j), static_cast<double>(k), 1.0 };
+        double position[4] = { 0.0, 0.0, 0.0, 1.0 };
+        this->ImageToWorld->MultiplyPoint(ijk, position);
+        T* voxelPtr = static_cast<T*>(this->Image->GetScalarPointer(segment.Extent[0], j, k));
+        bool insideFound = false;
+        for (int i = segment.Extent[0]; i <= segment.Extent[1]; ++i)
+          {
+          if (this->Stroke.IsInside(segment, position))
+            {
+            *voxelPtr = this->FillValue;
+            rowRange.Min = std::min(rowRange.Min, i);
+            rowRange.Max = std::max(rowRange.Max, i);
+            insideFound = true;
+            }
+          else if (insideFound)
+            {
+            // The swept brush is convex, therefore the rest of the row is outside
+            break;
+            }
+          position[0] += step[0];
+          position[1] += step[1];
+          position[2] += step[2];
+          voxelPtr += this->NumberOfComponents;
+          }
+        }
+      }
+    }
+
+private:
+  vtkImageData* Image;
+  const BrushStroke& Stroke;
+  vtkMatrix4x4* ImageToWorld;
+  int Extent[6];
+  int NumberOfComponents;
+  T FillValue;
+  std::vector<RowRange>& RowRanges;
+};
+
+//----------------------------------------------------------------------------
+template <class T>
+void PaintRows(vtkImageData* image, const BrushStroke& stroke, vtkMatrix4x4* imageToWorld,
+  const int extent[6], double fillValue, std::vector<RowRange>& rowRanges)
+{
+  PaintRowsFunctor<T> functor(image, stroke, imageToWorld, extent, static_cast<T>(fillValue), rowRanges);
+  vtkSMPTools::For(0, static_cast<vtkIdType>(rowRanges.size()), functor);
+}
+
+//----------------------------------------------------------------------------
+double SquaredDistanceToSegment(const double point[3], const double start[3], const double end[3])
+{
+  double t = 0.0;
+  double closestPoint[3] = { 0.0, 0.0, 0.0 };
+  return vtkLine::DistanceToLine(point, start, end, t, closestPoint);
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkImageBrushStrokeRasterizer);
+
+//----------------------------------------------------------------------------
+vtkImageBrushStrokeRasterizer::vtkImageBrushStrokeRasterizer() = default;
+
+//----------------------------------------------------------------------------
+vtkImageBrushStrokeRasterizer::~vtkImageBrushStrokeRasterizer()
+{
+  this->SetWorldToImageMatrix(nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageBrushStrokeRasterizer::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "BrushShape: " << (this->BrushShape == BrushShapeCylinder ? "Cylinder" : "Sphere") << "\n";
+  os << indent << "Radius: " << this->Radius << "\n";
+  os << indent << "Height: " << this->Height << "\n";
+  os << indent << "CylinderAxis: " << this->CylinderAxis[0] << ", "
+    << this->CylinderAxis[1] << ", " << this->CylinderAxis[2] << "\n";
+  os << indent << "FillValue: " << this->FillValue << "\n";
+  os << indent << "WorldToImageMatrix:";
+  if (this->WorldToImageMatrix)
+    {
+    os << "\n";
+    this->WorldToImageMatrix->PrintSelf(os, indent.GetNextIndent());
+    }
+  else
+    {
+    os << " (none)\n";
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageBrushStrokeRasterizer::PaintStroke(vtkImageData* image, vtkPoints* strokePoints_World, int modifiedExtent[6]/*=nullptr*/)
+{
+  if (modifiedExtent)
+    {
+    const int emptyExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    std::copy(emptyExtent, emptyExtent + 6, modifiedExtent);
+    }
+  if (!image || !strokePoints_World)
+    {
+    vtkErrorMacro("PaintStroke failed: invalid input image or stroke points");
+    return false;
+    }
+  if (!image->GetPointData()->GetScalars())
+    {
+    vtkErrorMacro("PaintStroke failed: input image has no scalars");
+    return false;
+    }
+  vtkIdType numberOfPoints = strokePoints_World->GetNumberOfPoints();
+  int* imageExtent = image->GetExtent();
+  if (numberOfPoints == 0 || imageExtent[0] > imageExtent[1] || imageExtent[2] > imageExtent[3] || imageExtent[4] > imageExtent[5])
+    {
+    // nothing to paint
+    return true;
+    }
+
+  vtkNew<vtkMatrix4x4> worldToImage;
+  if (this->WorldToImageMatrix)
+    {
+    worldToImage->DeepCopy(this->WorldToImageMatrix);
+    }
+  else if (vtkOrientedImageData::SafeDownCast(image))
+    {
+    vtkOrientedImageData::SafeDownCast(image)->GetWorldToImageMatrix(worldToImage);
+    }
+  else
+    {
+    double* origin = image->GetOrigin();
+    double* spacing = image->GetSpacing();
+    for (int i = 0; i < 3; ++i)
+      {
+      worldToImage->SetElement(i, i, 1.0 / spacing[i]);
+      worldToImage->SetElement(i, 3, -origin[i] / spacing[i]);
+      }
+    }
+  vtkNew<vtkMatrix4x4> imageToWorld;
+  vtkMatrix4x4::Invert(worldToImage, imageToWorld);
+
+  BrushStroke stroke;
+  stroke.SquaredRadius = this->Radius * this->Radius;
+  // Half size of the brush bounding box along each world axis
+  double brushHalfSize[3] = { this->Radius, this->Radius, this->Radius };
+  if (this->BrushShape == BrushShapeCylinder)
+    {
+    std::copy(this->CylinderAxis, this->CylinderAxis + 3, stroke.Axis);
+    if (vtkMath::Normalize(stroke.Axis) == 0.0)
+      {
+      vtkErrorMacro("PaintStroke failed: invalid cylinder axis");
+      return false;
+      }
+    stroke.HalfHeight = this->Height / 2.0;
+    for (int i = 0; i < 3; ++i)
+      {
+      brushHalfSize[i] = this->Radius * sqrt(std::max(0.0, 1.0 - stroke.Axis[i] * stroke.Axis[i]))
+        + stroke.HalfHeight * std::abs(stroke.Axis[i]);
+      }
+    }
+
+  // Interpolated stroke points often lie on a straight line. A brush that is swept along
+  // collinear segments is the same as the brush that is swept along the merged segment,
+  // therefore collinear points are skipped to avoid visiting the same voxels multiple times.
+  std::vector<vtkIdType> segmentPointIds;
+  segmentPointIds.push_back(0);
+  const double collinearToleranceSquared = 1e-12 * stroke.SquaredRadius;
+  for (vtkIdType startPointId = 0; startPointId < numberOfPoints - 1; )
+    {
+    double startPoint[3] = { 0.0, 0.0, 0.0 };
+    strokePoints_World->GetPoint(startPointId, startPoint);
+    vtkIdType endPointId = startPointId + 1;
+    while (endPointId + 1 < numberOfPoints)
+      {
+      double candidateEndPoint[3] = { 0.0, 0.0, 0.0 };
+      strokePoints_World->GetPoint(endPointId + 1, candidateEndPoint);
+      bool collinear = true;
+      for (vtkIdType pointId = startPointId + 1; pointId <= endPointId && collinear; ++pointId)
+        {
+        double point[3] = { 0.0, 0.0, 0.0 };
+        strokePoints_World->GetPoint(pointId, point);
+        collinear = (SquaredDistanceToSegment(point, startPoint, candidateEndPoint) <= collinearToleranceSquared);
+        }
+      if (!collinear)
+        {
+        break;
+        }
+      ++endPointId;
+      }
+    segmentPointIds.push_back(endPointId);
+    startPointId = endPointId;
+    }
+  if (segmentPointIds.size() == 1)
+    {
+    // single point, the brush is not swept
+    segmentPointIds.push_back(0);
+    }
+
+  int strokeExtent[6] = { VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN };
+  for (size_t segmentIndex = 0; segmentIndex + 1 < segmentPointIds.size(); ++segmentIndex)
+    {
+    BrushSegment segment;
+    double endPoint[3] = { 0.0, 0.0, 0.0 };
+    strokePoints_World->GetPoint(segmentPointIds[segmentIndex], segment.Start);
+    strokePoints_World->GetPoint(segmentPointIds[segmentIndex + 1], endPoint);
+    double direction[3] = { 0.0, 0.0, 0.0 };
+    vtkMath::Subtract(endPoint, segment.Start, direction);
+    segment.AxialDirection = vtkMath::Dot(direction, stroke.Axis);
+    for (int i = 0; i < 3; ++i)
+      {
+      segment.RadialDirection[i] = direction[i] - segment.AxialDirection * stroke.Axis[i];
+      }
+    segment.RadialDirectionSquaredNorm = vtkMath::Dot(segment.RadialDirection, segment.RadialDirection);
+
+    // Voxel range: IJK bounding box of the corners of the world bounding box, cropped to the image extent
+    double bounds_World[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    for (int i = 0; i < 3; ++i)
+      {
+      bounds_World[2 * i] = std::min(segment.Start[i], endPoint[i]) - brushHalfSize[i];
+      bounds_World[2 * i + 1] = std::max(segment.Start[i], endPoint[i]) + brushHalfSize[i];
+      }
+    double bounds_Ijk[6] = { VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN };
+    for (int cornerIndex = 0; cornerIndex < 8; ++cornerIndex)
+      {
+      double corner_World[4] =
+        {
+        bounds_World[(cornerIndex & 1) ? 1 : 0],
+        bounds_World[(cornerIndex & 2) ? 3 : 2],
+        bounds_World[(cornerIndex & 4) ? 5 : 4],
+        1.0
+        };
+      double corner_Ijk[4] = { 0.0, 0.0, 0.0, 1.0 };
+      worldToImage->MultiplyPoint(corner_World, corner_Ijk);
+      for (int i = 0; i < 3; ++i)
+        {
+        bounds_Ijk[2 * i] = std::min(bounds_Ijk[2 * i], corner_Ijk[i]);
+        bounds_Ijk[2 * i + 1] = std::max(bounds_Ijk[2 * i + 1], corner_Ijk[i]);
+        }
+      }
+    bool emptyExtent = false;
+    for (int i = 0; i < 3; ++i)
+      {
+      // compare as double to avoid integer overflow for points far outside the image
+      double minIndex = std::max(floor(bounds_Ijk[2 * i]), static_cast<double>(imageExtent[2 * i]));
+      double maxIndex = std::min(ceil(bounds_Ijk[2 * i + 1]), static_cast<double>(imageExtent[2 * i + 1]));
+      if (minIndex > maxIndex)
+        {
+        emptyExtent = true;
+        break;
+        }
+      segment.Extent[2 * i] = static_cast<int>(minIndex);
+      segment.Extent[2 * i + 1] = static_cast<int>(maxIndex);
+      }
+    if (emptyExtent)
+      {
+      continue;
+      }
+    for (int i = 0; i < 3; ++i)
+      {
+      strokeExtent[2 * i] = std::min(strokeExtent[2 * i], segment.Extent[2 * i]);
+      strokeExtent[2 * i + 1] = std::max(strokeExtent[2 * i + 1], segment.Extent[2 * i + 1]);
+      }
+    stroke.Segments.push_back(segment);
+    }
+  if (stroke.Segments.empty())
+    {
+    // stroke is outside of the image
+    return true;
+    }
+
+  vtkIdType numberOfRows = static_cast<vtkIdType>(strokeExtent[3] - strokeExtent[2] + 1)
+    * static_cast<vtkIdType>(strokeExtent[5] - strokeExtent[4] + 1);
+  std::vector<RowRange> rowRanges(numberOfRows);
+  switch (image->GetScalarType())
+    {
+    vtkTemplateMacro(PaintRows<VTK_TT>(image, stroke, imageToWorld, strokeExtent, this->FillValue, rowRanges));
+    default:
+      vtkErrorMacro("PaintStroke failed: unsupported image scalar type " << image->GetScalarType());
+      return false;
+    }
+  image->Modified();
+
+  if (modifiedExtent)
+    {
+    int rowsPerSlice = strokeExtent[3] - strokeExtent[2] + 1;
+    int paintedExtent[6] = { VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN };
+    for (vtkIdType row = 0; row < numberOfRows; ++row)
+      {
+      if (rowRanges[row].Min > rowRanges[row].Max)
+        {
+        continue;
+        }
+      int j = strokeExtent[2] + static_cast<int>(row % rowsPerSlice);
+      int k = strokeExtent[4] + static_cast<int>(row / rowsPerSlice);
+      paintedExtent[0] = std::min(paintedExtent[0], rowRanges[row].Min);
+      paintedExtent[1] = std::max(paintedExtent[1], rowRanges[row].Max);
+      paintedExtent[2] = std::min(paintedExtent[2], j);
+      paintedExtent[3] = std::max(paintedExtent[3], j);
+      paintedExtent[4] = std::min(paintedExtent[4], k);
+      paintedExtent[5] = std::max(paintedExtent[5], k);
+      }
+    if (paintedExtent[0] <= paintedExtent[1])
+      {
+      std::copy(paintedExtent, paintedExtent + 6, modifiedExtent);
+      }
+    }
+  return true;
+}
@@ -0,0 +1,107 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef vtkImageBrushStrokeRasterizer_h
+#define vtkImageBrushStrokeRasterizer_h
+
+#include "vtkSlicerSegmentationsModuleLogicExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+class vtkImageData;
+class vtkMatrix4x4;
+class vtkPoints;
+
+/// \brief Paint a brush stroke directly into the voxels of an image.
+///
+/// The brush is swept along each segment of the stroke polyline: with a sphere brush
+/// the painted region is a union of capsules, with a cylinder brush it is a union of
+/// cylinders extruded along the segments. A voxel is painted if its center is inside
+/// the swept brush. Brush size, cylinder axis, and stroke points are specified in world
+/// coordinates, therefore anisotropic spacing and oriented images are supported.
+///
+/// Only the image region that the stroke may touch is visited. Image rows are processed
+/// in parallel, using multiple threads.
+class VTK_SLICER_SEGMENTATIONS_LOGIC_EXPORT vtkImageBrushStrokeRasterizer : public vtkObject
+{
+public:
+  static vtkImageBrushStrokeRasterizer* New();
+  vtkTypeMacro(vtkImageBrushStrokeRasterizer, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  enum
+    {
+    BrushShapeSphere,
+    BrushShapeCylinder,
+    BrushShape_Last // must be last
+    };
+
+  /// Shape of the brush. Default is sphere.
+  vtkSetClampMacro(BrushShape, int, BrushShapeSphere, BrushShape_Last - 1);
+  vtkGetMacro(BrushShape, int);
+  void SetBrushShapeToSphere() { this->SetBrushShape(BrushShapeSphere); }
+  void SetBrushShapeToCylinder() { this->SetBrushShape(BrushShapeCylinder); }
+
+  /// Radius of the sphere or cylinder, in world coordinate system units.
+  vtkSetMacro(Radius, double);
+  vtkGetMacro(Radius, double);
+
+  /// Height of the cylinder, in world coordinate system units. Not used for sphere brush.
+  vtkSetMacro(Height, double);
+  vtkGetMacro(Height, double);
+
+  /// Direction of the axis of the cylinder in world coordinate system. It does not have to be normalized.
+  /// Not used for sphere brush.
+  vtkSetVector3Macro(CylinderAxis, double);
+  vtkGetVector3Macro(CylinderAxis, double);
+
+  /// Value that is written into voxels that are inside the brush.
+  vtkSetMacro(FillValue, double);
+  vtkGetMacro(FillValue, double);
+
+  /// Transform from world coordinate system to the IJK coordinate system of the image.
+  /// If not set then the geometry of the image is used (directions are taken into account
+  /// if the image is a vtkOrientedImageData).
+  vtkSetObjectMacro(WorldToImageMatrix, vtkMatrix4x4);
+  vtkGetObjectMacro(WorldToImageMatrix, vtkMatrix4x4);
+
+  /// Paint the stroke into the image.
+  /// \param image Image that is modified in place. Only the first scalar component is written.
+  /// \param strokePoints_World Points of the stroke polyline. A single point paints a single brush.
+  /// \param modifiedExtent Optional output, bounding box of the painted voxels.
+  ///   It is an empty extent (0, -1, 0, -1, 0, -1) if no voxels were painted.
+  /// \return False if the inputs are invalid.
+  bool PaintStroke(vtkImageData* image, vtkPoints* strokePoints_World, int modifiedExtent[6] = nullptr);
+
+protected:
+  vtkImageBrushStrokeRasterizer();
+  ~vtkImageBrushStrokeRasterizer() override;
+
+  int BrushShape{ BrushShapeSphere };
+  double Radius{ 1.0 };
+  double Height{ 1.0 };
+  double CylinderAxis[3]{ 0.0, 0.0, 1.0 };
+  double FillValue{ 1.0 };
+  vtkMatrix4x4* WorldToImageMatrix{ nullptr };
+
+private:
+  vtkImageBrushStrokeRasterizer(const vtkImageBrushStrokeRasterizer&) = delete;
+  void operator=(const vtkImageBrushStrokeRasterizer&) = delete;
+};
+
+#endif
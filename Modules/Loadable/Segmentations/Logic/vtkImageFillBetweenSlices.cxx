@@ -0,0 +1,637 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkImageFillBetweenSlices.h"
+#include "SquaredDistanceTransform.h"
+
+// vtkSegmentationCore includes
+#include "vtkOrientedImageData.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+/// Interpolation result between two annotated slices of a label
+struct vtkImageFillBetweenSlicesGap
+{
+  int Axis{ 2 };
+  int Slices[2]{ 0, 0 };
+  vtkTypeUInt64 SliceHashes[2]{ 0, 0 };
+  /// In-plane bounding box (first axis min, max, second axis min, max) of the label in the annotated slices
+  int PlaneExtent[4]{ 0, -1, 0, -1 };
+  /// Filled voxels of the intermediate slices within the plane extent
+  std::vector<unsigned char> Mask;
+};
+
+namespace
+{
+
+/// Number of slabs per thread that the labelmap is split into when slices are summarized
+const int SLABS_PER_THREAD = 4;
+
+//----------------------------------------------------------------------------
+/// Get the two in-plane axes of slices that are orthogonal to the specified axis
+void GetPlaneAxes(int axis, int& uAxis, int& vAxis)
+{
+  uAxis = (axis == 0 ? 1 : 0);
+  vAxis = (axis == 2 ? 1 : 2);
+}
+
+//----------------------------------------------------------------------------
+/// Hash of a run of voxels (splitmix64 finalizer). Hashes of the runs in a slice are summed,
+/// therefore the slice hash does not depend on the order in which the runs are visited.
+vtkTypeUInt64 HashRun(int a, int b, int c)
+{
+  vtkTypeUInt64 x = static_cast<vtkTypeUInt64>(a)
+    | (static_cast<vtkTypeUInt64>(b) << 21)
+    | (static_cast<vtkTypeUInt64>(c) << 42);
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+//----------------------------------------------------------------------------
+/// Content summary of a label in a slice
+struct SliceSummary
+{
+  vtkTypeUInt64 Hash{ 0 };
+  vtkIdType NumberOfVoxels{ 0 };
+  int PlaneExtent[4]{ VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN };
+
+  void AddVoxels(vtkTypeUInt64 hash, vtkIdType numberOfVoxels, int u0, int u1, int v0, int v1)
+  {
+    this->Hash += hash;
+    this->NumberOfVoxels += numberOfVoxels;
+    this->PlaneExtent[0] = std::min(this->PlaneExtent[0], u0);
+    this->PlaneExtent[1] = std::max(this->PlaneExtent[1], u1);
+    this->PlaneExtent[2] = std::min(this->PlaneExtent[2], v0);
+    this->PlaneExtent[3] = std::max(this->PlaneExtent[3], v1);
+  }
+
+  void Add(const SliceSummary& other)
+  {
+    if (other.NumberOfVoxels > 0)
+      {
+      this->AddVoxels(other.Hash, other.NumberOfVoxels,
+        other.PlaneExtent[0], other.PlaneExtent[1], other.PlaneExtent[2], other.PlaneExtent[3]);
+      }
+  }
+};
+
+/// Content summary of all slices of a label along each axis
+struct LabelSummary
+{
+  std::vector<SliceSummary> Slices[3];
+};
+
+typedef std::map<int, LabelSummary> LabelSummaryMap;
+
+//----------------------------------------------------------------------------
+/// Compute content summary of each label in each slice, along all three axes, in a single pass.
+/// Slabs of the labelmap are processed in parallel. Runs of voxels with the same label value
+/// are handled at once to minimize the number of map lookups.
+template <class T>
+void vtkImageFillBetweenSlicesSummarizeSlices(vtkImageData* labelmap, LabelSummaryMap& labelSummaries)
+{
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  labelmap->GetExtent(extent);
+  const int dimensions[3] = { extent[1] - extent[0] + 1, extent[3] - extent[2] + 1, extent[5] - extent[4] + 1 };
+  vtkIdType increments[3] = { 0, 0, 0 };
+  labelmap->GetIncrements(increments);
+  const T* basePtr = static_cast<const T*>(labelmap->GetScalarPointerForExtent(extent));
+
+  const int numberOfSlabs = std::max(1, std::min(dimensions[2], SLABS_PER_THREAD * vtkSMPTools::GetEstimatedNumberOfThreads()));
+  std::vector<LabelSummaryMap> slabLabelSummaries(numberOfSlabs);
+  vtkSMPTools::For(0, numberOfSlabs, 1, [&](vtkIdType firstSlab, vtkIdType lastSlab)
+    {
+    for (vtkIdType slab = firstSlab; slab < lastSlab; ++slab)
+      {
+      LabelSummaryMap& summaries = slabLabelSummaries[slab];
+      LabelSummary* summary = nullptr;
+      int summaryLabelValue = 0;
+      const int firstK = static_cast<int>(slab * dimensions[2] / numberOfSlabs);
+      const int lastK = static_cast<int>((slab + 1) * dimensions[2] / numberOfSlabs);
+      for (int k = firstK; k < lastK; ++k)
+        {
+        for (int j = 0; j < dimensions[1]; ++j)
+          {
+          const T* rowPtr = basePtr + k * increments[2] + j * increments[1];
+          int i = 0;
+          while (i < dimensions[0])
+            {
+            const T value = rowPtr[i * increments[0]];
+            const int runStart = i;
+            while (i + 1 < dimensions[0] && rowPtr[(i + 1) * increments[0]] == value)
+              {
+              ++i;
+              }
+            const int runEnd = i;
+            ++i;
+            if (value == 0)
+              {
+              continue;
+              }
+            const int labelValue = static_cast<int>(value);
+            if (!summary || labelValue != summaryLabelValue)
+              {
+              LabelSummaryMap::iterator summaryIt = summaries.find(labelValue);
+              if (summaryIt == summaries.end())
+                {
+                summaryIt = summaries.insert(std::make_pair(labelValue, LabelSummary())).first;
+                for (int axis = 0; axis < 3; ++axis)
+                  {
+                  summaryIt->second.Slices[axis].resize(dimensions[axis]);
+                  }
+                }
+              summary = &summaryIt->second;
+              summaryLabelValue = labelValue;
+              }
+            const vtkIdType runLength = runEnd - runStart + 1;
+            summary->Slices[2][k].AddVoxels(HashRun(runStart, runEnd, j), runLength, runStart, runEnd, j, j);
+            summary->Slices[1][j].AddVoxels(HashRun(runStart, runEnd, k), runLength, runStart, runEnd, k, k);
+            const vtkTypeUInt64 voxelHash = HashRun(j, k, 0);
+            for (int runI = runStart; runI <= runEnd; ++runI)
+              {
+              summary->Slices[0][runI].AddVoxels(voxelHash, 1, j, j, k, k);
+              }
+            }
+          }
+        }
+      }
+    });
+
+  labelSummaries.clear();
+  for (LabelSummaryMap& summaries : slabLabelSummaries)
+    {
+    for (auto& summaryItem : summaries)
+      {
+      LabelSummaryMap::iterator summaryIt = labelSummaries.find(summaryItem.first);
+      if (summaryIt == labelSummaries.end())
+        {
+        labelSummaries.insert(std::make_pair(summaryItem.first, std::move(summaryItem.second)));
+        continue;
+        }
+      for (int axis = 0; axis < 3; ++axis)
+        {
+        std::vector<SliceSummary>& slices = summaryIt->second.Slices[axis];
+        const std::vector<SliceSummary>& slabSlices = summaryItem.second.Slices[axis];
+        for (size_t slice = 0; slice < slices.size(); ++slice)
+          {
+          slices[slice].Add(slabSlices[slice]);
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Get number of gaps between annotated slices along an axis
+int GetNumberOfGaps(const std::vector<SliceSummary>& slices)
+{
+  int numberOfGaps = 0;
+  int previousSlice = -1;
+  for (int slice = 0; slice < static_cast<int>(slices.size()); ++slice)
+    {
+    if (slices[slice].NumberOfVoxels == 0)
+      {
+      continue;
+      }
+    if (previousSlice >= 0 && slice - previousSlice > 1)
+      {
+      ++numberOfGaps;
+      }
+    previousSlice = slice;
+    }
+  return numberOfGaps;
+}
+
+//----------------------------------------------------------------------------
+/// Compute squared distance map of a 2D image (x-fastest order) in place
+void ComputeSquaredDistances2D(float* values, const int dimensions[2], const double spacing[2],
+  SquaredDistanceTransform1D& transform)
+{
+  for (int v = 0; v < dimensions[1]; ++v)
+    {
+    transform.Transform(values + static_cast<vtkIdType>(v) * dimensions[0], 1, dimensions[0], spacing[0]);
+    }
+  for (int u = 0; u < dimensions[0]; ++u)
+    {
+    transform.Transform(values + u, dimensions[0], dimensions[1], spacing[1]);
+    }
+}
+
+/// Labelmap geometry and working buffers used during interpolation
+struct vtkImageFillBetweenSlicesContext
+{
+  int Dimensions[3]{ 0, 0, 0 };
+  vtkIdType Increments[3]{ 0, 0, 0 };
+  double Spacing[3]{ 1.0, 1.0, 1.0 };
+
+  /// Get offset of a voxel from the first voxel of the labelmap
+  vtkIdType GetOffset(int axis, int slice, int uAxis, int u, int vAxis, int v) const
+  {
+    return slice * this->Increments[axis] + u * this->Increments[uAxis] + v * this->Increments[vAxis];
+  }
+};
+
+//----------------------------------------------------------------------------
+template <class T>
+void vtkImageFillBetweenSlicesComputeSignedDistances(const vtkImageFillBetweenSlicesContext& context, const T* labelPtr,
+  int labelValue, const vtkImageFillBetweenSlicesGap* gap, int side, std::vector<float>& signedDistances)
+{
+  int uAxis = 0;
+  int vAxis = 1;
+  GetPlaneAxes(gap->Axis, uAxis, vAxis);
+  const int* planeExtent = gap->PlaneExtent;
+  // The plane extent is padded by one background pixel, therefore the nearest background pixel
+  // of each label pixel is within the padded region.
+  const int paddedDimensions[2] = { planeExtent[1] - planeExtent[0] + 3, planeExtent[3] - planeExtent[2] + 3 };
+  const vtkIdType numberOfPixels = static_cast<vtkIdType>(paddedDimensions[0]) * paddedDimensions[1];
+  const double planeSpacing[2] = { fabs(context.Spacing[uAxis]), fabs(context.Spacing[vAxis]) };
+  // The contour is half pixel away from the center of the boundary pixels
+  const double halfPixel = 0.5 * std::min(planeSpacing[0], planeSpacing[1]);
+
+  std::vector<unsigned char> mask(numberOfPixels, 0);
+  const T foregroundValue = static_cast<T>(labelValue);
+  for (int v = planeExtent[2]; v <= planeExtent[3]; ++v)
+    {
+    unsigned char* maskRow = &mask[static_cast<vtkIdType>(v - planeExtent[2] + 1) * paddedDimensions[0] + 1];
+    for (int u = planeExtent[0]; u <= planeExtent[1]; ++u)
+      {
+      maskRow[u - planeExtent[0]] =
+        (labelPtr[context.GetOffset(gap->Axis, gap->Slices[side], uAxis, u, vAxis, v)] == foregroundValue ? 1 : 0);
+      }
+    }
+
+  SquaredDistanceTransform1D transform;
+  std::vector<float> squaredDistances(numberOfPixels);
+  signedDistances.resize(numberOfPixels);
+  // Distance of background pixels from the label
+  for (vtkIdType pixel = 0; pixel < numberOfPixels; ++pixel)
+    {
+    squaredDistances[pixel] = (mask[pixel] ? 0.0f : SQUARED_DISTANCE_INFINITE);
+    }
+  ComputeSquaredDistances2D(squaredDistances.data(), paddedDimensions, planeSpacing, transform);
+  for (vtkIdType pixel = 0; pixel < numberOfPixels; ++pixel)
+    {
+    if (!mask[pixel])
+      {
+      signedDistances[pixel] = static_cast<float>(sqrt(squaredDistances[pixel]) - halfPixel);
+      }
+    }
+  // Distance of label pixels from the background (negative)
+  for (vtkIdType pixel = 0; pixel < numberOfPixels; ++pixel)
+    {
+    squaredDistances[pixel] = (mask[pixel] ? SQUARED_DISTANCE_INFINITE : 0.0f);
+    }
+  ComputeSquaredDistances2D(squaredDistances.data(), paddedDimensions, planeSpacing, transform);
+  for (vtkIdType pixel = 0; pixel < numberOfPixels; ++pixel)
+    {
+    if (mask[pixel])
+      {
+      signedDistances[pixel] = static_cast<float>(halfPixel - sqrt(squaredDistances[pixel]));
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void vtkImageFillBetweenSlicesInterpolateGaps(const vtkImageFillBetweenSlicesContext& context, const T* labelPtr,
+  const std::vector<std::pair<int, vtkImageFillBetweenSlicesGap*>>& gaps)
+{
+  // Compute signed distance maps of the two annotated slices of each gap
+  const vtkIdType numberOfGaps = static_cast<vtkIdType>(gaps.size());
+  std::vector<std::vector<float>> signedDistances(2 * numberOfGaps);
+  vtkSMPTools::For(0, 2 * numberOfGaps, 1, [&](vtkIdType first, vtkIdType last)
+    {
+    for (vtkIdType index = first; index < last; ++index)
+      {
+      const std::pair<int, vtkImageFillBetweenSlicesGap*>& gap = gaps[index / 2];
+      vtkImageFillBetweenSlicesComputeSignedDistances<T>(context, labelPtr, gap.first, gap.second,
+        static_cast<int>(index % 2), signedDistances[index]);
+      }
+    });
+
+  // Interpolate all intermediate slices of all gaps
+  std::vector<std::pair<vtkIdType, int>> intermediateSlices;
+  for (vtkIdType gapIndex = 0; gapIndex < numberOfGaps; ++gapIndex)
+    {
+    vtkImageFillBetweenSlicesGap* gap = gaps[gapIndex].second;
+    const int numberOfIntermediateSlices = gap->Slices[1] - gap->Slices[0] - 1;
+    gap->Mask.assign(static_cast<size_t>(numberOfIntermediateSlices)
+      * (gap->PlaneExtent[1] - gap->PlaneExtent[0] + 1) * (gap->PlaneExtent[3] - gap->PlaneExtent[2] + 1), 0);
+    for (int slice = 0; slice < numberOfIntermediateSlices; ++slice)
+      {
+      intermediateSlices.push_back(std::make_pair(gapIndex, slice));
+      }
+    }
+  vtkSMPTools::For(0, static_cast<vtkIdType>(intermediateSlices.size()), [&](vtkIdType first, vtkIdType last)
+    {
+    for (vtkIdType index = first; index < last; ++index)
+      {
+      const vtkIdType gapIndex = intermediateSlices[index].first;
+      const int slice = intermediateSlices[index].second;
+      vtkImageFillBetweenSlicesGap* gap = gaps[gapIndex].second;
+      const float* signedDistances0 = signedDistances[2 * gapIndex].data();
+      const float* signedDistances1 = signedDistances[2 * gapIndex + 1].data();
+      const int planeDimensions[2] = { gap->PlaneExtent[1] - gap->PlaneExtent[0] + 1, gap->PlaneExtent[3] - gap->PlaneExtent[2] + 1 };
+      const float weight1 = static_cast<float>(slice + 1) / static_cast<float>(gap->Slices[1] - gap->Slices[0]);
+      const float weight0 = 1.0f - weight1;
+      unsigned char* maskPtr = &gap->Mask[static_cast<size_t>(slice) * planeDimensions[0] * planeDimensions[1]];
+      for (int v = 0; v < planeDimensions[1]; ++v)
+        {
+        const vtkIdType paddedOffset = static_cast<vtkIdType>(v + 1) * (planeDimensions[0] + 2) + 1;
+        for (int u = 0; u < planeDimensions[0]; ++u)
+          {
+          *(maskPtr++) = (weight0 * signedDistances0[paddedOffset + u] + weight1 * signedDistances1[paddedOffset + u] <= 0.0f ? 1 : 0);
+          }
+        }
+      }
+    });
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void vtkImageFillBetweenSlicesWriteOutput(const vtkImageFillBetweenSlicesContext& context, const T* labelPtr,
+  T* outputPtr, const std::map<int, std::vector<std::shared_ptr<vtkImageFillBetweenSlicesGap>>>& labelGaps)
+{
+  // Copy input
+  const vtkIdType numberOfVoxels = static_cast<vtkIdType>(context.Dimensions[0]) * context.Dimensions[1] * context.Dimensions[2];
+  const vtkIdType componentIncrement = context.Increments[0];
+  vtkSMPTools::For(0, numberOfVoxels, [&](vtkIdType first, vtkIdType last)
+    {
+    for (vtkIdType index = first; index < last; ++index)
+      {
+      outputPtr[index] = labelPtr[index * componentIncrement];
+      }
+    });
+
+  // Write interpolated voxels where the input is empty. Labels are written in descending order,
+  // so that lower label values overwrite higher label values where interpolated regions overlap.
+  const vtkIdType outputIncrements[3] = { 1, context.Dimensions[0], static_cast<vtkIdType>(context.Dimensions[0]) * context.Dimensions[1] };
+  for (auto labelGapsIt = labelGaps.rbegin(); labelGapsIt != labelGaps.rend(); ++labelGapsIt)
+    {
+    const T labelValue = static_cast<T>(labelGapsIt->first);
+    const std::vector<std::shared_ptr<vtkImageFillBetweenSlicesGap>>& gaps = labelGapsIt->second;
+    std::vector<std::pair<size_t, int>> intermediateSlices;
+    for (size_t gapIndex = 0; gapIndex < gaps.size(); ++gapIndex)
+      {
+      for (int slice = gaps[gapIndex]->Slices[0] + 1; slice < gaps[gapIndex]->Slices[1]; ++slice)
+        {
+        intermediateSlices.push_back(std::make_pair(gapIndex, slice));
+        }
+      }
+    // Gaps of a label do not overlap, therefore all intermediate slices can be written in parallel
+    vtkSMPTools::For(0, static_cast<vtkIdType>(intermediateSlices.size()), [&](vtkIdType first, vtkIdType last)
+      {
+      for (vtkIdType index = first; index < last; ++index)
+        {
+        const vtkImageFillBetweenSlicesGap* gap = gaps[intermediateSlices[index].first].get();
+        const int slice = intermediateSlices[index].second;
+        int uAxis = 0;
+        int vAxis = 1;
+        GetPlaneAxes(gap->Axis, uAxis, vAxis);
+        const int* planeExtent = gap->PlaneExtent;
+        const unsigned char* maskPtr = &gap->Mask[static_cast<size_t>(slice - gap->Slices[0] - 1)
+          * (planeExtent[1] - planeExtent[0] + 1) * (planeExtent[3] - planeExtent[2] + 1)];
+        for (int v = planeExtent[2]; v <= planeExtent[3]; ++v)
+          {
+          for (int u = planeExtent[0]; u <= planeExtent[1]; ++u)
+            {
+            if (*(maskPtr++) == 0)
+              {
+              continue;
+              }
+            if (labelPtr[context.GetOffset(gap->Axis, slice, uAxis, u, vAxis, v)] != 0)
+              {
+              continue;
+              }
+            outputPtr[slice * outputIncrements[gap->Axis] + u * outputIncrements[uAxis] + v * outputIncrements[vAxis]] = labelValue;
+            }
+          }
+        }
+      });
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void vtkImageFillBetweenSlicesExecute(vtkImageData* labelmap, vtkImageData* output,
+  int forcedAxis, std::map<int, std::vector<std::shared_ptr<vtkImageFillBetweenSlicesGap>>>& cachedLabelGaps,
+  int& numberOfInterpolatedGaps, int& numberOfReusedGaps)
+{
+  vtkImageFillBetweenSlicesContext context;
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  labelmap->GetExtent(extent);
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    context.Dimensions[axis] = extent[axis * 2 + 1] - extent[axis * 2] + 1;
+    }
+  labelmap->GetIncrements(context.Increments);
+  labelmap->GetSpacing(context.Spacing);
+  const T* labelPtr = static_cast<const T*>(labelmap->GetScalarPointerForExtent(extent));
+  T* outputPtr = static_cast<T*>(output->GetScalarPointerForExtent(extent));
+
+  LabelSummaryMap labelSummaries;
+  vtkImageFillBetweenSlicesSummarizeSlices<T>(labelmap, labelSummaries);
+
+  // Find gaps between annotated slices. Gaps whose annotated slices have not changed are reused.
+  std::map<int, std::vector<std::shared_ptr<vtkImageFillBetweenSlicesGap>>> labelGaps;
+  std::vector<std::pair<int, vtkImageFillBetweenSlicesGap*>> gapsToInterpolate;
+  for (const auto& labelSummaryIt : labelSummaries)
+    {
+    const int labelValue = labelSummaryIt.first;
+    const LabelSummary& summary = labelSummaryIt.second;
+    int axis = forcedAxis;
+    if (axis < 0)
+      {
+      // Use the axis that has the most gaps, prefer the last axis if equal
+      int maximumNumberOfGaps = 0;
+      axis = 2;
+      for (int candidateAxis = 2; candidateAxis >= 0; --candidateAxis)
+        {
+        const int numberOfGaps = GetNumberOfGaps(summary.Slices[candidateAxis]);
+        if (numberOfGaps > maximumNumberOfGaps)
+          {
+          maximumNumberOfGaps = numberOfGaps;
+          axis = candidateAxis;
+          }
+        }
+      }
+
+    const std::vector<SliceSummary>& slices = summary.Slices[axis];
+    std::vector<std::shared_ptr<vtkImageFillBetweenSlicesGap>> cachedGaps;
+    auto cachedGapsIt = cachedLabelGaps.find(labelValue);
+    if (cachedGapsIt != cachedLabelGaps.end())
+      {
+      cachedGaps = cachedGapsIt->second;
+      }
+    std::vector<std::shared_ptr<vtkImageFillBetweenSlicesGap>>& gaps = labelGaps[labelValue];
+    int previousSlice = -1;
+    for (int slice = 0; slice < static_cast<int>(slices.size()); ++slice)
+      {
+      if (slices[slice].NumberOfVoxels == 0)
+        {
+        continue;
+        }
+      if (previousSlice >= 0 && slice - previousSlice > 1)
+        {
+        const SliceSummary& summary0 = slices[previousSlice];
+        const SliceSummary& summary1 = slices[slice];
+        std::shared_ptr<vtkImageFillBetweenSlicesGap> gap;
+        for (const std::shared_ptr<vtkImageFillBetweenSlicesGap>& cachedGap : cachedGaps)
+          {
+          if (cachedGap->Axis == axis
+            && cachedGap->Slices[0] == previousSlice && cachedGap->Slices[1] == slice
+            && cachedGap->SliceHashes[0] == summary0.Hash && cachedGap->SliceHashes[1] == summary1.Hash)
+            {
+            gap = cachedGap;
+            break;
+            }
+          }
+        if (gap)
+          {
+          ++numberOfReusedGaps;
+          }
+        else
+          {
+          gap = std::make_shared<vtkImageFillBetweenSlicesGap>();
+          gap->Axis = axis;
+          gap->Slices[0] = previousSlice;
+          gap->Slices[1] = slice;
+          gap->SliceHashes[0] = summary0.Hash;
+          gap->SliceHashes[1] = summary1.Hash;
+          gap->PlaneExtent[0] = std::min(summary0.PlaneExtent[0], summary1.PlaneExtent[0]);
+          gap->PlaneExtent[1] = std::max(summary0.PlaneExtent[1], summary1.PlaneExtent[1]);
+          gap->PlaneExtent[2] = std::min(summary0.PlaneExtent[2], summary1.PlaneExtent[2]);
+          gap->PlaneExtent[3] = std::max(summary0.PlaneExtent[3], summary1.PlaneExtent[3]);
+          gapsToInterpolate.push_back(std::make_pair(labelValue, gap.get()));
+          }
+        gaps.push_back(gap);
+        }
+      previousSlice = slice;
+      }
+    }
+
+  numberOfInterpolatedGaps = static_cast<int>(gapsToInterpolate.size());
+  vtkImageFillBetweenSlicesInterpolateGaps<T>(context, labelPtr, gapsToInterpolate);
+  vtkImageFillBetweenSlicesWriteOutput<T>(context, labelPtr, outputPtr, labelGaps);
+
+  // Gaps that are not used anymore are removed from the cache
+  cachedLabelGaps.swap(labelGaps);
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkImageFillBetweenSlices);
+
+//----------------------------------------------------------------------------
+vtkImageFillBetweenSlices::vtkImageFillBetweenSlices() = default;
+
+//----------------------------------------------------------------------------
+vtkImageFillBetweenSlices::~vtkImageFillBetweenSlices()
+{
+  this->SetLabelmap(nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageFillBetweenSlices::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Labelmap: " << this->Labelmap << "\n";
+  os << indent << "Axis: " << this->Axis << "\n";
+  os << indent << "NumberOfInterpolatedGaps: " << this->NumberOfInterpolatedGaps << "\n";
+  os << indent << "NumberOfReusedGaps: " << this->NumberOfReusedGaps << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkImageFillBetweenSlices::ClearCache()
+{
+  this->Gaps.clear();
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    this->CacheExtent[axis * 2] = 0;
+    this->CacheExtent[axis * 2 + 1] = -1;
+    this->CacheSpacing[axis] = 0.0;
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageFillBetweenSlices::Execute(vtkOrientedImageData* output)
+{
+  if (!output)
+    {
+    vtkErrorMacro("Execute: invalid output");
+    return false;
+    }
+  if (!this->Labelmap || !this->Labelmap->GetPointData() || !this->Labelmap->GetPointData()->GetScalars())
+    {
+    vtkErrorMacro("Execute: invalid input labelmap");
+    return false;
+    }
+  this->NumberOfInterpolatedGaps = 0;
+  this->NumberOfReusedGaps = 0;
+
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  this->Labelmap->GetExtent(extent);
+  double spacing[3] = { 1.0, 1.0, 1.0 };
+  this->Labelmap->GetSpacing(spacing);
+  if (!std::equal(extent, extent + 6, this->CacheExtent) || !std::equal(spacing, spacing + 3, this->CacheSpacing))
+    {
+    this->ClearCache();
+    std::copy(extent, extent + 6, this->CacheExtent);
+    std::copy(spacing, spacing + 3, this->CacheSpacing);
+    }
+
+  output->Initialize();
+  output->SetOrigin(this->Labelmap->GetOrigin());
+  output->SetSpacing(spacing);
+  if (vtkOrientedImageData::SafeDownCast(this->Labelmap))
+    {
+    output->CopyDirections(this->Labelmap);
+    }
+  else
+    {
+    output->SetDirections(1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0);
+    }
+  output->SetExtent(extent);
+  output->AllocateScalars(this->Labelmap->GetScalarType(), 1);
+  if (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5])
+    {
+    // empty input
+    return true;
+    }
+
+  switch (this->Labelmap->GetScalarType())
+    {
+    vtkTemplateMacro(vtkImageFillBetweenSlicesExecute<VTK_TT>(this->Labelmap, output, this->Axis,
+      this->Gaps, this->NumberOfInterpolatedGaps, this->NumberOfReusedGaps));
+    default:
+      vtkErrorMacro("Execute: unsupported labelmap scalar type");
+      return false;
+    }
+  return true;
+}
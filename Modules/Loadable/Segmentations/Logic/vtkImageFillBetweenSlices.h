@@ -0,0 +1,99 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef vtkImageFillBetweenSlices_h
+#define vtkImageFillBetweenSlices_h
+
+#include "vtkSlicerSegmentationsModuleLogicExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <map>
+#include <memory>
+#include <vector>
+
+class vtkImageData;
+class vtkOrientedImageData;
+struct vtkImageFillBetweenSlicesGap;
+
+/// \brief Fill empty slices between segmented slices of each label of a labelmap.
+///
+/// Slices that contain a label are the annotated slices of that label. Each gap between
+/// two annotated slices is filled using shape-based interpolation: in-plane signed distance
+/// maps of the two bounding slices are linearly interpolated and the zero level set is
+/// the contour in the intermediate slices. Only the slab between the two annotated slices,
+/// restricted to the in-plane bounding box of the label in the annotated slices, is processed.
+/// Gaps of all labels are interpolated in parallel.
+///
+/// Interpolated gaps are cached: in the next execution only those gaps are interpolated again
+/// where any of the two bounding annotated slices have changed. Therefore editing one slice
+/// only requires interpolation of the adjacent gaps.
+///
+/// Non-zero voxels of the input are not modified. If interpolated regions of different labels
+/// overlap then the lower label value is used.
+class VTK_SLICER_SEGMENTATIONS_LOGIC_EXPORT vtkImageFillBetweenSlices : public vtkObject
+{
+public:
+  static vtkImageFillBetweenSlices* New();
+  vtkTypeMacro(vtkImageFillBetweenSlices, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Input labelmap. Each label value is interpolated independently.
+  vtkSetObjectMacro(Labelmap, vtkImageData);
+  vtkGetObjectMacro(Labelmap, vtkImageData);
+
+  /// Interpolate along this axis (0, 1, 2). If -1 (default) then the axis is chosen for each
+  /// label automatically: the axis that has the most gaps between annotated slices.
+  vtkSetClampMacro(Axis, int, -1, 2);
+  vtkGetMacro(Axis, int);
+
+  /// Compute the filled labelmap. Output has the same extent and geometry as the input labelmap.
+  /// \return False if the inputs are invalid.
+  bool Execute(vtkOrientedImageData* output);
+
+  /// Remove all cached interpolation results
+  void ClearCache();
+
+  /// Number of gaps that were interpolated in the last execution
+  vtkGetMacro(NumberOfInterpolatedGaps, int);
+
+  /// Number of gaps whose interpolation result was reused from the cache in the last execution
+  vtkGetMacro(NumberOfReusedGaps, int);
+
+protected:
+  vtkImageFillBetweenSlices();
+  ~vtkImageFillBetweenSlices() override;
+
+  vtkImageData* Labelmap{ nullptr };
+  int Axis{ -1 };
+  int NumberOfInterpolatedGaps{ 0 };
+  int NumberOfReusedGaps{ 0 };
+
+  /// Cached gaps of each label value
+  std::map<int, std::vector<std::shared_ptr<vtkImageFillBetweenSlicesGap>>> Gaps;
+  /// Extent of the labelmap that the cached gaps were computed for
+  int CacheExtent[6]{ 0, -1, 0, -1, 0, -1 };
+  double CacheSpacing[3]{ 0.0, 0.0, 0.0 };
+
+private:
+  vtkImageFillBetweenSlices(const vtkImageFillBetweenSlices&) = delete;
+  void operator=(const vtkImageFillBetweenSlices&) = delete;
+};
+
+#endif
@@ -1,7 +1,10 @@
 #include "vtkImageGrowCutSegment.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <limits>
+#include <utility>
 #include <vector>
 
 #include <vtkInformation.h>
@@ -9,6 +12,7 @@
 #include <vtkMath.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkSMPTools.h>
 #include <vtkSmartPointer.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
 #include <vtkTimerLog.h>
@@ -27,6 +31,151 @@ const int MaskPixelTypeID = VTK_UNSIGNED_CHAR;
 const NodeKeyValueType DIST_INF = std::numeric_limits<NodeKeyValueType>::max();
 const NodeKeyValueType DIST_EPSILON = 1e-3;
 
+// Bucket width is chosen so that the largest possible edge weight spans this many buckets
+const long long BUCKETS_PER_MAX_EDGE_WEIGHT = 4096;
+// Number of buckets processed by each slab between two synchronizations
+const long long BUCKETS_PER_ROUND = 1024;
+// Minimum number of slices in a slab (thinner slabs would mostly exchange messages)
+const NodeIndexType MIN_SLAB_THICKNESS = 8;
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Priority queue of voxels, sorted into buckets of equal distance range.
+/// Only voxels with a pending update are stored (8 bytes per entry), the queue
+/// does not need per-voxel bookkeeping. Outdated entries are not removed when
+/// a voxel's distance decreases, but they are skipped when popped.
+/// Entries must be within a window of buckets that is smaller than the number of
+/// buckets; the queue grows automatically if this is not the case.
+class GrowCutBucketQueue
+{
+public:
+  struct Entry
+  {
+    NodeKeyValueType Distance;
+    NodeIndexType Index;
+  };
+
+  void Initialize(NodeKeyValueType bucketWidth, long long numberOfBuckets)
+  {
+    this->BucketWidth = bucketWidth;
+    this->Buckets.clear();
+    this->Buckets.resize(numberOfBuckets);
+    this->Size = 0;
+  }
+
+  bool IsEmpty() const { return this->Size == 0; }
+
+  long long GetBucket(NodeKeyValueType distance) const
+  {
+    // Clamp to avoid overflow for very large distances
+    double bucket = static_cast<double>(distance) / this->BucketWidth;
+    return static_cast<long long>(std::min(bucket, 1.0e15));
+  }
+
+  void Push(NodeKeyValueType distance, NodeIndexType index)
+  {
+    long long bucket = this->GetBucket(distance);
+    if (this->Size == 0)
+      {
+      this->MinimumBucket = bucket;
+      this->MaximumBucket = bucket;
+      }
+    else
+      {
+      long long minimumBucket = std::min(this->MinimumBucket, bucket);
+      long long maximumBucket = std::max(this->MaximumBucket, bucket);
+      if (maximumBucket - minimumBucket >= static_cast<long long>(this->Buckets.size()))
+        {
+        this->Grow(maximumBucket - minimumBucket + 1);
+        }
+      this->MinimumBucket = minimumBucket;
+      this->MaximumBucket = maximumBucket;
+      }
+    this->Buckets[bucket % this->Buckets.size()].push_back({ distance, index });
+    this->Size++;
+  }
+
+  /// Get the lowest non-empty bucket. Returns false if the queue is empty.
+  bool GetMinimumBucket(long long& bucket)
+  {
+    if (this->Size == 0)
+      {
+      return false;
+      }
+    while (this->Buckets[this->MinimumBucket % this->Buckets.size()].empty())
+      {
+      this->MinimumBucket++;
+      }
+    bucket = this->MinimumBucket;
+    return true;
+  }
+
+  /// Remove an entry from the specified bucket. Returns false if the bucket is empty.
+  bool Pop(long long bucket, Entry& entry)
+  {
+    std::vector<Entry>& entries = this->Buckets[bucket % this->Buckets.size()];
+    if (entries.empty())
+      {
+      return false;
+      }
+    entry = entries.back();
+    entries.pop_back();
+    this->Size--;
+    return true;
+  }
+
+protected:
+  void Grow(long long minimumNumberOfBuckets)
+  {
+    std::vector<std::vector<Entry> > oldBuckets;
+    oldBuckets.swap(this->Buckets);
+    long long numberOfBuckets = std::max(minimumNumberOfBuckets, 2 * static_cast<long long>(oldBuckets.size()));
+    this->Buckets.resize(numberOfBuckets);
+    for (const std::vector<Entry>& entries : oldBuckets)
+      {
+      for (const Entry& entry : entries)
+        {
+        this->Buckets[this->GetBucket(entry.Distance) % numberOfBuckets].push_back(entry);
+        }
+      }
+  }
+
+  std::vector<std::vector<Entry> > Buckets;
+  NodeKeyValueType BucketWidth{ 1.0 };
+  long long MinimumBucket{ 0 };
+  long long MaximumBucket{ 0 };
+  size_t Size{ 0 };
+};
+
+//----------------------------------------------------------------------------
+/// Label propagation request to a voxel that belongs to another slab
+template<typename LabelPixelType>
+struct GrowCutMessage
+{
+  NodeKeyValueType Distance;
+  NodeIndexType Index;
+  LabelPixelType Label;
+};
+
+//----------------------------------------------------------------------------
+/// Range of slices that is processed by a single thread.
+/// Only the thread that processes the slab modifies voxels in the slab.
+template<typename LabelPixelType>
+struct GrowCutSlab
+{
+  NodeIndexType BeginIndex{ 0 };
+  NodeIndexType EndIndex{ 0 };
+  GrowCutBucketQueue Queue;
+  /// Seeds that were removed or changed since the last update (index and previous label)
+  std::vector<std::pair<NodeIndexType, LabelPixelType> > RemovedSeeds;
+  std::vector<GrowCutMessage<LabelPixelType> > MessagesToPreviousSlab;
+  std::vector<GrowCutMessage<LabelPixelType> > MessagesToNextSlab;
+};
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 class vtkImageGrowCutSegment::vtkInternal
 {
@@ -36,18 +185,24 @@ public:
 
   void Reset();
 
+  void AllocateVolumes(vtkImageData *seedLabelVolume, double distancePenalty);
+
   template<typename IntensityPixelType, typename LabelPixelType>
   bool InitializationAHP(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume, vtkImageData *maskLabelVolume, double distancePenalty);
 
   template<typename IntensityPixelType, typename LabelPixelType>
   void DijkstraBasedClassificationAHP(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume, vtkImageData *maskLabelVolume);
 
+  template<typename IntensityPixelType, typename LabelPixelType>
+  void BucketQueueClassification(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume, vtkImageData *maskLabelVolume);
+
   template <class SourceVolType>
   bool ExecuteGrowCut(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume, vtkImageData *maskLabelVolume,
-    vtkImageData *resultLabelVolume, double distancePenalty);
+    vtkImageData *resultLabelVolume, double distancePenalty, int algorithm);
 
   template< class SourceVolType, class SeedVolType>
-  bool ExecuteGrowCut2(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume, vtkImageData *maskLabelVolume, double distancePenalty);
+  bool ExecuteGrowCut2(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume, vtkImageData *maskLabelVolume,
+    double distancePenalty, int algorithm);
 
   // Stores the shortest distance from known labels to each point
   // If a point is set to DIST_INF then that point will modified, as a shorter distance path will be found.
@@ -64,9 +219,11 @@ public:
   NodeIndexType m_DimZ;
 
   std::vector<NodeIndexType> m_NeighborIndexOffsets;
+  std::vector<int> m_NeighborCoordinateOffsets; // (ix, iy, iz) triplets in the same order as m_NeighborIndexOffsets
   std::vector<double> m_NeighborDistancePenalties;
   std::vector<unsigned char> m_NumberOfNeighbors; // size of neighborhood (everywhere the same except at the image boundary)
 
+  // Only used by the Fibonacci heap algorithm
   FibHeap *m_Heap;
   FibHeapNode *m_HeapNodes; // a node is stored for each voxel
   bool m_bSegInitialized;
@@ -107,6 +264,74 @@ void vtkImageGrowCutSegment::vtkInternal::Reset()
   m_ResultLabelVolume->Initialize();
 }
 
+//-----------------------------------------------------------------------------
+void vtkImageGrowCutSegment::vtkInternal::AllocateVolumes(vtkImageData *seedLabelVolume, double distancePenalty)
+{
+  NodeIndexType dimXYZ = m_DimX * m_DimY * m_DimZ;
+  m_ResultLabelVolume->SetOrigin(seedLabelVolume->GetOrigin());
+  m_ResultLabelVolume->SetSpacing(seedLabelVolume->GetSpacing());
+  m_ResultLabelVolume->SetExtent(seedLabelVolume->GetExtent());
+  m_ResultLabelVolume->AllocateScalars(seedLabelVolume->GetScalarType(), 1);
+  m_DistanceVolume->SetOrigin(seedLabelVolume->GetOrigin());
+  m_DistanceVolume->SetSpacing(seedLabelVolume->GetSpacing());
+  m_DistanceVolume->SetExtent(seedLabelVolume->GetExtent());
+  m_DistanceVolume->AllocateScalars(NodeKeyValueTypeID, 1);
+
+  // Compute index offset
+  m_DistancePenalty = distancePenalty;
+  m_NeighborIndexOffsets.clear();
+  m_NeighborCoordinateOffsets.clear();
+  m_NeighborDistancePenalties.clear();
+  // Neighbors are traversed in the order of m_NeighborIndexOffsets,
+  // therefore one would expect that the offsets should
+  // be as continuous as possible (e.g., x coordinate
+  // should change most quickly), but that resulted in
+  // about 5-6% longer computation time. Therefore,
+  // we put indices in order x1y1z1, x1y1z2, x1y1z3, etc.
+  double* spacing = seedLabelVolume->GetSpacing();
+  for (long ix = -1; ix <= 1; ix++)
+  {
+    for (long iy = -1; iy <= 1; iy++)
+    {
+      for (long iz = -1; iz <= 1; iz++)
+      {
+        if (ix == 0 && iy == 0 && iz == 0)
+          {
+          continue;
+          }
+        m_NeighborIndexOffsets.push_back(ix + long(m_DimX)*(iy + long(m_DimY)*iz));
+        m_NeighborCoordinateOffsets.push_back(ix);
+        m_NeighborCoordinateOffsets.push_back(iy);
+        m_NeighborCoordinateOffsets.push_back(iz);
+        m_NeighborDistancePenalties.push_back(this->m_DistancePenalty * sqrt((spacing[0] * ix) * (spacing[0] * ix)
+          + (spacing[1] * iy) * (spacing[1] * iy) + (spacing[2] * iz) * (spacing[2] * iz)));
+        }
+      }
+    }
+
+  // Determine neighborhood size for computation at each voxel.
+  // The neighborhood size is everywhere the same (size of m_NeighborIndexOffsets)
+  // except at the edges of the volume, where the neighborhood size is 0.
+  m_NumberOfNeighbors.resize(dimXYZ);
+  const unsigned char numberOfNeighbors = static_cast<unsigned char>(m_NeighborIndexOffsets.size());
+  unsigned char* nbSizePtr = &(m_NumberOfNeighbors[0]);
+  for (NodeIndexType z = 0; z < m_DimZ; z++)
+    {
+    bool zEdge = (z == 0 || z == m_DimZ - 1);
+    for (NodeIndexType y = 0; y < m_DimY; y++)
+      {
+      bool yEdge = (y == 0 || y == m_DimY - 1);
+      *(nbSizePtr++) = 0; // x == 0 (there is always padding, so we don't need to check if m_DimX>0)
+      unsigned char nbSize = (zEdge || yEdge) ? 0 : numberOfNeighbors;
+      for (NodeIndexType x = m_DimX-2; x > 0; x--)
+        {
+        *(nbSizePtr++) = nbSize;
+        }
+      *(nbSizePtr++) = 0; // x == m_DimX-1 (there is always padding, so we don'neighborNewDistance need to check if m_DimX>1)
+      }
+    }
+}
+
 //-----------------------------------------------------------------------------
 template<typename IntensityPixelType, typename LabelPixelType>
 bool vtkImageGrowCutSegment::vtkInternal::InitializationAHP(
@@ -149,67 +374,10 @@ bool vtkImageGrowCutSegment::vtkInternal::InitializationAHP(
 
   if (!m_bSegInitialized)
     {
-    m_ResultLabelVolume->SetOrigin(seedLabelVolume->GetOrigin());
-    m_ResultLabelVolume->SetSpacing(seedLabelVolume->GetSpacing());
-    m_ResultLabelVolume->SetExtent(seedLabelVolume->GetExtent());
-    m_ResultLabelVolume->AllocateScalars(seedLabelVolume->GetScalarType(), 1);
-    m_DistanceVolume->SetOrigin(seedLabelVolume->GetOrigin());
-    m_DistanceVolume->SetSpacing(seedLabelVolume->GetSpacing());
-    m_DistanceVolume->SetExtent(seedLabelVolume->GetExtent());
-    m_DistanceVolume->AllocateScalars(NodeKeyValueTypeID, 1);
+    this->AllocateVolumes(seedLabelVolume, distancePenalty);
     LabelPixelType* resultLabelVolumePtr = static_cast<LabelPixelType*>(m_ResultLabelVolume->GetScalarPointer());
     NodeKeyValueType* distanceVolumePtr = static_cast<NodeKeyValueType*>(m_DistanceVolume->GetScalarPointer());
 
-    // Compute index offset
-    m_DistancePenalty = distancePenalty;
-    m_NeighborIndexOffsets.clear();
-    m_NeighborDistancePenalties.clear();
-    // Neighbors are traversed in the order of m_NeighborIndexOffsets,
-    // therefore one would expect that the offsets should
-    // be as continuous as possible (e.g., x coordinate
-    // should change most quickly), but that resulted in
-    // about 5-6% longer computation time. Therefore,
-    // we put indices in order x1y1z1, x1y1z2, x1y1z3, etc.
-    double* spacing = seedLabelVolume->GetSpacing();
-    for (long ix = -1; ix <= 1; ix++)
-    {
-      for (long iy = -1; iy <= 1; iy++)
-      {
-        for (long iz = -1; iz <= 1; iz++)
-        {
-          if (ix == 0 && iy == 0 && iz == 0)
-            {
-            continue;
-            }
-          m_NeighborIndexOffsets.push_back(ix + long(m_DimX)*(iy + long(m_DimY)*iz));
-          m_NeighborDistancePenalties.push_back(this->m_DistancePenalty * sqrt((spacing[0] * ix) * (spacing[0] * ix)
-            + (spacing[1] * iy) * (spacing[1] * iy) + (spacing[2] * iz) * (spacing[2] * iz)));
-          }
-        }
-      }
-
-    // Determine neighborhood size for computation at each voxel.
-    // The neighborhood size is everywhere the same (size of m_NeighborIndexOffsets)
-    // except at the edges of the volume, where the neighborhood size is 0.
-    m_NumberOfNeighbors.resize(dimXYZ);
-    const unsigned char numberOfNeighbors = static_cast<unsigned char>(m_NeighborIndexOffsets.size());
-    unsigned char* nbSizePtr = &(m_NumberOfNeighbors[0]);
-    for (NodeIndexType z = 0; z < m_DimZ; z++)
-      {
-      bool zEdge = (z == 0 || z == m_DimZ - 1);
-      for (NodeIndexType y = 0; y < m_DimY; y++)
-        {
-        bool yEdge = (y == 0 || y == m_DimY - 1);
-        *(nbSizePtr++) = 0; // x == 0 (there is always padding, so we don't need to check if m_DimX>0)
-        unsigned char nbSize = (zEdge || yEdge) ? 0 : numberOfNeighbors;
-        for (NodeIndexType x = m_DimX-2; x > 0; x--)
-          {
-          *(nbSizePtr++) = nbSize;
-          }
-        *(nbSizePtr++) = 0; // x == m_DimX-1 (there is always padding, so we don'neighborNewDistance need to check if m_DimX>1)
-        }
-      }
-
     if (!maskLabelVolumePtr)
       {
       // no mask
@@ -403,10 +571,313 @@ void vtkImageGrowCutSegment::vtkInternal::DijkstraBasedClassificationAHP(
   m_HeapNodes = nullptr;
 }
 
+//-----------------------------------------------------------------------------
+template<typename IntensityPixelType, typename LabelPixelType>
+void vtkImageGrowCutSegment::vtkInternal::BucketQueueClassification(
+    vtkImageData *intensityVolume,
+    vtkImageData *seedLabelVolume,
+    vtkImageData *maskLabelVolume)
+{
+  // Computes the same shortest paths as the Dijkstra-based classification, but the volume is split
+  // into slabs along the z axis and each slab is processed by a separate thread, using a bucket queue.
+  // Label propagation to a neighbor slab is sent as a message, which is applied by the neighbor slab's
+  // thread after all threads finished processing the current range of buckets. Since voxels are only
+  // updated when their distance decreases, the result converges to the exact shortest path distances
+  // (voxels with multiple shortest paths of equal length may get the label of any of those paths).
+
+  if (!m_bSegInitialized)
+    {
+    this->AllocateVolumes(seedLabelVolume, m_DistancePenalty);
+    }
+
+  IntensityPixelType* imSrc = static_cast<IntensityPixelType*>(intensityVolume->GetScalarPointer());
+  LabelPixelType* seedLabelVolumePtr = static_cast<LabelPixelType*>(seedLabelVolume->GetScalarPointer());
+  MaskPixelType* maskLabelVolumePtr = nullptr;
+  if (maskLabelVolume != nullptr)
+    {
+    maskLabelVolumePtr = static_cast<MaskPixelType*>(maskLabelVolume->GetScalarPointer());
+    }
+  LabelPixelType* resultLabelVolumePtr = static_cast<LabelPixelType*>(m_ResultLabelVolume->GetScalarPointer());
+  NodeKeyValueType* distanceVolumePtr = static_cast<NodeKeyValueType*>(m_DistanceVolume->GetScalarPointer());
+
+  // Bucket width is based on the largest possible edge weight
+  double* intensityRange = intensityVolume->GetScalarRange();
+  double maximumEdgeWeight = intensityRange[1] - intensityRange[0];
+  if (!m_NeighborDistancePenalties.empty())
+    {
+    maximumEdgeWeight += *std::max_element(m_NeighborDistancePenalties.begin(), m_NeighborDistancePenalties.end());
+    }
+  NodeKeyValueType bucketWidth = static_cast<NodeKeyValueType>(maximumEdgeWeight / BUCKETS_PER_MAX_EDGE_WEIGHT);
+  if (!(bucketWidth > 0.0) || !std::isfinite(bucketWidth))
+    {
+    bucketWidth = 1.0;
+    }
+
+  NodeIndexType sliceSize = m_DimX * m_DimY;
+  int numberOfSlabs = std::max(1, std::min(vtkSMPTools::GetEstimatedNumberOfThreads(),
+    static_cast<int>(m_DimZ / MIN_SLAB_THICKNESS)));
+  std::vector<GrowCutSlab<LabelPixelType> > slabs(numberOfSlabs);
+  for (int slabIndex = 0; slabIndex < numberOfSlabs; slabIndex++)
+    {
+    GrowCutSlab<LabelPixelType>& slab = slabs[slabIndex];
+    slab.BeginIndex = sliceSize * static_cast<NodeIndexType>(static_cast<size_t>(m_DimZ) * slabIndex / numberOfSlabs);
+    slab.EndIndex = sliceSize * static_cast<NodeIndexType>(static_cast<size_t>(m_DimZ) * (slabIndex + 1) / numberOfSlabs);
+    slab.Queue.Initialize(bucketWidth, BUCKETS_PER_MAX_EDGE_WEIGHT + BUCKETS_PER_ROUND + 2);
+    }
+
+  // Initialize distances and add seeds to the queues
+  bool fullComputation = !m_bSegInitialized;
+  vtkSMPTools::For(0, numberOfSlabs, 1, [&](vtkIdType beginSlab, vtkIdType endSlab)
+    {
+    for (vtkIdType slabIndex = beginSlab; slabIndex < endSlab; slabIndex++)
+      {
+      GrowCutSlab<LabelPixelType>& slab = slabs[slabIndex];
+      for (NodeIndexType index = slab.BeginIndex; index < slab.EndIndex; index++)
+        {
+        LabelPixelType seedValue = seedLabelVolumePtr[index];
+        if (fullComputation)
+          {
+          if (maskLabelVolumePtr && maskLabelVolumePtr[index] != 0)
+            {
+            // small distance will prevent overwriting of masked voxels
+            resultLabelVolumePtr[index] = 0;
+            distanceVolumePtr[index] = DIST_EPSILON;
+            continue;
+            }
+          resultLabelVolumePtr[index] = seedValue;
+          distanceVolumePtr[index] = (seedValue == 0 ? DIST_INF : DIST_EPSILON);
+          if (seedValue != 0)
+            {
+            slab.Queue.Push(DIST_EPSILON, index);
+            }
+          }
+        else if (seedValue != 0)
+          {
+          if (resultLabelVolumePtr[index] == seedValue && distanceVolumePtr[index] <= DIST_EPSILON)
+            {
+            // Old seeds are ignored, as their labels have been already propagated
+            continue;
+            }
+          if (resultLabelVolumePtr[index] != 0 && distanceVolumePtr[index] <= DIST_EPSILON)
+            {
+            // Changed seed, labels that were propagated from it have to be recomputed
+            slab.RemovedSeeds.push_back(std::make_pair(index, resultLabelVolumePtr[index]));
+            }
+          // Only grow from new/changed seeds
+          resultLabelVolumePtr[index] = seedValue;
+          distanceVolumePtr[index] = DIST_EPSILON;
+          slab.Queue.Push(DIST_EPSILON, index);
+          }
+        else if (resultLabelVolumePtr[index] != 0 && distanceVolumePtr[index] <= DIST_EPSILON)
+          {
+          // Removed seed
+          slab.RemovedSeeds.push_back(std::make_pair(index, resultLabelVolumePtr[index]));
+          resultLabelVolumePtr[index] = 0;
+          distanceVolumePtr[index] = DIST_INF;
+          }
+        }
+      }
+    });
+
+  const NodeIndexType* neighborIndexOffsets = m_NeighborIndexOffsets.data();
+  const double* neighborDistancePenalties = m_NeighborDistancePenalties.data();
+  const unsigned char* numberOfNeighbors = m_NumberOfNeighbors.data();
+
+  if (!fullComputation)
+    {
+    // Invalidate all voxels that got their label from a removed or changed seed.
+    // A voxel got its label from a neighbor if its distance equals the distance computed from
+    // that neighbor (the same expression is used as in label propagation, so it is bit-exact).
+    std::vector<NodeIndexType> invalidatedVoxels;
+    std::vector<GrowCutMessage<LabelPixelType> > voxelsToVisit;
+    for (GrowCutSlab<LabelPixelType>& slab : slabs)
+      {
+      for (const std::pair<NodeIndexType, LabelPixelType>& removedSeed : slab.RemovedSeeds)
+        {
+        voxelsToVisit.push_back({ DIST_EPSILON, removedSeed.first, removedSeed.second });
+        if (seedLabelVolumePtr[removedSeed.first] == 0)
+          {
+          invalidatedVoxels.push_back(removedSeed.first);
+          }
+        }
+      }
+    while (!voxelsToVisit.empty())
+      {
+      GrowCutMessage<LabelPixelType> voxel = voxelsToVisit.back();
+      voxelsToVisit.pop_back();
+      NodeKeyValueType pixCenter = imSrc[voxel.Index];
+      unsigned char nbSize = numberOfNeighbors[voxel.Index];
+      for (unsigned char i = 0; i < nbSize; i++)
+        {
+        NodeIndexType indexNgbh = voxel.Index + neighborIndexOffsets[i];
+        if (seedLabelVolumePtr[indexNgbh] != 0 || resultLabelVolumePtr[indexNgbh] != voxel.Label)
+          {
+          continue;
+          }
+        NodeKeyValueType neighborDistance = fabs(pixCenter - imSrc[indexNgbh]) + voxel.Distance + neighborDistancePenalties[i];
+        if (distanceVolumePtr[indexNgbh] != neighborDistance)
+          {
+          continue;
+          }
+        voxelsToVisit.push_back({ neighborDistance, indexNgbh, voxel.Label });
+        invalidatedVoxels.push_back(indexNgbh);
+        resultLabelVolumePtr[indexNgbh] = 0;
+        distanceVolumePtr[indexNgbh] = DIST_INF;
+        }
+      }
+
+    // Labels are propagated into the invalidated region again from the voxels around it.
+    // Voxels at the image boundary are not propagated from, but they can be reached from their neighbors,
+    // therefore neighbor coordinates are checked to avoid indexing out of the image.
+    const int* neighborCoordinateOffsets = m_NeighborCoordinateOffsets.data();
+    const int numberOfNeighborOffsets = static_cast<int>(m_NeighborIndexOffsets.size());
+    for (NodeIndexType index : invalidatedVoxels)
+      {
+      int x = static_cast<int>(index % m_DimX);
+      int y = static_cast<int>((index / m_DimX) % m_DimY);
+      int z = static_cast<int>(index / sliceSize);
+      for (int i = 0; i < numberOfNeighborOffsets; i++)
+        {
+        int neighborX = x + neighborCoordinateOffsets[3 * i];
+        int neighborY = y + neighborCoordinateOffsets[3 * i + 1];
+        int neighborZ = z + neighborCoordinateOffsets[3 * i + 2];
+        if (neighborX < 0 || neighborX >= static_cast<int>(m_DimX)
+          || neighborY < 0 || neighborY >= static_cast<int>(m_DimY)
+          || neighborZ < 0 || neighborZ >= static_cast<int>(m_DimZ))
+          {
+          continue;
+          }
+        NodeIndexType indexNgbh = index + neighborIndexOffsets[i];
+        // Invalidated, unreached, and masked voxels have zero label
+        if (numberOfNeighbors[indexNgbh] == 0 || resultLabelVolumePtr[indexNgbh] == 0)
+          {
+          continue;
+          }
+        int slabIndex = numberOfSlabs - 1;
+        while (indexNgbh < slabs[slabIndex].BeginIndex)
+          {
+          slabIndex--;
+          }
+        slabs[slabIndex].Queue.Push(distanceVolumePtr[indexNgbh], indexNgbh);
+        }
+      }
+    }
+
+  long long bucketsEnd = 0;
+
+  // Propagate labels from all queued voxels with distance below bucketsEnd
+  auto processSlab = [&](GrowCutSlab<LabelPixelType>& slab)
+    {
+    slab.MessagesToPreviousSlab.clear();
+    slab.MessagesToNextSlab.clear();
+    long long bucket = 0;
+    GrowCutBucketQueue::Entry entry;
+    while (slab.Queue.GetMinimumBucket(bucket) && bucket < bucketsEnd)
+      {
+      while (slab.Queue.Pop(bucket, entry))
+        {
+        NodeIndexType index = entry.Index;
+        NodeKeyValueType currentDistance = entry.Distance;
+        if (currentDistance > distanceVolumePtr[index])
+          {
+          // outdated entry, the voxel has been reached through a shorter path since then
+          continue;
+          }
+        LabelPixelType currentLabel = resultLabelVolumePtr[index];
+        NodeKeyValueType pixCenter = imSrc[index];
+        unsigned char nbSize = numberOfNeighbors[index];
+        for (unsigned char i = 0; i < nbSize; i++)
+          {
+          NodeIndexType indexNgbh = index + neighborIndexOffsets[i];
+          NodeKeyValueType neighborNewDistance = fabs(pixCenter - imSrc[indexNgbh]) + currentDistance + neighborDistancePenalties[i];
+          if (indexNgbh < slab.BeginIndex)
+            {
+            slab.MessagesToPreviousSlab.push_back({ neighborNewDistance, indexNgbh, currentLabel });
+            }
+          else if (indexNgbh >= slab.EndIndex)
+            {
+            slab.MessagesToNextSlab.push_back({ neighborNewDistance, indexNgbh, currentLabel });
+            }
+          else if (distanceVolumePtr[indexNgbh] > neighborNewDistance)
+            {
+            distanceVolumePtr[indexNgbh] = neighborNewDistance;
+            resultLabelVolumePtr[indexNgbh] = currentLabel;
+            slab.Queue.Push(neighborNewDistance, indexNgbh);
+            }
+          }
+        }
+      }
+    };
+
+  // Apply label propagation requests sent by a neighbor slab
+  auto receiveMessages = [&](GrowCutSlab<LabelPixelType>& slab, const std::vector<GrowCutMessage<LabelPixelType> >& messages)
+    {
+    for (const GrowCutMessage<LabelPixelType>& message : messages)
+      {
+      if (distanceVolumePtr[message.Index] > message.Distance)
+        {
+        distanceVolumePtr[message.Index] = message.Distance;
+        resultLabelVolumePtr[message.Index] = message.Label;
+        slab.Queue.Push(message.Distance, message.Index);
+        }
+      }
+    };
+
+  while (true)
+    {
+    // All slabs process the same range of buckets, to avoid that a slab propagates labels far ahead
+    // of its neighbors (these labels would likely be overwritten by labels coming from the neighbors).
+    bool empty = true;
+    long long minimumBucket = 0;
+    for (GrowCutSlab<LabelPixelType>& slab : slabs)
+      {
+      long long slabMinimumBucket = 0;
+      if (slab.Queue.GetMinimumBucket(slabMinimumBucket))
+        {
+        minimumBucket = (empty ? slabMinimumBucket : std::min(minimumBucket, slabMinimumBucket));
+        empty = false;
+        }
+      }
+    if (empty)
+      {
+      break;
+      }
+    bucketsEnd = minimumBucket + BUCKETS_PER_ROUND;
+
+    vtkSMPTools::For(0, numberOfSlabs, 1, [&](vtkIdType beginSlab, vtkIdType endSlab)
+      {
+      for (vtkIdType slabIndex = beginSlab; slabIndex < endSlab; slabIndex++)
+        {
+        processSlab(slabs[slabIndex]);
+        }
+      });
+    if (numberOfSlabs < 2)
+      {
+      continue;
+      }
+    vtkSMPTools::For(0, numberOfSlabs, 1, [&](vtkIdType beginSlab, vtkIdType endSlab)
+      {
+      for (vtkIdType slabIndex = beginSlab; slabIndex < endSlab; slabIndex++)
+        {
+        if (slabIndex > 0)
+          {
+          receiveMessages(slabs[slabIndex], slabs[slabIndex - 1].MessagesToNextSlab);
+          }
+        if (slabIndex < numberOfSlabs - 1)
+          {
+          receiveMessages(slabs[slabIndex], slabs[slabIndex + 1].MessagesToPreviousSlab);
+          }
+        }
+      });
+    }
+
+  m_bSegInitialized = true;
+}
+
 //-----------------------------------------------------------------------------
 template< class IntensityPixelType, class LabelPixelType>
 bool vtkImageGrowCutSegment::vtkInternal::ExecuteGrowCut2(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume,
-  vtkImageData *maskLabelVolume, double distancePenalty)
+  vtkImageData *maskLabelVolume, double distancePenalty, int algorithm)
 {
   int* imSize = intensityVolume->GetDimensions();
 
@@ -433,19 +904,25 @@ bool vtkImageGrowCutSegment::vtkInternal::ExecuteGrowCut2(vtkImageData *intensit
     return false;
     }
 
-  if (!InitializationAHP<IntensityPixelType, LabelPixelType>(intensityVolume, seedLabelVolume, maskLabelVolume, distancePenalty))
+  if (algorithm == vtkImageGrowCutSegment::AlgorithmFibonacciHeap)
     {
-    return false;
+    if (!InitializationAHP<IntensityPixelType, LabelPixelType>(intensityVolume, seedLabelVolume, maskLabelVolume, distancePenalty))
+      {
+      return false;
+      }
+    DijkstraBasedClassificationAHP<IntensityPixelType, LabelPixelType>(intensityVolume, seedLabelVolume, maskLabelVolume);
+    return true;
     }
 
-  DijkstraBasedClassificationAHP<IntensityPixelType, LabelPixelType>(intensityVolume, seedLabelVolume, maskLabelVolume);
+  m_DistancePenalty = distancePenalty;
+  BucketQueueClassification<IntensityPixelType, LabelPixelType>(intensityVolume, seedLabelVolume, maskLabelVolume);
   return true;
 }
 
 //----------------------------------------------------------------------------
 template <class SourceVolType>
 bool vtkImageGrowCutSegment::vtkInternal::ExecuteGrowCut(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume,
-  vtkImageData *maskLabelVolume, vtkImageData *resultLabelVolume, double distancePenalty)
+  vtkImageData *maskLabelVolume, vtkImageData *resultLabelVolume, double distancePenalty, int algorithm)
 {
   int* extent = intensityVolume->GetExtent();
   double* spacing = intensityVolume->GetSpacing();
@@ -521,7 +998,7 @@ bool vtkImageGrowCutSegment::vtkInternal::ExecuteGrowCut(vtkImageData *intensity
   bool success = false;
   switch (seedLabelVolume->GetScalarType())
   {
-    vtkTemplateMacro((success = ExecuteGrowCut2<SourceVolType, VTK_TT>(intensityVolume, seedLabelVolume, maskLabelVolume, distancePenalty)));
+    vtkTemplateMacro((success = ExecuteGrowCut2<SourceVolType, VTK_TT>(intensityVolume, seedLabelVolume, maskLabelVolume, distancePenalty, algorithm)));
   default:
     vtkGenericWarningMacro("vtkOrientedImageDataResample::MergeImage: Unknown ScalarType");
   }
@@ -544,6 +1021,7 @@ vtkImageGrowCutSegment::vtkImageGrowCutSegment()
   this->SetNumberOfInputPorts(3);
   this->SetNumberOfOutputPorts(1);
   this->DistancePenalty = 0.0;
+  this->Algorithm = AlgorithmParallelBucketQueue;
 }
 
 //-----------------------------------------------------------------------------
@@ -577,7 +1055,7 @@ void vtkImageGrowCutSegment::ExecuteDataWithInformation(
 
   switch (intensityVolume->GetScalarType())
     {
-    vtkTemplateMacro(this->Internal->ExecuteGrowCut<VTK_TT>(intensityVolume, seedLabelVolume, maskLabelVolume, resultLabelVolume, this->DistancePenalty));
+    vtkTemplateMacro(this->Internal->ExecuteGrowCut<VTK_TT>(intensityVolume, seedLabelVolume, maskLabelVolume, resultLabelVolume, this->DistancePenalty, this->Algorithm));
     break;
     }
   logger->StopTimer();
@@ -599,6 +1077,17 @@ int vtkImageGrowCutSegment::RequestInformation(
   return 1;
 }
 
+//-----------------------------------------------------------------------------
+const char* vtkImageGrowCutSegment::GetAlgorithmAsString()
+{
+  switch (this->Algorithm)
+    {
+    case AlgorithmParallelBucketQueue: return "ParallelBucketQueue";
+    case AlgorithmFibonacciHeap: return "FibonacciHeap";
+    default: return "Unknown";
+    }
+}
+
 //-----------------------------------------------------------------------------
 void vtkImageGrowCutSegment::Reset()
 {
@@ -608,6 +1097,7 @@ void vtkImageGrowCutSegment::Reset()
 //-----------------------------------------------------------------------------
 void vtkImageGrowCutSegment::PrintSelf(ostream &os, vtkIndent indent)
 {
-  // XXX Implement this function
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "DistancePenalty: " << this->DistancePenalty << "\n";
+  os << indent << "Algorithm: " << this->GetAlgorithmAsString() << "\n";
 }
@@ -27,7 +27,9 @@ public:
   void SetMaskVolume(vtkImageData* labelImage) { this->SetInputData(2, labelImage); }
 
   /// Reset to initial state. This forces full recomputation of the result label volume.
-  /// This method has to be called if intensity volume changes or if seeds are deleted after initial computation.
+  /// This method has to be called if intensity volume changes after initial computation.
+  /// When seeds are added, deleted, or changed then only the affected region is recomputed.
+  /// With AlgorithmFibonacciHeap this method has to be called if seeds are deleted.
   void Reset();
 
   /// Spatial regularization factor, which can force growing in nearby regions.
@@ -36,6 +38,26 @@ public:
   vtkGetMacro(DistancePenalty, double);
   vtkSetMacro(DistancePenalty, double);
 
+  enum
+    {
+    /// Multi-threaded computation using bucket queues (default).
+    /// Only stores voxels with a pending update in the queues, therefore it requires much less memory.
+    AlgorithmParallelBucketQueue,
+    /// Single-threaded computation using a Fibonacci heap node for each voxel.
+    /// Kept for comparison and validation.
+    AlgorithmFibonacciHeap,
+    Algorithm_Last // insert valid types above this line
+    };
+
+  /// Algorithm used for computing shortest paths from the seeds.
+  /// Both algorithms compute the same distances, therefore the algorithm can be changed
+  /// between incremental updates.
+  vtkSetClampMacro(Algorithm, int, AlgorithmParallelBucketQueue, Algorithm_Last - 1);
+  vtkGetMacro(Algorithm, int);
+  void SetAlgorithmToParallelBucketQueue() { this->SetAlgorithm(AlgorithmParallelBucketQueue); }
+  void SetAlgorithmToFibonacciHeap() { this->SetAlgorithm(AlgorithmFibonacciHeap); }
+  const char* GetAlgorithmAsString();
+
 protected:
   vtkImageGrowCutSegment();
   ~vtkImageGrowCutSegment() override;
@@ -52,6 +74,7 @@ private:
   class vtkInternal;
   vtkInternal * Internal;
   double DistancePenalty;
+  int Algorithm;
 };
 
 #endif
@@ -0,0 +1,353 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkImageLabelIslands.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkObjectFactory.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+
+/// Number of slabs per thread that are labeled independently
+const int SLABS_PER_THREAD = 4;
+
+//----------------------------------------------------------------------------
+/// Union-find on runs. Parent of a run always has a lower index than the run,
+/// therefore the root of each tree is the first run of the island in raster order.
+class RunUnionFind
+{
+public:
+  RunUnionFind(vtkIdType* parents, const int* runStarts, const int* runEnds, const vtkIdType* rowFirstRun, int gap)
+    : Parents(parents)
+    , RunStarts(runStarts)
+    , RunEnds(runEnds)
+    , RowFirstRun(rowFirstRun)
+    , Gap(gap)
+  {
+  }
+
+  vtkIdType Find(vtkIdType run)
+  {
+    while (this->Parents[run] != run)
+      {
+      // path halving
+      this->Parents[run] = this->Parents[this->Parents[run]];
+      run = this->Parents[run];
+      }
+    return run;
+  }
+
+  void Union(vtkIdType run1, vtkIdType run2)
+  {
+    vtkIdType root1 = this->Find(run1);
+    vtkIdType root2 = this->Find(run2);
+    if (root1 < root2)
+      {
+      this->Parents[root2] = root1;
+      }
+    else if (root2 < root1)
+      {
+      this->Parents[root1] = root2;
+      }
+  }
+
+  /// Merge runs of two rows that touch each other.
+  /// Gap is 0 for face connectivity and 1 if runs that touch diagonally are connected, too.
+  void UnionRows(vtkIdType row1, vtkIdType row2)
+  {
+    vtkIdType run1 = this->RowFirstRun[row1];
+    vtkIdType run2 = this->RowFirstRun[row2];
+    const vtkIdType lastRun1 = this->RowFirstRun[row1 + 1];
+    const vtkIdType lastRun2 = this->RowFirstRun[row2 + 1];
+    while (run1 < lastRun1 && run2 < lastRun2)
+      {
+      if (this->RunStarts[run1] <= this->RunEnds[run2] + this->Gap
+        && this->RunStarts[run2] <= this->RunEnds[run1] + this->Gap)
+        {
+        this->Union(run1, run2);
+        }
+      // advance the run that ends first
+      if (this->RunEnds[run1] < this->RunEnds[run2])
+        {
+        ++run1;
+        }
+      else
+        {
+        ++run2;
+        }
+      }
+  }
+
+protected:
+  vtkIdType* Parents;
+  const int* RunStarts;
+  const int* RunEnds;
+  const vtkIdType* RowFirstRun;
+  int Gap;
+};
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkImageLabelIslands);
+
+//----------------------------------------------------------------------------
+vtkImageLabelIslands::vtkImageLabelIslands() = default;
+
+//----------------------------------------------------------------------------
+vtkImageLabelIslands::~vtkImageLabelIslands() = default;
+
+//----------------------------------------------------------------------------
+void vtkImageLabelIslands::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "FullyConnected: " << (this->FullyConnected ? "true" : "false") << "\n";
+  os << indent << "MinimumSize: " << this->MinimumSize << "\n";
+  os << indent << "NumberOfIslands: " << this->NumberOfIslands << "\n";
+  os << indent << "OriginalNumberOfIslands: " << this->OriginalNumberOfIslands << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelIslands::GetLabelMargins(int inputMargin[3], int outputMargin[3])
+{
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    inputMargin[axis] = 0;
+    outputMargin[axis] = 0;
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelIslands::GetOutputScalarType()
+{
+  return VTK_UNSIGNED_INT;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelIslands::ClearResults()
+{
+  this->NumberOfIslands = 0;
+  this->OriginalNumberOfIslands = 0;
+  this->IslandSizes.clear();
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkImageLabelIslands::GetIslandSize(int islandLabelValue)
+{
+  if (islandLabelValue < 1 || islandLabelValue > static_cast<int>(this->IslandSizes.size()))
+    {
+    return 0;
+    }
+  return this->IslandSizes[islandLabelValue - 1];
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageLabelIslands::ProcessMask(const int maskExtent[6], vtkImageData* output, const int outputExtent[6])
+{
+  const int dimensions[3] =
+    {
+    maskExtent[1] - maskExtent[0] + 1,
+    maskExtent[3] - maskExtent[2] + 1,
+    maskExtent[5] - maskExtent[4] + 1
+    };
+  const vtkIdType numberOfRows = static_cast<vtkIdType>(dimensions[1]) * dimensions[2];
+  const unsigned char* mask = this->Mask.data();
+
+  // Extract runs of foreground voxels from each row
+  this->RowFirstRun.resize(numberOfRows + 1);
+  vtkIdType* rowFirstRun = this->RowFirstRun.data();
+  rowFirstRun[0] = 0;
+  vtkSMPTools::For(0, numberOfRows, [&](vtkIdType firstRow, vtkIdType lastRow)
+    {
+    for (vtkIdType row = firstRow; row < lastRow; ++row)
+      {
+      const unsigned char* maskRow = mask + row * dimensions[0];
+      vtkIdType numberOfRuns = 0;
+      for (int i = 0; i < dimensions[0]; ++i)
+        {
+        if (maskRow[i] && (i == 0 || !maskRow[i - 1]))
+          {
+          ++numberOfRuns;
+          }
+        }
+      rowFirstRun[row + 1] = numberOfRuns;
+      }
+    });
+  std::partial_sum(rowFirstRun, rowFirstRun + numberOfRows + 1, rowFirstRun);
+  const vtkIdType numberOfRuns = rowFirstRun[numberOfRows];
+  if (static_cast<vtkIdType>(this->RunStarts.size()) < numberOfRuns)
+    {
+    this->RunStarts.resize(numberOfRuns);
+    this->RunEnds.resize(numberOfRuns);
+    this->RunParents.resize(numberOfRuns);
+    }
+  int* runStarts = this->RunStarts.data();
+  int* runEnds = this->RunEnds.data();
+  vtkIdType* runParents = this->RunParents.data();
+  vtkSMPTools::For(0, numberOfRows, [&](vtkIdType firstRow, vtkIdType lastRow)
+    {
+    for (vtkIdType row = firstRow; row < lastRow; ++row)
+      {
+      const unsigned char* maskRow = mask + row * dimensions[0];
+      vtkIdType run = rowFirstRun[row];
+      for (int i = 0; i < dimensions[0]; ++i)
+        {
+        if (!maskRow[i])
+          {
+          continue;
+          }
+        runStarts[run] = i;
+        while (i + 1 < dimensions[0] && maskRow[i + 1])
+          {
+          ++i;
+          }
+        runEnds[run] = i;
+        runParents[run] = run;
+        ++run;
+        }
+      }
+    });
+
+  // Connect runs within slabs of slices in parallel. Runs of different slabs are not connected
+  // in this step, therefore each thread only modifies parents of runs in its own slab.
+  const int gap = (this->FullyConnected ? 1 : 0);
+  const int numberOfSlabs = std::max(1, std::min(dimensions[2], SLABS_PER_THREAD * vtkSMPTools::GetEstimatedNumberOfThreads()));
+  auto slabStartSlice = [&](int slab) { return static_cast<int>(static_cast<vtkIdType>(slab) * dimensions[2] / numberOfSlabs); };
+  auto connectRowToPreviousSlice = [&](RunUnionFind& unionFind, int j, int k)
+    {
+    const vtkIdType row = static_cast<vtkIdType>(k) * dimensions[1] + j;
+    unionFind.UnionRows(row, row - dimensions[1]);
+    if (this->FullyConnected)
+      {
+      if (j > 0)
+        {
+        unionFind.UnionRows(row, row - dimensions[1] - 1);
+        }
+      if (j + 1 < dimensions[1])
+        {
+        unionFind.UnionRows(row, row - dimensions[1] + 1);
+        }
+      }
+    };
+  vtkSMPTools::For(0, numberOfSlabs, 1, [&](vtkIdType firstSlab, vtkIdType lastSlab)
+    {
+    RunUnionFind unionFind(runParents, runStarts, runEnds, rowFirstRun, gap);
+    for (vtkIdType slab = firstSlab; slab < lastSlab; ++slab)
+      {
+      const int firstSlice = slabStartSlice(static_cast<int>(slab));
+      const int lastSlice = slabStartSlice(static_cast<int>(slab) + 1);
+      for (int k = firstSlice; k < lastSlice; ++k)
+        {
+        for (int j = 0; j < dimensions[1]; ++j)
+          {
+          const vtkIdType row = static_cast<vtkIdType>(k) * dimensions[1] + j;
+          if (rowFirstRun[row] == rowFirstRun[row + 1])
+            {
+            continue;
+            }
+          if (j > 0)
+            {
+            unionFind.UnionRows(row, row - 1);
+            }
+          if (k > firstSlice)
+            {
+            connectRowToPreviousSlice(unionFind, j, k);
+            }
+          }
+        }
+      }
+    });
+
+  // Connect runs across slab boundaries
+  RunUnionFind unionFind(runParents, runStarts, runEnds, rowFirstRun, gap);
+  for (int slab = 1; slab < numberOfSlabs; ++slab)
+    {
+    const int k = slabStartSlice(slab);
+    if (k <= slabStartSlice(slab - 1))
+      {
+      // empty slab
+      continue;
+      }
+    for (int j = 0; j < dimensions[1]; ++j)
+      {
+      connectRowToPreviousSlice(unionFind, j, k);
+      }
+    }
+
+  // Replace parent of each run by its island index. Islands are indexed in raster order of their first voxel.
+  // The parent of a run always precedes the run, therefore it has already been replaced by the island index.
+  std::vector<vtkIdType> islandSizes;
+  for (vtkIdType run = 0; run < numberOfRuns; ++run)
+    {
+    if (runParents[run] == run)
+      {
+      runParents[run] = static_cast<vtkIdType>(islandSizes.size());
+      islandSizes.push_back(0);
+      }
+    else
+      {
+      runParents[run] = runParents[runParents[run]];
+      }
+    islandSizes[runParents[run]] += runEnds[run] - runStarts[run] + 1;
+    }
+  this->OriginalNumberOfIslands = static_cast<int>(islandSizes.size());
+
+  // Sort islands by size (larger first) and remove small islands
+  std::vector<vtkIdType> sortedIslands(islandSizes.size());
+  std::iota(sortedIslands.begin(), sortedIslands.end(), 0);
+  std::stable_sort(sortedIslands.begin(), sortedIslands.end(),
+    [&islandSizes](vtkIdType island1, vtkIdType island2) { return islandSizes[island1] > islandSizes[island2]; });
+  std::vector<unsigned int> islandLabelValues(islandSizes.size(), 0);
+  for (vtkIdType islandRank = 0; islandRank < static_cast<vtkIdType>(sortedIslands.size()); ++islandRank)
+    {
+    const vtkIdType islandSize = islandSizes[sortedIslands[islandRank]];
+    if (islandSize < this->MinimumSize)
+      {
+      break;
+      }
+    islandLabelValues[sortedIslands[islandRank]] = static_cast<unsigned int>(islandRank + 1);
+    this->IslandSizes.push_back(islandSize);
+    }
+  this->NumberOfIslands = static_cast<int>(this->IslandSizes.size());
+
+  // Write island label values into the output
+  vtkIdType outputIncrements[3] = { 0, 0, 0 };
+  output->GetIncrements(outputIncrements);
+  unsigned int* outputBasePtr = static_cast<unsigned int*>(output->GetScalarPointerForExtent(const_cast<int*>(outputExtent)));
+  vtkSMPTools::For(0, numberOfRows, [&](vtkIdType firstRow, vtkIdType lastRow)
+    {
+    for (vtkIdType row = firstRow; row < lastRow; ++row)
+      {
+      const vtkIdType j = row % dimensions[1];
+      const vtkIdType k = row / dimensions[1];
+      unsigned int* outputRow = outputBasePtr + k * outputIncrements[2] + j * outputIncrements[1];
+      for (vtkIdType run = rowFirstRun[row]; run < rowFirstRun[row + 1]; ++run)
+        {
+        std::fill(outputRow + runStarts[run], outputRow + runEnds[run] + 1, islandLabelValues[runParents[run]]);
+        }
+      }
+    });
+
+  return true;
+}
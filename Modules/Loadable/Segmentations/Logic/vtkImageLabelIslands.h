@@ -0,0 +1,85 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef vtkImageLabelIslands_h
+#define vtkImageLabelIslands_h
+
+#include "vtkImageLabelOperation.h"
+
+/// \brief Find connected components (islands) of a single label of a labelmap.
+///
+/// Output is an unsigned int labelmap, where each island has a different label value.
+/// Islands are sorted by size: label value 1 is the largest island. Islands that contain
+/// less voxels than MinimumSize are removed. Equal-sized islands are sorted by their
+/// first voxel in raster order. The result is the same as computed by vtkITKIslandMath.
+///
+/// Connected runs of foreground voxels are extracted from image rows and merged using
+/// union-find. Slabs of slices are labeled in parallel and then merged across the slab boundaries.
+class VTK_SLICER_SEGMENTATIONS_LOGIC_EXPORT vtkImageLabelIslands : public vtkImageLabelOperation
+{
+public:
+  static vtkImageLabelIslands* New();
+  vtkTypeMacro(vtkImageLabelIslands, vtkImageLabelOperation);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// If enabled then voxels that share only an edge or a corner are connected (26-connectivity).
+  /// If disabled (default) then only voxels that share a face are connected (6-connectivity).
+  vtkSetMacro(FullyConnected, bool);
+  vtkGetMacro(FullyConnected, bool);
+  vtkBooleanMacro(FullyConnected, bool);
+
+  /// Islands that have fewer voxels than this value are removed from the output.
+  vtkSetMacro(MinimumSize, vtkIdType);
+  vtkGetMacro(MinimumSize, vtkIdType);
+
+  /// Number of islands in the output (computed by Execute)
+  vtkGetMacro(NumberOfIslands, int);
+
+  /// Number of islands before removing small islands (computed by Execute)
+  vtkGetMacro(OriginalNumberOfIslands, int);
+
+  /// Number of voxels in the specified island (label value of the island in the output).
+  /// Returns 0 if the island does not exist.
+  vtkIdType GetIslandSize(int islandLabelValue);
+
+protected:
+  vtkImageLabelIslands();
+  ~vtkImageLabelIslands() override;
+
+  void GetLabelMargins(int inputMargin[3], int outputMargin[3]) override;
+  int GetOutputScalarType() override;
+  void ClearResults() override;
+  bool ProcessMask(const int maskExtent[6], vtkImageData* output, const int outputExtent[6]) override;
+
+  bool FullyConnected{ false };
+  vtkIdType MinimumSize{ 0 };
+  int NumberOfIslands{ 0 };
+  int OriginalNumberOfIslands{ 0 };
+  std::vector<vtkIdType> IslandSizes;
+
+  /// Working buffers, kept between executions
+  std::vector<int> RunStarts;
+  std::vector<int> RunEnds;
+  std::vector<vtkIdType> RowFirstRun;
+  std::vector<vtkIdType> RunParents;
+
+private:
+  vtkImageLabelIslands(const vtkImageLabelIslands&) = delete;
+  void operator=(const vtkImageLabelIslands&) = delete;
+};
+
+#endif
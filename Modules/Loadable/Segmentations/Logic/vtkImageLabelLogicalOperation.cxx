@@ -0,0 +1,547 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkImageLabelLogicalOperation.h"
+
+// vtkSegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageConstantPad.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <array>
+#include <set>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+bool IsExtentEmpty(const int extent[6])
+{
+  return extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5];
+}
+
+//----------------------------------------------------------------------------
+void GetExtentIntersection(const int extentA[6], const int extentB[6], int extentIntersection[6])
+{
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    extentIntersection[axis * 2] = std::max(extentA[axis * 2], extentB[axis * 2]);
+    extentIntersection[axis * 2 + 1] = std::min(extentA[axis * 2 + 1], extentB[axis * 2 + 1]);
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Bounding box of two extents. Empty extents are ignored.
+void GetExtentUnion(const int extentA[6], const int extentB[6], int extentUnion[6])
+{
+  if (IsExtentEmpty(extentA))
+    {
+    std::copy(extentB, extentB + 6, extentUnion);
+    return;
+    }
+  if (IsExtentEmpty(extentB))
+    {
+    std::copy(extentA, extentA + 6, extentUnion);
+    return;
+    }
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    extentUnion[axis * 2] = std::min(extentA[axis * 2], extentB[axis * 2]);
+    extentUnion[axis * 2 + 1] = std::max(extentA[axis * 2 + 1], extentB[axis * 2 + 1]);
+    }
+}
+
+//----------------------------------------------------------------------------
+bool HasScalars(vtkImageData* image)
+{
+  return image && image->GetPointData() && image->GetPointData()->GetScalars()
+    && image->GetPointData()->GetScalars()->GetNumberOfTuples() > 0;
+}
+
+//----------------------------------------------------------------------------
+/// Table of modifier label values. Lookup is a single range check and table access,
+/// independently from the number of label values.
+struct ModifierLabelTable
+{
+  long long MinimumValue{ 0 };
+  std::vector<unsigned char> Table;
+
+  explicit ModifierLabelTable(const std::vector<int>& labelValues)
+  {
+    if (labelValues.empty())
+      {
+      return;
+      }
+    auto range = std::minmax_element(labelValues.begin(), labelValues.end());
+    this->MinimumValue = *range.first;
+    this->Table.resize(static_cast<size_t>(*range.second - *range.first + 1), 0);
+    for (int labelValue : labelValues)
+      {
+      this->Table[labelValue - this->MinimumValue] = 1;
+      }
+  }
+
+  template <class M>
+  bool Contains(M value) const
+  {
+    const long long index = static_cast<long long>(value) - this->MinimumValue;
+    return index >= 0 && index < static_cast<long long>(this->Table.size()) && this->Table[index] != 0;
+  }
+};
+
+//----------------------------------------------------------------------------
+/// Parameters of one pass over the labelmap
+struct LogicalOperationPass
+{
+  int Operation{ vtkImageLabelLogicalOperation::OperationUnion };
+  int LabelValue{ 1 };
+  /// Voxels that are processed
+  int ProcessedExtent[6]{ 0, -1, 0, -1, 0, -1 };
+  /// Region of the invert operation
+  int InvertExtent[6]{ 0, -1, 0, -1, 0, -1 };
+  /// If false then the voxels are only classified, the labelmap is not modified.
+  /// Voxels outside the labelmap extent are treated as empty.
+  bool Modify{ false };
+
+  // Results
+  vtkIdType NumberOfConflictingVoxels{ 0 };
+  vtkIdType NumberOfModifiedVoxels{ 0 };
+  /// Bounding extent of voxels where the label is set
+  int LabelSetExtent[6]{ 0, -1, 0, -1, 0, -1 };
+  /// Other label values in voxels where the label is set
+  std::set<int> OverwrittenLabelValues;
+};
+
+//----------------------------------------------------------------------------
+struct SliceResult
+{
+  vtkIdType NumberOfConflictingVoxels{ 0 };
+  vtkIdType NumberOfModifiedVoxels{ 0 };
+  std::array<int, 6> LabelSetExtent{ { VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN } };
+  std::set<int> OverwrittenLabelValues;
+};
+
+//----------------------------------------------------------------------------
+template <class T, class M>
+void vtkImageLabelLogicalOperationProcess(vtkImageData* labelmap, vtkImageData* modifierLabelmap,
+  const ModifierLabelTable& modifierLabels, LogicalOperationPass& pass)
+{
+  const int* processedExtent = pass.ProcessedExtent;
+  if (IsExtentEmpty(processedExtent))
+    {
+    return;
+    }
+
+  int labelmapExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  if (HasScalars(labelmap))
+    {
+    labelmap->GetExtent(labelmapExtent);
+    }
+  int modifierExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  if (modifierLabelmap && HasScalars(modifierLabelmap))
+    {
+    modifierLabelmap->GetExtent(modifierExtent);
+    }
+  const int* invertExtent = pass.InvertExtent;
+
+  const int operation = pass.Operation;
+  const T labelValue = static_cast<T>(pass.LabelValue);
+  const bool modify = pass.Modify;
+
+  const int numberOfSlices = processedExtent[5] - processedExtent[4] + 1;
+  std::vector<SliceResult> sliceResults(numberOfSlices);
+  vtkSMPTools::For(0, numberOfSlices, [&](vtkIdType firstSlice, vtkIdType lastSlice)
+    {
+    for (vtkIdType slice = firstSlice; slice < lastSlice; ++slice)
+      {
+      SliceResult& result = sliceResults[slice];
+      const int k = processedExtent[4] + static_cast<int>(slice);
+      for (int j = processedExtent[2]; j <= processedExtent[3]; ++j)
+        {
+        const bool rowInLabelmap = (j >= labelmapExtent[2] && j <= labelmapExtent[3] && k >= labelmapExtent[4] && k <= labelmapExtent[5]);
+        const bool rowInModifier = (j >= modifierExtent[2] && j <= modifierExtent[3] && k >= modifierExtent[4] && k <= modifierExtent[5]);
+        const bool rowInInvertExtent = (j >= invertExtent[2] && j <= invertExtent[3] && k >= invertExtent[4] && k <= invertExtent[5]);
+        if (modify && !rowInLabelmap)
+          {
+          continue;
+          }
+        T* labelmapRowPtr = rowInLabelmap ? static_cast<T*>(labelmap->GetScalarPointer(labelmapExtent[0], j, k)) : nullptr;
+        const M* modifierRowPtr = rowInModifier ? static_cast<M*>(modifierLabelmap->GetScalarPointer(modifierExtent[0], j, k)) : nullptr;
+        for (int i = processedExtent[0]; i <= processedExtent[1]; ++i)
+          {
+          const bool inLabelmap = rowInLabelmap && i >= labelmapExtent[0] && i <= labelmapExtent[1];
+          if (modify && !inLabelmap)
+            {
+            continue;
+            }
+          const T value = inLabelmap ? labelmapRowPtr[i - labelmapExtent[0]] : static_cast<T>(0);
+          bool setLabel = false;
+          bool clearLabel = false;
+          switch (operation)
+            {
+            case vtkImageLabelLogicalOperation::OperationUnion:
+              setLabel = (value != labelValue && rowInModifier && i >= modifierExtent[0] && i <= modifierExtent[1]
+                && modifierLabels.Contains(modifierRowPtr[i - modifierExtent[0]]));
+              break;
+            case vtkImageLabelLogicalOperation::OperationSubtract:
+              clearLabel = (value == labelValue && rowInModifier && i >= modifierExtent[0] && i <= modifierExtent[1]
+                && modifierLabels.Contains(modifierRowPtr[i - modifierExtent[0]]));
+              break;
+            case vtkImageLabelLogicalOperation::OperationIntersect:
+              clearLabel = (value == labelValue && !(rowInModifier && i >= modifierExtent[0] && i <= modifierExtent[1]
+                && modifierLabels.Contains(modifierRowPtr[i - modifierExtent[0]])));
+              break;
+            case vtkImageLabelLogicalOperation::OperationInvert:
+              if (value == labelValue)
+                {
+                clearLabel = true;
+                }
+              else
+                {
+                setLabel = (rowInInvertExtent && i >= invertExtent[0] && i <= invertExtent[1]);
+                }
+              break;
+            default:
+              break;
+            }
+          if (setLabel)
+            {
+            if (value != 0)
+              {
+              ++result.NumberOfConflictingVoxels;
+              result.OverwrittenLabelValues.insert(static_cast<int>(value));
+              }
+            std::array<int, 6>& setExtent = result.LabelSetExtent;
+            setExtent[0] = std::min(setExtent[0], i);
+            setExtent[1] = std::max(setExtent[1], i);
+            setExtent[2] = std::min(setExtent[2], j);
+            setExtent[3] = std::max(setExtent[3], j);
+            setExtent[4] = std::min(setExtent[4], k);
+            setExtent[5] = std::max(setExtent[5], k);
+            if (modify)
+              {
+              labelmapRowPtr[i - labelmapExtent[0]] = labelValue;
+              ++result.NumberOfModifiedVoxels;
+              }
+            }
+          else if (clearLabel && modify)
+            {
+            labelmapRowPtr[i - labelmapExtent[0]] = 0;
+            ++result.NumberOfModifiedVoxels;
+            }
+          }
+        }
+      }
+    });
+
+  pass.NumberOfConflictingVoxels = 0;
+  pass.NumberOfModifiedVoxels = 0;
+  pass.OverwrittenLabelValues.clear();
+  int setExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  for (const SliceResult& result : sliceResults)
+    {
+    pass.NumberOfConflictingVoxels += result.NumberOfConflictingVoxels;
+    pass.NumberOfModifiedVoxels += result.NumberOfModifiedVoxels;
+    pass.OverwrittenLabelValues.insert(result.OverwrittenLabelValues.begin(), result.OverwrittenLabelValues.end());
+    GetExtentUnion(setExtent, result.LabelSetExtent.data(), setExtent);
+    }
+  std::copy(setExtent, setExtent + 6, pass.LabelSetExtent);
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+bool vtkImageLabelLogicalOperationDispatchModifier(vtkImageData* labelmap, vtkImageData* modifierLabelmap,
+  const ModifierLabelTable& modifierLabels, LogicalOperationPass& pass)
+{
+  if (!modifierLabelmap || !HasScalars(modifierLabelmap))
+    {
+    vtkImageLabelLogicalOperationProcess<T, T>(labelmap, nullptr, modifierLabels, pass);
+    return true;
+    }
+  switch (modifierLabelmap->GetScalarType())
+    {
+    // Parentheses are needed because of the comma in the template argument list
+    vtkTemplateMacro((vtkImageLabelLogicalOperationProcess<T, VTK_TT>(labelmap, modifierLabelmap, modifierLabels, pass)));
+    default:
+      return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkImageLabelLogicalOperation);
+
+//----------------------------------------------------------------------------
+vtkImageLabelLogicalOperation::vtkImageLabelLogicalOperation() = default;
+
+//----------------------------------------------------------------------------
+vtkImageLabelLogicalOperation::~vtkImageLabelLogicalOperation()
+{
+  this->SetLabelmap(nullptr);
+  this->SetModifierLabelmap(nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelLogicalOperation::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Operation: " << this->Operation << "\n";
+  os << indent << "Labelmap: " << this->Labelmap << "\n";
+  os << indent << "LabelValue: " << this->LabelValue << "\n";
+  os << indent << "ModifierLabelmap: " << this->ModifierLabelmap << "\n";
+  os << indent << "ModifierLabelValues:";
+  for (int labelValue : this->ModifierLabelValues)
+    {
+    os << " " << labelValue;
+    }
+  os << "\n";
+  os << indent << "Extent: " << this->Extent[0] << ", " << this->Extent[1] << ", " << this->Extent[2]
+    << ", " << this->Extent[3] << ", " << this->Extent[4] << ", " << this->Extent[5] << "\n";
+  os << indent << "OverwriteOtherLabels: " << (this->OverwriteOtherLabels ? "true" : "false") << "\n";
+  os << indent << "NumberOfConflictingVoxels: " << this->NumberOfConflictingVoxels << "\n";
+  os << indent << "NumberOfModifiedVoxels: " << this->NumberOfModifiedVoxels << "\n";
+  os << indent << "OverwrittenLabelValues:";
+  for (int labelValue : this->OverwrittenLabelValues)
+    {
+    os << " " << labelValue;
+    }
+  os << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelLogicalOperation::AddModifierLabelValue(int labelValue)
+{
+  if (std::find(this->ModifierLabelValues.begin(), this->ModifierLabelValues.end(), labelValue) != this->ModifierLabelValues.end())
+    {
+    return;
+    }
+  this->ModifierLabelValues.push_back(labelValue);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelLogicalOperation::RemoveAllModifierLabelValues()
+{
+  if (this->ModifierLabelValues.empty())
+    {
+    return;
+    }
+  this->ModifierLabelValues.clear();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelLogicalOperation::GetNumberOfModifierLabelValues()
+{
+  return static_cast<int>(this->ModifierLabelValues.size());
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelLogicalOperation::GetNumberOfOverwrittenLabelValues()
+{
+  return static_cast<int>(this->OverwrittenLabelValues.size());
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelLogicalOperation::GetNthOverwrittenLabelValue(int index)
+{
+  if (index < 0 || index >= static_cast<int>(this->OverwrittenLabelValues.size()))
+    {
+    vtkErrorMacro("GetNthOverwrittenLabelValue: index " << index << " is out of range");
+    return 0;
+    }
+  return this->OverwrittenLabelValues[index];
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageLabelLogicalOperation::Execute()
+{
+  this->NumberOfConflictingVoxels = 0;
+  this->NumberOfModifiedVoxels = 0;
+  this->OverwrittenLabelValues.clear();
+  if (!this->Labelmap)
+    {
+    vtkErrorMacro("Execute: invalid labelmap");
+    return false;
+    }
+  if (this->LabelValue == 0)
+    {
+    vtkErrorMacro("Execute: label value must not be 0");
+    return false;
+    }
+  const bool labelmapEmpty = !HasScalars(this->Labelmap);
+  const bool modifierEmpty = !this->ModifierLabelmap || !HasScalars(this->ModifierLabelmap) || this->ModifierLabelValues.empty();
+  if (this->Operation != OperationInvert)
+    {
+    if (!this->ModifierLabelmap)
+      {
+      vtkErrorMacro("Execute: invalid modifier labelmap");
+      return false;
+      }
+    if (!modifierEmpty && !labelmapEmpty
+      && !vtkOrientedImageDataResample::DoGeometriesMatch(this->Labelmap, this->ModifierLabelmap))
+      {
+      vtkErrorMacro("Execute: geometry of the labelmap and the modifier labelmap must match");
+      return false;
+      }
+    }
+
+  LogicalOperationPass pass;
+  pass.Operation = this->Operation;
+  pass.LabelValue = this->LabelValue;
+  int labelmapExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  if (!labelmapEmpty)
+    {
+    this->Labelmap->GetExtent(labelmapExtent);
+    }
+  int modifierExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  if (!modifierEmpty)
+    {
+    this->ModifierLabelmap->GetExtent(modifierExtent);
+    }
+  switch (this->Operation)
+    {
+    case OperationUnion:
+      // Only voxels of the modifier region may change
+      std::copy(modifierExtent, modifierExtent + 6, pass.ProcessedExtent);
+      break;
+    case OperationSubtract:
+      GetExtentIntersection(labelmapExtent, modifierExtent, pass.ProcessedExtent);
+      break;
+    case OperationIntersect:
+      std::copy(labelmapExtent, labelmapExtent + 6, pass.ProcessedExtent);
+      break;
+    case OperationInvert:
+      if (IsExtentEmpty(this->Extent))
+        {
+        std::copy(labelmapExtent, labelmapExtent + 6, pass.InvertExtent);
+        }
+      else
+        {
+        std::copy(this->Extent, this->Extent + 6, pass.InvertExtent);
+        }
+      GetExtentUnion(labelmapExtent, pass.InvertExtent, pass.ProcessedExtent);
+      break;
+    default:
+      vtkErrorMacro("Execute: invalid operation " << this->Operation);
+      return false;
+    }
+  if (IsExtentEmpty(pass.ProcessedExtent))
+    {
+    // Nothing to do
+    return true;
+    }
+
+  if (labelmapEmpty && !this->Labelmap->GetPointData()->GetScalars())
+    {
+    // Labelmap has no scalars yet, use the modifier labelmap scalar type
+    // (or the smallest type that can store the label value).
+    int scalarType = VTK_UNSIGNED_CHAR;
+    if (this->Operation != OperationInvert && this->ModifierLabelmap->GetPointData()->GetScalars())
+      {
+      scalarType = this->ModifierLabelmap->GetScalarType();
+      }
+    else if (this->LabelValue < 0 || this->LabelValue > VTK_UNSIGNED_CHAR_MAX)
+      {
+      scalarType = VTK_SHORT;
+      }
+    this->Labelmap->SetExtent(0, -1, 0, -1, 0, -1);
+    this->Labelmap->AllocateScalars(scalarType, 1);
+    }
+
+  // Classify the voxels: find conflicts and the region where the label is set
+  pass.Modify = false;
+  bool success = false;
+  switch (this->Labelmap->GetScalarType())
+    {
+    vtkTemplateMacro(success = vtkImageLabelLogicalOperationDispatchModifier<VTK_TT>(
+      this->Labelmap, this->Operation == OperationInvert ? nullptr : this->ModifierLabelmap,
+      ModifierLabelTable(this->ModifierLabelValues), pass));
+    default:
+      success = false;
+    }
+  if (!success)
+    {
+    vtkErrorMacro("Execute: unsupported scalar type");
+    return false;
+    }
+  this->NumberOfConflictingVoxels = pass.NumberOfConflictingVoxels;
+  this->OverwrittenLabelValues.assign(pass.OverwrittenLabelValues.begin(), pass.OverwrittenLabelValues.end());
+  if (pass.NumberOfConflictingVoxels > 0 && !this->OverwriteOtherLabels)
+    {
+    // Voxels would be overwritten, labelmap is not modified
+    return false;
+    }
+
+  // Make sure that all voxels where the label is set are within the labelmap
+  int requiredExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  GetExtentUnion(labelmapExtent, pass.LabelSetExtent, requiredExtent);
+  if (!IsExtentEmpty(requiredExtent) && !std::equal(requiredExtent, requiredExtent + 6, labelmapExtent))
+    {
+    if (labelmapEmpty)
+      {
+      if (this->Operation != OperationInvert)
+        {
+        // Labelmap has no valid geometry, use the modifier geometry
+        vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+        this->ModifierLabelmap->GetImageToWorldMatrix(imageToWorldMatrix);
+        this->Labelmap->SetGeometryFromImageToWorldMatrix(imageToWorldMatrix);
+        }
+      int scalarType = this->Labelmap->GetScalarType();
+      this->Labelmap->SetExtent(requiredExtent);
+      this->Labelmap->AllocateScalars(scalarType, 1);
+      vtkOrientedImageDataResample::FillImage(this->Labelmap, 0);
+      }
+    else
+      {
+      vtkNew<vtkImageConstantPad> padder;
+      padder->SetInputData(this->Labelmap);
+      padder->SetOutputWholeExtent(requiredExtent);
+      padder->SetConstant(0);
+      padder->Update();
+      // Directions are kept by ShallowCopy, as the padded image is not oriented
+      this->Labelmap->ShallowCopy(padder->GetOutput());
+      }
+    }
+
+  // Apply the operation
+  pass.Modify = true;
+  switch (this->Labelmap->GetScalarType())
+    {
+    vtkTemplateMacro(vtkImageLabelLogicalOperationDispatchModifier<VTK_TT>(
+      this->Labelmap, this->Operation == OperationInvert ? nullptr : this->ModifierLabelmap,
+      ModifierLabelTable(this->ModifierLabelValues), pass));
+    }
+  this->NumberOfModifiedVoxels = pass.NumberOfModifiedVoxels;
+  if (this->NumberOfModifiedVoxels > 0)
+    {
+    this->Labelmap->Modified();
+    }
+  return true;
+}
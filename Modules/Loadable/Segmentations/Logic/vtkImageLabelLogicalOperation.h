@@ -0,0 +1,141 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef vtkImageLabelLogicalOperation_h
+#define vtkImageLabelLogicalOperation_h
+
+#include "vtkSlicerSegmentationsModuleLogicExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <vector>
+
+class vtkOrientedImageData;
+
+/// \brief Apply a logical operation on a label of a labelmap, in place.
+///
+/// The labelmap is typically a (shared) binary labelmap layer of a segmentation, where each segment
+/// is stored with a different label value. The modifier region is the union of one or more label values
+/// of the modifier labelmap, which may be the same labelmap (segments in the same layer) or another
+/// labelmap with the same geometry (segments in a different layer). Label values are looked up in a
+/// table, therefore the number of modifier labels does not affect the speed of the operation.
+///
+/// No intermediate binary labelmaps are created and no resampling is performed. Voxels are processed
+/// in parallel. The labelmap is padded if the result extends beyond its extent (union and invert).
+///
+/// Operations:
+/// - Union: modifier region is added to the label.
+/// - Intersect: label is removed outside the modifier region.
+/// - Subtract: label is removed inside the modifier region.
+/// - Invert: label is set in the empty voxels and removed from the label voxels in the Extent
+///   (and removed outside the Extent).
+///
+/// Each voxel stores a single label, therefore other labels have to be overwritten if the label is set
+/// in their voxels (union and invert). If OverwriteOtherLabels is disabled and this would be needed then
+/// the labelmap is not modified and Execute returns false.
+class VTK_SLICER_SEGMENTATIONS_LOGIC_EXPORT vtkImageLabelLogicalOperation : public vtkObject
+{
+public:
+  static vtkImageLabelLogicalOperation* New();
+  vtkTypeMacro(vtkImageLabelLogicalOperation, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  enum
+    {
+    OperationUnion,
+    OperationIntersect,
+    OperationSubtract,
+    OperationInvert,
+    Operation_Last // must be last
+    };
+
+  /// Logical operation. Default is OperationUnion.
+  vtkSetClampMacro(Operation, int, OperationUnion, Operation_Last - 1);
+  vtkGetMacro(Operation, int);
+  void SetOperationToUnion() { this->SetOperation(OperationUnion); }
+  void SetOperationToIntersect() { this->SetOperation(OperationIntersect); }
+  void SetOperationToSubtract() { this->SetOperation(OperationSubtract); }
+  void SetOperationToInvert() { this->SetOperation(OperationInvert); }
+
+  /// Labelmap that is modified. The first scalar component is used.
+  vtkSetObjectMacro(Labelmap, vtkOrientedImageData);
+  vtkGetObjectMacro(Labelmap, vtkOrientedImageData);
+
+  /// Label value that is modified in the labelmap
+  vtkSetMacro(LabelValue, int);
+  vtkGetMacro(LabelValue, int);
+
+  /// Labelmap that contains the modifier region. It may be the same object as Labelmap.
+  /// Geometry (origin, spacing, axis directions) must be the same as the labelmap, the extent may be different.
+  /// Not used by the invert operation.
+  vtkSetObjectMacro(ModifierLabelmap, vtkOrientedImageData);
+  vtkGetObjectMacro(ModifierLabelmap, vtkOrientedImageData);
+
+  /// Label values in the modifier labelmap that specify the modifier region
+  void AddModifierLabelValue(int labelValue);
+  void RemoveAllModifierLabelValues();
+  int GetNumberOfModifierLabelValues();
+
+  /// Region where the invert operation sets the label in empty voxels.
+  /// By default it is empty, which means that the extent of the labelmap is used.
+  vtkSetVector6Macro(Extent, int);
+  vtkGetVector6Macro(Extent, int);
+
+  /// Allow setting the label in voxels that contain other labels. Default is false.
+  vtkSetMacro(OverwriteOtherLabels, bool);
+  vtkGetMacro(OverwriteOtherLabels, bool);
+  vtkBooleanMacro(OverwriteOtherLabels, bool);
+
+  /// Apply the operation on the labelmap.
+  /// \return False if the inputs are invalid or if other labels would have to be overwritten but
+  ///   OverwriteOtherLabels is disabled. The labelmap is not modified if false is returned.
+  bool Execute();
+
+  /// Number of voxels that contain other labels and would be (or were) overwritten in the last execution
+  vtkGetMacro(NumberOfConflictingVoxels, vtkIdType);
+
+  /// Number of voxels changed in the last execution
+  vtkGetMacro(NumberOfModifiedVoxels, vtkIdType);
+
+  /// Other label values that would be (or were) overwritten in the last execution, in ascending order
+  int GetNumberOfOverwrittenLabelValues();
+  int GetNthOverwrittenLabelValue(int index);
+
+protected:
+  vtkImageLabelLogicalOperation();
+  ~vtkImageLabelLogicalOperation() override;
+
+  int Operation{ OperationUnion };
+  vtkOrientedImageData* Labelmap{ nullptr };
+  int LabelValue{ 1 };
+  vtkOrientedImageData* ModifierLabelmap{ nullptr };
+  std::vector<int> ModifierLabelValues;
+  int Extent[6]{ 0, -1, 0, -1, 0, -1 };
+  bool OverwriteOtherLabels{ false };
+
+  vtkIdType NumberOfConflictingVoxels{ 0 };
+  vtkIdType NumberOfModifiedVoxels{ 0 };
+  std::vector<int> OverwrittenLabelValues;
+
+private:
+  vtkImageLabelLogicalOperation(const vtkImageLabelLogicalOperation&) = delete;
+  void operator=(const vtkImageLabelLogicalOperation&) = delete;
+};
+
+#endif
@@ -0,0 +1,350 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkImageLabelMargin.h"
+#include "SquaredDistanceTransform.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkObjectFactory.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+//----------------------------------------------------------------------------
+/// Distances of a label. Foreground voxels are all within LabelExtent, therefore distance of
+/// background voxels can be computed in any region that contains LabelExtent and distance of
+/// foreground voxels only requires LabelExtent padded by one voxel (nearest background voxel
+/// is always in this region).
+struct vtkImageLabelMarginDistanceMap
+{
+  /// Geometry of the labelmap that the distances were computed for
+  int WholeExtent[6]{ 0, -1, 0, -1, 0, -1 };
+  double Spacing[3]{ 1.0, 1.0, 1.0 };
+  /// Binary mask of the label in its bounding extent
+  int LabelExtent[6]{ 0, -1, 0, -1, 0, -1 };
+  std::vector<unsigned char> LabelMask;
+  /// Squared distance of background voxels from the nearest foreground voxel
+  int OutsideExtent[6]{ 0, -1, 0, -1, 0, -1 };
+  std::vector<float> OutsideSquaredDistances;
+  /// Squared distance of foreground voxels from the nearest background voxel
+  int InsideExtent[6]{ 0, -1, 0, -1, 0, -1 };
+  std::vector<float> InsideSquaredDistances;
+};
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+bool ExtentContains(const int extent[6], const int subExtent[6])
+{
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    if (subExtent[axis * 2] < extent[axis * 2] || subExtent[axis * 2 + 1] > extent[axis * 2 + 1])
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+/// Offset of voxel (i, j, k) in a buffer that stores the specified extent in x-fastest order
+vtkIdType GetOffset(const int extent[6], int i, int j, int k)
+{
+  return (i - extent[0]) + (extent[1] - extent[0] + 1)
+    * ((j - extent[2]) + static_cast<vtkIdType>(extent[3] - extent[2] + 1) * (k - extent[4]));
+}
+
+//----------------------------------------------------------------------------
+/// Compare (if copy is false) or copy (if copy is true) the region of the mask buffer
+/// that is inside labelExtent with the label mask. Returns true if the contents are equal.
+bool CompareOrCopyLabelMask(const unsigned char* mask, const int maskExtent[6],
+  std::vector<unsigned char>& labelMask, const int labelExtent[6], bool copy)
+{
+  const int rowLength = labelExtent[1] - labelExtent[0] + 1;
+  const vtkIdType numberOfVoxels = static_cast<vtkIdType>(rowLength)
+    * (labelExtent[3] - labelExtent[2] + 1) * (labelExtent[5] - labelExtent[4] + 1);
+  if (copy)
+    {
+    labelMask.resize(numberOfVoxels);
+    }
+  else if (static_cast<vtkIdType>(labelMask.size()) != numberOfVoxels)
+    {
+    return false;
+    }
+  for (int k = labelExtent[4]; k <= labelExtent[5]; ++k)
+    {
+    for (int j = labelExtent[2]; j <= labelExtent[3]; ++j)
+      {
+      const unsigned char* maskRow = mask + GetOffset(maskExtent, labelExtent[0], j, k);
+      unsigned char* labelMaskRow = labelMask.data() + GetOffset(labelExtent, labelExtent[0], j, k);
+      if (copy)
+        {
+        memcpy(labelMaskRow, maskRow, rowLength);
+        }
+      else if (memcmp(labelMaskRow, maskRow, rowLength) != 0)
+        {
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+/// Compute squared distance from the nearest voxel that has seedValue in the specified extent.
+/// Voxels outside the label extent are background.
+void ComputeLabelSquaredDistances(const vtkImageLabelMarginDistanceMap& distanceMap, const int extent[6],
+  unsigned char seedValue, std::vector<float>& squaredDistances)
+{
+  const int dimensions[3] = { extent[1] - extent[0] + 1, extent[3] - extent[2] + 1, extent[5] - extent[4] + 1 };
+  squaredDistances.resize(static_cast<vtkIdType>(dimensions[0]) * dimensions[1] * dimensions[2]);
+  const int* labelExtent = distanceMap.LabelExtent;
+  const float backgroundValue = (seedValue == 0 ? 0.0f : SQUARED_DISTANCE_INFINITE);
+  const float foregroundValue = (seedValue == 0 ? SQUARED_DISTANCE_INFINITE : 0.0f);
+  vtkSMPTools::For(extent[4], extent[5] + 1, [&](vtkIdType firstSlice, vtkIdType lastSlice)
+    {
+    for (int k = static_cast<int>(firstSlice); k < lastSlice; ++k)
+      {
+      for (int j = extent[2]; j <= extent[3]; ++j)
+        {
+        float* row = squaredDistances.data() + GetOffset(extent, extent[0], j, k);
+        std::fill(row, row + dimensions[0], backgroundValue);
+        if (j < labelExtent[2] || j > labelExtent[3] || k < labelExtent[4] || k > labelExtent[5])
+          {
+          continue;
+          }
+        const unsigned char* labelMaskRow = distanceMap.LabelMask.data() + GetOffset(labelExtent, labelExtent[0], j, k);
+        float* labelRow = row + (labelExtent[0] - extent[0]);
+        for (int i = 0; i <= labelExtent[1] - labelExtent[0]; ++i)
+          {
+          if (labelMaskRow[i])
+            {
+            labelRow[i] = foregroundValue;
+            }
+          }
+        }
+      }
+    });
+  const bool transformAxes[3] = { true, true, true };
+  ::ComputeSquaredDistances(squaredDistances.data(), dimensions, distanceMap.Spacing, transformAxes);
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkImageLabelMargin);
+
+//----------------------------------------------------------------------------
+vtkImageLabelMargin::vtkImageLabelMargin()
+  : InnerMarginSize(vtkMath::NegInf())
+{
+}
+
+//----------------------------------------------------------------------------
+vtkImageLabelMargin::~vtkImageLabelMargin() = default;
+
+//----------------------------------------------------------------------------
+void vtkImageLabelMargin::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "MarginSize: " << this->MarginSize << "\n";
+  os << indent << "InnerMarginSize: " << this->InnerMarginSize << "\n";
+  os << indent << "Number of cached distance maps: " << this->DistanceMaps.size() << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelMargin::ClearCache()
+{
+  this->DistanceMaps.clear();
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelMargin::ClearResults()
+{
+  this->DistanceMapReused = false;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelMargin::GetLabelMargins(int inputMargin[3], int outputMargin[3])
+{
+  double spacing[3] = { 1.0, 1.0, 1.0 };
+  if (this->Labelmap)
+    {
+    this->Labelmap->GetSpacing(spacing);
+    }
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    // Foreground voxels may be added within the margin distance
+    outputMargin[axis] = (this->MarginSize > 0 && spacing[axis] != 0.0 ?
+      static_cast<int>(ceil(this->MarginSize / fabs(spacing[axis]))) : 0);
+    // Nearest background voxel of a foreground voxel is either in the label extent or right next to it
+    inputMargin[axis] = std::max(outputMargin[axis], 1);
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkImageLabelMarginDistanceMap* vtkImageLabelMargin::GetDistanceMap(const int maskExtent[6])
+{
+  std::shared_ptr<vtkImageLabelMarginDistanceMap>& distanceMap = this->DistanceMaps[this->CurrentLabelValue];
+  int wholeExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  this->Labelmap->GetExtent(wholeExtent);
+  double spacing[3] = { 1.0, 1.0, 1.0 };
+  this->Labelmap->GetSpacing(spacing);
+  if (distanceMap
+    && std::equal(wholeExtent, wholeExtent + 6, distanceMap->WholeExtent)
+    && std::equal(spacing, spacing + 3, distanceMap->Spacing)
+    && std::equal(this->CurrentLabelExtent, this->CurrentLabelExtent + 6, distanceMap->LabelExtent)
+    && CompareOrCopyLabelMask(this->Mask.data(), maskExtent, distanceMap->LabelMask, this->CurrentLabelExtent, false))
+    {
+    // label has not changed
+    return distanceMap.get();
+    }
+
+  distanceMap = std::make_shared<vtkImageLabelMarginDistanceMap>();
+  std::copy(wholeExtent, wholeExtent + 6, distanceMap->WholeExtent);
+  std::copy(spacing, spacing + 3, distanceMap->Spacing);
+  std::copy(this->CurrentLabelExtent, this->CurrentLabelExtent + 6, distanceMap->LabelExtent);
+  CompareOrCopyLabelMask(this->Mask.data(), maskExtent, distanceMap->LabelMask, this->CurrentLabelExtent, true);
+  return distanceMap.get();
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageLabelMargin::ProcessMask(const int maskExtent[6], vtkImageData* output, const int outputExtent[6])
+{
+  // Remove distance maps of labels that are no longer in the labelmap
+  for (auto distanceMapIt = this->DistanceMaps.begin(); distanceMapIt != this->DistanceMaps.end();)
+    {
+    if (this->LabelExtents.find(distanceMapIt->first) == this->LabelExtents.end())
+      {
+      distanceMapIt = this->DistanceMaps.erase(distanceMapIt);
+      }
+    else
+      {
+      ++distanceMapIt;
+      }
+    }
+
+  const double upperMargin = this->MarginSize;
+  const double lowerMargin = this->InnerMarginSize;
+  const bool lowerMarginInfinite = vtkMath::IsInf(lowerMargin) && lowerMargin < 0;
+  if (upperMargin == 0.0 && lowerMarginInfinite)
+    {
+    // Nothing to do, output is the same as the input
+    this->CopyMaskToOutput(maskExtent, output, outputExtent);
+    return true;
+    }
+
+  // Squared margins, with tolerance for rounding errors (same as in vtkITKImageMargin)
+  const double epsilon = std::numeric_limits<double>::epsilon();
+  const float upperSquaredMargin = static_cast<float>(pow(fabs(upperMargin) + epsilon, 2));
+  const float lowerSquaredMargin = lowerMarginInfinite ? SQUARED_DISTANCE_INFINITE
+    : static_cast<float>(pow(fabs(lowerMargin) + epsilon, 2));
+  // Background voxels may only be in the output if the upper margin is positive,
+  // foreground voxels are only excluded if any of the margins is negative.
+  const bool outsideDistancesRequired = (upperMargin > 0.0);
+  const bool insideDistancesRequired = (upperMargin < 0.0 || (!lowerMarginInfinite && lowerMargin < 0.0));
+
+  vtkImageLabelMarginDistanceMap* distanceMap = this->GetDistanceMap(maskExtent);
+  this->DistanceMapReused = true;
+  if (outsideDistancesRequired && (distanceMap->OutsideSquaredDistances.empty()
+    || !ExtentContains(distanceMap->OutsideExtent, outputExtent)))
+    {
+    // Compute distances in the output extent. If distances were already computed for a smaller
+    // margin then the padding is at least doubled to reduce recomputations when the margin is
+    // increased in small steps.
+    int outsideExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    const bool increasePadding = !distanceMap->OutsideSquaredDistances.empty();
+    for (int bound = 0; bound < 6; ++bound)
+      {
+      const int direction = (bound % 2 == 0 ? -1 : 1);
+      int padding = std::abs(outputExtent[bound] - distanceMap->LabelExtent[bound]);
+      if (increasePadding)
+        {
+        padding = std::max(padding, 2 * std::abs(distanceMap->OutsideExtent[bound] - distanceMap->LabelExtent[bound]));
+        }
+      outsideExtent[bound] = distanceMap->LabelExtent[bound] + direction * padding;
+      outsideExtent[bound] = (direction < 0 ? std::max(outsideExtent[bound], distanceMap->WholeExtent[bound])
+        : std::min(outsideExtent[bound], distanceMap->WholeExtent[bound]));
+      }
+    std::copy(outsideExtent, outsideExtent + 6, distanceMap->OutsideExtent);
+    ComputeLabelSquaredDistances(*distanceMap, distanceMap->OutsideExtent, 1, distanceMap->OutsideSquaredDistances);
+    this->DistanceMapReused = false;
+    }
+  if (insideDistancesRequired && distanceMap->InsideSquaredDistances.empty())
+    {
+    for (int bound = 0; bound < 6; ++bound)
+      {
+      distanceMap->InsideExtent[bound] = (bound % 2 == 0 ?
+        std::max(distanceMap->LabelExtent[bound] - 1, distanceMap->WholeExtent[bound])
+        : std::min(distanceMap->LabelExtent[bound] + 1, distanceMap->WholeExtent[bound]));
+      }
+    ComputeLabelSquaredDistances(*distanceMap, distanceMap->InsideExtent, 0, distanceMap->InsideSquaredDistances);
+    this->DistanceMapReused = false;
+    }
+
+  // Threshold the signed distance. The result is written into the mask buffer.
+  unsigned char* mask = this->Mask.data();
+  vtkSMPTools::For(outputExtent[4], outputExtent[5] + 1, [&](vtkIdType firstSlice, vtkIdType lastSlice)
+    {
+    for (int k = static_cast<int>(firstSlice); k < lastSlice; ++k)
+      {
+      for (int j = outputExtent[2]; j <= outputExtent[3]; ++j)
+        {
+        unsigned char* maskRow = mask + GetOffset(maskExtent, outputExtent[0], j, k);
+        const float* outsideRow = (outsideDistancesRequired ?
+          distanceMap->OutsideSquaredDistances.data() + GetOffset(distanceMap->OutsideExtent, outputExtent[0], j, k) : nullptr);
+        for (int i = 0; i <= outputExtent[1] - outputExtent[0]; ++i)
+          {
+          if (maskRow[i])
+            {
+            // Foreground voxel, signed distance is negative
+            if (!insideDistancesRequired)
+              {
+              // All foreground voxels are kept if there is no lower margin, removed if lower margin is non-negative
+              maskRow[i] = (lowerMarginInfinite ? 1 : 0);
+              continue;
+              }
+            const float squaredDistance = distanceMap->InsideSquaredDistances[
+              GetOffset(distanceMap->InsideExtent, outputExtent[0] + i, j, k)];
+            const bool belowUpperMargin = (upperMargin >= 0.0 || squaredDistance > upperSquaredMargin);
+            const bool aboveLowerMargin = (lowerMarginInfinite || (lowerMargin < 0.0 && squaredDistance <= lowerSquaredMargin));
+            maskRow[i] = (belowUpperMargin && aboveLowerMargin ? 1 : 0);
+            }
+          else if (outsideDistancesRequired)
+            {
+            // Background voxel, signed distance is positive
+            const float squaredDistance = outsideRow[i];
+            const bool belowUpperMargin = (squaredDistance <= upperSquaredMargin);
+            const bool aboveLowerMargin = (lowerMargin <= 0.0 || squaredDistance > lowerSquaredMargin);
+            maskRow[i] = (belowUpperMargin && aboveLowerMargin ? 1 : 0);
+            }
+          }
+        }
+      }
+    });
+  this->CopyMaskToOutput(maskExtent, output, outputExtent);
+  return true;
+}
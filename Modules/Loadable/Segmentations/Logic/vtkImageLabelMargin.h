@@ -0,0 +1,98 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef vtkImageLabelMargin_h
+#define vtkImageLabelMargin_h
+
+#include "vtkImageLabelOperation.h"
+
+// STD includes
+#include <memory>
+
+struct vtkImageLabelMarginDistanceMap;
+
+/// \brief Grow or shrink a single label of a labelmap by a margin, or create a shell at its boundary.
+///
+/// Output is a binary labelmap (0: background, 1: foreground).
+/// Signed distance of a background voxel is its distance from the nearest foreground voxel,
+/// signed distance of a foreground voxel is the negative of its distance from the nearest background voxel.
+/// Voxels outside the labelmap are not considered as background.
+/// A voxel is foreground in the output if its signed distance is between InnerMarginSize and MarginSize.
+/// A voxel whose distance is exactly equal to a margin size is considered to be within that margin
+/// (between the label boundary and the margin surface).
+///
+/// With the default (infinite) inner margin size, growing is the same as computed by vtkITKImageMargin
+/// with margin specified in physical units; when shrinking, foreground voxels are removed
+/// if their distance from the nearest background voxel is not larger than the margin.
+///
+/// Exact Euclidean distances are computed using separable squared distance transform
+/// (lower envelope of parabolas) along each axis, in parallel.
+/// Distance maps are cached for each label value and are reused as long as the label content,
+/// labelmap extent, and spacing are not changed. Therefore computing the result for a different
+/// margin size only requires thresholding of the cached distance map.
+class VTK_SLICER_SEGMENTATIONS_LOGIC_EXPORT vtkImageLabelMargin : public vtkImageLabelOperation
+{
+public:
+  static vtkImageLabelMargin* New();
+  vtkTypeMacro(vtkImageLabelMargin, vtkImageLabelOperation);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Margin size in physical units (same as labelmap spacing).
+  /// Positive value grows, negative value shrinks the label.
+  /// Voxels that have larger signed distance than this value are background in the output.
+  vtkSetMacro(MarginSize, double);
+  vtkGetMacro(MarginSize, double);
+
+  /// Inner margin size in physical units. Voxels that have smaller signed distance than this value
+  /// are background in the output. Default is negative infinity, which means that the output contains
+  /// the complete grown or shrunk label. Finite values can be used for creating shells: for example,
+  /// InnerMarginSize = 0 and MarginSize = 3 creates a 3mm thick shell around the label.
+  vtkSetMacro(InnerMarginSize, double);
+  vtkGetMacro(InnerMarginSize, double);
+
+  /// Remove all cached distance maps
+  void ClearCache();
+
+  /// True if no distance transform had to be computed in the last execution
+  /// because the distance map was available in the cache.
+  vtkGetMacro(DistanceMapReused, bool);
+
+protected:
+  vtkImageLabelMargin();
+  ~vtkImageLabelMargin() override;
+
+  void GetLabelMargins(int inputMargin[3], int outputMargin[3]) override;
+  void ClearResults() override;
+  bool ProcessMask(const int maskExtent[6], vtkImageData* output, const int outputExtent[6]) override;
+
+  /// Get cached distance map of the current label. A new distance map is created if the label has been
+  /// changed since the cached distance map was computed.
+  vtkImageLabelMarginDistanceMap* GetDistanceMap(const int maskExtent[6]);
+
+  double MarginSize{ 0.0 };
+  double InnerMarginSize;
+  bool DistanceMapReused{ false };
+
+  /// Cached distance map of each label value
+  std::map<int, std::shared_ptr<vtkImageLabelMarginDistanceMap>> DistanceMaps;
+
+private:
+  vtkImageLabelMargin(const vtkImageLabelMargin&) = delete;
+  void operator=(const vtkImageLabelMargin&) = delete;
+};
+
+#endif
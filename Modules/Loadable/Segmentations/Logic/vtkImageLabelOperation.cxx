@@ -0,0 +1,350 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkImageLabelOperation.h"
+
+// vtkSegmentationCore includes
+#include "vtkOrientedImageData.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkIntArray.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+typedef std::map<int, std::array<int, 6>> LabelExtentMap;
+
+//----------------------------------------------------------------------------
+void AddToExtent(std::array<int, 6>& extent, int i0, int i1, int j, int k)
+{
+  extent[0] = std::min(extent[0], i0);
+  extent[1] = std::max(extent[1], i1);
+  extent[2] = std::min(extent[2], j);
+  extent[3] = std::max(extent[3], j);
+  extent[4] = std::min(extent[4], k);
+  extent[5] = std::max(extent[5], k);
+}
+
+//----------------------------------------------------------------------------
+/// Compute bounding extent of each label, slice by slice. Runs of voxels with
+/// the same label value are handled at once to minimize the number of map lookups.
+template <class T>
+void vtkImageLabelOperationComputeLabelExtents(vtkImageData* labelmap, LabelExtentMap& labelExtents)
+{
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  labelmap->GetExtent(extent);
+  vtkIdType increments[3] = { 0, 0, 0 };
+  labelmap->GetIncrements(increments);
+  const T* basePtr = static_cast<const T*>(labelmap->GetScalarPointerForExtent(extent));
+  const int numberOfSlices = extent[5] - extent[4] + 1;
+
+  std::vector<LabelExtentMap> sliceLabelExtents(numberOfSlices);
+  vtkSMPTools::For(0, numberOfSlices, [&](vtkIdType firstSlice, vtkIdType lastSlice)
+    {
+    for (vtkIdType slice = firstSlice; slice < lastSlice; ++slice)
+      {
+      LabelExtentMap& labelExtentsInSlice = sliceLabelExtents[slice];
+      const int k = extent[4] + static_cast<int>(slice);
+      for (int j = extent[2]; j <= extent[3]; ++j)
+        {
+        const T* rowPtr = basePtr + slice * increments[2] + (j - extent[2]) * increments[1];
+        int i = extent[0];
+        while (i <= extent[1])
+          {
+          const T value = rowPtr[(i - extent[0]) * increments[0]];
+          const int runStart = i;
+          while (i + 1 <= extent[1] && rowPtr[(i + 1 - extent[0]) * increments[0]] == value)
+            {
+            ++i;
+            }
+          if (value != 0)
+            {
+            const int labelValue = static_cast<int>(value);
+            LabelExtentMap::iterator labelExtentIt = labelExtentsInSlice.find(labelValue);
+            if (labelExtentIt == labelExtentsInSlice.end())
+              {
+              std::array<int, 6> labelExtent = { { runStart, i, j, j, k, k } };
+              labelExtentsInSlice[labelValue] = labelExtent;
+              }
+            else
+              {
+              AddToExtent(labelExtentIt->second, runStart, i, j, k);
+              }
+            }
+          ++i;
+          }
+        }
+      }
+    });
+
+  labelExtents.clear();
+  for (const LabelExtentMap& labelExtentsInSlice : sliceLabelExtents)
+    {
+    for (const auto& labelExtentInSlice : labelExtentsInSlice)
+      {
+      LabelExtentMap::iterator labelExtentIt = labelExtents.find(labelExtentInSlice.first);
+      if (labelExtentIt == labelExtents.end())
+        {
+        labelExtents[labelExtentInSlice.first] = labelExtentInSlice.second;
+        }
+      else
+        {
+        const std::array<int, 6>& sliceExtent = labelExtentInSlice.second;
+        AddToExtent(labelExtentIt->second, sliceExtent[0], sliceExtent[1], sliceExtent[2], sliceExtent[4]);
+        AddToExtent(labelExtentIt->second, sliceExtent[0], sliceExtent[1], sliceExtent[3], sliceExtent[5]);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void vtkImageLabelOperationExtractMask(vtkImageData* labelmap, int labelValue,
+  const int maskExtent[6], unsigned char* mask)
+{
+  vtkIdType increments[3] = { 0, 0, 0 };
+  labelmap->GetIncrements(increments);
+  const T* basePtr = static_cast<const T*>(labelmap->GetScalarPointerForExtent(const_cast<int*>(maskExtent)));
+  const T foregroundValue = static_cast<T>(labelValue);
+  const int dimensions[3] =
+    {
+    maskExtent[1] - maskExtent[0] + 1,
+    maskExtent[3] - maskExtent[2] + 1,
+    maskExtent[5] - maskExtent[4] + 1
+    };
+  vtkSMPTools::For(0, dimensions[2], [&](vtkIdType firstSlice, vtkIdType lastSlice)
+    {
+    for (vtkIdType k = firstSlice; k < lastSlice; ++k)
+      {
+      for (int j = 0; j < dimensions[1]; ++j)
+        {
+        const T* inPtr = basePtr + k * increments[2] + j * increments[1];
+        unsigned char* outPtr = mask + (k * dimensions[1] + j) * static_cast<vtkIdType>(dimensions[0]);
+        for (int i = 0; i < dimensions[0]; ++i, inPtr += increments[0])
+          {
+          outPtr[i] = (*inPtr == foregroundValue ? 1 : 0);
+          }
+        }
+      }
+    });
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkImageLabelOperation::vtkImageLabelOperation() = default;
+
+//----------------------------------------------------------------------------
+vtkImageLabelOperation::~vtkImageLabelOperation()
+{
+  this->SetLabelmap(nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelOperation::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Labelmap: " << this->Labelmap << "\n";
+  os << indent << "CropOutput: " << (this->CropOutput ? "true" : "false") << "\n";
+  os << indent << "Number of labels: " << this->LabelExtents.size() << "\n";
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelOperation::GetOutputScalarType()
+{
+  return VTK_UNSIGNED_CHAR;
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageLabelOperation::UpdateLabelExtents()
+{
+  if (!this->Labelmap || !this->Labelmap->GetPointData() || !this->Labelmap->GetPointData()->GetScalars())
+    {
+    vtkErrorMacro("UpdateLabelExtents: invalid input labelmap");
+    return false;
+    }
+  vtkMTimeType labelmapTime = std::max(this->Labelmap->GetMTime(), this->Labelmap->GetPointData()->GetScalars()->GetMTime());
+  if (this->Labelmap == this->LabelExtentsLabelmap && labelmapTime == this->LabelExtentsTime)
+    {
+    // up-to-date
+    return true;
+    }
+
+  this->LabelExtents.clear();
+  int* extent = this->Labelmap->GetExtent();
+  if (extent[0] <= extent[1] && extent[2] <= extent[3] && extent[4] <= extent[5])
+    {
+    switch (this->Labelmap->GetScalarType())
+      {
+      vtkTemplateMacro(vtkImageLabelOperationComputeLabelExtents<VTK_TT>(this->Labelmap, this->LabelExtents));
+      default:
+        vtkErrorMacro("UpdateLabelExtents: unsupported labelmap scalar type");
+        return false;
+      }
+    }
+  this->LabelExtentsLabelmap = this->Labelmap;
+  this->LabelExtentsTime = labelmapTime;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageLabelOperation::GetLabelExtent(int labelValue, int extent[6])
+{
+  if (!this->UpdateLabelExtents())
+    {
+    return false;
+    }
+  LabelExtentMap::iterator labelExtentIt = this->LabelExtents.find(labelValue);
+  if (labelExtentIt == this->LabelExtents.end())
+    {
+    return false;
+    }
+  std::copy(labelExtentIt->second.begin(), labelExtentIt->second.end(), extent);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelOperation::GetLabelValues(vtkIntArray* labelValues)
+{
+  if (!labelValues)
+    {
+    vtkErrorMacro("GetLabelValues: invalid labelValues");
+    return;
+    }
+  labelValues->Initialize();
+  if (!this->UpdateLabelExtents())
+    {
+    return;
+    }
+  for (const auto& labelExtent : this->LabelExtents)
+    {
+    labelValues->InsertNextValue(labelExtent.first);
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageLabelOperation::Execute(int labelValue, vtkOrientedImageData* output)
+{
+  if (!output)
+    {
+    vtkErrorMacro("Execute: invalid output");
+    return false;
+    }
+  this->ClearResults();
+  if (!this->UpdateLabelExtents())
+    {
+    return false;
+    }
+
+  output->Initialize();
+  output->SetOrigin(this->Labelmap->GetOrigin());
+  output->SetSpacing(this->Labelmap->GetSpacing());
+  if (vtkOrientedImageData::SafeDownCast(this->Labelmap))
+    {
+    output->CopyDirections(this->Labelmap);
+    }
+  else
+    {
+    output->SetDirections(1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0);
+    }
+
+  int wholeExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  this->Labelmap->GetExtent(wholeExtent);
+  int labelExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  if (!this->GetLabelExtent(labelValue, labelExtent))
+    {
+    // Label is not present, the output is empty
+    int emptyExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    output->SetExtent(this->CropOutput ? emptyExtent : wholeExtent);
+    output->AllocateScalars(this->GetOutputScalarType(), 1);
+    if (output->GetPointData()->GetScalars()->GetNumberOfValues() > 0)
+      {
+      output->GetPointData()->GetScalars()->Fill(0);
+      }
+    return true;
+    }
+
+  this->CurrentLabelValue = labelValue;
+  std::copy(labelExtent, labelExtent + 6, this->CurrentLabelExtent);
+
+  int inputMargin[3] = { 0, 0, 0 };
+  int outputMargin[3] = { 0, 0, 0 };
+  this->GetLabelMargins(inputMargin, outputMargin);
+  int maskExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  int outputExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    maskExtent[axis * 2] = std::max(labelExtent[axis * 2] - inputMargin[axis], wholeExtent[axis * 2]);
+    maskExtent[axis * 2 + 1] = std::min(labelExtent[axis * 2 + 1] + inputMargin[axis], wholeExtent[axis * 2 + 1]);
+    outputExtent[axis * 2] = std::max(labelExtent[axis * 2] - outputMargin[axis], maskExtent[axis * 2]);
+    outputExtent[axis * 2 + 1] = std::min(labelExtent[axis * 2 + 1] + outputMargin[axis], maskExtent[axis * 2 + 1]);
+    }
+
+  output->SetExtent(this->CropOutput ? outputExtent : wholeExtent);
+  output->AllocateScalars(this->GetOutputScalarType(), 1);
+  output->GetPointData()->GetScalars()->Fill(0);
+
+  // Extract binary mask of the label. The buffer is only reallocated if it needs to grow.
+  vtkIdType numberOfMaskVoxels = static_cast<vtkIdType>(maskExtent[1] - maskExtent[0] + 1)
+    * (maskExtent[3] - maskExtent[2] + 1) * (maskExtent[5] - maskExtent[4] + 1);
+  if (static_cast<vtkIdType>(this->Mask.size()) < numberOfMaskVoxels)
+    {
+    this->Mask.resize(numberOfMaskVoxels);
+    }
+  switch (this->Labelmap->GetScalarType())
+    {
+    vtkTemplateMacro(vtkImageLabelOperationExtractMask<VTK_TT>(this->Labelmap, labelValue, maskExtent, this->Mask.data()));
+    default:
+      vtkErrorMacro("Execute: unsupported labelmap scalar type");
+      return false;
+    }
+
+  return this->ProcessMask(maskExtent, output, outputExtent);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelOperation::CopyMaskToOutput(const int maskExtent[6], vtkImageData* output, const int outputExtent[6])
+{
+  const int maskDimensions[2] = { maskExtent[1] - maskExtent[0] + 1, maskExtent[3] - maskExtent[2] + 1 };
+  const int rowLength = outputExtent[1] - outputExtent[0] + 1;
+  vtkIdType outputIncrements[3] = { 0, 0, 0 };
+  output->GetIncrements(outputIncrements);
+  unsigned char* outputBasePtr = static_cast<unsigned char*>(output->GetScalarPointerForExtent(const_cast<int*>(outputExtent)));
+  vtkSMPTools::For(outputExtent[4], outputExtent[5] + 1, [&](vtkIdType firstSlice, vtkIdType lastSlice)
+    {
+    for (vtkIdType k = firstSlice; k < lastSlice; ++k)
+      {
+      for (int j = outputExtent[2]; j <= outputExtent[3]; ++j)
+        {
+        const unsigned char* maskPtr = this->Mask.data()
+          + ((k - maskExtent[4]) * maskDimensions[1] + (j - maskExtent[2])) * static_cast<vtkIdType>(maskDimensions[0])
+          + (outputExtent[0] - maskExtent[0]);
+        unsigned char* outPtr = outputBasePtr
+          + (k - outputExtent[4]) * outputIncrements[2] + (j - outputExtent[2]) * outputIncrements[1];
+        memcpy(outPtr, maskPtr, rowLength);
+        }
+      }
+    });
+}
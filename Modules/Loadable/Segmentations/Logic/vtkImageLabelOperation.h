@@ -0,0 +1,124 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef vtkImageLabelOperation_h
+#define vtkImageLabelOperation_h
+
+#include "vtkSlicerSegmentationsModuleLogicExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <array>
+#include <map>
+#include <vector>
+
+class vtkImageData;
+class vtkIntArray;
+class vtkOrientedImageData;
+
+/// \brief Abstract base class of operations that compute a new labelmap from a single label of a labelmap.
+///
+/// The input labelmap may be a shared labelmap layer of a segmentation (each segment is stored with
+/// a different label value) or a binary labelmap. Bounding extents of all labels are computed in a single
+/// multi-threaded pass and are reused until the labelmap is modified, therefore processing all segments
+/// of a layer one after the other requires only one full scan of the labelmap.
+///
+/// Each label is processed within its bounding extent, padded by the margin that the operation requires
+/// (for example the kernel radius). Working buffers are kept between calls to avoid repeated allocations.
+class VTK_SLICER_SEGMENTATIONS_LOGIC_EXPORT vtkImageLabelOperation : public vtkObject
+{
+public:
+  vtkTypeMacro(vtkImageLabelOperation, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Input labelmap. Voxels that are equal to the processed label value are foreground,
+  /// all other voxels are background. The first scalar component is used.
+  vtkSetObjectMacro(Labelmap, vtkImageData);
+  vtkGetObjectMacro(Labelmap, vtkImageData);
+
+  /// If enabled (default) then the output extent is restricted to the region that may contain
+  /// foreground voxels. If disabled then the output has the same extent as the input labelmap
+  /// (the voxels outside the processed region are set to 0).
+  vtkSetMacro(CropOutput, bool);
+  vtkGetMacro(CropOutput, bool);
+  vtkBooleanMacro(CropOutput, bool);
+
+  /// Compute the result for the specified label value.
+  /// Geometry (origin, spacing, directions) of the output is the same as the input labelmap.
+  /// If the label value does not occur in the labelmap and CropOutput is enabled
+  /// then the output extent is empty.
+  /// \return False if the inputs are invalid.
+  bool Execute(int labelValue, vtkOrientedImageData* output);
+
+  /// Get bounding extent of a label in the input labelmap.
+  /// \return False if the label value does not occur in the labelmap.
+  bool GetLabelExtent(int labelValue, int extent[6]);
+
+  /// Get all non-zero label values that occur in the input labelmap, in ascending order.
+  void GetLabelValues(vtkIntArray* labelValues);
+
+protected:
+  vtkImageLabelOperation();
+  ~vtkImageLabelOperation() override;
+
+  /// Number of voxels along each axis by which the region of the label is padded.
+  /// \param inputMargin Voxels in this region are needed to compute the output.
+  /// \param outputMargin Foreground output voxels may only appear in this region.
+  virtual void GetLabelMargins(int inputMargin[3], int outputMargin[3]) = 0;
+
+  /// Scalar type of the output. Default is unsigned char.
+  virtual int GetOutputScalarType();
+
+  /// Called at the beginning of Execute to clear results of the previous execution.
+  virtual void ClearResults() {}
+
+  /// Compute the output from the Mask buffer.
+  /// \param maskExtent Extent of the Mask buffer (label extent padded by the input margin).
+  /// \param output Image to write the result into. Its extent contains the label extent padded
+  ///   by the output margin and it is filled with 0 before this method is called.
+  /// \param outputExtent Part of the output extent that the result has to be written into.
+  virtual bool ProcessMask(const int maskExtent[6], vtkImageData* output, const int outputExtent[6]) = 0;
+
+  /// Copy the region of the Mask buffer that is inside outputExtent to the (unsigned char) output.
+  void CopyMaskToOutput(const int maskExtent[6], vtkImageData* output, const int outputExtent[6]);
+
+  /// Update bounding extent of all labels if the labelmap has changed since the last update.
+  bool UpdateLabelExtents();
+
+  vtkImageData* Labelmap{ nullptr };
+  bool CropOutput{ true };
+
+  /// Label value and its bounding extent that are processed in the current execution.
+  int CurrentLabelValue{ 0 };
+  int CurrentLabelExtent[6]{ 0, -1, 0, -1, 0, -1 };
+
+  /// Binary mask of the processed label (0: background, 1: foreground), stored in x-fastest order.
+  std::vector<unsigned char> Mask;
+
+  /// Bounding extent of each label value, computed from the labelmap at LabelExtentsTime.
+  std::map<int, std::array<int, 6>> LabelExtents;
+  vtkImageData* LabelExtentsLabelmap{ nullptr };
+  vtkMTimeType LabelExtentsTime{ 0 };
+
+private:
+  vtkImageLabelOperation(const vtkImageLabelOperation&) = delete;
+  void operator=(const vtkImageLabelOperation&) = delete;
+};
+
+#endif
@@ -0,0 +1,402 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkImageLabelSmoothing.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkObjectFactory.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Call lineFunctor(firstVoxelIndex, stride, length) for each image line along the specified axis,
+/// using multiple threads.
+template <class LineFunctorType>
+void ForEachLine(const int dimensions[3], int axis, LineFunctorType lineFunctor)
+{
+  const vtkIdType strides[3] = { 1, dimensions[0], static_cast<vtkIdType>(dimensions[0]) * dimensions[1] };
+  const int otherAxis0 = (axis == 0 ? 1 : 0);
+  const int otherAxis1 = (axis == 2 ? 1 : 2);
+  const vtkIdType numberOfLines = static_cast<vtkIdType>(dimensions[otherAxis0]) * dimensions[otherAxis1];
+  vtkSMPTools::For(0, numberOfLines, [&](vtkIdType firstLine, vtkIdType lastLine)
+    {
+    for (vtkIdType line = firstLine; line < lastLine; ++line)
+      {
+      const vtkIdType index0 = line % dimensions[otherAxis0];
+      const vtkIdType index1 = line / dimensions[otherAxis0];
+      lineFunctor(index0 * strides[otherAxis0] + index1 * strides[otherAxis1], strides[axis], dimensions[axis]);
+      }
+    });
+}
+
+//----------------------------------------------------------------------------
+/// Kernel row along the first axis: voxels from -HalfWidth to +HalfWidth at row offset (OffsetY, OffsetZ).
+struct KernelRow
+{
+  int OffsetY;
+  int OffsetZ;
+  int HalfWidth;
+};
+
+//----------------------------------------------------------------------------
+/// Rows of the ellipsoid kernel, as generated by vtkImageEllipsoidSource in vtkImageDilateErode3D.
+std::vector<KernelRow> GetEllipsoidKernelRows(const int kernelRadius[3])
+{
+  double ellipsoidRadius[3] = { 0.0, 0.0, 0.0 };
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    ellipsoidRadius[axis] = (2 * kernelRadius[axis] + 1) * 0.5;
+    }
+  std::vector<KernelRow> kernelRows;
+  for (int dz = -kernelRadius[2]; dz <= kernelRadius[2]; ++dz)
+    {
+    double s2 = dz / ellipsoidRadius[2];
+    s2 *= s2;
+    for (int dy = -kernelRadius[1]; dy <= kernelRadius[1]; ++dy)
+      {
+      double s1 = dy / ellipsoidRadius[1];
+      s1 *= s1;
+      int halfWidth = -1;
+      for (int dx = 0; dx <= kernelRadius[0]; ++dx)
+        {
+        double s0 = dx / ellipsoidRadius[0];
+        s0 *= s0;
+        if (s0 + s1 + s2 > 1.0)
+          {
+          break;
+          }
+        halfWidth = dx;
+        }
+      if (halfWidth >= 0)
+        {
+        kernelRows.push_back({ dy, dz, halfWidth });
+        }
+      }
+    }
+  return kernelRows;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkImageLabelSmoothing);
+
+//----------------------------------------------------------------------------
+vtkImageLabelSmoothing::vtkImageLabelSmoothing() = default;
+
+//----------------------------------------------------------------------------
+vtkImageLabelSmoothing::~vtkImageLabelSmoothing() = default;
+
+//----------------------------------------------------------------------------
+void vtkImageLabelSmoothing::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Method: " << this->Method << "\n";
+  os << indent << "KernelSize: " << this->KernelSize[0] << ", " << this->KernelSize[1] << ", " << this->KernelSize[2] << "\n";
+  os << indent << "GaussianStandardDeviation: " << this->GaussianStandardDeviation[0] << ", "
+    << this->GaussianStandardDeviation[1] << ", " << this->GaussianStandardDeviation[2] << "\n";
+  os << indent << "GaussianRadiusFactor: " << this->GaussianRadiusFactor << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelSmoothing::GetKernelRadius(int kernelRadius[3])
+{
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    if (this->Method == Gaussian)
+      {
+      kernelRadius[axis] = std::max(0, static_cast<int>(this->GaussianStandardDeviation[axis] * this->GaussianRadiusFactor));
+      }
+    else
+      {
+      kernelRadius[axis] = std::max(0, this->KernelSize[axis] / 2);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelSmoothing::GetLabelMargins(int inputMargin[3], int outputMargin[3])
+{
+  // Smoothing may add foreground voxels within one kernel radius of the label.
+  // Computing these voxels requires input voxels within two kernel radii (opening and closing
+  // consist of two filtering steps; Gaussian kernel normalization depends on the distance from the boundary).
+  int kernelRadius[3] = { 0, 0, 0 };
+  this->GetKernelRadius(kernelRadius);
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    outputMargin[axis] = kernelRadius[axis];
+    inputMargin[axis] = 2 * kernelRadius[axis];
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageLabelSmoothing::ProcessMask(const int maskExtent[6], vtkImageData* output, const int outputExtent[6])
+{
+  const int dimensions[3] =
+    {
+    maskExtent[1] - maskExtent[0] + 1,
+    maskExtent[3] - maskExtent[2] + 1,
+    maskExtent[5] - maskExtent[4] + 1
+    };
+  switch (this->Method)
+    {
+    case Median:
+      this->ApplyMedian(dimensions);
+      break;
+    case MorphologicalOpening:
+      this->ApplyDilateErode(dimensions, false);
+      this->ApplyDilateErode(dimensions, true);
+      break;
+    case MorphologicalClosing:
+      this->ApplyDilateErode(dimensions, true);
+      this->ApplyDilateErode(dimensions, false);
+      break;
+    case Gaussian:
+      this->ApplyGaussian(dimensions);
+      break;
+    default:
+      vtkErrorMacro("ProcessMask: invalid smoothing method " << this->Method);
+      return false;
+    }
+  this->CopyMaskToOutput(maskExtent, output, outputExtent);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelSmoothing::ApplyMedian(const int dimensions[3])
+{
+  int kernelRadius[3] = { 0, 0, 0 };
+  this->GetKernelRadius(kernelRadius);
+  const vtkIdType numberOfVoxels = static_cast<vtkIdType>(dimensions[0]) * dimensions[1] * dimensions[2];
+  if (static_cast<vtkIdType>(this->Counts.size()) < numberOfVoxels)
+    {
+    this->Counts.resize(numberOfVoxels);
+    }
+  int* counts = this->Counts.data();
+  unsigned char* mask = this->Mask.data();
+  std::copy(mask, mask + numberOfVoxels, counts);
+
+  // Number of foreground voxels in the kernel around each voxel, computed by separable running sums.
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    const int radius = kernelRadius[axis];
+    if (radius == 0)
+      {
+      continue;
+      }
+    ForEachLine(dimensions, axis, [counts, radius](vtkIdType first, vtkIdType stride, int length)
+      {
+      std::vector<int> cumulativeSum(length + 1, 0);
+      for (int i = 0; i < length; ++i)
+        {
+        cumulativeSum[i + 1] = cumulativeSum[i] + counts[first + i * stride];
+        }
+      for (int i = 0; i < length; ++i)
+        {
+        counts[first + i * stride] = cumulativeSum[std::min(i + radius, length - 1) + 1] - cumulativeSum[std::max(i - radius, 0)];
+        }
+      });
+    }
+
+  // A voxel is foreground if at least half of the voxels in the (clipped) kernel are foreground
+  vtkSMPTools::For(0, dimensions[2], [&](vtkIdType firstSlice, vtkIdType lastSlice)
+    {
+    for (vtkIdType k = firstSlice; k < lastSlice; ++k)
+      {
+      const int kernelLengthZ = static_cast<int>(std::min<vtkIdType>(k + kernelRadius[2], dimensions[2] - 1)
+        - std::max<vtkIdType>(k - kernelRadius[2], 0) + 1);
+      for (int j = 0; j < dimensions[1]; ++j)
+        {
+        const int kernelLengthY = std::min(j + kernelRadius[1], dimensions[1] - 1) - std::max(j - kernelRadius[1], 0) + 1;
+        const vtkIdType rowOffset = (k * dimensions[1] + j) * static_cast<vtkIdType>(dimensions[0]);
+        for (int i = 0; i < dimensions[0]; ++i)
+          {
+          const int kernelLengthX = std::min(i + kernelRadius[0], dimensions[0] - 1) - std::max(i - kernelRadius[0], 0) + 1;
+          const vtkIdType numberOfKernelVoxels = static_cast<vtkIdType>(kernelLengthX) * kernelLengthY * kernelLengthZ;
+          mask[rowOffset + i] = (2 * static_cast<vtkIdType>(counts[rowOffset + i]) >= numberOfKernelVoxels ? 1 : 0);
+          }
+        }
+      }
+    });
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelSmoothing::ApplyDilateErode(const int dimensions[3], bool dilate)
+{
+  int kernelRadius[3] = { 0, 0, 0 };
+  this->GetKernelRadius(kernelRadius);
+  const std::vector<KernelRow> kernelRows = GetEllipsoidKernelRows(kernelRadius);
+
+  const vtkIdType numberOfVoxels = static_cast<vtkIdType>(dimensions[0]) * dimensions[1] * dimensions[2];
+  const vtkIdType numberOfRows = static_cast<vtkIdType>(dimensions[1]) * dimensions[2];
+  const vtkIdType cumulativeRowLength = dimensions[0] + 1;
+  if (static_cast<vtkIdType>(this->Counts.size()) < numberOfRows * cumulativeRowLength)
+    {
+    this->Counts.resize(numberOfRows * cumulativeRowLength);
+    }
+  if (static_cast<vtkIdType>(this->TemporaryMask.size()) < numberOfVoxels)
+    {
+    this->TemporaryMask.resize(numberOfVoxels);
+    }
+  const unsigned char* inputMask = this->Mask.data();
+  unsigned char* outputMask = this->TemporaryMask.data();
+  int* cumulativeCounts = this->Counts.data();
+
+  // Number of foreground voxels before each position in each row.
+  // It allows counting foreground voxels in a kernel row in constant time.
+  vtkSMPTools::For(0, numberOfRows, [&](vtkIdType firstRow, vtkIdType lastRow)
+    {
+    for (vtkIdType row = firstRow; row < lastRow; ++row)
+      {
+      const unsigned char* maskRow = inputMask + row * dimensions[0];
+      int* cumulativeCountsRow = cumulativeCounts + row * cumulativeRowLength;
+      cumulativeCountsRow[0] = 0;
+      for (int i = 0; i < dimensions[0]; ++i)
+        {
+        cumulativeCountsRow[i + 1] = cumulativeCountsRow[i] + maskRow[i];
+        }
+      }
+    });
+
+  // Dilation: background voxel becomes foreground if there is any foreground voxel in the kernel.
+  // Erosion: foreground voxel becomes background if there is any background voxel in the kernel.
+  // Kernel voxels outside the image are ignored.
+  const unsigned char changedValue = (dilate ? 0 : 1);
+  vtkSMPTools::For(0, numberOfRows, [&](vtkIdType firstRow, vtkIdType lastRow)
+    {
+    for (vtkIdType row = firstRow; row < lastRow; ++row)
+      {
+      const int j = static_cast<int>(row % dimensions[1]);
+      const int k = static_cast<int>(row / dimensions[1]);
+      const unsigned char* inputRow = inputMask + row * dimensions[0];
+      unsigned char* outputRow = outputMask + row * dimensions[0];
+      for (int i = 0; i < dimensions[0]; ++i)
+        {
+        outputRow[i] = inputRow[i];
+        if (inputRow[i] != changedValue)
+          {
+          continue;
+          }
+        for (const KernelRow& kernelRow : kernelRows)
+          {
+          const int kernelJ = j + kernelRow.OffsetY;
+          const int kernelK = k + kernelRow.OffsetZ;
+          if (kernelJ < 0 || kernelJ >= dimensions[1] || kernelK < 0 || kernelK >= dimensions[2])
+            {
+            continue;
+            }
+          const int firstI = std::max(i - kernelRow.HalfWidth, 0);
+          const int lastI = std::min(i + kernelRow.HalfWidth, dimensions[0] - 1);
+          const int* cumulativeCountsRow = cumulativeCounts + (static_cast<vtkIdType>(kernelK) * dimensions[1] + kernelJ) * cumulativeRowLength;
+          const int foregroundCount = cumulativeCountsRow[lastI + 1] - cumulativeCountsRow[firstI];
+          if (dilate ? (foregroundCount > 0) : (foregroundCount < lastI - firstI + 1))
+            {
+            outputRow[i] = 1 - changedValue;
+            break;
+            }
+          }
+        }
+      }
+    });
+
+  std::swap(this->Mask, this->TemporaryMask);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelSmoothing::ApplyGaussian(const int dimensions[3])
+{
+  // Same scale and threshold as the binary labelmap smoothing that was implemented
+  // by vtkImageThreshold and vtkImageGaussianSmooth on unsigned char images.
+  const float foregroundValue = 255.0;
+  const float threshold = 127.0;
+
+  int kernelRadius[3] = { 0, 0, 0 };
+  this->GetKernelRadius(kernelRadius);
+  const vtkIdType numberOfVoxels = static_cast<vtkIdType>(dimensions[0]) * dimensions[1] * dimensions[2];
+  if (static_cast<vtkIdType>(this->Values.size()) < numberOfVoxels)
+    {
+    this->Values.resize(numberOfVoxels);
+    }
+  float* values = this->Values.data();
+  unsigned char* mask = this->Mask.data();
+  vtkSMPTools::For(0, numberOfVoxels, [&](vtkIdType first, vtkIdType last)
+    {
+    for (vtkIdType index = first; index < last; ++index)
+      {
+      values[index] = mask[index] * foregroundValue;
+      }
+    });
+
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    const int radius = kernelRadius[axis];
+    const double standardDeviation = this->GaussianStandardDeviation[axis];
+    if (radius == 0 || standardDeviation <= 0.0)
+      {
+      continue;
+      }
+    // Cumulative sum of kernel weights is used for normalizing the kernel when it is clipped at the image boundary
+    std::vector<double> weights(2 * radius + 1, 0.0);
+    std::vector<double> cumulativeWeights(2 * radius + 2, 0.0);
+    for (int offset = -radius; offset <= radius; ++offset)
+      {
+      weights[offset + radius] = exp(-static_cast<double>(offset * offset) / (standardDeviation * standardDeviation * 2.0));
+      cumulativeWeights[offset + radius + 1] = cumulativeWeights[offset + radius] + weights[offset + radius];
+      }
+    ForEachLine(dimensions, axis, [&](vtkIdType first, vtkIdType stride, int length)
+      {
+      std::vector<double> line(length, 0.0);
+      bool empty = true;
+      for (int i = 0; i < length; ++i)
+        {
+        line[i] = values[first + i * stride];
+        empty = empty && (line[i] == 0.0);
+        }
+      if (empty)
+        {
+        return;
+        }
+      for (int i = 0; i < length; ++i)
+        {
+        const int firstOffset = std::max(-radius, -i);
+        const int lastOffset = std::min(radius, length - 1 - i);
+        double sum = 0.0;
+        for (int offset = firstOffset; offset <= lastOffset; ++offset)
+          {
+          sum += weights[offset + radius] * line[i + offset];
+          }
+        values[first + i * stride] = static_cast<float>(sum
+          / (cumulativeWeights[lastOffset + radius + 1] - cumulativeWeights[firstOffset + radius]));
+        }
+      });
+    }
+
+  vtkSMPTools::For(0, numberOfVoxels, [&](vtkIdType first, vtkIdType last)
+    {
+    for (vtkIdType index = first; index < last; ++index)
+      {
+      mask[index] = (values[index] >= threshold ? 1 : 0);
+      }
+    });
+}
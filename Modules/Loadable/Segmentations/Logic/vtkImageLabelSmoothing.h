@@ -0,0 +1,101 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef vtkImageLabelSmoothing_h
+#define vtkImageLabelSmoothing_h
+
+#include "vtkImageLabelOperation.h"
+
+/// \brief Smooth a single label of a labelmap.
+///
+/// Output is a binary labelmap (0: background, 1: foreground) of the smoothed label.
+/// Results are the same as the filters that the Smoothing segment editor effect used
+/// to apply on the binary labelmap of the segment:
+/// - Median: vtkImageMedian3D with a box kernel of KernelSize voxels.
+/// - MorphologicalOpening, MorphologicalClosing: vtkImageOpenClose3D with an ellipsoid
+///   kernel of KernelSize voxels.
+/// - Gaussian: vtkImageGaussianSmooth with GaussianStandardDeviation and GaussianRadiusFactor,
+///   followed by thresholding at half of the foreground value.
+/// Kernels are clipped at the boundary of the labelmap.
+///
+/// Foreground voxels in the kernel are counted using running sums: the median filter cost does not
+/// depend on the kernel size, morphological filters process each row of the kernel in constant time.
+class VTK_SLICER_SEGMENTATIONS_LOGIC_EXPORT vtkImageLabelSmoothing : public vtkImageLabelOperation
+{
+public:
+  static vtkImageLabelSmoothing* New();
+  vtkTypeMacro(vtkImageLabelSmoothing, vtkImageLabelOperation);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  enum
+    {
+    Median,
+    MorphologicalOpening,
+    MorphologicalClosing,
+    Gaussian,
+    Method_Last // must be last
+    };
+
+  /// Smoothing method. Default is median.
+  vtkSetClampMacro(Method, int, Median, Method_Last - 1);
+  vtkGetMacro(Method, int);
+  void SetMethodToMedian() { this->SetMethod(Median); }
+  void SetMethodToMorphologicalOpening() { this->SetMethod(MorphologicalOpening); }
+  void SetMethodToMorphologicalClosing() { this->SetMethod(MorphologicalClosing); }
+  void SetMethodToGaussian() { this->SetMethod(Gaussian); }
+
+  /// Kernel size in voxels, used by median and morphological methods.
+  /// Kernel size should be an odd number, even numbers are rounded up to the next odd number.
+  vtkSetVector3Macro(KernelSize, int);
+  vtkGetVector3Macro(KernelSize, int);
+
+  /// Standard deviation of the Gaussian kernel, in voxels.
+  vtkSetVector3Macro(GaussianStandardDeviation, double);
+  vtkGetVector3Macro(GaussianStandardDeviation, double);
+
+  /// The Gaussian kernel extends to GaussianRadiusFactor times the standard deviation.
+  vtkSetMacro(GaussianRadiusFactor, double);
+  vtkGetMacro(GaussianRadiusFactor, double);
+
+protected:
+  vtkImageLabelSmoothing();
+  ~vtkImageLabelSmoothing() override;
+
+  void GetLabelMargins(int inputMargin[3], int outputMargin[3]) override;
+  bool ProcessMask(const int maskExtent[6], vtkImageData* output, const int outputExtent[6]) override;
+
+  void GetKernelRadius(int kernelRadius[3]);
+  void ApplyMedian(const int dimensions[3]);
+  void ApplyDilateErode(const int dimensions[3], bool dilate);
+  void ApplyGaussian(const int dimensions[3]);
+
+  int Method{ Median };
+  int KernelSize[3]{ 3, 3, 3 };
+  double GaussianStandardDeviation[3]{ 1.0, 1.0, 1.0 };
+  double GaussianRadiusFactor{ 4.0 };
+
+  /// Working buffers, kept between executions
+  std::vector<int> Counts;
+  std::vector<unsigned char> TemporaryMask;
+  std::vector<float> Values;
+
+private:
+  vtkImageLabelSmoothing(const vtkImageLabelSmoothing&) = delete;
+  void operator=(const vtkImageLabelSmoothing&) = delete;
+};
+
+#endif
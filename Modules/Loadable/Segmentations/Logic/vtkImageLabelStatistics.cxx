@@ -0,0 +1,677 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkImageLabelStatistics.h"
+
+// vtkSegmentationCore includes
+#include "vtkOrientedImageData.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkImageData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkLongArray.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
+#include <vtkTable.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace
+{
+// Label values are mapped to a contiguous range of slots, this limits the range of label values
+const vtkIdType MAXIMUM_NUMBER_OF_LABEL_SLOTS = 1 << 24;
+// Limits memory usage of the per-chunk accumulators
+const vtkIdType MAXIMUM_NUMBER_OF_ACCUMULATORS = 1 << 20;
+// Number of chunks per thread, more chunks improve load balancing
+const vtkIdType CHUNKS_PER_THREAD = 4;
+
+//----------------------------------------------------------------------------
+/// Statistics of a label in a range of image rows.
+/// Voxel positions are summed as integers, relative to the first voxel of the
+/// processed region, therefore results do not depend on the summation order.
+struct LabelAccumulator
+{
+  vtkIdType VoxelCount{ 0 };
+  double Sum{ 0.0 };
+  double SumOfSquares{ 0.0 };
+  double Minimum{ VTK_DOUBLE_MAX };
+  double Maximum{ VTK_DOUBLE_MIN };
+  vtkTypeInt64 PositionSum[3]{ 0, 0, 0 };
+  /// Sums of ii, jj, kk, ij, ik, jk
+  vtkTypeInt64 PositionProductSum[6]{ 0, 0, 0, 0, 0, 0 };
+
+  void Add(const LabelAccumulator& other)
+    {
+    this->VoxelCount += other.VoxelCount;
+    this->Sum += other.Sum;
+    this->SumOfSquares += other.SumOfSquares;
+    this->Minimum = std::min(this->Minimum, other.Minimum);
+    this->Maximum = std::max(this->Maximum, other.Maximum);
+    for (int i = 0; i < 3; ++i)
+      {
+      this->PositionSum[i] += other.PositionSum[i];
+      }
+    for (int i = 0; i < 6; ++i)
+      {
+      this->PositionProductSum[i] += other.PositionProductSum[i];
+      }
+    }
+};
+
+//----------------------------------------------------------------------------
+/// Processed region of the input images. Increments are in number of scalar values.
+struct ImageRegion
+{
+  int Dimensions[3]{ 0, 0, 0 };
+  vtkIdType LabelIncrements[3]{ 0, 0, 0 };
+  vtkIdType ScalarIncrements[3]{ 0, 0, 0 };
+  vtkIdType MinimumLabelValue{ 0 };
+  vtkIdType NumberOfLabelSlots{ 0 };
+  vtkIdType NumberOfChunks{ 1 };
+  bool ComputeShapeStatistics{ false };
+
+  vtkIdType GetNumberOfRows() const
+    {
+    return static_cast<vtkIdType>(this->Dimensions[1]) * this->Dimensions[2];
+    }
+};
+
+//----------------------------------------------------------------------------
+/// Call voxelFunction(slot, i, j, k, scalarPtr) for each labeled voxel in the chunk.
+/// scalarPtr is nullptr if there is no scalar volume.
+template <class L, class S, class VoxelFunction>
+void ForEachLabeledVoxel(const ImageRegion& region, const L* labelPtr, const S* scalarPtr,
+  vtkIdType chunk, VoxelFunction voxelFunction)
+{
+  const vtkIdType numberOfRows = region.GetNumberOfRows();
+  const vtkIdType firstRow = chunk * numberOfRows / region.NumberOfChunks;
+  const vtkIdType lastRow = (chunk + 1) * numberOfRows / region.NumberOfChunks;
+  for (vtkIdType row = firstRow; row < lastRow; ++row)
+    {
+    const int j = static_cast<int>(row % region.Dimensions[1]);
+    const int k = static_cast<int>(row / region.Dimensions[1]);
+    const L* labelRow = labelPtr + j * region.LabelIncrements[1] + k * region.LabelIncrements[2];
+    const S* scalarRow = scalarPtr ? scalarPtr + j * region.ScalarIncrements[1] + k * region.ScalarIncrements[2] : nullptr;
+    for (int i = 0; i < region.Dimensions[0]; ++i)
+      {
+      const L labelValue = labelRow[i * region.LabelIncrements[0]];
+      if (labelValue == 0)
+        {
+        continue;
+        }
+      const vtkIdType slot = static_cast<vtkIdType>(labelValue) - region.MinimumLabelValue;
+      voxelFunction(slot, i, j, k, scalarRow ? scalarRow + i * region.ScalarIncrements[0] : nullptr);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Nearest-rank percentile: index of the smallest value that is greater than or equal to
+/// the specified percentage of values.
+vtkIdType GetPercentileRank(double percentile, vtkIdType numberOfValues)
+{
+  vtkIdType rank = static_cast<vtkIdType>(std::ceil(percentile / 100.0 * numberOfValues)) - 1;
+  return std::max<vtkIdType>(0, std::min(rank, numberOfValues - 1));
+}
+
+//----------------------------------------------------------------------------
+/// Compute statistics of all labels.
+/// percentiles must be sorted in ascending order, their values are stored in percentileValues
+/// (numberOfPercentiles values for each label slot).
+template <class L, class S>
+void vtkImageLabelStatisticsExecute(const ImageRegion& region, const L* labelPtr, const S* scalarPtr,
+  const std::vector<double>& percentiles,
+  std::vector<LabelAccumulator>& labelAccumulators, std::vector<double>& percentileValues)
+{
+  const vtkIdType numberOfSlots = region.NumberOfLabelSlots;
+  const vtkIdType numberOfChunks = region.NumberOfChunks;
+
+  // Accumulate statistics of each chunk separately
+  std::vector<LabelAccumulator> chunkAccumulators(numberOfChunks * numberOfSlots);
+  vtkSMPTools::For(0, numberOfChunks, 1, [&](vtkIdType firstChunk, vtkIdType lastChunk)
+    {
+    for (vtkIdType chunk = firstChunk; chunk < lastChunk; ++chunk)
+      {
+      LabelAccumulator* accumulators = &chunkAccumulators[chunk * numberOfSlots];
+      ForEachLabeledVoxel(region, labelPtr, scalarPtr, chunk,
+        [&](vtkIdType slot, int i, int j, int k, const S* scalar)
+        {
+        LabelAccumulator& accumulator = accumulators[slot];
+        accumulator.VoxelCount++;
+        if (scalar)
+          {
+          const double value = static_cast<double>(*scalar);
+          accumulator.Sum += value;
+          accumulator.SumOfSquares += value * value;
+          accumulator.Minimum = std::min(accumulator.Minimum, value);
+          accumulator.Maximum = std::max(accumulator.Maximum, value);
+          }
+        if (region.ComputeShapeStatistics)
+          {
+          accumulator.PositionSum[0] += i;
+          accumulator.PositionSum[1] += j;
+          accumulator.PositionSum[2] += k;
+          accumulator.PositionProductSum[0] += static_cast<vtkTypeInt64>(i) * i;
+          accumulator.PositionProductSum[1] += static_cast<vtkTypeInt64>(j) * j;
+          accumulator.PositionProductSum[2] += static_cast<vtkTypeInt64>(k) * k;
+          accumulator.PositionProductSum[3] += static_cast<vtkTypeInt64>(i) * j;
+          accumulator.PositionProductSum[4] += static_cast<vtkTypeInt64>(i) * k;
+          accumulator.PositionProductSum[5] += static_cast<vtkTypeInt64>(j) * k;
+          }
+        });
+      }
+    });
+
+  // Merge chunks in the same order each time to get reproducible results
+  labelAccumulators.assign(numberOfSlots, LabelAccumulator());
+  vtkSMPTools::For(0, numberOfSlots, [&](vtkIdType firstSlot, vtkIdType lastSlot)
+    {
+    for (vtkIdType slot = firstSlot; slot < lastSlot; ++slot)
+      {
+      for (vtkIdType chunk = 0; chunk < numberOfChunks; ++chunk)
+        {
+        labelAccumulators[slot].Add(chunkAccumulators[chunk * numberOfSlots + slot]);
+        }
+      }
+    });
+
+  const size_t numberOfPercentiles = percentiles.size();
+  if (!scalarPtr || numberOfPercentiles == 0)
+    {
+    return;
+    }
+
+  // Gather scalar values of each label into a contiguous range of a single buffer.
+  // Each chunk writes its values of a label to a range that is reserved for it,
+  // therefore chunks can be processed in parallel.
+  std::vector<vtkIdType> labelValuesBegin(numberOfSlots);
+  std::vector<vtkIdType> chunkValueOffsets(numberOfChunks * numberOfSlots);
+  vtkIdType numberOfValues = 0;
+  for (vtkIdType slot = 0; slot < numberOfSlots; ++slot)
+    {
+    labelValuesBegin[slot] = numberOfValues;
+    for (vtkIdType chunk = 0; chunk < numberOfChunks; ++chunk)
+      {
+      chunkValueOffsets[chunk * numberOfSlots + slot] = numberOfValues;
+      numberOfValues += chunkAccumulators[chunk * numberOfSlots + slot].VoxelCount;
+      }
+    }
+  chunkAccumulators.clear();
+  chunkAccumulators.shrink_to_fit();
+
+  std::vector<S> values(numberOfValues);
+  vtkSMPTools::For(0, numberOfChunks, 1, [&](vtkIdType firstChunk, vtkIdType lastChunk)
+    {
+    for (vtkIdType chunk = firstChunk; chunk < lastChunk; ++chunk)
+      {
+      vtkIdType* valueOffsets = &chunkValueOffsets[chunk * numberOfSlots];
+      ForEachLabeledVoxel(region, labelPtr, scalarPtr, chunk,
+        [&](vtkIdType slot, int, int, int, const S* scalar)
+        {
+        values[valueOffsets[slot]++] = *scalar;
+        });
+      }
+    });
+
+  // Partial sorting is sufficient, each percentile only needs to search
+  // among values that are not less than the previous percentile.
+  percentileValues.assign(numberOfSlots * numberOfPercentiles, 0.0);
+  vtkSMPTools::For(0, numberOfSlots, [&](vtkIdType firstSlot, vtkIdType lastSlot)
+    {
+    for (vtkIdType slot = firstSlot; slot < lastSlot; ++slot)
+      {
+      const vtkIdType numberOfLabelValues = labelAccumulators[slot].VoxelCount;
+      if (numberOfLabelValues == 0)
+        {
+        continue;
+        }
+      typename std::vector<S>::iterator labelBegin = values.begin() + labelValuesBegin[slot];
+      typename std::vector<S>::iterator labelEnd = labelBegin + numberOfLabelValues;
+      typename std::vector<S>::iterator searchBegin = labelBegin;
+      for (size_t percentileIndex = 0; percentileIndex < numberOfPercentiles; ++percentileIndex)
+        {
+        typename std::vector<S>::iterator nth = labelBegin
+          + GetPercentileRank(percentiles[percentileIndex], numberOfLabelValues);
+        std::nth_element(searchBegin, nth, labelEnd);
+        percentileValues[slot * numberOfPercentiles + percentileIndex] = static_cast<double>(*nth);
+        searchBegin = nth;
+        }
+      }
+    });
+}
+
+//----------------------------------------------------------------------------
+template <class L>
+void vtkImageLabelStatisticsDispatchScalarType(const ImageRegion& region, const L* labelPtr,
+  void* scalarPtr, int scalarType, const std::vector<double>& percentiles,
+  std::vector<LabelAccumulator>& labelAccumulators, std::vector<double>& percentileValues)
+{
+  if (!scalarPtr)
+    {
+    vtkImageLabelStatisticsExecute(region, labelPtr, static_cast<const L*>(nullptr),
+      percentiles, labelAccumulators, percentileValues);
+    return;
+    }
+  switch (scalarType)
+    {
+    vtkTemplateMacro(vtkImageLabelStatisticsExecute(region, labelPtr, static_cast<const VTK_TT*>(scalarPtr),
+      percentiles, labelAccumulators, percentileValues));
+    default:
+      vtkGenericWarningMacro("vtkImageLabelStatistics: unsupported scalar volume type " << scalarType);
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Compute shape statistics from position sums, using the same definitions as itk::ShapeLabelMapFilter.
+/// indexToPhysical is the 3x3 matrix that maps voxel index offsets to physical offsets.
+void ComputeLabelShapeStatistics(const LabelAccumulator& accumulator,
+  const double regionOriginPhysical[3], const double indexToPhysical[3][3],
+  double centroid[3], double principalMoments[3], double principalAxes[3][3])
+{
+  const double numberOfVoxels = static_cast<double>(accumulator.VoxelCount);
+  double meanIndex[3] = { 0.0, 0.0, 0.0 };
+  for (int i = 0; i < 3; ++i)
+    {
+    meanIndex[i] = accumulator.PositionSum[i] / numberOfVoxels;
+    }
+  // Central second order moments in index space
+  const int productIndex[3][3] = { { 0, 3, 4 }, { 3, 1, 5 }, { 4, 5, 2 } };
+  double indexMoments[3][3];
+  for (int i = 0; i < 3; ++i)
+    {
+    for (int j = 0; j < 3; ++j)
+      {
+      indexMoments[i][j] = accumulator.PositionProductSum[productIndex[i][j]] / numberOfVoxels
+        - meanIndex[i] * meanIndex[j];
+      }
+    // Second order central moment of the voxel itself
+    indexMoments[i][i] += 1.0 / 12.0;
+    }
+
+  vtkMath::Multiply3x3(indexToPhysical, meanIndex, centroid);
+  vtkMath::Add(centroid, regionOriginPhysical, centroid);
+
+  double momentsTimesTransposed[3][3];
+  double indexToPhysicalTransposed[3][3];
+  double physicalMoments[3][3];
+  vtkMath::Transpose3x3(indexToPhysical, indexToPhysicalTransposed);
+  vtkMath::Multiply3x3(indexMoments, indexToPhysicalTransposed, momentsTimesTransposed);
+  vtkMath::Multiply3x3(indexToPhysical, momentsTimesTransposed, physicalMoments);
+
+  // Eigenvalues are sorted in descending order, eigenvectors are stored in columns
+  double eigenvalues[3];
+  double eigenvectors[3][3];
+  double* physicalMomentsRows[3] = { physicalMoments[0], physicalMoments[1], physicalMoments[2] };
+  double* eigenvectorsRows[3] = { eigenvectors[0], eigenvectors[1], eigenvectors[2] };
+  vtkMath::Jacobi(physicalMomentsRows, eigenvalues, eigenvectorsRows);
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    principalMoments[axis] = eigenvalues[2 - axis];
+    for (int i = 0; i < 3; ++i)
+      {
+      principalAxes[axis][i] = eigenvectors[i][2 - axis];
+      }
+    }
+  // Make the axes a proper rotation
+  if (vtkMath::Determinant3x3(principalAxes) < 0.0)
+    {
+    vtkMath::MultiplyScalar(principalAxes[2], -1.0);
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+T* AddColumn(vtkTable* table, const std::string& name, int numberOfComponents, vtkIdType numberOfRows)
+{
+  vtkNew<T> array;
+  array->SetName(name.c_str());
+  array->SetNumberOfComponents(numberOfComponents);
+  array->SetNumberOfTuples(numberOfRows);
+  table->AddColumn(array);
+  return array.GetPointer();
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkImageLabelStatistics);
+
+//----------------------------------------------------------------------------
+vtkImageLabelStatistics::vtkImageLabelStatistics()
+{
+  this->SetNumberOfInputPorts(2);
+}
+
+//----------------------------------------------------------------------------
+vtkImageLabelStatistics::~vtkImageLabelStatistics()
+{
+  this->SetDirections(nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelStatistics::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "ComputeShapeStatistics: " << (this->ComputeShapeStatistics ? "true" : "false") << "\n";
+  os << indent << "ComputeMedian: " << (this->ComputeMedian ? "true" : "false") << "\n";
+  os << indent << "Percentiles:";
+  for (double percentile : this->Percentiles)
+    {
+    os << " " << percentile;
+    }
+  os << "\n";
+  os << indent << "Directions:";
+  if (this->Directions)
+    {
+    os << "\n";
+    this->Directions->PrintSelf(os, indent.GetNextIndent());
+    }
+  else
+    {
+    os << " (none)\n";
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelStatistics::FillInputPortInformation(int port, vtkInformation* info)
+{
+  info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkImageData");
+  if (port == 1)
+    {
+    info->Set(vtkAlgorithm::INPUT_IS_OPTIONAL(), 1);
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+std::string vtkImageLabelStatistics::GetPercentileColumnName(double percentile)
+{
+  std::stringstream ss;
+  ss << "Percentile" << percentile;
+  return ss.str();
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkImageLabelStatistics::GetRowForLabelValue(int labelValue)
+{
+  vtkDataArray* labelValues = vtkDataArray::SafeDownCast(this->GetOutput()->GetColumnByName("LabelValue"));
+  if (!labelValues)
+    {
+    return -1;
+    }
+  for (vtkIdType row = 0; row < labelValues->GetNumberOfTuples(); ++row)
+    {
+    if (labelValues->GetComponent(row, 0) == labelValue)
+      {
+      return row;
+      }
+    }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelStatistics::RequestData(
+  vtkInformation* vtkNotUsed(request),
+  vtkInformationVector** inputVector,
+  vtkInformationVector* outputVector)
+{
+  vtkImageData* labelmap = vtkImageData::GetData(inputVector[0]);
+  vtkImageData* scalarVolume = vtkImageData::GetData(inputVector[1]);
+  vtkTable* output = vtkTable::GetData(outputVector);
+  output->Initialize();
+
+  vtkDataArray* labelScalars = labelmap ? labelmap->GetPointData()->GetScalars() : nullptr;
+  if (!labelScalars)
+    {
+    vtkErrorMacro("RequestData failed: invalid input labelmap");
+    return 0;
+    }
+  vtkDataArray* scalars = nullptr;
+  if (scalarVolume)
+    {
+    scalars = scalarVolume->GetPointData()->GetScalars();
+    if (!scalars)
+      {
+      vtkErrorMacro("RequestData failed: invalid input scalar volume");
+      return 0;
+      }
+    }
+
+  // Percentiles are computed in ascending order
+  std::vector<double> percentiles = this->Percentiles;
+  if (this->ComputeMedian)
+    {
+    percentiles.push_back(50.0);
+    }
+  for (double percentile : percentiles)
+    {
+    if (!(percentile >= 0.0 && percentile <= 100.0))
+      {
+      vtkErrorMacro("RequestData failed: percentile must be between 0 and 100, got " << percentile);
+      return 0;
+      }
+    }
+  std::sort(percentiles.begin(), percentiles.end());
+  percentiles.erase(std::unique(percentiles.begin(), percentiles.end()), percentiles.end());
+  if (!scalars)
+    {
+    percentiles.clear();
+    }
+
+  // Processed region
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  labelmap->GetExtent(extent);
+  if (scalarVolume)
+    {
+    int scalarExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    scalarVolume->GetExtent(scalarExtent);
+    for (int i = 0; i < 3; ++i)
+      {
+      extent[2 * i] = std::max(extent[2 * i], scalarExtent[2 * i]);
+      extent[2 * i + 1] = std::min(extent[2 * i + 1], scalarExtent[2 * i + 1]);
+      }
+    }
+  ImageRegion region;
+  region.ComputeShapeStatistics = this->ComputeShapeStatistics;
+  bool emptyRegion = false;
+  for (int i = 0; i < 3; ++i)
+    {
+    region.Dimensions[i] = extent[2 * i + 1] - extent[2 * i] + 1;
+    emptyRegion |= (region.Dimensions[i] <= 0);
+    }
+
+  std::vector<LabelAccumulator> labelAccumulators;
+  std::vector<double> percentileValues;
+  if (!emptyRegion)
+    {
+    double labelRange[2] = { 0.0, 0.0 };
+    labelScalars->GetRange(labelRange, 0);
+    region.MinimumLabelValue = static_cast<vtkIdType>(std::floor(labelRange[0]));
+    region.NumberOfLabelSlots = static_cast<vtkIdType>(std::floor(labelRange[1])) - region.MinimumLabelValue + 1;
+    if (region.NumberOfLabelSlots > MAXIMUM_NUMBER_OF_LABEL_SLOTS)
+      {
+      vtkErrorMacro("RequestData failed: range of label values is too large ("
+        << labelRange[0] << " to " << labelRange[1] << ")");
+      return 0;
+      }
+    region.NumberOfChunks = std::min(region.GetNumberOfRows(),
+      CHUNKS_PER_THREAD * vtkSMPTools::GetEstimatedNumberOfThreads());
+    region.NumberOfChunks = std::max<vtkIdType>(1,
+      std::min(region.NumberOfChunks, MAXIMUM_NUMBER_OF_ACCUMULATORS / region.NumberOfLabelSlots));
+
+    labelmap->GetIncrements(region.LabelIncrements);
+    void* labelPtr = labelmap->GetScalarPointer(extent[0], extent[2], extent[4]);
+    void* scalarPtr = nullptr;
+    if (scalars)
+      {
+      scalarVolume->GetIncrements(region.ScalarIncrements);
+      scalarPtr = scalarVolume->GetScalarPointer(extent[0], extent[2], extent[4]);
+      }
+    const int scalarType = scalars ? scalars->GetDataType() : VTK_VOID;
+
+    switch (labelScalars->GetDataType())
+      {
+      vtkTemplateMacro(vtkImageLabelStatisticsDispatchScalarType(region, static_cast<const VTK_TT*>(labelPtr),
+        scalarPtr, scalarType, percentiles, labelAccumulators, percentileValues));
+      default:
+        vtkErrorMacro("RequestData failed: unsupported labelmap scalar type " << labelScalars->GetDataType());
+        return 0;
+      }
+    }
+
+  std::vector<vtkIdType> labelSlots;
+  for (vtkIdType slot = 0; slot < static_cast<vtkIdType>(labelAccumulators.size()); ++slot)
+    {
+    if (labelAccumulators[slot].VoxelCount > 0)
+      {
+      labelSlots.push_back(slot);
+      }
+    }
+  const vtkIdType numberOfRows = static_cast<vtkIdType>(labelSlots.size());
+
+  double spacing[3] = { 1.0, 1.0, 1.0 };
+  labelmap->GetSpacing(spacing);
+  const double voxelVolume = std::abs(spacing[0] * spacing[1] * spacing[2]);
+
+  vtkLongArray* labelValueArray = AddColumn<vtkLongArray>(output, "LabelValue", 1, numberOfRows);
+  vtkIdTypeArray* voxelCountArray = AddColumn<vtkIdTypeArray>(output, "VoxelCount", 1, numberOfRows);
+  vtkDoubleArray* volumeArray = AddColumn<vtkDoubleArray>(output, "Volume", 1, numberOfRows);
+  for (vtkIdType row = 0; row < numberOfRows; ++row)
+    {
+    const LabelAccumulator& accumulator = labelAccumulators[labelSlots[row]];
+    labelValueArray->SetValue(row, static_cast<long>(region.MinimumLabelValue + labelSlots[row]));
+    voxelCountArray->SetValue(row, accumulator.VoxelCount);
+    volumeArray->SetValue(row, accumulator.VoxelCount * voxelVolume);
+    }
+
+  if (scalars)
+    {
+    vtkDoubleArray* minimumArray = AddColumn<vtkDoubleArray>(output, "Minimum", 1, numberOfRows);
+    vtkDoubleArray* maximumArray = AddColumn<vtkDoubleArray>(output, "Maximum", 1, numberOfRows);
+    vtkDoubleArray* meanArray = AddColumn<vtkDoubleArray>(output, "Mean", 1, numberOfRows);
+    vtkDoubleArray* standardDeviationArray = AddColumn<vtkDoubleArray>(output, "StandardDeviation", 1, numberOfRows);
+    for (vtkIdType row = 0; row < numberOfRows; ++row)
+      {
+      const LabelAccumulator& accumulator = labelAccumulators[labelSlots[row]];
+      const double numberOfVoxels = static_cast<double>(accumulator.VoxelCount);
+      const double mean = accumulator.Sum / numberOfVoxels;
+      double variance = 0.0;
+      if (accumulator.VoxelCount > 1)
+        {
+        variance = std::max(0.0, (accumulator.SumOfSquares - mean * accumulator.Sum) / (numberOfVoxels - 1.0));
+        }
+      minimumArray->SetValue(row, accumulator.Minimum);
+      maximumArray->SetValue(row, accumulator.Maximum);
+      meanArray->SetValue(row, mean);
+      standardDeviationArray->SetValue(row, std::sqrt(variance));
+      }
+
+    for (size_t percentileIndex = 0; percentileIndex < percentiles.size(); ++percentileIndex)
+      {
+      const double percentile = percentiles[percentileIndex];
+      std::vector<vtkDoubleArray*> percentileArrays;
+      if (this->ComputeMedian && percentile == 50.0)
+        {
+        percentileArrays.push_back(AddColumn<vtkDoubleArray>(output, "Median", 1, numberOfRows));
+        }
+      if (std::find(this->Percentiles.begin(), this->Percentiles.end(), percentile) != this->Percentiles.end())
+        {
+        percentileArrays.push_back(AddColumn<vtkDoubleArray>(output,
+          vtkImageLabelStatistics::GetPercentileColumnName(percentile), 1, numberOfRows));
+        }
+      for (vtkIdType row = 0; row < numberOfRows; ++row)
+        {
+        const double value = percentileValues[labelSlots[row] * percentiles.size() + percentileIndex];
+        for (vtkDoubleArray* percentileArray : percentileArrays)
+          {
+          percentileArray->SetValue(row, value);
+          }
+        }
+      }
+    }
+
+  if (this->ComputeShapeStatistics)
+    {
+    double directions[3][3] = { { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0 } };
+    vtkOrientedImageData* orientedLabelmap = vtkOrientedImageData::SafeDownCast(labelmap);
+    if (this->Directions)
+      {
+      for (int i = 0; i < 3; ++i)
+        {
+        for (int j = 0; j < 3; ++j)
+          {
+          directions[i][j] = this->Directions->GetElement(i, j);
+          }
+        }
+      }
+    else if (orientedLabelmap)
+      {
+      orientedLabelmap->GetDirections(directions);
+      }
+    double indexToPhysical[3][3];
+    for (int i = 0; i < 3; ++i)
+      {
+      for (int j = 0; j < 3; ++j)
+        {
+        indexToPhysical[i][j] = directions[i][j] * spacing[j];
+        }
+      }
+    double origin[3] = { 0.0, 0.0, 0.0 };
+    labelmap->GetOrigin(origin);
+    const double regionOriginIndex[3] = { static_cast<double>(extent[0]),
+      static_cast<double>(extent[2]), static_cast<double>(extent[4]) };
+    double regionOriginPhysical[3] = { 0.0, 0.0, 0.0 };
+    vtkMath::Multiply3x3(indexToPhysical, regionOriginIndex, regionOriginPhysical);
+    vtkMath::Add(regionOriginPhysical, origin, regionOriginPhysical);
+
+    vtkDoubleArray* centroidArray = AddColumn<vtkDoubleArray>(output, "Centroid", 3, numberOfRows);
+    vtkDoubleArray* principalMomentsArray = AddColumn<vtkDoubleArray>(output, "PrincipalMoments", 3, numberOfRows);
+    vtkDoubleArray* principalAxisXArray = AddColumn<vtkDoubleArray>(output, "PrincipalAxisX", 3, numberOfRows);
+    vtkDoubleArray* principalAxisYArray = AddColumn<vtkDoubleArray>(output, "PrincipalAxisY", 3, numberOfRows);
+    vtkDoubleArray* principalAxisZArray = AddColumn<vtkDoubleArray>(output, "PrincipalAxisZ", 3, numberOfRows);
+    vtkDoubleArray* elongationArray = AddColumn<vtkDoubleArray>(output, "Elongation", 1, numberOfRows);
+    vtkDoubleArray* flatnessArray = AddColumn<vtkDoubleArray>(output, "Flatness", 1, numberOfRows);
+    for (vtkIdType row = 0; row < numberOfRows; ++row)
+      {
+      double centroid[3] = { 0.0, 0.0, 0.0 };
+      double principalMoments[3] = { 0.0, 0.0, 0.0 };
+      double principalAxes[3][3];
+      ComputeLabelShapeStatistics(labelAccumulators[labelSlots[row]], regionOriginPhysical, indexToPhysical,
+        centroid, principalMoments, principalAxes);
+      centroidArray->SetTypedTuple(row, centroid);
+      principalMomentsArray->SetTypedTuple(row, principalMoments);
+      principalAxisXArray->SetTypedTuple(row, principalAxes[0]);
+      principalAxisYArray->SetTypedTuple(row, principalAxes[1]);
+      principalAxisZArray->SetTypedTuple(row, principalAxes[2]);
+      elongationArray->SetValue(row, principalMoments[1] > 0.0 ? std::sqrt(principalMoments[2] / principalMoments[1]) : 0.0);
+      flatnessArray->SetValue(row, principalMoments[0] > 0.0 ? std::sqrt(principalMoments[1] / principalMoments[0]) : 0.0);
+      }
+    }
+
+  return 1;
+}
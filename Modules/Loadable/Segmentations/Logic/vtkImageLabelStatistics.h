@@ -0,0 +1,119 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef vtkImageLabelStatistics_h
+#define vtkImageLabelStatistics_h
+
+#include "vtkSlicerSegmentationsModuleLogicExport.h"
+
+// VTK includes
+#include <vtkTableAlgorithm.h>
+
+// vtkAddon includes
+#include <vtkAddonSetGet.h>
+
+// STD includes
+#include <string>
+#include <vector>
+
+class vtkImageData;
+class vtkMatrix4x4;
+
+/// \brief Compute statistics of all labels of a labelmap in a single multi-threaded pass.
+///
+/// Input 0 is a labelmap, for example a shared labelmap layer of a segmentation.
+/// Each non-zero label value is a separate label. Input 1 is an optional scalar volume
+/// with the same geometry: voxel (i,j,k) of the scalar volume corresponds to voxel (i,j,k)
+/// of the labelmap. If the scalar volume is set then only voxels that are inside both extents
+/// are taken into account. The first component of the scalars is used.
+///
+/// Output is a vtkTable where each row is a label value that occurs in the labelmap, in ascending order.
+/// Columns:
+/// - LabelValue, VoxelCount, Volume: always computed. Volume is in cubic spacing units.
+/// - Minimum, Maximum, Mean, StandardDeviation: computed if a scalar volume is set.
+///   StandardDeviation is the sample standard deviation (same as vtkImageAccumulate).
+/// - Median and Percentile<p> (for example Percentile95): computed if a scalar volume is set
+///   and ComputeMedian is enabled or Percentiles are specified. The nearest-rank value is returned,
+///   therefore the result is always one of the voxel values.
+/// - Centroid, PrincipalMoments, PrincipalAxisX, PrincipalAxisY, PrincipalAxisZ, Elongation, Flatness:
+///   computed if ComputeShapeStatistics is enabled. Definitions are the same as in
+///   itk::ShapeLabelMapFilter (vtkITKLabelShapeStatistics): principal moments are sorted in ascending order
+///   and axes form a right-handed coordinate system. Positions are in the physical coordinate
+///   system of the labelmap (defined by origin, spacing, and Directions).
+class VTK_SLICER_SEGMENTATIONS_LOGIC_EXPORT vtkImageLabelStatistics : public vtkTableAlgorithm
+{
+public:
+  static vtkImageLabelStatistics* New();
+  vtkTypeMacro(vtkImageLabelStatistics, vtkTableAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Set input labelmap (input 0)
+  void SetLabelmap(vtkImageData* labelmap) { this->SetInputData(0, labelmap); }
+
+  /// Set scalar volume (input 1). Optional.
+  /// Intensity statistics are only computed if a scalar volume is set.
+  void SetScalarVolume(vtkImageData* scalarVolume) { this->SetInputData(1, scalarVolume); }
+
+  /// Axis directions of the labelmap, used for computing shape statistics.
+  /// If not set and the labelmap is a vtkOrientedImageData then its directions are used.
+  vtkSetObjectMacro(Directions, vtkMatrix4x4);
+  vtkGetObjectMacro(Directions, vtkMatrix4x4);
+
+  /// Compute centroid, principal moments and axes, elongation, and flatness.
+  /// Disabled by default.
+  vtkSetMacro(ComputeShapeStatistics, bool);
+  vtkGetMacro(ComputeShapeStatistics, bool);
+  vtkBooleanMacro(ComputeShapeStatistics, bool);
+
+  /// Compute median of the scalar values of each label.
+  /// Computing median (or any percentile) requires temporarily storing all labeled scalar values.
+  /// Enabled by default.
+  vtkSetMacro(ComputeMedian, bool);
+  vtkGetMacro(ComputeMedian, bool);
+  vtkBooleanMacro(ComputeMedian, bool);
+
+  /// Additional percentiles (in the range of 0 to 100) of the scalar values of each label.
+  /// Empty by default.
+  vtkSetStdVectorMacro(Percentiles, std::vector<double>);
+  vtkGetStdVectorMacro(Percentiles, std::vector<double>);
+
+  /// Name of the output column that stores the specified percentile.
+  static std::string GetPercentileColumnName(double percentile);
+
+  /// Get output table row of a label value. Returns -1 if the label value does not occur in the labelmap.
+  vtkIdType GetRowForLabelValue(int labelValue);
+
+protected:
+  vtkImageLabelStatistics();
+  ~vtkImageLabelStatistics() override;
+
+  int FillInputPortInformation(int port, vtkInformation* info) override;
+  int RequestData(vtkInformation* request,
+    vtkInformationVector** inputVector,
+    vtkInformationVector* outputVector) override;
+
+  vtkMatrix4x4* Directions{ nullptr };
+  bool ComputeShapeStatistics{ false };
+  bool ComputeMedian{ true };
+  std::vector<double> Percentiles;
+
+private:
+  vtkImageLabelStatistics(const vtkImageLabelStatistics&) = delete;
+  void operator=(const vtkImageLabelStatistics&) = delete;
+};
+
+#endif
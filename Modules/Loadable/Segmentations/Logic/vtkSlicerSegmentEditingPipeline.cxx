@@ -0,0 +1,1004 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkSlicerSegmentEditingPipeline.h"
+
+// Segmentations includes
+#include "vtkImageBrickThreshold.h"
+#include "vtkImageLabelIslands.h"
+#include "vtkImageLabelMargin.h"
+#include "vtkImageLabelSmoothing.h"
+#include "vtkMRMLSegmentEditorNode.h"
+#include "vtkMRMLSegmentationNode.h"
+#include "vtkSlicerSegmentationsModuleLogic.h"
+
+// vtkSegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+#include "vtkSegmentation.h"
+#include "vtkSegmentationConversionPath.h"
+#include "vtkSegmentationConverter.h"
+#include "vtkSegmentationModifier.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageConstantPad.h>
+#include <vtkImageThreshold.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+//----------------------------------------------------------------------------
+/// Operation stored in the pipeline
+struct vtkSlicerSegmentEditingOperation
+{
+  int Type{ vtkSlicerSegmentEditingPipeline::OperationThreshold };
+  std::string SegmentID;
+  std::string ModifierSegmentID;
+  /// Smoothing method or logical operation
+  int Method{ 0 };
+  /// Threshold range, margin size, or smoothing kernel size
+  double Parameters[2]{ 0.0, 0.0 };
+  vtkIdType MinimumSize{ 0 };
+  bool KeepLargestIslandOnly{ false };
+};
+
+//----------------------------------------------------------------------------
+/// State of a single execution of the pipeline
+struct vtkSlicerSegmentEditingContext
+{
+  vtkSegmentation* Segmentation{ nullptr };
+  vtkOrientedImageData* SourceImage{ nullptr };
+  /// Geometry of the computed labelmaps (scalars are not allocated)
+  vtkSmartPointer<vtkOrientedImageData> ReferenceGeometry;
+  /// Source image in the reference geometry, computed when it is first needed
+  vtkSmartPointer<vtkOrientedImageData> AlignedSourceImage;
+  /// Threshold filter, kept during the execution so that its brick table is reused by all threshold operations
+  vtkSmartPointer<vtkImageBrickThreshold> BrickThreshold;
+  /// Segments whose binary labelmap has been modified
+  std::set<std::string> ModifiedSegmentIDs;
+};
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+bool IsExtentEmpty(const int extent[6])
+{
+  return extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5];
+}
+
+//----------------------------------------------------------------------------
+/// Bounding box of two extents. Empty extents are ignored.
+void GetExtentUnion(const int extentA[6], const int extentB[6], int extentUnion[6])
+{
+  if (IsExtentEmpty(extentA))
+    {
+    std::copy(extentB, extentB + 6, extentUnion);
+    return;
+    }
+  if (IsExtentEmpty(extentB))
+    {
+    std::copy(extentA, extentA + 6, extentUnion);
+    return;
+    }
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    extentUnion[axis * 2] = std::min(extentA[axis * 2], extentB[axis * 2]);
+    extentUnion[axis * 2 + 1] = std::max(extentA[axis * 2 + 1], extentB[axis * 2 + 1]);
+    }
+}
+
+//----------------------------------------------------------------------------
+bool HasScalars(vtkOrientedImageData* image)
+{
+  return image && !image->IsEmpty() && image->GetPointData() && image->GetPointData()->GetScalars();
+}
+
+//----------------------------------------------------------------------------
+/// Pad or crop the image to the specified extent. Voxels outside the input extent are set to 0.
+/// Geometry and scalar type of the output are the same as the input.
+void PadImageToExtent(vtkOrientedImageData* input, const int extent[6], vtkOrientedImageData* output)
+{
+  vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+  input->GetImageToWorldMatrix(imageToWorldMatrix);
+  if (!HasScalars(input))
+    {
+    int scalarType = (input->GetPointData() && input->GetPointData()->GetScalars()) ? input->GetScalarType() : VTK_UNSIGNED_CHAR;
+    output->Initialize();
+    output->SetExtent(const_cast<int*>(extent));
+    output->SetGeometryFromImageToWorldMatrix(imageToWorldMatrix);
+    output->AllocateScalars(scalarType, 1);
+    vtkOrientedImageDataResample::FillImage(output, 0);
+    return;
+    }
+  int outputExtent[6] = { extent[0], extent[1], extent[2], extent[3], extent[4], extent[5] };
+  vtkNew<vtkImageConstantPad> padder;
+  padder->SetInputData(input);
+  padder->SetOutputWholeExtent(outputExtent);
+  padder->SetConstant(0);
+  padder->Update();
+  output->ShallowCopy(padder->GetOutput());
+  output->SetGeometryFromImageToWorldMatrix(imageToWorldMatrix);
+}
+
+//----------------------------------------------------------------------------
+/// Binary labelmap (unsigned char, 0: background, 1: foreground) of the voxels of the input
+/// that are within the [lower, upper] range.
+void ThresholdToBinaryLabelmap(vtkOrientedImageData* input, double lower, double upper, vtkOrientedImageData* output)
+{
+  if (!HasScalars(input))
+    {
+    // Empty input, the output is an empty binary labelmap with the same geometry
+    vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+    input->GetImageToWorldMatrix(imageToWorldMatrix);
+    output->Initialize();
+    output->SetGeometryFromImageToWorldMatrix(imageToWorldMatrix);
+    return;
+    }
+  vtkNew<vtkImageThreshold> threshold;
+  threshold->SetInputData(input);
+  threshold->ThresholdBetween(lower, upper);
+  threshold->SetInValue(1);
+  threshold->SetOutValue(0);
+  threshold->SetOutputScalarTypeToUnsignedChar();
+  threshold->Update();
+  output->ShallowCopy(threshold->GetOutput());
+  output->CopyDirections(input);
+}
+
+//----------------------------------------------------------------------------
+/// Binary labelmap of a segment. If geometry image is specified and its geometry is different
+/// from the geometry of the segment labelmap then the labelmap is resampled to that geometry
+/// (the resampled labelmap contains the complete segment).
+bool GetSegmentBinaryLabelmap(vtkSegment* segment, vtkOrientedImageData* geometryImage, vtkOrientedImageData* binaryLabelmap)
+{
+  vtkOrientedImageData* segmentLabelmap = vtkOrientedImageData::SafeDownCast(
+    segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()));
+  if (!segmentLabelmap)
+    {
+    return false;
+    }
+  vtkNew<vtkOrientedImageData> segmentBinaryLabelmap;
+  ThresholdToBinaryLabelmap(segmentLabelmap, segment->GetLabelValue(), segment->GetLabelValue(), segmentBinaryLabelmap);
+  if (!geometryImage || vtkOrientedImageDataResample::DoGeometriesMatch(segmentBinaryLabelmap, geometryImage)
+    || !HasScalars(segmentBinaryLabelmap))
+    {
+    binaryLabelmap->ShallowCopy(segmentBinaryLabelmap);
+    if (geometryImage && !HasScalars(segmentBinaryLabelmap))
+      {
+      vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+      geometryImage->GetImageToWorldMatrix(imageToWorldMatrix);
+      binaryLabelmap->SetGeometryFromImageToWorldMatrix(imageToWorldMatrix);
+      }
+    return true;
+    }
+  return vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+    segmentBinaryLabelmap, geometryImage, binaryLabelmap, false /* nearest neighbor */, true /* do not crop */);
+}
+
+//----------------------------------------------------------------------------
+/// Labelmap that a label operation can be applied on: the layer of the segment if it is in the
+/// reference geometry, otherwise the binary labelmap of the segment resampled to the reference geometry.
+/// If padToReferenceExtent is enabled then the labelmap is padded to contain the reference extent
+/// (so that the segment can grow in the entire reference image).
+bool GetSegmentLabelmap(vtkSlicerSegmentEditingContext& context, vtkSegment* segment, bool padToReferenceExtent,
+  vtkSmartPointer<vtkOrientedImageData>& labelmap, int& labelValue)
+{
+  labelmap = vtkOrientedImageData::SafeDownCast(
+    segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()));
+  labelValue = segment->GetLabelValue();
+  if (!labelmap)
+    {
+    return false;
+    }
+  if (!context.ReferenceGeometry || !HasScalars(labelmap))
+    {
+    return true;
+    }
+  if (!vtkOrientedImageDataResample::DoGeometriesMatch(labelmap, context.ReferenceGeometry))
+    {
+    vtkSmartPointer<vtkOrientedImageData> resampledLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    if (!GetSegmentBinaryLabelmap(segment, context.ReferenceGeometry, resampledLabelmap))
+      {
+      return false;
+      }
+    labelmap = resampledLabelmap;
+    labelValue = 1;
+    }
+  if (padToReferenceExtent)
+    {
+    int extent[6] = { 0, -1, 0, -1, 0, -1 };
+    GetExtentUnion(labelmap->GetExtent(), context.ReferenceGeometry->GetExtent(), extent);
+    if (!std::equal(extent, extent + 6, labelmap->GetExtent()))
+      {
+      vtkSmartPointer<vtkOrientedImageData> paddedLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+      PadImageToExtent(labelmap, extent, paddedLabelmap);
+      labelmap = paddedLabelmap;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+/// Get the reference geometry of the segmentation, or the geometry of the source image
+/// if the segmentation does not have reference geometry.
+bool GetReferenceGeometry(vtkSegmentation* segmentation, vtkOrientedImageData* sourceImage, vtkOrientedImageData* referenceGeometry)
+{
+  std::string referenceGeometryString = segmentation->GetConversionParameter(
+    vtkSegmentationConverter::GetReferenceImageGeometryParameterName());
+  if (!referenceGeometryString.empty()
+    && vtkSegmentationConverter::DeserializeImageGeometry(referenceGeometryString, referenceGeometry, false))
+    {
+    return true;
+    }
+  if (!sourceImage)
+    {
+    return false;
+    }
+  vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+  sourceImage->GetImageToWorldMatrix(imageToWorldMatrix);
+  referenceGeometry->SetExtent(sourceImage->GetExtent());
+  referenceGeometry->SetGeometryFromImageToWorldMatrix(imageToWorldMatrix);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+/// Source image in the reference geometry. The source image is used directly if it has the same geometry.
+vtkOrientedImageData* GetAlignedSourceImage(vtkSlicerSegmentEditingContext& context)
+{
+  if (context.AlignedSourceImage)
+    {
+    return context.AlignedSourceImage;
+    }
+  if (!context.SourceImage || !context.ReferenceGeometry)
+    {
+    return nullptr;
+    }
+  if (vtkOrientedImageDataResample::DoGeometriesMatch(context.SourceImage, context.ReferenceGeometry))
+    {
+    context.AlignedSourceImage = context.SourceImage;
+    return context.AlignedSourceImage;
+    }
+  vtkSmartPointer<vtkOrientedImageData> alignedSourceImage = vtkSmartPointer<vtkOrientedImageData>::New();
+  if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+    context.SourceImage, context.ReferenceGeometry, alignedSourceImage, true /* linear interpolation */))
+    {
+    return nullptr;
+    }
+  context.AlignedSourceImage = alignedSourceImage;
+  return context.AlignedSourceImage;
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void vtkSlicerSegmentEditingPipelineEraseVoxels(vtkImageData* labelmap, vtkImageData* modifierLabelmap, const int extent[6])
+{
+  vtkSMPTools::For(extent[4], extent[5] + 1, [&](vtkIdType firstSlice, vtkIdType lastSlice)
+    {
+    for (int k = static_cast<int>(firstSlice); k < static_cast<int>(lastSlice); ++k)
+      {
+      for (int j = extent[2]; j <= extent[3]; ++j)
+        {
+        T* labelmapPtr = static_cast<T*>(labelmap->GetScalarPointer(extent[0], j, k));
+        const unsigned char* modifierPtr = static_cast<unsigned char*>(modifierLabelmap->GetScalarPointer(extent[0], j, k));
+        for (int i = extent[0]; i <= extent[1]; ++i, ++labelmapPtr, ++modifierPtr)
+          {
+          if (*modifierPtr != 0)
+            {
+            *labelmapPtr = 0;
+            }
+          }
+        }
+      }
+    });
+}
+
+//----------------------------------------------------------------------------
+/// Erase the voxels that are set in the modifier labelmap from all layers except the layer of the edited segment.
+/// Segments in the layer of the edited segment are overwritten by vtkSegmentationModifier.
+bool EraseModifierFromOtherLayers(vtkSlicerSegmentEditingContext& context, const std::string& segmentID,
+  vtkOrientedImageData* modifierLabelmap)
+{
+  if (!HasScalars(modifierLabelmap))
+    {
+    return true;
+    }
+  vtkSegmentation* segmentation = context.Segmentation;
+  const std::string binaryLabelmapName = vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName();
+  vtkDataObject* editedLayer = segmentation->GetSegment(segmentID)->GetRepresentation(binaryLabelmapName);
+  for (int layerIndex = 0; layerIndex < segmentation->GetNumberOfLayers(binaryLabelmapName); ++layerIndex)
+    {
+    vtkOrientedImageData* layerLabelmap = vtkOrientedImageData::SafeDownCast(
+      segmentation->GetLayerDataObject(layerIndex, binaryLabelmapName));
+    if (!layerLabelmap || layerLabelmap == editedLayer || !HasScalars(layerLabelmap))
+      {
+      continue;
+      }
+
+    vtkSmartPointer<vtkOrientedImageData> layerModifierLabelmap = modifierLabelmap;
+    if (!vtkOrientedImageDataResample::DoGeometriesMatch(layerLabelmap, modifierLabelmap))
+      {
+      layerModifierLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+      if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+        modifierLabelmap, layerLabelmap, layerModifierLabelmap, false /* nearest neighbor */))
+        {
+        vtkGenericWarningMacro("vtkSlicerSegmentEditingPipeline: Failed to resample modifier labelmap to layer " << layerIndex);
+        return false;
+        }
+      }
+    int extent[6] = { 0, -1, 0, -1, 0, -1 };
+    vtkSegmentationModifier::GetExtentIntersection(layerLabelmap->GetExtent(), layerModifierLabelmap->GetExtent(), extent);
+    if (IsExtentEmpty(extent))
+      {
+      continue;
+      }
+
+    switch (layerLabelmap->GetScalarType())
+      {
+      vtkTemplateMacro(vtkSlicerSegmentEditingPipelineEraseVoxels<VTK_TT>(layerLabelmap, layerModifierLabelmap, extent));
+      default:
+        vtkGenericWarningMacro("vtkSlicerSegmentEditingPipeline: Unsupported labelmap scalar type");
+        return false;
+      }
+
+    // Other representations of the segments are reconverted at the end of the execution, therefore
+    // master representation modified event (which would remove them) is not needed.
+    bool wasMasterRepresentationModifiedEnabled = segmentation->SetMasterRepresentationModifiedEnabled(false);
+    layerLabelmap->Modified();
+    segmentation->SetMasterRepresentationModifiedEnabled(wasMasterRepresentationModifiedEnabled);
+    std::vector<std::string> layerSegmentIDs = segmentation->GetSegmentIDsForLayer(layerIndex, binaryLabelmapName);
+    for (const std::string& layerSegmentID : layerSegmentIDs)
+      {
+      context.ModifiedSegmentIDs.insert(layerSegmentID);
+      segmentation->InvokeEvent(vtkSegmentation::MasterRepresentationModified, (void*)layerSegmentID.c_str());
+      segmentation->InvokeEvent(vtkSegmentation::RepresentationModified, (void*)layerSegmentID.c_str());
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerSegmentEditingPipeline);
+
+//----------------------------------------------------------------------------
+vtkSlicerSegmentEditingPipeline::vtkSlicerSegmentEditingPipeline()
+{
+  this->MaskMode = vtkMRMLSegmentationNode::EditAllowedEverywhere;
+  this->OverwriteMode = vtkMRMLSegmentEditorNode::OverwriteAllSegments;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerSegmentEditingPipeline::~vtkSlicerSegmentEditingPipeline()
+{
+  this->SetMaskSegmentID(nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerSegmentEditingPipeline::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfOperations: " << this->Operations.size() << "\n";
+  os << indent << "MaskMode: " << this->MaskMode << "\n";
+  os << indent << "MaskSegmentID: " << (this->MaskSegmentID ? this->MaskSegmentID : "(none)") << "\n";
+  os << indent << "SourceVolumeIntensityMask: " << (this->SourceVolumeIntensityMask ? "true" : "false") << "\n";
+  os << indent << "SourceVolumeIntensityMaskRange: " << this->SourceVolumeIntensityMaskRange[0]
+    << ", " << this->SourceVolumeIntensityMaskRange[1] << "\n";
+  os << indent << "OverwriteMode: " << this->OverwriteMode << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerSegmentEditingPipeline::AddThreshold(const std::string& segmentID, double lowerThreshold, double upperThreshold)
+{
+  std::shared_ptr<vtkSlicerSegmentEditingOperation> operation = std::make_shared<vtkSlicerSegmentEditingOperation>();
+  operation->Type = OperationThreshold;
+  operation->SegmentID = segmentID;
+  operation->Parameters[0] = lowerThreshold;
+  operation->Parameters[1] = upperThreshold;
+  this->Operations.push_back(operation);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerSegmentEditingPipeline::AddIslands(const std::string& segmentID, vtkIdType minimumSize, bool keepLargestIslandOnly/*=false*/)
+{
+  std::shared_ptr<vtkSlicerSegmentEditingOperation> operation = std::make_shared<vtkSlicerSegmentEditingOperation>();
+  operation->Type = OperationIslands;
+  operation->SegmentID = segmentID;
+  operation->MinimumSize = minimumSize;
+  operation->KeepLargestIslandOnly = keepLargestIslandOnly;
+  this->Operations.push_back(operation);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerSegmentEditingPipeline::AddMargin(const std::string& segmentID, double marginSizeMm)
+{
+  std::shared_ptr<vtkSlicerSegmentEditingOperation> operation = std::make_shared<vtkSlicerSegmentEditingOperation>();
+  operation->Type = OperationMargin;
+  operation->SegmentID = segmentID;
+  operation->Parameters[0] = marginSizeMm;
+  this->Operations.push_back(operation);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerSegmentEditingPipeline::AddSmoothing(const std::string& segmentID, int method, double kernelSizeMm)
+{
+  if (method < vtkImageLabelSmoothing::Median || method >= vtkImageLabelSmoothing::Method_Last)
+    {
+    vtkErrorMacro("AddSmoothing: invalid smoothing method " << method);
+    return;
+    }
+  std::shared_ptr<vtkSlicerSegmentEditingOperation> operation = std::make_shared<vtkSlicerSegmentEditingOperation>();
+  operation->Type = OperationSmoothing;
+  operation->SegmentID = segmentID;
+  operation->Method = method;
+  operation->Parameters[0] = kernelSizeMm;
+  this->Operations.push_back(operation);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerSegmentEditingPipeline::AddLogicalOperation(const std::string& segmentID, int logicalOperation,
+  const std::string& modifierSegmentID/*=""*/)
+{
+  if (logicalOperation < LogicalCopy || logicalOperation >= Logical_Last)
+    {
+    vtkErrorMacro("AddLogicalOperation: invalid logical operation " << logicalOperation);
+    return;
+    }
+  std::shared_ptr<vtkSlicerSegmentEditingOperation> operation = std::make_shared<vtkSlicerSegmentEditingOperation>();
+  operation->Type = OperationLogical;
+  operation->SegmentID = segmentID;
+  operation->ModifierSegmentID = modifierSegmentID;
+  operation->Method = logicalOperation;
+  this->Operations.push_back(operation);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerSegmentEditingPipeline::RemoveAllOperations()
+{
+  this->Operations.clear();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerSegmentEditingPipeline::GetNumberOfOperations()
+{
+  return static_cast<int>(this->Operations.size());
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerSegmentEditingPipeline::Execute(vtkSegmentation* segmentation, vtkOrientedImageData* sourceImage/*=nullptr*/)
+{
+  if (!segmentation)
+    {
+    vtkErrorMacro("Execute: invalid segmentation");
+    return false;
+    }
+  const std::string binaryLabelmapName = vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName();
+  if (segmentation->GetMasterRepresentationName() != binaryLabelmapName)
+    {
+    vtkErrorMacro("Execute: master representation of the segmentation must be binary labelmap");
+    return false;
+    }
+  if (this->MaskMode != vtkMRMLSegmentationNode::EditAllowedEverywhere
+    && this->MaskMode != vtkMRMLSegmentationNode::EditAllowedInsideAllSegments
+    && this->MaskMode != vtkMRMLSegmentationNode::EditAllowedOutsideAllSegments
+    && this->MaskMode != vtkMRMLSegmentationNode::EditAllowedInsideSingleSegment)
+    {
+    vtkErrorMacro("Execute: unsupported mask mode " << this->MaskMode);
+    return false;
+    }
+  if (this->OverwriteMode != vtkMRMLSegmentEditorNode::OverwriteAllSegments
+    && this->OverwriteMode != vtkMRMLSegmentEditorNode::OverwriteNone)
+    {
+    vtkErrorMacro("Execute: unsupported overwrite mode " << this->OverwriteMode);
+    return false;
+    }
+  if (this->SourceVolumeIntensityMask && !sourceImage)
+    {
+    vtkErrorMacro("Execute: source image is required for editable intensity range masking");
+    return false;
+    }
+
+  vtkSlicerSegmentEditingContext context;
+  context.Segmentation = segmentation;
+  context.SourceImage = sourceImage;
+  vtkSmartPointer<vtkOrientedImageData> referenceGeometry = vtkSmartPointer<vtkOrientedImageData>::New();
+  if (GetReferenceGeometry(segmentation, sourceImage, referenceGeometry))
+    {
+    context.ReferenceGeometry = referenceGeometry;
+    }
+
+  std::vector<std::string> representationNames;
+  segmentation->GetContainedRepresentationNames(representationNames);
+
+  bool success = true;
+  for (const std::shared_ptr<vtkSlicerSegmentEditingOperation>& operation : this->Operations)
+    {
+    if (!this->ApplyOperation(context, *operation))
+      {
+      success = false;
+      break;
+      }
+    }
+
+  // Update the status and the other representations of modified segments.
+  // Segments are modified with master representation modified event disabled, therefore
+  // the other representations are not removed but they have to be reconverted.
+  std::vector<std::string> modifiedSegmentIDs;
+  for (const std::string& segmentID : context.ModifiedSegmentIDs)
+    {
+    vtkSegment* segment = segmentation->GetSegment(segmentID);
+    if (!segment)
+      {
+      continue;
+      }
+    modifiedSegmentIDs.push_back(segmentID);
+    if (vtkSlicerSegmentationsModuleLogic::GetSegmentStatus(segment) == vtkSlicerSegmentationsModuleLogic::NotStarted)
+      {
+      vtkSlicerSegmentationsModuleLogic::SetSegmentStatus(segment, vtkSlicerSegmentationsModuleLogic::InProgress);
+      }
+    }
+  if (!modifiedSegmentIDs.empty())
+    {
+    for (const std::string& representationName : representationNames)
+      {
+      if (representationName == binaryLabelmapName)
+        {
+        continue;
+        }
+      vtkNew<vtkSegmentationConversionPaths> paths;
+      segmentation->GetPossibleConversions(representationName, paths);
+      vtkSegmentationConversionPath* cheapestPath = vtkSegmentationConverter::GetCheapestPath(paths);
+      if (cheapestPath)
+        {
+        segmentation->ConvertSegmentsUsingPath(modifiedSegmentIDs, cheapestPath, true);
+        }
+      }
+    }
+
+  return success;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerSegmentEditingPipeline::ApplyOperation(vtkSlicerSegmentEditingContext& context,
+  const vtkSlicerSegmentEditingOperation& operation)
+{
+  vtkSegment* segment = context.Segmentation->GetSegment(operation.SegmentID);
+  if (!segment)
+    {
+    vtkErrorMacro("ApplyOperation: segment " << operation.SegmentID << " not found");
+    return false;
+    }
+  vtkOrientedImageData* segmentLabelmap = vtkOrientedImageData::SafeDownCast(
+    segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()));
+  if (!segmentLabelmap)
+    {
+    vtkErrorMacro("ApplyOperation: segment " << operation.SegmentID << " has no binary labelmap representation");
+    return false;
+    }
+
+  vtkNew<vtkOrientedImageData> modifierLabelmap;
+  int modificationMode = ModificationSet;
+  switch (operation.Type)
+    {
+    case OperationThreshold:
+      {
+      vtkOrientedImageData* sourceImage = GetAlignedSourceImage(context);
+      if (!sourceImage)
+        {
+        vtkErrorMacro("ApplyOperation: threshold operation requires a source image");
+        return false;
+        }
+      if (!context.BrickThreshold)
+        {
+        context.BrickThreshold = vtkSmartPointer<vtkImageBrickThreshold>::New();
+        }
+      context.BrickThreshold->SetInputImage(sourceImage);
+      if (!context.BrickThreshold->Execute(operation.Parameters[0], operation.Parameters[1], modifierLabelmap))
+        {
+        vtkErrorMacro("ApplyOperation: failed to threshold the source image");
+        return false;
+        }
+      break;
+      }
+
+    case OperationIslands:
+    case OperationMargin:
+    case OperationSmoothing:
+      {
+      if (!HasScalars(segmentLabelmap))
+        {
+        // Empty segment remains empty
+        return true;
+        }
+      vtkSmartPointer<vtkOrientedImageData> labelmap;
+      int labelValue = 0;
+      if (!GetSegmentLabelmap(context, segment, operation.Type != OperationIslands, labelmap, labelValue))
+        {
+        vtkErrorMacro("ApplyOperation: failed to get labelmap of segment " << operation.SegmentID);
+        return false;
+        }
+      if (operation.Type == OperationIslands)
+        {
+        vtkNew<vtkImageLabelIslands> labelIslands;
+        labelIslands->SetLabelmap(labelmap);
+        labelIslands->SetMinimumSize(operation.MinimumSize);
+        vtkNew<vtkOrientedImageData> islandImage;
+        if (!labelIslands->Execute(labelValue, islandImage))
+          {
+          vtkErrorMacro("ApplyOperation: failed to identify islands of segment " << operation.SegmentID);
+          return false;
+          }
+        // Islands are labeled in descending order of size, starting from 1
+        ThresholdToBinaryLabelmap(islandImage, 1, operation.KeepLargestIslandOnly ? 1 : VTK_UNSIGNED_INT_MAX, modifierLabelmap);
+        }
+      else if (operation.Type == OperationMargin)
+        {
+        vtkNew<vtkImageLabelMargin> labelMargin;
+        labelMargin->SetLabelmap(labelmap);
+        labelMargin->SetMarginSize(operation.Parameters[0]);
+        if (!labelMargin->Execute(labelValue, modifierLabelmap))
+          {
+          vtkErrorMacro("ApplyOperation: failed to apply margin on segment " << operation.SegmentID);
+          return false;
+          }
+        }
+      else
+        {
+        vtkNew<vtkImageLabelSmoothing> labelSmoothing;
+        labelSmoothing->SetLabelmap(labelmap);
+        labelSmoothing->SetMethod(operation.Method);
+        double* spacing = labelmap->GetSpacing();
+        if (operation.Method == vtkImageLabelSmoothing::Gaussian)
+          {
+          labelSmoothing->SetGaussianStandardDeviation(operation.Parameters[0] / spacing[0],
+            operation.Parameters[0] / spacing[1], operation.Parameters[0] / spacing[2]);
+          labelSmoothing->SetGaussianRadiusFactor(4.0);
+          }
+        else
+          {
+          // Size rounded to nearest odd number, same as in the Smoothing effect
+          int kernelSize[3] = { 1, 1, 1 };
+          for (int axis = 0; axis < 3; ++axis)
+            {
+            kernelSize[axis] = std::max(1, static_cast<int>(std::round((operation.Parameters[0] / spacing[axis] + 1.0) / 2.0)) * 2 - 1);
+            }
+          labelSmoothing->SetKernelSize(kernelSize);
+          }
+        if (!labelSmoothing->Execute(labelValue, modifierLabelmap))
+          {
+          vtkErrorMacro("ApplyOperation: failed to smooth segment " << operation.SegmentID);
+          return false;
+          }
+        }
+      break;
+      }
+
+    case OperationLogical:
+      {
+      // Labelmaps are computed in the reference geometry, or in the geometry of the segment if there is no reference geometry
+      vtkOrientedImageData* geometryImage = context.ReferenceGeometry ? context.ReferenceGeometry.GetPointer() : segmentLabelmap;
+      if (operation.Method == LogicalInvert || operation.Method == LogicalFill)
+        {
+        if (!context.ReferenceGeometry)
+          {
+          vtkErrorMacro("ApplyOperation: reference geometry is required for invert and fill operations");
+          return false;
+          }
+        PadImageToExtent(context.ReferenceGeometry, context.ReferenceGeometry->GetExtent(), modifierLabelmap);
+        vtkOrientedImageDataResample::FillImage(modifierLabelmap, 1);
+        if (operation.Method == LogicalInvert)
+          {
+          vtkNew<vtkOrientedImageData> segmentBinaryLabelmap;
+          if (!GetSegmentBinaryLabelmap(segment, geometryImage, segmentBinaryLabelmap))
+            {
+            vtkErrorMacro("ApplyOperation: failed to get labelmap of segment " << operation.SegmentID);
+            return false;
+            }
+          if (HasScalars(segmentBinaryLabelmap))
+            {
+            vtkOrientedImageDataResample::ApplyImageMask(modifierLabelmap, segmentBinaryLabelmap, 0, true);
+            }
+          }
+        }
+      else if (operation.Method == LogicalClear)
+        {
+        // empty modifier labelmap clears the segment
+        }
+      else
+        {
+        vtkSegment* modifierSegment = context.Segmentation->GetSegment(operation.ModifierSegmentID);
+        if (!modifierSegment)
+          {
+          vtkErrorMacro("ApplyOperation: modifier segment " << operation.ModifierSegmentID << " not found");
+          return false;
+          }
+        vtkNew<vtkOrientedImageData> modifierSegmentLabelmap;
+        if (!GetSegmentBinaryLabelmap(modifierSegment, geometryImage, modifierSegmentLabelmap))
+          {
+          vtkErrorMacro("ApplyOperation: failed to get labelmap of segment " << operation.ModifierSegmentID);
+          return false;
+          }
+        if (operation.Method == LogicalIntersect)
+          {
+          vtkNew<vtkOrientedImageData> segmentBinaryLabelmap;
+          if (!GetSegmentBinaryLabelmap(segment, geometryImage, segmentBinaryLabelmap))
+            {
+            vtkErrorMacro("ApplyOperation: failed to get labelmap of segment " << operation.SegmentID);
+            return false;
+            }
+          if (HasScalars(segmentBinaryLabelmap))
+            {
+            PadImageToExtent(modifierSegmentLabelmap, segmentBinaryLabelmap->GetExtent(), modifierLabelmap);
+            vtkOrientedImageDataResample::ModifyImage(modifierLabelmap, segmentBinaryLabelmap,
+              vtkOrientedImageDataResample::OPERATION_MINIMUM);
+            }
+          }
+        else
+          {
+          modifierLabelmap->ShallowCopy(modifierSegmentLabelmap);
+          if (operation.Method == LogicalUnion)
+            {
+            modificationMode = ModificationAdd;
+            }
+          else if (operation.Method == LogicalSubtract)
+            {
+            modificationMode = ModificationRemove;
+            }
+          }
+        }
+      break;
+      }
+
+    default:
+      vtkErrorMacro("ApplyOperation: unknown operation " << operation.Type);
+      return false;
+    }
+
+  return this->ModifySegment(context, operation.SegmentID, modifierLabelmap, modificationMode);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerSegmentEditingPipeline::ModifySegment(vtkSlicerSegmentEditingContext& context, const std::string& segmentID,
+  vtkOrientedImageData* modifierLabelmapInput, int modificationMode)
+{
+  vtkSegmentation* segmentation = context.Segmentation;
+  vtkSegment* segment = segmentation->GetSegment(segmentID);
+  vtkOrientedImageData* segmentLabelmap = vtkOrientedImageData::SafeDownCast(
+    segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()));
+
+  vtkSmartPointer<vtkOrientedImageData> modifierLabelmap = modifierLabelmapInput;
+  if (!HasScalars(modifierLabelmap))
+    {
+    if (modificationMode != ModificationSet || !HasScalars(segmentLabelmap))
+      {
+      // Nothing to add or remove
+      return true;
+      }
+    // Empty modifier labelmap in the region of the segment, clears the segment
+    modifierLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    vtkNew<vtkOrientedImageData> emptyLabelmap;
+    emptyLabelmap->CopyDirections(segmentLabelmap);
+    emptyLabelmap->SetOrigin(segmentLabelmap->GetOrigin());
+    emptyLabelmap->SetSpacing(segmentLabelmap->GetSpacing());
+    PadImageToExtent(emptyLabelmap, segmentLabelmap->GetExtent(), modifierLabelmap);
+    }
+  if (modifierLabelmap->GetScalarType() != VTK_UNSIGNED_CHAR)
+    {
+    vtkErrorMacro("ModifySegment: modifier labelmap must be unsigned char");
+    return false;
+    }
+
+  if (this->MaskMode != vtkMRMLSegmentationNode::EditAllowedEverywhere || this->SourceVolumeIntensityMask)
+    {
+    vtkSmartPointer<vtkOrientedImageData> maskedModifierLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    if (!this->ApplyEditMask(context, segmentID, modifierLabelmap, modificationMode, maskedModifierLabelmap))
+      {
+      return false;
+      }
+    modifierLabelmap = maskedModifierLabelmap;
+    }
+
+  std::vector<std::string> segmentIDsToOverwrite;
+  if (this->OverwriteMode == vtkMRMLSegmentEditorNode::OverwriteAllSegments && modificationMode != ModificationRemove)
+    {
+    segmentation->GetSegmentIDs(segmentIDsToOverwrite);
+    segmentIDsToOverwrite.erase(std::remove(segmentIDsToOverwrite.begin(), segmentIDsToOverwrite.end(), segmentID),
+      segmentIDsToOverwrite.end());
+    }
+
+  std::vector<std::string> modifiedSegmentIDs;
+  bool success = false;
+  if (modificationMode == ModificationRemove)
+    {
+    // Keep the segment where the modifier labelmap is 0
+    vtkNew<vtkImageThreshold> inverter;
+    inverter->SetInputData(modifierLabelmap);
+    inverter->ThresholdByLower(0);
+    inverter->SetInValue(VTK_UNSIGNED_CHAR_MAX);
+    inverter->SetOutValue(0);
+    inverter->SetOutputScalarTypeToUnsignedChar();
+    inverter->Update();
+    vtkNew<vtkOrientedImageData> invertedModifierLabelmap;
+    invertedModifierLabelmap->ShallowCopy(inverter->GetOutput());
+    invertedModifierLabelmap->CopyDirections(modifierLabelmap);
+    success = vtkSegmentationModifier::ModifyBinaryLabelmap(invertedModifierLabelmap, segmentation, segmentID,
+      vtkSegmentationModifier::MODE_MERGE_MIN, nullptr, false, false, segmentIDsToOverwrite, &modifiedSegmentIDs);
+    }
+  else
+    {
+    int mergeMode = (modificationMode == ModificationSet ? vtkSegmentationModifier::MODE_REPLACE : vtkSegmentationModifier::MODE_MERGE_MASK);
+    success = vtkSegmentationModifier::ModifyBinaryLabelmap(modifierLabelmap, segmentation, segmentID,
+      mergeMode, nullptr, false, false, segmentIDsToOverwrite, &modifiedSegmentIDs);
+    }
+  if (!success)
+    {
+    vtkErrorMacro("ModifySegment: failed to modify segment " << segmentID);
+    return false;
+    }
+  context.ModifiedSegmentIDs.insert(segmentID);
+  context.ModifiedSegmentIDs.insert(modifiedSegmentIDs.begin(), modifiedSegmentIDs.end());
+
+  if (!segmentIDsToOverwrite.empty())
+    {
+    return EraseModifierFromOtherLayers(context, segmentID, modifierLabelmap);
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerSegmentEditingPipeline::ApplyEditMask(vtkSlicerSegmentEditingContext& context, const std::string& segmentID,
+  vtkOrientedImageData* modifierLabelmap, int modificationMode, vtkOrientedImageData* maskedModifierLabelmap)
+{
+  vtkSegmentation* segmentation = context.Segmentation;
+  vtkSegment* segment = segmentation->GetSegment(segmentID);
+
+  // In set mode the segment is kept outside the editable area. In remove mode the segment is editable
+  // when editing inside a single segment (same as in the segment editor).
+  const bool keepSegment = (modificationMode == ModificationSet);
+  const bool segmentEditable = (modificationMode == ModificationRemove
+    && this->MaskMode == vtkMRMLSegmentationNode::EditAllowedInsideSingleSegment);
+
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  modifierLabelmap->GetExtent(extent);
+  vtkNew<vtkOrientedImageData> segmentBinaryLabelmap;
+  if (keepSegment || segmentEditable)
+    {
+    vtkNew<vtkOrientedImageData> segmentLabelmap;
+    if (!GetSegmentBinaryLabelmap(segment, modifierLabelmap, segmentLabelmap))
+      {
+      vtkErrorMacro("ApplyEditMask: failed to get labelmap of segment " << segmentID);
+      return false;
+      }
+    if (keepSegment)
+      {
+      GetExtentUnion(extent, segmentLabelmap->GetExtent(), extent);
+      }
+    PadImageToExtent(segmentLabelmap, extent, segmentBinaryLabelmap);
+    }
+  PadImageToExtent(modifierLabelmap, extent, maskedModifierLabelmap);
+
+  // Segments that specify the editable area
+  bool editInsideSegments = false;
+  std::vector<std::string> maskSegmentIDs;
+  if (this->MaskMode == vtkMRMLSegmentationNode::EditAllowedInsideAllSegments
+    || this->MaskMode == vtkMRMLSegmentationNode::EditAllowedOutsideAllSegments)
+    {
+    editInsideSegments = (this->MaskMode == vtkMRMLSegmentationNode::EditAllowedInsideAllSegments);
+    segmentation->GetSegmentIDs(maskSegmentIDs);
+    }
+  else if (this->MaskMode == vtkMRMLSegmentationNode::EditAllowedInsideSingleSegment)
+    {
+    editInsideSegments = true;
+    if (this->MaskSegmentID && segmentation->GetSegment(this->MaskSegmentID))
+      {
+      maskSegmentIDs.push_back(this->MaskSegmentID);
+      }
+    else
+      {
+      vtkWarningMacro("ApplyEditMask: EditAllowedInsideSingleSegment selected but mask segment is not found");
+      }
+    }
+  if (!editInsideSegments)
+    {
+    // Exclude edited segment from "outside" mask
+    maskSegmentIDs.erase(std::remove(maskSegmentIDs.begin(), maskSegmentIDs.end(), segmentID), maskSegmentIDs.end());
+    }
+  vtkNew<vtkOrientedImageData> maskSegmentsLabelmap;
+  if (!maskSegmentIDs.empty())
+    {
+    if (!segmentation->GenerateMergedLabelmap(maskSegmentsLabelmap, vtkSegmentation::EXTENT_REFERENCE_GEOMETRY,
+      maskedModifierLabelmap, maskSegmentIDs))
+      {
+      vtkErrorMacro("ApplyEditMask: failed to generate mask from segments");
+      return false;
+      }
+    }
+  const bool maskBySegments = (this->MaskMode != vtkMRMLSegmentationNode::EditAllowedEverywhere);
+  // If there are no mask segments then everything is editable outside segments, nothing is editable inside segments
+  const bool editableWithoutMaskSegments = !editInsideSegments;
+
+  // Editable intensity range
+  vtkNew<vtkOrientedImageData> intensityMaskLabelmap;
+  if (this->SourceVolumeIntensityMask)
+    {
+    vtkSmartPointer<vtkOrientedImageData> sourceImage = context.SourceImage;
+    if (!vtkOrientedImageDataResample::DoGeometriesMatch(sourceImage, maskedModifierLabelmap))
+      {
+      sourceImage = vtkSmartPointer<vtkOrientedImageData>::New();
+      if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+        context.SourceImage, maskedModifierLabelmap, sourceImage, true /* linear interpolation */))
+        {
+        vtkErrorMacro("ApplyEditMask: failed to resample source image");
+        return false;
+        }
+      }
+    vtkNew<vtkOrientedImageData> intensityInRangeLabelmap;
+    ThresholdToBinaryLabelmap(sourceImage, this->SourceVolumeIntensityMaskRange[0], this->SourceVolumeIntensityMaskRange[1],
+      intensityInRangeLabelmap);
+    // Voxels outside the source image are not editable
+    PadImageToExtent(intensityInRangeLabelmap, extent, intensityMaskLabelmap);
+    }
+
+  unsigned char* modifierPtr = static_cast<unsigned char*>(maskedModifierLabelmap->GetScalarPointer());
+  const unsigned char* segmentPtr = (keepSegment || segmentEditable)
+    ? static_cast<unsigned char*>(segmentBinaryLabelmap->GetScalarPointer()) : nullptr;
+  const short* maskSegmentsPtr = maskSegmentIDs.empty() ? nullptr : static_cast<short*>(maskSegmentsLabelmap->GetScalarPointer());
+  const unsigned char* intensityMaskPtr = this->SourceVolumeIntensityMask
+    ? static_cast<unsigned char*>(intensityMaskLabelmap->GetScalarPointer()) : nullptr;
+  const vtkIdType numberOfVoxels = maskedModifierLabelmap->GetNumberOfPoints();
+  vtkSMPTools::For(0, numberOfVoxels, [&](vtkIdType firstVoxel, vtkIdType lastVoxel)
+    {
+    for (vtkIdType voxelIndex = firstVoxel; voxelIndex < lastVoxel; ++voxelIndex)
+      {
+      bool editable = true;
+      if (maskBySegments)
+        {
+        editable = maskSegmentsPtr ? ((maskSegmentsPtr[voxelIndex] != 0) == editInsideSegments) : editableWithoutMaskSegments;
+        }
+      if (intensityMaskPtr && intensityMaskPtr[voxelIndex] == 0)
+        {
+        editable = false;
+        }
+      if (segmentEditable && segmentPtr[voxelIndex] != 0)
+        {
+        editable = true;
+        }
+      if (!editable)
+        {
+        modifierPtr[voxelIndex] = (keepSegment ? segmentPtr[voxelIndex] : 0);
+        }
+      }
+    });
+  maskedModifierLabelmap->Modified();
+  return true;
+}
@@ -0,0 +1,176 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef vtkSlicerSegmentEditingPipeline_h
+#define vtkSlicerSegmentEditingPipeline_h
+
+#include "vtkSlicerSegmentationsModuleLogicExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <memory>
+#include <string>
+#include <vector>
+
+class vtkOrientedImageData;
+class vtkSegmentation;
+struct vtkSlicerSegmentEditingContext;
+struct vtkSlicerSegmentEditingOperation;
+
+/// \brief Apply a sequence of segment editing operations to a segmentation without the segment editor.
+///
+/// Operations are added to the pipeline by the Add... methods and are applied in the order
+/// they were added by Execute. Operations modify the binary labelmap layers of the segmentation
+/// directly, using the native label operations of this module (vtkImageBrickThreshold,
+/// vtkImageLabelIslands, vtkImageLabelMargin, vtkImageLabelSmoothing), therefore no Qt,
+/// segment editor widget, or MRML scene is needed.
+///
+/// Masking and overwriting of other segments follow the segment editor: modifications are
+/// restricted to the editable area specified by MaskMode, MaskSegmentID, and the editable
+/// intensity range, and other segments are overwritten according to OverwriteMode.
+///
+/// Labelmaps are computed in the reference image geometry of the segmentation. If the segmentation
+/// has no reference image geometry then the geometry of the source image is used.
+/// The source image is resampled to the reference geometry if their geometries are different.
+///
+/// The pipeline itself is not modified by Execute, therefore the same pipeline can be executed
+/// on different segmentations concurrently (see vtkSlicerSegmentationsModuleLogic::ApplySegmentEditingPipeline).
+class VTK_SLICER_SEGMENTATIONS_LOGIC_EXPORT vtkSlicerSegmentEditingPipeline : public vtkObject
+{
+public:
+  static vtkSlicerSegmentEditingPipeline* New();
+  vtkTypeMacro(vtkSlicerSegmentEditingPipeline, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  enum
+    {
+    OperationThreshold,
+    OperationIslands,
+    OperationMargin,
+    OperationSmoothing,
+    OperationLogical,
+    Operation_Last // must be last
+    };
+
+  enum
+    {
+    LogicalCopy,
+    LogicalUnion,
+    LogicalIntersect,
+    LogicalSubtract,
+    LogicalInvert,
+    LogicalClear,
+    LogicalFill,
+    Logical_Last // must be last
+    };
+
+  /// Set the segment to the voxels of the source image that are in the [lowerThreshold, upperThreshold] range.
+  void AddThreshold(const std::string& segmentID, double lowerThreshold, double upperThreshold);
+
+  /// Remove islands of the segment that have fewer voxels than minimumSize.
+  /// If keepLargestIslandOnly is enabled then only the largest island is kept.
+  void AddIslands(const std::string& segmentID, vtkIdType minimumSize, bool keepLargestIslandOnly = false);
+
+  /// Grow (positive margin size) or shrink (negative margin size) the segment. Margin size is in mm.
+  void AddMargin(const std::string& segmentID, double marginSizeMm);
+
+  /// Smooth the segment.
+  /// \param method Smoothing method (vtkImageLabelSmoothing::Median, MorphologicalOpening, MorphologicalClosing, Gaussian).
+  /// \param kernelSizeMm Kernel size in mm. For Gaussian smoothing it is the standard deviation of the kernel.
+  void AddSmoothing(const std::string& segmentID, int method, double kernelSizeMm);
+
+  /// Apply a logical operation on the segment.
+  /// \param operation LogicalCopy, LogicalUnion, LogicalIntersect, LogicalSubtract, LogicalInvert, LogicalClear, LogicalFill.
+  /// \param modifierSegmentID Segment used as second operand by copy, union, intersect, and subtract operations.
+  void AddLogicalOperation(const std::string& segmentID, int operation, const std::string& modifierSegmentID = "");
+
+  /// Remove all operations from the pipeline
+  void RemoveAllOperations();
+
+  /// Number of operations in the pipeline
+  int GetNumberOfOperations();
+
+  /// Area where segments can be modified (vtkMRMLSegmentationNode::EditAllowedEverywhere, EditAllowedInsideAllSegments,
+  /// EditAllowedOutsideAllSegments, EditAllowedInsideSingleSegment). Default is EditAllowedEverywhere.
+  /// Visibility based modes are not supported, as segment visibility is not stored in the segmentation.
+  vtkSetMacro(MaskMode, int);
+  vtkGetMacro(MaskMode, int);
+
+  /// Segment that specifies the editable area if MaskMode is EditAllowedInsideSingleSegment
+  vtkSetStringMacro(MaskSegmentID);
+  vtkGetStringMacro(MaskSegmentID);
+
+  /// If enabled then only voxels that have source image intensity within SourceVolumeIntensityMaskRange are editable.
+  vtkSetMacro(SourceVolumeIntensityMask, bool);
+  vtkGetMacro(SourceVolumeIntensityMask, bool);
+  vtkBooleanMacro(SourceVolumeIntensityMask, bool);
+  vtkSetVector2Macro(SourceVolumeIntensityMaskRange, double);
+  vtkGetVector2Macro(SourceVolumeIntensityMaskRange, double);
+
+  /// Specifies if other segments are overwritten where the edited segment is set
+  /// (vtkMRMLSegmentEditorNode::OverwriteAllSegments or OverwriteNone). Default is OverwriteAllSegments.
+  vtkSetMacro(OverwriteMode, int);
+  vtkGetMacro(OverwriteMode, int);
+
+  /// Apply all operations on the segmentation, in the order they were added.
+  /// Master representation of the segmentation must be binary labelmap.
+  /// \param sourceImage Source image, only needed by threshold and editable intensity range masking.
+  ///   It must be in the same coordinate system as the segmentation.
+  /// \return False if any of the operations failed. Operations after the failed operation are not applied.
+  bool Execute(vtkSegmentation* segmentation, vtkOrientedImageData* sourceImage = nullptr);
+
+protected:
+  vtkSlicerSegmentEditingPipeline();
+  ~vtkSlicerSegmentEditingPipeline() override;
+
+  /// Modification modes, same as in qSlicerSegmentEditorAbstractEffect
+  enum
+    {
+    ModificationSet,
+    ModificationAdd,
+    ModificationRemove
+    };
+
+  /// Apply a single operation
+  bool ApplyOperation(vtkSlicerSegmentEditingContext& context, const vtkSlicerSegmentEditingOperation& operation);
+
+  /// Modify the segment by a binary modifier labelmap, applying masking and overwriting of other segments.
+  /// \param modificationMode ModificationSet, ModificationAdd, or ModificationRemove.
+  bool ModifySegment(vtkSlicerSegmentEditingContext& context, const std::string& segmentID,
+    vtkOrientedImageData* modifierLabelmap, int modificationMode);
+
+  /// Restrict modifier labelmap to the editable area.
+  /// In set mode the segment is kept outside the editable area.
+  bool ApplyEditMask(vtkSlicerSegmentEditingContext& context, const std::string& segmentID,
+    vtkOrientedImageData* modifierLabelmap, int modificationMode, vtkOrientedImageData* maskedModifierLabelmap);
+
+  int MaskMode;
+  char* MaskSegmentID{ nullptr };
+  bool SourceVolumeIntensityMask{ false };
+  double SourceVolumeIntensityMaskRange[2]{ 0.0, 0.0 };
+  int OverwriteMode;
+
+  std::vector<std::shared_ptr<vtkSlicerSegmentEditingOperation>> Operations;
+
+private:
+  vtkSlicerSegmentEditingPipeline(const vtkSlicerSegmentEditingPipeline&) = delete;
+  void operator=(const vtkSlicerSegmentEditingPipeline&) = delete;
+};
+
+#endif
@@ -29,6 +29,7 @@
 #include "vtkOrientedImageData.h"
 #include "vtkOrientedImageDataResample.h"
 #include "vtkSegmentationConverterFactory.h"
+#include "vtkSlicerSegmentEditingPipeline.h"
 #include <vtkSegmentationModifier.h>
 
 // Terminologies includes
@@ -39,6 +40,7 @@
 #include <vtkActor.h>
 #include <vtkAppendPolyData.h>
 #include <vtkCallbackCommand.h>
+#include <vtkCollection.h>
 #include <vtkDataObject.h>
 #include <vtkGeneralTransform.h>
 #include <vtkGeometryFilter.h>
@@ -57,6 +59,7 @@
 #include <vtkProperty.h>
 #include <vtkRenderer.h>
 #include <vtkRenderWindow.h>
+#include <vtkSMPTools.h>
 #include <vtkSTLWriter.h>
 #include <vtkStringArray.h>
 #include <vtkTransform.h>
@@ -86,6 +89,7 @@
 #include <vtkEventBroker.h>
 
 // STD includes
+#include <algorithm>
 #include <sstream>
 
 //----------------------------------------------------------------------------
@@ -2669,6 +2673,45 @@ bool vtkSlicerSegmentationsModuleLogic::ReconvertAllRepresentations(vtkMRMLSegme
   return conversionHappened;
 }
 
+//-----------------------------------------------------------------------------
+bool vtkSlicerSegmentationsModuleLogic::UpdateSegmentsModifiedInPlace(vtkMRMLSegmentationNode* segmentationNode,
+  vtkStringArray* segmentIDs)
+{
+  if (!segmentationNode || !segmentationNode->GetSegmentation())
+    {
+    vtkErrorWithObjectMacro(nullptr, "Invalid segmentation node!");
+    return false;
+    }
+  if (!segmentIDs || segmentIDs->GetNumberOfValues() == 0)
+    {
+    return true;
+    }
+  vtkSegmentation* segmentation = segmentationNode->GetSegmentation();
+  std::vector<std::string> segmentIDsVector;
+  for (int segmentIndex = 0; segmentIndex < segmentIDs->GetNumberOfValues(); ++segmentIndex)
+    {
+    std::string segmentID = segmentIDs->GetValue(segmentIndex);
+    if (!segmentation->GetSegment(segmentID))
+      {
+      vtkErrorWithObjectMacro(nullptr, "UpdateSegmentsModifiedInPlace: segment " << segmentID << " not found");
+      continue;
+      }
+    segmentIDsVector.push_back(segmentID);
+    }
+  if (segmentIDsVector.empty())
+    {
+    return false;
+    }
+
+  vtkSlicerSegmentationsModuleLogic::ReconvertAllRepresentations(segmentationNode, segmentIDsVector);
+  for (const std::string& segmentID : segmentIDsVector)
+    {
+    segmentation->InvokeEvent(vtkSegmentation::MasterRepresentationModified, (void*)segmentID.c_str());
+    segmentation->InvokeEvent(vtkSegmentation::RepresentationModified, (void*)segmentID.c_str());
+    }
+  return true;
+}
+
 //-----------------------------------------------------------------------------
 void vtkSlicerSegmentationsModuleLogic::CollapseBinaryLabelmaps(vtkMRMLSegmentationNode* segmentationNode, bool forceToSingleLayer)
 {
@@ -2748,3 +2791,83 @@ bool vtkSlicerSegmentationsModuleLogic::IsSegmentationExentOutsideReferenceGeome
     }
   return false;
 }
+
+//-----------------------------------------------------------------------------
+bool vtkSlicerSegmentationsModuleLogic::ApplySegmentEditingPipeline(vtkSlicerSegmentEditingPipeline* pipeline,
+  vtkMRMLSegmentationNode* segmentationNode, vtkMRMLScalarVolumeNode* sourceVolumeNode/*=nullptr*/)
+{
+  if (!pipeline || !segmentationNode || !segmentationNode->GetSegmentation())
+    {
+    vtkGenericWarningMacro("vtkSlicerSegmentationsModuleLogic::ApplySegmentEditingPipeline: Invalid inputs");
+    return false;
+    }
+
+  vtkSmartPointer<vtkOrientedImageData> sourceImage;
+  if (sourceVolumeNode)
+    {
+    sourceImage = vtkSmartPointer<vtkOrientedImageData>::Take(
+      vtkSlicerSegmentationsModuleLogic::CreateOrientedImageDataFromVolumeNode(sourceVolumeNode, segmentationNode->GetParentTransformNode()));
+    if (!sourceImage)
+      {
+      vtkGenericWarningMacro("vtkSlicerSegmentationsModuleLogic::ApplySegmentEditingPipeline: Failed to get image from source volume");
+      return false;
+      }
+    }
+
+  MRMLNodeModifyBlocker blocker(segmentationNode);
+  return pipeline->Execute(segmentationNode->GetSegmentation(), sourceImage);
+}
+
+//-----------------------------------------------------------------------------
+bool vtkSlicerSegmentationsModuleLogic::ApplySegmentEditingPipeline(vtkSlicerSegmentEditingPipeline* pipeline,
+  vtkCollection* segmentations, vtkCollection* sourceImages/*=nullptr*/)
+{
+  if (!pipeline || !segmentations)
+    {
+    vtkGenericWarningMacro("vtkSlicerSegmentationsModuleLogic::ApplySegmentEditingPipeline: Invalid inputs");
+    return false;
+    }
+  int numberOfSegmentations = segmentations->GetNumberOfItems();
+  if (sourceImages && sourceImages->GetNumberOfItems() != numberOfSegmentations)
+    {
+    vtkGenericWarningMacro("vtkSlicerSegmentationsModuleLogic::ApplySegmentEditingPipeline: Number of source images ("
+      << sourceImages->GetNumberOfItems() << ") does not match the number of segmentations (" << numberOfSegmentations << ")");
+    return false;
+    }
+
+  std::vector<vtkSegmentation*> segmentationList;
+  std::vector<vtkSmartPointer<vtkOrientedImageData>> sourceImageList(numberOfSegmentations);
+  for (int index = 0; index < numberOfSegmentations; ++index)
+    {
+    vtkSegmentation* segmentation = vtkSegmentation::SafeDownCast(segmentations->GetItemAsObject(index));
+    if (!segmentation || std::find(segmentationList.begin(), segmentationList.end(), segmentation) != segmentationList.end())
+      {
+      vtkGenericWarningMacro("vtkSlicerSegmentationsModuleLogic::ApplySegmentEditingPipeline: Invalid or duplicate segmentation at index " << index);
+      return false;
+      }
+    segmentationList.push_back(segmentation);
+    if (sourceImages)
+      {
+      vtkOrientedImageData* sourceImage = vtkOrientedImageData::SafeDownCast(sourceImages->GetItemAsObject(index));
+      if (!sourceImage)
+        {
+        vtkGenericWarningMacro("vtkSlicerSegmentationsModuleLogic::ApplySegmentEditingPipeline: Invalid source image at index " << index);
+        return false;
+        }
+      // Source images may be shared between segmentations, use a shallow copy in each thread
+      sourceImageList[index] = vtkSmartPointer<vtkOrientedImageData>::New();
+      sourceImageList[index]->ShallowCopy(sourceImage);
+      }
+    }
+
+  std::vector<unsigned char> results(numberOfSegmentations, 0);
+  vtkSMPTools::For(0, numberOfSegmentations, 1, [&](vtkIdType begin, vtkIdType end)
+    {
+    for (vtkIdType index = begin; index < end; ++index)
+      {
+      results[index] = pipeline->Execute(segmentationList[index], sourceImageList[index]) ? 1 : 0;
+      }
+    });
+
+  return std::find(results.begin(), results.end(), 0) == results.end();
+}
@@ -34,6 +34,7 @@
 #include "vtkMRMLSegmentationNode.h"
 
 class vtkCallbackCommand;
+class vtkCollection;
 class vtkOrientedImageData;
 class vtkPolyData;
 class vtkDataObject;
@@ -44,6 +45,7 @@ class vtkMRMLScalarVolumeNode;
 class vtkMRMLLabelMapVolumeNode;
 class vtkMRMLVolumeNode;
 class vtkMRMLModelNode;
+class vtkSlicerSegmentEditingPipeline;
 class vtkSlicerTerminologiesModuleLogic;
 
 /// \ingroup Slicer_QtModules_Segmentations
@@ -425,6 +427,14 @@ public:
   static bool ReconvertAllRepresentations(vtkMRMLSegmentationNode* segmentationNode,
     const std::vector<std::string>& segmentIDs={});
 
+  /// Update segments after their binary labelmap was modified in place with master representation modified
+  /// event disabled (therefore representations of the other segments in the same layer are preserved).
+  /// Other representations of the specified segments are reconverted and master representation modified
+  /// and representation modified events are invoked for each of them.
+  /// \param segmentationNode Node containing the segmentation
+  /// \param segmentIDs Segment IDs of the modified segments
+  static bool UpdateSegmentsModifiedInPlace(vtkMRMLSegmentationNode* segmentationNode, vtkStringArray* segmentIDs);
+
   /// Collapse all segments into fewer shared labelmap layers
   /// \param segmentationNode Node containing the segmentation
   /// \param forceToSingleLayer If false, then the layers will not be overwritten by each other, if true then the layers can
@@ -456,6 +466,22 @@ public:
   /// \return True if the segmentation extent is outside of the reference volume, False otherwise.
   static bool IsSegmentationExentOutsideReferenceGeometry(vtkOrientedImageData* referenceGeometry, vtkOrientedImageData* segmentationGeometry);
 
+  /// Apply all operations of a segment editing pipeline on a segmentation node.
+  /// \param sourceVolumeNode Source volume, only needed by threshold operations and editable intensity range masking.
+  /// \return True on success
+  static bool ApplySegmentEditingPipeline(vtkSlicerSegmentEditingPipeline* pipeline, vtkMRMLSegmentationNode* segmentationNode,
+    vtkMRMLScalarVolumeNode* sourceVolumeNode = nullptr);
+
+  /// Apply all operations of a segment editing pipeline on multiple segmentations, processing the segmentations in parallel.
+  /// Segmentations must not be observed (for example, they must not be segmentations of nodes displayed in the scene),
+  /// as events are invoked from worker threads.
+  /// \param segmentations Collection of vtkSegmentation objects. Each segmentation must occur only once.
+  /// \param sourceImages Optional collection of vtkOrientedImageData objects, one for each segmentation,
+  ///   in the coordinate system of the segmentation.
+  /// \return True if all segmentations were processed successfully
+  static bool ApplySegmentEditingPipeline(vtkSlicerSegmentEditingPipeline* pipeline, vtkCollection* segmentations,
+    vtkCollection* sourceImages = nullptr);
+
 protected:
   void SetMRMLSceneInternal(vtkMRMLScene * newScene) override;
 
@@ -0,0 +1,246 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// Segmentations includes
+#include "vtkImageBrickThreshold.h"
+
+// vtkSegmentationCore includes
+#include "vtkOrientedImageData.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageThreshold.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+// STD includes
+#include <cmath>
+#include <limits>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Create a CT-like image: air background, a body with soft tissue and noise, and a bone.
+/// Scalar type is short or float (in the float image a few voxels are NaN).
+void CreateImage(vtkOrientedImageData* image, const int dimensions[3], int scalarType)
+{
+  image->SetExtent(-7, dimensions[0] - 8, 3, dimensions[1] + 2, 0, dimensions[2] - 1);
+  image->SetSpacing(0.7, 0.7, 1.2);
+  image->SetOrigin(-20.0, 15.0, 3.0);
+  image->SetDirections(1.0, 0.0, 0.0, 0.0, 0.0, -1.0, 0.0, 1.0, 0.0);
+  image->AllocateScalars(scalarType, 1);
+  int* extent = image->GetExtent();
+  for (int k = 0; k < dimensions[2]; ++k)
+    {
+    for (int j = 0; j < dimensions[1]; ++j)
+      {
+      for (int i = 0; i < dimensions[0]; ++i)
+        {
+        const double squaredRadius = pow((i - dimensions[0] * 0.5) / (dimensions[0] * 0.4), 2)
+          + pow((j - dimensions[1] * 0.5) / (dimensions[1] * 0.35), 2);
+        const double boneSquaredRadius = pow((i - dimensions[0] * 0.6) / 6.0, 2) + pow((j - dimensions[1] * 0.45) / 5.0, 2);
+        const int noise = (i * 7919 + j * 104729 + k * 1299709) % 61 - 30;
+        double value = -1000.0;
+        if (boneSquaredRadius <= 1.0)
+          {
+          value = 700.0 + 4.0 * noise;
+          }
+        else if (squaredRadius <= 1.0)
+          {
+          value = 40.0 + noise + 20.0 * sin(k * 0.3);
+          }
+        if (scalarType == VTK_FLOAT)
+          {
+          if ((i + 3 * j + 5 * k) % 997 == 0)
+            {
+            value = std::numeric_limits<double>::quiet_NaN();
+            }
+          else
+            {
+            value += 0.25;
+            }
+          }
+        image->SetScalarComponentFromDouble(extent[0] + i, extent[2] + j, extent[4] + k, 0, value);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Count voxels that differ from the output of vtkImageThreshold.
+/// Voxels outside the output extent are expected to be 0.
+int CountMismatchingVoxels(vtkOrientedImageData* image, double lowerThreshold, double upperThreshold, vtkOrientedImageData* output)
+{
+  vtkNew<vtkImageThreshold> threshold;
+  threshold->SetInputData(image);
+  threshold->ThresholdBetween(lowerThreshold, upperThreshold);
+  threshold->SetInValue(1);
+  threshold->SetOutValue(0);
+  threshold->SetOutputScalarTypeToUnsignedChar();
+  threshold->Update();
+  vtkImageData* expected = threshold->GetOutput();
+
+  int* extent = image->GetExtent();
+  int* outputExtent = output->GetExtent();
+  int mismatchingVoxels = 0;
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+        {
+        unsigned char value = 0;
+        if (i >= outputExtent[0] && i <= outputExtent[1] && j >= outputExtent[2] && j <= outputExtent[3]
+          && k >= outputExtent[4] && k <= outputExtent[5])
+          {
+          value = *static_cast<unsigned char*>(output->GetScalarPointer(i, j, k));
+          }
+        if (value != *static_cast<unsigned char*>(expected->GetScalarPointer(i, j, k)))
+          {
+          ++mismatchingVoxels;
+          }
+        }
+      }
+    }
+  return mismatchingVoxels;
+}
+
+//----------------------------------------------------------------------------
+int TestThreshold(int scalarType)
+{
+  const int dimensions[3] = { 70, 61, 37 };
+  vtkNew<vtkOrientedImageData> image;
+  CreateImage(image, dimensions, scalarType);
+
+  vtkNew<vtkImageBrickThreshold> threshold;
+  threshold->SetInputImage(image);
+  vtkNew<vtkOrientedImageData> output;
+
+  // Thresholds are changed in small steps, in large steps, non-integer values, values outside
+  // the range of the scalar type, and lower threshold larger than upper threshold.
+  const double thresholdRanges[][2] =
+    {
+    { 20.0, 80.0 }, { 20.0, 80.0 }, { 25.0, 80.0 }, { 25.0, 75.5 }, { -200.0, 3000.0 }, { 650.5, 1e10 },
+    { -1e10, -999.0 }, { 10.0, -10.0 }, { 30.0, 45.0 }, { -1000.0, 1000.0 }
+    };
+  for (const auto& thresholdRange : thresholdRanges)
+    {
+    CHECK_BOOL(threshold->Execute(thresholdRange[0], thresholdRange[1], output), true);
+    CHECK_INT(output->GetScalarType(), VTK_UNSIGNED_CHAR);
+    CHECK_INT(CountMismatchingVoxels(image, thresholdRange[0], thresholdRange[1], output), 0);
+    }
+
+  // Output geometry is the same as the input
+  double spacing[3] = { 0.0, 0.0, 0.0 };
+  output->GetSpacing(spacing);
+  CHECK_DOUBLE_TOLERANCE(spacing[2], 1.2, 1e-9);
+  double directions[3][3] = { { 0.0 } };
+  output->GetDirections(directions);
+  CHECK_DOUBLE_TOLERANCE(directions[1][2], -1.0, 1e-9);
+
+  // Cropped output only contains the body
+  CHECK_BOOL(threshold->Execute(0.0, 100.0, output), true);
+  CHECK_BOOL(output->GetExtent()[0] > image->GetExtent()[0], true);
+  CHECK_BOOL(output->GetExtent()[1] < image->GetExtent()[1], true);
+  threshold->CropOutputOff();
+  CHECK_BOOL(threshold->Execute(0.0, 100.0, output), true);
+  CHECK_INT(output->GetExtent()[0], image->GetExtent()[0]);
+  CHECK_INT(output->GetExtent()[5], image->GetExtent()[5]);
+  CHECK_INT(CountMismatchingVoxels(image, 0.0, 100.0, output), 0);
+
+  // Empty output if no voxels are in the threshold range
+  threshold->CropOutputOn();
+  CHECK_BOOL(threshold->Execute(5000.0, 6000.0, output), true);
+  CHECK_BOOL(output->IsEmpty(), true);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestIncrementalUpdate()
+{
+  const int dimensions[3] = { 70, 61, 37 };
+  vtkNew<vtkOrientedImageData> image;
+  CreateImage(image, dimensions, VTK_SHORT);
+
+  vtkNew<vtkImageBrickThreshold> threshold;
+  threshold->SetInputImage(image);
+  vtkNew<vtkOrientedImageData> output;
+
+  // First execution computes all bricks
+  CHECK_BOOL(threshold->Execute(500.0, 2000.0, output), true);
+  CHECK_INT(threshold->GetNumberOfBricks(), 9 * 8 * 5);
+  CHECK_INT(threshold->GetNumberOfUpdatedBricks(), threshold->GetNumberOfBricks());
+
+  // Same thresholds, nothing to update
+  CHECK_BOOL(threshold->Execute(500.0, 2000.0, output), true);
+  CHECK_INT(threshold->GetNumberOfUpdatedBricks(), 0);
+
+  // Changing the upper threshold above all values does not change anything.
+  // Changing the lower threshold only updates bricks that contain bone.
+  CHECK_BOOL(threshold->Execute(500.0, 3000.0, output), true);
+  CHECK_INT(threshold->GetNumberOfUpdatedBricks(), 0);
+  CHECK_BOOL(threshold->Execute(600.0, 3000.0, output), true);
+  CHECK_BOOL(threshold->GetNumberOfUpdatedBricks() > 0, true);
+  CHECK_BOOL(threshold->GetNumberOfUpdatedBricks() < threshold->GetNumberOfBricks() / 4, true);
+  CHECK_INT(CountMismatchingVoxels(image, 600.0, 3000.0, output), 0);
+
+  // Modified input image is fully recomputed
+  int* extent = image->GetExtent();
+  *static_cast<short*>(image->GetScalarPointer(extent[0], extent[2], extent[4])) = 800;
+  image->Modified();
+  CHECK_BOOL(threshold->Execute(600.0, 3000.0, output), true);
+  CHECK_INT(threshold->GetNumberOfUpdatedBricks(), threshold->GetNumberOfBricks());
+  CHECK_INT(output->GetExtent()[0], extent[0]);
+  CHECK_INT(CountMismatchingVoxels(image, 600.0, 3000.0, output), 0);
+
+  // Changing the brick size recomputes everything
+  threshold->SetBrickSize(16);
+  CHECK_BOOL(threshold->Execute(600.0, 3000.0, output), true);
+  CHECK_INT(threshold->GetNumberOfBricks(), 5 * 4 * 3);
+  CHECK_INT(threshold->GetNumberOfUpdatedBricks(), threshold->GetNumberOfBricks());
+  CHECK_INT(CountMismatchingVoxels(image, 600.0, 3000.0, output), 0);
+
+  threshold->ClearCache();
+  CHECK_BOOL(threshold->Execute(600.0, 3000.0, output), true);
+  CHECK_INT(threshold->GetNumberOfUpdatedBricks(), threshold->GetNumberOfBricks());
+
+  // Invalid inputs
+  vtkNew<vtkImageBrickThreshold> thresholdWithoutInput;
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(thresholdWithoutInput->Execute(0.0, 1.0, output), false);
+  CHECK_BOOL(threshold->Execute(0.0, 1.0, nullptr), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkImageBrickThresholdTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestThreshold(VTK_SHORT));
+  CHECK_EXIT_SUCCESS(TestThreshold(VTK_FLOAT));
+  CHECK_EXIT_SUCCESS(TestIncrementalUpdate());
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
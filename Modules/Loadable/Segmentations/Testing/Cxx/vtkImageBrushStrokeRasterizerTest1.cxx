@@ -0,0 +1,378 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLCoreTestingUtilities.h"
+
+// Segmentations includes
+#include "vtkImageBrushStrokeRasterizer.h"
+
+// vtkSegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageChangeInformation.h>
+#include <vtkImageStencilToImage.h>
+#include <vtkLine.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataToImageStencil.h>
+#include <vtkSphereSource.h>
+#include <vtkTimerLog.h>
+#include <vtkTransform.h>
+#include <vtkTransformPolyDataFilter.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void CreateImage(vtkOrientedImageData* image, int dimensions[3], double spacing, bool oriented)
+{
+  image->SetDimensions(dimensions);
+  image->SetSpacing(spacing, spacing * 1.5, spacing * 0.8);
+  image->SetOrigin(-10.0, 5.0, 2.5);
+  if (oriented)
+    {
+    vtkNew<vtkTransform> directions;
+    directions->RotateZ(25.0);
+    directions->RotateX(-10.0);
+    vtkNew<vtkMatrix4x4> directionsMatrix;
+    directions->GetMatrix(directionsMatrix);
+    image->SetDirectionMatrix(directionsMatrix);
+    }
+  image->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  image->GetPointData()->GetScalars()->Fill(0);
+}
+
+//----------------------------------------------------------------------------
+/// Returns true if the position is inside the brush swept along any segment of the stroke.
+/// The cylinder brush is only checked for strokes that are orthogonal to the cylinder axis.
+bool IsInsideStroke(vtkPoints* stroke, double radius, bool cylinder, double height, const double axis[3], const double position[3])
+{
+  vtkIdType numberOfSegments = std::max<vtkIdType>(1, stroke->GetNumberOfPoints() - 1);
+  for (vtkIdType segmentIndex = 0; segmentIndex < numberOfSegments; segmentIndex++)
+    {
+    double start[3] = { 0.0, 0.0, 0.0 };
+    double end[3] = { 0.0, 0.0, 0.0 };
+    stroke->GetPoint(segmentIndex, start);
+    stroke->GetPoint(std::min(segmentIndex + 1, stroke->GetNumberOfPoints() - 1), end);
+    double projectedPosition[3] = { position[0], position[1], position[2] };
+    if (cylinder)
+      {
+      double offset[3] = { 0.0, 0.0, 0.0 };
+      vtkMath::Subtract(position, start, offset);
+      double axialOffset = vtkMath::Dot(offset, axis);
+      if (std::abs(axialOffset) > height / 2.0)
+        {
+        continue;
+        }
+      for (int i = 0; i < 3; i++)
+        {
+        projectedPosition[i] -= axialOffset * axis[i];
+        }
+      }
+    double t = 0.0;
+    double closestPoint[3] = { 0.0, 0.0, 0.0 };
+    if (vtkLine::DistanceToLine(projectedPosition, start, end, t, closestPoint) <= radius * radius)
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+/// Compare painted voxels to the expected brush shape. Returns the number of mismatching voxels.
+int CountMismatchingVoxels(vtkOrientedImageData* image, vtkPoints* stroke, double radius,
+  bool cylinder, double height, const double axis[3], int expectedModifiedExtent[6])
+{
+  vtkNew<vtkMatrix4x4> imageToWorld;
+  image->GetImageToWorldMatrix(imageToWorld);
+  int* extent = image->GetExtent();
+  int numberOfMismatches = 0;
+  std::fill(expectedModifiedExtent, expectedModifiedExtent + 6, 0);
+  bool painted = false;
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        double ijk[4] = { static_cast<double>(i), static_cast<double>(j), static_cast<double>(k), 1.0 };
+        double position[4] = { 0.0, 0.0, 0.0, 1.0 };
+        imageToWorld->MultiplyPoint(ijk, position);
+        bool expectedInside = IsInsideStroke(stroke, radius, cylinder, height, axis, position);
+        bool inside = (image->GetScalarComponentAsDouble(i, j, k, 0) == 1.0);
+        if (expectedInside != inside)
+          {
+          numberOfMismatches++;
+          }
+        if (!inside)
+          {
+          continue;
+          }
+        int voxel[3] = { i, j, k };
+        for (int axisIndex = 0; axisIndex < 3; axisIndex++)
+          {
+          if (!painted || voxel[axisIndex] < expectedModifiedExtent[axisIndex * 2])
+            {
+            expectedModifiedExtent[axisIndex * 2] = voxel[axisIndex];
+            }
+          if (!painted || voxel[axisIndex] > expectedModifiedExtent[axisIndex * 2 + 1])
+            {
+            expectedModifiedExtent[axisIndex * 2 + 1] = voxel[axisIndex];
+            }
+          }
+        painted = true;
+        }
+      }
+    }
+  if (!painted)
+    {
+    const int emptyExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    std::copy(emptyExtent, emptyExtent + 6, expectedModifiedExtent);
+    }
+  return numberOfMismatches;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType CountPaintedVoxels(vtkImageData* image)
+{
+  vtkIdType numberOfPaintedVoxels = 0;
+  unsigned char* voxelPtr = static_cast<unsigned char*>(image->GetScalarPointer());
+  vtkIdType numberOfVoxels = image->GetNumberOfPoints();
+  for (vtkIdType voxelIndex = 0; voxelIndex < numberOfVoxels; voxelIndex++)
+    {
+    if (voxelPtr[voxelIndex] != 0)
+      {
+      numberOfPaintedVoxels++;
+      }
+    }
+  return numberOfPaintedVoxels;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int TestSphereBrushStroke()
+{
+  int dimensions[3] = { 40, 30, 35 };
+  vtkNew<vtkOrientedImageData> image;
+  CreateImage(image, dimensions, 0.9, true);
+  vtkNew<vtkMatrix4x4> imageToWorld;
+  image->GetImageToWorldMatrix(imageToWorld);
+  double centerIjk[4] = { 20.0, 15.0, 17.0, 1.0 };
+  double center[4] = { 0.0, 0.0, 0.0, 1.0 };
+  imageToWorld->MultiplyPoint(centerIjk, center);
+
+  // Stroke with a sharp turn and with collinear points
+  vtkNew<vtkPoints> stroke;
+  stroke->InsertNextPoint(center[0] - 8.2, center[1] - 3.1, center[2] + 1.3);
+  stroke->InsertNextPoint(center[0] - 4.1, center[1] - 1.55, center[2] + 0.65);
+  stroke->InsertNextPoint(center[0], center[1], center[2]);
+  stroke->InsertNextPoint(center[0] + 2.7, center[1] + 9.4, center[2] - 2.2);
+
+  vtkNew<vtkImageBrushStrokeRasterizer> rasterizer;
+  rasterizer->SetBrushShapeToSphere();
+  rasterizer->SetRadius(4.3);
+  rasterizer->SetFillValue(1.0);
+  int modifiedExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  CHECK_BOOL(rasterizer->PaintStroke(image, stroke, modifiedExtent), true);
+
+  double axis[3] = { 0.0, 0.0, 1.0 };
+  int expectedModifiedExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  CHECK_INT(CountMismatchingVoxels(image, stroke, 4.3, false, 0.0, axis, expectedModifiedExtent), 0);
+  CHECK_BOOL(CountPaintedVoxels(image) > 0, true);
+  for (int i = 0; i < 6; i++)
+    {
+    CHECK_INT(modifiedExtent[i], expectedModifiedExtent[i]);
+    }
+
+  // Single point paints a single sphere
+  image->GetPointData()->GetScalars()->Fill(0);
+  vtkNew<vtkPoints> singlePoint;
+  singlePoint->InsertNextPoint(center[0] + 1.2, center[1] - 0.7, center[2] + 0.4);
+  CHECK_BOOL(rasterizer->PaintStroke(image, singlePoint, modifiedExtent), true);
+  CHECK_INT(CountMismatchingVoxels(image, singlePoint, 4.3, false, 0.0, axis, expectedModifiedExtent), 0);
+  for (int i = 0; i < 6; i++)
+    {
+    CHECK_INT(modifiedExtent[i], expectedModifiedExtent[i]);
+    }
+
+  // Stroke outside of the image does not modify the image
+  image->GetPointData()->GetScalars()->Fill(0);
+  vtkNew<vtkPoints> strokeOutside;
+  strokeOutside->InsertNextPoint(center[0] + 500.0, center[1], center[2]);
+  strokeOutside->InsertNextPoint(center[0] + 600.0, center[1], center[2]);
+  CHECK_BOOL(rasterizer->PaintStroke(image, strokeOutside, modifiedExtent), true);
+  CHECK_INT(CountPaintedVoxels(image), 0);
+  CHECK_INT(modifiedExtent[0], 0);
+  CHECK_INT(modifiedExtent[1], -1);
+
+  // Invalid input
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(rasterizer->PaintStroke(nullptr, stroke), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestCylinderBrushStroke()
+{
+  int dimensions[3] = { 40, 30, 35 };
+  double spacing = 0.9;
+  vtkNew<vtkOrientedImageData> image;
+  CreateImage(image, dimensions, spacing, false);
+
+  // Stroke in an axial slice, between two voxel layers
+  double sliceZ = image->GetOrigin()[2] + 17.3 * image->GetSpacing()[2];
+  vtkNew<vtkPoints> stroke;
+  stroke->InsertNextPoint(-3.2, 14.1, sliceZ);
+  stroke->InsertNextPoint(8.6, 20.3, sliceZ);
+  stroke->InsertNextPoint(4.4, 31.7, sliceZ);
+
+  double axis[3] = { 0.0, 0.0, 1.0 };
+  double height = image->GetSpacing()[2];
+  vtkNew<vtkImageBrushStrokeRasterizer> rasterizer;
+  rasterizer->SetBrushShapeToCylinder();
+  rasterizer->SetRadius(3.7);
+  rasterizer->SetHeight(height);
+  rasterizer->SetCylinderAxis(axis);
+  rasterizer->SetFillValue(1.0);
+  int modifiedExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  CHECK_BOOL(rasterizer->PaintStroke(image, stroke, modifiedExtent), true);
+
+  int expectedModifiedExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  CHECK_INT(CountMismatchingVoxels(image, stroke, 3.7, true, height, axis, expectedModifiedExtent), 0);
+  CHECK_BOOL(CountPaintedVoxels(image) > 0, true);
+  for (int i = 0; i < 6; i++)
+    {
+    CHECK_INT(modifiedExtent[i], expectedModifiedExtent[i]);
+    }
+  // Cylinder height is the slice spacing, therefore a single slice is painted
+  CHECK_INT(modifiedExtent[4], 17);
+  CHECK_INT(modifiedExtent[5], 17);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestBrushStrokePerformance()
+{
+  // Fine resolution labelmap, large brush, fast stroke
+  int dimensions[3] = { 300, 300, 300 };
+  double spacing = 0.4;
+  double radius = 12.0;
+  vtkNew<vtkOrientedImageData> stencilPipelineImage;
+  stencilPipelineImage->SetDimensions(dimensions);
+  stencilPipelineImage->SetSpacing(spacing, spacing, spacing);
+  stencilPipelineImage->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  stencilPipelineImage->GetPointData()->GetScalars()->Fill(0);
+  vtkNew<vtkOrientedImageData> rasterizerImage;
+  rasterizerImage->DeepCopy(stencilPipelineImage);
+
+  // Stroke points are interpolated at 0.2 * diameter, as in the paint effect
+  vtkNew<vtkPoints> stroke;
+  const int numberOfStrokePoints = 25;
+  for (int pointIndex = 0; pointIndex < numberOfStrokePoints; pointIndex++)
+    {
+    double t = static_cast<double>(pointIndex) * 0.4 * radius;
+    stroke->InsertNextPoint(10.0 + 0.8 * t, 20.0 + 0.6 * t, 60.0);
+    }
+  vtkNew<vtkTimerLog> timer;
+
+  // Brush stencil stamped at each stroke point (previous paint effect implementation)
+  timer->StartTimer();
+  vtkNew<vtkSphereSource> brushSource;
+  brushSource->SetRadius(radius);
+  brushSource->SetPhiResolution(32);
+  brushSource->SetThetaResolution(32);
+  vtkNew<vtkTransform> brushToIjk;
+  brushToIjk->Scale(1.0 / spacing, 1.0 / spacing, 1.0 / spacing);
+  vtkNew<vtkTransformPolyDataFilter> brushToIjkTransformer;
+  brushToIjkTransformer->SetTransform(brushToIjk);
+  brushToIjkTransformer->SetInputConnection(brushSource->GetOutputPort());
+  brushToIjkTransformer->Update();
+  double* boundsIjk = brushToIjkTransformer->GetOutput()->GetBounds();
+  vtkNew<vtkPolyDataToImageStencil> polyDataToStencil;
+  polyDataToStencil->SetInputConnection(brushToIjkTransformer->GetOutputPort());
+  polyDataToStencil->SetOutputSpacing(1.0, 1.0, 1.0);
+  polyDataToStencil->SetOutputWholeExtent(floor(boundsIjk[0]) - 1, ceil(boundsIjk[1]) + 1,
+    floor(boundsIjk[2]) - 1, ceil(boundsIjk[3]) + 1, floor(boundsIjk[4]) - 1, ceil(boundsIjk[5]) + 1);
+  vtkNew<vtkImageStencilToImage> stencilToImage;
+  stencilToImage->SetInputConnection(polyDataToStencil->GetOutputPort());
+  stencilToImage->SetInsideValue(1);
+  stencilToImage->SetOutsideValue(0);
+  stencilToImage->SetOutputScalarType(VTK_UNSIGNED_CHAR);
+  vtkNew<vtkImageChangeInformation> brushPositioner;
+  brushPositioner->SetInputConnection(stencilToImage->GetOutputPort());
+  brushPositioner->SetOutputSpacing(stencilPipelineImage->GetSpacing());
+  brushPositioner->SetOutputOrigin(stencilPipelineImage->GetOrigin());
+  for (int pointIndex = 0; pointIndex < numberOfStrokePoints; pointIndex++)
+    {
+    double* point = stroke->GetPoint(pointIndex);
+    int shift[3] = { vtkMath::Round(point[0] / spacing), vtkMath::Round(point[1] / spacing), vtkMath::Round(point[2] / spacing) };
+    brushPositioner->SetExtentTranslation(shift);
+    brushPositioner->Update();
+    vtkNew<vtkOrientedImageData> brushImage;
+    brushImage->ShallowCopy(brushPositioner->GetOutput());
+    vtkOrientedImageDataResample::ModifyImage(stencilPipelineImage, brushImage, vtkOrientedImageDataResample::OPERATION_MAXIMUM);
+    }
+  timer->StopTimer();
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("BrushStroke-StencilPipeline25PointsRadius12mm", timer->GetElapsedTime());
+
+  // Brush swept along the stroke
+  vtkNew<vtkImageBrushStrokeRasterizer> rasterizer;
+  rasterizer->SetRadius(radius);
+  timer->StartTimer();
+  CHECK_BOOL(rasterizer->PaintStroke(rasterizerImage, stroke), true);
+  timer->StopTimer();
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("BrushStroke-Rasterizer25PointsRadius12mm", timer->GetElapsedTime());
+
+  // The swept brush fills the small gaps between the stamped spheres,
+  // therefore the painted volume is slightly larger.
+  vtkIdType stencilPipelineVoxelCount = CountPaintedVoxels(stencilPipelineImage);
+  vtkIdType rasterizerVoxelCount = CountPaintedVoxels(rasterizerImage);
+  std::cout << "Painted voxels: stencil pipeline = " << stencilPipelineVoxelCount
+    << ", rasterizer = " << rasterizerVoxelCount << std::endl;
+  CHECK_BOOL(std::abs(static_cast<double>(rasterizerVoxelCount - stencilPipelineVoxelCount))
+    < 0.05 * static_cast<double>(stencilPipelineVoxelCount), true);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageBrushStrokeRasterizerTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestSphereBrushStroke());
+  CHECK_EXIT_SUCCESS(TestCylinderBrushStroke());
+  CHECK_EXIT_SUCCESS(TestBrushStrokePerformance());
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
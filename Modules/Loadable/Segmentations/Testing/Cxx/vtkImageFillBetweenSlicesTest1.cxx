@@ -0,0 +1,411 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// Segmentations includes
+#include "vtkImageFillBetweenSlices.h"
+
+// vtkSegmentationCore includes
+#include "vtkOrientedImageData.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+short GetVoxel(vtkImageData* image, int i, int j, int k)
+{
+  int* extent = image->GetExtent();
+  return *static_cast<short*>(image->GetScalarPointer(extent[0] + i, extent[2] + j, extent[4] + k));
+}
+
+//----------------------------------------------------------------------------
+void SetVoxel(vtkImageData* image, int i, int j, int k, short value)
+{
+  int* extent = image->GetExtent();
+  *static_cast<short*>(image->GetScalarPointer(extent[0] + i, extent[2] + j, extent[4] + k)) = value;
+}
+
+//----------------------------------------------------------------------------
+/// Draw a filled ellipse into a slice that is orthogonal to the specified axis
+void DrawEllipse(vtkImageData* image, int axis, int slice, double centerU, double centerV,
+  double radiusU, double radiusV, short value)
+{
+  const int uAxis = (axis == 0 ? 1 : 0);
+  const int vAxis = (axis == 2 ? 1 : 2);
+  int* extent = image->GetExtent();
+  for (int v = 0; v <= extent[vAxis * 2 + 1] - extent[vAxis * 2]; ++v)
+    {
+    for (int u = 0; u <= extent[uAxis * 2 + 1] - extent[uAxis * 2]; ++u)
+      {
+      if (pow((u - centerU) / radiusU, 2) + pow((v - centerV) / radiusV, 2) > 1.0)
+        {
+        continue;
+        }
+      int ijk[3] = { 0, 0, 0 };
+      ijk[axis] = slice;
+      ijk[uAxis] = u;
+      ijk[vAxis] = v;
+      SetVoxel(image, ijk[0], ijk[1], ijk[2], value);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void CreateLabelmap(vtkOrientedImageData* labelmap, const int dimensions[3])
+{
+  labelmap->SetExtent(-3, dimensions[0] - 4, 5, dimensions[1] + 4, 0, dimensions[2] - 1);
+  labelmap->SetSpacing(0.6, 0.9, 1.5);
+  labelmap->SetOrigin(12.0, -3.0, 7.5);
+  labelmap->SetDirections(0.0, 1.0, 0.0, -1.0, 0.0, 0.0, 0.0, 0.0, 1.0);
+  labelmap->AllocateScalars(VTK_SHORT, 1);
+  labelmap->GetPointData()->GetScalars()->Fill(0);
+}
+
+//----------------------------------------------------------------------------
+/// Signed distance of each pixel of a slice from the contour of a label, computed by brute force.
+/// Negative inside the label. The contour is half pixel away from the center of the boundary pixels.
+std::vector<double> ReferenceSignedDistances(vtkImageData* labelmap, short labelValue, int axis, int slice)
+{
+  const int uAxis = (axis == 0 ? 1 : 0);
+  const int vAxis = (axis == 2 ? 1 : 2);
+  int* extent = labelmap->GetExtent();
+  double* spacing = labelmap->GetSpacing();
+  const int dimensions[2] = { extent[uAxis * 2 + 1] - extent[uAxis * 2] + 1, extent[vAxis * 2 + 1] - extent[vAxis * 2] + 1 };
+  std::vector<unsigned char> mask(dimensions[0] * dimensions[1]);
+  for (int v = 0; v < dimensions[1]; ++v)
+    {
+    for (int u = 0; u < dimensions[0]; ++u)
+      {
+      int ijk[3] = { 0, 0, 0 };
+      ijk[axis] = slice;
+      ijk[uAxis] = u;
+      ijk[vAxis] = v;
+      mask[v * dimensions[0] + u] = (GetVoxel(labelmap, ijk[0], ijk[1], ijk[2]) == labelValue ? 1 : 0);
+      }
+    }
+  const double halfPixel = 0.5 * std::min(spacing[uAxis], spacing[vAxis]);
+  std::vector<double> signedDistances(mask.size());
+  for (int v = 0; v < dimensions[1]; ++v)
+    {
+    for (int u = 0; u < dimensions[0]; ++u)
+      {
+      const unsigned char inside = mask[v * dimensions[0] + u];
+      double minimumDistance = std::numeric_limits<double>::max();
+      for (int v2 = 0; v2 < dimensions[1]; ++v2)
+        {
+        for (int u2 = 0; u2 < dimensions[0]; ++u2)
+          {
+          if (mask[v2 * dimensions[0] + u2] != inside)
+            {
+            minimumDistance = std::min(minimumDistance,
+              sqrt(pow((u2 - u) * spacing[uAxis], 2) + pow((v2 - v) * spacing[vAxis], 2)));
+            }
+          }
+        }
+      signedDistances[v * dimensions[0] + u] = (inside ? halfPixel - minimumDistance : minimumDistance - halfPixel);
+      }
+    }
+  return signedDistances;
+}
+
+//----------------------------------------------------------------------------
+/// Fill gaps of a label along an axis by brute force. Labels are expected to be processed
+/// in descending order. Returns number of filled voxels.
+int ReferenceFill(vtkImageData* labelmap, short labelValue, int axis, vtkImageData* expected)
+{
+  const int uAxis = (axis == 0 ? 1 : 0);
+  const int vAxis = (axis == 2 ? 1 : 2);
+  int* extent = labelmap->GetExtent();
+  const int numberOfSlices = extent[axis * 2 + 1] - extent[axis * 2] + 1;
+  const int dimensions[2] = { extent[uAxis * 2 + 1] - extent[uAxis * 2] + 1, extent[vAxis * 2 + 1] - extent[vAxis * 2] + 1 };
+  std::vector<int> annotatedSlices;
+  for (int slice = 0; slice < numberOfSlices; ++slice)
+    {
+    bool annotated = false;
+    for (int v = 0; v < dimensions[1] && !annotated; ++v)
+      {
+      for (int u = 0; u < dimensions[0] && !annotated; ++u)
+        {
+        int ijk[3] = { 0, 0, 0 };
+        ijk[axis] = slice;
+        ijk[uAxis] = u;
+        ijk[vAxis] = v;
+        annotated = (GetVoxel(labelmap, ijk[0], ijk[1], ijk[2]) == labelValue);
+        }
+      }
+    if (annotated)
+      {
+      annotatedSlices.push_back(slice);
+      }
+    }
+  int numberOfFilledVoxels = 0;
+  for (size_t gapIndex = 1; gapIndex < annotatedSlices.size(); ++gapIndex)
+    {
+    const int slice0 = annotatedSlices[gapIndex - 1];
+    const int slice1 = annotatedSlices[gapIndex];
+    if (slice1 - slice0 < 2)
+      {
+      continue;
+      }
+    std::vector<double> signedDistances0 = ReferenceSignedDistances(labelmap, labelValue, axis, slice0);
+    std::vector<double> signedDistances1 = ReferenceSignedDistances(labelmap, labelValue, axis, slice1);
+    for (int slice = slice0 + 1; slice < slice1; ++slice)
+      {
+      const double weight1 = static_cast<double>(slice - slice0) / (slice1 - slice0);
+      for (int v = 0; v < dimensions[1]; ++v)
+        {
+        for (int u = 0; u < dimensions[0]; ++u)
+          {
+          int ijk[3] = { 0, 0, 0 };
+          ijk[axis] = slice;
+          ijk[uAxis] = u;
+          ijk[vAxis] = v;
+          const double signedDistance = (1.0 - weight1) * signedDistances0[v * dimensions[0] + u]
+            + weight1 * signedDistances1[v * dimensions[0] + u];
+          if (signedDistance <= 0.0 && GetVoxel(labelmap, ijk[0], ijk[1], ijk[2]) == 0)
+            {
+            SetVoxel(expected, ijk[0], ijk[1], ijk[2], labelValue);
+            ++numberOfFilledVoxels;
+            }
+          }
+        }
+      }
+    }
+  return numberOfFilledVoxels;
+}
+
+//----------------------------------------------------------------------------
+/// Count voxels that differ
+int CountMismatchingVoxels(vtkImageData* image, vtkImageData* expected)
+{
+  int numberOfMismatches = 0;
+  int* extent = image->GetExtent();
+  for (int k = 0; k <= extent[5] - extent[4]; ++k)
+    {
+    for (int j = 0; j <= extent[3] - extent[2]; ++j)
+      {
+      for (int i = 0; i <= extent[1] - extent[0]; ++i)
+        {
+        if (GetVoxel(image, i, j, k) != GetVoxel(expected, i, j, k))
+          {
+          ++numberOfMismatches;
+          }
+        }
+      }
+    }
+  return numberOfMismatches;
+}
+
+//----------------------------------------------------------------------------
+int TestInterpolation()
+{
+  const int dimensions[3] = { 60, 50, 40 };
+  vtkNew<vtkOrientedImageData> labelmap;
+  CreateLabelmap(labelmap, dimensions);
+
+  // Label 1: ellipses in axial slices, shape and position is changing
+  DrawEllipse(labelmap, 2, 5, 20.0, 20.0, 8.0, 6.0, 1);
+  DrawEllipse(labelmap, 2, 15, 24.0, 22.0, 14.0, 9.0, 1);
+  DrawEllipse(labelmap, 2, 19, 26.0, 22.0, 5.0, 4.0, 1);
+  // Label 2: identical squares in sagittal slices
+  for (int slice : { 40, 50 })
+    {
+    for (int k = 5; k <= 15; ++k)
+      {
+      for (int j = 5; j <= 15; ++j)
+        {
+        SetVoxel(labelmap, slice, j, k, 2);
+        }
+      }
+    }
+  // Label 3: overlaps with the interpolated region of label 1
+  for (int slice : { 4, 16 })
+    {
+    for (int j = 18; j <= 22; ++j)
+      {
+      for (int i = 10; i <= 40; ++i)
+        {
+        SetVoxel(labelmap, i, j, slice, 3);
+        }
+      }
+    }
+
+  vtkNew<vtkImageFillBetweenSlices> fillBetweenSlices;
+  fillBetweenSlices->SetLabelmap(labelmap);
+  vtkNew<vtkOrientedImageData> output;
+  CHECK_BOOL(fillBetweenSlices->Execute(output), true);
+  CHECK_INT(fillBetweenSlices->GetNumberOfInterpolatedGaps(), 4);
+  CHECK_INT(fillBetweenSlices->GetNumberOfReusedGaps(), 0);
+
+  // Geometry
+  CHECK_INT(output->GetScalarType(), VTK_SHORT);
+  for (int i = 0; i < 6; ++i)
+    {
+    CHECK_INT(output->GetExtent()[i], labelmap->GetExtent()[i]);
+    }
+  double outputDirections[3][3] = { { 0.0 } };
+  double inputDirections[3][3] = { { 0.0 } };
+  output->GetDirections(outputDirections);
+  labelmap->GetDirections(inputDirections);
+  for (int i = 0; i < 9; ++i)
+    {
+    CHECK_DOUBLE_TOLERANCE(outputDirections[i / 3][i % 3], inputDirections[i / 3][i % 3], 1e-9);
+    }
+
+  // Compare to brute force computation. Labels are processed in descending order,
+  // so that lower label values have priority.
+  vtkNew<vtkOrientedImageData> expected;
+  expected->DeepCopy(labelmap);
+  ReferenceFill(labelmap, 3, 2, expected);
+  ReferenceFill(labelmap, 2, 0, expected);
+  CHECK_BOOL(ReferenceFill(labelmap, 1, 2, expected) > 1000, true);
+  CHECK_INT(CountMismatchingVoxels(output, expected), 0);
+
+  // Identical squares are copied to all intermediate slices
+  for (int i = 41; i <= 49; ++i)
+    {
+    CHECK_INT(GetVoxel(output, i, 10, 10), 2);
+    CHECK_INT(GetVoxel(output, i, 5, 15), 2);
+    CHECK_INT(GetVoxel(output, i, 4, 10), 0);
+    }
+  // Label 1 has priority over label 3
+  CHECK_INT(GetVoxel(output, 22, 20, 10), 1);
+  CHECK_INT(GetVoxel(output, 39, 20, 10), 3);
+  // Input voxels are not modified, no extrapolation
+  CHECK_INT(GetVoxel(output, 20, 20, 5), 1);
+  CHECK_INT(GetVoxel(output, 20, 20, 4), 3);
+  CHECK_INT(GetVoxel(output, 20, 20, 3), 0);
+  CHECK_INT(GetVoxel(output, 26, 22, 20), 0);
+
+  // Forced axis: label 2 has no gaps along the k axis
+  fillBetweenSlices->SetAxis(2);
+  CHECK_BOOL(fillBetweenSlices->Execute(output), true);
+  CHECK_INT(GetVoxel(output, 45, 10, 10), 0);
+  CHECK_INT(GetVoxel(output, 22, 20, 10), 1);
+
+  // Invalid inputs
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(fillBetweenSlices->Execute(nullptr), false);
+  fillBetweenSlices->SetLabelmap(nullptr);
+  CHECK_BOOL(fillBetweenSlices->Execute(output), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestCache()
+{
+  const int dimensions[3] = { 40, 30, 30 };
+  vtkNew<vtkOrientedImageData> labelmap;
+  CreateLabelmap(labelmap, dimensions);
+  DrawEllipse(labelmap, 2, 5, 15.0, 15.0, 6.0, 5.0, 1);
+  DrawEllipse(labelmap, 2, 15, 17.0, 14.0, 9.0, 7.0, 1);
+  DrawEllipse(labelmap, 2, 25, 18.0, 15.0, 4.0, 4.0, 1);
+  DrawEllipse(labelmap, 2, 5, 32.0, 8.0, 3.0, 3.0, 2);
+  DrawEllipse(labelmap, 2, 25, 30.0, 10.0, 5.0, 3.0, 2);
+
+  vtkNew<vtkImageFillBetweenSlices> fillBetweenSlices;
+  fillBetweenSlices->SetLabelmap(labelmap);
+  vtkNew<vtkOrientedImageData> output;
+  CHECK_BOOL(fillBetweenSlices->Execute(output), true);
+  CHECK_INT(fillBetweenSlices->GetNumberOfInterpolatedGaps(), 3);
+  CHECK_INT(fillBetweenSlices->GetNumberOfReusedGaps(), 0);
+
+  // Nothing has changed
+  vtkNew<vtkOrientedImageData> output2;
+  CHECK_BOOL(fillBetweenSlices->Execute(output2), true);
+  CHECK_INT(fillBetweenSlices->GetNumberOfInterpolatedGaps(), 0);
+  CHECK_INT(fillBetweenSlices->GetNumberOfReusedGaps(), 3);
+  CHECK_INT(CountMismatchingVoxels(output, output2), 0);
+
+  // Edit one slice: only the adjacent gap is interpolated again
+  SetVoxel(labelmap, 18, 20, 25, 1);
+  labelmap->Modified();
+  CHECK_BOOL(fillBetweenSlices->Execute(output), true);
+  CHECK_INT(fillBetweenSlices->GetNumberOfInterpolatedGaps(), 1);
+  CHECK_INT(fillBetweenSlices->GetNumberOfReusedGaps(), 2);
+  vtkNew<vtkImageFillBetweenSlices> referenceFillBetweenSlices;
+  referenceFillBetweenSlices->SetLabelmap(labelmap);
+  CHECK_BOOL(referenceFillBetweenSlices->Execute(output2), true);
+  CHECK_INT(CountMismatchingVoxels(output, output2), 0);
+
+  // Annotate a new slice: the gap is split into two
+  DrawEllipse(labelmap, 2, 10, 16.0, 15.0, 7.0, 6.0, 1);
+  labelmap->Modified();
+  CHECK_BOOL(fillBetweenSlices->Execute(output), true);
+  CHECK_INT(fillBetweenSlices->GetNumberOfInterpolatedGaps(), 2);
+  CHECK_INT(fillBetweenSlices->GetNumberOfReusedGaps(), 2);
+  CHECK_BOOL(referenceFillBetweenSlices->Execute(output2), true);
+  CHECK_INT(CountMismatchingVoxels(output, output2), 0);
+
+  // Remove a label: its gaps are dropped from the cache
+  for (int k = 0; k < dimensions[2]; ++k)
+    {
+    for (int j = 0; j < dimensions[1]; ++j)
+      {
+      for (int i = 0; i < dimensions[0]; ++i)
+        {
+        if (GetVoxel(labelmap, i, j, k) == 2)
+          {
+          SetVoxel(labelmap, i, j, k, 0);
+          }
+        }
+      }
+    }
+  labelmap->Modified();
+  CHECK_BOOL(fillBetweenSlices->Execute(output), true);
+  CHECK_INT(fillBetweenSlices->GetNumberOfInterpolatedGaps(), 0);
+  CHECK_INT(fillBetweenSlices->GetNumberOfReusedGaps(), 3);
+
+  // Cache is cleared if the labelmap extent changes
+  int* extent = labelmap->GetExtent();
+  labelmap->SetExtent(extent[0] + 1, extent[1] + 1, extent[2], extent[3], extent[4], extent[5]);
+  CHECK_BOOL(fillBetweenSlices->Execute(output), true);
+  CHECK_INT(fillBetweenSlices->GetNumberOfInterpolatedGaps(), 3);
+  CHECK_INT(fillBetweenSlices->GetNumberOfReusedGaps(), 0);
+
+  fillBetweenSlices->ClearCache();
+  CHECK_BOOL(fillBetweenSlices->Execute(output), true);
+  CHECK_INT(fillBetweenSlices->GetNumberOfInterpolatedGaps(), 3);
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkImageFillBetweenSlicesTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestInterpolation());
+  CHECK_EXIT_SUCCESS(TestCache());
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
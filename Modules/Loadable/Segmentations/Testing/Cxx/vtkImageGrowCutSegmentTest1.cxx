@@ -0,0 +1,286 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLCoreTestingUtilities.h"
+
+// Segmentations includes
+#include "vtkImageGrowCutSegment.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// VTKSYS includes
+#include <vtksys/SystemInformation.hxx>
+
+// STD includes
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void AllocateImage(vtkImageData* image, int size, int scalarType)
+{
+  image->SetDimensions(size, size, size);
+  image->AllocateScalars(scalarType, 1);
+  memset(image->GetScalarPointer(), 0, image->GetNumberOfPoints() * image->GetScalarSize());
+}
+
+//----------------------------------------------------------------------------
+/// Bright textured sphere on dark textured background, with a seed inside
+/// the sphere (label 1) and a seed in the background (label 2).
+void CreateTestVolumes(int size, vtkImageData* intensityVolume, vtkImageData* seedLabelVolume)
+{
+  AllocateImage(intensityVolume, size, VTK_SHORT);
+  AllocateImage(seedLabelVolume, size, VTK_SHORT);
+  double center = (size - 1) / 2.0;
+  double radius = size / 4.0;
+  for (int k = 0; k < size; k++)
+    {
+    for (int j = 0; j < size; j++)
+      {
+      for (int i = 0; i < size; i++)
+        {
+        double distance2 = (i - center) * (i - center) + (j - center) * (j - center) + (k - center) * (k - center);
+        short texture = static_cast<short>((i * 7 + j * 13 + k * 3) % 11);
+        intensityVolume->SetScalarComponentFromDouble(i, j, k, 0, (distance2 < radius * radius ? 100 : 0) + texture);
+        }
+      }
+    }
+  int centerIndex = static_cast<int>(center);
+  for (int k = -1; k <= 1; k++)
+    {
+    for (int j = -1; j <= 1; j++)
+      {
+      for (int i = -1; i <= 1; i++)
+        {
+        seedLabelVolume->SetScalarComponentFromDouble(centerIndex + i, centerIndex + j, centerIndex + k, 0, 1);
+        seedLabelVolume->SetScalarComponentFromDouble(3 + i, 3 + j, 3 + k, 0, 2);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkIdType CountDifferentVoxels(vtkImageData* image1, vtkImageData* image2)
+{
+  short* voxels1 = static_cast<short*>(image1->GetScalarPointer());
+  short* voxels2 = static_cast<short*>(image2->GetScalarPointer());
+  vtkIdType numberOfDifferentVoxels = 0;
+  for (vtkIdType i = 0; i < image1->GetNumberOfPoints(); i++)
+    {
+    if (voxels1[i] != voxels2[i])
+      {
+      numberOfDifferentVoxels++;
+      }
+    }
+  return numberOfDifferentVoxels;
+}
+
+//----------------------------------------------------------------------------
+/// Update the filter and return the peak increase of process memory usage (in MiB)
+/// sampled while the filter was running.
+double UpdateAndGetPeakMemoryIncrease(vtkImageGrowCutSegment* filter)
+{
+  vtksys::SystemInformation systemInformation;
+  long long baselineMemory = systemInformation.GetProcMemoryUsed();
+  std::atomic<long long> peakMemory(baselineMemory);
+  std::atomic<bool> completed(false);
+  std::thread sampler([&]()
+    {
+    vtksys::SystemInformation samplerSystemInformation;
+    while (!completed)
+      {
+      long long memory = samplerSystemInformation.GetProcMemoryUsed();
+      if (memory > peakMemory)
+        {
+        peakMemory = memory;
+        }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+  filter->Update();
+  completed = true;
+  sampler.join();
+  return (peakMemory - baselineMemory) / 1024.0;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int TestGrowCutAlgorithms()
+{
+  const int size = 40;
+  vtkNew<vtkImageData> intensityVolume;
+  vtkNew<vtkImageData> seedLabelVolume;
+  CreateTestVolumes(size, intensityVolume, seedLabelVolume);
+  vtkNew<vtkImageData> maskVolume;
+  AllocateImage(maskVolume, size, VTK_UNSIGNED_CHAR);
+  for (int i = 0; i < size; i++)
+    {
+    maskVolume->SetScalarComponentFromDouble(i, size - 3, size - 3, 0, 1);
+    }
+
+  vtkSmartPointer<vtkImageData> results[vtkImageGrowCutSegment::Algorithm_Last];
+  for (int algorithm = 0; algorithm < vtkImageGrowCutSegment::Algorithm_Last; algorithm++)
+    {
+    vtkNew<vtkImageGrowCutSegment> growCut;
+    growCut->SetAlgorithm(algorithm);
+    growCut->SetIntensityVolume(intensityVolume);
+    growCut->SetSeedLabelVolume(seedLabelVolume);
+    growCut->SetMaskVolume(maskVolume);
+    growCut->Update();
+    vtkImageData* result = growCut->GetOutput();
+    std::cout << "Algorithm: " << growCut->GetAlgorithmAsString() << std::endl;
+    CHECK_INT(result->GetScalarType(), VTK_SHORT);
+    CHECK_INT(result->GetScalarComponentAsDouble(size / 2 + 5, size / 2, size / 2, 0), 1);
+    CHECK_INT(result->GetScalarComponentAsDouble(size / 2 - 5, size / 2 + 3, size / 2, 0), 1);
+    CHECK_INT(result->GetScalarComponentAsDouble(size - 5, 5, size / 2, 0), 2);
+    CHECK_INT(result->GetScalarComponentAsDouble(size / 2, size - 3, size - 3, 0), 0);
+    results[algorithm] = vtkSmartPointer<vtkImageData>::New();
+    results[algorithm]->DeepCopy(result);
+    }
+
+  // Only voxels reached by multiple shortest paths of equal length may be labeled differently
+  vtkIdType numberOfDifferentVoxels = CountDifferentVoxels(results[vtkImageGrowCutSegment::AlgorithmParallelBucketQueue],
+    results[vtkImageGrowCutSegment::AlgorithmFibonacciHeap]);
+  std::cout << "Number of different voxels: " << numberOfDifferentVoxels << std::endl;
+  CHECK_BOOL(numberOfDifferentVoxels <= size * size * size / 1000, true);
+
+  // Incremental update gives the same result as full computation
+  vtkNew<vtkImageGrowCutSegment> growCut;
+  growCut->SetIntensityVolume(intensityVolume);
+  growCut->SetSeedLabelVolume(seedLabelVolume);
+  growCut->SetMaskVolume(maskVolume);
+  growCut->Update();
+  seedLabelVolume->SetScalarComponentFromDouble(size - 4, size - 4, 3, 0, 3);
+  seedLabelVolume->Modified();
+  growCut->Update();
+  CHECK_INT(growCut->GetOutput()->GetScalarComponentAsDouble(size - 5, size - 5, 5, 0), 3);
+
+  vtkNew<vtkImageGrowCutSegment> growCutFull;
+  growCutFull->SetIntensityVolume(intensityVolume);
+  growCutFull->SetSeedLabelVolume(seedLabelVolume);
+  growCutFull->SetMaskVolume(maskVolume);
+  growCutFull->Update();
+  numberOfDifferentVoxels = CountDifferentVoxels(growCut->GetOutput(), growCutFull->GetOutput());
+  CHECK_BOOL(numberOfDifferentVoxels <= size * size * size / 1000, true);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestGrowCutIncrementalUpdate()
+{
+  const int size = 128;
+  vtkNew<vtkImageData> intensityVolume;
+  vtkNew<vtkImageData> seedLabelVolume;
+  CreateTestVolumes(size, intensityVolume, seedLabelVolume);
+  vtkNew<vtkTimerLog> timer;
+
+  vtkNew<vtkImageGrowCutSegment> growCut;
+  growCut->SetIntensityVolume(intensityVolume);
+  growCut->SetSeedLabelVolume(seedLabelVolume);
+  timer->StartTimer();
+  growCut->Update();
+  timer->StopTimer();
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("GrowCut-FullUpdate128Cube", timer->GetElapsedTime());
+
+  // Add a small seed region
+  seedLabelVolume->SetScalarComponentFromDouble(size - 4, size - 4, 3, 0, 3);
+  seedLabelVolume->Modified();
+  timer->StartTimer();
+  growCut->Update();
+  timer->StopTimer();
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("GrowCut-IncrementalUpdateSeedAdded128Cube", timer->GetElapsedTime());
+  CHECK_INT(growCut->GetOutput()->GetScalarComponentAsDouble(size - 5, size - 5, 5, 0), 3);
+
+  // Remove the seed region: the result must be the same as before adding it
+  seedLabelVolume->SetScalarComponentFromDouble(size - 4, size - 4, 3, 0, 0);
+  seedLabelVolume->Modified();
+  timer->StartTimer();
+  growCut->Update();
+  timer->StopTimer();
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("GrowCut-IncrementalUpdateSeedRemoved128Cube", timer->GetElapsedTime());
+  CHECK_INT(growCut->GetOutput()->GetScalarComponentAsDouble(size - 5, size - 5, 5, 0), 2);
+
+  // Change label of a seed region
+  seedLabelVolume->SetScalarComponentFromDouble(3, 3, 3, 0, 4);
+  seedLabelVolume->Modified();
+  growCut->Update();
+
+  vtkNew<vtkImageGrowCutSegment> growCutFull;
+  growCutFull->SetIntensityVolume(intensityVolume);
+  growCutFull->SetSeedLabelVolume(seedLabelVolume);
+  growCutFull->Update();
+  vtkIdType numberOfDifferentVoxels = CountDifferentVoxels(growCut->GetOutput(), growCutFull->GetOutput());
+  std::cout << "Number of different voxels after incremental updates: " << numberOfDifferentVoxels << std::endl;
+  CHECK_BOOL(numberOfDifferentVoxels <= size * size * size / 1000, true);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestGrowCutPerformance()
+{
+  const int size = 128;
+  vtkNew<vtkImageData> intensityVolume;
+  vtkNew<vtkImageData> seedLabelVolume;
+  CreateTestVolumes(size, intensityVolume, seedLabelVolume);
+  vtkNew<vtkTimerLog> timer;
+
+  vtkSmartPointer<vtkImageData> results[vtkImageGrowCutSegment::Algorithm_Last];
+  for (int algorithm = 0; algorithm < vtkImageGrowCutSegment::Algorithm_Last; algorithm++)
+    {
+    vtkNew<vtkImageGrowCutSegment> growCut;
+    growCut->SetAlgorithm(algorithm);
+    growCut->SetIntensityVolume(intensityVolume);
+    growCut->SetSeedLabelVolume(seedLabelVolume);
+    timer->StartTimer();
+    double peakMemoryIncrease = UpdateAndGetPeakMemoryIncrease(growCut);
+    timer->StopTimer();
+    std::string measurementName = std::string("GrowCut-") + growCut->GetAlgorithmAsString() + "-128Cube";
+    vtkMRMLCoreTestingUtilities::PrintMeasurement(measurementName + "-Time", timer->GetElapsedTime());
+    vtkMRMLCoreTestingUtilities::PrintMeasurement(measurementName + "-PeakMemoryIncreaseMiB", peakMemoryIncrease);
+    results[algorithm] = vtkSmartPointer<vtkImageData>::New();
+    results[algorithm]->DeepCopy(growCut->GetOutput());
+    }
+
+  vtkIdType numberOfDifferentVoxels = CountDifferentVoxels(results[vtkImageGrowCutSegment::AlgorithmParallelBucketQueue],
+    results[vtkImageGrowCutSegment::AlgorithmFibonacciHeap]);
+  CHECK_BOOL(numberOfDifferentVoxels <= size * size * size / 1000, true);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageGrowCutSegmentTest1(int , char * [] )
+{
+  CHECK_EXIT_SUCCESS(TestGrowCutAlgorithms());
+  CHECK_EXIT_SUCCESS(TestGrowCutIncrementalUpdate());
+  CHECK_EXIT_SUCCESS(TestGrowCutPerformance());
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
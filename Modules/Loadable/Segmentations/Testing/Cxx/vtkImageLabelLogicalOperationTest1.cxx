@@ -0,0 +1,275 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// Segmentations includes
+#include "vtkImageLabelLogicalOperation.h"
+
+// vtkSegmentationCore includes
+#include "vtkOrientedImageData.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Create a labelmap with label 1 in the [0,9] and label 2 in the [10,14] i range (all j and k)
+void CreateLabelmap(vtkOrientedImageData* labelmap, int scalarType)
+{
+  labelmap->SetExtent(0, 19, 0, 4, 0, 3);
+  labelmap->SetSpacing(0.5, 0.5, 2.0);
+  labelmap->SetOrigin(10.0, -20.0, 5.0);
+  labelmap->AllocateScalars(scalarType, 1);
+  labelmap->GetPointData()->GetScalars()->Fill(0);
+  int* extent = labelmap->GetExtent();
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= 14; ++i)
+        {
+        labelmap->SetScalarComponentFromDouble(i, j, k, 0, i < 10 ? 1 : 2);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Create a labelmap in the same geometry as the reference, with the specified label value
+/// in the [iMin, iMax] range and 0 elsewhere
+void CreateModifierLabelmap(vtkOrientedImageData* reference, vtkOrientedImageData* modifier,
+  int iMin, int iMax, int labelValue, int extentIMax)
+{
+  modifier->SetOrigin(reference->GetOrigin());
+  modifier->SetSpacing(reference->GetSpacing());
+  int* referenceExtent = reference->GetExtent();
+  modifier->SetExtent(referenceExtent[0], extentIMax, referenceExtent[2], referenceExtent[3], referenceExtent[4], referenceExtent[5]);
+  modifier->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  modifier->GetPointData()->GetScalars()->Fill(0);
+  int* extent = modifier->GetExtent();
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = iMin; i <= iMax; ++i)
+        {
+        modifier->SetScalarComponentFromDouble(i, j, k, 0, labelValue);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+int GetNumberOfLabelVoxels(vtkOrientedImageData* labelmap, int labelValue)
+{
+  int numberOfVoxels = 0;
+  int* extent = labelmap->GetExtent();
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+        {
+        if (static_cast<int>(labelmap->GetScalarComponentAsDouble(i, j, k, 0)) == labelValue)
+          {
+          ++numberOfVoxels;
+          }
+        }
+      }
+    }
+  return numberOfVoxels;
+}
+
+//----------------------------------------------------------------------------
+int TestSharedLayer()
+{
+  // 20 voxels in each slice, 5 rows, 4 slices
+  const int voxelsPerColumn = 5 * 4;
+
+  vtkNew<vtkOrientedImageData> labelmap;
+  CreateLabelmap(labelmap, VTK_SHORT);
+
+  vtkNew<vtkImageLabelLogicalOperation> logicalOperation;
+  logicalOperation->SetLabelmap(labelmap);
+  logicalOperation->SetModifierLabelmap(labelmap);
+  logicalOperation->SetLabelValue(1);
+  logicalOperation->AddModifierLabelValue(2);
+
+  // Adding label 2 to label 1 would overwrite label 2, labelmap must not be modified
+  logicalOperation->SetOperationToUnion();
+  CHECK_BOOL(logicalOperation->Execute(), false);
+  CHECK_INT(logicalOperation->GetNumberOfConflictingVoxels(), 5 * voxelsPerColumn);
+  CHECK_INT(logicalOperation->GetNumberOfOverwrittenLabelValues(), 1);
+  CHECK_INT(logicalOperation->GetNthOverwrittenLabelValue(0), 2);
+  CHECK_INT(GetNumberOfLabelVoxels(labelmap, 1), 10 * voxelsPerColumn);
+  CHECK_INT(GetNumberOfLabelVoxels(labelmap, 2), 5 * voxelsPerColumn);
+
+  // Subtract and intersect of non-overlapping labels
+  logicalOperation->SetOperationToSubtract();
+  CHECK_BOOL(logicalOperation->Execute(), true);
+  CHECK_INT(logicalOperation->GetNumberOfModifiedVoxels(), 0);
+  CHECK_INT(logicalOperation->GetNumberOfOverwrittenLabelValues(), 0);
+  CHECK_INT(GetNumberOfLabelVoxels(labelmap, 1), 10 * voxelsPerColumn);
+
+  logicalOperation->SetOperationToIntersect();
+  CHECK_BOOL(logicalOperation->Execute(), true);
+  CHECK_INT(logicalOperation->GetNumberOfModifiedVoxels(), 10 * voxelsPerColumn);
+  CHECK_INT(GetNumberOfLabelVoxels(labelmap, 1), 0);
+  CHECK_INT(GetNumberOfLabelVoxels(labelmap, 2), 5 * voxelsPerColumn);
+
+  // Union with overwrite moves label 2 voxels to label 1
+  CreateLabelmap(labelmap, VTK_SHORT);
+  logicalOperation->SetOperationToUnion();
+  logicalOperation->OverwriteOtherLabelsOn();
+  CHECK_BOOL(logicalOperation->Execute(), true);
+  CHECK_INT(logicalOperation->GetNumberOfModifiedVoxels(), 5 * voxelsPerColumn);
+  CHECK_INT(GetNumberOfLabelVoxels(labelmap, 1), 15 * voxelsPerColumn);
+  CHECK_INT(GetNumberOfLabelVoxels(labelmap, 2), 0);
+
+  // Invert label 2 within the labelmap extent: label 1 voxels are overwritten
+  CreateLabelmap(labelmap, VTK_SHORT);
+  logicalOperation->SetLabelValue(2);
+  logicalOperation->SetOperationToInvert();
+  logicalOperation->OverwriteOtherLabelsOff();
+  CHECK_BOOL(logicalOperation->Execute(), false);
+  CHECK_INT(logicalOperation->GetNumberOfConflictingVoxels(), 10 * voxelsPerColumn);
+  logicalOperation->OverwriteOtherLabelsOn();
+  CHECK_BOOL(logicalOperation->Execute(), true);
+  CHECK_INT(GetNumberOfLabelVoxels(labelmap, 1), 0);
+  CHECK_INT(GetNumberOfLabelVoxels(labelmap, 2), 15 * voxelsPerColumn);
+  CHECK_INT(GetNumberOfLabelVoxels(labelmap, 0), 5 * voxelsPerColumn);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestSeparateLayers()
+{
+  const int voxelsPerColumn = 5 * 4;
+
+  vtkNew<vtkOrientedImageData> labelmap;
+  CreateLabelmap(labelmap, VTK_UNSIGNED_CHAR);
+
+  // Modifier covers the [5,24] range, beyond the labelmap extent
+  vtkNew<vtkOrientedImageData> modifierLabelmap;
+  CreateModifierLabelmap(labelmap, modifierLabelmap, 5, 24, 3, 24);
+
+  vtkNew<vtkImageLabelLogicalOperation> logicalOperation;
+  logicalOperation->SetLabelmap(labelmap);
+  logicalOperation->SetModifierLabelmap(modifierLabelmap);
+  logicalOperation->SetLabelValue(1);
+  logicalOperation->AddModifierLabelValue(3);
+
+  // Intersect: label 1 is only kept in [5,9]
+  logicalOperation->SetOperationToIntersect();
+  CHECK_BOOL(logicalOperation->Execute(), true);
+  CHECK_INT(GetNumberOfLabelVoxels(labelmap, 1), 5 * voxelsPerColumn);
+  CHECK_INT(GetNumberOfLabelVoxels(labelmap, 2), 5 * voxelsPerColumn);
+
+  // Subtract: label 1 is removed
+  CreateLabelmap(labelmap, VTK_UNSIGNED_CHAR);
+  logicalOperation->SetOperationToSubtract();
+  CHECK_BOOL(logicalOperation->Execute(), true);
+  CHECK_INT(GetNumberOfLabelVoxels(labelmap, 1), 5 * voxelsPerColumn);
+  CHECK_INT(GetNumberOfLabelVoxels(labelmap, 2), 5 * voxelsPerColumn);
+
+  // Union: labelmap is padded to contain the modifier region
+  CreateLabelmap(labelmap, VTK_UNSIGNED_CHAR);
+  logicalOperation->SetOperationToUnion();
+  logicalOperation->OverwriteOtherLabelsOn();
+  CHECK_BOOL(logicalOperation->Execute(), true);
+  CHECK_INT(labelmap->GetExtent()[0], 0);
+  CHECK_INT(labelmap->GetExtent()[1], 24);
+  CHECK_INT(GetNumberOfLabelVoxels(labelmap, 1), 25 * voxelsPerColumn);
+  CHECK_INT(GetNumberOfLabelVoxels(labelmap, 2), 0);
+
+  // Any of the modifier label values specify the modifier region
+  CreateLabelmap(labelmap, VTK_UNSIGNED_CHAR);
+  CreateModifierLabelmap(labelmap, modifierLabelmap, 16, 17, 4, 19);
+  logicalOperation->OverwriteOtherLabelsOff();
+  logicalOperation->AddModifierLabelValue(4);
+  CHECK_INT(logicalOperation->GetNumberOfModifierLabelValues(), 2);
+  CHECK_BOOL(logicalOperation->Execute(), true);
+  CHECK_INT(logicalOperation->GetNumberOfConflictingVoxels(), 0);
+  CHECK_INT(GetNumberOfLabelVoxels(labelmap, 1), 12 * voxelsPerColumn);
+
+  // Union into an empty labelmap
+  vtkNew<vtkOrientedImageData> emptyLabelmap;
+  logicalOperation->SetLabelmap(emptyLabelmap);
+  CHECK_BOOL(logicalOperation->Execute(), true);
+  CHECK_INT(GetNumberOfLabelVoxels(emptyLabelmap, 1), 2 * voxelsPerColumn);
+  CHECK_BOOL(emptyLabelmap->GetSpacing()[2] == modifierLabelmap->GetSpacing()[2], true);
+
+  // Invert within a specified extent, label outside the extent is removed
+  CreateLabelmap(labelmap, VTK_UNSIGNED_CHAR);
+  logicalOperation->SetLabelmap(labelmap);
+  logicalOperation->SetLabelValue(2);
+  logicalOperation->SetOperationToInvert();
+  logicalOperation->SetExtent(15, 29, 0, 4, 0, 3);
+  CHECK_BOOL(logicalOperation->Execute(), true);
+  CHECK_INT(labelmap->GetExtent()[1], 29);
+  CHECK_INT(GetNumberOfLabelVoxels(labelmap, 1), 10 * voxelsPerColumn);
+  CHECK_INT(GetNumberOfLabelVoxels(labelmap, 2), 15 * voxelsPerColumn);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestInvalidInputs()
+{
+  vtkNew<vtkOrientedImageData> labelmap;
+  CreateLabelmap(labelmap, VTK_SHORT);
+  vtkNew<vtkOrientedImageData> modifierLabelmap;
+  CreateModifierLabelmap(labelmap, modifierLabelmap, 0, 4, 1, 19);
+  modifierLabelmap->SetSpacing(1.0, 1.0, 1.0);
+
+  vtkNew<vtkImageLabelLogicalOperation> logicalOperation;
+  logicalOperation->SetLabelmap(labelmap);
+  logicalOperation->AddModifierLabelValue(1);
+
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  // No modifier labelmap
+  CHECK_BOOL(logicalOperation->Execute(), false);
+  // Label value 0
+  logicalOperation->SetModifierLabelmap(modifierLabelmap);
+  logicalOperation->SetLabelValue(0);
+  CHECK_BOOL(logicalOperation->Execute(), false);
+  // Different geometry
+  logicalOperation->SetLabelValue(1);
+  CHECK_BOOL(logicalOperation->Execute(), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  CHECK_INT(GetNumberOfLabelVoxels(labelmap, 1), 10 * 5 * 4);
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkImageLabelLogicalOperationTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestSharedLayer());
+  CHECK_EXIT_SUCCESS(TestSeparateLayers());
+  CHECK_EXIT_SUCCESS(TestInvalidInputs());
+  return EXIT_SUCCESS;
+}
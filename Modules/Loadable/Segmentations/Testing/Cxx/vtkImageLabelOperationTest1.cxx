@@ -0,0 +1,626 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// Segmentations includes
+#include "vtkImageLabelIslands.h"
+#include "vtkImageLabelMargin.h"
+#include "vtkImageLabelSmoothing.h"
+
+// vtkSegmentationCore includes
+#include "vtkOrientedImageData.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageGaussianSmooth.h>
+#include <vtkImageThreshold.h>
+#include <vtkIntArray.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+// STD includes
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Binary mask of a label, indexed from the first voxel of the labelmap extent
+typedef std::vector<unsigned char> Mask;
+
+//----------------------------------------------------------------------------
+/// Create a shared labelmap with three labels. Label 1 and 2 are ellipsoids,
+/// label 2 touches the image boundary. Label 3 consists of a few separate blobs.
+void CreateSharedLabelmap(vtkOrientedImageData* labelmap, int dimensions[3])
+{
+  labelmap->SetExtent(-5, dimensions[0] - 6, 10, dimensions[1] + 9, 0, dimensions[2] - 1);
+  labelmap->SetSpacing(0.6, 0.8, 1.3);
+  labelmap->SetOrigin(12.0, -3.0, 7.5);
+  labelmap->SetDirections(0.0, 1.0, 0.0, -1.0, 0.0, 0.0, 0.0, 0.0, 1.0);
+  labelmap->AllocateScalars(VTK_SHORT, 1);
+  labelmap->GetPointData()->GetScalars()->Fill(0);
+  int* extent = labelmap->GetExtent();
+  for (int k = 0; k < dimensions[2]; ++k)
+    {
+    for (int j = 0; j < dimensions[1]; ++j)
+      {
+      for (int i = 0; i < dimensions[0]; ++i)
+        {
+        short* voxel = static_cast<short*>(labelmap->GetScalarPointer(extent[0] + i, extent[2] + j, extent[4] + k));
+        if (pow((i - 12.0) / 8.5, 2) + pow((j - 14.0) / 6.5, 2) + pow((k - 9.0) / 4.5, 2) <= 1.0
+          || (i * 7 + j * 3 + k) % 37 == 0 && pow((i - 12.0) / 10.0, 2) + pow((j - 14.0) / 8.0, 2) + pow((k - 9.0) / 6.0, 2) <= 1.0)
+          {
+          *voxel = 1;
+          }
+        else if (pow((i - dimensions[0] + 4.0) / 6.0, 2) + pow((j - 20.0) / 7.0, 2) + pow((k - 12.0) / 5.0, 2) <= 1.0)
+          {
+          *voxel = 2;
+          }
+        else if ((i - 5) * (i - 5) + (j - 27) * (j - 27) + (k - 3) * (k - 3) <= 5
+          || (i - 13) * (i - 13) + (j - 27) * (j - 27) + (k - 6) * (k - 6) <= 3
+          || (i == 20 && j == 2 && k >= 2 && k <= 5))
+          {
+          *voxel = 3;
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+Mask GetLabelMask(vtkOrientedImageData* labelmap, int labelValue)
+{
+  int* extent = labelmap->GetExtent();
+  Mask mask;
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+        {
+        mask.push_back(*static_cast<short*>(labelmap->GetScalarPointer(i, j, k)) == labelValue ? 1 : 0);
+        }
+      }
+    }
+  return mask;
+}
+
+//----------------------------------------------------------------------------
+/// Compare output of a label operation to the expected result (specified in the extent of the labelmap).
+/// Voxels outside the output extent are expected to be 0.
+int CountMismatchingVoxels(vtkOrientedImageData* output, vtkOrientedImageData* labelmap, const std::vector<unsigned int>& expected)
+{
+  int* extent = labelmap->GetExtent();
+  int* outputExtent = output->GetExtent();
+  int mismatchingVoxels = 0;
+  vtkIdType index = 0;
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i, ++index)
+        {
+        unsigned int value = 0;
+        if (i >= outputExtent[0] && i <= outputExtent[1] && j >= outputExtent[2] && j <= outputExtent[3]
+          && k >= outputExtent[4] && k <= outputExtent[5])
+          {
+          value = static_cast<unsigned int>(output->GetScalarComponentAsDouble(i, j, k, 0));
+          }
+        if (value != expected[index])
+          {
+          ++mismatchingVoxels;
+          }
+        }
+      }
+    }
+  return mismatchingVoxels;
+}
+
+//----------------------------------------------------------------------------
+int CountMismatchingVoxels(vtkOrientedImageData* output, vtkOrientedImageData* labelmap, const Mask& expected)
+{
+  return CountMismatchingVoxels(output, labelmap, std::vector<unsigned int>(expected.begin(), expected.end()));
+}
+
+//----------------------------------------------------------------------------
+/// Brute-force median filter with box kernel, clipped at the image boundary
+Mask ReferenceMedian(const Mask& mask, const int dimensions[3], const int radius[3])
+{
+  Mask result(mask.size(), 0);
+  for (int k = 0; k < dimensions[2]; ++k)
+    {
+    for (int j = 0; j < dimensions[1]; ++j)
+      {
+      for (int i = 0; i < dimensions[0]; ++i)
+        {
+        int count = 0;
+        int kernelVoxels = 0;
+        for (int z = std::max(k - radius[2], 0); z <= std::min(k + radius[2], dimensions[2] - 1); ++z)
+          {
+          for (int y = std::max(j - radius[1], 0); y <= std::min(j + radius[1], dimensions[1] - 1); ++y)
+            {
+            for (int x = std::max(i - radius[0], 0); x <= std::min(i + radius[0], dimensions[0] - 1); ++x)
+              {
+              count += mask[x + dimensions[0] * (y + dimensions[1] * z)];
+              ++kernelVoxels;
+              }
+            }
+          }
+        result[i + dimensions[0] * (j + dimensions[1] * k)] = (2 * count >= kernelVoxels ? 1 : 0);
+        }
+      }
+    }
+  return result;
+}
+
+//----------------------------------------------------------------------------
+/// Brute-force dilation or erosion with the ellipsoid kernel of vtkImageDilateErode3D
+Mask ReferenceDilateErode(const Mask& mask, const int dimensions[3], const int radius[3], bool dilate)
+{
+  Mask result(mask);
+  const unsigned char changedValue = (dilate ? 0 : 1);
+  for (int k = 0; k < dimensions[2]; ++k)
+    {
+    for (int j = 0; j < dimensions[1]; ++j)
+      {
+      for (int i = 0; i < dimensions[0]; ++i)
+        {
+        vtkIdType index = i + dimensions[0] * (j + dimensions[1] * k);
+        if (mask[index] != changedValue)
+          {
+          continue;
+          }
+        for (int z = -radius[2]; z <= radius[2]; ++z)
+          {
+          for (int y = -radius[1]; y <= radius[1]; ++y)
+            {
+            for (int x = -radius[0]; x <= radius[0]; ++x)
+              {
+              double s0 = x / (radius[0] + 0.5);
+              double s1 = y / (radius[1] + 0.5);
+              double s2 = z / (radius[2] + 0.5);
+              if (s0 * s0 + s1 * s1 + s2 * s2 > 1.0
+                || i + x < 0 || i + x >= dimensions[0] || j + y < 0 || j + y >= dimensions[1] || k + z < 0 || k + z >= dimensions[2])
+                {
+                continue;
+                }
+              if (mask[(i + x) + dimensions[0] * ((j + y) + dimensions[1] * (k + z))] != changedValue)
+                {
+                result[index] = 1 - changedValue;
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+  return result;
+}
+
+//----------------------------------------------------------------------------
+/// Brute-force signed distance: distance of each voxel from the nearest voxel that has different value,
+/// negative for foreground voxels.
+std::vector<double> ReferenceSignedDistances(const Mask& mask, const int dimensions[3], const double spacing[3])
+{
+  std::vector<std::array<double, 3>> positions[2];
+  for (vtkIdType index = 0; index < static_cast<vtkIdType>(mask.size()); ++index)
+    {
+    const std::array<double, 3> position = { { (index % dimensions[0]) * spacing[0],
+      ((index / dimensions[0]) % dimensions[1]) * spacing[1], (index / (dimensions[0] * dimensions[1])) * spacing[2] } };
+    positions[mask[index]].push_back(position);
+    }
+  std::vector<double> signedDistances(mask.size());
+  vtkIdType voxelIndex[2] = { 0, 0 };
+  for (vtkIdType index = 0; index < static_cast<vtkIdType>(mask.size()); ++index)
+    {
+    const int value = mask[index];
+    const std::array<double, 3>& position = positions[value][voxelIndex[value]++];
+    double squaredDistance = std::numeric_limits<double>::max();
+    for (const std::array<double, 3>& otherPosition : positions[1 - value])
+      {
+      squaredDistance = std::min(squaredDistance, pow(position[0] - otherPosition[0], 2)
+        + pow(position[1] - otherPosition[1], 2) + pow(position[2] - otherPosition[2], 2));
+      }
+    signedDistances[index] = (value ? -sqrt(squaredDistance) : sqrt(squaredDistance));
+    }
+  return signedDistances;
+}
+
+//----------------------------------------------------------------------------
+/// Voxels whose signed distance is between innerMargin and margin.
+/// Voxels at exactly margin distance are on the side of the label boundary.
+Mask ReferenceMargin(const std::vector<double>& signedDistances, double margin,
+  double innerMargin = -std::numeric_limits<double>::infinity())
+{
+  const double tolerance = 1e-6;
+  Mask result(signedDistances.size(), 0);
+  for (vtkIdType index = 0; index < static_cast<vtkIdType>(signedDistances.size()); ++index)
+    {
+    const double signedDistance = signedDistances[index];
+    const bool belowMargin = (margin >= 0 ? signedDistance <= margin + tolerance : signedDistance < margin - tolerance);
+    const bool aboveInnerMargin = (innerMargin <= 0 ? signedDistance >= innerMargin - tolerance : signedDistance > innerMargin + tolerance);
+    result[index] = (belowMargin && aboveInnerMargin ? 1 : 0);
+    }
+  return result;
+}
+
+//----------------------------------------------------------------------------
+/// Flood-fill connected components, sort them by size
+std::vector<unsigned int> ReferenceIslands(const Mask& mask, const int dimensions[3], bool fullyConnected, vtkIdType minimumSize,
+  int& numberOfIslands)
+{
+  std::vector<int> islands(mask.size(), -1);
+  std::vector<vtkIdType> islandSizes;
+  for (vtkIdType start = 0; start < static_cast<vtkIdType>(mask.size()); ++start)
+    {
+    if (!mask[start] || islands[start] >= 0)
+      {
+      continue;
+      }
+    const int island = static_cast<int>(islandSizes.size());
+    islandSizes.push_back(0);
+    std::deque<vtkIdType> queue(1, start);
+    islands[start] = island;
+    while (!queue.empty())
+      {
+      vtkIdType index = queue.front();
+      queue.pop_front();
+      ++islandSizes[island];
+      const int position[3] = { static_cast<int>(index % dimensions[0]), static_cast<int>((index / dimensions[0]) % dimensions[1]),
+        static_cast<int>(index / (dimensions[0] * dimensions[1])) };
+      for (int offset = 0; offset < 27; ++offset)
+        {
+        const int neighborOffset[3] = { offset % 3 - 1, (offset / 3) % 3 - 1, offset / 9 - 1 };
+        const int distance = abs(neighborOffset[0]) + abs(neighborOffset[1]) + abs(neighborOffset[2]);
+        if (distance == 0 || (!fullyConnected && distance > 1))
+          {
+          continue;
+          }
+        int neighbor[3] = { 0, 0, 0 };
+        bool inside = true;
+        for (int axis = 0; axis < 3; ++axis)
+          {
+          neighbor[axis] = position[axis] + neighborOffset[axis];
+          inside = inside && neighbor[axis] >= 0 && neighbor[axis] < dimensions[axis];
+          }
+        if (!inside)
+          {
+          continue;
+          }
+        const vtkIdType neighborIndex = neighbor[0] + dimensions[0] * (neighbor[1] + static_cast<vtkIdType>(dimensions[1]) * neighbor[2]);
+        if (mask[neighborIndex] && islands[neighborIndex] < 0)
+          {
+          islands[neighborIndex] = island;
+          queue.push_back(neighborIndex);
+          }
+        }
+      }
+    }
+  std::vector<int> sortedIslands(islandSizes.size());
+  for (int island = 0; island < static_cast<int>(sortedIslands.size()); ++island)
+    {
+    sortedIslands[island] = island;
+    }
+  std::stable_sort(sortedIslands.begin(), sortedIslands.end(),
+    [&islandSizes](int island1, int island2) { return islandSizes[island1] > islandSizes[island2]; });
+  std::vector<unsigned int> islandLabelValues(islandSizes.size(), 0);
+  numberOfIslands = 0;
+  for (int island : sortedIslands)
+    {
+    if (islandSizes[island] >= minimumSize)
+      {
+      islandLabelValues[island] = ++numberOfIslands;
+      }
+    }
+  std::vector<unsigned int> result(mask.size(), 0);
+  for (vtkIdType index = 0; index < static_cast<vtkIdType>(mask.size()); ++index)
+    {
+    result[index] = (islands[index] >= 0 ? islandLabelValues[islands[index]] : 0);
+    }
+  return result;
+}
+
+//----------------------------------------------------------------------------
+int TestLabelExtents()
+{
+  int dimensions[3] = { 32, 30, 20 };
+  vtkNew<vtkOrientedImageData> labelmap;
+  CreateSharedLabelmap(labelmap, dimensions);
+
+  vtkNew<vtkImageLabelMargin> margin;
+  margin->SetLabelmap(labelmap);
+  vtkNew<vtkIntArray> labelValues;
+  margin->GetLabelValues(labelValues);
+  CHECK_INT(labelValues->GetNumberOfValues(), 3);
+  CHECK_INT(labelValues->GetValue(0), 1);
+  CHECK_INT(labelValues->GetValue(2), 3);
+
+  int labelExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  CHECK_BOOL(margin->GetLabelExtent(2, labelExtent), true);
+  CHECK_INT(labelExtent[1], labelmap->GetExtent()[1]);
+  CHECK_BOOL(margin->GetLabelExtent(4, labelExtent), false);
+
+  // Cached extents are updated when the labelmap is modified
+  short* voxel = static_cast<short*>(labelmap->GetScalarPointer(labelmap->GetExtent()[0], 10, 0));
+  *voxel = 4;
+  labelmap->Modified();
+  CHECK_BOOL(margin->GetLabelExtent(4, labelExtent), true);
+  CHECK_INT(labelExtent[0], labelmap->GetExtent()[0]);
+  CHECK_INT(labelExtent[1], labelmap->GetExtent()[0]);
+
+  // Output of a missing label is empty
+  vtkNew<vtkOrientedImageData> output;
+  CHECK_BOOL(margin->Execute(5, output), true);
+  CHECK_BOOL(output->IsEmpty(), true);
+  margin->CropOutputOff();
+  CHECK_BOOL(margin->Execute(5, output), true);
+  CHECK_INT(output->GetExtent()[1], labelmap->GetExtent()[1]);
+
+  // Invalid input
+  vtkNew<vtkImageLabelMargin> marginWithoutInput;
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(marginWithoutInput->Execute(1, output), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestSmoothing()
+{
+  int dimensions[3] = { 32, 30, 20 };
+  vtkNew<vtkOrientedImageData> labelmap;
+  CreateSharedLabelmap(labelmap, dimensions);
+
+  vtkNew<vtkImageLabelSmoothing> smoothing;
+  smoothing->SetLabelmap(labelmap);
+  const int kernelSize[3] = { 5, 3, 3 };
+  const int kernelRadius[3] = { 2, 1, 1 };
+  smoothing->SetKernelSize(kernelSize[0], kernelSize[1], kernelSize[2]);
+  vtkNew<vtkOrientedImageData> output;
+  for (int labelValue = 1; labelValue <= 3; ++labelValue)
+    {
+    Mask mask = GetLabelMask(labelmap, labelValue);
+    for (bool cropOutput : { true, false })
+      {
+      smoothing->SetCropOutput(cropOutput);
+
+      smoothing->SetMethodToMedian();
+      CHECK_BOOL(smoothing->Execute(labelValue, output), true);
+      CHECK_INT(CountMismatchingVoxels(output, labelmap, ReferenceMedian(mask, dimensions, kernelRadius)), 0);
+
+      smoothing->SetMethodToMorphologicalOpening();
+      CHECK_BOOL(smoothing->Execute(labelValue, output), true);
+      CHECK_INT(CountMismatchingVoxels(output, labelmap, ReferenceDilateErode(
+        ReferenceDilateErode(mask, dimensions, kernelRadius, false), dimensions, kernelRadius, true)), 0);
+
+      smoothing->SetMethodToMorphologicalClosing();
+      CHECK_BOOL(smoothing->Execute(labelValue, output), true);
+      CHECK_INT(CountMismatchingVoxels(output, labelmap, ReferenceDilateErode(
+        ReferenceDilateErode(mask, dimensions, kernelRadius, true), dimensions, kernelRadius, false)), 0);
+      }
+    }
+
+  // Output has the geometry of the input
+  double directions[3][3] = { { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 } };
+  output->GetDirections(directions);
+  CHECK_DOUBLE_TOLERANCE(directions[1][0], -1.0, 1e-9);
+  CHECK_DOUBLE_TOLERANCE(output->GetSpacing()[2], 1.3, 1e-9);
+
+  // Gaussian smoothing is compared to the previously used filter pipeline
+  smoothing->SetMethodToGaussian();
+  smoothing->SetGaussianStandardDeviation(1.5, 1.2, 0.8);
+  smoothing->CropOutputOn();
+  CHECK_BOOL(smoothing->Execute(1, output), true);
+  vtkNew<vtkImageThreshold> threshold;
+  threshold->SetInputData(labelmap);
+  threshold->ThresholdBetween(1, 1);
+  threshold->SetInValue(255);
+  threshold->SetOutValue(0);
+  threshold->SetOutputScalarTypeToUnsignedChar();
+  vtkNew<vtkImageGaussianSmooth> gaussianFilter;
+  gaussianFilter->SetInputConnection(threshold->GetOutputPort());
+  gaussianFilter->SetStandardDeviation(1.5, 1.2, 0.8);
+  gaussianFilter->SetRadiusFactor(4.0);
+  gaussianFilter->Update();
+  Mask expected;
+  vtkImageData* gaussianImage = gaussianFilter->GetOutput();
+  int* extent = gaussianImage->GetExtent();
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+        {
+        expected.push_back(gaussianImage->GetScalarComponentAsDouble(i, j, k, 0) >= 127 ? 1 : 0);
+        }
+      }
+    }
+  // Intermediate results are rounded differently, which may change a few voxels at the boundary
+  int mismatchingVoxels = CountMismatchingVoxels(output, labelmap, expected);
+  int expectedForegroundVoxels = static_cast<int>(std::count(expected.begin(), expected.end(), 1));
+  std::cout << "Gaussian smoothing mismatching voxels: " << mismatchingVoxels
+    << " (foreground voxels: " << expectedForegroundVoxels << ")" << std::endl;
+  CHECK_BOOL(expectedForegroundVoxels > 0, true);
+  CHECK_BOOL(mismatchingVoxels < 0.02 * expectedForegroundVoxels, true);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestMargin()
+{
+  int dimensions[3] = { 32, 30, 20 };
+  vtkNew<vtkOrientedImageData> labelmap;
+  CreateSharedLabelmap(labelmap, dimensions);
+
+  vtkNew<vtkImageLabelMargin> margin;
+  margin->SetLabelmap(labelmap);
+  vtkNew<vtkOrientedImageData> output;
+  for (int labelValue = 1; labelValue <= 3; ++labelValue)
+    {
+    std::vector<double> signedDistances = ReferenceSignedDistances(GetLabelMask(labelmap, labelValue), dimensions, labelmap->GetSpacing());
+    for (double marginSize : { 2.4, -1.3, 0.6 })
+      {
+      margin->SetMarginSize(marginSize);
+      CHECK_BOOL(margin->Execute(labelValue, output), true);
+      CHECK_INT(CountMismatchingVoxels(output, labelmap, ReferenceMargin(signedDistances, marginSize)), 0);
+      }
+    // Shells: outside the label, inside the label, centered on the boundary, inside band
+    const double shellMargins[4][2] = { { 0.0, 3.0 }, { -1.7, 0.0 }, { -1.2, 1.2 }, { -2.5, -0.8 } };
+    for (const auto& shellMargin : shellMargins)
+      {
+      margin->SetInnerMarginSize(shellMargin[0]);
+      margin->SetMarginSize(shellMargin[1]);
+      CHECK_BOOL(margin->Execute(labelValue, output), true);
+      CHECK_INT(CountMismatchingVoxels(output, labelmap,
+        ReferenceMargin(signedDistances, shellMargin[1], shellMargin[0])), 0);
+      }
+    margin->SetInnerMarginSize(vtkMath::NegInf());
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestMarginCache()
+{
+  int dimensions[3] = { 32, 30, 20 };
+  vtkNew<vtkOrientedImageData> labelmap;
+  CreateSharedLabelmap(labelmap, dimensions);
+
+  vtkNew<vtkImageLabelMargin> margin;
+  margin->SetLabelmap(labelmap);
+  vtkNew<vtkOrientedImageData> output;
+
+  // Changing the margin size only requires thresholding of the cached distance map
+  margin->SetMarginSize(2.0);
+  CHECK_BOOL(margin->Execute(1, output), true);
+  CHECK_BOOL(margin->GetDistanceMapReused(), false);
+  margin->SetMarginSize(1.0);
+  CHECK_BOOL(margin->Execute(1, output), true);
+  CHECK_BOOL(margin->GetDistanceMapReused(), true);
+  // Distance map is extended when the margin is larger than before
+  margin->SetMarginSize(3.0);
+  CHECK_BOOL(margin->Execute(1, output), true);
+  CHECK_BOOL(margin->GetDistanceMapReused(), false);
+  margin->SetMarginSize(3.5);
+  CHECK_BOOL(margin->Execute(1, output), true);
+  CHECK_BOOL(margin->GetDistanceMapReused(), true);
+  // Inside distances are computed at the first shrink
+  margin->SetMarginSize(-1.0);
+  CHECK_BOOL(margin->Execute(1, output), true);
+  CHECK_BOOL(margin->GetDistanceMapReused(), false);
+  margin->SetMarginSize(-2.0);
+  CHECK_BOOL(margin->Execute(1, output), true);
+  CHECK_BOOL(margin->GetDistanceMapReused(), true);
+  // Distance maps of different labels are cached independently
+  CHECK_BOOL(margin->Execute(2, output), true);
+  CHECK_BOOL(margin->GetDistanceMapReused(), false);
+  CHECK_BOOL(margin->Execute(1, output), true);
+  CHECK_BOOL(margin->GetDistanceMapReused(), true);
+
+  // Modifying another label does not invalidate the distance map
+  int* extent = labelmap->GetExtent();
+  *static_cast<short*>(labelmap->GetScalarPointer(extent[1], extent[3], extent[5])) = 3;
+  labelmap->Modified();
+  margin->SetMarginSize(2.5);
+  CHECK_BOOL(margin->Execute(1, output), true);
+  CHECK_BOOL(margin->GetDistanceMapReused(), true);
+
+  // Modifying the label invalidates the distance map
+  *static_cast<short*>(labelmap->GetScalarPointer(extent[0] + 12, extent[2] + 14, extent[4] + 9)) = 0;
+  labelmap->Modified();
+  CHECK_BOOL(margin->Execute(1, output), true);
+  CHECK_BOOL(margin->GetDistanceMapReused(), false);
+  CHECK_INT(CountMismatchingVoxels(output, labelmap,
+    ReferenceMargin(ReferenceSignedDistances(GetLabelMask(labelmap, 1), dimensions, labelmap->GetSpacing()), 2.5)), 0);
+
+  // Distance map is reused for a different labelmap object with the same content
+  vtkNew<vtkOrientedImageData> labelmapCopy;
+  labelmapCopy->DeepCopy(labelmap);
+  margin->SetLabelmap(labelmapCopy);
+  CHECK_BOOL(margin->Execute(1, output), true);
+  CHECK_BOOL(margin->GetDistanceMapReused(), true);
+
+  margin->ClearCache();
+  CHECK_BOOL(margin->Execute(1, output), true);
+  CHECK_BOOL(margin->GetDistanceMapReused(), false);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestIslands()
+{
+  int dimensions[3] = { 32, 30, 20 };
+  vtkNew<vtkOrientedImageData> labelmap;
+  CreateSharedLabelmap(labelmap, dimensions);
+
+  vtkNew<vtkImageLabelIslands> islands;
+  islands->SetLabelmap(labelmap);
+  vtkNew<vtkOrientedImageData> output;
+  for (int labelValue = 1; labelValue <= 3; ++labelValue)
+    {
+    Mask mask = GetLabelMask(labelmap, labelValue);
+    for (bool fullyConnected : { false, true })
+      {
+      for (vtkIdType minimumSize : { 0, 4 })
+        {
+        islands->SetFullyConnected(fullyConnected);
+        islands->SetMinimumSize(minimumSize);
+        CHECK_BOOL(islands->Execute(labelValue, output), true);
+        CHECK_INT(output->GetScalarType(), VTK_UNSIGNED_INT);
+        int expectedNumberOfIslands = 0;
+        CHECK_INT(CountMismatchingVoxels(output, labelmap,
+          ReferenceIslands(mask, dimensions, fullyConnected, minimumSize, expectedNumberOfIslands)), 0);
+        CHECK_INT(islands->GetNumberOfIslands(), expectedNumberOfIslands);
+        }
+      }
+    }
+
+  // Label 3 consists of three islands: two blobs and a 4-voxel line
+  islands->SetFullyConnected(false);
+  islands->SetMinimumSize(0);
+  CHECK_BOOL(islands->Execute(3, output), true);
+  CHECK_INT(islands->GetOriginalNumberOfIslands(), 3);
+  CHECK_INT(islands->GetIslandSize(3), 4);
+  CHECK_INT(islands->GetIslandSize(4), 0);
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkImageLabelOperationTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestLabelExtents());
+  CHECK_EXIT_SUCCESS(TestSmoothing());
+  CHECK_EXIT_SUCCESS(TestMargin());
+  CHECK_EXIT_SUCCESS(TestMarginCache());
+  CHECK_EXIT_SUCCESS(TestIslands());
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
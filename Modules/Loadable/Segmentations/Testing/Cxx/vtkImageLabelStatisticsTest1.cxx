@@ -0,0 +1,278 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLCoreTestingUtilities.h"
+
+// Segmentations includes
+#include "vtkImageLabelStatistics.h"
+
+// vtkSegmentationCore includes
+#include "vtkOrientedImageData.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageAccumulate.h>
+#include <vtkImageData.h>
+#include <vtkImageThreshold.h>
+#include <vtkImageToImageStencil.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkTable.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+double GetTableValue(vtkTable* table, const char* columnName, vtkIdType row, int component = 0)
+{
+  vtkDataArray* column = vtkDataArray::SafeDownCast(table->GetColumnByName(columnName));
+  if (!column)
+    {
+    std::cerr << "Column " << columnName << " not found" << std::endl;
+    return -1.0;
+    }
+  return column->GetComponent(row, component);
+}
+
+//----------------------------------------------------------------------------
+/// Labelmap with boxes of different labels on a grid and a scalar volume with varying intensity.
+void CreateTestVolumes(int size, int numberOfBoxesPerAxis, vtkImageData* labelmap, vtkImageData* scalarVolume)
+{
+  labelmap->SetDimensions(size, size, size);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  scalarVolume->SetDimensions(size, size, size);
+  scalarVolume->AllocateScalars(VTK_SHORT, 1);
+  unsigned char* labelPtr = static_cast<unsigned char*>(labelmap->GetScalarPointer());
+  short* scalarPtr = static_cast<short*>(scalarVolume->GetScalarPointer());
+  const int boxSpacing = size / numberOfBoxesPerAxis;
+  for (int k = 0; k < size; k++)
+    {
+    for (int j = 0; j < size; j++)
+      {
+      for (int i = 0; i < size; i++)
+        {
+        int boxI = i / boxSpacing;
+        int boxJ = j / boxSpacing;
+        int boxK = k / boxSpacing;
+        bool insideBox = boxI < numberOfBoxesPerAxis && boxJ < numberOfBoxesPerAxis && boxK < numberOfBoxesPerAxis
+          && (i % boxSpacing) < boxSpacing - 2 && (j % boxSpacing) < boxSpacing - 1 && (k % boxSpacing) < boxSpacing - 3;
+        int labelValue = insideBox ? 1 + boxI + numberOfBoxesPerAxis * (boxJ + numberOfBoxesPerAxis * boxK) : 0;
+        *(labelPtr++) = static_cast<unsigned char>(labelValue);
+        *(scalarPtr++) = static_cast<short>((i * 7 + j * 13 + k * 3) % 101 - 20 + labelValue);
+        }
+      }
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int TestLabelStatistics()
+{
+  const int size = 40;
+  vtkNew<vtkOrientedImageData> labelmap;
+  vtkNew<vtkImageData> scalarVolume;
+  CreateTestVolumes(size, 3, labelmap, scalarVolume);
+  // Add a sparse label value and a label that is only partially inside the scalar volume
+  labelmap->SetScalarComponentFromDouble(0, 12, 0, 0, 200);
+  labelmap->SetScalarComponentFromDouble(1, 12, 0, 0, 200);
+  labelmap->SetSpacing(0.5, 1.5, 2.0);
+  labelmap->SetOrigin(10.0, -20.0, 30.0);
+  labelmap->SetDirections(0.0, 1.0, 0.0, -1.0, 0.0, 0.0, 0.0, 0.0, 1.0);
+
+  vtkNew<vtkImageLabelStatistics> labelStatistics;
+  labelStatistics->SetLabelmap(labelmap);
+  labelStatistics->SetScalarVolume(scalarVolume);
+  labelStatistics->ComputeShapeStatisticsOn();
+  labelStatistics->SetPercentiles({ 0.0, 90.0, 100.0 });
+  labelStatistics->Update();
+  vtkTable* table = labelStatistics->GetOutput();
+  CHECK_INT(table->GetNumberOfRows(), 28);
+  CHECK_INT(labelStatistics->GetRowForLabelValue(0), -1);
+  CHECK_INT(labelStatistics->GetRowForLabelValue(50), -1);
+
+  vtkNew<vtkMatrix4x4> imageToWorld;
+  labelmap->GetImageToWorldMatrix(imageToWorld);
+  for (int labelValue : { 1, 14, 27, 200 })
+    {
+    vtkIdType row = labelStatistics->GetRowForLabelValue(labelValue);
+    CHECK_BOOL(row >= 0, true);
+    CHECK_INT(GetTableValue(table, "LabelValue", row), labelValue);
+
+    // Compute reference values voxel by voxel
+    std::vector<double> values;
+    double centroid[3] = { 0.0, 0.0, 0.0 };
+    for (int k = 0; k < size; k++)
+      {
+      for (int j = 0; j < size; j++)
+        {
+        for (int i = 0; i < size; i++)
+          {
+          if (labelmap->GetScalarComponentAsDouble(i, j, k, 0) != labelValue)
+            {
+            continue;
+            }
+          values.push_back(scalarVolume->GetScalarComponentAsDouble(i, j, k, 0));
+          double position[4] = { static_cast<double>(i), static_cast<double>(j), static_cast<double>(k), 1.0 };
+          imageToWorld->MultiplyPoint(position, position);
+          for (int axis = 0; axis < 3; axis++)
+            {
+            centroid[axis] += position[axis];
+            }
+          }
+        }
+      }
+    const double numberOfValues = static_cast<double>(values.size());
+    double mean = 0.0;
+    for (double value : values)
+      {
+      mean += value / numberOfValues;
+      }
+    double variance = 0.0;
+    for (double value : values)
+      {
+      variance += (value - mean) * (value - mean) / (numberOfValues - 1.0);
+      }
+    std::sort(values.begin(), values.end());
+
+    CHECK_INT(GetTableValue(table, "VoxelCount", row), static_cast<int>(values.size()));
+    CHECK_DOUBLE_TOLERANCE(GetTableValue(table, "Volume", row), numberOfValues * 0.5 * 1.5 * 2.0, 1e-6);
+    CHECK_DOUBLE_TOLERANCE(GetTableValue(table, "Minimum", row), values.front(), 1e-6);
+    CHECK_DOUBLE_TOLERANCE(GetTableValue(table, "Maximum", row), values.back(), 1e-6);
+    CHECK_DOUBLE_TOLERANCE(GetTableValue(table, "Mean", row), mean, 1e-6);
+    CHECK_DOUBLE_TOLERANCE(GetTableValue(table, "StandardDeviation", row), std::sqrt(variance), 1e-6);
+    CHECK_DOUBLE_TOLERANCE(GetTableValue(table, "Median", row), values[(values.size() + 1) / 2 - 1], 1e-6);
+    CHECK_DOUBLE_TOLERANCE(GetTableValue(table, "Percentile0", row), values.front(), 1e-6);
+    CHECK_DOUBLE_TOLERANCE(GetTableValue(table, "Percentile90", row),
+      values[static_cast<size_t>(std::ceil(0.9 * numberOfValues)) - 1], 1e-6);
+    CHECK_DOUBLE_TOLERANCE(GetTableValue(table, "Percentile100", row), values.back(), 1e-6);
+    for (int axis = 0; axis < 3; axis++)
+      {
+      CHECK_DOUBLE_TOLERANCE(GetTableValue(table, "Centroid", row, axis), centroid[axis] / numberOfValues, 1e-6);
+      }
+    }
+
+  // Principal moments of a box are (size^2)/12 along each axis, independently of the axis directions
+  vtkIdType row = labelStatistics->GetRowForLabelValue(1);
+  const double boxSize[3] = { 11.0 * 0.5, 12.0 * 1.5, 10.0 * 2.0 };
+  CHECK_DOUBLE_TOLERANCE(GetTableValue(table, "PrincipalMoments", row, 0), boxSize[0] * boxSize[0] / 12.0, 1e-6);
+  CHECK_DOUBLE_TOLERANCE(GetTableValue(table, "PrincipalMoments", row, 1), boxSize[1] * boxSize[1] / 12.0, 1e-6);
+  CHECK_DOUBLE_TOLERANCE(GetTableValue(table, "PrincipalMoments", row, 2), boxSize[2] * boxSize[2] / 12.0, 1e-6);
+  CHECK_DOUBLE_TOLERANCE(GetTableValue(table, "Elongation", row), boxSize[2] / boxSize[1], 1e-6);
+  CHECK_DOUBLE_TOLERANCE(GetTableValue(table, "Flatness", row), boxSize[1] / boxSize[0], 1e-6);
+  // Smallest principal axis is along the image I axis, which is the world -Y axis
+  CHECK_DOUBLE_TOLERANCE(std::abs(GetTableValue(table, "PrincipalAxisX", row, 1)), 1.0, 1e-6);
+  CHECK_DOUBLE_TOLERANCE(std::abs(GetTableValue(table, "PrincipalAxisZ", row, 2)), 1.0, 1e-6);
+
+  // Only voxels inside the scalar volume are taken into account
+  scalarVolume->SetExtent(1, size - 1, 0, size - 1, 0, size - 1);
+  scalarVolume->AllocateScalars(VTK_FLOAT, 1);
+  scalarVolume->GetPointData()->GetScalars()->Fill(3.0);
+  labelStatistics->ComputeShapeStatisticsOff();
+  labelStatistics->Update();
+  row = labelStatistics->GetRowForLabelValue(200);
+  CHECK_INT(GetTableValue(table, "VoxelCount", row), 1);
+  CHECK_DOUBLE_TOLERANCE(GetTableValue(table, "Median", row), 3.0, 1e-6);
+  CHECK_NULL(table->GetColumnByName("Centroid"));
+
+  // Without scalar volume only voxel counts are computed
+  labelStatistics->SetScalarVolume(nullptr);
+  labelStatistics->Update();
+  CHECK_INT(table->GetNumberOfRows(), 28);
+  CHECK_INT(GetTableValue(table, "VoxelCount", labelStatistics->GetRowForLabelValue(200)), 2);
+  CHECK_NULL(table->GetColumnByName("Mean"));
+  CHECK_NULL(table->GetColumnByName("Median"));
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+/// Compare computing statistics for each label separately (as it was done in SegmentStatistics
+/// plugins) with computing statistics of all labels at once.
+int TestLabelStatisticsPerformance()
+{
+  const int size = 200;
+  const int numberOfBoxesPerAxis = 5;
+  const int numberOfLabels = numberOfBoxesPerAxis * numberOfBoxesPerAxis * numberOfBoxesPerAxis;
+  vtkNew<vtkImageData> labelmap;
+  vtkNew<vtkImageData> scalarVolume;
+  CreateTestVolumes(size, numberOfBoxesPerAxis, labelmap, scalarVolume);
+  vtkNew<vtkTimerLog> timer;
+
+  std::vector<double> perLabelVoxelCounts;
+  std::vector<double> perLabelMeans;
+  timer->StartTimer();
+  for (int labelValue = 1; labelValue <= numberOfLabels; labelValue++)
+    {
+    vtkNew<vtkImageThreshold> threshold;
+    threshold->SetInputData(labelmap);
+    threshold->ThresholdBetween(labelValue, labelValue);
+    threshold->SetInValue(1);
+    threshold->SetOutValue(0);
+    threshold->SetOutputScalarTypeToUnsignedChar();
+    vtkNew<vtkImageToImageStencil> stencil;
+    stencil->SetInputConnection(threshold->GetOutputPort());
+    stencil->ThresholdByUpper(1);
+    stencil->Update();
+    vtkNew<vtkImageAccumulate> accumulate;
+    accumulate->SetInputData(scalarVolume);
+    accumulate->SetStencilData(stencil->GetOutput());
+    accumulate->Update();
+    perLabelVoxelCounts.push_back(static_cast<double>(accumulate->GetVoxelCount()));
+    perLabelMeans.push_back(accumulate->GetMean()[0]);
+    }
+  timer->StopTimer();
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("LabelStatistics-PerLabel125Labels200Cube", timer->GetElapsedTime());
+
+  vtkNew<vtkImageLabelStatistics> labelStatistics;
+  labelStatistics->SetLabelmap(labelmap);
+  labelStatistics->SetScalarVolume(scalarVolume);
+  labelStatistics->ComputeShapeStatisticsOn();
+  timer->StartTimer();
+  labelStatistics->Update();
+  timer->StopTimer();
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("LabelStatistics-AllLabels125Labels200Cube", timer->GetElapsedTime());
+
+  vtkTable* table = labelStatistics->GetOutput();
+  CHECK_INT(table->GetNumberOfRows(), numberOfLabels);
+  for (int labelValue = 1; labelValue <= numberOfLabels; labelValue++)
+    {
+    vtkIdType row = labelStatistics->GetRowForLabelValue(labelValue);
+    CHECK_DOUBLE_TOLERANCE(GetTableValue(table, "VoxelCount", row), perLabelVoxelCounts[labelValue - 1], 0.5);
+    CHECK_DOUBLE_TOLERANCE(GetTableValue(table, "Mean", row), perLabelMeans[labelValue - 1], 1e-6);
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelStatisticsTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestLabelStatistics());
+  CHECK_EXIT_SUCCESS(TestLabelStatisticsPerformance());
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,301 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLSegmentEditorNode.h"
+#include "vtkMRMLSegmentationNode.h"
+
+// Segmentations includes
+#include "vtkSlicerSegmentEditingPipeline.h"
+#include "vtkSlicerSegmentationsModuleLogic.h"
+
+// vtkSegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkSegment.h"
+#include "vtkSegmentation.h"
+#include "vtkSegmentationConverter.h"
+
+// VTK includes
+#include <vtkCollection.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Source image with a bright sphere (radius 8 voxels) and a small bright blob (7 voxels)
+void CreateSourceImage(vtkOrientedImageData* image)
+{
+  image->SetExtent(0, 39, 0, 39, 0, 19);
+  image->SetSpacing(1.0, 1.0, 1.0);
+  image->SetOrigin(-20.0, 10.0, 5.0);
+  image->AllocateScalars(VTK_SHORT, 1);
+  for (int k = 0; k <= 19; ++k)
+    {
+    for (int j = 0; j <= 39; ++j)
+      {
+      for (int i = 0; i <= 39; ++i)
+        {
+        short value = 0;
+        if ((i - 20) * (i - 20) + (j - 20) * (j - 20) + (k - 10) * (k - 10) <= 64)
+          {
+          value = 100;
+          }
+        else if ((i - 5) * (i - 5) + (j - 5) * (j - 5) + (k - 5) * (k - 5) <= 1)
+          {
+          value = 150;
+          }
+        *static_cast<short*>(image->GetScalarPointer(i, j, k)) = value;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+int CountSourceVoxels(vtkOrientedImageData* image, double lower, double upper)
+{
+  int count = 0;
+  int* extent = image->GetExtent();
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+        {
+        double value = image->GetScalarComponentAsDouble(i, j, k, 0);
+        if (value >= lower && value <= upper)
+          {
+          ++count;
+          }
+        }
+      }
+    }
+  return count;
+}
+
+//----------------------------------------------------------------------------
+/// Segmentation with binary labelmap master representation and two empty segments ("A" and "B")
+void CreateSegmentation(vtkSegmentation* segmentation, vtkOrientedImageData* sourceImage)
+{
+  const std::string binaryLabelmapName = vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName();
+  segmentation->SetMasterRepresentationName(binaryLabelmapName);
+  segmentation->SetConversionParameter(vtkSegmentationConverter::GetReferenceImageGeometryParameterName(),
+    vtkSegmentationConverter::SerializeImageGeometry(sourceImage));
+  const char* segmentIDs[2] = { "A", "B" };
+  for (const char* segmentID : segmentIDs)
+    {
+    vtkNew<vtkSegment> segment;
+    segment->SetName(segmentID);
+    vtkNew<vtkOrientedImageData> labelmap;
+    segment->AddRepresentation(binaryLabelmapName, labelmap);
+    segmentation->AddSegment(segment, segmentID);
+    }
+}
+
+//----------------------------------------------------------------------------
+int CountSegmentVoxels(vtkSegmentation* segmentation, const std::string& segmentID)
+{
+  vtkSegment* segment = segmentation->GetSegment(segmentID);
+  vtkOrientedImageData* labelmap = vtkOrientedImageData::SafeDownCast(
+    segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()));
+  if (!labelmap || labelmap->IsEmpty() || !labelmap->GetPointData()->GetScalars())
+    {
+    return 0;
+    }
+  int count = 0;
+  int* extent = labelmap->GetExtent();
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+        {
+        if (labelmap->GetScalarComponentAsDouble(i, j, k, 0) == segment->GetLabelValue())
+          {
+          ++count;
+          }
+        }
+      }
+    }
+  return count;
+}
+
+//----------------------------------------------------------------------------
+int TestOperations(vtkOrientedImageData* sourceImage)
+{
+  const int sphereVoxels = CountSourceVoxels(sourceImage, 50, 120);
+  const int brightVoxels = CountSourceVoxels(sourceImage, 50, 200);
+  CHECK_INT(brightVoxels, sphereVoxels + 7);
+
+  vtkNew<vtkSegmentation> segmentation;
+  CreateSegmentation(segmentation, sourceImage);
+  vtkNew<vtkSlicerSegmentEditingPipeline> pipeline;
+
+  // Threshold and islands
+  pipeline->AddThreshold("A", 50, 200);
+  CHECK_INT(pipeline->GetNumberOfOperations(), 1);
+  CHECK_BOOL(pipeline->Execute(segmentation, sourceImage), true);
+  CHECK_INT(CountSegmentVoxels(segmentation, "A"), brightVoxels);
+  pipeline->RemoveAllOperations();
+  pipeline->AddIslands("A", 10);
+  CHECK_BOOL(pipeline->Execute(segmentation, sourceImage), true);
+  CHECK_INT(CountSegmentVoxels(segmentation, "A"), sphereVoxels);
+
+  // Margin
+  pipeline->RemoveAllOperations();
+  pipeline->AddMargin("A", 2.0);
+  CHECK_BOOL(pipeline->Execute(segmentation), true);
+  const int grownVoxels = CountSegmentVoxels(segmentation, "A");
+  CHECK_BOOL(grownVoxels > sphereVoxels, true);
+  pipeline->RemoveAllOperations();
+  pipeline->AddMargin("A", -4.0);
+  CHECK_BOOL(pipeline->Execute(segmentation), true);
+  const int shrunkVoxels = CountSegmentVoxels(segmentation, "A");
+  CHECK_BOOL(shrunkVoxels > 0 && shrunkVoxels < sphereVoxels, true);
+  pipeline->RemoveAllOperations();
+  pipeline->AddThreshold("A", 50, 120);
+  CHECK_BOOL(pipeline->Execute(segmentation, sourceImage), true);
+  CHECK_INT(CountSegmentVoxels(segmentation, "A"), sphereVoxels);
+
+  // Logical operations (without overwriting, copy would erase the modifier segment)
+  pipeline->SetOverwriteMode(vtkMRMLSegmentEditorNode::OverwriteNone);
+  pipeline->RemoveAllOperations();
+  pipeline->AddLogicalOperation("B", vtkSlicerSegmentEditingPipeline::LogicalCopy, "A");
+  CHECK_BOOL(pipeline->Execute(segmentation), true);
+  CHECK_INT(CountSegmentVoxels(segmentation, "B"), sphereVoxels);
+  CHECK_INT(CountSegmentVoxels(segmentation, "A"), sphereVoxels);
+
+  pipeline->RemoveAllOperations();
+  pipeline->AddLogicalOperation("B", vtkSlicerSegmentEditingPipeline::LogicalInvert);
+  CHECK_BOOL(pipeline->Execute(segmentation), true);
+  CHECK_INT(CountSegmentVoxels(segmentation, "B"), 40 * 40 * 20 - sphereVoxels);
+
+  pipeline->RemoveAllOperations();
+  pipeline->AddLogicalOperation("B", vtkSlicerSegmentEditingPipeline::LogicalIntersect, "A");
+  CHECK_BOOL(pipeline->Execute(segmentation), true);
+  CHECK_INT(CountSegmentVoxels(segmentation, "B"), 0);
+
+  pipeline->RemoveAllOperations();
+  pipeline->AddLogicalOperation("B", vtkSlicerSegmentEditingPipeline::LogicalFill);
+  pipeline->AddLogicalOperation("B", vtkSlicerSegmentEditingPipeline::LogicalSubtract, "A");
+  CHECK_INT(pipeline->GetNumberOfOperations(), 2);
+  CHECK_BOOL(pipeline->Execute(segmentation), true);
+  CHECK_INT(CountSegmentVoxels(segmentation, "B"), 40 * 40 * 20 - sphereVoxels);
+
+  pipeline->RemoveAllOperations();
+  pipeline->AddLogicalOperation("B", vtkSlicerSegmentEditingPipeline::LogicalUnion, "A");
+  CHECK_BOOL(pipeline->Execute(segmentation), true);
+  CHECK_INT(CountSegmentVoxels(segmentation, "B"), 40 * 40 * 20);
+
+  pipeline->RemoveAllOperations();
+  pipeline->AddLogicalOperation("B", vtkSlicerSegmentEditingPipeline::LogicalClear);
+  CHECK_BOOL(pipeline->Execute(segmentation), true);
+  CHECK_INT(CountSegmentVoxels(segmentation, "B"), 0);
+
+  // Editing is restricted to inside segment A
+  pipeline->SetMaskMode(vtkMRMLSegmentationNode::EditAllowedInsideSingleSegment);
+  pipeline->SetMaskSegmentID("A");
+  pipeline->RemoveAllOperations();
+  pipeline->AddThreshold("B", -1000, 1000);
+  CHECK_BOOL(pipeline->Execute(segmentation, sourceImage), true);
+  CHECK_INT(CountSegmentVoxels(segmentation, "B"), sphereVoxels);
+  CHECK_INT(CountSegmentVoxels(segmentation, "A"), sphereVoxels);
+
+  // Editable intensity range: only the small blob is editable outside all segments
+  pipeline->SetMaskMode(vtkMRMLSegmentationNode::EditAllowedOutsideAllSegments);
+  pipeline->SetSourceVolumeIntensityMask(true);
+  pipeline->SetSourceVolumeIntensityMaskRange(120, 200);
+  pipeline->RemoveAllOperations();
+  pipeline->AddLogicalOperation("B", vtkSlicerSegmentEditingPipeline::LogicalFill);
+  CHECK_BOOL(pipeline->Execute(segmentation, sourceImage), true);
+  CHECK_INT(CountSegmentVoxels(segmentation, "B"), sphereVoxels + 7);
+
+  // Overwriting other segments
+  pipeline->SetMaskMode(vtkMRMLSegmentationNode::EditAllowedEverywhere);
+  pipeline->SetSourceVolumeIntensityMask(false);
+  pipeline->SetOverwriteMode(vtkMRMLSegmentEditorNode::OverwriteAllSegments);
+  pipeline->RemoveAllOperations();
+  pipeline->AddThreshold("B", 50, 120);
+  CHECK_BOOL(pipeline->Execute(segmentation, sourceImage), true);
+  CHECK_INT(CountSegmentVoxels(segmentation, "B"), sphereVoxels);
+  CHECK_INT(CountSegmentVoxels(segmentation, "A"), 0);
+
+  // Invalid inputs
+  pipeline->RemoveAllOperations();
+  pipeline->AddThreshold("missing", 50, 120);
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(pipeline->Execute(segmentation, sourceImage), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestParallelExecution(vtkOrientedImageData* sourceImage)
+{
+  const int sphereVoxels = CountSourceVoxels(sourceImage, 50, 120);
+
+  vtkNew<vtkCollection> segmentations;
+  vtkNew<vtkCollection> sourceImages;
+  const int numberOfSegmentations = 4;
+  for (int index = 0; index < numberOfSegmentations; ++index)
+    {
+    vtkNew<vtkSegmentation> segmentation;
+    CreateSegmentation(segmentation, sourceImage);
+    segmentations->AddItem(segmentation);
+    sourceImages->AddItem(sourceImage);
+    }
+
+  vtkNew<vtkSlicerSegmentEditingPipeline> pipeline;
+  // Segment A overwrites segment B
+  pipeline->AddLogicalOperation("B", vtkSlicerSegmentEditingPipeline::LogicalFill);
+  pipeline->AddThreshold("A", 50, 120);
+  pipeline->AddIslands("A", 0, true);
+  CHECK_BOOL(vtkSlicerSegmentationsModuleLogic::ApplySegmentEditingPipeline(pipeline, segmentations, sourceImages), true);
+  for (int index = 0; index < numberOfSegmentations; ++index)
+    {
+    vtkSegmentation* segmentation = vtkSegmentation::SafeDownCast(segmentations->GetItemAsObject(index));
+    CHECK_INT(CountSegmentVoxels(segmentation, "A"), sphereVoxels);
+    CHECK_INT(CountSegmentVoxels(segmentation, "B"), 40 * 40 * 20 - sphereVoxels);
+    }
+
+  // The same segmentation must not be processed twice
+  segmentations->AddItem(segmentations->GetItemAsObject(0));
+  sourceImages->AddItem(sourceImage);
+  TESTING_OUTPUT_ASSERT_WARNINGS_BEGIN();
+  CHECK_BOOL(vtkSlicerSegmentationsModuleLogic::ApplySegmentEditingPipeline(pipeline, segmentations, sourceImages), false);
+  TESTING_OUTPUT_ASSERT_WARNINGS_END();
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSlicerSegmentEditingPipelineTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkOrientedImageData> sourceImage;
+  CreateSourceImage(sourceImage);
+
+  CHECK_EXIT_SUCCESS(TestOperations(sourceImage));
+  CHECK_EXIT_SUCCESS(TestParallelExecution(sourceImage));
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
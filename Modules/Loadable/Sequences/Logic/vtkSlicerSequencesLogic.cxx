@@ -15,8 +15,6 @@
 
 ==============================================================================*/
 
-//#define ENABLE_PERFORMANCE_PROFILING
-
 // Sequence Logic includes
 #include "vtkSlicerSequencesLogic.h"
 
@@ -37,9 +35,7 @@
 #include "vtkMRMLScalarVolumeNode.h"
 #include "vtkMRMLScene.h"
 #include "vtkMRMLTransformNode.h"
-#ifdef ENABLE_PERFORMANCE_PROFILING
-#include "vtkTimerLog.h"
-#endif
+#include "vtkMRMLVolumeNode.h"
 
 // VTK includes
 #include <vtkAbstractTransform.h>
@@ -48,6 +44,7 @@
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
 #include <vtkTimerLog.h>
 #include <vtksys/SystemTools.hxx>
 
@@ -252,13 +249,19 @@ void vtkSlicerSequencesLogic::UpdateAllProxyNodes()
       }
     if (!browserNode->GetPlaybackActive())
       {
-      this->LastSequenceBrowserUpdateTimeSec.erase(browserNode);
+      if (this->LastSequenceBrowserUpdateTimeSec.erase(browserNode))
+        {
+        // playback stopped, prefetched items are no longer needed
+        browserNode->ClearPrefetchBuffer();
+        }
       continue;
       }
     if ( this->LastSequenceBrowserUpdateTimeSec.find(browserNode) == this->LastSequenceBrowserUpdateTimeSec.end() )
       {
       // we just started to play now, no need to update output nodes yet
       this->LastSequenceBrowserUpdateTimeSec[browserNode] = updateStartTimeSec;
+      browserNode->ResetPlaybackStatistics();
+      browserNode->PrefetchItems();
       continue;
       }
     // play is already in progress
@@ -273,6 +276,7 @@ void vtkSlicerSequencesLogic::UpdateAllProxyNodes()
         {
         selectionIncrement = 1;
         }
+      browserNode->AddDroppedFrames(selectionIncrement - 1);
       browserNode->SelectNextItem(selectionIncrement);
       }
     }
@@ -281,10 +285,7 @@ void vtkSlicerSequencesLogic::UpdateAllProxyNodes()
 //---------------------------------------------------------------------------
 void vtkSlicerSequencesLogic::UpdateProxyNodesFromSequences(vtkMRMLSequenceBrowserNode* browserNode)
 {
-#ifdef ENABLE_PERFORMANCE_PROFILING
-  vtkNew<vtkTimerLog> timer;
-  timer->StartTimer();
-#endif
+  double updateStartTimeSec = vtkTimerLog::GetUniversalTime();
 
   if (this->UpdateProxyNodesFromSequencesInProgress || this->UpdateSequencesFromProxyNodesInProgress)
     {
@@ -320,10 +321,22 @@ void vtkSlicerSequencesLogic::UpdateProxyNodesFromSequences(vtkMRMLSequenceBrows
 
   int selectedItemNumber=browserNode->GetSelectedItemNumber();
   std::string indexValue("0");
-  if (selectedItemNumber >= 0 && selectedItemNumber < browserNode->GetNumberOfItems())
+  bool selectedItemValid = (selectedItemNumber >= 0 && selectedItemNumber < browserNode->GetNumberOfItems());
+  if (selectedItemValid)
     {
     indexValue=browserNode->GetMasterSequenceNode()->GetNthIndexValue(selectedItemNumber);
     }
+  // Item numbers corresponding to the selected item are cached in the browser node,
+  // which avoids searching each synchronized sequence by index value.
+  auto getDataNodeAtSelectedItem = [&](vtkMRMLSequenceNode* sequenceNode, bool exactMatchRequired) -> vtkMRMLNode*
+    {
+    if (!selectedItemValid)
+      {
+      return sequenceNode->GetDataNodeAtValue(indexValue, exactMatchRequired);
+      }
+    int itemNumber = browserNode->GetSynchronizedSequenceItemNumber(sequenceNode, selectedItemNumber, exactMatchRequired);
+    return (itemNumber >= 0 ? sequenceNode->GetNthDataNode(itemNumber) : nullptr);
+    };
 
   std::vector< vtkMRMLSequenceNode* > synchronizedSequenceNodes;
   browserNode->GetSynchronizedSequenceNodes(synchronizedSequenceNodes, true);
@@ -346,17 +359,18 @@ void vtkSlicerSequencesLogic::UpdateProxyNodesFromSequences(vtkMRMLSequenceBrows
       }
 
     vtkMRMLNode* sourceDataNode = nullptr;
+    vtkSmartPointer<vtkImageData> prefetchedImageData;
     if (browserNode->GetSaveChanges(synchronizedSequenceNode))
       {
       // we want to save changes, therefore we have to make sure a data node is available for the current index
       if (synchronizedSequenceNode->GetNumberOfDataNodes() > 0)
         {
-        sourceDataNode = synchronizedSequenceNode->GetDataNodeAtValue(indexValue, true /*exact match*/);
+        sourceDataNode = getDataNodeAtSelectedItem(synchronizedSequenceNode, true /*exact match*/);
         if (sourceDataNode == nullptr)
           {
           // No source node is available for the current exact index.
           // Add a copy of the closest (previous) item into the sequence at the exact index.
-          sourceDataNode = synchronizedSequenceNode->GetDataNodeAtValue(indexValue, false /*closest match*/);
+          sourceDataNode = getDataNodeAtSelectedItem(synchronizedSequenceNode, false /*closest match*/);
           if (sourceDataNode)
             {
             sourceDataNode = synchronizedSequenceNode->SetDataNodeAtValue(sourceDataNode, indexValue);
@@ -377,7 +391,24 @@ void vtkSlicerSequencesLogic::UpdateProxyNodesFromSequences(vtkMRMLSequenceBrows
     else
       {
       // we just want to show a node, therefore we can just use closest data node
-      sourceDataNode = synchronizedSequenceNode->GetDataNodeAtValue(indexValue, false /*closest match*/);
+      if (browserNode->GetPlaybackActive() && browserNode->GetPrefetchEnabled())
+        {
+        // voxels may have been prepared in the background, then content of the data node is not needed
+        int sequenceItemNumber = browserNode->GetSynchronizedSequenceItemNumber(synchronizedSequenceNode, selectedItemNumber);
+        if (sequenceItemNumber >= 0)
+          {
+          prefetchedImageData = browserNode->TakePrefetchedImageData(synchronizedSequenceNode, sequenceItemNumber);
+          }
+        if (prefetchedImageData)
+          {
+          // Data node of a compact item is created but its content is not loaded
+          sourceDataNode = synchronizedSequenceNode->CreateCompactItemDataNode(sequenceItemNumber);
+          }
+        }
+      if (sourceDataNode == nullptr)
+        {
+        sourceDataNode = getDataNodeAtSelectedItem(synchronizedSequenceNode, false /*closest match*/);
+        }
       }
     if (sourceDataNode==nullptr)
       {
@@ -420,7 +451,20 @@ void vtkSlicerSequencesLogic::UpdateProxyNodesFromSequences(vtkMRMLSequenceBrows
     // TODO: if we really want to force non-mutable nodes in the sequence then we have to deep-copy, but that's slow.
     // Make sure that by default/most of the time shallow-copy is used.
     bool shallowCopy = browserNode->GetSaveChanges(synchronizedSequenceNode);
-    targetProxyNode->CopyContent(sourceDataNode, !shallowCopy);
+    if (prefetchedImageData)
+      {
+      // The prefetched image is not shared with the sequence, so the proxy node can use it without copying.
+      // It is set in a temporary node first so that the proxy node image is only replaced once.
+      vtkSmartPointer<vtkMRMLVolumeNode> prefetchedVolumeNode = vtkSmartPointer<vtkMRMLVolumeNode>::Take(
+        vtkMRMLVolumeNode::SafeDownCast(sourceDataNode->CreateNodeInstance()));
+      prefetchedVolumeNode->CopyContent(sourceDataNode, false);
+      prefetchedVolumeNode->SetAndObserveImageData(prefetchedImageData);
+      targetProxyNode->CopyContent(prefetchedVolumeNode, false);
+      }
+    else
+      {
+      targetProxyNode->CopyContent(sourceDataNode, !shallowCopy);
+      }
 
     // Singleton nodes must not be renamed, as they are often expected to exist by a specific name
     if (browserNode->GetOverwriteProxyName(synchronizedSequenceNode) && !targetProxyNode->GetSingletonTag())
@@ -477,10 +521,15 @@ void vtkSlicerSequencesLogic::UpdateProxyNodesFromSequences(vtkMRMLSequenceBrows
 
   this->UpdateProxyNodesFromSequencesInProgress = false;
 
-#ifdef ENABLE_PERFORMANCE_PROFILING
-  timer->StopTimer();
-  vtkInfoMacro("UpdateProxyNodesFromSequences: " << timer->GetElapsedTime() << "sec\n");
-#endif
+  if (browserNode->GetPlaybackActive())
+    {
+    // prepare the items that will be shown next, scheduling is part of the cost of a frame
+    browserNode->PrefetchItems();
+    }
+
+  double latencySec = vtkTimerLog::GetUniversalTime() - updateStartTimeSec;
+  browserNode->AddFrameLatency(latencySec);
+  vtkDebugMacro("UpdateProxyNodesFromSequences: " << latencySec << "sec");
 }
 
 //---------------------------------------------------------------------------
@@ -549,7 +598,7 @@ void vtkSlicerSequencesLogic::UpdateSequencesFromProxyNodes(vtkMRMLSequenceBrows
     if (sequenceNode && browserNode->GetSaveChanges(sequenceNode) && browserNode->GetSelectedItemNumber()>=0)
       {
       std::string indexValue = masterNode->GetNthIndexValue(browserNode->GetSelectedItemNumber());
-      int closestItemNumber = sequenceNode->GetItemNumberFromIndexValue(indexValue, false);
+      int closestItemNumber = browserNode->GetSynchronizedSequenceItemNumber(sequenceNode, browserNode->GetSelectedItemNumber());
       if (closestItemNumber >= 0)
         {
         std::string closestIndexValue = sequenceNode->GetNthIndexValue(closestItemNumber);
@@ -25,6 +25,8 @@
 
 // MRML includes
 #include <vtkMRMLScene.h>
+#include <vtkMRMLSequenceItemLoader.h>
+#include <vtkMRMLSequenceRecordingBuffer.h>
 #include <vtkMRMLVolumeNode.h>
 #include <vtkMRMLHierarchyNode.h>
 
@@ -34,15 +36,25 @@
 #include <vtkCommand.h>
 #include <vtkCollection.h>
 #include <vtkCollectionIterator.h>
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointData.h>
 #include <vtkSmartPointer.h>
 #include <vtksys/RegularExpression.hxx>
 #include <vtkTimerLog.h>
 #include <vtkVariant.h>
+#include <vtkWeakPointer.h>
 
 // STD includes
 #include <sstream>
 #include <algorithm> // for std::find
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
 #if defined(_WIN32) && !defined(__CYGWIN__)
 #  define SNPRINTF _snprintf
 #else
@@ -56,6 +68,9 @@ static const char* PROXY_NODE_REFERENCE_ROLE_BASE = "dataNodeRef";
 
 static const char* PROXY_NODE_COPY_ATTRIBUTE_NAME = "proxyNodeCopy";
 
+// Item number of a synchronized sequence that has not been looked up yet
+static const int ITEM_NUMBER_NOT_RESOLVED = -2;
+
 
 
 // Declare the Synchronization Properties struct
@@ -113,6 +128,221 @@ std::string vtkMRMLSequenceBrowserNode::SynchronizationProperties::ToString()
   return ss.str();
 }
 
+//----------------------------------------------------------------------------
+class vtkMRMLSequenceBrowserNode::vtkInternal
+{
+public:
+  /// Content of one item of a sequence, prepared in a background thread
+  struct PrefetchedFrame
+    {
+    // Set on the main thread before the frame is queued, not modified afterward.
+    // Sequence and data nodes are only used for identifying the item, they are not accessed.
+    // Data node is nullptr for compact items.
+    vtkMRMLSequenceNode* SequenceNode{nullptr};
+    int ItemNumber{-1};
+    vtkMRMLNode* DataNode{nullptr};
+    // Voxels are read by the loader if set, otherwise they are copied from the source image.
+    // The source image is only used for checking if the copy is still valid, it is not accessed
+    // by the background thread.
+    vtkSmartPointer<vtkMRMLSequenceItemLoader> Loader;
+    int ItemId{-1};
+    vtkSmartPointer<vtkImageData> SourceImageData;
+    vtkMTimeType SourceImageDataMTime{0};
+    // Shallow copy of the source image, made on the main thread when the frame is queued.
+    // It shares the voxel array with the source image and is not modified by any thread,
+    // the background thread deep copies it into ImageData.
+    vtkSmartPointer<vtkImageData> SharedImageData;
+    // Filled by the background thread
+    vtkSmartPointer<vtkImageData> ImageData;
+    // Guarded by Mutex
+    bool Done{false};
+    bool Success{false};
+    };
+  typedef std::shared_ptr<PrefetchedFrame> PrefetchedFramePointer;
+
+  /// Frames of all prefetched sequences for an item of the master sequence
+  struct Slot
+    {
+    int ItemNumber{-1};
+    std::vector<PrefetchedFramePointer> Frames;
+    };
+
+  /// Prepare queued frames until the queue is empty. Runs in a background thread.
+  void PrefetchLoop();
+
+  /// Read or copy voxels of the frame and compute the derived data used by the display pipeline.
+  static bool PrepareFrame(PrefetchedFrame& frame);
+
+  /// Remove the frame from the queue if its preparation has not started yet.
+  /// A frame that is being prepared is released when it is completed.
+  void Cancel(const PrefetchedFramePointer& frame);
+
+  /// Make sure that preparation of the frame is completed. Frames that are still in the queue
+  /// are prepared on the calling thread. Returns true if the frame is prepared successfully.
+  bool Complete(const PrefetchedFramePointer& frame);
+
+  /// Cancel all frames of the slot and make it available for another item.
+  void ClearSlot(Slot& slot);
+
+  /// Release completed frames and join threads that are finished. Must be called from the main thread.
+  void ReleaseCompletedFrames();
+
+  /// Buffers that store recorded states of proxy nodes, for each synchronization postfix.
+  /// A buffer is kept as long as recording continues into the same sequence, items that have
+  /// been recorded into the sequence keep a reference to the buffer.
+  std::map< std::string, vtkSmartPointer<vtkMRMLSequenceRecordingBuffer> > RecordingBuffers;
+
+  /// Item numbers of a synchronized sequence that correspond to the items of the master sequence.
+  /// Item numbers are resolved on first use (ITEM_NUMBER_NOT_RESOLVED until then).
+  /// Maps are stored by sequence node ID, so that they can be removed even if the node is no longer in the scene.
+  struct ItemNumberMap
+    {
+    vtkWeakPointer<vtkMRMLSequenceNode> SequenceNode;
+    vtkWeakPointer<vtkMRMLSequenceNode> MasterSequenceNode;
+    vtkMTimeType SequenceNodeMTime{0};
+    vtkMTimeType MasterSequenceNodeMTime{0};
+    std::vector<int> ExactItemNumbers;
+    std::vector<int> ClosestItemNumbers;
+    };
+  std::map< std::string, ItemNumberMap > ItemNumberMaps;
+
+  // Ring buffer, only accessed from the main thread
+  std::vector<Slot> Slots;
+  int NextSlot{0};
+
+  // All members below are guarded by Mutex
+  std::mutex Mutex;
+  std::condition_variable Condition;
+  std::deque<PrefetchedFramePointer> PendingFrames;
+  // Frames are released on the main thread, therefore background threads
+  // never delete VTK objects that the main thread may use.
+  std::vector<PrefetchedFramePointer> CompletedFrames;
+  std::vector<std::thread> Threads;
+  // Threads that exited their prefetch loop and can be joined
+  std::vector<std::thread::id> FinishedThreadIds;
+  int NumberOfActiveThreads{0};
+  int NumberOfRunningFrames{0};
+};
+
+//----------------------------------------------------------------------------
+void vtkMRMLSequenceBrowserNode::vtkInternal::PrefetchLoop()
+{
+  std::unique_lock<std::mutex> lock(this->Mutex);
+  while (!this->PendingFrames.empty())
+    {
+    PrefetchedFramePointer frame = std::move(this->PendingFrames.front());
+    this->PendingFrames.pop_front();
+    this->NumberOfRunningFrames++;
+    lock.unlock();
+
+    bool success = PrepareFrame(*frame);
+
+    lock.lock();
+    frame->Success = success;
+    frame->Done = true;
+    this->CompletedFrames.push_back(std::move(frame));
+    this->NumberOfRunningFrames--;
+    this->Condition.notify_all();
+    }
+  this->NumberOfActiveThreads--;
+  this->FinishedThreadIds.push_back(std::this_thread::get_id());
+  this->Condition.notify_all();
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSequenceBrowserNode::vtkInternal::PrepareFrame(PrefetchedFrame& frame)
+{
+  if (frame.Loader)
+    {
+    if (!frame.Loader->ReadItemData(frame.ItemId, frame.ImageData))
+      {
+      return false;
+      }
+    }
+  else if (frame.SharedImageData)
+    {
+    // the copy is owned by the frame, the proxy node can use it without copying again
+    frame.ImageData->DeepCopy(frame.SharedImageData);
+    }
+  // The scalar range is cached in the image, so that display nodes can get it without iterating through the voxels
+  frame.ImageData->GetScalarRange();
+  vtkDataArray* scalars = frame.ImageData->GetPointData() ? frame.ImageData->GetPointData()->GetScalars() : nullptr;
+  if (scalars && scalars->GetNumberOfComponents() > 1)
+    {
+    for (int component = 0; component < scalars->GetNumberOfComponents(); ++component)
+      {
+      scalars->GetRange(component);
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSequenceBrowserNode::vtkInternal::Cancel(const PrefetchedFramePointer& frame)
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  std::deque<PrefetchedFramePointer>::iterator pendingIt = std::find(this->PendingFrames.begin(), this->PendingFrames.end(), frame);
+  if (pendingIt != this->PendingFrames.end())
+    {
+    this->PendingFrames.erase(pendingIt);
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSequenceBrowserNode::vtkInternal::Complete(const PrefetchedFramePointer& frame)
+{
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    std::deque<PrefetchedFramePointer>::iterator pendingIt = std::find(this->PendingFrames.begin(), this->PendingFrames.end(), frame);
+    if (pendingIt == this->PendingFrames.end())
+      {
+      this->Condition.wait(lock, [&frame] { return frame->Done; });
+      return frame->Success;
+      }
+    this->PendingFrames.erase(pendingIt);
+  }
+  // Not started yet, it is faster to prepare it here than waiting for the background threads
+  return PrepareFrame(*frame);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSequenceBrowserNode::vtkInternal::ClearSlot(Slot& slot)
+{
+  for (const PrefetchedFramePointer& frame : slot.Frames)
+    {
+    this->Cancel(frame);
+    }
+  slot.Frames.clear();
+  slot.ItemNumber = -1;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSequenceBrowserNode::vtkInternal::ReleaseCompletedFrames()
+{
+  std::vector<PrefetchedFramePointer> completedFrames;
+  std::vector<std::thread> finishedThreads;
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    completedFrames.swap(this->CompletedFrames);
+    for (const std::thread::id& threadId : this->FinishedThreadIds)
+      {
+      std::vector<std::thread>::iterator threadIt = std::find_if(this->Threads.begin(), this->Threads.end(),
+        [&threadId](const std::thread& thread) { return thread.get_id() == threadId; });
+      if (threadIt != this->Threads.end())
+        {
+        finishedThreads.push_back(std::move(*threadIt));
+        this->Threads.erase(threadIt);
+        }
+      }
+    this->FinishedThreadIds.clear();
+  }
+  // the threads have left the prefetch loop, joining returns immediately
+  for (std::thread& thread : finishedThreads)
+    {
+    thread.join();
+    }
+}
+
 //------------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLSequenceBrowserNode);
 
@@ -123,10 +353,16 @@ vtkMRMLSequenceBrowserNode::vtkMRMLSequenceBrowserNode()
   this->SetHideFromEditors(false);
   this->RecordingTimeOffsetSec = vtkTimerLog::GetUniversalTime();
   this->LastSaveProxyNodesStateTimeSec = vtkTimerLog::GetUniversalTime();
+  this->Internal = new vtkInternal;
 }
 
 //----------------------------------------------------------------------------
-vtkMRMLSequenceBrowserNode::~vtkMRMLSequenceBrowserNode() = default;
+vtkMRMLSequenceBrowserNode::~vtkMRMLSequenceBrowserNode()
+{
+  this->ClearPrefetchBuffer();
+  delete this->Internal;
+  this->Internal = nullptr;
+}
 
 //----------------------------------------------------------------------------
 void vtkMRMLSequenceBrowserNode::WriteXML(ostream& of, int nIndent)
@@ -142,6 +378,9 @@ void vtkMRMLSequenceBrowserNode::WriteXML(ostream& of, int nIndent)
   of << indent << " selectedItemNumber=\"" << this->SelectedItemNumber << "\"";
   of << indent << " recordingActive=\"" << (this->RecordingActive ? "true" : "false") << "\"";
   of << indent << " recordOnMasterModifiedOnly=\"" << (this->RecordMasterOnly ? "true" : "false") << "\"";
+  of << indent << " compactRecording=\"" << (this->CompactRecording ? "true" : "false") << "\"";
+  of << indent << " prefetchEnabled=\"" << (this->PrefetchEnabled ? "true" : "false") << "\"";
+  of << indent << " prefetchBufferSize=\"" << this->PrefetchBufferSize << "\"";
 
   std::string recordingSamplingModeString = this->GetRecordingSamplingModeAsString();
   if (!recordingSamplingModeString.empty())
@@ -264,6 +503,22 @@ void vtkMRMLSequenceBrowserNode::ReadXMLAttributes(const char** atts)
         this->SetRecordMasterOnly(0);
         }
       }
+    else if (!strcmp(attName, "compactRecording"))
+      {
+      this->SetCompactRecording(!strcmp(attValue, "true"));
+      }
+    else if (!strcmp(attName, "prefetchEnabled"))
+      {
+      this->SetPrefetchEnabled(!strcmp(attValue, "true"));
+      }
+    else if (!strcmp(attName, "prefetchBufferSize"))
+      {
+      std::stringstream ss;
+      ss << attValue;
+      int prefetchBufferSize = 4;
+      ss >> prefetchBufferSize;
+      this->SetPrefetchBufferSize(prefetchBufferSize);
+      }
     else if (!strcmp(attName, "recordingSamplingMode"))
       {
       int recordingSamplingMode = this->GetRecordingSamplingModeFromString(attValue);
@@ -363,6 +618,9 @@ void vtkMRMLSequenceBrowserNode::Copy(vtkMRMLNode *anode)
   this->SetPlaybackItemSkippingEnabled(node->GetPlaybackItemSkippingEnabled());
   this->SetPlaybackLooped(node->GetPlaybackLooped());
   this->SetRecordMasterOnly(node->GetRecordMasterOnly());
+  this->SetCompactRecording(node->GetCompactRecording());
+  this->SetPrefetchEnabled(node->GetPrefetchEnabled());
+  this->SetPrefetchBufferSize(node->GetPrefetchBufferSize());
   this->SetRecordingSamplingMode(node->GetRecordingSamplingMode());
   this->SetIndexDisplayMode(node->GetIndexDisplayMode());
   this->SetIndexDisplayFormat(node->GetIndexDisplayFormat());
@@ -386,9 +644,19 @@ void vtkMRMLSequenceBrowserNode::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << " Selected item number: " << this->SelectedItemNumber << '\n';
   os << indent << " Recording active: " << (this->RecordingActive ? "true" : "false") << '\n';
   os << indent << " Recording on master modified only: " << (this->RecordMasterOnly ? "true" : "false") << '\n';
+  os << indent << " Compact recording: " << (this->CompactRecording ? "true" : "false") << '\n';
   os << indent << " Recording sampling mode: " << this->GetRecordingSamplingModeAsString() << "\n";
   os << indent << " Index display mode: " << this->GetIndexDisplayModeAsString() << "\n";
   os << indent << " Index display format: " << this->GetIndexDisplayFormat() << "\n";
+  os << indent << " Prefetch enabled: " << (this->PrefetchEnabled ? "true" : "false") << '\n';
+  os << indent << " Prefetch buffer size: " << this->PrefetchBufferSize << '\n';
+  os << indent << " Number of dropped frames: " << this->NumberOfDroppedFrames << '\n';
+  os << indent << " Number of displayed frames: " << this->NumberOfDisplayedFrames << '\n';
+  os << indent << " Last frame latency (sec): " << this->LastFrameLatencySec << '\n';
+  os << indent << " Average frame latency (sec): " << this->GetAverageFrameLatencySec() << '\n';
+  os << indent << " Maximum frame latency (sec): " << this->MaximumFrameLatencySec << '\n';
+  os << indent << " Number of prefetch hits: " << this->NumberOfPrefetchHits << '\n';
+  os << indent << " Number of prefetch misses: " << this->NumberOfPrefetchMisses << '\n';
 
   os << indent << " Sequence nodes:\n";
   if (this->SynchronizationPostfixes.empty())
@@ -888,6 +1156,8 @@ void vtkMRMLSequenceBrowserNode::RemoveSynchronizedSequenceNode(const char* node
       std::string rolePostfix=(*rolePostfixIt);
       bool oldModify=this->StartModify();
       this->SynchronizationPostfixes.erase(rolePostfixIt);
+      this->Internal->RecordingBuffers.erase(rolePostfix);
+      this->Internal->ItemNumberMaps.erase(nodeId);
       this->RemoveNodeReferenceIDs(sequenceNodeRef.c_str());
       this->RemoveProxyNode(rolePostfix);
       this->EndModify(oldModify);
@@ -897,6 +1167,49 @@ void vtkMRMLSequenceBrowserNode::RemoveSynchronizedSequenceNode(const char* node
   vtkWarningMacro("vtkMRMLSequenceBrowserNode::RemoveSynchronizedSequenceNode did nothing, the specified node was not synchronized");
 }
 
+//----------------------------------------------------------------------------
+int vtkMRMLSequenceBrowserNode::GetSynchronizedSequenceItemNumber(vtkMRMLSequenceNode* sequenceNode, int masterItemNumber,
+  bool exactMatchRequired /* =false */)
+{
+  vtkMRMLSequenceNode* masterSequenceNode = this->GetMasterSequenceNode();
+  if (!sequenceNode || !masterSequenceNode
+    || masterItemNumber < 0 || masterItemNumber >= masterSequenceNode->GetNumberOfDataNodes())
+    {
+    return -1;
+    }
+  if (sequenceNode == masterSequenceNode)
+    {
+    return masterItemNumber;
+    }
+
+  const char* sequenceNodeId = sequenceNode->GetID();
+  vtkInternal::ItemNumberMap& itemNumberMap = this->Internal->ItemNumberMaps[sequenceNodeId ? sequenceNodeId : ""];
+  if (itemNumberMap.SequenceNode.GetPointer() != sequenceNode
+    || itemNumberMap.MasterSequenceNode.GetPointer() != masterSequenceNode
+    || itemNumberMap.SequenceNodeMTime != sequenceNode->GetMTime()
+    || itemNumberMap.MasterSequenceNodeMTime != masterSequenceNode->GetMTime())
+    {
+    // Sequence index may have changed, discard all resolved item numbers
+    itemNumberMap.SequenceNode = sequenceNode;
+    itemNumberMap.MasterSequenceNode = masterSequenceNode;
+    itemNumberMap.SequenceNodeMTime = sequenceNode->GetMTime();
+    itemNumberMap.MasterSequenceNodeMTime = masterSequenceNode->GetMTime();
+    itemNumberMap.ExactItemNumbers.assign(masterSequenceNode->GetNumberOfDataNodes(), ITEM_NUMBER_NOT_RESOLVED);
+    itemNumberMap.ClosestItemNumbers.assign(masterSequenceNode->GetNumberOfDataNodes(), ITEM_NUMBER_NOT_RESOLVED);
+    }
+
+  if (itemNumberMap.ExactItemNumbers[masterItemNumber] == ITEM_NUMBER_NOT_RESOLVED)
+    {
+    std::string indexValue = masterSequenceNode->GetNthIndexValue(masterItemNumber);
+    int exactItemNumber = sequenceNode->GetItemNumberFromIndexValue(indexValue, true);
+    itemNumberMap.ExactItemNumbers[masterItemNumber] = exactItemNumber;
+    itemNumberMap.ClosestItemNumbers[masterItemNumber] = (exactItemNumber >= 0 ? exactItemNumber
+      : sequenceNode->GetItemNumberFromIndexValue(indexValue, false));
+    }
+  return (exactMatchRequired ? itemNumberMap.ExactItemNumbers[masterItemNumber]
+    : itemNumberMap.ClosestItemNumbers[masterItemNumber]);
+}
+
 //----------------------------------------------------------------------------
 int vtkMRMLSequenceBrowserNode::GetNumberOfSynchronizedSequenceNodes(bool includeMasterNode/*=false*/)
 {
@@ -1001,6 +1314,10 @@ int vtkMRMLSequenceBrowserNode::SelectNextItem(int selectionIncrement/*=1*/)
     return -1;
     }
   int selectedItemNumber=this->GetSelectedItemNumber();
+  if (selectionIncrement != 0)
+    {
+    this->LastSelectionIncrement = selectionIncrement;
+    }
   int browserNodeModify=this->StartModify(); // invoke modification event once all the modifications has been completed
   if (selectedItemNumber<0)
     {
@@ -1052,6 +1369,357 @@ int vtkMRMLSequenceBrowserNode::GetNumberOfItems()
   return sequenceNode->GetNumberOfDataNodes();
 }
 
+//---------------------------------------------------------------------------
+void vtkMRMLSequenceBrowserNode::SetPrefetchEnabled(bool enabled)
+{
+  if (this->PrefetchEnabled == enabled)
+    {
+    return;
+    }
+  this->PrefetchEnabled = enabled;
+  if (!enabled)
+    {
+    this->ClearPrefetchBuffer();
+    }
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLSequenceBrowserNode::SetPrefetchBufferSize(int bufferSize)
+{
+  bufferSize = std::max(1, bufferSize);
+  if (this->PrefetchBufferSize == bufferSize)
+    {
+    return;
+    }
+  this->ClearPrefetchBuffer();
+  this->PrefetchBufferSize = bufferSize;
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLSequenceBrowserNode::PrefetchItems()
+{
+  this->Internal->ReleaseCompletedFrames();
+  vtkMRMLSequenceNode* masterSequenceNode = this->GetMasterSequenceNode();
+  int numberOfItems = this->GetNumberOfItems();
+  if (!this->PrefetchEnabled || !masterSequenceNode || numberOfItems < 2
+    || this->SelectedItemNumber < 0 || this->SelectedItemNumber >= numberOfItems)
+    {
+    return;
+    }
+
+  // Items that are expected to be selected next
+  std::vector<int> upcomingItemNumbers;
+  int itemNumber = this->SelectedItemNumber;
+  for (int i = 0; i < this->PrefetchBufferSize; ++i)
+    {
+    itemNumber += this->LastSelectionIncrement;
+    if (itemNumber < 0 || itemNumber >= numberOfItems)
+      {
+      if (!this->PlaybackLooped)
+        {
+        break;
+        }
+      itemNumber = ((itemNumber % numberOfItems) + numberOfItems) % numberOfItems;
+      }
+    if (itemNumber == this->SelectedItemNumber
+      || std::find(upcomingItemNumbers.begin(), upcomingItemNumbers.end(), itemNumber) != upcomingItemNumbers.end())
+      {
+      break;
+      }
+    upcomingItemNumbers.push_back(itemNumber);
+    }
+
+  std::vector<vtkInternal::Slot>& slots = this->Internal->Slots;
+  if (static_cast<int>(slots.size()) != this->PrefetchBufferSize)
+    {
+    this->ClearPrefetchBuffer();
+    slots.resize(this->PrefetchBufferSize);
+    }
+  // Items that are not expected to be selected anymore are released
+  for (vtkInternal::Slot& slot : slots)
+    {
+    if (std::find(upcomingItemNumbers.begin(), upcomingItemNumbers.end(), slot.ItemNumber) == upcomingItemNumbers.end())
+      {
+      this->Internal->ClearSlot(slot);
+      }
+    }
+
+  std::vector<vtkMRMLSequenceNode*> prefetchedSequenceNodes;
+  std::vector<vtkMRMLSequenceNode*> synchronizedSequenceNodes;
+  this->GetSynchronizedSequenceNodes(synchronizedSequenceNodes, true);
+  for (vtkMRMLSequenceNode* sequenceNode : synchronizedSequenceNodes)
+    {
+    // Proxy nodes of sequences that save changes share content with the sequence, nothing to prepare
+    if (sequenceNode && this->GetPlayback(sequenceNode) && !this->GetSaveChanges(sequenceNode))
+      {
+      prefetchedSequenceNodes.push_back(sequenceNode);
+      }
+    }
+  if (prefetchedSequenceNodes.empty())
+    {
+    return;
+    }
+
+  std::vector<vtkInternal::PrefetchedFramePointer> queuedFrames;
+  for (int upcomingItemNumber : upcomingItemNumbers)
+    {
+    bool alreadyPrefetched = false;
+    for (const vtkInternal::Slot& slot : slots)
+      {
+      if (slot.ItemNumber == upcomingItemNumber)
+        {
+        alreadyPrefetched = true;
+        break;
+        }
+      }
+    if (alreadyPrefetched)
+      {
+      continue;
+      }
+
+    // Use the next free slot of the ring buffer
+    int slotIndex = -1;
+    for (int i = 0; i < this->PrefetchBufferSize; ++i)
+      {
+      int candidateSlotIndex = (this->Internal->NextSlot + i) % this->PrefetchBufferSize;
+      if (slots[candidateSlotIndex].ItemNumber < 0)
+        {
+        slotIndex = candidateSlotIndex;
+        break;
+        }
+      }
+    if (slotIndex < 0)
+      {
+      break;
+      }
+    this->Internal->NextSlot = (slotIndex + 1) % this->PrefetchBufferSize;
+    vtkInternal::Slot& slot = slots[slotIndex];
+    slot.ItemNumber = upcomingItemNumber;
+
+    for (vtkMRMLSequenceNode* sequenceNode : prefetchedSequenceNodes)
+      {
+      int sequenceItemNumber = this->GetSynchronizedSequenceItemNumber(sequenceNode, upcomingItemNumber);
+      if (sequenceItemNumber < 0)
+        {
+        continue;
+        }
+      vtkInternal::PrefetchedFramePointer frame = std::make_shared<vtkInternal::PrefetchedFrame>();
+      frame->SequenceNode = sequenceNode;
+      frame->ItemNumber = sequenceItemNumber;
+      // Only volumes are prefetched. Data nodes of compact items are not created here,
+      // voxels are read by the loader and the data node is created when the item is displayed.
+      vtkMRMLSequenceItemLoader* compactItemLoader = sequenceNode->GetCompactItemLoader(sequenceItemNumber);
+      if (compactItemLoader)
+        {
+        if (!vtkMRMLVolumeNode::SafeDownCast(compactItemLoader->GetItemDataNodeTemplate()))
+          {
+          continue;
+          }
+        frame->Loader = compactItemLoader;
+        frame->ItemId = sequenceNode->GetCompactItemId(sequenceItemNumber);
+        frame->ImageData = vtkSmartPointer<vtkImageData>::New();
+        slot.Frames.push_back(frame);
+        queuedFrames.push_back(frame);
+        continue;
+        }
+      vtkMRMLVolumeNode* dataNode = vtkMRMLVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(sequenceItemNumber, false));
+      if (!dataNode)
+        {
+        continue;
+        }
+      frame->DataNode = dataNode;
+      vtkMRMLSequenceItemLoader* loader = sequenceNode->GetDataNodeLoader(dataNode);
+      if (loader && !sequenceNode->IsDataNodeLoaded(dataNode))
+        {
+        frame->Loader = loader;
+        frame->ItemId = sequenceNode->GetDataNodeItemId(dataNode);
+        frame->ImageData = vtkSmartPointer<vtkImageData>::New();
+        }
+      else if (dataNode->GetImageData())
+        {
+        frame->SourceImageData = dataNode->GetImageData();
+        frame->SourceImageDataMTime = dataNode->GetImageData()->GetMTime();
+        // The source image object may be modified on the main thread at any time, therefore the
+        // background thread gets its own image object. Voxels are not copied here but in the
+        // background thread, modification of the source image is detected by its MTime.
+        frame->SharedImageData = vtkSmartPointer<vtkImageData>::Take(dataNode->GetImageData()->NewInstance());
+        frame->SharedImageData->ShallowCopy(dataNode->GetImageData());
+        frame->ImageData = vtkSmartPointer<vtkImageData>::Take(dataNode->GetImageData()->NewInstance());
+        }
+      else
+        {
+        continue;
+        }
+      slot.Frames.push_back(frame);
+      queuedFrames.push_back(frame);
+      }
+    if (slot.Frames.empty())
+      {
+      slot.ItemNumber = -1;
+      }
+    }
+
+  if (queuedFrames.empty())
+    {
+    return;
+    }
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  this->Internal->PendingFrames.insert(this->Internal->PendingFrames.end(), queuedFrames.begin(), queuedFrames.end());
+  int maximumNumberOfThreads = std::max(1, std::min(this->PrefetchBufferSize, static_cast<int>(std::thread::hardware_concurrency())));
+  while (this->Internal->NumberOfActiveThreads < maximumNumberOfThreads
+    && this->Internal->NumberOfActiveThreads < static_cast<int>(this->Internal->PendingFrames.size()))
+    {
+    this->Internal->NumberOfActiveThreads++;
+    this->Internal->Threads.emplace_back(&vtkInternal::PrefetchLoop, this->Internal);
+    }
+}
+
+//---------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> vtkMRMLSequenceBrowserNode::TakePrefetchedImageData(vtkMRMLSequenceNode* sequenceNode, int itemNumber)
+{
+  vtkInternal::PrefetchedFramePointer frame;
+  for (vtkInternal::Slot& slot : this->Internal->Slots)
+    {
+    for (std::vector<vtkInternal::PrefetchedFramePointer>::iterator frameIt = slot.Frames.begin(); frameIt != slot.Frames.end(); ++frameIt)
+      {
+      if ((*frameIt)->SequenceNode == sequenceNode && (*frameIt)->ItemNumber == itemNumber)
+        {
+        frame = *frameIt;
+        slot.Frames.erase(frameIt);
+        if (slot.Frames.empty())
+          {
+          slot.ItemNumber = -1;
+          }
+        break;
+        }
+      }
+    if (frame)
+      {
+      break;
+      }
+    }
+  if (!frame || !sequenceNode || !this->Internal->Complete(frame))
+    {
+    this->NumberOfPrefetchMisses++;
+    return nullptr;
+    }
+
+  // Make sure the item has not changed since the frame was scheduled for preparation
+  vtkMRMLVolumeNode* dataNode = nullptr;
+  if (itemNumber < sequenceNode->GetNumberOfDataNodes())
+    {
+    dataNode = vtkMRMLVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(itemNumber, false));
+    }
+  bool valid = false;
+  if (frame->Loader)
+    {
+    // The item is still read by the same loader: either it is still a compact item
+    // or its data node has been created since then but its content has not been loaded.
+    if (sequenceNode->GetCompactItemLoader(itemNumber))
+      {
+      valid = (sequenceNode->GetCompactItemLoader(itemNumber) == frame->Loader.GetPointer()
+        && sequenceNode->GetCompactItemId(itemNumber) == frame->ItemId);
+      }
+    else if (dataNode)
+      {
+      valid = (sequenceNode->GetDataNodeLoader(dataNode) == frame->Loader.GetPointer()
+        && sequenceNode->GetDataNodeItemId(dataNode) == frame->ItemId
+        && !sequenceNode->IsDataNodeLoaded(dataNode));
+      }
+    }
+  else if (dataNode != nullptr && dataNode == frame->DataNode)
+    {
+    valid = (dataNode->GetImageData() == frame->SourceImageData.GetPointer()
+      && frame->SourceImageData->GetMTime() == frame->SourceImageDataMTime);
+    }
+  if (!valid)
+    {
+    this->NumberOfPrefetchMisses++;
+    return nullptr;
+    }
+  this->NumberOfPrefetchHits++;
+  return frame->ImageData;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLSequenceBrowserNode::ClearPrefetchBuffer()
+{
+  for (vtkInternal::Slot& slot : this->Internal->Slots)
+    {
+    this->Internal->ClearSlot(slot);
+    }
+  this->Internal->NextSlot = 0;
+  {
+    std::unique_lock<std::mutex> lock(this->Internal->Mutex);
+    this->Internal->Condition.wait(lock, [this] { return this->Internal->NumberOfActiveThreads == 0; });
+  }
+  this->Internal->ReleaseCompletedFrames();
+}
+
+//---------------------------------------------------------------------------
+int vtkMRMLSequenceBrowserNode::GetNumberOfPrefetchedItems()
+{
+  int numberOfPrefetchedItems = 0;
+  for (const vtkInternal::Slot& slot : this->Internal->Slots)
+    {
+    if (!slot.Frames.empty())
+      {
+      numberOfPrefetchedItems++;
+      }
+    }
+  return numberOfPrefetchedItems;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLSequenceBrowserNode::WaitForPrefetchedItems()
+{
+  {
+    std::unique_lock<std::mutex> lock(this->Internal->Mutex);
+    this->Internal->Condition.wait(lock, [this]
+      { return this->Internal->PendingFrames.empty() && this->Internal->NumberOfRunningFrames == 0; });
+  }
+  this->Internal->ReleaseCompletedFrames();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLSequenceBrowserNode::AddDroppedFrames(int numberOfFrames)
+{
+  this->NumberOfDroppedFrames += numberOfFrames;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLSequenceBrowserNode::AddFrameLatency(double latencySec)
+{
+  this->NumberOfDisplayedFrames++;
+  this->LastFrameLatencySec = latencySec;
+  this->TotalFrameLatencySec += latencySec;
+  this->MaximumFrameLatencySec = std::max(this->MaximumFrameLatencySec, latencySec);
+}
+
+//---------------------------------------------------------------------------
+double vtkMRMLSequenceBrowserNode::GetAverageFrameLatencySec()
+{
+  if (this->NumberOfDisplayedFrames == 0)
+    {
+    return 0.0;
+    }
+  return this->TotalFrameLatencySec / this->NumberOfDisplayedFrames;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLSequenceBrowserNode::ResetPlaybackStatistics()
+{
+  this->NumberOfDroppedFrames = 0;
+  this->NumberOfDisplayedFrames = 0;
+  this->NumberOfPrefetchHits = 0;
+  this->NumberOfPrefetchMisses = 0;
+  this->LastFrameLatencySec = 0.0;
+  this->MaximumFrameLatencySec = 0.0;
+  this->TotalFrameLatencySec = 0.0;
+}
+
 
 //---------------------------------------------------------------------------
 void vtkMRMLSequenceBrowserNode::ProcessMRMLEvents( vtkObject *caller, unsigned long event, void *callData )
@@ -1115,7 +1783,11 @@ void vtkMRMLSequenceBrowserNode::SaveProxyNodesState()
     vtkMRMLSequenceNode* currSequenceNode = (*it);
     if (this->GetRecording(currSequenceNode))
       {
-      currSequenceNode->SetDataNodeAtValue(this->GetProxyNode(currSequenceNode), currTime.str().c_str());
+      vtkMRMLNode* proxyNode = this->GetProxyNode(currSequenceNode);
+      if (!this->CompactRecording || !this->RecordCompactItem(currSequenceNode, proxyNode, currTime.str()))
+        {
+        currSequenceNode->SetDataNodeAtValue(proxyNode, currTime.str().c_str());
+        }
       snapshotAdded = true;
       }
     }
@@ -1127,6 +1799,31 @@ void vtkMRMLSequenceBrowserNode::SaveProxyNodesState()
   this->EndModify(wasModified);
 }
 
+//---------------------------------------------------------------------------
+bool vtkMRMLSequenceBrowserNode::RecordCompactItem(vtkMRMLSequenceNode* sequenceNode, vtkMRMLNode* proxyNode,
+  const std::string& indexValue)
+{
+  if (!vtkMRMLSequenceRecordingBuffer::CanRecordNode(proxyNode))
+    {
+    return false;
+    }
+  vtkSmartPointer<vtkMRMLSequenceRecordingBuffer>& recordingBuffer =
+    this->Internal->RecordingBuffers[this->GetSynchronizationPostfixFromSequence(sequenceNode)];
+  int itemId = (recordingBuffer ? recordingBuffer->AppendSample(proxyNode) : -1);
+  if (itemId < 0)
+    {
+    // Proxy node content is not compatible with the samples in the current buffer
+    // (e.g., image size changed), continue recording into a new buffer
+    recordingBuffer = vtkSmartPointer<vtkMRMLSequenceRecordingBuffer>::New();
+    itemId = recordingBuffer->AppendSample(proxyNode);
+    if (itemId < 0)
+      {
+      return false;
+      }
+    }
+  return sequenceNode->SetCompactItemAtValue(indexValue, recordingBuffer, itemId);
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLSequenceBrowserNode::OnNodeReferenceAdded(vtkMRMLNodeReference* nodeReference)
 {
@@ -28,12 +28,14 @@
 #include <vtkMRML.h>
 #include <vtkMRMLNode.h>
 #include <vtkNew.h>
+#include <vtkSmartPointer.h>
 
 // STD includes
 #include <set>
 #include <map>
 
 class vtkCollection;
+class vtkImageData;
 class vtkMRMLSequenceNode;
 class vtkIntArray;
 
@@ -119,6 +121,13 @@ public:
   bool IsSynchronizedSequenceNodeID(const char* sequenceNodeId, bool includeMasterNode = false);
   bool IsSynchronizedSequenceNode(vtkMRMLSequenceNode* sequenceNode, bool includeMasterNode = false);
 
+  /// Returns the item number of a synchronized sequence that corresponds to an item of the master sequence.
+  /// The item is found by the index value of the master sequence item, as in vtkMRMLSequenceNode::GetItemNumberFromIndexValue.
+  /// Results are cached, therefore repeated lookups (for example, when the selected item changes during scrubbing or playback)
+  /// do not require searching the sequence. The cache of a sequence is discarded when the sequence or the master sequence is modified.
+  /// Returns -1 if the master item number is out of range or no matching item is found.
+  int GetSynchronizedSequenceItemNumber(vtkMRMLSequenceNode* sequenceNode, int masterItemNumber, bool exactMatchRequired = false);
+
   /// Get/Set automatic playback (automatic continuous changing of selected sequence nodes)
   vtkGetMacro(PlaybackActive, bool);
   vtkSetMacro(PlaybackActive, bool);
@@ -152,6 +161,15 @@ public:
   vtkSetMacro(RecordMasterOnly, bool);
   vtkBooleanMacro(RecordMasterOnly, bool);
 
+  /// Get/set whether recorded states are stored in compact form.
+  /// If enabled then states of linear transform and volume proxy nodes are stored in
+  /// recording buffers (see vtkMRMLSequenceRecordingBuffer) and data nodes of the recorded
+  /// items are only created when they are accessed (browsing, saving, etc.).
+  /// States of other proxy nodes are copied into new data nodes. Disabled by default.
+  vtkGetMacro(CompactRecording, bool);
+  vtkSetMacro(CompactRecording, bool);
+  vtkBooleanMacro(CompactRecording, bool);
+
   /// Set the recording sampling mode
   vtkSetMacro(RecordingSamplingMode, int);
   void SetRecordingSamplingModeFromString(const char *recordingSamplingModeString);
@@ -182,6 +200,10 @@ public:
   /// Selects the next sequence item for display, returns current selected item number
   int SelectNextItem(int selectionIncrement=1);
 
+  /// Item number increment of the last SelectNextItem call.
+  /// Its sign indicates the playback direction, which determines what items are prefetched.
+  vtkGetMacro(LastSelectionIncrement, int);
+
   /// Selects first sequence item for display, returns current selected item number
   int SelectFirstItem();
 
@@ -292,6 +314,77 @@ public:
   /// Save state of all proxy nodes that recording is enabled for
   virtual void SaveProxyNodesState();
 
+  /// Store state of the proxy node in the recording buffer of the sequence and add it
+  /// to the sequence as a compact item. Returns false if the proxy node cannot be stored in a recording buffer.
+  bool RecordCompactItem(vtkMRMLSequenceNode* sequenceNode, vtkMRMLNode* proxyNode, const std::string& indexValue);
+
+  /// \name Prefetching
+  /// During playback, content of the volume items that follow the selected item in the
+  /// playback direction is prepared in background threads: voxels of deferred data nodes
+  /// are read by their item loader and the scalar range that the display pipeline needs
+  /// is computed. Voxels of other data nodes are copied in the background threads from a
+  /// shallow copy of the image that is made when the item is scheduled; the data node may be
+  /// modified at any time, which is detected when the item is taken. Prepared items are kept in
+  /// a ring buffer of PrefetchBufferSize items, therefore proxy nodes can be updated
+  /// without reading voxels when the item is selected.
+  /// Only sequences that have playback enabled and save changes disabled are prefetched.
+  ///@{
+
+  /// Enable prefetching. Enabled by default.
+  vtkGetMacro(PrefetchEnabled, bool);
+  void SetPrefetchEnabled(bool enabled);
+  vtkBooleanMacro(PrefetchEnabled, bool);
+
+  /// Maximum number of items kept in the prefetch buffer. Default is 4.
+  vtkGetMacro(PrefetchBufferSize, int);
+  void SetPrefetchBufferSize(int bufferSize);
+
+  /// Schedule preparation of the items that are expected to be selected next.
+  /// Items that are already in the buffer are kept, the others are replaced.
+  void PrefetchItems();
+
+  /// Return the prepared image of an item and remove the item from the buffer.
+  /// The returned image is not shared with the sequence node.
+  /// If the item is being prepared then the method waits for its completion.
+  /// Returns nullptr if the item is not in the buffer or the data node has changed
+  /// since preparation was scheduled.
+  vtkSmartPointer<vtkImageData> TakePrefetchedImageData(vtkMRMLSequenceNode* sequenceNode, int itemNumber);
+
+  /// Remove all items from the prefetch buffer.
+  void ClearPrefetchBuffer();
+
+  /// Return the number of items in the prefetch buffer, including items being prepared.
+  int GetNumberOfPrefetchedItems();
+
+  /// Wait until all scheduled items are prepared.
+  void WaitForPrefetchedItems();
+  ///@}
+
+  /// \name Playback statistics
+  /// Updated by the sequences logic when proxy nodes are updated.
+  /// Changes of these values do not invoke modified event.
+  ///@{
+
+  /// Number of items that were skipped to keep up with the playback rate.
+  vtkGetMacro(NumberOfDroppedFrames, int);
+  void AddDroppedFrames(int numberOfFrames);
+
+  /// Record the time it took to update the proxy nodes for the selected item,
+  /// including scheduling the preparation of the next items (see PrefetchItems()).
+  void AddFrameLatency(double latencySec);
+  /// Number of recorded frame latencies.
+  vtkGetMacro(NumberOfDisplayedFrames, int);
+  vtkGetMacro(LastFrameLatencySec, double);
+  vtkGetMacro(MaximumFrameLatencySec, double);
+  double GetAverageFrameLatencySec();
+
+  /// Number of TakePrefetchedImageData calls that found/did not find a prepared item.
+  vtkGetMacro(NumberOfPrefetchHits, int);
+  vtkGetMacro(NumberOfPrefetchMisses, int);
+
+  void ResetPlaybackStatistics();
+  ///@}
+
   /// Returns the formatted index value, formatted using the sprintf string provided by IndexDisplayFormat
   /// \sa SetIndexDisplayFormat() GetIndexDisplayFormat()
   std::string GetFormattedIndexValue(int index);
@@ -333,6 +426,7 @@ protected:
   double RecordingTimeOffsetSec; // difference between universal time and index value
   double LastSaveProxyNodesStateTimeSec;
   bool RecordMasterOnly{false};
+  bool CompactRecording{false};
   int RecordingSamplingMode{vtkMRMLSequenceBrowserNode::SamplingLimitedToPlaybackFrameRate};
   int IndexDisplayMode{vtkMRMLSequenceBrowserNode::IndexDisplayAsIndexValue};
   std::string IndexDisplayFormat;
@@ -344,11 +438,27 @@ protected:
   // Counter that is used for generating the unique (only for this class) proxy node postfix strings
   int LastPostfixIndex{0};
 
+  int LastSelectionIncrement{1};
+
+  bool PrefetchEnabled{true};
+  int PrefetchBufferSize{4};
+
+  int NumberOfDroppedFrames{0};
+  int NumberOfDisplayedFrames{0};
+  int NumberOfPrefetchHits{0};
+  int NumberOfPrefetchMisses{0};
+  double LastFrameLatencySec{0.0};
+  double MaximumFrameLatencySec{0.0};
+  double TotalFrameLatencySec{0.0};
+
 private:
   struct SynchronizationProperties;
   std::map< std::string, SynchronizationProperties* > SynchronizationPropertiesMap;
   SynchronizationProperties* GetSynchronizationPropertiesForSequence(vtkMRMLSequenceNode* sequenceNode);
   SynchronizationProperties* GetSynchronizationPropertiesForPostfix(const std::string& rolePostfix);
+
+  class vtkInternal;
+  vtkInternal* Internal;
 };
 
 #endif
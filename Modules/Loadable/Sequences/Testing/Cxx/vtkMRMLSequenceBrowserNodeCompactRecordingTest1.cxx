@@ -0,0 +1,197 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLLinearTransformNode.h"
+#include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLSequenceBrowserNode.h"
+#include "vtkMRMLSequenceNode.h"
+#include "vtkMRMLSequenceRecordingBuffer.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+// STD includes
+#include <sstream>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+vtkMRMLSequenceBrowserNode* AddRecordingBrowser(vtkMRMLScene* scene, vtkMRMLNode* proxyNode, bool compactRecording)
+{
+  vtkMRMLSequenceNode* sequenceNode = vtkMRMLSequenceNode::SafeDownCast(scene->AddNewNodeByClass("vtkMRMLSequenceNode", "Sequence"));
+  vtkMRMLSequenceBrowserNode* browserNode = vtkMRMLSequenceBrowserNode::SafeDownCast(
+    scene->AddNewNodeByClass("vtkMRMLSequenceBrowserNode", "Browser"));
+  browserNode->SetAndObserveMasterSequenceNodeID(sequenceNode->GetID());
+  browserNode->AddProxyNode(proxyNode, sequenceNode, false);
+  browserNode->SetRecording(sequenceNode, true);
+  browserNode->SetPlaybackRateFps(1.0);
+  browserNode->SetCompactRecording(compactRecording);
+  return browserNode;
+}
+
+//---------------------------------------------------------------------------
+void SetTranslation(vtkMRMLLinearTransformNode* transformNode, double translation)
+{
+  vtkNew<vtkMatrix4x4> matrix;
+  matrix->SetElement(0, 3, translation);
+  transformNode->SetMatrixTransformToParent(matrix);
+}
+
+//---------------------------------------------------------------------------
+double GetTranslation(vtkMRMLNode* node)
+{
+  vtkNew<vtkMatrix4x4> matrix;
+  vtkMRMLLinearTransformNode::SafeDownCast(node)->GetMatrixTransformToParent(matrix);
+  return matrix->GetElement(0, 3);
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int TestCompactTransformRecording()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLLinearTransformNode* transformNode = vtkMRMLLinearTransformNode::SafeDownCast(
+    scene->AddNewNodeByClass("vtkMRMLLinearTransformNode", "Tracker"));
+  vtkMRMLSequenceBrowserNode* browserNode = AddRecordingBrowser(scene, transformNode, true);
+  vtkMRMLSequenceNode* sequenceNode = browserNode->GetMasterSequenceNode();
+  CHECK_BOOL(browserNode->GetCompactRecording(), true);
+
+  const int numberOfSamples = 100;
+  for (int sampleIndex = 0; sampleIndex < numberOfSamples; ++sampleIndex)
+    {
+    SetTranslation(transformNode, sampleIndex);
+    browserNode->SaveProxyNodesState();
+    }
+  CHECK_INT(sequenceNode->GetNumberOfDataNodes(), numberOfSamples);
+  CHECK_STD_STRING(sequenceNode->GetAttribute("DataNodeClassName"), "vtkMRMLLinearTransformNode");
+  // No data node is created, not even for getting the data node class name or saving the scene
+  CHECK_INT(sequenceNode->GetNumberOfCompactItems(), numberOfSamples);
+  CHECK_STD_STRING(sequenceNode->GetDataNodeClassName(), "vtkMRMLLinearTransformNode");
+  std::stringstream xml;
+  sequenceNode->WriteXML(xml, 0);
+  CHECK_INT(sequenceNode->GetSequenceScene()->GetNumberOfNodesByClass("vtkMRMLLinearTransformNode"), 0);
+  CHECK_BOOL(sequenceNode->IsCompactItem(0), true);
+  CHECK_BOOL(sequenceNode->IsCompactItem(50), true);
+
+  // Data node is created when the item is accessed
+  vtkMRMLNode* dataNode = sequenceNode->GetNthDataNode(50);
+  CHECK_NOT_NULL(dataNode);
+  CHECK_STD_STRING(dataNode->GetClassName(), "vtkMRMLLinearTransformNode");
+  CHECK_DOUBLE_TOLERANCE(GetTranslation(dataNode), 50.0, 1e-9);
+  CHECK_BOOL(sequenceNode->IsCompactItem(50), false);
+  CHECK_INT(sequenceNode->GetNumberOfCompactItems(), numberOfSamples - 1);
+  CHECK_BOOL(sequenceNode->GetNthDataNode(50) == dataNode, true);
+  CHECK_INT(sequenceNode->GetItemNumberFromIndexValue(sequenceNode->GetNthIndexValue(50)), 50);
+
+  // Compact items are preserved in copies
+  vtkNew<vtkMRMLSequenceNode> sequenceNodeCopy;
+  sequenceNodeCopy->CopySequenceIndex(sequenceNode);
+  CHECK_INT(sequenceNodeCopy->GetNumberOfCompactItems(), numberOfSamples - 1);
+  CHECK_DOUBLE_TOLERANCE(GetTranslation(sequenceNodeCopy->GetNthDataNode(70)), 70.0, 1e-9);
+
+  // Replacing a compact item by a regular data node
+  SetTranslation(transformNode, -1.0);
+  sequenceNode->SetDataNodeAtValue(transformNode, sequenceNode->GetNthIndexValue(80));
+  CHECK_INT(sequenceNode->GetNumberOfCompactItems(), numberOfSamples - 2);
+  CHECK_DOUBLE_TOLERANCE(GetTranslation(sequenceNode->GetNthDataNode(80)), -1.0, 1e-9);
+
+  // Removing a compact item
+  sequenceNode->RemoveDataNodeAtValue(sequenceNode->GetNthIndexValue(90));
+  CHECK_INT(sequenceNode->GetNumberOfDataNodes(), numberOfSamples - 1);
+  CHECK_INT(sequenceNode->GetNumberOfCompactItems(), numberOfSamples - 3);
+
+  // All data nodes are created when the content is needed in full
+  CHECK_BOOL(sequenceNode->CreateAllCompactItemDataNodes(), true);
+  CHECK_INT(sequenceNode->GetNumberOfCompactItems(), 0);
+  CHECK_DOUBLE_TOLERANCE(GetTranslation(sequenceNode->GetNthDataNode(numberOfSamples - 2)), numberOfSamples - 1, 1e-9);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestCompactVolumeRecording()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkImageData> imageData;
+  imageData->SetDimensions(16, 16, 8);
+  imageData->AllocateScalars(VTK_SHORT, 1);
+  vtkMRMLScalarVolumeNode* volumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(
+    scene->AddNewNodeByClass("vtkMRMLScalarVolumeNode", "Image"));
+  volumeNode->SetAndObserveImageData(imageData);
+  vtkMRMLSequenceBrowserNode* browserNode = AddRecordingBrowser(scene, volumeNode, true);
+  vtkMRMLSequenceNode* sequenceNode = browserNode->GetMasterSequenceNode();
+
+  const int numberOfSamples = 20;
+  for (int sampleIndex = 0; sampleIndex < numberOfSamples; ++sampleIndex)
+    {
+    imageData->GetPointData()->GetScalars()->Fill(sampleIndex);
+    volumeNode->SetOrigin(sampleIndex, 0, 0);
+    browserNode->SaveProxyNodesState();
+    }
+  CHECK_INT(sequenceNode->GetNumberOfDataNodes(), numberOfSamples);
+  CHECK_INT(sequenceNode->GetNumberOfCompactItems(), numberOfSamples);
+
+  vtkMRMLScalarVolumeNode* itemVolumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(7));
+  CHECK_NOT_NULL(itemVolumeNode);
+  CHECK_NOT_NULL(itemVolumeNode->GetImageData());
+  CHECK_BOOL(itemVolumeNode->GetImageData() != imageData.GetPointer(), true);
+  CHECK_DOUBLE_TOLERANCE(itemVolumeNode->GetImageData()->GetPointData()->GetScalars()->GetTuple1(100), 7.0, 1e-9);
+  CHECK_DOUBLE_TOLERANCE(itemVolumeNode->GetOrigin()[0], 7.0, 1e-9);
+
+  // Voxels can be read without creating the data node
+  vtkMRMLSequenceRecordingBuffer* recordingBuffer = vtkMRMLSequenceRecordingBuffer::SafeDownCast(
+    sequenceNode->GetDataNodeLoader(itemVolumeNode));
+  CHECK_NOT_NULL(recordingBuffer);
+  CHECK_INT(recordingBuffer->GetNumberOfSamples(), numberOfSamples);
+  vtkNew<vtkImageData> frameImageData;
+  CHECK_BOOL(recordingBuffer->ReadItemData(12, frameImageData), true);
+  CHECK_DOUBLE_TOLERANCE(frameImageData->GetPointData()->GetScalars()->GetTuple1(0), 12.0, 1e-9);
+  CHECK_BOOL(recordingBuffer->ReadItemData(numberOfSamples, frameImageData), false);
+
+  // Recording continues in a new buffer if the image size changes
+  vtkNew<vtkImageData> largerImageData;
+  largerImageData->SetDimensions(32, 16, 8);
+  largerImageData->AllocateScalars(VTK_SHORT, 1);
+  largerImageData->GetPointData()->GetScalars()->Fill(100);
+  volumeNode->SetAndObserveImageData(largerImageData);
+  browserNode->SaveProxyNodesState();
+  CHECK_INT(sequenceNode->GetNumberOfDataNodes(), numberOfSamples + 1);
+  CHECK_INT(recordingBuffer->GetNumberOfSamples(), numberOfSamples);
+  itemVolumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(numberOfSamples));
+  CHECK_INT(itemVolumeNode->GetImageData()->GetDimensions()[0], 32);
+  CHECK_DOUBLE_TOLERANCE(itemVolumeNode->GetImageData()->GetPointData()->GetScalars()->GetTuple1(0), 100.0, 1e-9);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int vtkMRMLSequenceBrowserNodeCompactRecordingTest1(int, char*[])
+{
+  CHECK_EXIT_SUCCESS(TestCompactTransformRecording());
+  CHECK_EXIT_SUCCESS(TestCompactVolumeRecording());
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
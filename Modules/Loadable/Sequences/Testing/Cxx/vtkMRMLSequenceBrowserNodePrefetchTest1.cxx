@@ -0,0 +1,278 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLCoreTestingUtilities.h"
+#include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLSequenceBrowserNode.h"
+#include "vtkMRMLSequenceNode.h"
+#include "vtkMRMLVolumeSequenceStorageNode.h"
+
+// Sequences includes
+#include "vtkSlicerSequencesLogic.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <sstream>
+#include <string>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+vtkMRMLSequenceNode* CreateVolumeSequence(vtkMRMLScene* scene, int numberOfItems, int size)
+{
+  vtkMRMLSequenceNode* sequenceNode = vtkMRMLSequenceNode::SafeDownCast(scene->AddNewNodeByClass("vtkMRMLSequenceNode", "Sequence"));
+  for (int itemNumber = 0; itemNumber < numberOfItems; ++itemNumber)
+    {
+    vtkNew<vtkImageData> imageData;
+    imageData->SetDimensions(size, size, size);
+    imageData->AllocateScalars(VTK_SHORT, 1);
+    imageData->GetPointData()->GetScalars()->Fill(itemNumber);
+    vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+    volumeNode->SetAndObserveImageData(imageData);
+    std::stringstream indexValue;
+    indexValue << itemNumber;
+    sequenceNode->SetDataNodeAtValue(volumeNode, indexValue.str());
+    }
+  return sequenceNode;
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLSequenceBrowserNode* AddBrowser(vtkMRMLScene* scene, vtkMRMLSequenceNode* sequenceNode)
+{
+  vtkMRMLSequenceBrowserNode* browserNode = vtkMRMLSequenceBrowserNode::SafeDownCast(
+    scene->AddNewNodeByClass("vtkMRMLSequenceBrowserNode", "Browser"));
+  browserNode->SetAndObserveMasterSequenceNodeID(sequenceNode->GetID());
+  return browserNode;
+}
+
+//---------------------------------------------------------------------------
+double GetFirstVoxelValue(vtkImageData* imageData)
+{
+  return imageData->GetPointData()->GetScalars()->GetTuple1(0);
+}
+
+//---------------------------------------------------------------------------
+vtkImageData* GetItemImageData(vtkMRMLSequenceNode* sequenceNode, int itemNumber)
+{
+  return vtkMRMLVolumeNode::SafeDownCast(sequenceNode->GetNthDataNode(itemNumber))->GetImageData();
+}
+
+//---------------------------------------------------------------------------
+int TestPrefetchBuffer()
+{
+  vtkNew<vtkMRMLScene> scene;
+  const int numberOfItems = 10;
+  vtkMRMLSequenceNode* sequenceNode = CreateVolumeSequence(scene, numberOfItems, 16);
+  vtkMRMLSequenceBrowserNode* browserNode = AddBrowser(scene, sequenceNode);
+  CHECK_BOOL(browserNode->GetPrefetchEnabled(), true);
+  CHECK_INT(browserNode->GetPrefetchBufferSize(), 4);
+
+  // Forward direction
+  browserNode->SetSelectedItemNumber(0);
+  browserNode->PrefetchItems();
+  CHECK_INT(browserNode->GetNumberOfPrefetchedItems(), 4);
+  browserNode->WaitForPrefetchedItems();
+  vtkSmartPointer<vtkImageData> prefetchedImageData = browserNode->TakePrefetchedImageData(sequenceNode, 1);
+  CHECK_NOT_NULL(prefetchedImageData.GetPointer());
+  CHECK_BOOL(prefetchedImageData.GetPointer() != GetItemImageData(sequenceNode, 1), true);
+  CHECK_BOOL(GetFirstVoxelValue(prefetchedImageData) == 1.0, true);
+  CHECK_INT(browserNode->GetNumberOfPrefetchedItems(), 3);
+  CHECK_INT(browserNode->GetNumberOfPrefetchHits(), 1);
+  // Items are removed from the buffer when taken
+  CHECK_NULL(browserNode->TakePrefetchedImageData(sequenceNode, 1).GetPointer());
+  CHECK_INT(browserNode->GetNumberOfPrefetchMisses(), 1);
+
+  // Backward direction, wrapping around
+  browserNode->SelectNextItem(-1);
+  CHECK_INT(browserNode->GetSelectedItemNumber(), numberOfItems - 1);
+  CHECK_INT(browserNode->GetLastSelectionIncrement(), -1);
+  browserNode->PrefetchItems();
+  CHECK_INT(browserNode->GetNumberOfPrefetchedItems(), 4);
+  prefetchedImageData = browserNode->TakePrefetchedImageData(sequenceNode, numberOfItems - 2);
+  CHECK_NOT_NULL(prefetchedImageData.GetPointer());
+  CHECK_BOOL(GetFirstVoxelValue(prefetchedImageData) == numberOfItems - 2, true);
+
+  // Item modified after it was prefetched is not used
+  browserNode->WaitForPrefetchedItems();
+  GetItemImageData(sequenceNode, numberOfItems - 3)->Modified();
+  CHECK_NULL(browserNode->TakePrefetchedImageData(sequenceNode, numberOfItems - 3).GetPointer());
+  CHECK_NOT_NULL(browserNode->TakePrefetchedImageData(sequenceNode, numberOfItems - 4).GetPointer());
+
+  // No items after the last one if playback is not looped
+  browserNode->SetPlaybackLooped(false);
+  browserNode->SetSelectedItemNumber(numberOfItems - 3);
+  browserNode->SelectNextItem(1);
+  browserNode->PrefetchItems();
+  CHECK_INT(browserNode->GetNumberOfPrefetchedItems(), 1);
+
+  // Disabling prefetching clears the buffer
+  browserNode->SetPrefetchEnabled(false);
+  CHECK_INT(browserNode->GetNumberOfPrefetchedItems(), 0);
+  browserNode->PrefetchItems();
+  CHECK_INT(browserNode->GetNumberOfPrefetchedItems(), 0);
+
+  // Sequences that save changes are not prefetched
+  browserNode->SetPrefetchEnabled(true);
+  browserNode->SetSaveChanges(sequenceNode, true);
+  browserNode->SetSelectedItemNumber(0);
+  browserNode->PrefetchItems();
+  CHECK_INT(browserNode->GetNumberOfPrefetchedItems(), 0);
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestPrefetchDeferredItems(const std::string& tempDir)
+{
+  vtkNew<vtkMRMLScene> scene;
+  const int numberOfItems = 8;
+  vtkMRMLSequenceNode* sourceSequenceNode = CreateVolumeSequence(scene, numberOfItems, 16);
+  std::string fileName = tempDir + "/vtkMRMLSequenceBrowserNodePrefetchTest1.vseq";
+  vtkNew<vtkMRMLVolumeSequenceStorageNode> storageNode;
+  scene->AddNode(storageNode);
+  storageNode->SetFileName(fileName.c_str());
+  CHECK_BOOL(storageNode->WriteData(sourceSequenceNode) != 0, true);
+
+  vtkMRMLSequenceNode* sequenceNode = vtkMRMLSequenceNode::SafeDownCast(scene->AddNewNodeByClass("vtkMRMLSequenceNode", "ReadSequence"));
+  CHECK_BOOL(storageNode->ReadData(sequenceNode) != 0, true);
+  CHECK_INT(sequenceNode->GetNumberOfCompactItems(), numberOfItems);
+  CHECK_INT(sequenceNode->GetNumberOfDeferredDataNodes(), 0);
+
+  vtkMRMLSequenceBrowserNode* browserNode = AddBrowser(scene, sequenceNode);
+  browserNode->SetSelectedItemNumber(0);
+  browserNode->PrefetchItems();
+  browserNode->WaitForPrefetchedItems();
+  // Voxels are read in the background, the data node is not created
+  vtkSmartPointer<vtkImageData> prefetchedImageData = browserNode->TakePrefetchedImageData(sequenceNode, 2);
+  CHECK_NOT_NULL(prefetchedImageData.GetPointer());
+  CHECK_BOOL(GetFirstVoxelValue(prefetchedImageData) == 2.0, true);
+  CHECK_BOOL(sequenceNode->IsCompactItem(2), true);
+  CHECK_INT(sequenceNode->GetNumberOfCompactItems(), numberOfItems);
+
+  // Prefetched voxels are still valid if the data node is created but its content is not loaded
+  CHECK_NOT_NULL(sequenceNode->CreateCompactItemDataNode(3));
+  prefetchedImageData = browserNode->TakePrefetchedImageData(sequenceNode, 3);
+  CHECK_NOT_NULL(prefetchedImageData.GetPointer());
+  CHECK_BOOL(GetFirstVoxelValue(prefetchedImageData) == 3.0, true);
+  CHECK_BOOL(sequenceNode->IsDataNodeLoaded(sequenceNode->GetNthDataNode(3, false)), false);
+  CHECK_INT(sequenceNode->GetNumberOfLoadedDeferredDataNodes(), 0);
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestPlayback()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSlicerSequencesLogic> logic;
+  logic->SetMRMLScene(scene);
+  const int numberOfItems = 6;
+  vtkMRMLSequenceNode* sequenceNode = CreateVolumeSequence(scene, numberOfItems, 16);
+  vtkMRMLSequenceBrowserNode* browserNode = AddBrowser(scene, sequenceNode);
+  browserNode->SetSelectedItemNumber(0);
+  vtkMRMLScalarVolumeNode* proxyNode = vtkMRMLScalarVolumeNode::SafeDownCast(browserNode->GetProxyNode(sequenceNode));
+  CHECK_NOT_NULL(proxyNode);
+
+  browserNode->SetPlaybackActive(true);
+  browserNode->ResetPlaybackStatistics();
+  for (int itemNumber = 1; itemNumber < numberOfItems; ++itemNumber)
+    {
+    browserNode->WaitForPrefetchedItems();
+    browserNode->SelectNextItem();
+    CHECK_BOOL(GetFirstVoxelValue(proxyNode->GetImageData()) == itemNumber, true);
+    // Proxy node content is not shared with the sequence
+    CHECK_BOOL(proxyNode->GetImageData() != GetItemImageData(sequenceNode, itemNumber), true);
+    }
+  CHECK_INT(browserNode->GetNumberOfDisplayedFrames(), numberOfItems - 1);
+  CHECK_INT(browserNode->GetNumberOfPrefetchHits(), numberOfItems - 1);
+  CHECK_INT(browserNode->GetNumberOfPrefetchMisses(), 0);
+  browserNode->SetPlaybackActive(false);
+
+  // Statistics
+  browserNode->ResetPlaybackStatistics();
+  browserNode->AddDroppedFrames(2);
+  browserNode->AddFrameLatency(0.1);
+  browserNode->AddFrameLatency(0.3);
+  CHECK_INT(browserNode->GetNumberOfDroppedFrames(), 2);
+  CHECK_INT(browserNode->GetNumberOfDisplayedFrames(), 2);
+  CHECK_DOUBLE_TOLERANCE(browserNode->GetAverageFrameLatencySec(), 0.2, 1e-9);
+  CHECK_DOUBLE_TOLERANCE(browserNode->GetMaximumFrameLatencySec(), 0.3, 1e-9);
+  CHECK_DOUBLE_TOLERANCE(browserNode->GetLastFrameLatencySec(), 0.3, 1e-9);
+  browserNode->ResetPlaybackStatistics();
+  CHECK_INT(browserNode->GetNumberOfDroppedFrames(), 0);
+  CHECK_DOUBLE_TOLERANCE(browserNode->GetAverageFrameLatencySec(), 0.0, 1e-9);
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestPlaybackPerformance()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSlicerSequencesLogic> logic;
+  logic->SetMRMLScene(scene);
+  const int numberOfItems = 10;
+  vtkMRMLSequenceNode* sequenceNode = CreateVolumeSequence(scene, numberOfItems, 128);
+  vtkMRMLSequenceBrowserNode* browserNode = AddBrowser(scene, sequenceNode);
+  browserNode->SetSelectedItemNumber(0);
+  browserNode->SetPlaybackActive(true);
+
+  for (bool prefetchEnabled : { false, true })
+    {
+    browserNode->SetPrefetchEnabled(prefetchEnabled);
+    browserNode->SetSelectedItemNumber(0);
+    browserNode->ResetPlaybackStatistics();
+    for (int itemNumber = 1; itemNumber < numberOfItems; ++itemNumber)
+      {
+      // items are prepared while the current item is displayed
+      browserNode->WaitForPrefetchedItems();
+      browserNode->SelectNextItem();
+      }
+    vtkMRMLCoreTestingUtilities::PrintMeasurement(
+      std::string("SequenceBrowser-AverageFrameLatency") + (prefetchEnabled ? "Prefetch" : ""),
+      browserNode->GetAverageFrameLatencySec());
+    }
+  browserNode->SetPlaybackActive(false);
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLSequenceBrowserNodePrefetchTest1(int argc, char* argv[])
+{
+  if (argc != 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string tempDir = argv[1];
+
+  CHECK_EXIT_SUCCESS(TestPrefetchBuffer());
+  CHECK_EXIT_SUCCESS(TestPrefetchDeferredItems(tempDir));
+  CHECK_EXIT_SUCCESS(TestPlayback());
+  CHECK_EXIT_SUCCESS(TestPlaybackPerformance());
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
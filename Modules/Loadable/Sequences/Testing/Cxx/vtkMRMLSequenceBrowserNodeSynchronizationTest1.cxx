@@ -0,0 +1,155 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLScriptedModuleNode.h"
+#include "vtkMRMLSequenceBrowserNode.h"
+#include "vtkMRMLSequenceNode.h"
+
+// VTK includes
+#include <vtkNew.h>
+
+// STD includes
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+std::string IndexValueString(int value)
+{
+  std::ostringstream ss;
+  ss << value;
+  return ss.str();
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLSequenceNode* CreateSequence(vtkMRMLScene* scene, int indexType, int numberOfItems, int indexValueStep)
+{
+  vtkMRMLSequenceNode* sequenceNode = vtkMRMLSequenceNode::SafeDownCast(scene->AddNewNodeByClass("vtkMRMLSequenceNode"));
+  sequenceNode->SetIndexType(indexType);
+  vtkNew<vtkMRMLScriptedModuleNode> dataNode;
+  for (int itemNumber = 0; itemNumber < numberOfItems; ++itemNumber)
+    {
+    sequenceNode->SetDataNodeAtValue(dataNode, IndexValueString(itemNumber * indexValueStep));
+    }
+  return sequenceNode;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int TestSynchronizedItemNumbers()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLSequenceNode* masterSequenceNode = CreateSequence(scene, vtkMRMLSequenceNode::NumericIndex, 10, 1);
+  // Items at 0, 2, 4, ...
+  vtkMRMLSequenceNode* sequenceNode = CreateSequence(scene, vtkMRMLSequenceNode::NumericIndex, 5, 2);
+  vtkMRMLSequenceBrowserNode* browserNode = vtkMRMLSequenceBrowserNode::SafeDownCast(
+    scene->AddNewNodeByClass("vtkMRMLSequenceBrowserNode"));
+  browserNode->SetAndObserveMasterSequenceNodeID(masterSequenceNode->GetID());
+  browserNode->AddSynchronizedSequenceNodeID(sequenceNode->GetID());
+
+  CHECK_INT(browserNode->GetSynchronizedSequenceItemNumber(masterSequenceNode, 7), 7);
+  CHECK_INT(browserNode->GetSynchronizedSequenceItemNumber(sequenceNode, 4), 2);
+  CHECK_INT(browserNode->GetSynchronizedSequenceItemNumber(sequenceNode, 4, true), 2);
+  CHECK_INT(browserNode->GetSynchronizedSequenceItemNumber(sequenceNode, 5), 2);
+  CHECK_INT(browserNode->GetSynchronizedSequenceItemNumber(sequenceNode, 5, true), -1);
+  CHECK_INT(browserNode->GetSynchronizedSequenceItemNumber(sequenceNode, 9), 4);
+  CHECK_INT(browserNode->GetSynchronizedSequenceItemNumber(sequenceNode, -1), -1);
+  CHECK_INT(browserNode->GetSynchronizedSequenceItemNumber(sequenceNode, 10), -1);
+  CHECK_INT(browserNode->GetSynchronizedSequenceItemNumber(nullptr, 1), -1);
+
+  // Modification of the synchronized sequence invalidates the cached item numbers
+  vtkNew<vtkMRMLScriptedModuleNode> dataNode;
+  sequenceNode->SetDataNodeAtValue(dataNode, "5");
+  CHECK_INT(browserNode->GetSynchronizedSequenceItemNumber(sequenceNode, 5, true), 3);
+  CHECK_INT(browserNode->GetSynchronizedSequenceItemNumber(sequenceNode, 9), 5);
+
+  // Modification of the master sequence invalidates the cached item numbers
+  masterSequenceNode->RemoveDataNodeAtValue("0");
+  CHECK_INT(browserNode->GetSynchronizedSequenceItemNumber(sequenceNode, 4, true), 3);
+  CHECK_INT(browserNode->GetSynchronizedSequenceItemNumber(sequenceNode, 8), 5);
+  CHECK_INT(browserNode->GetSynchronizedSequenceItemNumber(sequenceNode, 9), -1);
+
+  // Text index only has exact matches
+  vtkMRMLSequenceNode* textSequenceNode = CreateSequence(scene, vtkMRMLSequenceNode::TextIndex, 5, 2);
+  textSequenceNode->SetIndexName(masterSequenceNode->GetIndexName());
+  textSequenceNode->SetIndexUnit(masterSequenceNode->GetIndexUnit());
+  browserNode->AddSynchronizedSequenceNodeID(textSequenceNode->GetID());
+  CHECK_INT(browserNode->GetSynchronizedSequenceItemNumber(textSequenceNode, 3), 2);
+  CHECK_INT(browserNode->GetSynchronizedSequenceItemNumber(textSequenceNode, 4), -1);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestSynchronizedItemNumbersOfManySequences()
+{
+  const int numberOfSequences = 5;
+  const int numberOfItems = 100;
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLSequenceBrowserNode* browserNode = vtkMRMLSequenceBrowserNode::SafeDownCast(
+    scene->AddNewNodeByClass("vtkMRMLSequenceBrowserNode"));
+  std::vector<vtkMRMLSequenceNode*> sequenceNodes;
+  for (int sequenceIndex = 0; sequenceIndex < numberOfSequences; ++sequenceIndex)
+    {
+    // Text index requires linear search in the sequence
+    vtkMRMLSequenceNode* sequenceNode = CreateSequence(scene, vtkMRMLSequenceNode::TextIndex, numberOfItems, 1);
+    if (sequenceIndex == 0)
+      {
+      browserNode->SetAndObserveMasterSequenceNodeID(sequenceNode->GetID());
+      }
+    else
+      {
+      browserNode->AddSynchronizedSequenceNodeID(sequenceNode->GetID());
+      }
+    sequenceNodes.push_back(sequenceNode);
+    }
+
+  // Item numbers are the same when they are computed and when they are retrieved from the cache
+  for (int pass = 0; pass < 2; ++pass)
+    {
+    for (int masterItemNumber = 0; masterItemNumber < numberOfItems; ++masterItemNumber)
+      {
+      for (vtkMRMLSequenceNode* sequenceNode : sequenceNodes)
+        {
+        if (browserNode->GetSynchronizedSequenceItemNumber(sequenceNode, masterItemNumber) != masterItemNumber)
+          {
+          std::cerr << "Item number lookup failed at item " << masterItemNumber << " in pass " << pass << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int vtkMRMLSequenceBrowserNodeSynchronizationTest1(int, char*[])
+{
+  CHECK_EXIT_SUCCESS(TestSynchronizedItemNumbers());
+  CHECK_EXIT_SUCCESS(TestSynchronizedItemNumbersOfManySequences());
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
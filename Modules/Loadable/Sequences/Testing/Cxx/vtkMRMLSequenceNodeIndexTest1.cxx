@@ -0,0 +1,203 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLCoreTestingUtilities.h"
+#include "vtkMRMLScriptedModuleNode.h"
+#include "vtkMRMLSequenceNode.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <sstream>
+#include <string>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+std::string IndexValueString(double value)
+{
+  std::ostringstream ss;
+  ss.precision(10);
+  ss << value;
+  return ss.str();
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int TestNumericIndexSearch()
+{
+  vtkNew<vtkMRMLSequenceNode> sequenceNode;
+  sequenceNode->SetIndexType(vtkMRMLSequenceNode::NumericIndex);
+  sequenceNode->SetNumericIndexValueTolerance(0.01);
+  vtkNew<vtkMRMLScriptedModuleNode> dataNode;
+
+  // Items are added out of order, they must be sorted by numeric value (not by string)
+  const char* indexValues[] = { "10", "2", "30", "4.5", "-1", "100", "20" };
+  for (const char* indexValue : indexValues)
+    {
+    CHECK_NOT_NULL(sequenceNode->SetDataNodeAtValue(dataNode.GetPointer(), indexValue));
+    }
+  CHECK_INT(sequenceNode->GetNumberOfDataNodes(), 7);
+  const char* sortedIndexValues[] = { "-1", "2", "4.5", "10", "20", "30", "100" };
+  for (int i = 0; i < 7; i++)
+    {
+    CHECK_STD_STRING(sequenceNode->GetNthIndexValue(i), sortedIndexValues[i]);
+    }
+
+  // Exact match within tolerance
+  CHECK_INT(sequenceNode->GetItemNumberFromIndexValue("-1"), 0);
+  CHECK_INT(sequenceNode->GetItemNumberFromIndexValue("4.505"), 2);
+  CHECK_INT(sequenceNode->GetItemNumberFromIndexValue("19.995"), 4);
+  CHECK_INT(sequenceNode->GetItemNumberFromIndexValue("100.0"), 6);
+  CHECK_INT(sequenceNode->GetItemNumberFromIndexValue("4.52"), -1);
+  CHECK_INT(sequenceNode->GetItemNumberFromIndexValue("-5"), -1);
+  CHECK_INT(sequenceNode->GetItemNumberFromIndexValue("200"), -1);
+
+  // Closest match uses the item before the index value
+  CHECK_INT(sequenceNode->GetItemNumberFromIndexValue("-5", false), 0);
+  CHECK_INT(sequenceNode->GetItemNumberFromIndexValue("0", false), 0);
+  CHECK_INT(sequenceNode->GetItemNumberFromIndexValue("4.52", false), 2);
+  CHECK_INT(sequenceNode->GetItemNumberFromIndexValue("99", false), 5);
+  CHECK_INT(sequenceNode->GetItemNumberFromIndexValue("200", false), 6);
+
+  // Setting a value within tolerance replaces the existing item
+  sequenceNode->SetDataNodeAtValue(dataNode.GetPointer(), "30.001");
+  CHECK_INT(sequenceNode->GetNumberOfDataNodes(), 7);
+  sequenceNode->SetDataNodeAtValue(dataNode.GetPointer(), "100.005");
+  CHECK_INT(sequenceNode->GetNumberOfDataNodes(), 7);
+
+  // Changing index value moves the item
+  CHECK_BOOL(sequenceNode->UpdateIndexValue("2", "25"), true);
+  CHECK_STD_STRING(sequenceNode->GetNthIndexValue(4), "25");
+  CHECK_INT(sequenceNode->GetItemNumberFromIndexValue("25"), 4);
+  CHECK_INT(sequenceNode->GetItemNumberFromIndexValue("2"), -1);
+
+  sequenceNode->RemoveDataNodeAtValue("10");
+  CHECK_INT(sequenceNode->GetNumberOfDataNodes(), 6);
+  CHECK_INT(sequenceNode->GetItemNumberFromIndexValue("20"), 2);
+
+  // Numeric values are preserved when the index is copied
+  vtkNew<vtkMRMLSequenceNode> sequenceNodeCopy;
+  sequenceNodeCopy->CopySequenceIndex(sequenceNode.GetPointer());
+  CHECK_INT(sequenceNodeCopy->GetItemNumberFromIndexValue("30"), 4);
+  CHECK_INT(sequenceNodeCopy->GetItemNumberFromIndexValue("26", false), 3);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestLargeIndexPerformance()
+{
+  const int numberOfItems = 1000000;
+  const double indexValueStep = 0.01;
+
+  vtkNew<vtkMRMLSequenceNode> sequenceNode;
+  sequenceNode->SetIndexType(vtkMRMLSequenceNode::NumericIndex);
+
+  // Create an index of a large sequence (as if it was read from a scene file)
+  std::ostringstream indexValuesStream;
+  for (int i = 0; i < numberOfItems; i++)
+    {
+    if (i > 0)
+      {
+      indexValuesStream << ";";
+      }
+    indexValuesStream << "Data_" << i << ":" << IndexValueString(i * indexValueStep);
+    }
+  std::string indexValues = indexValuesStream.str();
+  const char* atts[] = { "indexValues", indexValues.c_str(), nullptr };
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  sequenceNode->ReadXMLAttributes(atts);
+  timer->StopTimer();
+  CHECK_INT(sequenceNode->GetNumberOfDataNodes(), numberOfItems);
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("SequenceIndex-Read1MItems", timer->GetElapsedTime());
+
+  // Exact and closest match lookup of all items
+  timer->StartTimer();
+  for (int i = 0; i < numberOfItems; i++)
+    {
+    std::string indexValue = IndexValueString(i * indexValueStep + 0.0004);
+    int itemNumber = sequenceNode->GetItemNumberFromIndexValue(indexValue);
+    if (itemNumber != i)
+      {
+      std::cerr << "Exact lookup of " << indexValue << " failed: expected " << i << ", got " << itemNumber << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  timer->StopTimer();
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("SequenceIndex-ExactLookup1MItems", timer->GetElapsedTime());
+
+  timer->StartTimer();
+  for (int i = 0; i < numberOfItems; i++)
+    {
+    std::string indexValue = IndexValueString(i * indexValueStep + indexValueStep / 2);
+    int itemNumber = sequenceNode->GetItemNumberFromIndexValue(indexValue, false);
+    if (itemNumber != i)
+      {
+      std::cerr << "Closest lookup of " << indexValue << " failed: expected " << i << ", got " << itemNumber << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  timer->StopTimer();
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("SequenceIndex-ClosestLookup1MItems", timer->GetElapsedTime());
+
+  // Append items to the end of the large sequence (recording)
+  const int numberOfAppendedItems = 10000;
+  vtkNew<vtkMRMLScriptedModuleNode> dataNode;
+  timer->StartTimer();
+  for (int i = numberOfItems; i < numberOfItems + numberOfAppendedItems; i++)
+    {
+    sequenceNode->SetDataNodeAtValue(dataNode.GetPointer(), IndexValueString(i * indexValueStep));
+    }
+  timer->StopTimer();
+  CHECK_INT(sequenceNode->GetNumberOfDataNodes(), numberOfItems + numberOfAppendedItems);
+  CHECK_INT(sequenceNode->GetItemNumberFromIndexValue(IndexValueString((numberOfItems + 10) * indexValueStep)), numberOfItems + 10);
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("SequenceIndex-AppendItemTo1MItems", timer->GetElapsedTime() / numberOfAppendedItems);
+
+  // Insert items in the middle of the large sequence
+  const int numberOfInsertedItems = 100;
+  timer->StartTimer();
+  for (int i = 0; i < numberOfInsertedItems; i++)
+    {
+    sequenceNode->SetDataNodeAtValue(dataNode.GetPointer(), IndexValueString((numberOfItems / 2 + i) * indexValueStep + indexValueStep / 2));
+    }
+  timer->StopTimer();
+  CHECK_INT(sequenceNode->GetNumberOfDataNodes(), numberOfItems + numberOfAppendedItems + numberOfInsertedItems);
+  CHECK_INT(sequenceNode->GetItemNumberFromIndexValue(IndexValueString(numberOfItems / 2 * indexValueStep + indexValueStep / 2)),
+    numberOfItems / 2 + 1);
+  vtkMRMLCoreTestingUtilities::PrintMeasurement("SequenceIndex-InsertItemTo1MItems", timer->GetElapsedTime() / numberOfInsertedItems);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int vtkMRMLSequenceNodeIndexTest1(int, char*[])
+{
+  CHECK_EXIT_SUCCESS(TestNumericIndexSearch());
+  CHECK_EXIT_SUCCESS(TestLargeIndexPerformance());
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
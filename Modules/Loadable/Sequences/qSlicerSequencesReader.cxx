@@ -92,7 +92,8 @@ QStringList qSlicerSequencesReader::extensions()const
 {
   return QStringList()
     << "Sequence (*.seq.mrb *.mrb)"
-    << "Volume Sequence (*.seq.nrrd *.seq.nhdr)" << "Volume Sequence (*.nrrd *.nhdr)";
+    << "Volume Sequence (*.seq.nrrd *.seq.nhdr)" << "Volume Sequence (*.nrrd *.nhdr)"
+    << "Chunked Volume Sequence (*.vseq)";
 }
 
 //-----------------------------------------------------------------------------
@@ -47,6 +47,7 @@ or http://www.slicer.org/copyright/copyright.txt for details.
 #include <vtkLine.h>
 #include <vtkLookupTable.h>
 #include <vtkMath.h>
+#include <vtkMatrix4x4.h>
 #include <vtkTransform.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
@@ -55,6 +56,7 @@ or http://www.slicer.org/copyright/copyright.txt for details.
 #include <vtkPoints.h>
 #include <vtkPointSet.h>
 #include <vtkPointData.h>
+#include <vtkSMPTools.h>
 #include <vtkSphereSource.h>
 #include <vtkThinPlateSplineTransform.h>
 #include <vtkTransform.h>
@@ -82,6 +84,73 @@ or http://www.slicer.org/copyright/copyright.txt for details.
 
 vtkStandardNewMacro(vtkSlicerTransformLogic);
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Fill a float image with the displacement (vector or magnitude) computed at each voxel position.
+/// Voxels are processed using multiple threads, as evaluating non-linear transforms is slow.
+void FillDisplacementImage(vtkImageData* image, vtkAbstractTransform* transform, vtkMatrix4x4* ijkToRAS, bool magnitude)
+{
+  int numberOfComponents = magnitude ? 1 : 3;
+  float* voxelPtr = static_cast<float*>(image->GetScalarPointer());
+  int* extent = image->GetExtent();
+  vtkIdType dimensions[3] =
+    {
+    extent[1] - extent[0] + 1,
+    extent[3] - extent[2] + 1,
+    extent[5] - extent[4] + 1
+    };
+  if (dimensions[0] <= 0 || dimensions[1] <= 0 || dimensions[2] <= 0)
+    {
+    return;
+    }
+  double ijkToRASElements[16];
+  vtkMatrix4x4::DeepCopy(ijkToRASElements, ijkToRAS);
+
+  // Only the thread-safe Internal... methods are called from the worker threads
+  transform->Update();
+
+  // Each work item is an image row
+  vtkSMPTools::For(0, dimensions[1] * dimensions[2], [&](vtkIdType beginRow, vtkIdType endRow)
+    {
+    double point_IJK[4] = { 0, 0, 0, 1 };
+    double point_RAS[4] = { 0, 0, 0, 1 };
+    double transformedPoint_RAS[3] = { 0, 0, 0 };
+    for (vtkIdType row = beginRow; row < endRow; ++row)
+      {
+      point_IJK[1] = extent[2] + row % dimensions[1];
+      point_IJK[2] = extent[4] + row / dimensions[1];
+      float* rowVoxelPtr = voxelPtr + row * dimensions[0] * numberOfComponents;
+      for (vtkIdType i = 0; i < dimensions[0]; ++i)
+        {
+        point_IJK[0] = extent[0] + i;
+        vtkMatrix4x4::MultiplyPoint(ijkToRASElements, point_IJK, point_RAS);
+        transform->InternalTransformPoint(point_RAS, transformedPoint_RAS);
+        double displacement_RAS[3] =
+          {
+          transformedPoint_RAS[0] - point_RAS[0],
+          transformedPoint_RAS[1] - point_RAS[1],
+          transformedPoint_RAS[2] - point_RAS[2]
+          };
+        if (magnitude)
+          {
+          *(rowVoxelPtr++) = static_cast<float>(vtkMath::Norm(displacement_RAS));
+          }
+        else
+          {
+          *(rowVoxelPtr++) = static_cast<float>(displacement_RAS[0]);
+          *(rowVoxelPtr++) = static_cast<float>(displacement_RAS[1]);
+          *(rowVoxelPtr++) = static_cast<float>(displacement_RAS[2]);
+          }
+        }
+      }
+    });
+  image->GetPointData()->GetScalars()->Modified();
+}
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 vtkSlicerTransformLogic::vtkSlicerTransformLogic() = default;
 
@@ -215,21 +284,11 @@ void vtkSlicerTransformLogic::GetTransformedPointSamples(vtkPointSet* outputPoin
   vtkMRMLTransformNode* inputTransformNode, vtkMatrix4x4* gridToRAS, int* gridSize,
   bool transformToWorld /* = true */)
 {
-  vtkNew<vtkGeneralTransform> inputTransform;
-  if (transformToWorld)
-  {
-    inputTransformNode->GetTransformToWorld(inputTransform.GetPointer());
-  }
-  else
-  {
-    inputTransformNode->GetTransformFromWorld(inputTransform.GetPointer());
-  }
   // Generate sample point set on a grid
   vtkNew<vtkPoints> samplePositions_RAS;
   int numOfSamples = gridSize[0] * gridSize[1] * gridSize[2];
   samplePositions_RAS->SetNumberOfPoints(numOfSamples);
   double point_RAS[4] = { 0, 0, 0, 1 };
-  double transformedPoint_RAS[4] = { 0, 0, 0, 1 };
   double point_Grid[4] = { 0, 0, 0, 1 };
   int sampleIndex = 0;
   for (point_Grid[2] = 0; point_Grid[2]<gridSize[2]; point_Grid[2]++)
@@ -239,7 +298,6 @@ void vtkSlicerTransformLogic::GetTransformedPointSamples(vtkPointSet* outputPoin
       for (point_Grid[0] = 0; point_Grid[0]<gridSize[0]; point_Grid[0]++)
         {
         gridToRAS->MultiplyPoint(point_Grid, point_RAS);
-        inputTransform->TransformPoint(point_RAS, transformedPoint_RAS);
         samplePositions_RAS->SetPoint(sampleIndex, point_RAS[0], point_RAS[1], point_RAS[2]);
         sampleIndex++;
         }
@@ -277,13 +335,17 @@ void vtkSlicerTransformLogic::GetTransformedPointSamples(vtkPointSet* outputPoin
     inputTransformNode->GetTransformFromWorld(inputTransform.GetPointer());
     }
 
-  double transformedPoint_RAS[4] = { 0, 0, 0, 1 };
-  double pointDislocationVector_RAS[4] = { 0, 0, 0, 1 };
+  vtkNew<vtkPoints> transformedSamplePositions_RAS;
+  transformedSamplePositions_RAS->SetDataTypeToDouble();
+  vtkMRMLTransformNode::TransformPoints(inputTransform, samplePositions_RAS, transformedSamplePositions_RAS);
+
+  double point_RAS[3] = { 0, 0, 0 };
+  double transformedPoint_RAS[3] = { 0, 0, 0 };
+  double pointDislocationVector_RAS[3] = { 0, 0, 0 };
   for (int sampleIndex = 0; sampleIndex < numOfSamples; sampleIndex++)
     {
-    double* point_RAS = samplePositions_RAS->GetPoint(sampleIndex);
-
-    inputTransform->TransformPoint(point_RAS, transformedPoint_RAS);
+    samplePositions_RAS->GetPoint(sampleIndex, point_RAS);
+    transformedSamplePositions_RAS->GetPoint(sampleIndex, transformedPoint_RAS);
 
     pointDislocationVector_RAS[0] = transformedPoint_RAS[0] - point_RAS[0];
     pointDislocationVector_RAS[1] = transformedPoint_RAS[1] - point_RAS[1];
@@ -413,36 +475,7 @@ bool vtkSlicerTransformLogic::GetTransformedPointSamplesAsMagnitudeImage(vtkImag
   // therefore the volume will not appear in the correct position
   // if the direction matrix is not identity.
   magnitudeImage->AllocateScalars(VTK_FLOAT, 1);
-
-  double point_RAS[4] = { 0, 0, 0, 1 };
-  double transformedPoint_RAS[4] = { 0, 0, 0, 1 };
-  double pointDislocationVector_RAS[4] = { 0, 0, 0, 1 };
-  double point_IJK[4] = { 0, 0, 0, 1 };
-  float* voxelPtr = static_cast<float*>(magnitudeImage->GetScalarPointer());
-  int* extent = magnitudeImage->GetExtent();
-  for (point_IJK[2] = extent[4]; point_IJK[2] <= extent[5]; point_IJK[2]++)
-  {
-    for (point_IJK[1] = extent[2]; point_IJK[1] <= extent[3]; point_IJK[1]++)
-    {
-      for (point_IJK[0] = extent[0]; point_IJK[0] <= extent[1]; point_IJK[0]++)
-      {
-        ijkToRAS->MultiplyPoint(point_IJK, point_RAS);
-
-        inputTransform->TransformPoint(point_RAS, transformedPoint_RAS);
-
-        pointDislocationVector_RAS[0] = transformedPoint_RAS[0] - point_RAS[0];
-        pointDislocationVector_RAS[1] = transformedPoint_RAS[1] - point_RAS[1];
-        pointDislocationVector_RAS[2] = transformedPoint_RAS[2] - point_RAS[2];
-
-        float mag = sqrt(
-          pointDislocationVector_RAS[0] * pointDislocationVector_RAS[0] +
-          pointDislocationVector_RAS[1] * pointDislocationVector_RAS[1] +
-          pointDislocationVector_RAS[2] * pointDislocationVector_RAS[2]);
-
-        *(voxelPtr++) = mag;
-      }
-    }
-  }
+  FillDisplacementImage(magnitudeImage, inputTransform, ijkToRAS, true);
 
   return true;
 }
@@ -720,29 +753,7 @@ bool vtkSlicerTransformLogic::GetTransformedPointSamplesAsVectorImage(vtkImageDa
   // therefore the volume will not appear in the correct position
   // if the direction matrix is not identity.
   vectorImage->AllocateScalars(VTK_FLOAT, 3);
-
-  double point_RAS[4] = { 0, 0, 0, 1 };
-  double transformedPoint_RAS[4] = { 0, 0, 0, 1 };
-  double point_IJK[4] = { 0, 0, 0, 1 };
-  float* voxelPtr = static_cast<float*>(vectorImage->GetScalarPointer());
-  int* extent = vectorImage->GetExtent();
-  for (point_IJK[2] = extent[4]; point_IJK[2] <= extent[5]; point_IJK[2]++)
-  {
-    for (point_IJK[1] = extent[2]; point_IJK[1] <= extent[3]; point_IJK[1]++)
-    {
-      for (point_IJK[0] = extent[0]; point_IJK[0] <= extent[1]; point_IJK[0]++)
-      {
-        ijkToRAS->MultiplyPoint(point_IJK, point_RAS);
-
-        inputTransform->TransformPoint(point_RAS, transformedPoint_RAS);
-
-        // store the pointDislocationVector_RAS components in the image
-        *(voxelPtr++) = static_cast<float>(transformedPoint_RAS[0] - point_RAS[0]);
-        *(voxelPtr++) = static_cast<float>(transformedPoint_RAS[1] - point_RAS[1]);
-        *(voxelPtr++) = static_cast<float>(transformedPoint_RAS[2] - point_RAS[2]);
-      }
-    }
-  }
+  FillDisplacementImage(vectorImage, inputTransform, ijkToRAS, false);
 
   return true;
 }
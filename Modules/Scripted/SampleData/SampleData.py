@@ -680,7 +680,7 @@ class SampleDataLogic:
                         break
                     outputDir = slicer.mrmlScene.GetCacheManager().GetRemoteCacheDirectory() + "/" + os.path.splitext(os.path.basename(filePath))[0]
                     qt.QDir().mkpath(outputDir)
-                    if slicer.util.extractArchive(filePath, outputDir):
+                    if slicer.util.extractArchive(filePath, outputDir, checksum=checksum):
                         # Success
                         resultNodes.append(outputDir)
                         break
@@ -854,7 +854,11 @@ class SampleDataLogic:
         self.downloadPercent = 0
         filePath = destFolderPath + '/' + name
         (algo, digest) = extractAlgoAndDigest(checksum)
-        if not os.path.exists(filePath) or os.stat(filePath).st_size == 0:
+        if (not os.path.exists(filePath) or os.stat(filePath).st_size == 0) \
+                and slicer.util.copyFileFromContentCache(checksum, filePath):
+            self.downloadPercent = 100
+            self.logMessage('<b>File found in content cache - reusing it.</b>')
+        elif not os.path.exists(filePath) or os.stat(filePath).st_size == 0:
             import urllib.request, urllib.parse, urllib.error
             self.logMessage(f'<b>Requesting download</b> <i>{name}</i> from {uri} ...')
             try:
@@ -873,6 +877,7 @@ class SampleDataLogic:
                 else:
                     self.downloadPercent = 100
                     self.logMessage('<b>Checksum OK</b>')
+                    slicer.util.addFileToContentCache(filePath, checksum)
         else:
             if algo is not None:
                 self.logMessage('<b>Verifying checksum</b>')
@@ -884,6 +889,7 @@ class SampleDataLogic:
                 else:
                     self.downloadPercent = 100
                     self.logMessage('<b>File already exists and checksum is OK - reusing it.</b>')
+                    slicer.util.addFileToContentCache(filePath, checksum)
             else:
                 self.downloadPercent = 100
                 self.logMessage('<b>File already exists in cache - reusing it.</b>')
@@ -945,6 +951,7 @@ class SampleDataTest(ScriptedLoadableModuleTest):
         for test in [
             self.test_downloadFromSource_downloadFiles,
             self.test_downloadFromSource_downloadZipFile,
+            self.test_downloadFromSource_contentCache,
             self.test_downloadFromSource_loadMRBFile,
             self.test_downloadFromSource_loadMRMLFile,
             self.test_downloadFromSource_downloadMRBFile,
@@ -1009,6 +1016,51 @@ class SampleDataTest(ScriptedLoadableModuleTest):
         self.assertTrue(os.path.isdir(filePaths[0]))
         self.assertEqual(sceneMTime, slicer.mrmlScene.GetMTime())
 
+    def test_downloadFromSource_contentCache(self):
+        """Files with the same checksum are only downloaded once, regardless of their file name."""
+        import functools
+        import hashlib
+        import http.server
+        import tempfile
+        import threading
+
+        content = b'SampleData content cache test'
+        checksum = 'SHA256:' + hashlib.sha256(content).hexdigest()
+        cacheManager = slicer.mrmlScene.GetCacheManager()
+        cacheManager.RemoveFileFromContentCache(checksum)
+        cacheManager.ResetContentCacheStatistics()
+        cacheDir = cacheManager.GetRemoteCacheDirectory()
+        fileNames = ['SampleDataContentCacheTest1.txt', 'SampleDataContentCacheTest2.txt']
+        for fileName in fileNames:
+            if os.path.exists(os.path.join(cacheDir, fileName)):
+                os.remove(os.path.join(cacheDir, fileName))
+
+        with tempfile.TemporaryDirectory() as serverDir:
+            with open(os.path.join(serverDir, 'data.txt'), 'wb') as serverFile:
+                serverFile.write(content)
+            # Local HTTP server as a stand-in for the data store
+            handler = functools.partial(http.server.SimpleHTTPRequestHandler, directory=serverDir)
+            server = http.server.ThreadingHTTPServer(('127.0.0.1', 0), handler)
+            serverThread = threading.Thread(target=server.serve_forever, daemon=True)
+            serverThread.start()
+            url = 'http://127.0.0.1:%d/data.txt' % server.server_address[1]
+            try:
+                logic = SampleDataLogic()
+                filePaths = logic.downloadFromSource(SampleDataSource(uris=url, fileNames=fileNames[0], checksums=checksum))
+                self.assertEqual(cacheManager.GetContentCacheMissCount(), 1)
+                self.assertEqual(cacheManager.GetContentCacheHitCount(), 0)
+                self.assertTrue(os.path.isfile(cacheManager.GetContentCacheFilePath(checksum)))
+            finally:
+                server.shutdown()
+                server.server_close()
+
+        # Server is not available anymore, the file must be retrieved from the content cache
+        filePaths2 = logic.downloadFromSource(SampleDataSource(uris=url, fileNames=fileNames[1], checksums=checksum))
+        self.assertEqual(cacheManager.GetContentCacheHitCount(), 1)
+        with open(filePaths[0], 'rb') as file1, open(filePaths2[0], 'rb') as file2:
+            self.assertEqual(file1.read(), content)
+            self.assertEqual(file2.read(), content)
+
     def test_downloadFromSource_loadMRBFile(self):
         logic = SampleDataLogic()
         sceneMTime = slicer.mrmlScene.GetMTime()
@@ -452,9 +452,8 @@ class SegmentStatisticsLogic(ScriptedLoadableModuleLogic):
                 logging.debug("computeStatistics will not return any results: there are no visible segments")
 
             # update statistics for all segment IDs
-            for segmentIndex in range(visibleSegmentIds.GetNumberOfValues()):
-                segmentID = visibleSegmentIds.GetValue(segmentIndex)
-                self.updateStatisticsForSegment(segmentID)
+            segmentIDs = [visibleSegmentIds.GetValue(segmentIndex) for segmentIndex in range(visibleSegmentIds.GetNumberOfValues())]
+            self.updateStatisticsForSegments(segmentIDs)
         finally:
             if transformedSegmentationNode is not None:
                 # We made a copy and hardened the segmentation transform
@@ -466,27 +465,44 @@ class SegmentStatisticsLogic(ScriptedLoadableModuleLogic):
         Update statistical measures for specified segment.
         Note: This will not change or reset measurement results of other segments
         """
+        self.updateStatisticsForSegments([segmentID])
+
+    def updateStatisticsForSegments(self, segmentIDs):
+        """
+        Update statistical measures for specified segments.
+        Plugins compute measurements of all the segments at once, which is much faster than
+        updating segments one by one if there are many segments.
+        Note: This will not change or reset measurement results of other segments
+        """
 
         segmentationNode = slicer.mrmlScene.GetNodeByID(self.getParameterNode().GetParameter("Segmentation"))
 
-        if not segmentationNode.GetSegmentation().GetSegment(segmentID):
-            logging.debug("updateStatisticsForSegment will not update any results because the segment doesn't exist")
+        existingSegmentIDs = []
+        for segmentID in segmentIDs:
+            if not segmentationNode.GetSegmentation().GetSegment(segmentID):
+                logging.debug(f"updateStatisticsForSegments will not update results of segment {segmentID} because the segment doesn't exist")
+                continue
+            existingSegmentIDs.append(segmentID)
+        if not existingSegmentIDs:
             return
 
-        segment = segmentationNode.GetSegmentation().GetSegment(segmentID)
         statistics = self.getStatistics()
-        if segmentID not in statistics["SegmentIDs"]:
-            statistics["SegmentIDs"].append(segmentID)
-        statistics[segmentID, "Segment"] = segment.GetName()
+        for segmentID in existingSegmentIDs:
+            segment = segmentationNode.GetSegmentation().GetSegment(segmentID)
+            if segmentID not in statistics["SegmentIDs"]:
+                statistics["SegmentIDs"].append(segmentID)
+            statistics[segmentID, "Segment"] = segment.GetName()
 
         # apply all enabled plugins
         for plugin in self.plugins:
             pluginName = plugin.__class__.__name__
             if self.getParameterNode().GetParameter(pluginName + '.enabled') == 'True':
-                stats = plugin.computeStatistics(segmentID)
-                for key in stats:
-                    statistics[segmentID, pluginName + '.' + key] = stats[key]
-                    statistics["MeasurementInfo"][pluginName + '.' + key] = plugin.getMeasurementInfo(key)
+                statsForSegments = plugin.computeStatisticsForSegments(existingSegmentIDs)
+                for segmentID in existingSegmentIDs:
+                    stats = statsForSegments.get(segmentID, {})
+                    for key in stats:
+                        statistics[segmentID, pluginName + '.' + key] = stats[key]
+                        statistics["MeasurementInfo"][pluginName + '.' + key] = plugin.getMeasurementInfo(key)
 
     def getPluginByKey(self, key):
         """Get plugin responsible for obtaining measurement value for given key"""
@@ -22,6 +22,9 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
 
         self.defaultKeys = ["voxel_count", "volume_mm3", "volume_cm3"]  # Don't calculate label shape statistics by default since they take longer to compute
         self.keys = self.defaultKeys + self.shapeKeys
+        # Shape statistics computed by vtkImageLabelStatistics, all other shape statistics are computed by vtkITKLabelShapeStatistics
+        self.labelStatisticsShapeKeys = ["centroid_ras", "flatness", "elongation", "principal_moments"] + self.principalAxisKeys
+        self.itkShapeKeys = [key for key in self.shapeKeys if key not in self.labelStatisticsShapeKeys]
         self.keyToShapeStatisticNames = {
             "centroid_ras": vtkITK.vtkITKLabelShapeStatistics.GetShapeStatisticAsString(vtkITK.vtkITKLabelShapeStatistics.Centroid),
             "feret_diameter_mm": vtkITK.vtkITKLabelShapeStatistics.GetShapeStatisticAsString(vtkITK.vtkITKLabelShapeStatistics.FeretDiameter),
@@ -44,6 +47,9 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
         # ... developer may add extra options to configure other parameters
 
     def computeStatistics(self, segmentID):
+        return self.computeStatisticsForSegments([segmentID]).get(segmentID, {})
+
+    def computeStatisticsForSegments(self, segmentIDs):
         import vtkSegmentationCorePython as vtkSegmentationCore
         requestedKeys = self.getRequestedKeys()
 
@@ -52,343 +58,161 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
         if len(requestedKeys) == 0:
             return {}
 
-        containsLabelmapRepresentation = segmentationNode.GetSegmentation().ContainsRepresentation(
-            vtkSegmentationCore.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName())
-        if not containsLabelmapRepresentation:
-            return {}
-
-        segmentLabelmap = slicer.vtkOrientedImageData()
-        segmentationNode.GetBinaryLabelmapRepresentation(segmentID, segmentLabelmap)
-        if (not segmentLabelmap
-            or not segmentLabelmap.GetPointData()
-                or not segmentLabelmap.GetPointData().GetScalars()):
-            # No input label data
+        binaryLabelmapRepresentationName = vtkSegmentationCore.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName()
+        segmentation = segmentationNode.GetSegmentation()
+        if not segmentation.ContainsRepresentation(binaryLabelmapRepresentationName):
             return {}
 
-        # We need to know exactly the value of the segment voxels, apply threshold to make force the selected label value
-        labelValue = 1
-        backgroundValue = 0
-        thresh = vtk.vtkImageThreshold()
-        thresh.SetInputData(segmentLabelmap)
-        thresh.ThresholdByLower(0)
-        thresh.SetInValue(backgroundValue)
-        thresh.SetOutValue(labelValue)
-        thresh.SetOutputScalarType(vtk.VTK_UNSIGNED_CHAR)
-        thresh.Update()
-
-        #  Use binary labelmap as a stencil
-        stencil = vtk.vtkImageToImageStencil()
-        stencil.SetInputData(thresh.GetOutput())
-        stencil.ThresholdByUpper(labelValue)
-        stencil.Update()
-
-        stat = vtk.vtkImageAccumulate()
-        stat.SetInputData(thresh.GetOutput())
-        stat.SetStencilData(stencil.GetOutput())
-        stat.Update()
-
-        # Add data to statistics list
-        cubicMMPerVoxel = reduce(lambda x, y: x * y, segmentLabelmap.GetSpacing())
-        ccPerCubicMM = 0.001
-        stats = {}
-        if "voxel_count" in requestedKeys:
-            stats["voxel_count"] = stat.GetVoxelCount()
-        if "volume_mm3" in requestedKeys:
-            stats["volume_mm3"] = stat.GetVoxelCount() * cubicMMPerVoxel
-        if "volume_cm3" in requestedKeys:
-            stats["volume_cm3"] = stat.GetVoxelCount() * cubicMMPerVoxel * ccPerCubicMM
-
-        calculateShapeStats = False
-        for shapeKey in self.shapeKeys:
-            if shapeKey in requestedKeys:
-                calculateShapeStats = True
-                break
-
-        if calculateShapeStats:
+        # If segmentation node is transformed, apply that transform to get RAS coordinates
+        transformSegmentToRas = vtk.vtkGeneralTransform()
+        slicer.vtkMRMLTransformNode.GetTransformBetweenNodes(segmentationNode.GetParentTransformNode(), None, transformSegmentToRas)
+
+        # Segments that are stored in the same shared labelmap are processed at once
+        segmentIDsInLayers = {}
+        for segmentID in segmentIDs:
+            layerIndex = segmentation.GetLayerIndex(segmentID, binaryLabelmapRepresentationName)
+            if layerIndex < 0:
+                continue
+            segmentIDsInLayers.setdefault(layerIndex, []).append(segmentID)
+
+        statsForSegments = {}
+        for layerIndex, layerSegmentIDs in segmentIDsInLayers.items():
+            layerLabelmap = segmentation.GetLayerDataObject(layerIndex, binaryLabelmapRepresentationName)
+            if (not layerLabelmap
+                or not layerLabelmap.GetPointData()
+                    or not layerLabelmap.GetPointData().GetScalars()):
+                # No input label data
+                continue
+            statsForSegments.update(self.computeStatisticsForLayer(
+                segmentation, layerSegmentIDs, layerLabelmap, requestedKeys, transformSegmentToRas))
+        return statsForSegments
+
+    def computeStatisticsForLayer(self, segmentation, segmentIDs, layerLabelmap, requestedKeys, transformSegmentToRas):
+        """Compute statistics of segments that are stored in the same shared labelmap.
+        Voxel counts, centroid, principal moments and axes, flatness, and elongation of all segments are computed
+        in a single pass by vtkImageLabelStatistics. Remaining shape statistics of all segments are computed
+        by a single vtkITKLabelShapeStatistics filter.
+        """
+        import vtkSlicerSegmentationsModuleLogicPython as vtkSlicerSegmentationsModuleLogic
+
+        labelStatistics = vtkSlicerSegmentationsModuleLogic.vtkImageLabelStatistics()
+        labelStatistics.SetLabelmap(layerLabelmap)
+        labelStatistics.SetComputeShapeStatistics(any(key in requestedKeys for key in self.labelStatisticsShapeKeys))
+        labelStatistics.Update()
+        labelStatisticsTable = labelStatistics.GetOutput()
+
+        itkShapeStatisticsTable = None
+        itkShapeStatisticsRows = {}
+        requestedItkShapeStatisticNames = set()
+        for key in requestedKeys:
+            if key in self.obbKeys:
+                requestedItkShapeStatisticNames.add(self.keyToShapeStatisticNames["oriented_bounding_box"])
+            elif key in self.itkShapeKeys:
+                requestedItkShapeStatisticNames.add(self.keyToShapeStatisticNames[key])
+        if requestedItkShapeStatisticNames:
             directions = vtk.vtkMatrix4x4()
-            segmentLabelmap.GetDirectionMatrix(directions)
-
-            # Remove oriented bounding box from requested keys and replace with individual keys
-            requestedOptions = requestedKeys
-            statFilterOptions = self.shapeKeys
-            calculateOBB = (
-                "obb_diameter_mm" in requestedKeys or
-                "obb_origin_ras" in requestedKeys or
-                "obb_direction_ras_x" in requestedKeys or
-                "obb_direction_ras_y" in requestedKeys or
-                "obb_direction_ras_z" in requestedKeys
-            )
-
-            if calculateOBB:
-                temp = statFilterOptions
-                statFilterOptions = []
-                for option in temp:
-                    if option not in self.obbKeys:
-                        statFilterOptions.append(option)
-                statFilterOptions.append("oriented_bounding_box")
-
-                temp = requestedOptions
-                requestedOptions = []
-                for option in temp:
-                    if option not in self.obbKeys:
-                        requestedOptions.append(option)
-                requestedOptions.append("oriented_bounding_box")
-
-            calculatePrincipalAxis = (
-                "principal_axis_x" in requestedKeys or
-                "principal_axis_y" in requestedKeys or
-                "principal_axis_z" in requestedKeys
-            )
-            if calculatePrincipalAxis:
-                temp = statFilterOptions
-                statFilterOptions = []
-                for option in temp:
-                    if option not in self.principalAxisKeys:
-                        statFilterOptions.append(option)
-                statFilterOptions.append("principal_axes")
-
-                temp = requestedOptions
-                requestedOptions = []
-                for option in temp:
-                    if option not in self.principalAxisKeys:
-                        requestedOptions.append(option)
-                requestedOptions.append("principal_axes")
-                requestedOptions.append("centroid_ras")
-
+            layerLabelmap.GetDirectionMatrix(directions)
             shapeStat = vtkITK.vtkITKLabelShapeStatistics()
-            shapeStat.SetInputData(thresh.GetOutput())
+            shapeStat.SetInputData(layerLabelmap)
             shapeStat.SetDirections(directions)
-            for shapeKey in statFilterOptions:
-                shapeStat.SetComputeShapeStatistic(self.keyToShapeStatisticNames[shapeKey], shapeKey in requestedOptions)
+            shapeStat.SetComputedStatistics(sorted(requestedItkShapeStatisticNames))
             shapeStat.Update()
+            itkShapeStatisticsTable = shapeStat.GetOutput()
+            labelValueArray = itkShapeStatisticsTable.GetColumnByName("LabelValue")
+            if labelValueArray is not None:
+                for row in range(labelValueArray.GetNumberOfTuples()):
+                    itkShapeStatisticsRows[int(labelValueArray.GetValue(row))] = row
+
+        def getTuple(table, row, key):
+            array = table.GetColumnByName(self.keyToShapeStatisticNames[key])
+            if array is None:
+                logging.error(f"Could not calculate {key}!")
+                return None
+            return array.GetTuple(row)
+
+        cubicMMPerVoxel = reduce(lambda x, y: x * y, layerLabelmap.GetSpacing())
+        ccPerCubicMM = 0.001
+        statsForSegments = {}
+        for segmentID in segmentIDs:
+            labelValue = segmentation.GetSegment(segmentID).GetLabelValue()
+            row = labelStatistics.GetRowForLabelValue(labelValue)
+            voxelCount = labelStatisticsTable.GetColumnByName("VoxelCount").GetValue(row) if row >= 0 else 0
+
+            # Add data to statistics list
+            stats = {}
+            statsForSegments[segmentID] = stats
+            if "voxel_count" in requestedKeys:
+                stats["voxel_count"] = voxelCount
+            if "volume_mm3" in requestedKeys:
+                stats["volume_mm3"] = voxelCount * cubicMMPerVoxel
+            if "volume_cm3" in requestedKeys:
+                stats["volume_cm3"] = voxelCount * cubicMMPerVoxel * ccPerCubicMM
+            if voxelCount == 0:
+                # Shape statistics are not defined for empty segments
+                continue
+
+            centroidTuple = None
+            if "centroid_ras" in requestedKeys or any(key in requestedKeys for key in self.principalAxisKeys):
+                centroidTuple = getTuple(labelStatisticsTable, row, "centroid_ras")
+            if "centroid_ras" in requestedKeys and centroidTuple is not None:
+                centroidRAS = [0, 0, 0]
+                transformSegmentToRas.TransformPoint(centroidTuple, centroidRAS)
+                stats["centroid_ras"] = centroidRAS
 
-            # If segmentation node is transformed, apply that transform to get RAS coordinates
-            transformSegmentToRas = vtk.vtkGeneralTransform()
-            slicer.vtkMRMLTransformNode.GetTransformBetweenNodes(segmentationNode.GetParentTransformNode(), None, transformSegmentToRas)
+            for key in ["flatness", "elongation"]:
+                if key in requestedKeys:
+                    valueTuple = getTuple(labelStatisticsTable, row, key)
+                    if valueTuple is not None:
+                        stats[key] = valueTuple[0]
 
-            statTable = shapeStat.GetOutput()
-            if "centroid_ras" in requestedKeys:
-                centroidRAS = [0, 0, 0]
-                centroidTuple = None
-                centroidArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["centroid_ras"])
-                if centroidArray is None:
-                    logging.error("Could not calculate centroid_ras!")
-                else:
-                    centroidTuple = centroidArray.GetTuple(0)
-                if centroidTuple is not None:
-                    transformSegmentToRas.TransformPoint(centroidTuple, centroidRAS)
-                    stats["centroid_ras"] = centroidRAS
-
-            if "roundness" in requestedKeys:
-                roundnessTuple = None
-                roundnessArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["roundness"])
-                if roundnessArray is None:
-                    logging.error("Could not calculate roundness!")
-                else:
-                    roundnessTuple = roundnessArray.GetTuple(0)
-                if roundnessTuple is not None:
-                    roundness = roundnessTuple[0]
-                    stats["roundness"] = roundness
-
-            if "flatness" in requestedKeys:
-                flatnessTuple = None
-                flatnessArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["flatness"])
-                if flatnessArray is None:
-                    logging.error("Could not calculate flatness!")
-                else:
-                    flatnessTuple = flatnessArray.GetTuple(0)
-                if flatnessTuple is not None:
-                    flatness = flatnessTuple[0]
-                    stats["flatness"] = flatness
-
-            if "elongation" in requestedKeys:
-                elongationTuple = None
-                elongationArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["elongation"])
-                if elongationArray is None:
-                    logging.error("Could not calculate elongation!")
-                else:
-                    elongationTuple = elongationArray.GetTuple(0)
-                if elongationTuple is not None:
-                    elongation = elongationTuple[0]
-                    stats["elongation"] = elongation
-
-            if "feret_diameter_mm" in requestedKeys:
-                feretDiameterTuple = None
-                feretDiameterArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["feret_diameter_mm"])
-                if feretDiameterArray is None:
-                    logging.error("Could not calculate feret_diameter_mm!")
-                else:
-                    feretDiameterTuple = feretDiameterArray.GetTuple(0)
-                if feretDiameterTuple is not None:
-                    feretDiameter = feretDiameterTuple[0]
-                    stats["feret_diameter_mm"] = feretDiameter
-
-            if "surface_area_mm2" in requestedKeys:
-                perimeterTuple = None
-                perimeterArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["surface_area_mm2"])
-                if perimeterArray is None:
-                    logging.error("Could not calculate surface_area_mm2!")
-                else:
-                    perimeterTuple = perimeterArray.GetTuple(0)
-                if perimeterTuple is not None:
-                    perimeter = perimeterTuple[0]
-                    stats["surface_area_mm2"] = perimeter
-
-            if "obb_origin_ras" in requestedKeys:
-                obbOriginTuple = None
-                obbOriginRAS = [0, 0, 0]
-                obbOriginArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_origin_ras"])
-                if obbOriginArray is None:
-                    logging.error("Could not calculate obb_origin_ras!")
-                else:
-                    obbOriginTuple = obbOriginArray.GetTuple(0)
-                if obbOriginTuple is not None:
-                    transformSegmentToRas.TransformPoint(obbOriginTuple, obbOriginRAS)
-                    stats["obb_origin_ras"] = obbOriginRAS
+            if "principal_moments" in requestedKeys:
+                principalMomentsTuple = getTuple(labelStatisticsTable, row, "principal_moments")
+                if principalMomentsTuple is not None:
+                    stats["principal_moments"] = list(principalMomentsTuple)
+
+            for key in self.principalAxisKeys:
+                if key in requestedKeys:
+                    principalAxisTuple = getTuple(labelStatisticsTable, row, key)
+                    if centroidTuple is not None and principalAxisTuple is not None:
+                        principalAxis = list(principalAxisTuple)
+                        transformSegmentToRas.TransformVectorAtPoint(centroidTuple, principalAxis, principalAxis)
+                        stats[key] = principalAxis
+
+            if itkShapeStatisticsTable is None:
+                continue
+            itkRow = itkShapeStatisticsRows.get(labelValue)
+            if itkRow is None:
+                logging.error(f"Could not calculate shape statistics of segment {segmentID}!")
+                continue
+
+            for key in ["roundness", "feret_diameter_mm", "surface_area_mm2"]:
+                if key in requestedKeys:
+                    valueTuple = getTuple(itkShapeStatisticsTable, itkRow, key)
+                    if valueTuple is not None:
+                        stats[key] = valueTuple[0]
 
             if "obb_diameter_mm" in requestedKeys:
-                obbDiameterMMTuple = None
-                obbDiameterArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_diameter_mm"])
-                if obbDiameterArray is None:
-                    logging.error("Could not calculate obb_diameter_mm!")
-                else:
-                    obbDiameterMMTuple = obbDiameterArray.GetTuple(0)
+                obbDiameterMMTuple = getTuple(itkShapeStatisticsTable, itkRow, "obb_diameter_mm")
                 if obbDiameterMMTuple is not None:
-                    obbDiameterMM = list(obbDiameterMMTuple)
-                    stats["obb_diameter_mm"] = obbDiameterMM
-
-            if "obb_direction_ras_x" in requestedKeys:
-                obbOriginTuple = None
-                obbOriginArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_origin_ras"])
-                if obbOriginArray is None:
-                    logging.error("Could not calculate obb_direction_ras_x!")
-                else:
-                    obbOriginTuple = obbOriginArray.GetTuple(0)
-
-                obbDirectionXTuple = None
-                obbDirectionXArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_direction_ras_x"])
-                if obbDirectionXArray is None:
-                    logging.error("Could not calculate obb_direction_ras_x!")
-                else:
-                    obbDirectionXTuple = obbDirectionXArray.GetTuple(0)
-
-                if obbOriginTuple is not None and obbDirectionXTuple is not None:
-                    obbDirectionX = list(obbDirectionXTuple)
-                    transformSegmentToRas.TransformVectorAtPoint(obbOriginTuple, obbDirectionX, obbDirectionX)
-                    stats["obb_direction_ras_x"] = obbDirectionX
-
-            if "obb_direction_ras_y" in requestedKeys:
-                obbOriginTuple = None
-                obbOriginArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_origin_ras"])
-                if obbOriginArray is None:
-                    logging.error("Could not calculate obb_direction_ras_y!")
-                else:
-                    obbOriginTuple = obbOriginArray.GetTuple(0)
-
-                obbDirectionYTuple = None
-                obbDirectionYArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_direction_ras_y"])
-                if obbDirectionYArray is None:
-                    logging.error("Could not calculate obb_direction_ras_y!")
-                else:
-                    obbDirectionYTuple = obbDirectionYArray.GetTuple(0)
-
-                if obbOriginTuple is not None and obbDirectionYTuple is not None:
-                    obbDirectionY = list(obbDirectionYTuple)
-                    transformSegmentToRas.TransformVectorAtPoint(obbOriginTuple, obbDirectionY, obbDirectionY)
-                    stats["obb_direction_ras_y"] = obbDirectionY
-
-            if "obb_direction_ras_z" in requestedKeys:
-                obbOriginTuple = None
-                obbOriginArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_origin_ras"])
-                if obbOriginArray is None:
-                    logging.error("Could not calculate obb_direction_ras_z!")
-                else:
-                    obbOriginTuple = obbOriginArray.GetTuple(0)
-
-                obbDirectionZTuple = None
-                obbDirectionZArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_direction_ras_z"])
-                if obbDirectionZArray is None:
-                    logging.error("Could not calculate obb_direction_ras_z!")
-                else:
-                    obbDirectionZTuple = obbDirectionZArray.GetTuple(0)
-
-                if obbOriginTuple is not None and obbDirectionZTuple is not None:
-                    obbDirectionZ = list(obbDirectionZTuple)
-                    transformSegmentToRas.TransformVectorAtPoint(obbOriginTuple, obbDirectionZ, obbDirectionZ)
-                    stats["obb_direction_ras_z"] = obbDirectionZ
+                    stats["obb_diameter_mm"] = list(obbDiameterMMTuple)
 
-            if "principal_moments" in requestedKeys:
-                principalMomentsTuple = None
-                principalMomentsArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["principal_moments"])
-                if principalMomentsArray is None:
-                    logging.error("Could not calculate principal_moments!")
-                else:
-                    principalMomentsTuple = principalMomentsArray.GetTuple(0)
-                if principalMomentsTuple is not None:
-                    principalMoments = list(principalMomentsTuple)
-                    stats["principal_moments"] = principalMoments
-
-            if "principal_axis_x" in requestedKeys:
-                centroidRASTuple = None
-                centroidRASArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["centroid_ras"])
-                if centroidRASArray is None:
-                    logging.error("Could not calculate principal_axis_x!")
-                else:
-                    centroidRASTuple = centroidRASArray.GetTuple(0)
-
-                principalAxisXTuple = None
-                principalAxisXArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["principal_axis_x"])
-                if principalAxisXArray is None:
-                    logging.error("Could not calculate principal_axis_x!")
-                else:
-                    principalAxisXTuple = principalAxisXArray.GetTuple(0)
-
-                if centroidRASTuple is not None and principalAxisXTuple is not None:
-                    principalAxisX = list(principalAxisXTuple)
-                    transformSegmentToRas.TransformVectorAtPoint(centroidRASTuple, principalAxisX, principalAxisX)
-                    stats["principal_axis_x"] = principalAxisX
-
-            if "principal_axis_y" in requestedKeys:
-                centroidRASTuple = None
-                centroidRASArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["centroid_ras"])
-                if centroidRASArray is None:
-                    logging.error("Could not calculate principal_axis_y!")
-                else:
-                    centroidRASTuple = centroidRASArray.GetTuple(0)
-
-                principalAxisYTuple = None
-                principalAxisYArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["principal_axis_y"])
-                if principalAxisYArray is None:
-                    logging.error("Could not calculate principal_axis_y!")
-                else:
-                    principalAxisYTuple = principalAxisYArray.GetTuple(0)
-
-                if centroidRASTuple is not None and principalAxisYTuple is not None:
-                    principalAxisY = list(principalAxisYTuple)
-                    transformSegmentToRas.TransformVectorAtPoint(centroidRASTuple, principalAxisY, principalAxisY)
-                    stats["principal_axis_y"] = principalAxisY
-
-            if "principal_axis_z" in requestedKeys:
-                centroidRASTuple = None
-                centroidRASArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["centroid_ras"])
-                if centroidRASArray is None:
-                    logging.error("Could not calculate principal_axis_z!")
-                else:
-                    centroidRASTuple = centroidRASArray.GetTuple(0)
-
-                principalAxisZTuple = None
-                principalAxisZArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["principal_axis_z"])
-                if principalAxisZArray is None:
-                    logging.error("Could not calculate principal_axis_z!")
-                else:
-                    principalAxisZTuple = principalAxisZArray.GetTuple(0)
-
-                if centroidRASTuple is not None and principalAxisZTuple is not None:
-                    principalAxisZ = list(principalAxisZTuple)
-                    transformSegmentToRas.TransformVectorAtPoint(centroidRASTuple, principalAxisZ, principalAxisZ)
-                    stats["principal_axis_z"] = principalAxisZ
-
-        return stats
+            obbOriginTuple = None
+            if any(key in requestedKeys for key in ["obb_origin_ras", "obb_direction_ras_x", "obb_direction_ras_y", "obb_direction_ras_z"]):
+                obbOriginTuple = getTuple(itkShapeStatisticsTable, itkRow, "obb_origin_ras")
+            if "obb_origin_ras" in requestedKeys and obbOriginTuple is not None:
+                obbOriginRAS = [0, 0, 0]
+                transformSegmentToRas.TransformPoint(obbOriginTuple, obbOriginRAS)
+                stats["obb_origin_ras"] = obbOriginRAS
+
+            for key in ["obb_direction_ras_x", "obb_direction_ras_y", "obb_direction_ras_z"]:
+                if key in requestedKeys:
+                    obbDirectionTuple = getTuple(itkShapeStatisticsTable, itkRow, key)
+                    if obbOriginTuple is not None and obbDirectionTuple is not None:
+                        obbDirection = list(obbDirectionTuple)
+                        transformSegmentToRas.TransformVectorAtPoint(obbOriginTuple, obbDirection, obbDirection)
+                        stats[key] = obbDirection
+
+        return statsForSegments
 
     def getMeasurementInfo(self, key):
         """Get information (name, description, units, ...) about the measurement for the given key"""
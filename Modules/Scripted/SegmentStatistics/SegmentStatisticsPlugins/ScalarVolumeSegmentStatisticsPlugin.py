@@ -15,6 +15,11 @@ class ScalarVolumeSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
         # ... developer may add extra options to configure other parameters
 
     def computeStatistics(self, segmentID):
+        return self.computeStatisticsForSegments([segmentID]).get(segmentID, {})
+
+    def computeStatisticsForSegments(self, segmentIDs):
+        import vtkSegmentationCorePython as vtkSegmentationCore
+        import vtkSlicerSegmentationsModuleLogicPython as vtkSlicerSegmentationsModuleLogic
         requestedKeys = self.getRequestedKeys()
 
         segmentationNode = slicer.mrmlScene.GetNodeByID(self.getParameterNode().GetParameter("Segmentation"))
@@ -23,57 +28,83 @@ class ScalarVolumeSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
         if len(requestedKeys) == 0:
             return {}
 
-        stencil = self.getStencilForVolume(segmentationNode, segmentID, grayscaleNode)
-        if not stencil:
+        binaryLabelmapRepresentationName = vtkSegmentationCore.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName()
+        segmentation = segmentationNode.GetSegmentation()
+        if not segmentation.ContainsRepresentation(binaryLabelmapRepresentationName):
             return {}
 
-        cubicMMPerVoxel = reduce(lambda x, y: x * y, grayscaleNode.GetSpacing())
-        ccPerCubicMM = 0.001
-
-        stat = vtk.vtkImageAccumulate()
-        stat.SetInputData(grayscaleNode.GetImageData())
-        stat.SetStencilData(stencil.GetOutput())
-        stat.Update()
-
-        medians = vtk.vtkImageHistogramStatistics()
-        medians.SetInputData(grayscaleNode.GetImageData())
-        medians.SetStencilData(stencil.GetOutput())
-        medians.Update()
-
-        # create statistics list
-        stats = {}
-        if "voxel_count" in requestedKeys:
-            stats["voxel_count"] = stat.GetVoxelCount()
-        if "volume_mm3" in requestedKeys:
-            stats["volume_mm3"] = stat.GetVoxelCount() * cubicMMPerVoxel
-        if "volume_cm3" in requestedKeys:
-            stats["volume_cm3"] = stat.GetVoxelCount() * cubicMMPerVoxel * ccPerCubicMM
-        if stat.GetVoxelCount() > 0:
-            if "min" in requestedKeys:
-                stats["min"] = stat.GetMin()[0]
-            if "max" in requestedKeys:
-                stats["max"] = stat.GetMax()[0]
-            if "mean" in requestedKeys:
-                stats["mean"] = stat.GetMean()[0]
-            if "stdev" in requestedKeys:
-                stats["stdev"] = stat.GetStandardDeviation()[0]
-            if "median" in requestedKeys:
-                stats["median"] = medians.GetMedian()
-        return stats
-
-    def getStencilForVolume(self, segmentationNode, segmentID, grayscaleNode):
-        import vtkSegmentationCorePython as vtkSegmentationCore
-
-        containsLabelmapRepresentation = segmentationNode.GetSegmentation().ContainsRepresentation(
-            vtkSegmentationCore.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName())
-        if not containsLabelmapRepresentation:
-            return None
-
         if (not grayscaleNode
             or not grayscaleNode.GetImageData()
             or not grayscaleNode.GetImageData().GetPointData()
                 or not grayscaleNode.GetImageData().GetPointData().GetScalars()):
             # Input grayscale node does not contain valid image data
+            return {}
+
+        # Segments that are stored in the same shared labelmap are processed at once
+        segmentIDsInLayers = {}
+        for segmentID in segmentIDs:
+            layerIndex = segmentation.GetLayerIndex(segmentID, binaryLabelmapRepresentationName)
+            if layerIndex < 0:
+                continue
+            segmentIDsInLayers.setdefault(layerIndex, []).append(segmentID)
+
+        cubicMMPerVoxel = reduce(lambda x, y: x * y, grayscaleNode.GetSpacing())
+        ccPerCubicMM = 0.001
+
+        statsForSegments = {}
+        for layerIndex, layerSegmentIDs in segmentIDsInLayers.items():
+            layerLabelmap = segmentation.GetLayerDataObject(layerIndex, binaryLabelmapRepresentationName)
+            layerLabelmap_Reference = self.getLabelmapForVolume(segmentationNode, layerLabelmap, grayscaleNode)
+            if not layerLabelmap_Reference:
+                continue
+
+            # Compute statistics of all segments of the layer in a single pass
+            labelStatistics = vtkSlicerSegmentationsModuleLogic.vtkImageLabelStatistics()
+            statTable = None
+            if layerLabelmap_Reference.GetPointData().GetScalars():
+                labelStatistics.SetLabelmap(layerLabelmap_Reference)
+                labelStatistics.SetScalarVolume(grayscaleNode.GetImageData())
+                labelStatistics.SetComputeMedian("median" in requestedKeys)
+                labelStatistics.Update()
+                statTable = labelStatistics.GetOutput()
+
+            for segmentID in layerSegmentIDs:
+                # Segments that are outside of the grayscale volume have no voxels
+                row = labelStatistics.GetRowForLabelValue(segmentation.GetSegment(segmentID).GetLabelValue()) if statTable else -1
+                voxelCount = statTable.GetColumnByName("VoxelCount").GetValue(row) if row >= 0 else 0
+
+                # create statistics list
+                stats = {}
+                statsForSegments[segmentID] = stats
+                if "voxel_count" in requestedKeys:
+                    stats["voxel_count"] = voxelCount
+                if "volume_mm3" in requestedKeys:
+                    stats["volume_mm3"] = voxelCount * cubicMMPerVoxel
+                if "volume_cm3" in requestedKeys:
+                    stats["volume_cm3"] = voxelCount * cubicMMPerVoxel * ccPerCubicMM
+                if voxelCount > 0:
+                    if "min" in requestedKeys:
+                        stats["min"] = statTable.GetColumnByName("Minimum").GetValue(row)
+                    if "max" in requestedKeys:
+                        stats["max"] = statTable.GetColumnByName("Maximum").GetValue(row)
+                    if "mean" in requestedKeys:
+                        stats["mean"] = statTable.GetColumnByName("Mean").GetValue(row)
+                    if "stdev" in requestedKeys:
+                        stats["stdev"] = statTable.GetColumnByName("StandardDeviation").GetValue(row)
+                    if "median" in requestedKeys:
+                        stats["median"] = statTable.GetColumnByName("Median").GetValue(row)
+        return statsForSegments
+
+    def getLabelmapForVolume(self, segmentationNode, labelmap, grayscaleNode):
+        """Resample labelmap (segment or shared labelmap of the segmentation node) to the geometry of the grayscale volume.
+        Nearest neighbor interpolation is used, therefore label values are preserved.
+        """
+        import vtkSegmentationCorePython as vtkSegmentationCore
+
+        if (not labelmap
+            or not labelmap.GetPointData()
+                or not labelmap.GetPointData().GetScalars()):
+            # No input label data
             return None
 
         # Get geometry of grayscale volume node as oriented image data
@@ -89,20 +120,34 @@ class ScalarVolumeSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
         slicer.vtkMRMLTransformNode.GetTransformBetweenNodes(segmentationNode.GetParentTransformNode(),
                                                              grayscaleNode.GetParentTransformNode(), segmentationToReferenceGeometryTransform)
 
-        segmentLabelmap = vtkSegmentationCore.vtkOrientedImageData()
-        segmentationNode.GetBinaryLabelmapRepresentation(segmentID, segmentLabelmap)
-        if (not segmentLabelmap
-            or not segmentLabelmap.GetPointData()
-                or not segmentLabelmap.GetPointData().GetScalars()):
-            # No input label data
-            return None
-
-        segmentLabelmap_Reference = vtkSegmentationCore.vtkOrientedImageData()
+        labelmap_Reference = vtkSegmentationCore.vtkOrientedImageData()
         vtkSegmentationCore.vtkOrientedImageDataResample.ResampleOrientedImageToReferenceOrientedImage(
-            segmentLabelmap, referenceGeometry_Reference, segmentLabelmap_Reference,
+            labelmap, referenceGeometry_Reference, labelmap_Reference,
             False,  # nearest neighbor interpolation
             False,  # no padding
             segmentationToReferenceGeometryTransform)
+        return labelmap_Reference
+
+    def getStencilForVolume(self, segmentationNode, segmentID, grayscaleNode):
+        import vtkSegmentationCorePython as vtkSegmentationCore
+
+        containsLabelmapRepresentation = segmentationNode.GetSegmentation().ContainsRepresentation(
+            vtkSegmentationCore.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName())
+        if not containsLabelmapRepresentation:
+            return None
+
+        if (not grayscaleNode
+            or not grayscaleNode.GetImageData()
+            or not grayscaleNode.GetImageData().GetPointData()
+                or not grayscaleNode.GetImageData().GetPointData().GetScalars()):
+            # Input grayscale node does not contain valid image data
+            return None
+
+        segmentLabelmap = vtkSegmentationCore.vtkOrientedImageData()
+        segmentationNode.GetBinaryLabelmapRepresentation(segmentID, segmentLabelmap)
+        segmentLabelmap_Reference = self.getLabelmapForVolume(segmentationNode, segmentLabelmap, grayscaleNode)
+        if not segmentLabelmap_Reference:
+            return None
 
         # We need to know exactly the value of the segment voxels, apply threshold to make force the selected label value
         labelValue = 1
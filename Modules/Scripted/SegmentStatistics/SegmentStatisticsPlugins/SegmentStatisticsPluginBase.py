@@ -8,6 +8,7 @@ class SegmentStatisticsPluginBase:
     """Base class for statistics plugins operating on segments.
     Derived classes should specify: self.name, self.keys, self.defaultKeys
     and implement: computeStatistics, getMeasurementInfo
+    and optionally: computeStatisticsForSegments
     """
 
     @staticmethod
@@ -59,6 +60,13 @@ class SegmentStatisticsPluginBase:
         """
         pass
 
+    def computeStatisticsForSegments(self, segmentIDs):
+        """Compute measurements for requested keys on the given segments and return
+        as dictionary mapping segment IDs to measurement results (as returned by computeStatistics).
+        Plugins that can compute measurements of many segments faster at once should override this method.
+        """
+        return {segmentID: self.computeStatistics(segmentID) for segmentID in segmentIDs}
+
     def getMeasurementInfo(self, key):
         """Get information (name, description, units, ...) about the measurement for the given key.
         Utilize createMeasurementInfo() to create the dictionary containing the measurement information.